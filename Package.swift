@@ -15,6 +15,10 @@ let package = Package(
             name: "SwiftRecastNavigation",
             targets: ["SwiftRecastNavigation"]
         ),
+        .executable(
+            name: "SwiftRecastBenchmarks",
+            targets: ["SwiftRecastBenchmarks"]
+        ),
     ],
     dependencies: [
         // Polyline simplification
@@ -34,6 +38,11 @@ let package = Package(
         ),
         .target(
             name: "CRecast"
+        ),
+        .executableTarget(
+            name: "SwiftRecastBenchmarks",
+            dependencies: ["SwiftRecastNavigation"],
+            swiftSettings: [.interoperabilityMode(.Cxx)]
         )
     ]
 )
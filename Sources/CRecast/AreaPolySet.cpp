@@ -0,0 +1,292 @@
+// AreaPolySet.cpp
+// Convex polygons merged from area mesh triangles, for area marking
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "AreaPolySet.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <new>
+#include <unordered_map>
+
+// Normals of merged polygons may differ by about one degree
+static const float AREA_POLY_NORMAL_DOT = 0.9998f;
+
+struct WorkPoly
+{
+    int v[AREA_POLY_MAX_VERTS];
+    int nv;
+    float n[3];             // Plane normal of the seed triangle
+    float d;                // Plane offset, dot(n, p) == d
+    float ymin;
+    float ymax;
+    float xzSign;           // Winding of the polygon in xz, +1 or -1
+    bool alive;
+    bool mergeable;
+};
+
+static inline uint64_t edgeKey(int a, int b)
+{
+    return ((uint64_t)(uint32_t)a << 32) | (uint64_t)(uint32_t)b;
+}
+
+static inline float cross2(const float* a, const float* b, const float* c)
+{
+    return (b[0] - a[0]) * (c[2] - a[2]) - (b[2] - a[2]) * (c[0] - a[0]);
+}
+
+static void initTriangle(const float* verts, const int* t, WorkPoly& p)
+{
+    const float* a = &verts[t[0] * 3];
+    const float* b = &verts[t[1] * 3];
+    const float* c = &verts[t[2] * 3];
+
+    p.v[0] = t[0];
+    p.v[1] = t[1];
+    p.v[2] = t[2];
+    p.nv = 3;
+    p.alive = true;
+
+    p.ymin = fminf(a[1], fminf(b[1], c[1]));
+    p.ymax = fmaxf(a[1], fmaxf(b[1], c[1]));
+
+    const float e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    const float e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    float n[3] = {
+        e0[1] * e1[2] - e0[2] * e1[1],
+        e0[2] * e1[0] - e0[0] * e1[2],
+        e0[0] * e1[1] - e0[1] * e1[0]
+    };
+    const float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    const float area2 = cross2(a, b, c);
+
+    // Degenerate and vertical triangles are marked on their own.
+    p.mergeable = len > 1e-6f && fabsf(area2) > 1e-6f;
+    if (len > 0.0f) {
+        n[0] /= len;
+        n[1] /= len;
+        n[2] /= len;
+    }
+    p.n[0] = n[0];
+    p.n[1] = n[1];
+    p.n[2] = n[2];
+    p.d = n[0] * a[0] + n[1] * a[1] + n[2] * a[2];
+    p.xzSign = area2 < 0.0f ? -1.0f : 1.0f;
+}
+
+static bool isCoplanar(const float* verts, const WorkPoly& p, const WorkPoly& q,
+                       float planeTolerance)
+{
+    const float dot = p.n[0] * q.n[0] + p.n[1] * q.n[1] + p.n[2] * q.n[2];
+    if (dot < AREA_POLY_NORMAL_DOT)
+        return false;
+    for (int i = 0; i < q.nv; ++i) {
+        const float* v = &verts[q.v[i] * 3];
+        const float dist = p.n[0] * v[0] + p.n[1] * v[1] + p.n[2] * v[2] - p.d;
+        if (fabsf(dist) > planeTolerance)
+            return false;
+    }
+    return true;
+}
+
+// Joins q onto p across p's edge ia -> ia+1, which q holds as jb -> jb+1.
+// Returns the merged vertex count, or 0 if the result is not a convex polygon.
+static int mergePolys(const float* verts, const WorkPoly& p, int ia,
+                      const WorkPoly& q, int jb, int* out)
+{
+    int n = 0;
+    // Walk p starting at the far end of the shared edge, ending at its start...
+    for (int k = 0; k < p.nv; ++k)
+        out[n++] = p.v[(ia + 1 + k) % p.nv];
+    // ...then the rest of q, which closes the loop.
+    for (int k = 2; k < q.nv; ++k)
+        out[n++] = q.v[(jb + k) % q.nv];
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = i + 1; j < n; ++j) {
+            if (out[i] == out[j])
+                return 0;
+        }
+    }
+
+    for (int i = 0; i < n; ++i) {
+        const float* va = &verts[out[(i + n - 1) % n] * 3];
+        const float* vb = &verts[out[i] * 3];
+        const float* vc = &verts[out[(i + 1) % n] * 3];
+        if (cross2(va, vb, vc) * p.xzSign < 0.0f)
+            return 0;
+    }
+    return n;
+}
+
+rcAreaPolySet::rcAreaPolySet() :
+    verts(0),
+    polys(0),
+    bounds(0),
+    npolys(0),
+    nverts(0)
+{
+}
+
+rcAreaPolySet::~rcAreaPolySet()
+{
+    delete[] verts;
+    delete[] polys;
+    delete[] bounds;
+}
+
+bool rcBuildAreaPolySet(const float* verts, int nverts, const int* tris, int ntris,
+                        float planeTolerance, float maxHeightSpan, rcAreaPolySet* ps)
+{
+    if (!ps || !verts || !tris || nverts <= 0 || ntris <= 0)
+        return false;
+
+    WorkPoly* work = new (std::nothrow) WorkPoly[ntris];
+    if (!work)
+        return false;
+
+    int nwork = 0;
+    for (int i = 0; i < ntris; ++i) {
+        const int* t = &tris[i * 3];
+        if (t[0] < 0 || t[0] >= nverts || t[1] < 0 || t[1] >= nverts || t[2] < 0 || t[2] >= nverts)
+            continue;
+        initTriangle(verts, t, work[nwork++]);
+    }
+
+    // Directed edge -> polygon that owns it. Entries go stale as polygons
+    // merge, so every lookup is checked against the polygon itself.
+    std::unordered_map<uint64_t, int> edges;
+    edges.reserve((size_t)nwork * 3);
+    for (int i = 0; i < nwork; ++i) {
+        const WorkPoly& p = work[i];
+        for (int k = 0; k < 3; ++k)
+            edges[edgeKey(p.v[k], p.v[(k + 1) % 3])] = i;
+    }
+
+    int merged[AREA_POLY_MAX_VERTS];
+    int best[AREA_POLY_MAX_VERTS];
+    for (int pi = 0; pi < nwork; ++pi) {
+        WorkPoly& p = work[pi];
+        if (!p.alive || !p.mergeable)
+            continue;
+
+        // Greedily absorb neighbours, longest shared edge first.
+        for (;;) {
+            int bestQ = -1;
+            int bestN = 0;
+            float bestLen = -1.0f;
+
+            for (int i = 0; i < p.nv; ++i) {
+                const int a = p.v[i];
+                const int b = p.v[(i + 1) % p.nv];
+                std::unordered_map<uint64_t, int>::const_iterator it = edges.find(edgeKey(b, a));
+                if (it == edges.end())
+                    continue;
+
+                const int qi = it->second;
+                if (qi == pi)
+                    continue;
+                const WorkPoly& q = work[qi];
+                if (!q.alive || !q.mergeable)
+                    continue;
+                if (p.nv + q.nv - 2 > AREA_POLY_MAX_VERTS)
+                    continue;
+
+                int jb = -1;
+                for (int j = 0; j < q.nv; ++j) {
+                    if (q.v[j] == b && q.v[(j + 1) % q.nv] == a) {
+                        jb = j;
+                        break;
+                    }
+                }
+                if (jb < 0)
+                    continue;
+
+                if (fmaxf(p.ymax, q.ymax) - fminf(p.ymin, q.ymin) > maxHeightSpan)
+                    continue;
+                if (!isCoplanar(verts, p, q, planeTolerance))
+                    continue;
+
+                const int n = mergePolys(verts, p, i, q, jb, merged);
+                if (n == 0)
+                    continue;
+
+                const float* va = &verts[a * 3];
+                const float* vb = &verts[b * 3];
+                const float dx = vb[0] - va[0];
+                const float dz = vb[2] - va[2];
+                const float len = dx * dx + dz * dz;
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestQ = qi;
+                    bestN = n;
+                    for (int k = 0; k < n; ++k)
+                        best[k] = merged[k];
+                }
+            }
+
+            if (bestQ < 0)
+                break;
+
+            WorkPoly& q = work[bestQ];
+            for (int k = 0; k < bestN; ++k)
+                p.v[k] = best[k];
+            p.nv = bestN;
+            p.ymin = fminf(p.ymin, q.ymin);
+            p.ymax = fmaxf(p.ymax, q.ymax);
+            q.alive = false;
+
+            for (int k = 0; k < p.nv; ++k)
+                edges[edgeKey(p.v[k], p.v[(k + 1) % p.nv])] = pi;
+        }
+    }
+
+    int npolys = 0;
+    int totalVerts = 0;
+    for (int i = 0; i < nwork; ++i) {
+        if (!work[i].alive) continue;
+        ++npolys;
+        totalVerts += work[i].nv;
+    }
+
+    ps->verts = new (std::nothrow) float[totalVerts * 3];
+    ps->polys = new (std::nothrow) int[npolys * 2];
+    ps->bounds = new (std::nothrow) float[npolys * 6];
+    if (!ps->verts || !ps->polys || !ps->bounds) {
+        delete[] work;
+        return false;
+    }
+
+    int vi = 0;
+    int pn = 0;
+    for (int i = 0; i < nwork; ++i) {
+        const WorkPoly& p = work[i];
+        if (!p.alive) continue;
+
+        float* bmin = &ps->bounds[pn * 6];
+        float* bmax = &ps->bounds[pn * 6 + 3];
+        ps->polys[pn * 2 + 0] = vi;
+        ps->polys[pn * 2 + 1] = p.nv;
+        for (int k = 0; k < p.nv; ++k) {
+            const float* v = &verts[p.v[k] * 3];
+            float* dst = &ps->verts[(vi + k) * 3];
+            dst[0] = v[0];
+            dst[1] = v[1];
+            dst[2] = v[2];
+            for (int c = 0; c < 3; ++c) {
+                if (k == 0 || v[c] < bmin[c]) bmin[c] = v[c];
+                if (k == 0 || v[c] > bmax[c]) bmax[c] = v[c];
+            }
+        }
+        vi += p.nv;
+        ++pn;
+    }
+
+    ps->npolys = npolys;
+    ps->nverts = totalVerts;
+
+    delete[] work;
+    return true;
+}
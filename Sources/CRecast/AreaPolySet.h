@@ -0,0 +1,42 @@
+// AreaPolySet.h
+// Convex polygons merged from area mesh triangles, for area marking
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef AREAPOLYSET_H
+#define AREAPOLYSET_H
+
+// Max vertices of a merged area polygon
+static const int AREA_POLY_MAX_VERTS = 12;
+
+// Convex polygons covering an area mesh. Adjacent coplanar triangles are
+// merged, so each tile issues one rcMarkConvexPolyArea call per polygon
+// instead of one per triangle. Vertex positions are copied out so a polygon
+// can be passed to Recast directly.
+struct rcAreaPolySet
+{
+    rcAreaPolySet();
+    ~rcAreaPolySet();
+
+    float* verts;           // xyz per vertex, polygons stored back to back
+    int* polys;             // [first vertex, vertex count] per polygon
+    float* bounds;          // [minx, miny, minz, maxx, maxy, maxz] per polygon
+    int npolys;
+    int nverts;
+
+private:
+    // Explicitly-disabled copy constructor and copy assignment operator.
+    rcAreaPolySet(const rcAreaPolySet&);
+    rcAreaPolySet& operator=(const rcAreaPolySet&);
+};
+
+// Builds the polygon set for ntris triangles. Two polygons are merged when
+// they share an edge with opposite winding, lie within planeTolerance of the
+// same plane, stay convex in xz, and their union spans at most maxHeightSpan
+// in y. Triangles that cannot be merged are kept as they are.
+// Returns false if memory could not be allocated.
+bool rcBuildAreaPolySet(const float* verts, int nverts, const int* tris, int ntris,
+                        float planeTolerance, float maxHeightSpan, rcAreaPolySet* ps);
+
+#endif // AREAPOLYSET_H
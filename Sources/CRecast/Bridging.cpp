@@ -8,14 +8,42 @@
 #include "Recast.h"
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
+#include "DetourCommon.h"
 #include "DetourNavMeshBuilder.h"
 #include "DetourNavMesh.h"
+#include "DetourTileCache.h"
+#include "DetourTileCacheBuilder.h"
+#include "ChunkyTriMesh.h"
+#include "AreaPolySet.h"
+#include "BuildScratch.h"
+#include "BuildContext.h"
+#include "TileDiskCache.h"
+#include "LZTileCompressor.h"
+#include "PackedHeightfield.h"
+#include "ObjMeshParser.h"
+#include "GeometryCleanup.h"
+#include "TilePortalGraph.h"
 
 #include <math.h>
 #include <string.h>
 #include <stdio.h>
 #include <float.h>
+#include <errno.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 // Helper functions
 static inline unsigned int nextPow2(unsigned int v)
@@ -42,6 +70,18 @@ static inline unsigned int ilog2(unsigned int v)
     return r;
 }
 
+// Max triangles per leaf of the per-build chunky triangle index
+static const int CHUNKY_TRIS_PER_CHUNK = 256;
+
+// Define BRIDGING_TRACE_AREA_MARKING to log every marked area polygon and each
+// tile's area summary. Off by default: rcContext::log formats its message even
+// when nothing is listening.
+#ifdef BRIDGING_TRACE_AREA_MARKING
+#define TRACE_AREA(ctx, ...) (ctx)->log(RC_LOG_PROGRESS, __VA_ARGS__)
+#else
+#define TRACE_AREA(ctx, ...) ((void)0)
+#endif
+
 // Structure to hold area marking data
 struct AreaMarkingData {
     const float* verts;
@@ -49,97 +89,200 @@ struct AreaMarkingData {
     const int* tris;
     int ntris;
     unsigned char areaCode;
+    const rcChunkyTriMesh* chunkyMesh;  // Optional spatial index over tris
+    const rcAreaPolySet* polySet;       // Merged convex polygons, or null to mark per triangle
 };
 
-// Mark areas from triangle mesh data
+// Build a chunky index over a triangle mesh, or return null if it could not be built
+static rcChunkyTriMesh* createChunkyMesh(const float* verts, const int* tris, int ntris)
+{
+    if (!verts || !tris || ntris <= 0) return nullptr;
+    
+    rcChunkyTriMesh* cm = new rcChunkyTriMesh;
+    if (!rcCreateChunkyTriMesh(verts, tris, ntris, CHUNKY_TRIS_PER_CHUNK, cm)) {
+        delete cm;
+        return nullptr;
+    }
+    return cm;
+}
+
+// Mark and rasterize a triangle mesh into the tile heightfield.
+// With a chunky index only the triangles overlapping the tile's border-expanded
+// bounds are touched; without one every triangle is processed.
+static bool rasterizeTileTriangles(rcContext* ctx, const rcConfig& tileCfg,
+                                   const float* verts, int nverts,
+                                   const int* tris, int ntris,
+                                   const rcChunkyTriMesh* chunkyMesh,
+                                   rcHeightfield& solid)
+{
+    // Scratch buffers are RC_ALLOC_TEMP, so a tile build serves them from its arena
+    if (!chunkyMesh) {
+        unsigned char* triareas = (unsigned char*)rcAlloc(ntris * sizeof(unsigned char), RC_ALLOC_TEMP);
+        if (!triareas) return false;
+        memset(triareas, 0, ntris * sizeof(unsigned char));
+        
+        rcMarkWalkableTriangles(ctx, tileCfg.walkableSlopeAngle, verts, nverts, tris, ntris, triareas);
+        const bool ok = rcRasterizeTriangles(ctx, verts, nverts, tris, triareas, ntris,
+                                             solid, tileCfg.walkableClimb);
+        rcFree(triareas);
+        return ok;
+    }
+    
+    const float tbmin[2] = { tileCfg.bmin[0], tileCfg.bmin[2] };
+    const float tbmax[2] = { tileCfg.bmax[0], tileCfg.bmax[2] };
+    
+    int* triIds = (int*)rcAlloc(chunkyMesh->ntris * sizeof(int), RC_ALLOC_TEMP);
+    if (!triIds) return false;
+    const int ntileTris = rcGatherTrianglesOverlappingRect(chunkyMesh, tbmin, tbmax, triIds);
+    if (ntileTris == 0) {
+        rcFree(triIds);
+        return true;
+    }
+    
+    int* tileTris = (int*)rcAlloc(ntileTris * 3 * sizeof(int), RC_ALLOC_TEMP);
+    unsigned char* triareas = (unsigned char*)rcAlloc(ntileTris * sizeof(unsigned char), RC_ALLOC_TEMP);
+    if (!tileTris || !triareas) {
+        rcFree(triareas);
+        rcFree(tileTris);
+        rcFree(triIds);
+        return false;
+    }
+    
+    for (int i = 0; i < ntileTris; ++i) {
+        const int* t = &tris[triIds[i] * 3];
+        tileTris[i * 3 + 0] = t[0];
+        tileTris[i * 3 + 1] = t[1];
+        tileTris[i * 3 + 2] = t[2];
+    }
+    memset(triareas, 0, ntileTris * sizeof(unsigned char));
+    
+    rcMarkWalkableTriangles(ctx, tileCfg.walkableSlopeAngle, verts, nverts, tileTris, ntileTris, triareas);
+    const bool ok = rcRasterizeTriangles(ctx, verts, nverts, tileTris, triareas, ntileTris,
+                                         solid, tileCfg.walkableClimb);
+    // Newest first, so the arena can unwind them
+    rcFree(triareas);
+    rcFree(tileTris);
+    rcFree(triIds);
+    return ok;
+}
+
+// Vertical slack applied around area polygons when marking. Adaptive with the
+// heightfield's Y range and position: high terrains need more tolerance.
+static float calcAreaHeightTolerance(float ch, float hfMinY, float hfMaxY)
+{
+    float baseTolerance = ch * 10.0f;
+    float rangeTolerance = (hfMaxY - hfMinY) * 0.05f; // 5% of Y range
+    float positionTolerance = rcAbs(hfMinY) * 0.001f; // 0.1% of absolute Y position
+    
+    float tolerance = rcMax(baseTolerance, rcMax(rangeTolerance, positionTolerance));
+    
+    // Also ensure minimum tolerance for very high Y values
+    if (hfMinY > 100.0f) {
+        tolerance = rcMax(tolerance, 1.0f); // At least 1 unit tolerance for high terrains
+    }
+    return tolerance;
+}
+
+// Mark one convex polygon if its xz bounds touch the tile's compact heightfield
+static bool markAreaPolyInTile(rcContext* ctx, rcCompactHeightfield& chf,
+                               const float* polyVerts, int npolyVerts,
+                               const float* pbmin, const float* pbmax,
+                               float tolerance, unsigned char areaCode)
+{
+    if (pbmax[0] < chf.bmin[0] || pbmin[0] > chf.bmax[0] ||
+        pbmax[2] < chf.bmin[2] || pbmin[2] > chf.bmax[2])
+        return false;
+    
+    rcMarkConvexPolyArea(ctx, polyVerts, npolyVerts,
+                         pbmin[1] - tolerance, pbmax[1] + tolerance,
+                         areaCode, chf);
+    return true;
+}
+
+// Mark areas from triangle mesh data. Only polygons overlapping the tile are
+// marked; per-polygon tracing is compiled in with BRIDGING_TRACE_AREA_MARKING.
 static void markAreasFromMesh(rcContext* ctx, rcCompactHeightfield& chf,
                               const AreaMarkingData* areas, int numAreas)
 {
     if (!areas || numAreas <= 0) return;
     
-    // Calculate the Y range of the heightfield for better tolerance
-    float hfMinY = chf.bmin[1];
-    float hfMaxY = chf.bmax[1];
-    float hfYRange = hfMaxY - hfMinY;
+    const float tolerance = calcAreaHeightTolerance(chf.ch, chf.bmin[1], chf.bmax[1]);
     
     for (int i = 0; i < numAreas; ++i) {
         const AreaMarkingData& area = areas[i];
         if (!area.verts || !area.tris || area.nverts == 0 || area.ntris == 0) continue;
         
-        ctx->log(RC_LOG_PROGRESS, "Marking area %d with code %d (%d triangles)",
-                 i, area.areaCode, area.ntris);
-        
-        // Process each triangle as a convex polygon
         int markedCount = 0;
-        for (int j = 0; j < area.ntris; ++j) {
-            const int* tri = &area.tris[j * 3];
-            
-            // Get triangle vertices
-            float triVerts[9];
-            for (int k = 0; k < 3; ++k) {
-                triVerts[k*3 + 0] = area.verts[tri[k]*3 + 0];
-                triVerts[k*3 + 1] = area.verts[tri[k]*3 + 1];
-                triVerts[k*3 + 2] = area.verts[tri[k]*3 + 2];
-            }
-            
-            // Calculate height bounds
-            float hmin = triVerts[1];
-            float hmax = triVerts[1];
-            for (int k = 1; k < 3; ++k) {
-                hmin = rcMin(hmin, triVerts[k*3 + 1]);
-                hmax = rcMax(hmax, triVerts[k*3 + 1]);
+        if (area.polySet) {
+            // Coplanar triangles merged into convex polygons once per build
+            const rcAreaPolySet& ps = *area.polySet;
+            for (int j = 0; j < ps.npolys; ++j) {
+                const float* polyVerts = &ps.verts[ps.polys[j * 2] * 3];
+                const int npolyVerts = ps.polys[j * 2 + 1];
+                const float* pbmin = &ps.bounds[j * 6];
+                const float* pbmax = &ps.bounds[j * 6 + 3];
+                if (!markAreaPolyInTile(ctx, chf, polyVerts, npolyVerts, pbmin, pbmax,
+                                        tolerance, area.areaCode))
+                    continue;
+                
+                TRACE_AREA(ctx, "Polygon %d (%d verts): Y range [%.2f, %.2f], tolerance: %.2f",
+                           j, npolyVerts, pbmin[1] - tolerance, pbmax[1] + tolerance, tolerance);
+                ++markedCount;
             }
-            
-            // Use adaptive tolerance based on the heightfield's Y range and position
-            // For high Y values, we need more tolerance
-            float baseTolerance = chf.ch * 10.0f;
-            float rangeTolerance = hfYRange * 0.05f; // 5% of Y range
-            float positionTolerance = rcAbs(hfMinY) * 0.001f; // 0.1% of absolute Y position
-            
-            float tolerance = rcMax(baseTolerance, rcMax(rangeTolerance, positionTolerance));
-            
-            // Also ensure minimum tolerance for very high Y values
-            if (hfMinY > 100.0f) {
-                tolerance = rcMax(tolerance, 1.0f); // At least 1 unit tolerance for high terrains
+        } else {
+            // Process each triangle as a convex polygon
+            for (int j = 0; j < area.ntris; ++j) {
+                const int* tri = &area.tris[j * 3];
+                
+                float triVerts[9];
+                float tbmin[3], tbmax[3];
+                for (int k = 0; k < 3; ++k) {
+                    rcVcopy(&triVerts[k * 3], &area.verts[tri[k] * 3]);
+                }
+                rcVcopy(tbmin, triVerts);
+                rcVcopy(tbmax, triVerts);
+                for (int k = 1; k < 3; ++k) {
+                    rcVmin(tbmin, &triVerts[k * 3]);
+                    rcVmax(tbmax, &triVerts[k * 3]);
+                }
+                if (!markAreaPolyInTile(ctx, chf, triVerts, 3, tbmin, tbmax,
+                                        tolerance, area.areaCode))
+                    continue;
+                
+                TRACE_AREA(ctx, "Triangle %d: Y range [%.2f, %.2f], tolerance: %.2f",
+                           j, tbmin[1] - tolerance, tbmax[1] + tolerance, tolerance);
+                ++markedCount;
             }
-            
-            hmin -= tolerance;
-            hmax += tolerance;
-            
-            ctx->log(RC_LOG_PROGRESS, "Triangle %d: Y range [%.2f, %.2f], tolerance: %.2f",
-                     j, hmin, hmax, tolerance);
-            
-            // Mark the triangle area
-            rcMarkConvexPolyArea(ctx,
-                                 triVerts, 3,
-                                 hmin, hmax,
-                                 area.areaCode, chf);
-            ++markedCount;
         }
         
-        ctx->log(RC_LOG_PROGRESS, "Marked %d/%d triangles for area %d",
-                 markedCount, area.ntris, i);
+        TRACE_AREA(ctx, "Marked %d polygons for area %d with code %d (%d triangles)",
+                   markedCount, i, area.areaCode, area.ntris);
+        (void)markedCount;
     }
 }
 
-// Build a single tile
-static unsigned char* buildTileMesh(int tx, int ty,
-                                   const float* bmin, const float* bmax,
-                                   int& dataSize,
-                                   rcConfig* cfg,
-                                   const TileConfig* tileConfig,
-                                   int flags,
-                                   const float* verts, int nverts,
-                                   const int* tris, int ntris,
-                                   const AreaMarkingData* areas,
-                                   int numAreas,
-                                   float agentHeight,
-                                   float agentRadius,
-                                   float agentMaxClimb,
-                                   rcContext* ctx)
+// Map the Recast areas of built polygons to navmesh areas and flags
+static void applyPolyAreaFlags(unsigned char* polyAreas, unsigned short* polyFlags, int npolys)
+{
+    for (int i = 0; i < npolys; ++i) {
+        // Only update walkable areas to default ground
+        if (polyAreas[i] == RC_WALKABLE_AREA) {
+            polyAreas[i] = 1; // Default ground area
+        }
+        
+        // Set flags based on area
+        if (polyAreas[i] == RC_NULL_AREA) {
+            polyFlags[i] = 0;
+        } else {
+            polyFlags[i] = 1; // All areas walkable by default
+        }
+    }
+}
+
+// Border-expanded build config of the tile with (unexpanded) bounds bmin/bmax
+static void calcTileConfig(const rcConfig* cfg, const TileConfig* tileConfig,
+                           const float* bmin, const float* bmax, rcConfig& tileCfg)
 {
-    dataSize = 0;
-    
     // Expand bounds by border size
     float tileBmin[3], tileBmax[3];
     rcVcopy(tileBmin, bmin);
@@ -150,15 +293,22 @@ static unsigned char* buildTileMesh(int tx, int ty,
     tileBmax[2] += cfg->borderSize * cfg->cs;
     
     // Update config for this tile
-    rcConfig tileCfg = *cfg;
+    tileCfg = *cfg;
     rcVcopy(tileCfg.bmin, tileBmin);
     rcVcopy(tileCfg.bmax, tileBmax);
     tileCfg.width = tileConfig->tileSize + tileCfg.borderSize * 2;
     tileCfg.height = tileConfig->tileSize + tileCfg.borderSize * 2;
-    
-    ctx->log(RC_LOG_PROGRESS, "Building tile (%d,%d) bounds: (%.2f,%.2f,%.2f) to (%.2f,%.2f,%.2f)",
-             tx, ty, tileBmin[0], tileBmin[1], tileBmin[2], tileBmax[0], tileBmax[1], tileBmax[2]);
-    
+}
+
+// Rasterize the tile geometry and the area triangles into a new heightfield.
+// tileCfg holds the border-expanded tile bounds.
+static rcHeightfield* rasterizeTileHeightfield(rcContext* ctx, const rcConfig& tileCfg,
+                                               const float* verts, int nverts,
+                                               const int* tris, int ntris,
+                                               const rcChunkyTriMesh* chunkyMesh,
+                                               const AreaMarkingData* areas,
+                                               int numAreas)
+{
     // Build heightfield
     rcHeightfield* solid = rcAllocHeightfield();
     if (!solid) return nullptr;
@@ -170,13 +320,7 @@ static unsigned char* buildTileMesh(int tx, int ty,
     }
     
     // Rasterize main geometry triangles
-    unsigned char* triareas = new unsigned char[ntris];
-    memset(triareas, 0, ntris * sizeof(unsigned char));
-    
-    rcMarkWalkableTriangles(ctx, tileCfg.walkableSlopeAngle, verts, nverts, tris, ntris, triareas);
-    
-    if (!rcRasterizeTriangles(ctx, verts, nverts, tris, triareas, ntris, *solid, tileCfg.walkableClimb)) {
-        delete[] triareas;
+    if (!rasterizeTileTriangles(ctx, tileCfg, verts, nverts, tris, ntris, chunkyMesh, *solid)) {
         rcFreeHeightfield(solid);
         return nullptr;
     }
@@ -188,47 +332,43 @@ static unsigned char* buildTileMesh(int tx, int ty,
             const AreaMarkingData& area = areas[i];
             if (!area.verts || !area.tris || area.nverts == 0 || area.ntris == 0) continue;
             
-            unsigned char* areaTriFlags = new unsigned char[area.ntris];
-            memset(areaTriFlags, 0, area.ntris * sizeof(unsigned char));
-            
-            // Mark all area triangles as walkable
-            rcMarkWalkableTriangles(ctx, tileCfg.walkableSlopeAngle,
-                                  area.verts, area.nverts,
-                                  area.tris, area.ntris, areaTriFlags);
-            
-            // Rasterize area triangles
-            rcRasterizeTriangles(ctx, area.verts, area.nverts,
-                               area.tris, areaTriFlags, area.ntris,
-                               *solid, tileCfg.walkableClimb);
-            
-            delete[] areaTriFlags;
+            rasterizeTileTriangles(ctx, tileCfg, area.verts, area.nverts,
+                                   area.tris, area.ntris, area.chunkyMesh, *solid);
         }
     }
     
-    delete[] triareas;
-    
+    return solid;
+}
+
+// Filter a packed tile heightfield, compact and erode it, and mark the
+// custom areas on the result. Filtering only changes span areas in solid.
+static rcCompactHeightfield* compactTileHeightfield(rcContext* ctx, const rcConfig& tileCfg,
+                                                    int flags, rcPackedHeightfield& solid,
+                                                    const AreaMarkingData* areas,
+                                                    int numAreas,
+                                                    int tx, int ty,
+                                                    BindingTileStats* stats)
+{
     // Filter walkable surfaces
     if (flags & FILTER_LOW_HANGING_OBSTACLES)
-        rcFilterLowHangingWalkableObstacles(ctx, tileCfg.walkableClimb, *solid);
+        rcFilterLowHangingWalkableObstacles(ctx, tileCfg.walkableClimb, solid);
     if (flags & FILTER_LEDGE_SPANS)
-        rcFilterLedgeSpans(ctx, tileCfg.walkableHeight, tileCfg.walkableClimb, *solid);
+        rcFilterLedgeSpans(ctx, tileCfg.walkableHeight, tileCfg.walkableClimb, solid);
     if (flags & FILTER_WALKABLE_LOW_HEIGHT_SPANS)
-        rcFilterWalkableLowHeightSpans(ctx, tileCfg.walkableHeight, *solid);
+        rcFilterWalkableLowHeightSpans(ctx, tileCfg.walkableHeight, solid);
+    
+    if (stats) stats->heightfieldSpans = rcGetHeightFieldSpanCount(ctx, solid);
     
     // Compact heightfield
     rcCompactHeightfield* chf = rcAllocCompactHeightfield();
-    if (!chf) {
-        rcFreeHeightfield(solid);
-        return nullptr;
-    }
+    if (!chf) return nullptr;
     
-    if (!rcBuildCompactHeightfield(ctx, tileCfg.walkableHeight, tileCfg.walkableClimb, *solid, *chf)) {
-        rcFreeHeightfield(solid);
+    if (!rcBuildCompactHeightfield(ctx, tileCfg.walkableHeight, tileCfg.walkableClimb, solid, *chf)) {
         rcFreeCompactHeightfield(chf);
         return nullptr;
     }
     
-    rcFreeHeightfield(solid);
+    if (stats) stats->compactSpans = chf->spanCount;
     
     // Erode walkable area
     if (!rcErodeWalkableArea(ctx, tileCfg.walkableRadius, *chf)) {
@@ -238,105 +378,228 @@ static unsigned char* buildTileMesh(int tx, int ty,
     
     // Mark custom areas AFTER erosion
     if (areas && numAreas > 0) {
-        ctx->log(RC_LOG_PROGRESS, "Tile (%d,%d): Marking %d custom area meshes", tx, ty, numAreas);
+        TRACE_AREA(ctx, "Tile (%d,%d): Marking %d custom area meshes", tx, ty, numAreas);
         markAreasFromMesh(ctx, *chf, areas, numAreas);
     }
     
+    return chf;
+}
+
+// Rasterize, filter and erode tile geometry into a compact heightfield and
+// mark the custom areas on it. tileCfg holds the border-expanded tile bounds.
+static rcCompactHeightfield* buildTileCompactHeightfield(rcContext* ctx, const rcConfig& tileCfg,
+                                                         int flags,
+                                                         const float* verts, int nverts,
+                                                         const int* tris, int ntris,
+                                                         const rcChunkyTriMesh* chunkyMesh,
+                                                         const AreaMarkingData* areas,
+                                                         int numAreas,
+                                                         int tx, int ty,
+                                                         BindingTileStats* stats)
+{
+    rcHeightfield* solid = rasterizeTileHeightfield(ctx, tileCfg, verts, nverts, tris, ntris,
+                                                    chunkyMesh, areas, numAreas);
+    if (!solid) return nullptr;
+    
+    // Filters and compaction stream through the packed spans
+    rcPackedHeightfield packed;
+    const bool ok = rcPackHeightfield(ctx, *solid, packed);
+    rcFreeHeightfield(solid);
+    if (!ok) return nullptr;
+    
+    return compactTileHeightfield(ctx, tileCfg, flags, packed, areas, numAreas, tx, ty, stats);
+}
+
+// Partition a tile's compact heightfield (which this frees) and build its
+// regions, contours and poly mesh, plus the detail mesh when buildDetail is
+// set; dmesh is left null otherwise. Watershed partitioning splits its passes
+// across regionThreads.
+static bool buildTilePolyMeshes(rcContext* ctx, const rcConfig& tileCfg, int flags,
+                                rcCompactHeightfield* chf,
+                                int regionThreads,
+                                bool buildDetail,
+                                rcPolyMesh*& pmesh,
+                                rcPolyMeshDetail*& dmesh,
+                                BindingTileStats* stats)
+{
+    pmesh = nullptr;
+    dmesh = nullptr;
+    
     // Partition heightfield
     int partition = flags & PARTITION_MASK;
     if (partition == PARTITION_WATERSHED) {
-        if (!rcBuildDistanceField(ctx, *chf) ||
-            !rcBuildRegions(ctx, *chf, tileCfg.borderSize, tileCfg.minRegionArea, tileCfg.mergeRegionArea)) {
+        if (!rcBuildDistanceField(ctx, *chf, regionThreads) ||
+            !rcBuildRegions(ctx, *chf, tileCfg.borderSize, tileCfg.minRegionArea, tileCfg.mergeRegionArea,
+                            regionThreads)) {
             rcFreeCompactHeightfield(chf);
-            return nullptr;
+            return false;
         }
     } else if (partition == PARTITION_MONOTONE) {
         if (!rcBuildRegionsMonotone(ctx, *chf, tileCfg.borderSize, tileCfg.minRegionArea, tileCfg.mergeRegionArea)) {
             rcFreeCompactHeightfield(chf);
-            return nullptr;
+            return false;
         }
     } else {
         if (!rcBuildLayerRegions(ctx, *chf, tileCfg.borderSize, tileCfg.minRegionArea)) {
             rcFreeCompactHeightfield(chf);
-            return nullptr;
+            return false;
         }
     }
     
+    if (stats) stats->regions = chf->maxRegions;
+    
     // Build contours
     rcContourSet* cset = rcAllocContourSet();
     if (!cset) {
         rcFreeCompactHeightfield(chf);
-        return nullptr;
+        return false;
     }
     
     if (!rcBuildContours(ctx, *chf, tileCfg.maxSimplificationError, tileCfg.maxEdgeLen, *cset)) {
         rcFreeCompactHeightfield(chf);
         rcFreeContourSet(cset);
-        return nullptr;
+        return false;
     }
     
+    if (stats) stats->contours = cset->nconts;
+    
     // Build polygon mesh
-    rcPolyMesh* pmesh = rcAllocPolyMesh();
+    pmesh = rcAllocPolyMesh();
     if (!pmesh) {
         rcFreeCompactHeightfield(chf);
         rcFreeContourSet(cset);
-        return nullptr;
+        return false;
     }
     
     if (!rcBuildPolyMesh(ctx, *cset, tileCfg.maxVertsPerPoly, *pmesh)) {
         rcFreeCompactHeightfield(chf);
         rcFreeContourSet(cset);
         rcFreePolyMesh(pmesh);
-        return nullptr;
+        pmesh = nullptr;
+        return false;
+    }
+    
+    rcFreeContourSet(cset);
+    
+    if (stats) stats->polys = pmesh->npolys;
+    
+    if (!buildDetail) {
+        rcFreeCompactHeightfield(chf);
+        return true;
     }
     
     // Build detail mesh
-    rcPolyMeshDetail* dmesh = rcAllocPolyMeshDetail();
+    dmesh = rcAllocPolyMeshDetail();
     if (!dmesh) {
         rcFreeCompactHeightfield(chf);
-        rcFreeContourSet(cset);
         rcFreePolyMesh(pmesh);
-        return nullptr;
+        pmesh = nullptr;
+        return false;
     }
     
     if (!rcBuildPolyMeshDetail(ctx, *pmesh, *chf, tileCfg.detailSampleDist,
                               tileCfg.detailSampleMaxError, *dmesh)) {
         rcFreeCompactHeightfield(chf);
-        rcFreeContourSet(cset);
         rcFreePolyMesh(pmesh);
         rcFreePolyMeshDetail(dmesh);
-        return nullptr;
+        pmesh = nullptr;
+        dmesh = nullptr;
+        return false;
     }
     
     rcFreeCompactHeightfield(chf);
-    rcFreeContourSet(cset);
     
-    // Update poly flags and areas
-    int areaStats[256] = {0};
-    
-    for (int i = 0; i < pmesh->npolys; ++i) {
-        ++areaStats[pmesh->areas[i]];
-        
-        // Only update walkable areas to default ground
-        if (pmesh->areas[i] == RC_WALKABLE_AREA) {
-            pmesh->areas[i] = 1; // Default ground area
-        }
-        
-        // Set flags based on area
-        if (pmesh->areas[i] == RC_NULL_AREA) {
-            pmesh->flags[i] = 0;
-        } else {
-            pmesh->flags[i] = 1; // All areas walkable by default
+    if (stats) stats->detailTris = dmesh->ntris;
+    return true;
+}
+
+// Mark the open polygon edges of a layer's mesh that run along the cells
+// where the layer steps onto another one (see extractTileLayer) as portals,
+// in the direction of the step. Detour links portals between the layers of
+// one tile, as it does for the tile cache's layers.
+static void markLayerPortals(rcPolyMesh& pmesh, const unsigned char* portals, int w, int h, int borderSize)
+{
+    const int nvp = pmesh.nvp;
+    for (int i = 0; i < pmesh.npolys; ++i) {
+        unsigned short* p = &pmesh.polys[i * 2 * nvp];
+        for (int j = 0; j < nvp && p[j] != RC_MESH_NULL_IDX; ++j) {
+            if (p[nvp + j] != RC_MESH_NULL_IDX) continue;
+            
+            const int nj = (j + 1 < nvp && p[j + 1] != RC_MESH_NULL_IDX) ? j + 1 : 0;
+            const unsigned short* va = &pmesh.verts[p[j] * 3];
+            const unsigned short* vb = &pmesh.verts[p[nj] * 3];
+            
+            // Only edges along the grid line between two rows or columns of cells
+            int dirA, dirB, line, lo, hi;
+            if (va[0] == vb[0]) {
+                dirA = 2; dirB = 0; line = va[0]; lo = rcMin(va[2], vb[2]); hi = rcMax(va[2], vb[2]);
+            } else if (va[2] == vb[2]) {
+                dirA = 1; dirB = 3; line = va[2]; lo = rcMin(va[0], vb[0]); hi = rcMax(va[0], vb[0]);
+            } else {
+                continue;
+            }
+            
+            // The cells before the line step over it in dirA, the ones after it in dirB
+            int dir = -1;
+            for (int k = lo; k < hi && dir < 0; ++k) {
+                const int before = line - 1 + borderSize;
+                const int after = line + borderSize;
+                const int along = k + borderSize;
+                const int ib = dirA == 2 ? before + along * w : along + before * w;
+                const int ia = dirA == 2 ? after + along * w : along + after * w;
+                if (before >= 0 && (dirA == 2 ? before < w : before < h) && (portals[ib] & (1 << dirA)))
+                    dir = dirA;
+                else if ((dirA == 2 ? after < w : after < h) && (portals[ia] & (1 << dirB)))
+                    dir = dirB;
+            }
+            if (dir >= 0) p[nvp + j] = (unsigned short)(0x8000 | dir);
         }
     }
+}
+
+// Turn a tile's compact heightfield (which this frees) into Detour tile data
+// for layer tlayer of tile (tx, ty). layerPortals, when given, are the cells
+// where the layer meets the tile's other layers (see extractTileLayer), whose
+// edges become portals between them. With BUILD_LAZY_DETAIL_MESH the detail
+// mesh is skipped and Detour gives every polygon a flat fan of triangles, so
+// heights follow the polygon planes until a LazyDetailCache attaches the real
+// detail mesh.
+static unsigned char* buildTileNavData(rcContext* ctx, const rcConfig& tileCfg, int flags,
+                                       rcCompactHeightfield* chf,
+                                       int tx, int ty, int tlayer,
+                                       const unsigned char* layerPortals,
+                                       float agentHeight,
+                                       float agentRadius,
+                                       float agentMaxClimb,
+                                       int regionThreads,
+                                       int& dataSize,
+                                       BindingTileStats* stats)
+{
+    dataSize = 0;
+    
+    rcPolyMesh* pmesh = nullptr;
+    rcPolyMeshDetail* dmesh = nullptr;
+    if (!buildTilePolyMeshes(ctx, tileCfg, flags, chf, regionThreads,
+                             (flags & BUILD_LAZY_DETAIL_MESH) == 0, pmesh, dmesh, stats))
+        return nullptr;
+    
+    if (layerPortals)
+        markLayerPortals(*pmesh, layerPortals, tileCfg.width, tileCfg.height, tileCfg.borderSize);
     
-    // Log area statistics
-    ctx->log(RC_LOG_PROGRESS, "Tile (%d,%d) area distribution:", tx, ty);
+#ifdef BRIDGING_TRACE_AREA_MARKING
+    int areaStats[256] = {0};
+    for (int i = 0; i < pmesh->npolys; ++i)
+        ++areaStats[pmesh->areas[i]];
+    TRACE_AREA(ctx, "Tile (%d,%d) area distribution:", tx, ty);
     for (int i = 0; i < 256; ++i) {
         if (areaStats[i] > 0) {
-            ctx->log(RC_LOG_PROGRESS, "  Area %d: %d polygons", i, areaStats[i]);
+            TRACE_AREA(ctx, "  Area %d: %d polygons", i, areaStats[i]);
         }
     }
+#endif
+    
+    // Update poly flags and areas
+    applyPolyAreaFlags(pmesh->areas, pmesh->flags, pmesh->npolys);
     
     // Create Detour data
     dtNavMeshCreateParams params;
@@ -348,17 +611,19 @@ static unsigned char* buildTileMesh(int tx, int ty,
     params.polyFlags = pmesh->flags;
     params.polyCount = pmesh->npolys;
     params.nvp = pmesh->nvp;
-    params.detailMeshes = dmesh->meshes;
-    params.detailVerts = dmesh->verts;
-    params.detailVertsCount = dmesh->nverts;
-    params.detailTris = dmesh->tris;
-    params.detailTriCount = dmesh->ntris;
+    if (dmesh) {
+        params.detailMeshes = dmesh->meshes;
+        params.detailVerts = dmesh->verts;
+        params.detailVertsCount = dmesh->nverts;
+        params.detailTris = dmesh->tris;
+        params.detailTriCount = dmesh->ntris;
+    }
     params.walkableHeight = agentHeight;
     params.walkableRadius = agentRadius;
     params.walkableClimb = agentMaxClimb;
     params.tileX = tx;
     params.tileY = ty;
-    params.tileLayer = 0;
+    params.tileLayer = tlayer;
     rcVcopy(params.bmin, pmesh->bmin);
     rcVcopy(params.bmax, pmesh->bmax);
     params.cs = tileCfg.cs;
@@ -375,6 +640,7 @@ static unsigned char* buildTileMesh(int tx, int ty,
     }
     
     dataSize = navDataSize;
+    if (stats) stats->dataSize = navDataSize;
     
     rcFreePolyMesh(pmesh);
     rcFreePolyMeshDetail(dmesh);
@@ -382,241 +648,3397 @@ static unsigned char* buildTileMesh(int tx, int ty,
     return navData;
 }
 
-// Main tiled navmesh building function - updated to use raw geometry
-static struct BindingTileMeshResult* buildTiledNavMeshImpl(
-    rcConfig* config,
-    const TileConfig* tileConfig,
-    int flags,
-    const float* verts,
-    int numVerts,
-    const int* tris,
-    int numTris,
-    const float** areaVerts,      // Array of vertex arrays
-    const int* areaVertCounts,    // Number of vertices for each area
-    const int** areaTris,         // Array of triangle arrays
-    const int* areaTriCounts,     // Number of triangles for each area
-    const unsigned char* areaCodes,
-    int numAreaMeshes,
-    float agentHeight,
-    float agentRadius,
-    float agentMaxClimb)
+// Build a single tile
+static unsigned char* buildTileMesh(int tx, int ty,
+                                   const float* bmin, const float* bmax,
+                                   int& dataSize,
+                                   rcConfig* cfg,
+                                   const TileConfig* tileConfig,
+                                   int flags,
+                                   const float* verts, int nverts,
+                                   const int* tris, int ntris,
+                                   const rcChunkyTriMesh* chunkyMesh,
+                                   const AreaMarkingData* areas,
+                                   int numAreas,
+                                   float agentHeight,
+                                   float agentRadius,
+                                   float agentMaxClimb,
+                                   int regionThreads,
+                                   rcContext* ctx,
+                                   BindingTileStats* stats)
 {
-    BindingTileMeshResult* result = (BindingTileMeshResult*)calloc(1, sizeof(BindingTileMeshResult));
-    if (!result) return nullptr;
+    dataSize = 0;
     
-    result->code = BCODE_ERR_UNKNOWN;
-    result->navMesh = nullptr;
-    result->tilesBuilt = 0;
+    rcScopedTimer totalTimer(ctx, RC_TIMER_TOTAL);
     
-    rcContext ctx;
+    rcConfig tileCfg;
+    calcTileConfig(cfg, tileConfig, bmin, bmax, tileCfg);
     
-    // Calculate grid size
-    int gw = 0, gh = 0;
-    rcCalcGridSize(config->bmin, config->bmax, config->cs, &gw, &gh);
-    const int ts = tileConfig->tileSize;
-    const int tw = (gw + ts - 1) / ts;
-    const int th = (gh + ts - 1) / ts;
-    result->totalTiles = tw * th;
+    ctx->log(RC_LOG_PROGRESS, "Building tile (%d,%d) bounds: (%.2f,%.2f,%.2f) to (%.2f,%.2f,%.2f)",
+             tx, ty, tileCfg.bmin[0], tileCfg.bmin[1], tileCfg.bmin[2],
+             tileCfg.bmax[0], tileCfg.bmax[1], tileCfg.bmax[2]);
     
-    // Calculate max tiles and polys per tile
-    int tileBits = rcMin((int)ilog2(nextPow2(tw * th)), 14);
-    if (tileBits > 14) tileBits = 14;
-    int polyBits = 22 - tileBits;
-    int maxTiles = 1 << tileBits;
-    int maxPolysPerTile = 1 << polyBits;
+    rcCompactHeightfield* chf = buildTileCompactHeightfield(ctx, tileCfg, flags,
+                                                            verts, nverts, tris, ntris, chunkyMesh,
+                                                            areas, numAreas, tx, ty, stats);
+    if (!chf) return nullptr;
     
-    // Allocate navmesh
-    result->navMesh = dtAllocNavMesh();
-    if (!result->navMesh) {
-        result->code = BCODE_ERR_MEMORY;
-        return result;
-    }
+    return buildTileNavData(ctx, tileCfg, flags, chf, tx, ty, 0, nullptr,
+                            agentHeight, agentRadius, agentMaxClimb, regionThreads, dataSize, stats);
+}
+
+// Inputs shared by every tile of one build. Read-only while tiles are being built.
+struct TileBuildParams {
+    rcConfig* cfg;
+    const TileConfig* tileConfig;
+    int flags;
+    const float* verts;
+    int nverts;
+    const int* tris;
+    int ntris;
+    const rcChunkyTriMesh* chunkyMesh;
+    const AreaMarkingData* areas;
+    int numAreas;
+    float agentHeight;
+    float agentRadius;
+    float agentMaxClimb;
+    int tw;                 // Tiles along x
+    int th;                 // Tiles along z
+    const char* cacheDir;   // On-disk tile cache directory, or null
     
-    // Initialize navmesh
-    dtNavMeshParams params;
-    rcVcopy(params.orig, config->bmin);
-    params.tileWidth = tileConfig->tileSize * config->cs;
-    params.tileHeight = tileConfig->tileSize * config->cs;
-    params.maxTiles = maxTiles;
-    params.maxPolys = maxPolysPerTile;
+    // With BUILD_TILE_LAYERS, the userId of every layer the navmesh holds for
+    // each tile to build (MAX_TILE_LAYERS per tile, 0 where there is none), or null
+    const unsigned int* currentLayers;
+};
+
+// Layers expected per tile, for sizing layered navmeshes and tile caches
+static const int EXPECTED_TILE_LAYERS = 4;
+
+// dtTileCacheLayerHeader stores the layer index in a byte, and the sample
+// pipeline caps it far lower; more layers than this are dropped
+static const int MAX_TILE_LAYERS = 32;
+
+// Output slot for one tile in a parallel build
+struct TileBuildOutput {
+    unsigned char* data;
+    int dataSize;
+    bool done;
+};
+
+struct TileData {
+    unsigned char* data;
+    int dataSize;
+};
+
+// The Detour tiles built for one tile: a single one, or one per layer with
+// BUILD_TILE_LAYERS, each header giving its layer
+struct TileColumn {
+    std::vector<TileData> tiles;
+    unsigned int keptLayers;    // Bit per layer whose tile in the navmesh is still current
+    bool done;                  // Set once built, for the ordered commit of a parallel build
+};
+
+// Calculate the number of tiles along x and z
+static void calcTileGrid(const rcConfig* cfg, int tileSize, int& tw, int& th)
+{
+    int gw = 0, gh = 0;
+    rcCalcGridSize(cfg->bmin, cfg->bmax, cfg->cs, &gw, &gh);
+    tw = (gw + tileSize - 1) / tileSize;
+    th = (gh + tileSize - 1) / tileSize;
+}
+
+// Calculate the (unexpanded) world bounds of tile (x, y)
+static void calcTileBounds(const rcConfig* cfg, float tcs, int x, int y,
+                           float* tileBmin, float* tileBmax)
+{
+    tileBmin[0] = cfg->bmin[0] + x * tcs;
+    tileBmin[1] = cfg->bmin[1];
+    tileBmin[2] = cfg->bmin[2] + y * tcs;
     
-    dtStatus status = result->navMesh->init(&params);
-    if (dtStatusFailed(status)) {
-        result->code = BCODE_ERR_INIT_TILE_NAVMESH;
-        return result;
-    }
+    tileBmax[0] = cfg->bmin[0] + (x + 1) * tcs;
+    tileBmax[1] = cfg->bmax[1];
+    tileBmax[2] = cfg->bmin[2] + (y + 1) * tcs;
+}
+
+// Build the area marking data, with a triangle index per area when requested.
+// Returns null when there are no usable areas.
+static AreaMarkingData* createAreaMarkingData(const rcConfig* config, bool indexTriangles,
+                                              const float** areaVerts,
+                                              const int* areaVertCounts,
+                                              const int** areaTris,
+                                              const int* areaTriCounts,
+                                              const unsigned char* areaCodes,
+                                              int numAreaMeshes)
+{
+    if (numAreaMeshes <= 0 || !areaVerts || !areaTris || !areaCodes) return nullptr;
     
-    // Prepare area marking data
-    AreaMarkingData* areas = nullptr;
-    if (numAreaMeshes > 0 && areaVerts && areaTris && areaCodes) {
-        areas = new AreaMarkingData[numAreaMeshes];
-        for (int i = 0; i < numAreaMeshes; ++i) {
-            areas[i].verts = areaVerts[i];
-            areas[i].nverts = areaVertCounts[i];
-            areas[i].tris = areaTris[i];
-            areas[i].ntris = areaTriCounts[i];
-            areas[i].areaCode = areaCodes[i];
-        }
+    AreaMarkingData* areas = new AreaMarkingData[numAreaMeshes];
+    for (int i = 0; i < numAreaMeshes; ++i) {
+        areas[i].verts = areaVerts[i];
+        areas[i].nverts = areaVertCounts[i];
+        areas[i].tris = areaTris[i];
+        areas[i].ntris = areaTriCounts[i];
+        areas[i].areaCode = areaCodes[i];
+        areas[i].chunkyMesh = indexTriangles
+            ? createChunkyMesh(areas[i].verts, areas[i].tris, areas[i].ntris) : nullptr;
+        areas[i].polySet = nullptr;
     }
     
-    // Build all tiles
-    const float tcs = tileConfig->tileSize * config->cs;
-    
-    for (int y = 0; y < th; ++y) {
-        for (int x = 0; x < tw; ++x) {
-            float tileBmin[3], tileBmax[3];
-            tileBmin[0] = config->bmin[0] + x * tcs;
-            tileBmin[1] = config->bmin[1];
-            tileBmin[2] = config->bmin[2] + y * tcs;
-            
-            tileBmax[0] = config->bmin[0] + (x + 1) * tcs;
-            tileBmax[1] = config->bmax[1];
-            tileBmax[2] = config->bmin[2] + (y + 1) * tcs;
-            
-            int dataSize = 0;
-            unsigned char* data = buildTileMesh(x, y, tileBmin, tileBmax, dataSize,
-                                               config, tileConfig, flags,
-                                               verts, numVerts, tris, numTris,
-                                               areas, numAreaMeshes,
-                                               agentHeight, agentRadius, agentMaxClimb,
-                                               &ctx);
-            
-            if (data) {
-                result->navMesh->removeTile(result->navMesh->getTileRefAt(x, y, 0), 0, 0);
-                
-                status = result->navMesh->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, 0);
-                if (dtStatusFailed(status)) {
-                    dtFree(data);
-                    result->code = BCODE_ERR_ADD_TILE;
-                } else {
-                    result->tilesBuilt++;
-                }
-            }
+    // Merge coplanar area triangles once, instead of marking each triangle in every tile.
+    // A merged polygon may span at most one tolerance more in y than its source triangles.
+    const float tolerance = calcAreaHeightTolerance(
+        config->ch, config->bmin[1], config->bmax[1] + config->walkableHeight * config->ch);
+    for (int i = 0; i < numAreaMeshes; ++i) {
+        rcAreaPolySet* ps = new rcAreaPolySet;
+        if (rcBuildAreaPolySet(areas[i].verts, areas[i].nverts, areas[i].tris, areas[i].ntris,
+                               config->ch * 0.5f, tolerance, ps)) {
+            areas[i].polySet = ps;
+        } else {
+            delete ps;
         }
     }
-    
-    delete[] areas;
-    
-    result->code = (result->tilesBuilt > 0) ? BCODE_OK : BCODE_ERR_BUILD_TILE;
+    return areas;
+}
+
+static void releaseAreaMarkingData(AreaMarkingData* areas, int numAreas)
+{
+    if (!areas) return;
+    for (int i = 0; i < numAreas; ++i) {
+        delete areas[i].chunkyMesh;
+        delete areas[i].polySet;
+    }
+    delete[] areas;
+}
+
+// Bumped whenever the tile build changes what it produces for the same input
+static const int TILE_BUILD_REVISION = 1;
+
+// Hash the configuration, flags and agent every tile of the build shares
+static void hashBuildConfig(TileHasher& hasher, const TileBuildParams& bp)
+{
+    const rcConfig& cfg = *bp.cfg;
+    hasher.addValue(bp.flags);
+    hasher.addValue(bp.tileConfig->tileSize);
+    hasher.addValue(cfg.cs);
+    hasher.addValue(cfg.ch);
+    hasher.addValue(cfg.walkableSlopeAngle);
+    hasher.addValue(cfg.walkableHeight);
+    hasher.addValue(cfg.walkableClimb);
+    hasher.addValue(cfg.walkableRadius);
+    hasher.addValue(cfg.maxEdgeLen);
+    hasher.addValue(cfg.maxSimplificationError);
+    hasher.addValue(cfg.minRegionArea);
+    hasher.addValue(cfg.mergeRegionArea);
+    hasher.addValue(cfg.maxVertsPerPoly);
+    hasher.addValue(cfg.detailSampleDist);
+    hasher.addValue(cfg.detailSampleMaxError);
+    hasher.addValue(cfg.borderSize);
+    hasher.addValue(bp.agentHeight);
+    hasher.addValue(bp.agentRadius);
+    hasher.addValue(bp.agentMaxClimb);
+}
+
+// Hash everything buildTileMesh reads for tile (x, y): the configuration and
+// filter flags, the triangles overlapping the border-expanded tile bounds in
+// the order they are rasterized, and the area polygons touching those bounds.
+static TileDiskCacheKey hashTileInput(const TileBuildParams& bp, int x, int y)
+{
+    const rcConfig& cfg = *bp.cfg;
+    const float tcs = bp.tileConfig->tileSize * cfg.cs;
+    float bmin[3], bmax[3];
+    calcTileBounds(bp.cfg, tcs, x, y, bmin, bmax);
+    bmin[0] -= cfg.borderSize * cfg.cs;
+    bmin[2] -= cfg.borderSize * cfg.cs;
+    bmax[0] += cfg.borderSize * cfg.cs;
+    bmax[2] += cfg.borderSize * cfg.cs;
+    
+    TileHasher hasher;
+    hasher.addValue(TILE_BUILD_REVISION);
+    hasher.addValue(DT_NAVMESH_VERSION);
+    hasher.addValue(x);
+    hasher.addValue(y);
+    hasher.add(bmin, sizeof(bmin));
+    hasher.add(bmax, sizeof(bmax));
+    hashBuildConfig(hasher, bp);
+    
+    // Geometry, by position rather than index, so unrelated edits that shift
+    // vertex indices leave the key alone
+    std::vector<int> triIds;
+    int ntileTris = bp.ntris;
+    if (bp.chunkyMesh) {
+        const float tbmin[2] = { bmin[0], bmin[2] };
+        const float tbmax[2] = { bmax[0], bmax[2] };
+        triIds.resize(bp.chunkyMesh->ntris);
+        ntileTris = triIds.empty() ? 0 : rcGatherTrianglesOverlappingRect(bp.chunkyMesh, tbmin, tbmax, &triIds[0]);
+    }
+    hasher.addValue(ntileTris);
+    for (int i = 0; i < ntileTris; ++i) {
+        const int* t = &bp.tris[(bp.chunkyMesh ? triIds[i] : i) * 3];
+        for (int k = 0; k < 3; ++k)
+            hasher.add(&bp.verts[t[k] * 3], sizeof(float) * 3);
+    }
+    
+    // Areas, with the same xz cull the marking applies
+    for (int i = 0; i < bp.numAreas; ++i) {
+        const AreaMarkingData& area = bp.areas[i];
+        if (!area.verts || !area.tris || area.nverts == 0 || area.ntris == 0) continue;
+        hasher.addValue(i);
+        hasher.addValue(area.areaCode);
+        
+        if (area.polySet) {
+            const rcAreaPolySet& ps = *area.polySet;
+            for (int j = 0; j < ps.npolys; ++j) {
+                const float* pbmin = &ps.bounds[j * 6];
+                const float* pbmax = &ps.bounds[j * 6 + 3];
+                if (pbmax[0] < bmin[0] || pbmin[0] > bmax[0] || pbmax[2] < bmin[2] || pbmin[2] > bmax[2])
+                    continue;
+                hasher.addValue(ps.polys[j * 2 + 1]);
+                hasher.add(&ps.verts[ps.polys[j * 2] * 3], sizeof(float) * 3 * ps.polys[j * 2 + 1]);
+                hasher.add(pbmin, sizeof(float) * 3);
+                hasher.add(pbmax, sizeof(float) * 3);
+            }
+        } else {
+            for (int j = 0; j < area.ntris; ++j) {
+                const int* tri = &area.tris[j * 3];
+                float tbmin[3], tbmax[3];
+                rcVcopy(tbmin, &area.verts[tri[0] * 3]);
+                rcVcopy(tbmax, &area.verts[tri[0] * 3]);
+                for (int k = 1; k < 3; ++k) {
+                    rcVmin(tbmin, &area.verts[tri[k] * 3]);
+                    rcVmax(tbmax, &area.verts[tri[k] * 3]);
+                }
+                if (tbmax[0] < bmin[0] || tbmin[0] > bmax[0] || tbmax[2] < bmin[2] || tbmin[2] > bmax[2])
+                    continue;
+                for (int k = 0; k < 3; ++k)
+                    hasher.add(&area.verts[tri[k] * 3], sizeof(float) * 3);
+            }
+        }
+    }
+    
+    return hasher.finish();
+}
+
+static inline double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Threads partitioning each tile: regionThreads when set, otherwise all the
+// build's threads for a single-tile build, whose tile pool has one worker,
+// and one thread for tiled builds
+static int resolveRegionThreads(const TileBuildParams& bp)
+{
+    int n = bp.tileConfig->regionThreads;
+    if (n <= 0) {
+        if (bp.tw * bp.th > 1) return 1;
+        n = bp.tileConfig->numThreads;
+        if (n <= 0) n = (int)std::thread::hardware_concurrency();
+    }
+    return rcMax(1, n);
+}
+
+// ================================================
+//       Layered tiles
+// ================================================
+
+// Give walkable spans of cell (x, y) without a layer the layer of a connected
+// span, unless another span of the cell is in that layer already
+static void joinNeighbourLayer(const rcCompactHeightfield& chf, int x, int y, unsigned char* spanLayers)
+{
+    const rcCompactCell& c = chf.cells[x + y * chf.width];
+    for (int i = (int)c.index, ni = (int)(c.index + c.count); i < ni; ++i) {
+        if (spanLayers[i] != 0xff || chf.areas[i] == RC_NULL_AREA) continue;
+        
+        const rcCompactSpan& s = chf.spans[i];
+        for (int dir = 0; dir < 4 && spanLayers[i] == 0xff; ++dir) {
+            if (rcGetCon(s, dir) == RC_NOT_CONNECTED) continue;
+            const int ax = x + rcGetDirOffsetX(dir);
+            const int ay = y + rcGetDirOffsetY(dir);
+            const unsigned char layer = spanLayers[(int)chf.cells[ax + ay * chf.width].index + rcGetCon(s, dir)];
+            if (layer == 0xff) continue;
+            
+            bool taken = false;
+            for (int j = (int)c.index; j < ni && !taken; ++j)
+                taken = spanLayers[j] == layer;
+            if (!taken) spanLayers[i] = layer;
+        }
+    }
+}
+
+// Split a tile's compact heightfield into the layers rcBuildHeightfieldLayers
+// finds, as the tile cache stores them; only the first MAX_TILE_LAYERS are
+// used. With spanLayers every span also gets its layer, or 0xff. Border spans,
+// which the layers leave out, join the layer of a connected span, ring by ring
+// from the inside, so that each layer's polygons still reach the tile edges.
+static bool splitTileLayers(rcContext* ctx, const rcConfig& tileCfg, const rcCompactHeightfield& chf,
+                            rcHeightfieldLayerSet& lset, unsigned char* spanLayers)
+{
+    if (!rcBuildHeightfieldLayers(ctx, chf, tileCfg.borderSize, tileCfg.walkableHeight, lset, spanLayers))
+        return false;
+    if (!spanLayers) return true;
+    
+    for (int i = 0; i < chf.spanCount; ++i) {
+        if (spanLayers[i] != 0xff && spanLayers[i] >= MAX_TILE_LAYERS)
+            spanLayers[i] = 0xff;
+    }
+    
+    const int w = chf.width;
+    const int h = chf.height;
+    const int bs = rcMin(tileCfg.borderSize, rcMin(w, h) / 2);
+    for (int ring = 1; ring <= bs; ++ring) {
+        const int x0 = bs - ring, x1 = w - 1 - bs + ring;
+        const int y0 = bs - ring, y1 = h - 1 - bs + ring;
+        const int side = rcMax(x1 - x0, 1);
+        
+        // A second sweep lets the corners follow the cells beside them
+        for (int sweep = 0; sweep < 2; ++sweep) {
+            for (int y = y0; y <= y1; ++y) {
+                const int step = (y == y0 || y == y1) ? 1 : side;
+                for (int x = x0; x <= x1; x += step)
+                    joinNeighbourLayer(chf, x, y, spanLayers);
+            }
+        }
+    }
+    return true;
+}
+
+// Copy the spans of one layer, with the connections between them, into a
+// compact heightfield of their own. Every cell holds at most one of them.
+// With portals (one byte per cell) each cell also gets bit 1 << dir set where
+// its span connects in direction dir to a span of another layer.
+static rcCompactHeightfield* extractTileLayer(const rcCompactHeightfield& chf, const unsigned char* spanLayers,
+                                              int layer, unsigned char* portals)
+{
+    const int w = chf.width;
+    const int h = chf.height;
+    
+    if (portals) memset(portals, 0, w * h);
+    
+    int spanCount = 0;
+    for (int i = 0; i < chf.spanCount; ++i) {
+        if (spanLayers[i] == layer) ++spanCount;
+    }
+    
+    rcCompactHeightfield* lchf = rcAllocCompactHeightfield();
+    if (!lchf) return nullptr;
+    
+    lchf->width = w;
+    lchf->height = h;
+    lchf->spanCount = spanCount;
+    lchf->walkableHeight = chf.walkableHeight;
+    lchf->walkableClimb = chf.walkableClimb;
+    lchf->borderSize = chf.borderSize;
+    lchf->maxDistance = 0;
+    lchf->maxRegions = 0;
+    rcVcopy(lchf->bmin, chf.bmin);
+    rcVcopy(lchf->bmax, chf.bmax);
+    lchf->cs = chf.cs;
+    lchf->ch = chf.ch;
+    lchf->cells = (rcCompactCell*)rcAlloc(sizeof(rcCompactCell) * w * h, RC_ALLOC_PERM);
+    lchf->spans = (rcCompactSpan*)rcAlloc(sizeof(rcCompactSpan) * rcMax(spanCount, 1), RC_ALLOC_PERM);
+    lchf->areas = (unsigned char*)rcAlloc(rcMax(spanCount, 1), RC_ALLOC_PERM);
+    if (!lchf->cells || !lchf->spans || !lchf->areas) {
+        rcFreeCompactHeightfield(lchf);
+        return nullptr;
+    }
+    
+    int next = 0;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            const rcCompactCell& c = chf.cells[x + y * w];
+            rcCompactCell& lc = lchf->cells[x + y * w];
+            lc.index = next;
+            lc.count = 0;
+            for (int i = (int)c.index, ni = (int)(c.index + c.count); i < ni; ++i) {
+                if (spanLayers[i] != layer) continue;
+                
+                const rcCompactSpan& s = chf.spans[i];
+                rcCompactSpan& ls = lchf->spans[next];
+                ls = s;
+                ls.reg = 0;
+                for (int dir = 0; dir < 4; ++dir) {
+                    int con = RC_NOT_CONNECTED;
+                    if (rcGetCon(s, dir) != RC_NOT_CONNECTED) {
+                        const int ax = x + rcGetDirOffsetX(dir);
+                        const int ay = y + rcGetDirOffsetY(dir);
+                        const unsigned char other = spanLayers[(int)chf.cells[ax + ay * w].index + rcGetCon(s, dir)];
+                        if (other == layer)
+                            con = 0;
+                        else if (other != 0xff && portals)
+                            portals[x + y * w] |= (unsigned char)(1 << dir);
+                    }
+                    rcSetCon(ls, dir, con);
+                }
+                lchf->areas[next] = chf.areas[i];
+                lc.count = 1;
+                ++next;
+                break;
+            }
+        }
+    }
+    return lchf;
+}
+
+// Hash everything the Detour tile of one layer is built from: the layer's
+// spans and where it meets the other layers, the configuration and the
+// tile's place
+static TileDiskCacheKey hashTileLayer(const TileBuildParams& bp, int x, int y, int layer,
+                                      const rcCompactHeightfield& lchf, const unsigned char* portals)
+{
+    TileHasher hasher;
+    hasher.addValue(TILE_BUILD_REVISION);
+    hasher.addValue(DT_NAVMESH_VERSION);
+    hasher.addValue(x);
+    hasher.addValue(y);
+    hasher.addValue(layer);
+    hashBuildConfig(hasher, bp);
+    hasher.add(lchf.bmin, sizeof(lchf.bmin));
+    hasher.add(lchf.cells, sizeof(rcCompactCell) * lchf.width * lchf.height);
+    hasher.add(lchf.spans, sizeof(rcCompactSpan) * lchf.spanCount);
+    hasher.add(lchf.areas, lchf.spanCount);
+    hasher.add(portals, lchf.width * lchf.height);
+    return hasher.finish();
+}
+
+// The layer hash kept in a tile header's userId; never 0, which stands for no layer
+static inline unsigned int layerFingerprint(const TileDiskCacheKey& key)
+{
+    const unsigned int id = (unsigned int)key.h[0];
+    return id ? id : 1;
+}
+
+// Replace chf (which this frees) with the spans of one of its layers.
+// Returns null if the tile has no such layer.
+static rcCompactHeightfield* isolateTileLayer(rcContext* ctx, const rcConfig& tileCfg,
+                                              rcCompactHeightfield* chf, int layer)
+{
+    rcHeightfieldLayerSet* lset = rcAllocHeightfieldLayerSet();
+    unsigned char* spanLayers = (unsigned char*)rcAlloc(rcMax(chf->spanCount, 1), RC_ALLOC_TEMP);
+    
+    rcCompactHeightfield* lchf = nullptr;
+    if (lset && spanLayers && splitTileLayers(ctx, tileCfg, *chf, *lset, spanLayers) &&
+        layer >= 0 && layer < rcMin(lset->nlayers, MAX_TILE_LAYERS))
+        lchf = extractTileLayer(*chf, spanLayers, layer, nullptr);
+    
+    rcFree(spanLayers);
+    rcFreeHeightfieldLayerSet(lset);
+    rcFreeCompactHeightfield(chf);
+    return lchf;
+}
+
+// Build tile (x, y) as one Detour tile per layer, each with the fingerprint of
+// its input as userId. A layer whose fingerprint matches currentLayers (when
+// given) keeps the navmesh's tile and is only marked in column.keptLayers;
+// the others come from the disk cache when they are there, or are built.
+static void buildTileLayerMeshes(const TileBuildParams& bp, int x, int y,
+                                 const unsigned int* currentLayers,
+                                 TileColumn& column, rcContext* ctx,
+                                 BindingTileStats* stats)
+{
+    rcScopedTimer totalTimer(ctx, RC_TIMER_TOTAL);
+    
+    const float tcs = bp.tileConfig->tileSize * bp.cfg->cs;
+    float bmin[3], bmax[3];
+    calcTileBounds(bp.cfg, tcs, x, y, bmin, bmax);
+    
+    rcConfig tileCfg;
+    calcTileConfig(bp.cfg, bp.tileConfig, bmin, bmax, tileCfg);
+    
+    rcCompactHeightfield* chf = buildTileCompactHeightfield(ctx, tileCfg, bp.flags,
+                                                            bp.verts, bp.nverts, bp.tris, bp.ntris,
+                                                            bp.chunkyMesh, bp.areas, bp.numAreas,
+                                                            x, y, stats);
+    if (!chf) return;
+    
+    rcHeightfieldLayerSet* lset = rcAllocHeightfieldLayerSet();
+    unsigned char* spanLayers = (unsigned char*)rcAlloc(rcMax(chf->spanCount, 1), RC_ALLOC_TEMP);
+    unsigned char* portals = (unsigned char*)rcAlloc(chf->width * chf->height, RC_ALLOC_TEMP);
+    if (!lset || !spanLayers || !portals || !splitTileLayers(ctx, tileCfg, *chf, *lset, spanLayers)) {
+        rcFree(portals);
+        rcFree(spanLayers);
+        rcFreeHeightfieldLayerSet(lset);
+        rcFreeCompactHeightfield(chf);
+        return;
+    }
+    
+    // Only the span layers are needed from here on
+    const int nlayers = rcMin(lset->nlayers, MAX_TILE_LAYERS);
+    rcFreeHeightfieldLayerSet(lset);
+    
+    const int regionThreads = resolveRegionThreads(bp);
+    int built = 0, loaded = 0;
+    for (int layer = 0; layer < nlayers; ++layer) {
+        rcCompactHeightfield* lchf = extractTileLayer(*chf, spanLayers, layer, portals);
+        if (!lchf) break;
+        
+        const TileDiskCacheKey key = hashTileLayer(bp, x, y, layer, *lchf, portals);
+        const unsigned int fingerprint = layerFingerprint(key);
+        if (currentLayers && currentLayers[layer] == fingerprint) {
+            rcFreeCompactHeightfield(lchf);
+            column.keptLayers |= 1u << layer;
+            if (stats) stats->reusedLayers++;
+            continue;
+        }
+        
+        TileData tile = { nullptr, 0 };
+        if (bp.cacheDir && tileDiskCacheLoad(bp.cacheDir, key, x, y, tile.data, tile.dataSize)) {
+            rcFreeCompactHeightfield(lchf);
+            loaded++;
+        } else {
+            BindingTileStats layerStats;
+            memset(&layerStats, 0, sizeof(layerStats));
+            tile.data = buildTileNavData(ctx, tileCfg, bp.flags, lchf, x, y, layer, portals,
+                                         bp.agentHeight, bp.agentRadius, bp.agentMaxClimb,
+                                         regionThreads, tile.dataSize, &layerStats);
+            if (tile.data) {
+                ((dtMeshHeader*)tile.data)->userId = fingerprint;
+                if (bp.cacheDir)
+                    tileDiskCacheStore(bp.cacheDir, key, tile.data, tile.dataSize);
+            }
+            if (stats) {
+                stats->regions += layerStats.regions;
+                stats->contours += layerStats.contours;
+                stats->polys += layerStats.polys;
+                stats->detailTris += layerStats.detailTris;
+            }
+            built++;
+        }
+        
+        if (tile.data) {
+            column.tiles.push_back(tile);
+            if (stats) stats->dataSize += tile.dataSize;
+        }
+    }
+    
+    if (stats && loaded > 0 && built == 0) stats->fromCache = 1;
+    
+    rcFree(portals);
+    rcFree(spanLayers);
+    rcFreeCompactHeightfield(chf);
+}
+
+// Build tile (x, y) with the given context, filling stats when given.
+// With BUILD_TILE_LAYERS it comes out as one tile per layer; see
+// buildTileLayerMeshes. Otherwise, with a cache directory the tile is loaded
+// from there when its input is unchanged, and stored there after building.
+static void buildTileAt(const TileBuildParams& bp, int x, int y,
+                        const unsigned int* currentLayers,
+                        TileColumn& column, rcContext* ctx,
+                        BindingTileStats* stats)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (stats) {
+        memset(stats, 0, sizeof(BindingTileStats));
+        stats->tx = x;
+        stats->ty = y;
+    }
+    column.tiles.clear();
+    column.keptLayers = 0;
+    
+    if (bp.flags & BUILD_TILE_LAYERS) {
+        buildTileLayerMeshes(bp, x, y, currentLayers, column, ctx, stats);
+        if (stats) {
+            stats->layers = (int)column.tiles.size() + stats->reusedLayers;
+            stats->buildTimeMs = elapsedMs(start);
+        }
+        return;
+    }
+    
+    TileData tile = { nullptr, 0 };
+    TileDiskCacheKey cacheKey;
+    if (bp.cacheDir) {
+        cacheKey = hashTileInput(bp, x, y);
+        if (tileDiskCacheLoad(bp.cacheDir, cacheKey, x, y, tile.data, tile.dataSize)) {
+            column.tiles.push_back(tile);
+            if (stats) {
+                stats->fromCache = 1;
+                stats->dataSize = tile.dataSize;
+                stats->layers = 1;
+                stats->buildTimeMs = elapsedMs(start);
+            }
+            return;
+        }
+    }
+    
+    const float tcs = bp.tileConfig->tileSize * bp.cfg->cs;
+    float tileBmin[3], tileBmax[3];
+    calcTileBounds(bp.cfg, tcs, x, y, tileBmin, tileBmax);
+    
+    tile.data = buildTileMesh(x, y, tileBmin, tileBmax, tile.dataSize,
+                              bp.cfg, bp.tileConfig, bp.flags,
+                              bp.verts, bp.nverts, bp.tris, bp.ntris, bp.chunkyMesh,
+                              bp.areas, bp.numAreas,
+                              bp.agentHeight, bp.agentRadius, bp.agentMaxClimb,
+                              resolveRegionThreads(bp), ctx, stats);
+    
+    // Empty tiles are not stored: a null result may also be a failed build
+    if (tile.data) {
+        column.tiles.push_back(tile);
+        if (bp.cacheDir)
+            tileDiskCacheStore(bp.cacheDir, cacheKey, tile.data, tile.dataSize);
+    }
+    
+    if (stats) {
+        stats->layers = (int)column.tiles.size();
+        stats->buildTimeMs = elapsedMs(start);
+    }
+}
+
+// Remove every tile at (x, y) but the layers set in keptLayers.
+// Returns the number of tiles removed.
+static int removeTilesAt(dtNavMesh* navMesh, int x, int y, unsigned int keptLayers)
+{
+    const dtMeshTile* tiles[256];
+    const int ntiles = ((const dtNavMesh*)navMesh)->getTilesAt(x, y, tiles, 256);
+    
+    int removed = 0;
+    for (int i = 0; i < ntiles; ++i) {
+        const int layer = tiles[i]->header->layer;
+        if (layer >= 0 && layer < MAX_TILE_LAYERS && (keptLayers & (1u << layer))) continue;
+        if (dtStatusSucceed(navMesh->removeTile(navMesh->getTileRef(tiles[i]), 0, 0)))
+            removed++;
+    }
+    return removed;
+}
+
+// Replace whatever sits at (x, y) with the column's tiles, which the navmesh
+// takes over, leaving only the layers the column keeps. Old tiles go even when
+// the column built empty, so rebuilds never leave stale polygons.
+// added receives the tiles added. Returns false (and frees the rest of the
+// column's data) if a tile could not be added.
+static bool replaceTiles(dtNavMesh* navMesh, int x, int y, const TileColumn& column, int& added)
+{
+    added = 0;
+    removeTilesAt(navMesh, x, y, column.keptLayers);
+    
+    bool ok = true;
+    for (size_t i = 0; i < column.tiles.size(); ++i) {
+        const TileData& tile = column.tiles[i];
+        if (ok && dtStatusSucceed(navMesh->addTile(tile.data, tile.dataSize, DT_TILE_FREE_DATA, 0, 0))) {
+            added++;
+        } else {
+            dtFree(tile.data);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// Replace every tile at (x, y) with data, which the navmesh takes over.
+// Returns false (and frees data) if the new tile could not be added.
+static bool replaceTile(dtNavMesh* navMesh, int x, int y, unsigned char* data, int dataSize)
+{
+    TileColumn column;
+    column.keptLayers = 0;
+    if (data) {
+        TileData tile = { data, dataSize };
+        column.tiles.push_back(tile);
+    }
+    int added = 0;
+    return replaceTiles(navMesh, x, y, column, added);
+}
+
+// Swap the freshly built tiles into the result's navmesh
+static void commitTile(BindingTileMeshResult* result, int x, int y, const TileColumn& column)
+{
+    int added = 0;
+    if (!replaceTiles(result->navMesh, x, y, column, added))
+        result->code = BCODE_ERR_ADD_TILE;
+    result->tilesBuilt += added;
+}
+
+// Resolve the requested thread count: 0 means one worker per hardware thread
+static int resolveBuildThreads(int requested, int numTiles)
+{
+    int n = requested;
+    if (n <= 0) {
+        n = (int)std::thread::hardware_concurrency();
+        if (n <= 0) n = 1;
+    }
+    return rcMax(1, rcMin(n, numTiles));
+}
+
+// Coordinates of the i-th tile of a build: entry i of tileCoords as (x, y)
+// pairs, or row-major over the whole grid when there is no list
+static inline void tileCoordAt(const TileBuildParams& bp, const int* tileCoords, int i,
+                               int& x, int& y)
+{
+    if (tileCoords) {
+        x = tileCoords[i * 2 + 0];
+        y = tileCoords[i * 2 + 1];
+    } else {
+        x = i % bp.tw;
+        y = i / bp.tw;
+    }
+}
+
+// Build the i-th tile of a build, at (x, y), serving its Recast allocations
+// from scratch when given one. The arena is reset as soon as the tile's
+// Detour data exists.
+static void buildTileWithScratch(const TileBuildParams& bp, int i, int x, int y,
+                                 TileColumn& column, rcContext* ctx,
+                                 BuildScratch* scratch, BindingTileStats* stats)
+{
+    const unsigned int* currentLayers = bp.currentLayers ? &bp.currentLayers[(size_t)i * MAX_TILE_LAYERS] : nullptr;
+    if (!scratch) {
+        buildTileAt(bp, x, y, currentLayers, column, ctx, stats);
+        return;
+    }
+    
+    BuildScratchScope scope(scratch);
+    buildTileAt(bp, x, y, currentLayers, column, ctx, stats);
+}
+
+// Stats slot of the i-th tile, if the result collects them
+static inline BindingTileStats* tileStatsAt(BindingTileMeshResult* result, int i)
+{
+    return result->stats.tileStats ? &result->stats.tileStats[i] : nullptr;
+}
+
+// Build tiles on the calling thread, in order
+static void buildTilesSerial(const TileBuildParams& bp, const int* tileCoords, int numTiles,
+                             BindingTileMeshResult* result)
+{
+    BuildContext ctx;
+    
+    // One tile has nothing to reuse, so it keeps plain malloc/free
+    BuildScratch scratch;
+    BuildScratch* tileScratch = numTiles > 1 ? &scratch : nullptr;
+    
+    TileColumn column;
+    for (int i = 0; i < numTiles; ++i) {
+        int x, y;
+        tileCoordAt(bp, tileCoords, i, x, y);
+        
+        buildTileWithScratch(bp, i, x, y, column, &ctx, tileScratch, tileStatsAt(result, i));
+        commitTile(result, x, y, column);
+    }
+    
+    ctx.addAccumulatedMs(result->stats.timerMs);
+}
+
+// Build tiles on a pool of workers, each with its own context and scratch arena.
+// Tiles are claimed in order and committed to the navmesh by the calling
+// thread in that same order, so tile refs and the exported data are
+// identical to a serial build. dtNavMesh is only ever touched by this thread.
+static void buildTilesParallel(const TileBuildParams& bp, const int* tileCoords, int numTiles,
+                               BindingTileMeshResult* result, int numThreads)
+{
+    std::vector<TileColumn> outputs(numTiles);
+    for (int i = 0; i < numTiles; ++i) {
+        outputs[i].keptLayers = 0;
+        outputs[i].done = false;
+    }
+    
+    std::atomic<int> nextTile(0);
+    std::mutex mutex;
+    std::condition_variable tileDone;
+    
+    auto worker = [&]() {
+        BuildContext ctx;
+        BuildScratch scratch;
+        TileColumn column;
+        for (;;) {
+            const int i = nextTile.fetch_add(1);
+            if (i >= numTiles) break;
+            
+            int x, y;
+            tileCoordAt(bp, tileCoords, i, x, y);
+            
+            buildTileWithScratch(bp, i, x, y, column, &ctx, &scratch, tileStatsAt(result, i));
+            
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                outputs[i].tiles.swap(column.tiles);
+                outputs[i].keptLayers = column.keptLayers;
+                outputs[i].done = true;
+            }
+            tileDone.notify_all();
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        ctx.addAccumulatedMs(result->stats.timerMs);
+    };
+    
+    std::vector<std::thread> workers;
+    workers.reserve(numThreads);
+    for (int i = 0; i < numThreads; ++i)
+        workers.emplace_back(worker);
+    
+    // Serialize addTile in tile order while workers keep building
+    TileColumn column;
+    for (int i = 0; i < numTiles; ++i) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            tileDone.wait(lock, [&]() { return outputs[i].done; });
+            column.tiles.swap(outputs[i].tiles);
+            column.keptLayers = outputs[i].keptLayers;
+        }
+        int x, y;
+        tileCoordAt(bp, tileCoords, i, x, y);
+        commitTile(result, x, y, column);
+    }
+    
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+}
+
+// Record the userId of every layer the navmesh holds for the tiles to build
+static void collectCurrentLayers(const dtNavMesh* navMesh, const TileBuildParams& bp,
+                                 const int* tileCoords, int numTiles,
+                                 std::vector<unsigned int>& currentLayers)
+{
+    currentLayers.assign((size_t)numTiles * MAX_TILE_LAYERS, 0);
+    
+    const dtMeshTile* tiles[MAX_TILE_LAYERS];
+    for (int i = 0; i < numTiles; ++i) {
+        int x, y;
+        tileCoordAt(bp, tileCoords, i, x, y);
+        const int ntiles = navMesh->getTilesAt(x, y, tiles, MAX_TILE_LAYERS);
+        for (int j = 0; j < ntiles; ++j) {
+            const dtMeshHeader* header = tiles[j]->header;
+            if (header->layer >= 0 && header->layer < MAX_TILE_LAYERS)
+                currentLayers[(size_t)i * MAX_TILE_LAYERS + header->layer] = header->userId;
+        }
+    }
+}
+
+// Build the listed tiles (or the whole grid) on as many threads as configured.
+// Stage timings add up into result->stats; per-tile stats are kept if they
+// can be allocated. Layered rebuilds of listed tiles keep the layers that
+// come out the same as the navmesh's.
+static void buildTiles(const TileBuildParams& bp, const int* tileCoords, int numTiles,
+                       BindingTileMeshResult* result)
+{
+    if (numTiles > 0) {
+        result->stats.tileStats = (BindingTileStats*)calloc(numTiles, sizeof(BindingTileStats));
+        result->stats.numTileStats = result->stats.tileStats ? numTiles : 0;
+    }
+    
+    TileBuildParams tileParams = bp;
+    std::vector<unsigned int> currentLayers;
+    if ((bp.flags & BUILD_TILE_LAYERS) && tileCoords && numTiles > 0) {
+        collectCurrentLayers(result->navMesh, bp, tileCoords, numTiles, currentLayers);
+        tileParams.currentLayers = &currentLayers[0];
+    }
+    
+    const int numThreads = resolveBuildThreads(bp.tileConfig->numThreads, numTiles);
+    if (numThreads > 1)
+        buildTilesParallel(tileParams, tileCoords, numTiles, result, numThreads);
+    else
+        buildTilesSerial(tileParams, tileCoords, numTiles, result);
+}
+
+// Allocate an empty navmesh sized for a tw x th tile grid, with room for
+// EXPECTED_TILE_LAYERS layers per tile when layered. On failure the navmesh
+// that could be allocated, if any, is still returned through navMesh.
+static BCodeStatus createTiledNavMesh(const rcConfig* config, const TileConfig* tileConfig,
+                                      int tw, int th, bool layered, dtNavMesh*& navMesh)
+{
+    // Calculate max tiles and polys per tile
+    const int layers = layered ? EXPECTED_TILE_LAYERS : 1;
+    int tileBits = rcMin((int)ilog2(nextPow2(tw * th * layers)), 14);
+    if (tileBits > 14) tileBits = 14;
+    int polyBits = 22 - tileBits;
+    int maxTiles = 1 << tileBits;
+    int maxPolysPerTile = 1 << polyBits;
+    
+    // Allocate navmesh
+    navMesh = dtAllocNavMesh();
+    if (!navMesh) return BCODE_ERR_MEMORY;
+    
+    // Initialize navmesh
+    dtNavMeshParams params;
+    rcVcopy(params.orig, config->bmin);
+    params.tileWidth = tileConfig->tileSize * config->cs;
+    params.tileHeight = tileConfig->tileSize * config->cs;
+    params.maxTiles = maxTiles;
+    params.maxPolys = maxPolysPerTile;
+    
+    dtStatus status = navMesh->init(&params);
+    if (dtStatusFailed(status)) return BCODE_ERR_INIT_TILE_NAVMESH;
+    
+    return BCODE_OK;
+}
+
+// Allocate the result and a navmesh sized for a tw x th tile grid built with flags
+static BindingTileMeshResult* createTiledResult(const rcConfig* config,
+                                                const TileConfig* tileConfig,
+                                                int flags, int tw, int th)
+{
+    BindingTileMeshResult* result = (BindingTileMeshResult*)calloc(1, sizeof(BindingTileMeshResult));
+    if (!result) return nullptr;
+    
+    result->code = BCODE_ERR_UNKNOWN;
+    result->navMesh = nullptr;
+    result->tilesBuilt = 0;
+    result->totalTiles = tw * th;
+    
+    const BCodeStatus status = createTiledNavMesh(config, tileConfig, tw, th,
+                                                  (flags & BUILD_TILE_LAYERS) != 0, result->navMesh);
+    if (status != BCODE_OK)
+        result->code = status;
+    
     return result;
 }
 
-// New wrapper for the updated API
-struct BindingTileMeshResult* bindingBuildTiledNavMeshWithAreas(
-    rcConfig* config,
-    const TileConfig* tileConfig,
-    int flags,
-    const float* verts,
-    int numVerts,
-    const int* tris,
-    int numTris,
-    const float** areaVerts,
-    const int* areaVertCounts,
-    const int** areaTris,
-    const int* areaTriCounts,
-    const unsigned char* areaCodes,
-    int numAreaMeshes,
-    float agentHeight,
-    float agentRadius,
-    float agentMaxClimb)
+// Main tiled navmesh building function - updated to use raw geometry
+static struct BindingTileMeshResult* buildTiledNavMeshImpl(
+    rcConfig* config,
+    const TileConfig* tileConfig,
+    int flags,
+    const float* verts,
+    int numVerts,
+    const int* tris,
+    int numTris,
+    const float** areaVerts,      // Array of vertex arrays
+    const int* areaVertCounts,    // Number of vertices for each area
+    const int** areaTris,         // Array of triangle arrays
+    const int* areaTriCounts,     // Number of triangles for each area
+    const unsigned char* areaCodes,
+    int numAreaMeshes,
+    float agentHeight,
+    float agentRadius,
+    float agentMaxClimb)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+    int tw = 0, th = 0;
+    calcTileGrid(config, tileConfig->tileSize, tw, th);
+    
+    BindingTileMeshResult* result = createTiledResult(config, tileConfig, flags, tw, th);
+    if (!result || result->code != BCODE_ERR_UNKNOWN) return result;
+    
+    // Index the input geometry so each tile only rasterizes what overlaps it.
+    // A single-tile build touches everything anyway, so skip the index there.
+    const bool indexTriangles = tw * th > 1;
+    AreaMarkingData* areas = createAreaMarkingData(config, indexTriangles,
+                                                   areaVerts, areaVertCounts,
+                                                   areaTris, areaTriCounts,
+                                                   areaCodes, numAreaMeshes);
+    rcChunkyTriMesh* chunkyMesh = indexTriangles ? createChunkyMesh(verts, tris, numTris) : nullptr;
+    
+    TileBuildParams bp;
+    bp.cfg = config;
+    bp.tileConfig = tileConfig;
+    bp.flags = flags;
+    bp.verts = verts;
+    bp.nverts = numVerts;
+    bp.tris = tris;
+    bp.ntris = numTris;
+    bp.chunkyMesh = chunkyMesh;
+    bp.areas = areas;
+    bp.numAreas = areas ? numAreaMeshes : 0;
+    bp.agentHeight = agentHeight;
+    bp.agentRadius = agentRadius;
+    bp.agentMaxClimb = agentMaxClimb;
+    bp.tw = tw;
+    bp.th = th;
+    bp.cacheDir = nullptr;
+    bp.currentLayers = nullptr;
+    
+    // Build all tiles
+    buildTiles(bp, nullptr, tw * th, result);
+    
+    releaseAreaMarkingData(areas, bp.numAreas);
+    delete chunkyMesh;
+    
+    result->code = (result->tilesBuilt > 0) ? BCODE_OK : BCODE_ERR_BUILD_TILE;
+    result->stats.totalTimeMs = elapsedMs(start);
+    return result;
+}
+
+// New wrapper for the updated API
+struct BindingTileMeshResult* bindingBuildTiledNavMeshWithAreas(
+    rcConfig* config,
+    const TileConfig* tileConfig,
+    int flags,
+    const float* verts,
+    int numVerts,
+    const int* tris,
+    int numTris,
+    const float** areaVerts,
+    const int* areaVertCounts,
+    const int** areaTris,
+    const int* areaTriCounts,
+    const unsigned char* areaCodes,
+    int numAreaMeshes,
+    float agentHeight,
+    float agentRadius,
+    float agentMaxClimb)
+{
+    return buildTiledNavMeshImpl(config, tileConfig, flags,
+                                   verts, numVerts, tris, numTris,
+                                   areaVerts, areaVertCounts,
+                                   areaTris, areaTriCounts,
+                                   areaCodes, numAreaMeshes,
+                                   agentHeight, agentRadius, agentMaxClimb);
+}
+
+// Keep the old API for backward compatibility
+struct BindingTileMeshResult* bindingBuildTiledNavMesh(
+    rcConfig* config,
+    const TileConfig* tileConfig,
+    int flags,
+    const float* verts,
+    int numVerts,
+    const int* tris,
+    int numTris,
+    const rcPolyMesh** areaMeshes,     // Deprecated
+    const unsigned char* areaCodes,     // Deprecated
+    int numAreaMeshes,                  // Deprecated
+    float agentHeight,
+    float agentRadius,
+    float agentMaxClimb)
+{
+    // Call the new version without areas
+    return buildTiledNavMeshImpl(config, tileConfig, flags,
+                                   verts, numVerts, tris, numTris,
+                                   nullptr, nullptr, nullptr, nullptr,
+                                   nullptr, 0,
+                                   agentHeight, agentRadius, agentMaxClimb);
+}
+
+// ================================================
+//       Input geometry cleanup
+// ================================================
+
+int bindingCleanGeometry(const float* verts, int nverts, const int32_t* tris, int ntris,
+                         float weldTolerance, int removeDuplicates, float walkableSlopeAngle,
+                         BindingCleanGeometry* result)
+{
+    if (!result) return 0;
+    memset(result, 0, sizeof(BindingCleanGeometry));
+    if ((!verts && nverts > 0) || (!tris && ntris > 0) || nverts < 0 || ntris < 0) return 0;
+    
+    GeometryCleanupSettings settings;
+    settings.weldTolerance = weldTolerance;
+    settings.removeDuplicates = removeDuplicates != 0;
+    settings.walkableSlopeAngle = walkableSlopeAngle;
+    
+    std::vector<float> outVerts;
+    std::vector<int32_t> outTris;
+    GeometryCleanupStats stats;
+    try {
+        cleanupGeometry(verts, nverts, tris, ntris, settings, outVerts, outTris, stats);
+    } catch (const std::bad_alloc&) {
+        return 0;
+    }
+    
+    result->vertices = (float*)malloc(rcMax((size_t)1, outVerts.size() * sizeof(float)));
+    result->triangles = (int32_t*)malloc(rcMax((size_t)1, outTris.size() * sizeof(int32_t)));
+    if (!result->vertices || !result->triangles) {
+        bindingReleaseCleanGeometry(result);
+        return 0;
+    }
+    if (!outVerts.empty()) memcpy(result->vertices, outVerts.data(), outVerts.size() * sizeof(float));
+    if (!outTris.empty()) memcpy(result->triangles, outTris.data(), outTris.size() * sizeof(int32_t));
+    result->vertexCount = (int)(outVerts.size() / 3);
+    result->triangleCount = (int)(outTris.size() / 3);
+    
+    BindingGeometryCleanupStats& s = result->stats;
+    s.inputVertices = nverts;
+    s.inputTriangles = ntris;
+    s.outputVertices = result->vertexCount;
+    s.outputTriangles = result->triangleCount;
+    s.weldedVertices = stats.weldedVertices;
+    s.unusedVertices = stats.unusedVertices;
+    s.degenerateTriangles = stats.degenerateTriangles;
+    s.duplicateTriangles = stats.duplicateTriangles;
+    s.steepTriangles = stats.steepTriangles;
+    return 1;
+}
+
+void bindingReleaseCleanGeometry(BindingCleanGeometry* result)
+{
+    if (!result) return;
+    free(result->vertices);
+    free(result->triangles);
+    memset(result, 0, sizeof(BindingCleanGeometry));
+}
+
+// ================================================
+//       Retained input for incremental rebuilds
+// ================================================
+
+struct BindingTileBuildInput {
+    rcConfig config;
+    TileConfig tileConfig;
+    int flags;
+    float agentHeight;
+    float agentRadius;
+    float agentMaxClimb;
+    int tw;
+    int th;
+    
+    // Owned copies of the geometry, so tiles can be rebuilt at any time
+    std::vector<float> verts;
+    std::vector<int> tris;
+    std::vector<std::vector<float> > areaVerts;
+    std::vector<std::vector<int> > areaTris;
+    std::vector<unsigned char> areaCodes;
+    
+    // Indices derived from the copies above
+    rcChunkyTriMesh* chunkyMesh;
+    AreaMarkingData* areas;
+    int numAreas;
+    
+    std::string cacheDir;   // Empty when the tile cache is off
+};
+
+static void fillBuildParams(BindingTileBuildInput* input, TileBuildParams& bp)
+{
+    bp.cfg = &input->config;
+    bp.tileConfig = &input->tileConfig;
+    bp.flags = input->flags;
+    bp.verts = input->verts.empty() ? nullptr : &input->verts[0];
+    bp.nverts = (int)(input->verts.size() / 3);
+    bp.tris = input->tris.empty() ? nullptr : &input->tris[0];
+    bp.ntris = (int)(input->tris.size() / 3);
+    bp.chunkyMesh = input->chunkyMesh;
+    bp.areas = input->areas;
+    bp.numAreas = input->numAreas;
+    bp.agentHeight = input->agentHeight;
+    bp.agentRadius = input->agentRadius;
+    bp.agentMaxClimb = input->agentMaxClimb;
+    bp.tw = input->tw;
+    bp.th = input->th;
+    bp.cacheDir = input->cacheDir.empty() ? nullptr : input->cacheDir.c_str();
+    bp.currentLayers = nullptr;
+}
+
+BindingTileBuildInput* bindingCreateTileBuildInput(
+    const rcConfig* config,
+    const TileConfig* tileConfig,
+    int flags,
+    const float* verts,
+    int numVerts,
+    const int* tris,
+    int numTris,
+    const float** areaVerts,
+    const int* areaVertCounts,
+    const int** areaTris,
+    const int* areaTriCounts,
+    const unsigned char* areaCodes,
+    int numAreaMeshes,
+    float agentHeight,
+    float agentRadius,
+    float agentMaxClimb)
+{
+    if (!config || !tileConfig || tileConfig->tileSize <= 0) return nullptr;
+    
+    BindingTileBuildInput* input = new BindingTileBuildInput;
+    input->config = *config;
+    input->tileConfig = *tileConfig;
+    input->flags = flags;
+    input->agentHeight = agentHeight;
+    input->agentRadius = agentRadius;
+    input->agentMaxClimb = agentMaxClimb;
+    calcTileGrid(config, tileConfig->tileSize, input->tw, input->th);
+    input->chunkyMesh = nullptr;
+    input->areas = nullptr;
+    input->numAreas = 0;
+    
+    if (bindingUpdateTileBuildGeometry(input, verts, numVerts, tris, numTris) != BCODE_OK ||
+        bindingUpdateTileBuildAreas(input, areaVerts, areaVertCounts, areaTris, areaTriCounts,
+                                    areaCodes, numAreaMeshes) != BCODE_OK) {
+        bindingReleaseTileBuildInput(input);
+        return nullptr;
+    }
+    return input;
+}
+
+void bindingReleaseTileBuildInput(BindingTileBuildInput* input)
+{
+    if (!input) return;
+    releaseAreaMarkingData(input->areas, input->numAreas);
+    delete input->chunkyMesh;
+    delete input;
+}
+
+BCodeStatus bindingUpdateTileBuildGeometry(BindingTileBuildInput* input,
+                                           const float* verts, int numVerts,
+                                           const int* tris, int numTris)
+{
+    if (!input || numVerts < 0 || numTris < 0) return BCODE_ERR_UNKNOWN;
+    
+    delete input->chunkyMesh;
+    input->chunkyMesh = nullptr;
+    
+    input->verts.assign(verts, verts + (verts ? numVerts * 3 : 0));
+    input->tris.assign(tris, tris + (tris ? numTris * 3 : 0));
+    
+    // Rebuilds typically touch a handful of tiles, so the index pays off
+    // whenever the grid has more than one.
+    if (input->tw * input->th > 1 && !input->tris.empty()) {
+        input->chunkyMesh = createChunkyMesh(&input->verts[0], &input->tris[0],
+                                             (int)(input->tris.size() / 3));
+        if (!input->chunkyMesh) return BCODE_ERR_MEMORY;
+    }
+    return BCODE_OK;
+}
+
+BCodeStatus bindingUpdateTileBuildAreas(BindingTileBuildInput* input,
+                                        const float** areaVerts,
+                                        const int* areaVertCounts,
+                                        const int** areaTris,
+                                        const int* areaTriCounts,
+                                        const unsigned char* areaCodes,
+                                        int numAreaMeshes)
+{
+    if (!input) return BCODE_ERR_UNKNOWN;
+    
+    releaseAreaMarkingData(input->areas, input->numAreas);
+    input->areas = nullptr;
+    input->numAreas = 0;
+    input->areaVerts.clear();
+    input->areaTris.clear();
+    input->areaCodes.clear();
+    
+    if (numAreaMeshes <= 0 || !areaVerts || !areaTris || !areaCodes) return BCODE_OK;
+    
+    input->areaVerts.resize(numAreaMeshes);
+    input->areaTris.resize(numAreaMeshes);
+    input->areaCodes.assign(areaCodes, areaCodes + numAreaMeshes);
+    
+    std::vector<const float*> vptrs(numAreaMeshes);
+    std::vector<const int*> tptrs(numAreaMeshes);
+    for (int i = 0; i < numAreaMeshes; ++i) {
+        if (areaVerts[i])
+            input->areaVerts[i].assign(areaVerts[i], areaVerts[i] + areaVertCounts[i] * 3);
+        if (areaTris[i])
+            input->areaTris[i].assign(areaTris[i], areaTris[i] + areaTriCounts[i] * 3);
+        vptrs[i] = input->areaVerts[i].empty() ? nullptr : &input->areaVerts[i][0];
+        tptrs[i] = input->areaTris[i].empty() ? nullptr : &input->areaTris[i][0];
+    }
+    
+    input->areas = createAreaMarkingData(&input->config, input->tw * input->th > 1,
+                                         &vptrs[0], areaVertCounts,
+                                         &tptrs[0], areaTriCounts,
+                                         &input->areaCodes[0], numAreaMeshes);
+    input->numAreas = input->areas ? numAreaMeshes : 0;
+    return BCODE_OK;
+}
+
+struct BindingTileMeshResult* bindingBuildTiledNavMeshFromInput(BindingTileBuildInput* input)
+{
+    if (!input) return nullptr;
+    
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+    BindingTileMeshResult* result = createTiledResult(&input->config, &input->tileConfig,
+                                                      input->flags, input->tw, input->th);
+    if (!result || result->code != BCODE_ERR_UNKNOWN) return result;
+    
+    TileBuildParams bp;
+    fillBuildParams(input, bp);
+    buildTiles(bp, nullptr, input->tw * input->th, result);
+    
+    result->code = (result->tilesBuilt > 0) ? BCODE_OK : BCODE_ERR_BUILD_TILE;
+    result->stats.totalTimeMs = elapsedMs(start);
+    return result;
+}
+
+int bindingGetTileRangeInBounds(const BindingTileBuildInput* input,
+                                const float* bmin, const float* bmax,
+                                int includeBorder,
+                                int* minx, int* miny, int* maxx, int* maxy)
+{
+    if (!input || !bmin || !bmax) return 0;
+    
+    const rcConfig& cfg = input->config;
+    const float tcs = input->tileConfig.tileSize * cfg.cs;
+    
+    // A tile rasterizes geometry up to borderSize cells past its edges, so an
+    // edit there changes the neighbour too.
+    const float pad = includeBorder ? cfg.borderSize * cfg.cs : 0.0f;
+    
+    const int x0 = (int)floorf((bmin[0] - pad - cfg.bmin[0]) / tcs);
+    const int y0 = (int)floorf((bmin[2] - pad - cfg.bmin[2]) / tcs);
+    const int x1 = (int)floorf((bmax[0] + pad - cfg.bmin[0]) / tcs);
+    const int y1 = (int)floorf((bmax[2] + pad - cfg.bmin[2]) / tcs);
+    
+    if (x1 < 0 || y1 < 0 || x0 >= input->tw || y0 >= input->th) return 0;
+    
+    *minx = rcMax(x0, 0);
+    *miny = rcMax(y0, 0);
+    *maxx = rcMin(x1, input->tw - 1);
+    *maxy = rcMin(y1, input->th - 1);
+    return 1;
+}
+
+BCodeStatus bindingRebuildTiles(BindingTileBuildInput* input, dtNavMesh* navMesh,
+                                const int* tileCoords, int numTiles, int* tilesBuilt,
+                                BindingBuildStats* stats)
+{
+    if (tilesBuilt) *tilesBuilt = 0;
+    if (stats) memset(stats, 0, sizeof(BindingBuildStats));
+    if (!input || !navMesh || !tileCoords || numTiles < 0) return BCODE_ERR_UNKNOWN;
+    
+    for (int i = 0; i < numTiles; ++i) {
+        const int x = tileCoords[i * 2 + 0];
+        const int y = tileCoords[i * 2 + 1];
+        if (x < 0 || y < 0 || x >= input->tw || y >= input->th) return BCODE_ERR_UNKNOWN;
+    }
+    
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+    TileBuildParams bp;
+    fillBuildParams(input, bp);
+    
+    // Commit through a result that borrows the caller's navmesh
+    BindingTileMeshResult result;
+    memset(&result, 0, sizeof(result));
+    result.code = BCODE_OK;
+    result.navMesh = navMesh;
+    result.tilesBuilt = 0;
+    result.totalTiles = numTiles;
+    
+    buildTiles(bp, tileCoords, numTiles, &result);
+    result.stats.totalTimeMs = elapsedMs(start);
+    
+    if (tilesBuilt) *tilesBuilt = result.tilesBuilt;
+    if (stats)
+        *stats = result.stats;
+    else
+        bindingReleaseBuildStats(&result.stats);
+    return result.code;
+}
+
+BDetourStatus bindingRemoveTile(dtNavMesh* navMesh, int tx, int ty)
+{
+    if (!navMesh) return BD_ERR_INVALID_PARAM;
+    
+    return removeTilesAt(navMesh, tx, ty, 0) > 0 ? BD_OK : BD_ERR_INVALID_PARAM;
+}
+
+void bindingSetTileCacheDirectory(BindingTileBuildInput* input, const char* dir)
+{
+    if (!input) return;
+    input->cacheDir = dir ? dir : "";
+}
+
+void bindingGetTileGridSize(const BindingTileBuildInput* input, int* tw, int* th)
+{
+    if (tw) *tw = input ? input->tw : 0;
+    if (th) *th = input ? input->th : 0;
+}
+
+void bindingSortTilesByDistance(const BindingTileBuildInput* input, const float* focus,
+                                int* tileCoords, int numTiles)
+{
+    if (!input || !focus || !tileCoords || numTiles <= 1) return;
+    
+    const rcConfig& cfg = input->config;
+    const float tcs = input->tileConfig.tileSize * cfg.cs;
+    
+    struct TileDist {
+        float d;
+        int x, y;
+        bool operator<(const TileDist& o) const { return d < o.d; }
+    };
+    std::vector<TileDist> order(numTiles);
+    for (int i = 0; i < numTiles; ++i) {
+        TileDist& t = order[i];
+        t.x = tileCoords[i * 2 + 0];
+        t.y = tileCoords[i * 2 + 1];
+        const float dx = cfg.bmin[0] + (t.x + 0.5f) * tcs - focus[0];
+        const float dz = cfg.bmin[2] + (t.y + 0.5f) * tcs - focus[2];
+        t.d = dx * dx + dz * dz;
+    }
+    
+    // Stable, so equidistant tiles keep the caller's order
+    std::stable_sort(order.begin(), order.end());
+    
+    for (int i = 0; i < numTiles; ++i) {
+        tileCoords[i * 2 + 0] = order[i].x;
+        tileCoords[i * 2 + 1] = order[i].y;
+    }
+}
+
+dtNavMesh* bindingCreateTiledNavMesh(const BindingTileBuildInput* input, BCodeStatus* code)
+{
+    if (!input) {
+        if (code) *code = BCODE_ERR_UNKNOWN;
+        return nullptr;
+    }
+    
+    dtNavMesh* navMesh = nullptr;
+    const BCodeStatus status = createTiledNavMesh(&input->config, &input->tileConfig,
+                                                  input->tw, input->th,
+                                                  (input->flags & BUILD_TILE_LAYERS) != 0, navMesh);
+    if (code) *code = status;
+    if (status != BCODE_OK) {
+        dtFreeNavMesh(navMesh);
+        return nullptr;
+    }
+    return navMesh;
+}
+
+unsigned char* bindingBuildTileData(BindingTileBuildInput* input, int tx, int ty,
+                                    int* dataSize, BindingTileStats* stats)
+{
+    if (dataSize) *dataSize = 0;
+    if (!input || tx < 0 || ty < 0 || tx >= input->tw || ty >= input->th) return nullptr;
+    
+    TileBuildParams bp;
+    fillBuildParams(input, bp);
+    bp.flags &= ~BUILD_TILE_LAYERS;
+    
+    BuildContext ctx;
+    TileColumn column;
+    buildTileAt(bp, tx, ty, nullptr, column, &ctx, stats);
+    if (column.tiles.empty()) return nullptr;
+    
+    if (dataSize) *dataSize = column.tiles[0].dataSize;
+    return column.tiles[0].data;
+}
+
+BCodeStatus bindingAddTileData(dtNavMesh* navMesh, unsigned char* data, int dataSize)
+{
+    if (!navMesh || !data || dataSize < (int)sizeof(dtMeshHeader)) {
+        dtFree(data);
+        return BCODE_ERR_UNKNOWN;
+    }
+    
+    const dtMeshHeader* header = (const dtMeshHeader*)data;
+    if (header->magic != DT_NAVMESH_MAGIC || header->version != DT_NAVMESH_VERSION) {
+        dtFree(data);
+        return BCODE_ERR_UNKNOWN;
+    }
+    
+    return replaceTile(navMesh, header->x, header->y, data, dataSize) ? BCODE_OK : BCODE_ERR_ADD_TILE;
+}
+
+void bindingFreeTileData(unsigned char* data)
+{
+    dtFree(data);
+}
+
+// ================================================
+//       Tile cache navmesh (dynamic obstacles)
+// ================================================
+
+// Serves the per-tile allocations of dtTileCache::buildNavMeshTile from an
+// arena; the tile cache resets its allocator before every tile.
+class ScratchTileCacheAlloc : public dtTileCacheAlloc
+{
+public:
+    virtual void reset() { m_scratch.reset(); }
+    virtual void* alloc(const size_t size) { return m_scratch.alloc(size); }
+    virtual void free(void* ptr) { m_scratch.free(ptr); }
+    
+private:
+    BuildScratch m_scratch;
+};
+
+// Gives tile cache polygons the same areas and flags as the regular build
+struct AreaFlagsMeshProcess : public dtTileCacheMeshProcess
+{
+    virtual void process(dtNavMeshCreateParams* params, unsigned char* polyAreas, unsigned short* polyFlags)
+    {
+        applyPolyAreaFlags(polyAreas, polyFlags, params->polyCount);
+    }
+};
+
+struct BindingTileCacheMesh {
+    dtTileCache* tileCache;
+    dtNavMesh* navMesh;
+    
+    // Referenced by tileCache, so they live as long as it does
+    LZTileCompressor compressor;
+    ScratchTileCacheAlloc talloc;
+    AreaFlagsMeshProcess meshProcess;
+    
+    BindingTileCacheStats stats;
+};
+
+struct CompressedLayer {
+    unsigned char* data;
+    int dataSize;
+};
+
+// Build the compressed heightfield layers of tile (x, y), appending them to
+// layers. They are the layers BUILD_TILE_LAYERS makes Detour tiles of, with
+// the same indices.
+static bool buildTileLayers(const TileBuildParams& bp, int x, int y,
+                            dtTileCacheCompressor* comp, rcContext* ctx,
+                            std::vector<CompressedLayer>& layers)
+{
+    const float tcs = bp.tileConfig->tileSize * bp.cfg->cs;
+    float bmin[3], bmax[3];
+    calcTileBounds(bp.cfg, tcs, x, y, bmin, bmax);
+    
+    rcConfig tileCfg;
+    calcTileConfig(bp.cfg, bp.tileConfig, bmin, bmax, tileCfg);
+    
+    rcCompactHeightfield* chf = buildTileCompactHeightfield(ctx, tileCfg, bp.flags,
+                                                            bp.verts, bp.nverts, bp.tris, bp.ntris,
+                                                            bp.chunkyMesh, bp.areas, bp.numAreas,
+                                                            x, y, nullptr);
+    if (!chf) return false;
+    
+    rcHeightfieldLayerSet* lset = rcAllocHeightfieldLayerSet();
+    if (!lset) {
+        rcFreeCompactHeightfield(chf);
+        return false;
+    }
+    
+    if (!splitTileLayers(ctx, tileCfg, *chf, *lset, nullptr)) {
+        rcFreeHeightfieldLayerSet(lset);
+        rcFreeCompactHeightfield(chf);
+        return false;
+    }
+    
+    rcFreeCompactHeightfield(chf);
+    
+    bool ok = true;
+    const int nlayers = rcMin(lset->nlayers, MAX_TILE_LAYERS);
+    for (int i = 0; i < nlayers; ++i) {
+        const rcHeightfieldLayer& layer = lset->layers[i];
+        
+        dtTileCacheLayerHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = DT_TILECACHE_MAGIC;
+        header.version = DT_TILECACHE_VERSION;
+        header.tx = x;
+        header.ty = y;
+        header.tlayer = i;
+        rcVcopy(header.bmin, layer.bmin);
+        rcVcopy(header.bmax, layer.bmax);
+        header.width = (unsigned char)layer.width;
+        header.height = (unsigned char)layer.height;
+        header.minx = (unsigned char)layer.minx;
+        header.maxx = (unsigned char)layer.maxx;
+        header.miny = (unsigned char)layer.miny;
+        header.maxy = (unsigned char)layer.maxy;
+        header.hmin = (unsigned short)layer.hmin;
+        header.hmax = (unsigned short)layer.hmax;
+        
+        CompressedLayer out;
+        out.data = nullptr;
+        out.dataSize = 0;
+        if (dtStatusFailed(dtBuildTileCacheLayer(comp, &header, layer.heights, layer.areas, layer.cons,
+                                                 &out.data, &out.dataSize))) {
+            ok = false;
+            break;
+        }
+        layers.push_back(out);
+    }
+    
+    rcFreeHeightfieldLayerSet(lset);
+    return ok;
+}
+
+// Build the layers of every tile, on worker threads when configured.
+// tileLayers[i] receives the layers of row-major tile i.
+static bool buildAllTileLayers(const TileBuildParams& bp, dtTileCacheCompressor* comp,
+                               std::vector<std::vector<CompressedLayer> >& tileLayers)
+{
+    const int numTiles = bp.tw * bp.th;
+    tileLayers.assign(numTiles, std::vector<CompressedLayer>());
+    
+    std::atomic<int> nextTile(0);
+    std::atomic<bool> failed(false);
+    
+    auto worker = [&]() {
+        BuildContext ctx;
+        BuildScratch scratch;
+        for (;;) {
+            const int i = nextTile.fetch_add(1);
+            if (i >= numTiles) break;
+            
+            BuildScratchScope scope(&scratch);
+            if (!buildTileLayers(bp, i % bp.tw, i / bp.tw, comp, &ctx, tileLayers[i]))
+                failed = true;
+        }
+    };
+    
+    const int numThreads = resolveBuildThreads(bp.tileConfig->numThreads, numTiles);
+    if (numThreads > 1) {
+        std::vector<std::thread> workers;
+        workers.reserve(numThreads);
+        for (int i = 0; i < numThreads; ++i)
+            workers.emplace_back(worker);
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+    } else {
+        worker();
+    }
+    
+    return !failed;
+}
+
+BindingTileCacheMesh* bindingCreateTileCacheMesh(BindingTileBuildInput* input, int maxObstacles,
+                                                 BCodeStatus* code)
+{
+    if (code) *code = BCODE_ERR_UNKNOWN;
+    if (!input || maxObstacles <= 0) return nullptr;
+    
+    // Layer dimensions are stored in a byte
+    const rcConfig& cfg = input->config;
+    if (input->tileConfig.tileSize + cfg.borderSize * 2 > 255) return nullptr;
+    
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+    BindingTileCacheMesh* mesh = new BindingTileCacheMesh;
+    memset(&mesh->stats, 0, sizeof(mesh->stats));
+    mesh->tileCache = dtAllocTileCache();
+    mesh->navMesh = dtAllocNavMesh();
+    if (!mesh->tileCache || !mesh->navMesh) {
+        if (code) *code = BCODE_ERR_MEMORY;
+        bindingReleaseTileCacheMesh(mesh);
+        return nullptr;
+    }
+    
+    const int numTiles = input->tw * input->th;
+    const int tileBits = rcMin((int)ilog2(nextPow2(numTiles * EXPECTED_TILE_LAYERS)), 14);
+    const int polyBits = 22 - tileBits;
+    
+    dtTileCacheParams tcparams;
+    memset(&tcparams, 0, sizeof(tcparams));
+    rcVcopy(tcparams.orig, cfg.bmin);
+    tcparams.cs = cfg.cs;
+    tcparams.ch = cfg.ch;
+    tcparams.width = input->tileConfig.tileSize;
+    tcparams.height = input->tileConfig.tileSize;
+    tcparams.walkableHeight = input->agentHeight;
+    tcparams.walkableRadius = input->agentRadius;
+    tcparams.walkableClimb = input->agentMaxClimb;
+    tcparams.maxSimplificationError = cfg.maxSimplificationError;
+    tcparams.maxTiles = numTiles * EXPECTED_TILE_LAYERS;
+    tcparams.maxObstacles = maxObstacles;
+    
+    dtNavMeshParams params;
+    memset(&params, 0, sizeof(params));
+    rcVcopy(params.orig, cfg.bmin);
+    params.tileWidth = input->tileConfig.tileSize * cfg.cs;
+    params.tileHeight = input->tileConfig.tileSize * cfg.cs;
+    params.maxTiles = 1 << tileBits;
+    params.maxPolys = 1 << polyBits;
+    
+    if (dtStatusFailed(mesh->tileCache->init(&tcparams, &mesh->talloc, &mesh->compressor, &mesh->meshProcess)) ||
+        dtStatusFailed(mesh->navMesh->init(&params))) {
+        if (code) *code = BCODE_ERR_INIT_TILE_NAVMESH;
+        bindingReleaseTileCacheMesh(mesh);
+        return nullptr;
+    }
+    
+    TileBuildParams bp;
+    fillBuildParams(input, bp);
+    
+    std::vector<std::vector<CompressedLayer> > tileLayers;
+    const bool layersOk = buildAllTileLayers(bp, &mesh->compressor, tileLayers);
+    
+    // Hand the layers to the tile cache in tile order; it frees them from here on
+    BCodeStatus status = layersOk ? BCODE_OK : BCODE_ERR_BUILD_TILE;
+    for (int i = 0; i < numTiles; ++i) {
+        for (size_t j = 0; j < tileLayers[i].size(); ++j) {
+            const CompressedLayer& layer = tileLayers[i][j];
+            if (status == BCODE_OK &&
+                dtStatusSucceed(mesh->tileCache->addTile(layer.data, layer.dataSize,
+                                                         DT_COMPRESSEDTILE_FREE_DATA, 0))) {
+                const dtTileCacheLayerHeader* header = (const dtTileCacheLayerHeader*)layer.data;
+                mesh->stats.layers++;
+                mesh->stats.compressedSize += layer.dataSize;
+                mesh->stats.uncompressedSize += (int)sizeof(dtTileCacheLayerHeader) +
+                                                header->width * header->height * 3;
+            } else {
+                dtFree(layer.data);
+                if (status == BCODE_OK) status = BCODE_ERR_ADD_TILE;
+            }
+        }
+    }
+    
+    if (status == BCODE_OK) {
+        for (int y = 0; y < input->th; ++y) {
+            for (int x = 0; x < input->tw; ++x) {
+                if (dtStatusFailed(mesh->tileCache->buildNavMeshTilesAt(x, y, mesh->navMesh)))
+                    status = BCODE_ERR_BUILD_TILE;
+            }
+        }
+    }
+    
+    if (status != BCODE_OK) {
+        if (code) *code = status;
+        bindingReleaseTileCacheMesh(mesh);
+        return nullptr;
+    }
+    
+    const dtNavMesh* navMesh = mesh->navMesh;
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (tile && tile->header) mesh->stats.tiles++;
+    }
+    mesh->stats.buildTimeMs = elapsedMs(start);
+    
+    if (code) *code = BCODE_OK;
+    return mesh;
+}
+
+void bindingReleaseTileCacheMesh(BindingTileCacheMesh* mesh)
+{
+    if (!mesh) return;
+    dtFreeTileCache(mesh->tileCache);
+    dtFreeNavMesh(mesh->navMesh);
+    delete mesh;
+}
+
+dtNavMesh* bindingTileCacheGetNavMesh(BindingTileCacheMesh* mesh)
+{
+    return mesh ? mesh->navMesh : nullptr;
+}
+
+void bindingTileCacheGetStats(const BindingTileCacheMesh* mesh, BindingTileCacheStats* stats)
+{
+    if (!mesh || !stats) return;
+    *stats = mesh->stats;
+}
+
+// Queue an obstacle through add. The tile cache takes a limited number of
+// requests between updates; when they run out, process the queue once and retry.
+template <class AddObstacle>
+static uint32_t addObstacle(BindingTileCacheMesh* mesh, AddObstacle add)
+{
+    if (!mesh) return 0;
+    
+    dtObstacleRef ref = 0;
+    dtStatus status = add(&ref);
+    if (dtStatusDetail(status, DT_BUFFER_TOO_SMALL)) {
+        mesh->tileCache->update(0, mesh->navMesh);
+        status = add(&ref);
+    }
+    return dtStatusSucceed(status) ? ref : 0;
+}
+
+uint32_t bindingTileCacheAddCylinderObstacle(BindingTileCacheMesh* mesh, const float* pos,
+                                             float radius, float height)
+{
+    if (!pos) return 0;
+    return addObstacle(mesh, [&](dtObstacleRef* ref) {
+        return mesh->tileCache->addObstacle(pos, radius, height, ref);
+    });
+}
+
+uint32_t bindingTileCacheAddBoxObstacle(BindingTileCacheMesh* mesh, const float* bmin, const float* bmax)
+{
+    if (!bmin || !bmax) return 0;
+    return addObstacle(mesh, [&](dtObstacleRef* ref) {
+        return mesh->tileCache->addBoxObstacle(bmin, bmax, ref);
+    });
+}
+
+uint32_t bindingTileCacheAddOrientedBoxObstacle(BindingTileCacheMesh* mesh, const float* center,
+                                                const float* halfExtents, float yRadians)
+{
+    if (!center || !halfExtents) return 0;
+    return addObstacle(mesh, [&](dtObstacleRef* ref) {
+        return mesh->tileCache->addBoxObstacle(center, halfExtents, yRadians, ref);
+    });
+}
+
+BDetourStatus bindingTileCacheRemoveObstacle(BindingTileCacheMesh* mesh, uint32_t ref)
+{
+    if (!mesh || !ref) return BD_ERR_INVALID_PARAM;
+    
+    dtStatus status = mesh->tileCache->removeObstacle(ref);
+    if (dtStatusDetail(status, DT_BUFFER_TOO_SMALL)) {
+        mesh->tileCache->update(0, mesh->navMesh);
+        status = mesh->tileCache->removeObstacle(ref);
+    }
+    return dtStatusFailed(status) ? BD_ERR_INVALID_PARAM : BD_OK;
+}
+
+BDetourStatus bindingTileCacheUpdate(BindingTileCacheMesh* mesh, int maxTileUpdates, int* upToDate)
+{
+    if (upToDate) *upToDate = 0;
+    if (!mesh) return BD_ERR_INVALID_PARAM;
+    
+    // Each dtTileCache::update call rebuilds at most one tile
+    bool done = false;
+    for (int steps = 0; !done; ++steps) {
+        if (maxTileUpdates > 0 && steps >= maxTileUpdates) break;
+        if (dtStatusFailed(mesh->tileCache->update(0, mesh->navMesh, &done)))
+            return BD_ERR_BUILD_NAVMESH;
+    }
+    
+    if (upToDate) *upToDate = done ? 1 : 0;
+    return BD_OK;
+}
+
+// ================================================
+//       Multi-agent builds from one rasterization
+// ================================================
+
+// Voxel walkable dimensions of an agent profile at the build's cell size
+static void applyAgentProfile(const BindingAgentProfile& profile, rcConfig& cfg)
+{
+    cfg.walkableHeight = (int)ceilf(profile.height / cfg.ch);
+    cfg.walkableClimb = (int)floorf(profile.maxClimb / cfg.ch);
+    cfg.walkableRadius = (int)ceilf(profile.radius / cfg.cs);
+}
+
+// Inputs of a multi-agent build shared by every tile
+struct MultiAgentBuildParams {
+    const TileBuildParams* bp;
+    const BindingAgentProfile* profiles;
+    int numProfiles;
+    rcConfig rasterCfg;     // Base config with the shared border and merge threshold
+};
+
+// Build tile (x, y) for every profile, rasterizing its geometry once.
+// data, dataSize and stats hold one entry per profile.
+static void buildMultiAgentTile(const MultiAgentBuildParams& mp, int x, int y, rcContext* ctx,
+                                unsigned char** data, int* dataSize, BindingTileStats* stats)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const TileBuildParams& bp = *mp.bp;
+    
+    for (int p = 0; p < mp.numProfiles; ++p) {
+        data[p] = nullptr;
+        dataSize[p] = 0;
+        memset(&stats[p], 0, sizeof(BindingTileStats));
+        stats[p].tx = x;
+        stats[p].ty = y;
+    }
+    
+    rcScopedTimer totalTimer(ctx, RC_TIMER_TOTAL);
+    
+    const float tcs = bp.tileConfig->tileSize * bp.cfg->cs;
+    float bmin[3], bmax[3];
+    calcTileBounds(bp.cfg, tcs, x, y, bmin, bmax);
+    
+    rcConfig rasterTileCfg;
+    calcTileConfig(&mp.rasterCfg, bp.tileConfig, bmin, bmax, rasterTileCfg);
+    
+    rcHeightfield* solid = rasterizeTileHeightfield(ctx, rasterTileCfg, bp.verts, bp.nverts,
+                                                    bp.tris, bp.ntris, bp.chunkyMesh,
+                                                    bp.areas, bp.numAreas);
+    if (!solid) return;
+    
+    rcPackedHeightfield packed;
+    const bool packedOk = rcPackHeightfield(ctx, *solid, packed);
+    rcFreeHeightfield(solid);
+    if (!packedOk) return;
+    const double rasterMs = elapsedMs(start);
+    
+    // The span structure is fixed after rasterization and the filters only
+    // clear areas, so restoring them is all each profile needs to start over.
+    unsigned char* rasterAreas = nullptr;
+    if (mp.numProfiles > 1) {
+        rasterAreas = (unsigned char*)rcAlloc(rcMax(packed.spanCount, 1), RC_ALLOC_TEMP);
+        if (!rasterAreas) return;
+        memcpy(rasterAreas, packed.areas, packed.spanCount);
+    }
+    
+    for (int p = 0; p < mp.numProfiles; ++p) {
+        const std::chrono::steady_clock::time_point profileStart = std::chrono::steady_clock::now();
+        if (p > 0) memcpy(packed.areas, rasterAreas, packed.spanCount);
+        
+        rcConfig tileCfg = rasterTileCfg;
+        applyAgentProfile(mp.profiles[p], tileCfg);
+        
+        rcCompactHeightfield* chf = compactTileHeightfield(ctx, tileCfg, bp.flags, packed,
+                                                           bp.areas, bp.numAreas, x, y, &stats[p]);
+        // Lazy detail meshes are rebuilt with the input's own agent, so every
+        // profile gets its detail mesh up front
+        if (chf) {
+            data[p] = buildTileNavData(ctx, tileCfg, bp.flags & ~BUILD_LAZY_DETAIL_MESH, chf, x, y, 0, nullptr,
+                                       mp.profiles[p].height, mp.profiles[p].radius,
+                                       mp.profiles[p].maxClimb, 1, dataSize[p], &stats[p]);
+        }
+        stats[p].buildTimeMs = rasterMs + elapsedMs(profileStart);
+    }
+    
+    rcFree(rasterAreas);
+}
+
+BindingMultiAgentResult* bindingBuildTiledNavMeshesForAgents(BindingTileBuildInput* input,
+                                                             const BindingAgentProfile* profiles,
+                                                             int numProfiles)
+{
+    if (!input || !profiles || numProfiles <= 0) return nullptr;
+    
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const int numTiles = input->tw * input->th;
+    
+    BindingMultiAgentResult* result = (BindingMultiAgentResult*)calloc(1, sizeof(BindingMultiAgentResult));
+    if (!result) return nullptr;
+    result->code = BCODE_ERR_UNKNOWN;
+    result->totalTiles = numTiles;
+    result->navMeshes = (dtNavMesh**)calloc(numProfiles, sizeof(dtNavMesh*));
+    result->tilesBuilt = (int*)calloc(numProfiles, sizeof(int));
+    result->stats.tileStats = (BindingTileStats*)calloc((size_t)numTiles * numProfiles, sizeof(BindingTileStats));
+    if (!result->navMeshes || !result->tilesBuilt || !result->stats.tileStats) {
+        result->code = BCODE_ERR_MEMORY;
+        return result;
+    }
+    result->numProfiles = numProfiles;
+    result->stats.numTileStats = numTiles * numProfiles;
+    
+    // Every profile's tiles are built whole, without BUILD_TILE_LAYERS
+    for (int p = 0; p < numProfiles; ++p) {
+        const BCodeStatus status = createTiledNavMesh(&input->config, &input->tileConfig,
+                                                      input->tw, input->th, false, result->navMeshes[p]);
+        if (status != BCODE_OK) {
+            result->code = status;
+            return result;
+        }
+    }
+    
+    TileBuildParams bp;
+    fillBuildParams(input, bp);
+    
+    // Rasterize with the widest border any profile needs and the lowest climb
+    // as span merge threshold; each profile then filters with its own values.
+    MultiAgentBuildParams mp;
+    mp.bp = &bp;
+    mp.profiles = profiles;
+    mp.numProfiles = numProfiles;
+    mp.rasterCfg = input->config;
+    for (int p = 0; p < numProfiles; ++p) {
+        rcConfig profileCfg = input->config;
+        applyAgentProfile(profiles[p], profileCfg);
+        const int borderSize = profileCfg.walkableRadius + 3;
+        if (p == 0 || borderSize > mp.rasterCfg.borderSize)
+            mp.rasterCfg.borderSize = borderSize;
+        if (p == 0 || profileCfg.walkableClimb < mp.rasterCfg.walkableClimb)
+            mp.rasterCfg.walkableClimb = profileCfg.walkableClimb;
+    }
+    
+    // Tile-major outputs, committed in tile order once all workers are done
+    std::vector<TileBuildOutput> outputs((size_t)numTiles * numProfiles);
+    std::vector<BindingTileStats> tileStats((size_t)numTiles * numProfiles);
+    std::atomic<int> nextTile(0);
+    std::mutex mutex;
+    
+    auto worker = [&]() {
+        BuildContext ctx;
+        BuildScratch scratch;
+        std::vector<unsigned char*> data(numProfiles);
+        std::vector<int> dataSize(numProfiles);
+        for (;;) {
+            const int i = nextTile.fetch_add(1);
+            if (i >= numTiles) break;
+            
+            {
+                BuildScratchScope scope(&scratch);
+                buildMultiAgentTile(mp, i % bp.tw, i / bp.tw, &ctx, &data[0], &dataSize[0],
+                                    &tileStats[(size_t)i * numProfiles]);
+            }
+            for (int p = 0; p < numProfiles; ++p) {
+                TileBuildOutput& out = outputs[(size_t)i * numProfiles + p];
+                out.data = data[p];
+                out.dataSize = dataSize[p];
+                out.done = true;
+            }
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        ctx.addAccumulatedMs(result->stats.timerMs);
+    };
+    
+    const int numThreads = resolveBuildThreads(bp.tileConfig->numThreads, numTiles);
+    if (numThreads > 1) {
+        std::vector<std::thread> workers;
+        workers.reserve(numThreads);
+        for (int i = 0; i < numThreads; ++i)
+            workers.emplace_back(worker);
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+    } else {
+        worker();
+    }
+    
+    BCodeStatus status = BCODE_OK;
+    for (int i = 0; i < numTiles; ++i) {
+        for (int p = 0; p < numProfiles; ++p) {
+            const TileBuildOutput& out = outputs[(size_t)i * numProfiles + p];
+            result->stats.tileStats[(size_t)p * numTiles + i] = tileStats[(size_t)i * numProfiles + p];
+            if (!replaceTile(result->navMeshes[p], i % bp.tw, i / bp.tw, out.data, out.dataSize))
+                status = BCODE_ERR_ADD_TILE;
+            else if (out.data)
+                result->tilesBuilt[p]++;
+        }
+    }
+    
+    for (int p = 0; p < numProfiles && status == BCODE_OK; ++p) {
+        if (result->tilesBuilt[p] == 0) status = BCODE_ERR_BUILD_TILE;
+    }
+    
+    result->code = status;
+    result->stats.totalTimeMs = elapsedMs(start);
+    return result;
+}
+
+dtNavMesh* bindingMultiAgentTakeNavMesh(BindingMultiAgentResult* result, int profile)
+{
+    if (!result || !result->navMeshes || profile < 0 || profile >= result->numProfiles) return nullptr;
+    dtNavMesh* navMesh = result->navMeshes[profile];
+    result->navMeshes[profile] = nullptr;
+    return navMesh;
+}
+
+void bindingReleaseMultiAgentResult(BindingMultiAgentResult* result)
+{
+    if (!result) return;
+    if (result->navMeshes) {
+        for (int p = 0; p < result->numProfiles; ++p)
+            dtFreeNavMesh(result->navMeshes[p]);
+    }
+    free(result->navMeshes);
+    free(result->tilesBuilt);
+    free(result->stats.tileStats);
+    free(result);
+}
+
+// ================================================
+//       Lazy detail meshes
+// ================================================
+
+// Detail mesh attached to one tile. The arrays share one dtAlloc block laid
+// out like the detail section of Detour tile data.
+struct LazyDetailTile {
+    dtTileRef ref;              // Tile this entry describes, 0 if none
+    unsigned int lastUse;       // Stamp of the latest sample, for eviction
+    dtPolyDetail* fanMeshes;    // The tile's own polygon fans, put back on eviction
+    float* fanVerts;
+    unsigned char* fanTris;
+    unsigned char* detail;      // Null if the rebuild did not match the tile
+    int detailSize;
+};
+
+struct BindingLazyDetail : public dtTileDetailProvider {
+    BindingTileBuildInput* input;
+    dtNavMesh* navMesh;
+    int maxCachedTiles;
+    unsigned int clock;
+    std::vector<LazyDetailTile> tiles;  // Indexed like the navmesh's tiles
+    BindingLazyDetailStats stats;
+    BuildContext ctx;
+    BuildScratch scratch;
+    
+    virtual void requireDetail(const dtMeshTile* tile);
+    
+    bool buildDetail(const dtMeshTile* tile, LazyDetailTile& entry);
+    void dropDetail(LazyDetailTile& entry, bool restore);
+    void evictOldest();
+};
+
+// Whether a rebuilt poly mesh is the one the tile was created from:
+// same polygons over the same vertices, in the same order
+static bool polyMeshMatchesTile(const rcPolyMesh& pmesh, const dtMeshTile* tile)
+{
+    const dtMeshHeader* header = tile->header;
+    if (pmesh.npolys != header->polyCount || pmesh.nverts != header->vertCount) return false;
+    
+    for (int i = 0; i < pmesh.nverts; ++i) {
+        const unsigned short* iv = &pmesh.verts[i * 3];
+        const float* v = &tile->verts[i * 3];
+        if (v[0] != pmesh.bmin[0] + iv[0] * pmesh.cs ||
+            v[1] != pmesh.bmin[1] + iv[1] * pmesh.ch ||
+            v[2] != pmesh.bmin[2] + iv[2] * pmesh.cs)
+            return false;
+    }
+    
+    for (int i = 0; i < pmesh.npolys; ++i) {
+        const dtPoly& poly = tile->polys[i];
+        const unsigned short* src = &pmesh.polys[i * 2 * pmesh.nvp];
+        int nv = 0;
+        while (nv < pmesh.nvp && src[nv] != RC_MESH_NULL_IDX) {
+            if (nv >= poly.vertCount || src[nv] != poly.verts[nv]) return false;
+            ++nv;
+        }
+        if (nv != poly.vertCount) return false;
+    }
+    return true;
+}
+
+// Rebuild the tile's detail mesh from the input and attach it.
+// Returns false if the tile cannot be rebuilt as it is.
+bool BindingLazyDetail::buildDetail(const dtMeshTile* tile, LazyDetailTile& entry)
+{
+    const int x = tile->header->x;
+    const int y = tile->header->y;
+    if (x < 0 || y < 0 || x >= input->tw || y >= input->th) return false;
+    
+    TileBuildParams bp;
+    fillBuildParams(input, bp);
+    
+    const float tcs = bp.tileConfig->tileSize * bp.cfg->cs;
+    float bmin[3], bmax[3];
+    calcTileBounds(bp.cfg, tcs, x, y, bmin, bmax);
+    rcConfig tileCfg;
+    calcTileConfig(bp.cfg, bp.tileConfig, bmin, bmax, tileCfg);
+    
+    BuildScratchScope scope(&scratch);
+    
+    rcCompactHeightfield* chf = buildTileCompactHeightfield(&ctx, tileCfg, bp.flags,
+                                                            bp.verts, bp.nverts, bp.tris, bp.ntris,
+                                                            bp.chunkyMesh, bp.areas, bp.numAreas,
+                                                            x, y, nullptr);
+    if (chf && (bp.flags & BUILD_TILE_LAYERS))
+        chf = isolateTileLayer(&ctx, tileCfg, chf, tile->header->layer);
+    if (!chf) return false;
+    
+    rcPolyMesh* pmesh = nullptr;
+    rcPolyMeshDetail* dmesh = nullptr;
+    if (!buildTilePolyMeshes(&ctx, tileCfg, bp.flags, chf, 1, true, pmesh, dmesh, nullptr))
+        return false;
+    
+    if (!polyMeshMatchesTile(*pmesh, tile)) {
+        rcFreePolyMesh(pmesh);
+        rcFreePolyMeshDetail(dmesh);
+        return false;
+    }
+    
+    // Pack the detail mesh the way dtCreateNavMeshData does: the polygon's own
+    // vertices are not repeated in the detail vertices
+    int uniqueVerts = 0;
+    for (int i = 0; i < pmesh->npolys; ++i)
+        uniqueVerts += (int)dmesh->meshes[i * 4 + 1] - tile->polys[i].vertCount;
+    
+    const int meshesSize = dtAlign4((int)sizeof(dtPolyDetail) * pmesh->npolys);
+    const int vertsSize = dtAlign4((int)sizeof(float) * 3 * uniqueVerts);
+    const int trisSize = dtAlign4(4 * dmesh->ntris);
+    const int size = meshesSize + vertsSize + trisSize;
+    
+    unsigned char* block = (unsigned char*)dtAlloc(size, DT_ALLOC_PERM);
+    if (!block) {
+        rcFreePolyMesh(pmesh);
+        rcFreePolyMeshDetail(dmesh);
+        return false;
+    }
+    
+    dtPolyDetail* meshes = (dtPolyDetail*)block;
+    float* verts = (float*)(block + meshesSize);
+    unsigned char* tris = block + meshesSize + vertsSize;
+    
+    unsigned int vbase = 0;
+    for (int i = 0; i < pmesh->npolys; ++i) {
+        const int vb = (int)dmesh->meshes[i * 4 + 0];
+        const int ndv = (int)dmesh->meshes[i * 4 + 1];
+        const int nv = tile->polys[i].vertCount;
+        dtPolyDetail& dtl = meshes[i];
+        dtl.vertBase = vbase;
+        dtl.vertCount = (unsigned char)(ndv - nv);
+        dtl.triBase = dmesh->meshes[i * 4 + 2];
+        dtl.triCount = (unsigned char)dmesh->meshes[i * 4 + 3];
+        if (ndv > nv) {
+            memcpy(&verts[vbase * 3], &dmesh->verts[(vb + nv) * 3], sizeof(float) * 3 * (ndv - nv));
+            vbase += (unsigned int)(ndv - nv);
+        }
+    }
+    memcpy(tris, dmesh->tris, sizeof(unsigned char) * 4 * dmesh->ntris);
+    
+    rcFreePolyMesh(pmesh);
+    rcFreePolyMeshDetail(dmesh);
+    
+    entry.fanMeshes = tile->detailMeshes;
+    entry.fanVerts = tile->detailVerts;
+    entry.fanTris = tile->detailTris;
+    entry.detail = block;
+    entry.detailSize = size;
+    navMesh->setTileDetail(entry.ref, meshes, verts, tris);
+    return true;
+}
+
+// Free an entry's detail mesh, putting the polygon fans back on its tile
+// when restore is set and the tile is still there
+void BindingLazyDetail::dropDetail(LazyDetailTile& entry, bool restore)
+{
+    if (entry.detail) {
+        if (restore && navMesh->getTileByRef(entry.ref))
+            navMesh->setTileDetail(entry.ref, entry.fanMeshes, entry.fanVerts, entry.fanTris);
+        dtFree(entry.detail);
+        stats.cachedTiles--;
+        stats.cachedBytes -= entry.detailSize;
+    }
+    memset(&entry, 0, sizeof(entry));
+}
+
+void BindingLazyDetail::evictOldest()
+{
+    LazyDetailTile* oldest = nullptr;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        LazyDetailTile& entry = tiles[i];
+        if (entry.detail && (!oldest || clock - entry.lastUse > clock - oldest->lastUse))
+            oldest = &entry;
+    }
+    if (!oldest) return;
+    dropDetail(*oldest, true);
+    stats.evictions++;
+}
+
+void BindingLazyDetail::requireDetail(const dtMeshTile* tile)
+{
+    const dtTileRef ref = navMesh->getTileRef(tile);
+    LazyDetailTile& entry = tiles[navMesh->decodePolyIdTile((dtPolyRef)ref)];
+    if (entry.ref == ref) {
+        entry.lastUse = ++clock;
+        return;
+    }
+    
+    // The slot held a tile that has since been removed along with its arrays
+    dropDetail(entry, false);
+    
+    if (maxCachedTiles > 0 && stats.cachedTiles >= maxCachedTiles)
+        evictOldest();
+    
+    entry.ref = ref;
+    entry.lastUse = ++clock;
+    if (!buildDetail(tile, entry)) {
+        stats.failures++;
+        return;
+    }
+    stats.builds++;
+    stats.cachedTiles++;
+    stats.cachedBytes += entry.detailSize;
+}
+
+BindingLazyDetail* bindingCreateLazyDetail(BindingTileBuildInput* input, dtNavMesh* navMesh,
+                                           int maxCachedTiles)
+{
+    if (!input || !navMesh || maxCachedTiles < 0 || navMesh->getDetailProvider()) return nullptr;
+    
+    BindingLazyDetail* lazy = new BindingLazyDetail;
+    lazy->input = input;
+    lazy->navMesh = navMesh;
+    lazy->maxCachedTiles = maxCachedTiles;
+    lazy->clock = 0;
+    memset(&lazy->stats, 0, sizeof(lazy->stats));
+    lazy->tiles.resize(navMesh->getMaxTiles());
+    memset(&lazy->tiles[0], 0, sizeof(LazyDetailTile) * lazy->tiles.size());
+    
+    navMesh->setDetailProvider(lazy);
+    return lazy;
+}
+
+void bindingReleaseLazyDetail(BindingLazyDetail* lazy)
+{
+    if (!lazy) return;
+    for (size_t i = 0; i < lazy->tiles.size(); ++i)
+        lazy->dropDetail(lazy->tiles[i], true);
+    if (lazy->navMesh->getDetailProvider() == lazy)
+        lazy->navMesh->setDetailProvider(nullptr);
+    delete lazy;
+}
+
+void bindingLazyDetailGetStats(const BindingLazyDetail* lazy, BindingLazyDetailStats* stats)
+{
+    if (!stats) return;
+    if (!lazy) {
+        memset(stats, 0, sizeof(BindingLazyDetailStats));
+        return;
+    }
+    *stats = lazy->stats;
+}
+
+void bindingReleaseBuildStats(BindingBuildStats* stats)
+{
+    if (!stats) return;
+    free(stats->tileStats);
+    stats->tileStats = nullptr;
+    stats->numTileStats = 0;
+}
+
+// Indexed by rcTimerLabel
+static const char* const TIMER_LABEL_NAMES[] = {
+    "total",
+    "temp",
+    "rasterizeTriangles",
+    "buildCompactHeightfield",
+    "buildContours",
+    "buildContoursTrace",
+    "buildContoursSimplify",
+    "filterBorder",
+    "filterWalkable",
+    "medianArea",
+    "filterLowObstacles",
+    "buildPolyMesh",
+    "mergePolyMesh",
+    "erodeArea",
+    "markBoxArea",
+    "markCylinderArea",
+    "markConvexPolyArea",
+    "buildDistanceField",
+    "buildDistanceFieldDist",
+    "buildDistanceFieldBlur",
+    "buildRegions",
+    "buildRegionsWatershed",
+    "buildRegionsExpand",
+    "buildRegionsFlood",
+    "buildRegionsFilter",
+    "buildLayers",
+    "buildPolyMeshDetail",
+    "mergePolyMeshDetail",
+};
+static_assert(sizeof(TIMER_LABEL_NAMES) / sizeof(TIMER_LABEL_NAMES[0]) == RC_MAX_TIMERS,
+              "TIMER_LABEL_NAMES out of sync with rcTimerLabel");
+
+const char* bindingTimerLabelName(int label)
+{
+    if (label < 0 || label >= RC_MAX_TIMERS) return nullptr;
+    return TIMER_LABEL_NAMES[label];
+}
+
+void bindingReleaseTiledNavMesh(BindingTileMeshResult* result)
+{
+    if (result) {
+        if (result->navMesh) {
+            dtFreeNavMesh(result->navMesh);
+        }
+        free(result->stats.tileStats);
+        free(result);
+    }
+}
+
+// Appends what a BindingWriteFn receives to a malloc'ed buffer
+struct BufferWriter
+{
+    unsigned char* data;
+    int size;
+    int capacity;
+};
+
+static int writeToBuffer(void* context, const void* data, int size)
+{
+    BufferWriter* writer = (BufferWriter*)context;
+    if (size > writer->capacity - writer->size) {
+        int capacity = writer->capacity > 0 ? writer->capacity : 4096;
+        while (size > capacity - writer->size) {
+            if (capacity > INT_MAX / 2) return 0;
+            capacity *= 2;
+        }
+        unsigned char* grown = (unsigned char*)realloc(writer->data, capacity);
+        if (!grown) return 0;
+        writer->data = grown;
+        writer->capacity = capacity;
+    }
+    memcpy(writer->data + writer->size, data, size);
+    writer->size += size;
+    return 1;
+}
+
+int bindingWriteFileDescriptor(void* context, const void* data, int size)
+{
+    const int fd = *(const int*)context;
+    const unsigned char* bytes = (const unsigned char*)data;
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        bytes += written;
+        size -= (int)written;
+    }
+    return 1;
+}
+
+// Stream every tile of navMesh as a set with the given magic
+static BDetourStatus writeTileSet(const dtNavMesh* navMesh, int magic, BindingWriteFn write, void* context)
+{
+    rcNavMeshSetHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = magic;
+    header.version = NAVMESHSET_VERSION_RAW;
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (tile && tile->header && tile->dataSize) {
+            header.numTiles++;
+        }
+    }
+    memcpy(&header.params, navMesh->getParams(), sizeof(dtNavMeshParams));
+    if (!write(context, &header, sizeof(header))) return BD_ERR_WRITE;
+    
+    // Tile data goes out straight from the navmesh
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (!tile || !tile->header || !tile->dataSize) continue;
+        
+        rcNavMeshTileHeader tileHeader;
+        memset(&tileHeader, 0, sizeof(tileHeader));
+        tileHeader.tileRef = navMesh->getTileRef(tile);
+        tileHeader.dataSize = tile->dataSize;
+        if (!write(context, &tileHeader, sizeof(tileHeader)) ||
+            !write(context, tile->data, tile->dataSize)) {
+            return BD_ERR_WRITE;
+        }
+    }
+    return BD_OK;
+}
+
+// Collect the output of a writer into one malloc'ed buffer of the size given
+template <typename Writer>
+static BDetourStatus writeToResult(int sizeHint, void** result, int* resultSize, Writer writeSet)
+{
+    BufferWriter buffer = { (unsigned char*)malloc(sizeHint), 0, sizeHint };
+    if (!buffer.data) return BD_ERR_ALLOC_NAVMESH;
+    
+    BDetourStatus code = writeSet(&buffer);
+    if (code != BD_OK) {
+        free(buffer.data);
+        // The buffer only fails to take data when it cannot grow
+        return code == BD_ERR_WRITE ? BD_ERR_ALLOC_NAVMESH : code;
+    }
+    *result = buffer.data;
+    *resultSize = buffer.size;
+    return BD_OK;
+}
+
+// Write every tile of navMesh as a set with the given magic
+static BDetourStatus exportTileSet(const dtNavMesh* navMesh, int magic, void** result, int* resultSize)
+{
+    int totalSize = sizeof(rcNavMeshSetHeader);
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (!tile || !tile->header || !tile->dataSize) continue;
+        totalSize += sizeof(rcNavMeshTileHeader) + tile->dataSize;
+    }
+    return writeToResult(totalSize, result, resultSize, [&](BufferWriter* buffer) {
+        return writeTileSet(navMesh, magic, writeToBuffer, buffer);
+    });
+}
+
+BDetourStatus bindingExportTiledNavMesh(const dtNavMesh* navMesh, void** result, int* resultSize)
+{
+    if (!navMesh || !result || !resultSize) {
+        return BD_ERR_INVALID_PARAM;
+    }
+    return exportTileSet(navMesh, NAVMESHSET_MAGIC, result, resultSize);
+}
+
+BDetourStatus bindingWriteTiledNavMesh(const dtNavMesh* navMesh, BindingWriteFn write, void* context)
+{
+    if (!navMesh || !write) {
+        return BD_ERR_INVALID_PARAM;
+    }
+    return writeTileSet(navMesh, NAVMESHSET_MAGIC, write, context);
+}
+
+BDetourStatus bindingExportPrelinkedNavMesh(const dtNavMesh* navMesh, void** result, int* resultSize)
+{
+    if (!navMesh || !result || !resultSize) {
+        return BD_ERR_INVALID_PARAM;
+    }
+    // Live tile data already holds the links between all of the tiles, by tile
+    // reference; a reader that adds every tile back at its reference can use it as is
+    return exportTileSet(navMesh, NAVMESHSET_PRELINKED_MAGIC, result, resultSize);
+}
+
+dtStatus bindingLoadPrelinkedNavMesh(const void* data, int64_t dataSize, dtNavMesh** result)
+{
+    if (!data || !result || dataSize < (int64_t)sizeof(rcNavMeshSetHeader) || ((uintptr_t)data & 3)) {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+    *result = nullptr;
+    
+    const rcNavMeshSetHeader* header = (const rcNavMeshSetHeader*)data;
+    if (header->magic != NAVMESHSET_PRELINKED_MAGIC) return DT_FAILURE | DT_WRONG_MAGIC;
+    if (header->version != NAVMESHSET_VERSION_RAW) return DT_FAILURE | DT_WRONG_VERSION;
+    
+    dtNavMesh* navMesh = dtAllocNavMesh();
+    if (!navMesh) return DT_FAILURE | DT_OUT_OF_MEMORY;
+    dtStatus status = navMesh->init(&header->params);
+    
+    // Tiles are used where they are; nothing in data is written
+    unsigned char* bytes = (unsigned char*)data;
+    int64_t offset = sizeof(rcNavMeshSetHeader);
+    for (int i = 0; i < header->numTiles && dtStatusSucceed(status); ++i) {
+        if (dataSize - offset < (int64_t)sizeof(rcNavMeshTileHeader)) {
+            status = DT_FAILURE | DT_INVALID_PARAM;
+            break;
+        }
+        const rcNavMeshTileHeader* tileHeader = (const rcNavMeshTileHeader*)(bytes + offset);
+        offset += sizeof(rcNavMeshTileHeader);
+        if (tileHeader->dataSize < (int)sizeof(dtMeshHeader) || tileHeader->dataSize > dataSize - offset ||
+            (offset & 3)) {
+            status = DT_FAILURE | DT_INVALID_PARAM;
+            break;
+        }
+        status = navMesh->addTile(bytes + offset, tileHeader->dataSize, DT_TILE_PRELINKED,
+                                  tileHeader->tileRef, nullptr);
+        offset += tileHeader->dataSize;
+    }
+    
+    if (dtStatusFailed(status)) {
+        dtFreeNavMesh(navMesh);
+        return status;
+    }
+    *result = navMesh;
+    return DT_SUCCESS;
+}
+
+// The bytes one tile has in a version 2 set: LZ compressed unless that does
+// not make it smaller. stored points into scratch or the tile.
+struct StoredTileData
+{
+    const unsigned char* stored;
+    int storedSize;
+    int dataSize;
+};
+
+static void storeCompressedTile(const dtMeshTile* tile, LZTileCompressor& compressor,
+                                std::vector<unsigned char>& scratch, StoredTileData& out)
+{
+    const unsigned char* src = tile->data;
+    const int srcSize = tile->dataSize;
+    out.dataSize = srcSize;
+    const int maxSize = compressor.maxCompressedSize(srcSize);
+    if ((int)scratch.size() < maxSize) {
+        scratch.resize(maxSize);
+    }
+    int compressedSize = 0;
+    if (dtStatusSucceed(compressor.compress(src, srcSize, scratch.data(), maxSize, &compressedSize)) &&
+        compressedSize < srcSize) {
+        out.stored = scratch.data();
+        out.storedSize = compressedSize;
+    } else {
+        out.stored = src;
+        out.storedSize = srcSize;
+    }
+}
+
+// Stream navMesh as a version 2 set. The tile table comes first, so every tile
+// is compressed once to size the table and again to write it; only one tile is
+// held compressed at a time.
+static BDetourStatus writeCompressedSet(const dtNavMesh* navMesh, BindingWriteFn write, void* context)
+{
+    LZTileCompressor compressor;
+    std::vector<unsigned char> scratch;
+    std::vector<rcNavMeshSetTileEntry> entries;
+    
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (!tile || !tile->header || !tile->dataSize) continue;
+        
+        StoredTileData t;
+        storeCompressedTile(tile, compressor, scratch, t);
+        TileHasher hasher;
+        hasher.add(t.stored, t.storedSize);
+        
+        rcNavMeshSetTileEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.checksum = hasher.finish().h[0];
+        entry.tileRef = navMesh->getTileRef(tile);
+        entry.dataSize = t.dataSize;
+        entry.storedSize = t.storedSize;
+        entries.push_back(entry);
+    }
+    
+    uint64_t offset = sizeof(rcNavMeshSetHeader) + sizeof(rcNavMeshSetTileEntry) * entries.size();
+    for (rcNavMeshSetTileEntry& entry : entries) {
+        entry.offset = offset;
+        offset += entry.storedSize;
+    }
+    
+    rcNavMeshSetHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = NAVMESHSET_MAGIC;
+    header.version = NAVMESHSET_VERSION;
+    header.numTiles = (int)entries.size();
+    memcpy(&header.params, navMesh->getParams(), sizeof(dtNavMeshParams));
+    if (!write(context, &header, sizeof(header)) ||
+        (!entries.empty() && !write(context, entries.data(), (int)(sizeof(rcNavMeshSetTileEntry) * entries.size())))) {
+        return BD_ERR_WRITE;
+    }
+    
+    size_t next = 0;
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (!tile || !tile->header || !tile->dataSize) continue;
+        
+        StoredTileData t;
+        storeCompressedTile(tile, compressor, scratch, t);
+        if (next >= entries.size() || t.storedSize != entries[next].storedSize ||
+            !write(context, t.stored, t.storedSize)) {
+            return BD_ERR_WRITE;
+        }
+        next++;
+    }
+    return BD_OK;
+}
+
+BDetourStatus bindingExportCompressedNavMesh(const dtNavMesh* navMesh, void** result, int* resultSize)
+{
+    if (!navMesh || !result || !resultSize) {
+        return BD_ERR_INVALID_PARAM;
+    }
+    // Start from the raw size; compression only makes it smaller
+    int rawSize = sizeof(rcNavMeshSetHeader);
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (!tile || !tile->header || !tile->dataSize) continue;
+        rawSize += sizeof(rcNavMeshSetTileEntry) + tile->dataSize;
+    }
+    return writeToResult(rawSize, result, resultSize, [&](BufferWriter* buffer) {
+        return writeCompressedSet(navMesh, writeToBuffer, buffer);
+    });
+}
+
+BDetourStatus bindingWriteCompressedNavMesh(const dtNavMesh* navMesh, BindingWriteFn write, void* context)
+{
+    if (!navMesh || !write) {
+        return BD_ERR_INVALID_PARAM;
+    }
+    return writeCompressedSet(navMesh, write, context);
+}
+
+// Check and decompress one tile of a version 2 set.
+// data receives Detour tile data for addTile with DT_TILE_FREE_DATA.
+static dtStatus loadCompressedTile(const unsigned char* set, const rcNavMeshSetTileEntry& entry,
+                                   LZTileCompressor& compressor, unsigned char*& data, int& dataSize)
+{
+    const unsigned char* stored = set + entry.offset;
+    TileHasher hasher;
+    hasher.add(stored, entry.storedSize);
+    if (hasher.finish().h[0] != entry.checksum) return DT_FAILURE | DT_INVALID_PARAM;
+    
+    unsigned char* tile = (unsigned char*)dtAlloc(entry.dataSize, DT_ALLOC_PERM);
+    if (!tile) return DT_FAILURE | DT_OUT_OF_MEMORY;
+    
+    if (entry.storedSize == entry.dataSize) {
+        memcpy(tile, stored, entry.dataSize);
+    } else {
+        int size = 0;
+        if (dtStatusFailed(compressor.decompress(stored, entry.storedSize, tile, entry.dataSize, &size)) ||
+            size != entry.dataSize) {
+            dtFree(tile);
+            return DT_FAILURE | DT_INVALID_PARAM;
+        }
+    }
+    data = tile;
+    dataSize = entry.dataSize;
+    return DT_SUCCESS;
+}
+
+// Load every tile of a version 2 set: decompression runs on numThreads
+// workers, and the tiles are added in table order on this thread
+static dtStatus importCompressedSet(const unsigned char* bytes, int dataSize, const rcNavMeshSetHeader& header,
+                                    int numThreads, dtNavMesh* navMesh)
+{
+    const int numTiles = header.numTiles;
+    if (numTiles < 0 ||
+        (int64_t)sizeof(rcNavMeshSetHeader) + (int64_t)sizeof(rcNavMeshSetTileEntry) * numTiles > dataSize) {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+    
+    std::vector<rcNavMeshSetTileEntry> entries(numTiles);
+    if (numTiles > 0) {
+        memcpy(entries.data(), bytes + sizeof(rcNavMeshSetHeader), sizeof(rcNavMeshSetTileEntry) * numTiles);
+    }
+    for (const rcNavMeshSetTileEntry& entry : entries) {
+        if (entry.dataSize <= 0 || entry.storedSize <= 0 || entry.storedSize > entry.dataSize ||
+            entry.offset > (uint64_t)dataSize || (uint64_t)entry.storedSize > (uint64_t)dataSize - entry.offset) {
+            return DT_FAILURE | DT_INVALID_PARAM;
+        }
+    }
+    
+    struct LoadedTile { unsigned char* data; int dataSize; dtStatus status; };
+    std::vector<LoadedTile> tiles(numTiles);
+    std::atomic<int> nextTile(0);
+    
+    auto worker = [&]() {
+        LZTileCompressor compressor;
+        for (;;) {
+            const int i = nextTile.fetch_add(1);
+            if (i >= numTiles) break;
+            tiles[i].data = nullptr;
+            tiles[i].dataSize = 0;
+            tiles[i].status = loadCompressedTile(bytes, entries[i], compressor, tiles[i].data, tiles[i].dataSize);
+        }
+    };
+    
+    if (numThreads <= 0) numThreads = (int)std::thread::hardware_concurrency();
+    numThreads = dtClamp(numThreads, 1, dtMax(numTiles, 1));
+    if (numThreads == 1) {
+        worker();
+    } else {
+        std::vector<std::thread> workers;
+        workers.reserve(numThreads);
+        for (int i = 0; i < numThreads; ++i)
+            workers.emplace_back(worker);
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+    }
+    
+    dtStatus status = DT_SUCCESS;
+    for (int i = 0; i < numTiles; ++i) {
+        if (dtStatusSucceed(status)) status = tiles[i].status;
+        if (dtStatusSucceed(status)) {
+            status = navMesh->addTile(tiles[i].data, tiles[i].dataSize, DT_TILE_FREE_DATA, entries[i].tileRef, nullptr);
+            if (dtStatusSucceed(status)) continue;
+        }
+        dtFree(tiles[i].data);
+    }
+    return status;
+}
+
+// Load every tile of a version 1 set, or of a pre-linked one
+static dtStatus importRawSet(const unsigned char* bytes, int dataSize, const rcNavMeshSetHeader& header,
+                             dtNavMesh* navMesh)
+{
+    dtStatus status = DT_SUCCESS;
+    
+    int offset = sizeof(rcNavMeshSetHeader);
+    for (int i = 0; i < header.numTiles && dtStatusSucceed(status); ++i) {
+        rcNavMeshTileHeader tileHeader;
+        if (dataSize - offset < (int)sizeof(tileHeader)) {
+            status = DT_FAILURE | DT_INVALID_PARAM;
+            break;
+        }
+        memcpy(&tileHeader, bytes + offset, sizeof(tileHeader));
+        offset += sizeof(tileHeader);
+        if (tileHeader.dataSize <= 0 || tileHeader.dataSize > dataSize - offset) {
+            status = DT_FAILURE | DT_INVALID_PARAM;
+            break;
+        }
+        const unsigned char* src = bytes + offset;
+        offset += tileHeader.dataSize;
+        
+        // Detour patches tile data in place, so every tile gets its own copy
+        unsigned char* tileData = (unsigned char*)dtAlloc(tileHeader.dataSize, DT_ALLOC_PERM);
+        if (!tileData) {
+            status = DT_FAILURE | DT_OUT_OF_MEMORY;
+            break;
+        }
+        memcpy(tileData, src, tileHeader.dataSize);
+        
+        status = navMesh->addTile(tileData, tileHeader.dataSize, DT_TILE_FREE_DATA, tileHeader.tileRef, nullptr);
+        if (dtStatusFailed(status)) dtFree(tileData);
+    }
+    return status;
+}
+
+dtStatus bindingImportNavMeshSet(const void* data, int dataSize, int numThreads, dtNavMesh** result)
+{
+    if (!data || !result || dataSize < (int)sizeof(rcNavMeshSetHeader)) {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+    *result = nullptr;
+    
+    const unsigned char* bytes = (const unsigned char*)data;
+    rcNavMeshSetHeader header;
+    memcpy(&header, bytes, sizeof(header));
+    if (header.magic != NAVMESHSET_MAGIC && header.magic != NAVMESHSET_PRELINKED_MAGIC) {
+        return DT_FAILURE | DT_WRONG_MAGIC;
+    }
+    const bool compressed = header.magic == NAVMESHSET_MAGIC && header.version == NAVMESHSET_VERSION;
+    if (!compressed && header.version != NAVMESHSET_VERSION_RAW) {
+        return DT_FAILURE | DT_WRONG_VERSION;
+    }
+    
+    dtNavMesh* navMesh = dtAllocNavMesh();
+    if (!navMesh) return DT_FAILURE | DT_OUT_OF_MEMORY;
+    dtStatus status = navMesh->init(&header.params);
+    if (dtStatusSucceed(status)) {
+        status = compressed
+            ? importCompressedSet(bytes, dataSize, header, numThreads, navMesh)
+            : importRawSet(bytes, dataSize, header, navMesh);
+    }
+    
+    if (dtStatusFailed(status)) {
+        dtFreeNavMesh(navMesh);
+        return status;
+    }
+    *result = navMesh;
+    return DT_SUCCESS;
+}
+
+static inline size_t align4(size_t x) { return (x + 3) & ~(size_t)3; }
+
+BDetourStatus bindingExportIndexedNavMesh(const dtNavMesh* navMesh, void** result, int64_t* resultSize)
+{
+    if (!navMesh || !result || !resultSize) {
+        return BD_ERR_INVALID_PARAM;
+    }
+    
+    std::vector<const dtMeshTile*> tiles;
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (!tile || !tile->header || !tile->dataSize) continue;
+        tiles.push_back(tile);
+    }
+    
+    // 64-bit offsets, so a set can be larger than 2 GB
+    const size_t indexSize = sizeof(rcNavMeshIndexHeader) + sizeof(rcNavMeshIndexEntry) * tiles.size();
+    size_t totalSize = align4(indexSize);
+    for (const dtMeshTile* tile : tiles)
+        totalSize += align4((size_t)tile->dataSize);
+    
+    unsigned char* buf = (unsigned char*)malloc(totalSize);
+    if (!buf) {
+        return BD_ERR_ALLOC_NAVMESH;
+    }
+    memset(buf, 0, totalSize);
+    
+    rcNavMeshIndexHeader* header = (rcNavMeshIndexHeader*)buf;
+    header->magic = NAVMESHINDEX_MAGIC;
+    header->version = NAVMESHINDEX_VERSION;
+    header->numTiles = (int)tiles.size();
+    memcpy(&header->params, navMesh->getParams(), sizeof(dtNavMeshParams));
+    
+    // The header is 44 bytes, so the entries after it are not 8-byte aligned
+    // in the buffer; fill each one in place and copy it over
+    unsigned char* entries = buf + sizeof(rcNavMeshIndexHeader);
+    size_t offset = align4(indexSize);
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        const dtMeshTile* tile = tiles[i];
+        rcNavMeshIndexEntry entry;
+        entry.offset = (uint64_t)offset;
+        entry.tileRef = navMesh->getTileRef(tile);
+        entry.x = tile->header->x;
+        entry.y = tile->header->y;
+        entry.layer = tile->header->layer;
+        entry.storedSize = tile->dataSize;
+        entry.tileSize = tile->dataSize;
+        memcpy(entries + sizeof(rcNavMeshIndexEntry) * i, &entry, sizeof(entry));
+        
+        memcpy(buf + offset, tile->data, tile->dataSize);
+        offset += align4((size_t)tile->dataSize);
+    }
+    
+    *result = buf;
+    *resultSize = (int64_t)totalSize;
+    
+    return BD_OK;
+}
+
+// ================================================
+//       Region-streamed tile loading
+// ================================================
+
+enum StreamTileState {
+    STREAM_TILE_UNLOADED,
+    STREAM_TILE_QUEUED,     // Waiting for the reader
+    STREAM_TILE_READING,
+    STREAM_TILE_READ,       // Waiting in finished to be added
+    STREAM_TILE_RESIDENT,
+    STREAM_TILE_FAILED,
+};
+
+struct StreamReadTile {
+    int entry;
+    unsigned char* data;    // dtAlloc'ed Detour tile data, null if the read failed
+    int dataSize;
+};
+
+struct BindingTileStream {
+    int fd;
+    rcNavMeshIndexHeader header;
+    std::vector<rcNavMeshIndexEntry> entries;
+    dtNavMesh* navMesh;
+    int64_t memoryBudget;
+    BindingTileStreamStats stats;
+    std::vector<float> distances;           // Of every entry from the latest focus
+    
+    // Shared with the reader
+    std::mutex mutex;
+    std::condition_variable wake;           // Requests were queued, or stop
+    std::condition_variable idle;           // The reader ran out of requests
+    std::vector<unsigned char> states;      // StreamTileState per entry
+    std::vector<int> requests;              // Entries to read, nearest last
+    std::vector<StreamReadTile> finished;
+    bool reading;
+    bool stop;
+    std::thread reader;
+    
+    void readLoop();
+    bool readTile(const rcNavMeshIndexEntry& entry, unsigned char*& data, int& dataSize);
+    int addFinished(int maxTileAdds, float unloadRadius);
+};
+
+// Read one tile, off the navmesh
+bool BindingTileStream::readTile(const rcNavMeshIndexEntry& entry, unsigned char*& data, int& dataSize)
 {
-    return buildTiledNavMeshImpl(config, tileConfig, flags,
-                                   verts, numVerts, tris, numTris,
-                                   areaVerts, areaVertCounts,
-                                   areaTris, areaTriCounts,
-                                   areaCodes, numAreaMeshes,
-                                   agentHeight, agentRadius, agentMaxClimb);
+    unsigned char* stored = (unsigned char*)dtAlloc(entry.storedSize, DT_ALLOC_PERM);
+    if (!stored) return false;
+    
+    int done = 0;
+    while (done < entry.storedSize) {
+        const ssize_t n = pread(fd, stored + done, entry.storedSize - done, (off_t)(entry.offset + done));
+        if (n <= 0) {
+            dtFree(stored);
+            return false;
+        }
+        done += (int)n;
+    }
+    data = stored;
+    dataSize = entry.storedSize;
+    return true;
 }
 
-// Keep the old API for backward compatibility
-struct BindingTileMeshResult* bindingBuildTiledNavMesh(
-    rcConfig* config,
-    const TileConfig* tileConfig,
-    int flags,
-    const float* verts,
-    int numVerts,
-    const int* tris,
-    int numTris,
-    const rcPolyMesh** areaMeshes,     // Deprecated
-    const unsigned char* areaCodes,     // Deprecated
-    int numAreaMeshes,                  // Deprecated
-    float agentHeight,
-    float agentRadius,
-    float agentMaxClimb)
+void BindingTileStream::readLoop()
 {
-    // Call the new version without areas
-    return buildTiledNavMeshImpl(config, tileConfig, flags,
-                                   verts, numVerts, tris, numTris,
-                                   nullptr, nullptr, nullptr, nullptr,
-                                   nullptr, 0,
-                                   agentHeight, agentRadius, agentMaxClimb);
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [&]() { return stop || !requests.empty(); });
+        if (stop) break;
+        
+        const int i = requests.back();
+        requests.pop_back();
+        states[i] = STREAM_TILE_READING;
+        reading = true;
+        
+        lock.unlock();
+        StreamReadTile tile = { i, nullptr, 0 };
+        if (!readTile(entries[i], tile.data, tile.dataSize)) {
+            tile.data = nullptr;
+        }
+        lock.lock();
+        
+        states[i] = STREAM_TILE_READ;
+        finished.push_back(tile);
+        reading = false;
+        if (requests.empty()) idle.notify_all();
+    }
 }
 
-void bindingReleaseTiledNavMesh(BindingTileMeshResult* result)
+// Add tiles the reader has finished, dropping those that went out of range
+// meanwhile. Called with the mutex held.
+int BindingTileStream::addFinished(int maxTileAdds, float unloadRadius)
 {
-    if (result) {
-        if (result->navMesh) {
-            dtFreeNavMesh(result->navMesh);
+    int added = 0;
+    size_t kept = 0;
+    for (size_t k = 0; k < finished.size(); ++k) {
+        StreamReadTile& tile = finished[k];
+        if (maxTileAdds > 0 && added >= maxTileAdds && tile.data && distances[tile.entry] <= unloadRadius) {
+            finished[kept++] = tile;
+            continue;
         }
-        free(result);
+        
+        if (!tile.data) {
+            states[tile.entry] = STREAM_TILE_FAILED;
+            stats.failures++;
+            continue;
+        }
+        if (distances[tile.entry] > unloadRadius) {
+            dtFree(tile.data);
+            states[tile.entry] = STREAM_TILE_UNLOADED;
+            continue;
+        }
+        
+        const rcNavMeshIndexEntry& entry = entries[tile.entry];
+        if (dtStatusFailed(navMesh->addTile(tile.data, tile.dataSize, DT_TILE_FREE_DATA, entry.tileRef, nullptr))) {
+            dtFree(tile.data);
+            states[tile.entry] = STREAM_TILE_FAILED;
+            stats.failures++;
+            continue;
+        }
+        states[tile.entry] = STREAM_TILE_RESIDENT;
+        stats.residentTiles++;
+        stats.residentBytes += entry.tileSize;
+        stats.loads++;
+        added++;
     }
+    finished.resize(kept);
+    return added;
 }
 
-BDetourStatus bindingExportTiledNavMesh(const dtNavMesh* navMesh, void** result, int* resultSize)
+BindingTileStream* bindingOpenTileStream(const char* path, int64_t memoryBudget, dtStatus* status)
 {
-    if (!navMesh || !result || !resultSize) {
-        return BD_ERR_INVALID_PARAM;
+    dtStatus unused;
+    if (!status) status = &unused;
+    if (!path || memoryBudget < 0) {
+        *status = DT_FAILURE | DT_INVALID_PARAM;
+        return nullptr;
     }
     
-    // Calculate total size
-    int totalSize = sizeof(rcNavMeshSetHeader);
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        *status = DT_FAILURE | DT_INVALID_PARAM;
+        return nullptr;
+    }
     
-    for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
-        const dtMeshTile* tile = navMesh->getTile(i);
-        if (!tile || !tile->header || !tile->dataSize) continue;
-        totalSize += sizeof(rcNavMeshTileHeader) + tile->dataSize;
+    rcNavMeshIndexHeader header;
+    if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        header.magic != NAVMESHINDEX_MAGIC) {
+        close(fd);
+        *status = DT_FAILURE | DT_WRONG_MAGIC;
+        return nullptr;
+    }
+    if (header.version != NAVMESHINDEX_VERSION) {
+        close(fd);
+        *status = DT_FAILURE | DT_WRONG_VERSION;
+        return nullptr;
     }
     
-    // Allocate buffer
-    unsigned char* buf = (unsigned char*)malloc(totalSize);
-    if (!buf) return BD_ERR_ALLOC_NAVMESH;
+    std::vector<rcNavMeshIndexEntry> entries(header.numTiles > 0 ? header.numTiles : 0);
+    const ssize_t indexSize = (ssize_t)(sizeof(rcNavMeshIndexEntry) * entries.size());
+    if (header.numTiles < 0 ||
+        pread(fd, entries.data(), indexSize, sizeof(header)) != indexSize) {
+        close(fd);
+        *status = DT_FAILURE | DT_INVALID_PARAM;
+        return nullptr;
+    }
+    for (const rcNavMeshIndexEntry& entry : entries) {
+        if (entry.storedSize <= 0 || entry.tileSize <= 0) {
+            close(fd);
+            *status = DT_FAILURE | DT_INVALID_PARAM;
+            return nullptr;
+        }
+    }
+    
+    dtNavMesh* navMesh = dtAllocNavMesh();
+    if (!navMesh) {
+        close(fd);
+        *status = DT_FAILURE | DT_OUT_OF_MEMORY;
+        return nullptr;
+    }
+    *status = navMesh->init(&header.params);
+    if (dtStatusFailed(*status)) {
+        dtFreeNavMesh(navMesh);
+        close(fd);
+        return nullptr;
+    }
     
-    // Write header
-    rcNavMeshSetHeader* header = (rcNavMeshSetHeader*)buf;
-    header->magic = NAVMESHSET_MAGIC;
-    header->version = NAVMESHSET_VERSION;
-    header->numTiles = 0;
+    BindingTileStream* stream = new BindingTileStream();
+    stream->fd = fd;
+    stream->header = header;
+    stream->entries.swap(entries);
+    stream->navMesh = navMesh;
+    stream->memoryBudget = memoryBudget;
+    memset(&stream->stats, 0, sizeof(stream->stats));
+    stream->stats.totalTiles = header.numTiles;
+    stream->distances.assign(header.numTiles, FLT_MAX);
+    stream->states.assign(header.numTiles, STREAM_TILE_UNLOADED);
+    stream->reading = false;
+    stream->stop = false;
+    stream->reader = std::thread([stream]() { stream->readLoop(); });
     
-    for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
-        const dtMeshTile* tile = navMesh->getTile(i);
-        if (tile && tile->header && tile->dataSize) {
-            header->numTiles++;
+    *status = DT_SUCCESS;
+    return stream;
+}
+
+void bindingCloseTileStream(BindingTileStream* stream)
+{
+    if (!stream) return;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->stop = true;
+    }
+    stream->wake.notify_all();
+    stream->reader.join();
+    
+    for (const StreamReadTile& tile : stream->finished)
+        dtFree(tile.data);
+    dtFreeNavMesh(stream->navMesh);
+    close(stream->fd);
+    delete stream;
+}
+
+dtNavMesh* bindingTileStreamGetNavMesh(BindingTileStream* stream)
+{
+    return stream ? stream->navMesh : nullptr;
+}
+
+int bindingTileStreamUpdate(BindingTileStream* stream, const float* focus,
+                            float loadRadius, float unloadRadius, int maxTileAdds)
+{
+    if (!stream || !focus) return 0;
+    if (unloadRadius < loadRadius) unloadRadius = loadRadius;
+    
+    // Distance from the focus to every tile's bounds on the xz plane
+    const dtNavMeshParams& params = stream->header.params;
+    for (size_t i = 0; i < stream->entries.size(); ++i) {
+        const rcNavMeshIndexEntry& entry = stream->entries[i];
+        const float minx = params.orig[0] + entry.x * params.tileWidth;
+        const float minz = params.orig[2] + entry.y * params.tileHeight;
+        const float dx = dtMax(dtMax(minx - focus[0], focus[0] - (minx + params.tileWidth)), 0.0f);
+        const float dz = dtMax(dtMax(minz - focus[2], focus[2] - (minz + params.tileHeight)), 0.0f);
+        stream->distances[i] = sqrtf(dx * dx + dz * dz);
+    }
+    
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    std::vector<unsigned char>& states = stream->states;
+    
+    // Unload first so the budget has room for what is in range now
+    for (size_t i = 0; i < stream->entries.size(); ++i) {
+        if (states[i] != STREAM_TILE_RESIDENT || stream->distances[i] <= unloadRadius) continue;
+        const rcNavMeshIndexEntry& entry = stream->entries[i];
+        const dtMeshTile* tile = stream->navMesh->getTileAt(entry.x, entry.y, entry.layer);
+        if (tile) stream->navMesh->removeTile(stream->navMesh->getTileRef(tile), 0, 0);
+        states[i] = STREAM_TILE_UNLOADED;
+        stream->stats.residentTiles--;
+        stream->stats.residentBytes -= entry.tileSize;
+        stream->stats.unloads++;
+    }
+    
+    // Requeue from scratch, nearest first; tiles being read or already read count against the budget
+    int64_t committed = stream->stats.residentBytes;
+    std::vector<int> wanted;
+    for (size_t i = 0; i < stream->entries.size(); ++i) {
+        if (states[i] == STREAM_TILE_QUEUED) states[i] = STREAM_TILE_UNLOADED;
+        if (states[i] == STREAM_TILE_READING || states[i] == STREAM_TILE_READ) {
+            if (stream->distances[i] <= unloadRadius) committed += stream->entries[i].tileSize;
+        }
+        if (states[i] == STREAM_TILE_UNLOADED && stream->distances[i] <= loadRadius) {
+            wanted.push_back((int)i);
+        }
+    }
+    std::sort(wanted.begin(), wanted.end(), [&](int a, int b) {
+        return stream->distances[a] < stream->distances[b];
+    });
+    
+    stream->requests.clear();
+    stream->stats.budgetSkipped = 0;
+    for (size_t k = 0; k < wanted.size(); ++k) {
+        const int i = wanted[k];
+        if (stream->memoryBudget > 0 && committed + stream->entries[i].tileSize > stream->memoryBudget) {
+            stream->stats.budgetSkipped = (int)(wanted.size() - k);
+            break;
+        }
+        committed += stream->entries[i].tileSize;
+        states[i] = STREAM_TILE_QUEUED;
+        stream->requests.push_back(i);
+    }
+    std::reverse(stream->requests.begin(), stream->requests.end());
+    if (!stream->requests.empty()) stream->wake.notify_one();
+    
+    return stream->addFinished(maxTileAdds, unloadRadius);
+}
+
+int bindingTileStreamFlush(BindingTileStream* stream)
+{
+    if (!stream) return 0;
+    std::unique_lock<std::mutex> lock(stream->mutex);
+    stream->idle.wait(lock, [&]() { return stream->requests.empty() && !stream->reading; });
+    return stream->addFinished(0, FLT_MAX);
+}
+
+void bindingTileStreamGetStats(BindingTileStream* stream, BindingTileStreamStats* stats)
+{
+    if (!stats) return;
+    if (!stream) {
+        memset(stats, 0, sizeof(BindingTileStreamStats));
+        return;
+    }
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    *stats = stream->stats;
+    stats->pendingTiles = (int)(stream->requests.size() + stream->finished.size()) + (stream->reading ? 1 : 0);
+}
+
+// ================================================
+//       OBJ geometry loading
+// ================================================
+
+static BObjStatus objParseStatus(ObjParseResult result)
+{
+    switch (result) {
+        case OBJ_PARSE_OK: return BOBJ_OK;
+        case OBJ_PARSE_BAD_FORMAT: return BOBJ_ERR_FORMAT;
+        default: return BOBJ_ERR_MEMORY;
+    }
+}
+
+static void objMeshToBinding(const ObjMesh& objMesh, bool fromCache, BindingObjMesh* mesh)
+{
+    mesh->vertices = objMesh.vertices;
+    mesh->triangles = objMesh.triangles;
+    mesh->vertexCount = objMesh.vertexCount;
+    mesh->triangleCount = objMesh.triangleCount;
+    mesh->fromCache = fromCache ? 1 : 0;
+}
+
+BObjStatus bindingParseObjMesh(const char* text, int64_t size, int numThreads, BindingObjMesh* mesh)
+{
+    if (!mesh) return BOBJ_ERR_MEMORY;
+    memset(mesh, 0, sizeof(BindingObjMesh));
+    if (!text && size > 0) return BOBJ_ERR_IO;
+    
+    ObjMesh objMesh;
+    const ObjParseResult result = objParseMesh(text, size > 0 ? (size_t)size : 0, numThreads, objMesh);
+    if (result == OBJ_PARSE_OK) {
+        objMeshToBinding(objMesh, false, mesh);
+    }
+    return objParseStatus(result);
+}
+
+BObjStatus bindingLoadObjMesh(const char* path, const char* cachePath, int numThreads, BindingObjMesh* mesh)
+{
+    if (!mesh) return BOBJ_ERR_MEMORY;
+    memset(mesh, 0, sizeof(BindingObjMesh));
+    if (!path) return BOBJ_ERR_IO;
+    
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return BOBJ_ERR_IO;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return BOBJ_ERR_IO;
+    }
+    const uint64_t sourceSize = (uint64_t)st.st_size;
+#if defined(__APPLE__)
+    const int64_t sourceTime = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    const int64_t sourceTime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    
+    ObjMesh objMesh;
+    if (cachePath && objGeomCacheLoad(cachePath, sourceSize, sourceTime, objMesh)) {
+        close(fd);
+        objMeshToBinding(objMesh, true, mesh);
+        return BOBJ_OK;
+    }
+    
+    // Parsing reads the file once, front to back within each chunk
+    const void* text = nullptr;
+    if (sourceSize > 0) {
+        text = mmap(nullptr, sourceSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (text == MAP_FAILED) {
+            close(fd);
+            return BOBJ_ERR_IO;
         }
+        madvise((void*)text, sourceSize, MADV_SEQUENTIAL);
     }
+    close(fd);
+    
+    const ObjParseResult result = objParseMesh((const char*)text, sourceSize, numThreads, objMesh);
+    if (text) munmap((void*)text, sourceSize);
+    if (result != OBJ_PARSE_OK) return objParseStatus(result);
     
-    const dtNavMeshParams* navParams = navMesh->getParams();
-    memcpy(&header->params, navParams, sizeof(dtNavMeshParams));
+    if (cachePath) {
+        objGeomCacheStore(cachePath, sourceSize, sourceTime, objMesh);
+    }
+    objMeshToBinding(objMesh, false, mesh);
+    return BOBJ_OK;
+}
+
+void bindingReleaseObjMesh(BindingObjMesh* mesh)
+{
+    if (!mesh) return;
+    free(mesh->vertices);
+    free(mesh->triangles);
+    memset(mesh, 0, sizeof(BindingObjMesh));
+}
+
+// ================================================
+//       Batched path queries
+// ================================================
+
+void bindingFindStraightPaths(dtNavMeshQuery* query, const dtQueryFilter* filter,
+                              const float* starts, const float* ends,
+                              const int* items, int itemCount, const float* extents,
+                              int maxPolys, int maxPoints, int options,
+                              float* points, int* pointCounts, dtStatus* statuses)
+{
+    if (!query || !filter || itemCount <= 0) return;
     
-    // Write tiles
-    unsigned char* ptr = buf + sizeof(rcNavMeshSetHeader);
+    std::vector<dtPolyRef> corridor;
+    dtStatus alloc = DT_SUCCESS;
+    try {
+        corridor.resize(maxPolys > 0 ? maxPolys : 0);
+    } catch (const std::bad_alloc&) {
+        alloc = DT_FAILURE | DT_OUT_OF_MEMORY;
+    }
     
-    for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
-        const dtMeshTile* tile = navMesh->getTile(i);
-        if (!tile || !tile->header || !tile->dataSize) continue;
+    for (int k = 0; k < itemCount; ++k) {
+        const int i = items[k];
+        const float* start = &starts[i * 3];
+        const float* end = &ends[i * 3];
+        float* out = &points[(size_t)i * maxPoints * 3];
+        pointCounts[i] = 0;
+        if (dtStatusFailed(alloc) || maxPolys <= 0 || maxPoints <= 0) {
+            statuses[i] = dtStatusFailed(alloc) ? alloc : (DT_FAILURE | DT_INVALID_PARAM);
+            continue;
+        }
+        
+        dtPolyRef startRef = 0, endRef = 0;
+        float startPt[3], endPt[3];
+        dtStatus status = query->findNearestPoly(start, extents, filter, &startRef, startPt);
+        if (dtStatusSucceed(status)) {
+            status = query->findNearestPoly(end, extents, filter, &endRef, endPt);
+        }
+        if (dtStatusFailed(status)) {
+            statuses[i] = status;
+            continue;
+        }
         
-        rcNavMeshTileHeader* tileHeader = (rcNavMeshTileHeader*)ptr;
-        tileHeader->tileRef = navMesh->getTileRef(tile);
-        tileHeader->dataSize = tile->dataSize;
-        ptr += sizeof(rcNavMeshTileHeader);
+        int npolys = 0;
+        status = query->findPath(startRef, endRef, startPt, endPt, filter, corridor.data(), &npolys, maxPolys);
+        if (dtStatusFailed(status)) {
+            statuses[i] = status;
+            continue;
+        }
         
-        memcpy(ptr, tile->data, tile->dataSize);
-        ptr += tile->dataSize;
+        // Corridor and corner results both report partial paths and full buffers
+        int npoints = 0;
+        const dtStatus pull = query->findStraightPath(start, end, corridor.data(), npolys,
+                                                      out, nullptr, nullptr, &npoints, maxPoints, options);
+        if (dtStatusFailed(pull)) {
+            statuses[i] = pull;
+            continue;
+        }
+        pointCounts[i] = npoints;
+        statuses[i] = status | (pull & DT_STATUS_DETAIL_MASK);
     }
+}
+
+int bindingPolyRefsValid(const dtNavMeshQuery* query, const dtQueryFilter* filter,
+                         const dtPolyRef* refs, int count)
+{
+    const dtNavMesh* navMesh = query ? query->getAttachedNavMesh() : nullptr;
+    if (!navMesh || !filter) return 0;
     
-    *result = buf;
-    *resultSize = totalSize;
-    
-    return BD_OK;
+    // The salt in a ref changes whenever the tile in its slot does; flags and
+    // areas, such as a closed door's, change in place
+    for (int i = 0; i < count; ++i) {
+        if (!navMesh->isValidPolyRef(refs[i])) return 0;
+        const dtMeshTile* tile = nullptr;
+        const dtPoly* poly = nullptr;
+        navMesh->getTileAndPolyByRefUnsafe(refs[i], &tile, &poly);
+        // passFilter is inline in DetourNavMeshQuery.cpp unless DT_VIRTUAL_QUERYFILTER is set
+        if ((poly->flags & filter->getIncludeFlags()) == 0 || (poly->flags & filter->getExcludeFlags()) != 0) return 0;
+    }
+    return 1;
+}
+
+struct BindingPathPlanner {
+    TilePortalGraph graph;
+
+    BindingPathPlanner(const dtNavMesh* navMesh, const dtQueryFilter& filter) :
+        graph(navMesh, filter)
+    {
+    }
+};
+
+BindingPathPlanner* bindingCreatePathPlanner(const dtNavMesh* navMesh, const dtQueryFilter* filter, int numThreads)
+{
+    if (!navMesh || !filter) return nullptr;
+    BindingPathPlanner* planner = new BindingPathPlanner(navMesh, *filter);
+    planner->graph.update(numThreads);
+    return planner;
+}
+
+void bindingReleasePathPlanner(BindingPathPlanner* planner)
+{
+    delete planner;
+}
+
+int bindingPathPlannerUpdate(BindingPathPlanner* planner, int numThreads)
+{
+    return planner ? planner->graph.update(numThreads) : 0;
+}
+
+dtStatus bindingPathPlannerFindPath(const BindingPathPlanner* planner, dtNavMeshQuery* query,
+                                    dtPolyRef startRef, dtPolyRef endRef,
+                                    const float* startPos, const float* endPos,
+                                    dtPolyRef* path, int* pathCount, int maxPath, int* expanded)
+{
+    if (!planner || !pathCount) return DT_FAILURE | DT_INVALID_PARAM;
+    return planner->graph.findPath(query, startRef, endRef, startPos, endPos, path, pathCount, maxPath, expanded);
+}
+
+void bindingPathPlannerGetStats(const BindingPathPlanner* planner, struct BindingPathPlannerStats* stats)
+{
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!planner) return;
+    stats->tiles = planner->graph.tileCount();
+    stats->nodes = planner->graph.nodeCount();
+    stats->edges = planner->graph.edgeCount();
+    stats->bytes = (int64_t)planner->graph.memoryUsage();
 }
 
 // Utility functions
@@ -709,3 +4131,184 @@ void freeVertsAndTriangles(BindingVertsAndTriangles* data)
         free(data);
     }
 }
+
+// Incremental debug geometry
+
+struct CachedTileGeometry {
+    dtTileRef tileRef = 0;
+    int x = 0, y = 0, layer = 0;
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<uint32_t> indices;
+    std::vector<uint8_t> areas;
+    std::vector<uint16_t> flags;
+    std::vector<dtPolyRef> polys;
+};
+
+struct BindingGeometryCache {
+    const dtNavMesh* navMesh;
+    std::vector<CachedTileGeometry> tiles;
+};
+
+// Fan the ground polygons of a tile into triangles with smooth vertex normals
+static void extractCachedTile(const dtNavMesh* navMesh, const dtMeshTile* tile, CachedTileGeometry& out)
+{
+    out.positions.clear();
+    out.normals.clear();
+    out.indices.clear();
+    out.areas.clear();
+    out.flags.clear();
+    out.polys.clear();
+    out.tileRef = (tile && tile->header) ? navMesh->getTileRef(tile) : 0;
+    if (!out.tileRef) return;
+    
+    const dtMeshHeader* header = tile->header;
+    out.x = header->x;
+    out.y = header->y;
+    out.layer = header->layer;
+    
+    int ntris = 0;
+    for (int i = 0; i < header->polyCount; ++i) {
+        const dtPoly* p = &tile->polys[i];
+        if (p->getType() == DT_POLYTYPE_OFFMESH_CONNECTION) continue;
+        ntris += p->vertCount - 2;
+    }
+    
+    out.positions.resize(header->vertCount * 4);
+    out.normals.assign(header->vertCount * 4, 0.0f);
+    out.indices.reserve(ntris * 3);
+    out.areas.reserve(ntris);
+    out.flags.reserve(ntris);
+    out.polys.reserve(ntris);
+    
+    for (int i = 0; i < header->vertCount; ++i) {
+        dtVcopy(&out.positions[i * 4], &tile->verts[i * 3]);
+        out.positions[i * 4 + 3] = 0;
+    }
+    
+    const dtPolyRef base = navMesh->getPolyRefBase(tile);
+    for (int i = 0; i < header->polyCount; ++i) {
+        const dtPoly* p = &tile->polys[i];
+        if (p->getType() == DT_POLYTYPE_OFFMESH_CONNECTION) continue;
+        
+        for (int j = 2; j < p->vertCount; ++j) {
+            const unsigned short a = p->verts[0], b = p->verts[j - 1], c = p->verts[j];
+            out.indices.push_back(a);
+            out.indices.push_back(b);
+            out.indices.push_back(c);
+            out.areas.push_back(p->getArea());
+            out.flags.push_back(p->flags);
+            out.polys.push_back(base | (dtPolyRef)i);
+            
+            // Sum unit face normals, as the RealityKit extraction did
+            float e0[3], e1[3], n[3];
+            dtVsub(e0, &tile->verts[b * 3], &tile->verts[a * 3]);
+            dtVsub(e1, &tile->verts[c * 3], &tile->verts[a * 3]);
+            dtVcross(n, e0, e1);
+            const float len = dtVlen(n);
+            if (len <= 0) continue;
+            dtVscale(n, n, 1.0f / len);
+            dtVadd(&out.normals[a * 4], &out.normals[a * 4], n);
+            dtVadd(&out.normals[b * 4], &out.normals[b * 4], n);
+            dtVadd(&out.normals[c * 4], &out.normals[c * 4], n);
+        }
+    }
+    
+    for (int i = 0; i < header->vertCount; ++i) {
+        float* n = &out.normals[i * 4];
+        const float len = dtVlen(n);
+        if (len > 0) {
+            dtVscale(n, n, 1.0f / len);
+        } else {
+            n[0] = 0; n[1] = 1; n[2] = 0;
+        }
+    }
+}
+
+BindingGeometryCache* bindingCreateGeometryCache(const dtNavMesh* navMesh)
+{
+    if (!navMesh) return nullptr;
+    BindingGeometryCache* cache = new BindingGeometryCache();
+    cache->navMesh = navMesh;
+    cache->tiles.resize(navMesh->getMaxTiles());
+    return cache;
+}
+
+void bindingReleaseGeometryCache(BindingGeometryCache* cache)
+{
+    delete cache;
+}
+
+int bindingGeometryCacheUpdate(BindingGeometryCache* cache, int* changed, int maxChanged, int numThreads)
+{
+    if (!cache) return 0;
+    const dtNavMesh* navMesh = cache->navMesh;
+    
+    std::vector<int> dirty;
+    for (int i = 0; i < (int)cache->tiles.size(); ++i) {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        const dtTileRef ref = (tile && tile->header) ? navMesh->getTileRef(tile) : 0;
+        if (ref != cache->tiles[i].tileRef) dirty.push_back(i);
+    }
+    
+    const int numDirty = (int)dirty.size();
+    if (numThreads <= 0) numThreads = (int)std::thread::hardware_concurrency();
+    numThreads = std::max(1, std::min(numThreads, numDirty));
+    
+    std::atomic<int> nextTile(0);
+    auto worker = [&]() {
+        for (;;) {
+            const int i = nextTile.fetch_add(1);
+            if (i >= numDirty) break;
+            const int index = dirty[i];
+            extractCachedTile(navMesh, navMesh->getTile(index), cache->tiles[index]);
+        }
+    };
+    
+    if (numThreads == 1) {
+        worker();
+    } else {
+        std::vector<std::thread> threads;
+        threads.reserve(numThreads);
+        for (int t = 0; t < numThreads; ++t) threads.emplace_back(worker);
+        for (std::thread& t : threads) t.join();
+    }
+    
+    if (changed) {
+        const int n = std::min(numDirty, std::max(0, maxChanged));
+        std::copy(dirty.begin(), dirty.begin() + n, changed);
+    }
+    return numDirty;
+}
+
+int bindingGeometryCacheGetTile(const BindingGeometryCache* cache, int tileIndex, BindingTileGeometry* geom)
+{
+    if (!cache || !geom || tileIndex < 0 || tileIndex >= (int)cache->tiles.size()) return 0;
+    const CachedTileGeometry& t = cache->tiles[tileIndex];
+    geom->tileRef = t.tileRef;
+    geom->x = t.x;
+    geom->y = t.y;
+    geom->layer = t.layer;
+    geom->nverts = (int)t.positions.size() / 4;
+    geom->ntris = (int)t.areas.size();
+    geom->positions = t.positions.data();
+    geom->normals = t.normals.data();
+    geom->indices = t.indices.data();
+    geom->areas = t.areas.data();
+    geom->flags = t.flags.data();
+    geom->polys = t.polys.data();
+    return 1;
+}
+
+void bindingGeometryCacheGetTotals(const BindingGeometryCache* cache, int* nverts, int* ntris)
+{
+    int v = 0, n = 0;
+    if (cache) {
+        for (const CachedTileGeometry& t : cache->tiles) {
+            v += (int)t.positions.size() / 4;
+            n += (int)t.areas.size();
+        }
+    }
+    if (nverts) *nverts = v;
+    if (ntris) *ntris = n;
+}
@@ -0,0 +1,58 @@
+// BuildContext.cpp
+// Recast context that records per-stage build timings
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "BuildContext.h"
+
+#include <chrono>
+
+static inline int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+BuildContext::BuildContext() :
+    rcContext(true)
+{
+    doResetTimers();
+}
+
+void BuildContext::doResetTimers()
+{
+    for (int i = 0; i < RC_MAX_TIMERS; ++i) {
+        m_startNs[i] = -1;
+        m_accNs[i] = 0;
+    }
+}
+
+void BuildContext::doStartTimer(const rcTimerLabel label)
+{
+    m_startNs[label] = nowNs();
+}
+
+void BuildContext::doStopTimer(const rcTimerLabel label)
+{
+    if (m_startNs[label] < 0) return;
+    m_accNs[label] += nowNs() - m_startNs[label];
+    m_startNs[label] = -1;
+}
+
+int BuildContext::doGetAccumulatedTime(const rcTimerLabel label) const
+{
+    // Microseconds, like the Recast samples
+    return (int)(m_accNs[label] / 1000);
+}
+
+double BuildContext::getAccumulatedMs(rcTimerLabel label) const
+{
+    return m_accNs[label] / 1.0e6;
+}
+
+void BuildContext::addAccumulatedMs(double* ms) const
+{
+    for (int i = 0; i < RC_MAX_TIMERS; ++i)
+        ms[i] += m_accNs[i] / 1.0e6;
+}
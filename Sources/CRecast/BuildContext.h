@@ -0,0 +1,38 @@
+// BuildContext.h
+// Recast context that records per-stage build timings
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef BUILDCONTEXT_H
+#define BUILDCONTEXT_H
+
+#include "Recast.h"
+
+#include <stdint.h>
+
+// rcContext whose timers accumulate wall-clock time per rcTimerLabel.
+// Logging is left to the base class. Each build thread uses its own context.
+class BuildContext : public rcContext
+{
+public:
+    BuildContext();
+
+    // Accumulated time of label, in milliseconds
+    double getAccumulatedMs(rcTimerLabel label) const;
+
+    // Adds every label's accumulated time to ms[0 .. RC_MAX_TIMERS-1]
+    void addAccumulatedMs(double* ms) const;
+
+protected:
+    virtual void doResetTimers();
+    virtual void doStartTimer(const rcTimerLabel label);
+    virtual void doStopTimer(const rcTimerLabel label);
+    virtual int doGetAccumulatedTime(const rcTimerLabel label) const;
+
+private:
+    int64_t m_startNs[RC_MAX_TIMERS];   // -1 while the timer is stopped
+    int64_t m_accNs[RC_MAX_TIMERS];
+};
+
+#endif // BUILDCONTEXT_H
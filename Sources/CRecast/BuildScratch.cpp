@@ -0,0 +1,211 @@
+// BuildScratch.cpp
+// Per-thread arena for the Recast allocations of a tile build
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "BuildScratch.h"
+#include "RecastAlloc.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <mutex>
+
+// First block of a fresh arena
+static const size_t SCRATCH_INITIAL_BLOCK = 1 << 20;
+
+// An arena grown past this is given back to the system on reset
+static const size_t SCRATCH_MAX_RETAINED = 64 << 20;
+
+static const size_t SCRATCH_ALIGN = 16;
+
+static inline size_t alignUp(size_t v)
+{
+    return (v + SCRATCH_ALIGN - 1) & ~(SCRATCH_ALIGN - 1);
+}
+
+// Precedes every allocation, so frees can unwind in LIFO order
+struct ScratchHeader
+{
+    unsigned char* prevLast;
+    size_t prevTop;
+};
+
+static const size_t SCRATCH_HEADER_SIZE = (sizeof(ScratchHeader) + SCRATCH_ALIGN - 1) & ~(SCRATCH_ALIGN - 1);
+
+// Blocks come from malloc, which is at least 16-byte aligned on the platforms
+// we ship; the block header is padded so the data keeps that alignment.
+struct BuildScratch::Block
+{
+    Block* next;
+    size_t size;            // Usable bytes after the padded header
+    size_t top;             // Offset of the first free byte
+
+    unsigned char* base() { return (unsigned char*)this + headerSize(); }
+    const unsigned char* base() const { return (const unsigned char*)this + headerSize(); }
+
+    static size_t headerSize() { return (sizeof(Block) + SCRATCH_ALIGN - 1) & ~(SCRATCH_ALIGN - 1); }
+};
+
+BuildScratch::BuildScratch() :
+    m_blocks(0),
+    m_capacity(0),
+    m_used(0),
+    m_highWater(0),
+    m_last(0)
+{
+}
+
+BuildScratch::~BuildScratch()
+{
+    while (m_blocks) {
+        Block* next = m_blocks->next;
+        ::free(m_blocks);
+        m_blocks = next;
+    }
+}
+
+bool BuildScratch::addBlock(size_t minSize)
+{
+    size_t size = m_capacity > 0 ? m_capacity * 2 : SCRATCH_INITIAL_BLOCK;
+    if (size < minSize) size = alignUp(minSize);
+
+    void* mem = malloc(Block::headerSize() + size);
+    if (!mem) return false;
+
+    Block* block = (Block*)mem;
+    block->next = m_blocks;
+    block->size = size;
+    block->top = 0;
+    m_blocks = block;
+    m_capacity += size;
+    return true;
+}
+
+void* BuildScratch::alloc(size_t size)
+{
+    const size_t need = SCRATCH_HEADER_SIZE + alignUp(size);
+
+    if (!m_blocks || m_blocks->top + need > m_blocks->size) {
+        if (!addBlock(need)) return 0;
+    }
+
+    Block* block = m_blocks;
+    unsigned char* at = block->base() + block->top;
+
+    ScratchHeader* header = (ScratchHeader*)at;
+    header->prevLast = m_last;
+    header->prevTop = block->top;
+
+    block->top += need;
+    m_used += need;
+    if (m_used > m_highWater) m_highWater = m_used;
+
+    m_last = at + SCRATCH_HEADER_SIZE;
+    return m_last;
+}
+
+bool BuildScratch::owns(const void* ptr) const
+{
+    const unsigned char* p = (const unsigned char*)ptr;
+    for (const Block* block = m_blocks; block; block = block->next) {
+        if (p >= block->base() && p < block->base() + block->size)
+            return true;
+    }
+    return false;
+}
+
+bool BuildScratch::free(void* ptr)
+{
+    if (!owns(ptr)) return false;
+
+    // Only the newest allocation in the head block can be given back
+    if (ptr == m_last) {
+        const ScratchHeader* header = (const ScratchHeader*)((unsigned char*)ptr - SCRATCH_HEADER_SIZE);
+        Block* block = m_blocks;
+        m_used -= block->top - header->prevTop;
+        block->top = header->prevTop;
+
+        unsigned char* prev = header->prevLast;
+        m_last = (prev && prev >= block->base() && prev < block->base() + block->size) ? prev : 0;
+    }
+    return true;
+}
+
+void BuildScratch::reset()
+{
+    m_last = 0;
+    m_used = 0;
+
+    if (!m_blocks) return;
+
+    // The tile outgrew one block: replace the chain with a single block that
+    // fits it, or release everything if it got too large to keep around.
+    if (m_blocks->next || m_capacity > SCRATCH_MAX_RETAINED) {
+        const size_t capacity = m_capacity;
+        while (m_blocks) {
+            Block* next = m_blocks->next;
+            ::free(m_blocks);
+            m_blocks = next;
+        }
+        m_capacity = 0;
+        if (capacity <= SCRATCH_MAX_RETAINED)
+            addBlock(capacity);
+        return;
+    }
+
+    m_blocks->top = 0;
+}
+
+// ================================================
+//       Recast allocator hooks
+// ================================================
+
+static thread_local BuildScratch* tlsScratch = 0;
+
+// The allocator installed before the hooks, which they hand everything to
+// outside a scope
+static rcAllocFunc* sPrevAlloc = 0;
+static rcFreeFunc* sPrevFree = 0;
+
+static void* scratchAlloc(size_t size, rcAllocHint hint)
+{
+    // Inside a tile scope every Recast allocation is tile-lived, whatever
+    // its hint: the only output that outlives the tile is the Detour data,
+    // which comes from dtAlloc.
+    if (BuildScratch* scratch = tlsScratch) {
+        if (void* p = scratch->alloc(size))
+            return p;
+    }
+    return sPrevAlloc(size, hint);
+}
+
+static void scratchFree(void* ptr)
+{
+    if (BuildScratch* scratch = tlsScratch) {
+        if (scratch->free(ptr))
+            return;
+    }
+    sPrevFree(ptr);
+}
+
+static std::once_flag sInstallScratchAllocator;
+
+BuildScratchScope::BuildScratchScope(BuildScratch* scratch) :
+    m_scratch(scratch)
+{
+    // Outside a scope the hooks hand on to the allocator they replace, so
+    // memory it gave out before keeps going back to it and installing them
+    // once for the whole process is safe.
+    std::call_once(sInstallScratchAllocator, []() {
+        rcAllocGetCustom(&sPrevAlloc, &sPrevFree);
+        rcAllocSetCustom(scratchAlloc, scratchFree);
+    });
+    tlsScratch = m_scratch;
+}
+
+BuildScratchScope::~BuildScratchScope()
+{
+    tlsScratch = 0;
+    if (m_scratch) m_scratch->reset();
+}
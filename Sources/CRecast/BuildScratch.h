@@ -0,0 +1,77 @@
+// BuildScratch.h
+// Per-thread arena for the Recast allocations of a tile build
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef BUILDSCRATCH_H
+#define BUILDSCRATCH_H
+
+#include <stddef.h>
+
+// Bump allocator that backs every rcAlloc made while one tile is built.
+//
+// Everything Recast allocates for a tile (heightfield, compact heightfield,
+// contours, poly mesh, detail mesh and all RC_ALLOC_TEMP buffers) is freed
+// before the tile's Detour data is produced, so the whole arena can be reset
+// between tiles. The next tile then reuses the same, already faulted-in pages
+// instead of going through malloc/free for each structure.
+//
+// Frees are no-ops, except that the most recent allocations are popped in
+// LIFO order, which keeps scoped temp buffers from piling up.
+//
+// A BuildScratch belongs to the thread that creates it; use one per worker.
+class BuildScratch
+{
+public:
+    BuildScratch();
+    ~BuildScratch();
+
+    void* alloc(size_t size);
+
+    // Returns false if ptr was not allocated from this arena.
+    bool free(void* ptr);
+
+    // Releases all allocations. Keeps one block sized for the high-water mark.
+    void reset();
+
+    size_t highWater() const { return m_highWater; }
+
+private:
+    struct Block;
+
+    bool addBlock(size_t minSize);
+    bool owns(const void* ptr) const;
+
+    Block* m_blocks;        // Newest first; allocations come from the head
+    size_t m_capacity;      // Sum of all block sizes
+    size_t m_used;          // Bytes used across blocks, including headers
+    size_t m_highWater;
+    unsigned char* m_last;  // Most recent live allocation, for LIFO frees
+
+    // Explicitly-disabled copy constructor and copy assignment operator.
+    BuildScratch(const BuildScratch&);
+    BuildScratch& operator=(const BuildScratch&);
+};
+
+// Makes scratch the target of rcAlloc on this thread while in scope and
+// resets it on exit. Installs the dispatching Recast allocator the first time
+// it is used; outside a scope, and for blocks that are not the arena's,
+// rcAlloc/rcFree keep using the allocator that was installed before. A host
+// allocator must therefore be set with rcAllocSetCustom before the first
+// build, not during or after it.
+class BuildScratchScope
+{
+public:
+    explicit BuildScratchScope(BuildScratch* scratch);
+    ~BuildScratchScope();
+
+private:
+    BuildScratch* m_scratch;
+
+    // Explicitly-disabled copy constructor and copy assignment operator.
+    BuildScratchScope(const BuildScratchScope&);
+    BuildScratchScope& operator=(const BuildScratchScope&);
+};
+
+#endif // BUILDSCRATCH_H
@@ -0,0 +1,252 @@
+// ChunkyTriMesh.cpp
+// Spatial index over input triangles for tiled navmesh builds
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "ChunkyTriMesh.h"
+
+#include <float.h>
+#include <algorithm>
+#include <new>
+
+struct BoundsItem
+{
+    float bmin[2];
+    float bmax[2];
+    int i;
+};
+
+// Orders items by their bounds' minimum along one axis; ties fall back to the
+// triangle id so the tree layout is fully deterministic.
+struct CompareItemAxis
+{
+    int axis;
+    explicit CompareItemAxis(int a) : axis(a) {}
+    bool operator()(const BoundsItem& a, const BoundsItem& b) const
+    {
+        if (a.bmin[axis] != b.bmin[axis])
+            return a.bmin[axis] < b.bmin[axis];
+        return a.i < b.i;
+    }
+};
+
+static void calcExtends(const BoundsItem* items, const int imin, const int imax,
+                        float* bmin, float* bmax)
+{
+    bmin[0] = items[imin].bmin[0];
+    bmin[1] = items[imin].bmin[1];
+    bmax[0] = items[imin].bmax[0];
+    bmax[1] = items[imin].bmax[1];
+
+    for (int i = imin + 1; i < imax; ++i)
+    {
+        const BoundsItem& it = items[i];
+        if (it.bmin[0] < bmin[0]) bmin[0] = it.bmin[0];
+        if (it.bmin[1] < bmin[1]) bmin[1] = it.bmin[1];
+        if (it.bmax[0] > bmax[0]) bmax[0] = it.bmax[0];
+        if (it.bmax[1] > bmax[1]) bmax[1] = it.bmax[1];
+    }
+}
+
+inline int longestAxis(float x, float y)
+{
+    return y > x ? 1 : 0;
+}
+
+static void subdivide(BoundsItem* items, int imin, int imax, int trisPerChunk,
+                      int& curNode, rcChunkyTriMeshNode* nodes, const int maxNodes,
+                      int& curTri, int* outTriIds)
+{
+    const int inum = imax - imin;
+    const int icur = curNode;
+
+    if (curNode >= maxNodes)
+        return;
+
+    rcChunkyTriMeshNode& node = nodes[curNode++];
+
+    if (inum <= trisPerChunk)
+    {
+        // Leaf
+        calcExtends(items, imin, imax, node.bmin, node.bmax);
+
+        node.i = curTri;
+        node.n = inum;
+
+        for (int i = imin; i < imax; ++i)
+            outTriIds[curTri++] = items[i].i;
+    }
+    else
+    {
+        // Split along the longest axis at the median
+        calcExtends(items, imin, imax, node.bmin, node.bmax);
+
+        const int axis = longestAxis(node.bmax[0] - node.bmin[0],
+                                     node.bmax[1] - node.bmin[1]);
+        std::sort(items + imin, items + imax, CompareItemAxis(axis));
+
+        const int isplit = imin + inum / 2;
+
+        subdivide(items, imin, isplit, trisPerChunk, curNode, nodes, maxNodes, curTri, outTriIds);
+        subdivide(items, isplit, imax, trisPerChunk, curNode, nodes, maxNodes, curTri, outTriIds);
+
+        const int iescape = curNode - icur;
+        // Negative index means escape.
+        node.i = -iescape;
+        node.n = 0;
+    }
+}
+
+rcChunkyTriMesh::rcChunkyTriMesh() :
+    nodes(0),
+    nnodes(0),
+    triIds(0),
+    ntris(0),
+    maxTrisPerChunk(0)
+{
+}
+
+rcChunkyTriMesh::~rcChunkyTriMesh()
+{
+    delete[] nodes;
+    delete[] triIds;
+}
+
+bool rcCreateChunkyTriMesh(const float* verts, const int* tris, int ntris,
+                           int trisPerChunk, rcChunkyTriMesh* cm)
+{
+    if (!cm || !verts || !tris || ntris <= 0 || trisPerChunk <= 0)
+        return false;
+
+    const int nchunks = (ntris + trisPerChunk - 1) / trisPerChunk;
+
+    cm->nodes = new (std::nothrow) rcChunkyTriMeshNode[nchunks * 4];
+    if (!cm->nodes)
+        return false;
+
+    cm->triIds = new (std::nothrow) int[ntris];
+    if (!cm->triIds)
+        return false;
+
+    cm->ntris = ntris;
+
+    // Build tree
+    BoundsItem* items = new (std::nothrow) BoundsItem[ntris];
+    if (!items)
+        return false;
+
+    for (int i = 0; i < ntris; ++i)
+    {
+        const int* t = &tris[i * 3];
+        BoundsItem& it = items[i];
+        it.i = i;
+        // Calc triangle xz bounds.
+        it.bmin[0] = it.bmax[0] = verts[t[0] * 3 + 0];
+        it.bmin[1] = it.bmax[1] = verts[t[0] * 3 + 2];
+        for (int j = 1; j < 3; ++j)
+        {
+            const float* v = &verts[t[j] * 3];
+            if (v[0] < it.bmin[0]) it.bmin[0] = v[0];
+            if (v[2] < it.bmin[1]) it.bmin[1] = v[2];
+
+            if (v[0] > it.bmax[0]) it.bmax[0] = v[0];
+            if (v[2] > it.bmax[1]) it.bmax[1] = v[2];
+        }
+    }
+
+    int curTri = 0;
+    int curNode = 0;
+    subdivide(items, 0, ntris, trisPerChunk, curNode, cm->nodes, nchunks * 4, curTri, cm->triIds);
+
+    delete[] items;
+
+    cm->nnodes = curNode;
+
+    // Calc max tris per node.
+    cm->maxTrisPerChunk = 0;
+    for (int i = 0; i < cm->nnodes; ++i)
+    {
+        rcChunkyTriMeshNode& node = cm->nodes[i];
+        const bool isLeaf = node.i >= 0;
+        if (!isLeaf) continue;
+        if (node.n > cm->maxTrisPerChunk)
+            cm->maxTrisPerChunk = node.n;
+    }
+
+    return curTri == ntris;
+}
+
+inline bool checkOverlapRect(const float amin[2], const float amax[2],
+                             const float bmin[2], const float bmax[2])
+{
+    bool overlap = true;
+    overlap = (amin[0] > bmax[0] || amax[0] < bmin[0]) ? false : overlap;
+    overlap = (amin[1] > bmax[1] || amax[1] < bmin[1]) ? false : overlap;
+    return overlap;
+}
+
+int rcGetChunksOverlappingRect(const rcChunkyTriMesh* cm,
+                               const float bmin[2], const float bmax[2],
+                               int* ids, int maxIds)
+{
+    // Traverse tree
+    int i = 0;
+    int n = 0;
+    while (i < cm->nnodes)
+    {
+        const rcChunkyTriMeshNode* node = &cm->nodes[i];
+        const bool overlap = checkOverlapRect(bmin, bmax, node->bmin, node->bmax);
+        const bool isLeafNode = node->i >= 0;
+
+        if (isLeafNode && overlap)
+        {
+            if (n < maxIds)
+            {
+                ids[n] = i;
+                n++;
+            }
+        }
+
+        if (overlap || isLeafNode)
+            i++;
+        else
+        {
+            const int escapeIndex = -node->i;
+            i += escapeIndex;
+        }
+    }
+
+    return n;
+}
+
+int rcGatherTrianglesOverlappingRect(const rcChunkyTriMesh* cm,
+                                     const float bmin[2], const float bmax[2],
+                                     int* triIds)
+{
+    int i = 0;
+    int n = 0;
+    while (i < cm->nnodes)
+    {
+        const rcChunkyTriMeshNode* node = &cm->nodes[i];
+        const bool overlap = checkOverlapRect(bmin, bmax, node->bmin, node->bmax);
+        const bool isLeafNode = node->i >= 0;
+
+        if (isLeafNode && overlap)
+        {
+            for (int j = 0; j < node->n; ++j)
+                triIds[n++] = cm->triIds[node->i + j];
+        }
+
+        if (overlap || isLeafNode)
+            i++;
+        else
+            i += -node->i;
+    }
+
+    // Restore input order, so rasterization sees triangles exactly as it
+    // would without the index and the resulting spans are identical.
+    std::sort(triIds, triIds + n);
+
+    return n;
+}
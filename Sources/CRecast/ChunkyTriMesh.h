@@ -0,0 +1,60 @@
+// ChunkyTriMesh.h
+// Spatial index over input triangles for tiled navmesh builds
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef CHUNKYTRIMESH_H
+#define CHUNKYTRIMESH_H
+
+// Node of the xz-plane AABB tree.
+// Leaves have i >= 0 and reference n triangle ids starting at triIds[i].
+// Interior nodes have i < 0, and -i is the escape offset to the next sibling subtree.
+struct rcChunkyTriMeshNode
+{
+    float bmin[2];          // [x, z]
+    float bmax[2];          // [x, z]
+    int i;
+    int n;
+};
+
+// AABB tree that groups input triangles into spatially coherent chunks, so a
+// tile only has to look at the triangles that can overlap its bounds.
+// The tree stores triangle *ids* into the caller's index buffer; it does not
+// copy or reorder the geometry itself.
+struct rcChunkyTriMesh
+{
+    rcChunkyTriMesh();
+    ~rcChunkyTriMesh();
+
+    rcChunkyTriMeshNode* nodes;
+    int nnodes;
+    int* triIds;            // Triangle ids grouped by leaf
+    int ntris;
+    int maxTrisPerChunk;
+
+private:
+    // Explicitly-disabled copy constructor and copy assignment operator.
+    rcChunkyTriMesh(const rcChunkyTriMesh&);
+    rcChunkyTriMesh& operator=(const rcChunkyTriMesh&);
+};
+
+// Builds the tree over ntris triangles, with at most trisPerChunk triangles per leaf.
+// Returns false if memory could not be allocated.
+bool rcCreateChunkyTriMesh(const float* verts, const int* tris, int ntris,
+                           int trisPerChunk, rcChunkyTriMesh* cm);
+
+// Collects the ids of leaf nodes whose bounds overlap the xz rectangle [bmin, bmax].
+// Returns the number of ids written to ids (at most maxIds).
+int rcGetChunksOverlappingRect(const rcChunkyTriMesh* cm,
+                               const float bmin[2], const float bmax[2],
+                               int* ids, int maxIds);
+
+// Collects the ids of every triangle in chunks overlapping the xz rectangle
+// [bmin, bmax], sorted ascending so callers process them in input order.
+// triIds must hold cm->ntris entries. Returns the number of ids written.
+int rcGatherTrianglesOverlappingRect(const rcChunkyTriMesh* cm,
+                                     const float bmin[2], const float bmax[2],
+                                     int* triIds);
+
+#endif // CHUNKYTRIMESH_H
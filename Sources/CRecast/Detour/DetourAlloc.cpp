@@ -18,6 +18,7 @@
 
 #include <stdlib.h>
 #include "DetourAlloc.h"
+#include "DetourMemory.h"
 
 static void *dtAllocDefault(size_t size, dtAllocHint)
 {
@@ -40,11 +41,16 @@ void dtAllocSetCustom(dtAllocFunc *allocFunc, dtFreeFunc *freeFunc)
 
 void* dtAlloc(size_t size, dtAllocHint hint)
 {
-	return sAllocFunc(size, hint);
+	void* ptr = sAllocFunc(size, hint);
+	dtMemoryTrackAlloc(ptr, size, hint == DT_ALLOC_TEMP ? DT_MEMORY_DETOUR_TEMP : DT_MEMORY_DETOUR_PERM);
+	return ptr;
 }
 
 void dtFree(void* ptr)
 {
 	if (ptr)
+	{
+		dtMemoryTrackFree(ptr);
 		sFreeFunc(ptr);
+	}
 }
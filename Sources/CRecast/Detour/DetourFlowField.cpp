@@ -0,0 +1,491 @@
+// DetourFlowField.cpp
+// Shared-goal flow fields: the next polygon toward one goal from every polygon
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "DetourFlowField.h"
+#include "DetourAlloc.h"
+#include "DetourAssert.h"
+#include "DetourCommon.h"
+#include <float.h>
+#include <string.h>
+#include <new>
+
+dtFlowField* dtAllocFlowField()
+{
+	void* mem = dtAlloc(sizeof(dtFlowField), DT_ALLOC_PERM);
+	if (!mem) return 0;
+	return new(mem) dtFlowField;
+}
+
+void dtFreeFlowField(dtFlowField* field)
+{
+	if (!field) return;
+	field->~dtFlowField();
+	dtFree(field);
+}
+
+namespace
+{
+	// The link of @p poly to @p to, or null.
+	const dtLink* findLink(const dtMeshTile* tile, const dtPoly* poly, const dtPolyRef to)
+	{
+		for (unsigned int i = poly->firstLink; i != DT_NULL_LINK; i = tile->links[i].next)
+		{
+			if (tile->links[i].ref == to)
+				return &tile->links[i];
+		}
+		return 0;
+	}
+
+	// Where a path from @p from into @p to crosses between them: the middle
+	// of the shared part of the edge, or the end point of an off-mesh
+	// connection, as dtNavMeshQuery::getEdgeMidPoint finds it.
+	void portalPoint(const dtMeshTile* fromTile, const dtPoly* from, const dtLink* fromLink,
+					 const dtMeshTile* toTile, const dtPoly* to, const dtLink* toLink, float* pos)
+	{
+		if (from->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+		{
+			dtVcopy(pos, &fromTile->verts[from->verts[fromLink->edge]*3]);
+			return;
+		}
+		if (to->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+		{
+			dtVcopy(pos, &toTile->verts[to->verts[toLink->edge]*3]);
+			return;
+		}
+
+		const float* va = &fromTile->verts[from->verts[fromLink->edge]*3];
+		const float* vb = &fromTile->verts[from->verts[(fromLink->edge+1) % from->vertCount]*3];
+		if (fromLink->side != 0xff && (fromLink->bmin != 0 || fromLink->bmax != 255))
+		{
+			const float s = 1.0f/255.0f;
+			float left[3], right[3];
+			dtVlerp(left, va, vb, fromLink->bmin*s);
+			dtVlerp(right, va, vb, fromLink->bmax*s);
+			dtVlerp(pos, left, right, 0.5f);
+		}
+		else
+		{
+			dtVlerp(pos, va, vb, 0.5f);
+		}
+	}
+
+	inline bool heapLess(const float ca, const dtPolyRef ra, const float cb, const dtPolyRef rb)
+	{
+		return ca < cb || (ca == cb && ra < rb);
+	}
+}
+
+dtFlowField::dtFlowField() :
+	m_nav(0),
+	m_goalRef(0),
+	m_maxTiles(0),
+	m_front(0),
+	m_searching(false),
+	m_open(0),
+	m_openCount(0),
+	m_openCapacity(0)
+{
+	dtVset(m_goalPos, 0, 0, 0);
+	m_fields[0] = m_fields[1] = 0;
+	m_reached[0] = m_reached[1] = 0;
+}
+
+dtFlowField::~dtFlowField()
+{
+	purge();
+}
+
+void dtFlowField::freeBuffer(const int buffer)
+{
+	TileField* fields = m_fields[buffer];
+	if (!fields)
+		return;
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		dtFree(fields[i].next);
+		dtFree(fields[i].cost);
+		dtFree(fields[i].pos);
+		memset(&fields[i], 0, sizeof(TileField));
+	}
+	m_reached[buffer] = 0;
+}
+
+void dtFlowField::purge()
+{
+	for (int b = 0; b < 2; ++b)
+	{
+		freeBuffer(b);
+		dtFree(m_fields[b]);
+		m_fields[b] = 0;
+	}
+	dtFree(m_open);
+	m_open = 0;
+	m_openCount = 0;
+	m_openCapacity = 0;
+	m_maxTiles = 0;
+	m_goalRef = 0;
+	m_searching = false;
+}
+
+dtStatus dtFlowField::init(const dtNavMesh* nav, const dtQueryFilter* filter)
+{
+	purge();
+	if (!nav || !filter)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	m_nav = nav;
+	m_filter = *filter;
+	m_maxTiles = nav->getMaxTiles();
+	for (int b = 0; b < 2; ++b)
+	{
+		m_fields[b] = (TileField*)dtAlloc(sizeof(TileField)*m_maxTiles, DT_ALLOC_PERM);
+		if (!m_fields[b])
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+		memset(m_fields[b], 0, sizeof(TileField)*m_maxTiles);
+	}
+	m_front = 0;
+	return DT_SUCCESS;
+}
+
+dtStatus dtFlowField::setGoal(dtPolyRef goalRef, const float* goalPos)
+{
+	if (!m_nav)
+		return DT_FAILURE;
+	if (!goalPos || !dtVisfinite(goalPos) || !m_nav->isValidPolyRef(goalRef))
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	if (goalRef != m_goalRef)
+		freeBuffer(m_front);
+	m_goalRef = goalRef;
+	dtVcopy(m_goalPos, goalPos);
+	if (!beginSearch())
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	return DT_SUCCESS | DT_IN_PROGRESS;
+}
+
+/// @par
+///
+/// Entries for every tile the navmesh has now are set up in the buffer not
+/// in use, keeping its arrays for tiles with as many polygons as before.
+bool dtFlowField::beginSearch()
+{
+	const int back = 1 - m_front;
+	TileField* fields = m_fields[back];
+	m_searching = false;
+	m_reached[back] = 0;
+	m_openCount = 0;
+
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const dtMeshTile* tile = m_nav->getTile(i);
+		TileField& f = fields[i];
+		const int polyCount = (tile->header) ? tile->header->polyCount : 0;
+		if (f.polyCount != polyCount)
+		{
+			dtFree(f.next);
+			dtFree(f.cost);
+			dtFree(f.pos);
+			memset(&f, 0, sizeof(TileField));
+			if (polyCount > 0)
+			{
+				f.next = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*polyCount, DT_ALLOC_PERM);
+				f.cost = (float*)dtAlloc(sizeof(float)*polyCount, DT_ALLOC_PERM);
+				f.polyCount = polyCount;
+			}
+		}
+		if (polyCount > 0 && !f.pos)
+			f.pos = (float*)dtAlloc(sizeof(float)*3*polyCount, DT_ALLOC_PERM);
+		if (polyCount > 0 && (!f.next || !f.cost || !f.pos))
+		{
+			freeBuffer(back);
+			return false;
+		}
+		f.salt = polyCount > 0 ? tile->salt : 0;
+		for (int j = 0; j < polyCount; ++j)
+		{
+			f.next[j] = 0;
+			f.cost[j] = FLT_MAX;
+		}
+	}
+
+	const dtMeshTile* tile;
+	const dtPoly* poly;
+	int index;
+	if (!currentEntry(fields, m_goalRef, &tile, &poly, &index))
+		return true;
+	TileField& goal = fields[m_nav->decodePolyIdTile(m_goalRef)];
+	goal.cost[index] = 0;
+	dtVcopy(&goal.pos[index*3], m_goalPos);
+	if (!pushOpen(0, m_goalRef))
+		return false;
+	m_searching = true;
+	return true;
+}
+
+void dtFlowField::finishSearch()
+{
+	m_front = 1 - m_front;
+	m_searching = false;
+	m_openCount = 0;
+
+	// Node positions are only needed while searching.
+	TileField* fields = m_fields[m_front];
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		dtFree(fields[i].pos);
+		fields[i].pos = 0;
+	}
+}
+
+dtStatus dtFlowField::update(const int maxIter, int* doneIters)
+{
+	if (doneIters)
+		*doneIters = 0;
+	if (!m_nav || !m_goalRef)
+		return DT_FAILURE;
+
+	if (!m_searching)
+	{
+		if (!tilesChanged())
+			return DT_SUCCESS;
+		if (!m_nav->isValidPolyRef(m_goalRef))
+			return DT_FAILURE | DT_INVALID_PARAM;
+		if (!beginSearch())
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+
+	const int back = 1 - m_front;
+	TileField* fields = m_fields[back];
+	int iter = 0;
+	while (iter < maxIter && m_openCount > 0)
+	{
+		const HeapItem item = popOpen();
+		const dtMeshTile* curTile;
+		const dtPoly* curPoly;
+		int curIndex;
+		if (!currentEntry(fields, item.ref, &curTile, &curPoly, &curIndex))
+			continue;
+		TileField& cur = fields[m_nav->decodePolyIdTile(item.ref)];
+		if (item.cost > cur.cost[curIndex])
+			continue;
+		iter++;
+		m_reached[back]++;
+
+		const float* curPos = &cur.pos[curIndex*3];
+		const dtPolyRef curNext = cur.next[curIndex];
+
+		for (unsigned int i = curPoly->firstLink; i != DT_NULL_LINK; i = curTile->links[i].next)
+		{
+			const dtLink* link = &curTile->links[i];
+			const dtPolyRef neiRef = link->ref;
+			const dtMeshTile* neiTile;
+			const dtPoly* neiPoly;
+			int neiIndex;
+			if (!neiRef || neiRef == curNext)
+				continue;
+			if (!currentEntry(fields, neiRef, &neiTile, &neiPoly, &neiIndex))
+				continue;
+			// dtQueryFilter::passFilter, which DetourNavMeshQuery.cpp keeps inline
+			if ((neiPoly->flags & m_filter.getIncludeFlags()) == 0 || (neiPoly->flags & m_filter.getExcludeFlags()) != 0)
+				continue;
+
+			// Paths go from the neighbour into this polygon, which only
+			// off-mesh connections may not allow.
+			const dtLink* toCur = findLink(neiTile, neiPoly, item.ref);
+			if (!toCur)
+				continue;
+
+			float neiPos[3];
+			portalPoint(neiTile, neiPoly, toCur, curTile, curPoly, link, neiPos);
+			// Crossing this polygon from the neighbour, as dtQueryFilter::getCost prices it
+			const float cost = item.cost + dtVdist(neiPos, curPos)*m_filter.getAreaCost(curPoly->getArea());
+			TileField& nei = fields[m_nav->decodePolyIdTile(neiRef)];
+			if (cost >= nei.cost[neiIndex])
+				continue;
+			nei.cost[neiIndex] = cost;
+			nei.next[neiIndex] = item.ref;
+			dtVcopy(&nei.pos[neiIndex*3], neiPos);
+			if (!pushOpen(cost, neiRef))
+			{
+				m_searching = false;
+				m_openCount = 0;
+				if (doneIters)
+					*doneIters = iter;
+				return DT_FAILURE | DT_OUT_OF_MEMORY;
+			}
+		}
+	}
+
+	if (doneIters)
+		*doneIters = iter;
+	if (m_openCount > 0)
+		return DT_SUCCESS | DT_IN_PROGRESS;
+	finishSearch();
+	return DT_SUCCESS;
+}
+
+bool dtFlowField::getHop(dtPolyRef ref, dtPolyRef* next, float* cost) const
+{
+	const dtMeshTile* tile;
+	const dtPoly* poly;
+	int index;
+	if (!m_fields[m_front] || !currentEntry(m_fields[m_front], ref, &tile, &poly, &index))
+		return false;
+	const TileField& f = m_fields[m_front][m_nav->decodePolyIdTile(ref)];
+	if (f.cost[index] == FLT_MAX)
+		return false;
+	if (next)
+		*next = f.next[index];
+	if (cost)
+		*cost = f.cost[index];
+	return true;
+}
+
+dtStatus dtFlowField::getPath(dtPolyRef startRef, dtPolyRef* path, int* pathCount, const int maxPath) const
+{
+	if (!pathCount)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	*pathCount = 0;
+	if (!path || maxPath < 1)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	dtPolyRef ref = startRef;
+	dtPolyRef next;
+	if (!getHop(ref, &next, 0))
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	int n = 0;
+	for (;;)
+	{
+		path[n++] = ref;
+		if (!next)
+			break;
+		if (n >= maxPath)
+		{
+			*pathCount = n;
+			return DT_SUCCESS | DT_BUFFER_TOO_SMALL;
+		}
+		ref = next;
+		if (!getHop(ref, &next, 0))
+		{
+			*pathCount = n;
+			return DT_SUCCESS | DT_PARTIAL_RESULT;
+		}
+	}
+	*pathCount = n;
+	return DT_SUCCESS;
+}
+
+bool dtFlowField::currentEntry(const TileField* fields, dtPolyRef ref, const dtMeshTile** tile,
+							   const dtPoly** poly, int* index) const
+{
+	unsigned int salt, it, ip;
+	m_nav->decodePolyId(ref, salt, it, ip);
+	if ((int)it >= m_maxTiles)
+		return false;
+	const TileField& f = fields[it];
+	if (!f.salt || f.salt != salt || (int)ip >= f.polyCount)
+		return false;
+	const dtMeshTile* t = m_nav->getTile((int)it);
+	if (t->salt != salt || !t->header)
+		return false;
+	*tile = t;
+	*poly = &t->polys[ip];
+	*index = (int)ip;
+	return true;
+}
+
+bool dtFlowField::tilesChanged() const
+{
+	return getStaleTileCount() > 0;
+}
+
+int dtFlowField::getStaleTileCount() const
+{
+	if (!m_nav || !m_fields[m_front])
+		return 0;
+	const TileField* fields = m_fields[m_front];
+	int count = 0;
+	for (int i = 0; i < m_maxTiles; ++i)
+	{
+		const dtMeshTile* tile = m_nav->getTile(i);
+		const unsigned int salt = (tile->header && tile->header->polyCount > 0) ? tile->salt : 0;
+		if (salt != fields[i].salt)
+			count++;
+	}
+	return count;
+}
+
+size_t dtFlowField::getMemoryUsage() const
+{
+	size_t bytes = sizeof(*this) + sizeof(HeapItem)*m_openCapacity;
+	for (int b = 0; b < 2; ++b)
+	{
+		if (!m_fields[b])
+			continue;
+		bytes += sizeof(TileField)*m_maxTiles;
+		for (int i = 0; i < m_maxTiles; ++i)
+		{
+			const TileField& f = m_fields[b][i];
+			bytes += (sizeof(dtPolyRef) + sizeof(float))*f.polyCount;
+			if (f.pos)
+				bytes += sizeof(float)*3*f.polyCount;
+		}
+	}
+	return bytes;
+}
+
+bool dtFlowField::pushOpen(const float cost, const dtPolyRef ref)
+{
+	if (m_openCount == m_openCapacity)
+	{
+		const int capacity = m_openCapacity ? m_openCapacity*2 : 256;
+		HeapItem* open = (HeapItem*)dtAlloc(sizeof(HeapItem)*capacity, DT_ALLOC_PERM);
+		if (!open)
+			return false;
+		if (m_openCount)
+			memcpy(open, m_open, sizeof(HeapItem)*m_openCount);
+		dtFree(m_open);
+		m_open = open;
+		m_openCapacity = capacity;
+	}
+
+	int i = m_openCount++;
+	while (i > 0)
+	{
+		const int parent = (i - 1) / 2;
+		if (!heapLess(cost, ref, m_open[parent].cost, m_open[parent].ref))
+			break;
+		m_open[i] = m_open[parent];
+		i = parent;
+	}
+	m_open[i].cost = cost;
+	m_open[i].ref = ref;
+	return true;
+}
+
+dtFlowField::HeapItem dtFlowField::popOpen()
+{
+	dtAssert(m_openCount > 0);
+	const HeapItem top = m_open[0];
+	const HeapItem last = m_open[--m_openCount];
+	int i = 0;
+	for (;;)
+	{
+		int child = i*2 + 1;
+		if (child >= m_openCount)
+			break;
+		if (child + 1 < m_openCount && heapLess(m_open[child+1].cost, m_open[child+1].ref, m_open[child].cost, m_open[child].ref))
+			child++;
+		if (!heapLess(m_open[child].cost, m_open[child].ref, last.cost, last.ref))
+			break;
+		m_open[i] = m_open[child];
+		i = child;
+	}
+	if (m_openCount > 0)
+		m_open[i] = last;
+	return top;
+}
@@ -0,0 +1,941 @@
+// DetourLandmarks.cpp
+// Landmark distance tables for a tighter A* heuristic in dtNavMeshQuery
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "DetourLandmarks.h"
+#include "DetourAlloc.h"
+#include "DetourAssert.h"
+#include "DetourCommon.h"
+#include <float.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <new>
+
+dtLandmarkTable* dtAllocLandmarkTable()
+{
+	void* mem = dtAlloc(sizeof(dtLandmarkTable), DT_ALLOC_PERM);
+	if (!mem) return 0;
+	return new(mem) dtLandmarkTable;
+}
+
+void dtFreeLandmarkTable(dtLandmarkTable* table)
+{
+	if (!table) return;
+	table->~dtLandmarkTable();
+	dtFree(table);
+}
+
+namespace
+{
+	// Land polygons an end of an off-mesh connection is attached to, at most
+	static const int MAX_ATTACHED_POLYS = 4;
+
+	// Portals on one edge slot at most; an edge on a tile border with more
+	// links than that is treated as a whole
+	static const int MAX_EDGE_PORTALS = 8;
+
+	float distancePtSeg(const float* pt, const float* p, const float* q)
+	{
+		float pq[3], d[3];
+		dtVsub(pq, q, p);
+		dtVsub(d, pt, p);
+		const float len = dtVdot(pq, pq);
+		float t = len > 0.0f ? dtVdot(pq, d) / len : 0.0f;
+		t = dtClamp(t, 0.0f, 1.0f);
+		float closest[3];
+		dtVmad(closest, p, pq, t);
+		return dtVdist(pt, closest);
+	}
+
+	float distancePtBox(const float* pt, const float* bmin, const float* bmax)
+	{
+		float d[3];
+		for (int i = 0; i < 3; ++i)
+			d[i] = dtMax(0.0f, dtMax(bmin[i] - pt[i], pt[i] - bmax[i]));
+		return dtMathSqrtf(dtVdot(d, d));
+	}
+
+	// Where a search can cross an edge slot of a polygon, as getEdgeMidPoint
+	// places it: the middle of the part of the edge each link covers (the
+	// whole edge inside a tile, the clamped portal on a tile border), or an
+	// end point of an off-mesh connection.
+	struct EdgePortals
+	{
+		float pts[MAX_EDGE_PORTALS*3];
+		int count;
+		bool whole;		///< Too many portals; any point of the edge a..b.
+		float a[3];
+		float b[3];
+
+		void gather(const dtMeshTile* tile, const dtPoly* poly, const int edge)
+		{
+			count = 0;
+			whole = false;
+			dtVcopy(a, &tile->verts[poly->verts[edge]*3]);
+			if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+			{
+				dtVcopy(b, a);
+				dtVcopy(pts, a);
+				count = 1;
+				return;
+			}
+			dtVcopy(b, &tile->verts[poly->verts[(edge+1) % poly->vertCount]*3]);
+			for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+			{
+				const dtLink& link = tile->links[k];
+				if (link.edge != edge)
+					continue;
+				if (count == MAX_EDGE_PORTALS)
+				{
+					whole = true;
+					return;
+				}
+				// As dtNavMeshQuery::getPortalPoints clamps a tile border link
+				float tmin = 0.0f, tmax = 1.0f;
+				if (link.side != 0xff && (link.bmin != 0 || link.bmax != 255))
+				{
+					tmin = link.bmin / 255.0f;
+					tmax = link.bmax / 255.0f;
+				}
+				dtVlerp(&pts[count*3], a, b, (tmin + tmax)*0.5f);
+				count++;
+			}
+			if (count == 0)
+			{
+				dtVlerp(pts, a, b, 0.5f);
+				count = 1;
+			}
+		}
+
+		// Shortest distance from pt to any of the portals
+		float distance(const float* pt) const
+		{
+			if (whole)
+				return distancePtSeg(pt, a, b);
+			float d = FLT_MAX;
+			for (int i = 0; i < count; ++i)
+				d = dtMin(d, dtVdist(pt, &pts[i*3]));
+			return d;
+		}
+
+		// Shortest distance between any portal of this and any of other
+		float distance(const EdgePortals& other) const
+		{
+			if (!whole)
+			{
+				float d = FLT_MAX;
+				for (int i = 0; i < count; ++i)
+					d = dtMin(d, other.distance(&pts[i*3]));
+				return d;
+			}
+			if (!other.whole)
+				return other.distance(*this);
+			// Two edges of one convex polygon come closest at an end of one of them
+			return dtMin(dtMin(distance(other.a), distance(other.b)),
+						 dtMin(other.distance(a), other.distance(b)));
+		}
+	};
+
+	// Binary heap of nodes keyed by distance, with decrease-key.
+	class NodeHeap
+	{
+	public:
+		NodeHeap() : m_heap(0), m_slot(0), m_size(0) {}
+		~NodeHeap()
+		{
+			dtFree(m_heap);
+			dtFree(m_slot);
+		}
+
+		bool init(const unsigned int nodeCount)
+		{
+			m_heap = (unsigned int*)dtAlloc(sizeof(unsigned int)*nodeCount, DT_ALLOC_TEMP);
+			m_slot = (unsigned int*)dtAlloc(sizeof(unsigned int)*nodeCount, DT_ALLOC_TEMP);
+			if (!m_heap || !m_slot)
+				return false;
+			memset(m_slot, 0xff, sizeof(unsigned int)*nodeCount);
+			return true;
+		}
+
+		bool empty() const { return m_size == 0; }
+
+		void push(const unsigned int node, const float* dist)
+		{
+			unsigned int i = m_slot[node];
+			if (i == NOT_QUEUED)
+				i = m_size++;
+			up(i, node, dist);
+		}
+
+		unsigned int pop(const float* dist)
+		{
+			const unsigned int top = m_heap[0];
+			m_slot[top] = NOT_QUEUED;
+			m_size--;
+			if (m_size > 0)
+				down(0, m_heap[m_size], dist);
+			return top;
+		}
+
+	private:
+		static const unsigned int NOT_QUEUED = 0xffffffff;
+
+		void up(unsigned int i, const unsigned int node, const float* dist)
+		{
+			while (i > 0)
+			{
+				const unsigned int parent = (i - 1) / 2;
+				if (dist[m_heap[parent]] <= dist[node])
+					break;
+				m_heap[i] = m_heap[parent];
+				m_slot[m_heap[i]] = i;
+				i = parent;
+			}
+			m_heap[i] = node;
+			m_slot[node] = i;
+		}
+
+		void down(unsigned int i, const unsigned int node, const float* dist)
+		{
+			for (;;)
+			{
+				unsigned int child = i*2 + 1;
+				if (child >= m_size)
+					break;
+				if (child + 1 < m_size && dist[m_heap[child + 1]] < dist[m_heap[child]])
+					child++;
+				if (dist[node] <= dist[m_heap[child]])
+					break;
+				m_heap[i] = m_heap[child];
+				m_slot[m_heap[i]] = i;
+				i = child;
+			}
+			m_heap[i] = node;
+			m_slot[node] = i;
+		}
+
+		unsigned int* m_heap;
+		unsigned int* m_slot;
+		unsigned int m_size;
+	};
+
+	// Portal graph of the navmesh during a build. A node is an edge slot of a
+	// polygon; the nodes of a tile follow each other from base[tile].
+	struct PortalGraph
+	{
+		const dtNavMesh* nav;
+		int tileCount;
+		int* tiles;					///< Tile index of each tile with polygons, in order.
+		unsigned int* base;			///< First node of each of those tiles, plus the total.
+		unsigned int* polyBase;		///< First global polygon index of each of those tiles.
+		const int* const* edgeBase;	///< First edge slot of each polygon, per tile index.
+		int* order;					///< Position in tiles of every tile index, or -1.
+		unsigned int nodeCount;
+		// Off-mesh connection ends attached to each land polygon, by global polygon index
+		unsigned int* attachStart;
+		unsigned int* attached;
+	};
+
+	unsigned int findTileSlot(const PortalGraph& g, const unsigned int node)
+	{
+		int lo = 0, hi = g.tileCount - 1;
+		while (lo < hi)
+		{
+			const int mid = (lo + hi + 1) / 2;
+			if (g.base[mid] <= node)
+				lo = mid;
+			else
+				hi = mid - 1;
+		}
+		return (unsigned int)lo;
+	}
+
+	void decodeNode(const PortalGraph& g, const unsigned int node, int* slot, int* poly, int* edge)
+	{
+		*slot = (int)findTileSlot(g, node);
+		const int* edgeBase = g.edgeBase[g.tiles[*slot]];
+		const dtMeshTile* tile = g.nav->getTile(g.tiles[*slot]);
+		const int local = (int)(node - g.base[*slot]);
+		int lo = 0, hi = tile->header->polyCount - 1;
+		while (lo < hi)
+		{
+			const int mid = (lo + hi + 1) / 2;
+			if (edgeBase[mid] <= local)
+				lo = mid;
+			else
+				hi = mid - 1;
+		}
+		*poly = lo;
+		*edge = local - edgeBase[lo];
+	}
+}
+
+// Tiles changed since build(). Searches share it and only the first one
+// after dtNavMesh::getTileChangeCount moves on looks them up again, under
+// the lock.
+struct dtLandmarkTable::StaleTiles
+{
+	std::atomic<unsigned int> checked;	///< Tile change count + 1 the lists are for, 0 for none.
+	std::mutex lock;
+	int count;							///< Tiles with distances that no longer match, removed ones included.
+	int boundsCount;					///< Changed tiles in the navmesh, -1 for more than #DT_MAX_LANDMARK_STALE_TILES.
+	float bounds[DT_MAX_LANDMARK_STALE_TILES*6];	///< Their bounds with their off-mesh connections. [(bmin, bmax) * boundsCount]
+
+	StaleTiles() : checked(0), count(0), boundsCount(0) {}
+};
+
+dtLandmarkTable::dtLandmarkTable() :
+	m_nav(0),
+	m_minAreaCost(0),
+	m_includeFlags(0),
+	m_excludeFlags(0),
+	m_maxLandmarks(0),
+	m_landmarkCount(0),
+	m_tiles(0),
+	m_tileCount(0),
+	m_stale(0)
+{
+	memset(m_areaCost, 0, sizeof(m_areaCost));
+	memset(m_landmarkPos, 0, sizeof(m_landmarkPos));
+}
+
+dtLandmarkTable::~dtLandmarkTable()
+{
+	purge();
+	if (m_stale)
+	{
+		m_stale->~StaleTiles();
+		dtFree(m_stale);
+	}
+}
+
+void dtLandmarkTable::purge()
+{
+	for (int i = 0; i < m_tileCount; ++i)
+	{
+		dtFree(m_tiles[i].edgeBase);
+		dtFree(m_tiles[i].dist);
+	}
+	dtFree(m_tiles);
+	m_tiles = 0;
+	m_tileCount = 0;
+	m_landmarkCount = 0;
+}
+
+dtStatus dtLandmarkTable::init(const dtNavMesh* nav, const dtQueryFilter* filter, const int landmarkCount)
+{
+	if (!nav || !filter || landmarkCount < 1 || landmarkCount > DT_MAX_LANDMARKS)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	if (!m_stale)
+	{
+		void* mem = dtAlloc(sizeof(StaleTiles), DT_ALLOC_PERM);
+		if (!mem)
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+		m_stale = new(mem) StaleTiles;
+	}
+
+	purge();
+	m_nav = nav;
+	m_minAreaCost = FLT_MAX;
+	for (int i = 0; i < DT_MAX_AREAS; ++i)
+	{
+		m_areaCost[i] = filter->getAreaCost(i);
+		m_minAreaCost = dtMin(m_minAreaCost, m_areaCost[i]);
+	}
+	m_minAreaCost = dtMax(m_minAreaCost, 0.0f);
+	m_includeFlags = filter->getIncludeFlags();
+	m_excludeFlags = filter->getExcludeFlags();
+	m_maxLandmarks = landmarkCount;
+	return DT_SUCCESS;
+}
+
+bool dtLandmarkTable::matches(const dtQueryFilter* filter) const
+{
+	if (!filter || m_landmarkCount == 0)
+		return false;
+	if (filter->getIncludeFlags() != m_includeFlags || filter->getExcludeFlags() != m_excludeFlags)
+		return false;
+	for (int i = 0; i < DT_MAX_AREAS; ++i)
+	{
+		if (filter->getAreaCost(i) != m_areaCost[i])
+			return false;
+	}
+	return true;
+}
+
+bool dtLandmarkTable::passes(const dtPoly* poly) const
+{
+	// dtQueryFilter::passFilter, which DetourNavMeshQuery.cpp keeps inline
+	return (poly->flags & m_includeFlags) != 0 && (poly->flags & m_excludeFlags) == 0;
+}
+
+dtStatus dtLandmarkTable::build(dtPolyRef seedRef)
+{
+	dtAssert(m_nav);
+	if (!m_nav || m_maxLandmarks == 0)
+		return DT_FAILURE | DT_INVALID_PARAM;
+
+	purge();
+	m_stale->checked.store(0, std::memory_order_relaxed);
+	const int maxTiles = m_nav->getMaxTiles();
+	m_tiles = (TileTable*)dtAlloc(sizeof(TileTable)*maxTiles, DT_ALLOC_PERM);
+	if (!m_tiles)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	memset(m_tiles, 0, sizeof(TileTable)*maxTiles);
+	m_tileCount = maxTiles;
+
+	PortalGraph g;
+	memset(&g, 0, sizeof(g));
+	g.nav = m_nav;
+	g.tiles = (int*)dtAlloc(sizeof(int)*maxTiles, DT_ALLOC_TEMP);
+	g.base = (unsigned int*)dtAlloc(sizeof(unsigned int)*(maxTiles + 1), DT_ALLOC_TEMP);
+	g.polyBase = (unsigned int*)dtAlloc(sizeof(unsigned int)*(maxTiles + 1), DT_ALLOC_TEMP);
+	g.order = (int*)dtAlloc(sizeof(int)*maxTiles, DT_ALLOC_TEMP);
+	const int** edgeBases = (const int**)dtAlloc(sizeof(int*)*maxTiles, DT_ALLOC_TEMP);
+	float* dist = 0;
+	float* nearest = 0;
+	NodeHeap heap;
+	dtStatus status = DT_SUCCESS;
+
+	if (!g.tiles || !g.base || !g.polyBase || !g.order || !edgeBases)
+	{
+		status = DT_FAILURE | DT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+	g.edgeBase = edgeBases;
+
+	// Edge slots of every tile
+	{
+		unsigned int nodes = 0;
+		unsigned int polys = 0;
+		for (int i = 0; i < maxTiles; ++i)
+		{
+			g.order[i] = -1;
+			edgeBases[i] = 0;
+			const dtMeshTile* tile = m_nav->getTile(i);
+			if (!tile || !tile->header || tile->header->polyCount == 0)
+				continue;
+			TileTable& table = m_tiles[i];
+			const int polyCount = tile->header->polyCount;
+			table.salt = m_nav->decodePolyIdSalt(m_nav->getPolyRefBase(tile));
+			table.polyCount = polyCount;
+			table.edgeBase = (int*)dtAlloc(sizeof(int)*polyCount, DT_ALLOC_PERM);
+			if (!table.edgeBase)
+			{
+				status = DT_FAILURE | DT_OUT_OF_MEMORY;
+				goto cleanup;
+			}
+			int edges = 0;
+			for (int j = 0; j < polyCount; ++j)
+			{
+				table.edgeBase[j] = edges;
+				edges += tile->polys[j].vertCount;
+			}
+			table.edgeCount = edges;
+			table.dist = (float*)dtAlloc(sizeof(float)*edges*m_maxLandmarks, DT_ALLOC_PERM);
+			if (!table.dist)
+			{
+				status = DT_FAILURE | DT_OUT_OF_MEMORY;
+				goto cleanup;
+			}
+			for (int j = 0; j < edges*m_maxLandmarks; ++j)
+				table.dist[j] = FLT_MAX;
+
+			edgeBases[i] = table.edgeBase;
+			g.order[i] = g.tileCount;
+			g.tiles[g.tileCount] = i;
+			g.base[g.tileCount] = nodes;
+			g.polyBase[g.tileCount] = polys;
+			g.tileCount++;
+			nodes += (unsigned int)edges;
+			polys += (unsigned int)polyCount;
+		}
+		g.base[g.tileCount] = nodes;
+		g.polyBase[g.tileCount] = polys;
+		g.nodeCount = nodes;
+		if (nodes == 0)
+			goto cleanup;
+
+		// Land polygons only know off-mesh connections through links that
+		// may go one way; record every attachment so the graph goes both ways.
+		g.attachStart = (unsigned int*)dtAlloc(sizeof(unsigned int)*(polys + 1), DT_ALLOC_TEMP);
+		if (!g.attachStart)
+		{
+			status = DT_FAILURE | DT_OUT_OF_MEMORY;
+			goto cleanup;
+		}
+		memset(g.attachStart, 0, sizeof(unsigned int)*(polys + 1));
+		unsigned int attachments = 0;
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			for (int s = 0; s < g.tileCount; ++s)
+			{
+				const dtMeshTile* tile = m_nav->getTile(g.tiles[s]);
+				for (int j = 0; j < tile->header->polyCount; ++j)
+				{
+					const dtPoly* poly = &tile->polys[j];
+					if (poly->getType() != DT_POLYTYPE_OFFMESH_CONNECTION)
+						continue;
+					for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+					{
+						const dtLink& link = tile->links[k];
+						const int order = g.order[m_nav->decodePolyIdTile(link.ref)];
+						if (order < 0)
+							continue;
+						const unsigned int land = g.polyBase[order] + m_nav->decodePolyIdPoly(link.ref);
+						if (pass == 0)
+							g.attachStart[land + 1]++;
+						else
+							g.attached[g.attachStart[land]++] = g.base[s] + (unsigned int)(m_tiles[g.tiles[s]].edgeBase[j] + link.edge);
+					}
+				}
+			}
+			if (pass == 0)
+			{
+				for (unsigned int p = 0; p < polys; ++p)
+					g.attachStart[p + 1] += g.attachStart[p];
+				attachments = g.attachStart[polys];
+				g.attached = (unsigned int*)dtAlloc(sizeof(unsigned int)*(attachments > 0 ? attachments : 1), DT_ALLOC_TEMP);
+				if (!g.attached)
+				{
+					status = DT_FAILURE | DT_OUT_OF_MEMORY;
+					goto cleanup;
+				}
+			}
+			else
+			{
+				// The fill pass advanced every start to the next polygon's
+				for (unsigned int p = polys; p > 0; --p)
+					g.attachStart[p] = g.attachStart[p - 1];
+				g.attachStart[0] = 0;
+			}
+		}
+	}
+
+	dist = (float*)dtAlloc(sizeof(float)*g.nodeCount, DT_ALLOC_TEMP);
+	nearest = (float*)dtAlloc(sizeof(float)*g.nodeCount, DT_ALLOC_TEMP);
+	if (!dist || !nearest || !heap.init(g.nodeCount))
+	{
+		status = DT_FAILURE | DT_OUT_OF_MEMORY;
+		goto cleanup;
+	}
+
+	{
+		// Seed polygon: the one asked for, or the first with a link
+		const dtMeshTile* seedTile = 0;
+		const dtPoly* seedPoly = 0;
+		if (!seedRef || dtStatusFailed(m_nav->getTileAndPolyByRef(seedRef, &seedTile, &seedPoly)))
+		{
+			seedTile = 0;
+			for (int s = 0; s < g.tileCount && !seedTile; ++s)
+			{
+				const dtMeshTile* tile = m_nav->getTile(g.tiles[s]);
+				for (int j = 0; j < tile->header->polyCount; ++j)
+				{
+					if (tile->polys[j].firstLink != DT_NULL_LINK && passes(&tile->polys[j]))
+					{
+						seedTile = tile;
+						seedPoly = &tile->polys[j];
+						break;
+					}
+				}
+			}
+			if (!seedTile)
+				goto cleanup;
+		}
+		const int seedSlot = g.order[m_nav->decodePolyIdTile(m_nav->getPolyRefBase(seedTile))];
+		unsigned int source = g.base[seedSlot] + (unsigned int)m_tiles[g.tiles[seedSlot]].edgeBase[(int)(seedPoly - seedTile->polys)];
+		for (unsigned int k = seedPoly->firstLink; k != DT_NULL_LINK; k = seedTile->links[k].next)
+		{
+			if (seedTile->links[k].edge != 0xff)
+			{
+				source += seedTile->links[k].edge;
+				break;
+			}
+		}
+
+		for (unsigned int n = 0; n < g.nodeCount; ++n)
+			nearest[n] = FLT_MAX;
+
+		// Run 0 from the seed only places the first landmark
+		for (int run = 0; run <= m_maxLandmarks; ++run)
+		{
+			for (unsigned int n = 0; n < g.nodeCount; ++n)
+				dist[n] = FLT_MAX;
+			dist[source] = 0.0f;
+			heap.push(source, dist);
+
+			while (!heap.empty())
+			{
+				const unsigned int node = heap.pop(dist);
+				const float d = dist[node];
+				int slot, polyIndex, edge;
+				decodeNode(g, node, &slot, &polyIndex, &edge);
+				const dtMeshTile* tile = m_nav->getTile(g.tiles[slot]);
+				const dtPoly* poly = &tile->polys[polyIndex];
+				const dtPolyRef ref = m_nav->getPolyRefBase(tile) | (dtPolyRef)polyIndex;
+				EdgePortals portals;
+				portals.gather(tile, poly, edge);
+
+				// Across a land polygon from this portal to each of its others
+				const dtMeshTile* crossTiles[MAX_ATTACHED_POLYS];
+				const dtPoly* crossPolys[MAX_ATTACHED_POLYS];
+				int crossCount = 0;
+
+				if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+				{
+					if (passes(poly))
+					{
+						const unsigned int other = node - edge + (1 - edge);
+						const float nd = d + dtVdist(&tile->verts[poly->verts[0]*3], &tile->verts[poly->verts[1]*3])*m_areaCost[poly->getArea()];
+						if (nd < dist[other])
+						{
+							dist[other] = nd;
+							heap.push(other, dist);
+						}
+					}
+					for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+					{
+						if (tile->links[k].edge != edge || crossCount == MAX_ATTACHED_POLYS)
+							continue;
+						m_nav->getTileAndPolyByRefUnsafe(tile->links[k].ref, &crossTiles[crossCount], &crossPolys[crossCount]);
+						crossCount++;
+					}
+				}
+				else
+				{
+					crossTiles[0] = tile;
+					crossPolys[0] = poly;
+					crossCount = 1;
+
+					// The same edge seen from the polygons on the other side costs nothing
+					for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+					{
+						if (tile->links[k].edge != edge)
+							continue;
+						const dtMeshTile* nextTile = 0;
+						const dtPoly* nextPoly = 0;
+						m_nav->getTileAndPolyByRefUnsafe(tile->links[k].ref, &nextTile, &nextPoly);
+						if (!passes(nextPoly))
+							continue;
+						const int nextSlot = g.order[m_nav->decodePolyIdTile(tile->links[k].ref)];
+						if (nextSlot < 0)
+							continue;
+						const unsigned int nextBase = g.base[nextSlot] + (unsigned int)m_tiles[g.tiles[nextSlot]].edgeBase[(int)(nextPoly - nextTile->polys)];
+						for (unsigned int b = nextPoly->firstLink; b != DT_NULL_LINK; b = nextTile->links[b].next)
+						{
+							const dtLink& back = nextTile->links[b];
+							if (back.ref != ref || back.edge == 0xff)
+								continue;
+							const unsigned int twin = nextBase + back.edge;
+							if (d < dist[twin])
+							{
+								dist[twin] = d;
+								heap.push(twin, dist);
+							}
+						}
+					}
+				}
+
+				for (int c = 0; c < crossCount; ++c)
+				{
+					const dtMeshTile* crossTile = crossTiles[c];
+					const dtPoly* crossPoly = crossPolys[c];
+					if (!passes(crossPoly))
+						continue;
+					const float areaCost = m_areaCost[crossPoly->getArea()];
+					const int crossSlot = g.order[m_nav->decodePolyIdTile(m_nav->getPolyRefBase(crossTile))];
+					if (crossSlot < 0)
+						continue;
+					const int crossIndex = (int)(crossPoly - crossTile->polys);
+					const unsigned int crossBase = g.base[crossSlot] + (unsigned int)m_tiles[g.tiles[crossSlot]].edgeBase[crossIndex];
+					for (unsigned int k = crossPoly->firstLink; k != DT_NULL_LINK; k = crossTile->links[k].next)
+					{
+						const dtLink& link = crossTile->links[k];
+						if (link.edge == 0xff)
+							continue;
+						const unsigned int next = crossBase + link.edge;
+						if (next == node)
+							continue;
+						EdgePortals nextPortals;
+						nextPortals.gather(crossTile, crossPoly, link.edge);
+						const float nd = d + portals.distance(nextPortals)*areaCost;
+						if (nd < dist[next])
+						{
+							dist[next] = nd;
+							heap.push(next, dist);
+						}
+					}
+					const unsigned int land = g.polyBase[crossSlot] + (unsigned int)crossIndex;
+					for (unsigned int a = g.attachStart[land]; a < g.attachStart[land + 1]; ++a)
+					{
+						const unsigned int next = g.attached[a];
+						if (next == node)
+							continue;
+						int endSlot, endPoly, endEdge;
+						decodeNode(g, next, &endSlot, &endPoly, &endEdge);
+						const dtMeshTile* endTile = m_nav->getTile(g.tiles[endSlot]);
+						const float* q = &endTile->verts[endTile->polys[endPoly].verts[endEdge]*3];
+						const float nd = d + portals.distance(q)*areaCost;
+						if (nd < dist[next])
+						{
+							dist[next] = nd;
+							heap.push(next, dist);
+						}
+					}
+				}
+			}
+
+			if (run > 0)
+			{
+				// Store the distances of landmark run - 1
+				const int l = run - 1;
+				for (int s = 0; s < g.tileCount; ++s)
+				{
+					float* out = m_tiles[g.tiles[s]].dist;
+					const unsigned int count = g.base[s + 1] - g.base[s];
+					for (unsigned int n = 0; n < count; ++n)
+						out[n*m_maxLandmarks + l] = dist[g.base[s] + n];
+				}
+				m_landmarkCount = run;
+				for (unsigned int n = 0; n < g.nodeCount; ++n)
+					nearest[n] = dtMin(nearest[n], dist[n]);
+			}
+			else
+			{
+				for (unsigned int n = 0; n < g.nodeCount; ++n)
+					nearest[n] = dist[n];
+			}
+			if (run == m_maxLandmarks)
+				break;
+
+			// Next landmark: the reachable portal farthest from those so far
+			unsigned int farthest = source;
+			float farthestDist = 0.0f;
+			for (unsigned int n = 0; n < g.nodeCount; ++n)
+			{
+				if (nearest[n] < FLT_MAX && nearest[n] > farthestDist)
+				{
+					farthest = n;
+					farthestDist = nearest[n];
+				}
+			}
+			if (run > 0 && farthestDist == 0.0f)
+				break;
+			source = farthest;
+			int slot, polyIndex, edge;
+			decodeNode(g, source, &slot, &polyIndex, &edge);
+			const dtMeshTile* tile = m_nav->getTile(g.tiles[slot]);
+			EdgePortals portals;
+			portals.gather(tile, &tile->polys[polyIndex], edge);
+			dtVcopy(&m_landmarkPos[run*3], portals.pts);
+		}
+	}
+
+cleanup:
+	dtFree(g.tiles);
+	dtFree(g.base);
+	dtFree(g.polyBase);
+	dtFree(g.order);
+	dtFree(g.attachStart);
+	dtFree(g.attached);
+	dtFree(edgeBases);
+	dtFree(dist);
+	dtFree(nearest);
+	if (dtStatusFailed(status))
+		purge();
+	return status;
+}
+
+const float* dtLandmarkTable::distances(const dtMeshTile* tile, const dtPoly* poly, const int edge) const
+{
+	const dtPolyRef base = m_nav->getPolyRefBase(tile);
+	const unsigned int index = m_nav->decodePolyIdTile(base);
+	if ((int)index >= m_tileCount)
+		return 0;
+	const TileTable& table = m_tiles[index];
+	if (!table.dist || table.salt != m_nav->decodePolyIdSalt(base))
+		return 0;
+	return &table.dist[(table.edgeBase[poly - tile->polys] + edge)*m_maxLandmarks];
+}
+
+bool dtLandmarkTable::portalOfLink(const dtMeshTile* tile, const dtPoly* poly, const dtLink* link,
+								   const dtMeshTile* nextTile, const dtPoly* nextPoly,
+								   const dtMeshTile** portalTile, const dtPoly** portalPoly, int* edge) const
+{
+	if (link->edge != 0xff)
+	{
+		*portalTile = tile;
+		*portalPoly = poly;
+		*edge = link->edge;
+		return true;
+	}
+	// Onto an off-mesh connection: the end of it that links back
+	const dtPolyRef ref = m_nav->getPolyRefBase(tile) | (dtPolyRef)(poly - tile->polys);
+	for (unsigned int k = nextPoly->firstLink; k != DT_NULL_LINK; k = nextTile->links[k].next)
+	{
+		if (nextTile->links[k].ref == ref)
+		{
+			*portalTile = nextTile;
+			*portalPoly = nextPoly;
+			*edge = nextTile->links[k].edge;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool dtLandmarkTable::prepareGoal(dtPolyRef endRef, const float* endPos, dtLandmarkGoal& goal) const
+{
+	if (m_landmarkCount == 0)
+		return false;
+	const StaleTiles* stale = staleTiles();
+	if (stale->boundsCount < 0)
+		return false;
+	const dtMeshTile* tile = 0;
+	const dtPoly* poly = 0;
+	if (dtStatusFailed(m_nav->getTileAndPolyByRef(endRef, &tile, &poly)))
+		return false;
+
+	for (int l = 0; l < m_landmarkCount; ++l)
+	{
+		goal.minDist[l] = FLT_MAX;
+		goal.maxDist[l] = -FLT_MAX;
+	}
+	bool found = false;
+	for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next)
+	{
+		const dtMeshTile* nextTile = 0;
+		const dtPoly* nextPoly = 0;
+		m_nav->getTileAndPolyByRefUnsafe(tile->links[k].ref, &nextTile, &nextPoly);
+		const dtMeshTile* portalTile = 0;
+		const dtPoly* portalPoly = 0;
+		int edge = 0;
+		if (!portalOfLink(tile, poly, &tile->links[k], nextTile, nextPoly, &portalTile, &portalPoly, &edge))
+			continue;
+		const float* d = distances(portalTile, portalPoly, edge);
+		if (!d)
+			return false;
+		for (int l = 0; l < m_landmarkCount; ++l)
+		{
+			if (d[l] == FLT_MAX)
+				continue;
+			goal.minDist[l] = dtMin(goal.minDist[l], d[l]);
+			goal.maxDist[l] = dtMax(goal.maxDist[l], d[l]);
+			found = true;
+		}
+	}
+
+	goal.staleCount = stale->boundsCount;
+	memcpy(goal.staleBounds, stale->bounds, sizeof(float)*6*stale->boundsCount);
+	for (int i = 0; i < stale->boundsCount; ++i)
+		goal.staleGoalDist[i] = distancePtBox(endPos, &stale->bounds[i*6], &stale->bounds[i*6 + 3]);
+	return found;
+}
+
+float dtLandmarkTable::estimate(const dtLandmarkGoal& goal, const float* pos, const dtMeshTile* tile, const dtPoly* poly,
+								const dtLink* link, const dtMeshTile* nextTile, const dtPoly* nextPoly) const
+{
+	const dtMeshTile* portalTile = 0;
+	const dtPoly* portalPoly = 0;
+	int edge = 0;
+	if (!portalOfLink(tile, poly, link, nextTile, nextPoly, &portalTile, &portalPoly, &edge))
+		return 0.0f;
+	const float* d = distances(portalTile, portalPoly, edge);
+	if (!d)
+		return 0.0f;
+	float h = 0.0f;
+	for (int l = 0; l < m_landmarkCount; ++l)
+	{
+		if (d[l] == FLT_MAX || goal.minDist[l] == FLT_MAX)
+			continue;
+		h = dtMax(h, dtMax(goal.minDist[l] - d[l], d[l] - goal.maxDist[l]));
+	}
+
+	// The distances only bound routes that stay out of changed tiles; one
+	// through a changed tile costs at least the way in and out of its bounds
+	for (int i = 0; i < goal.staleCount && h > 0.0f; ++i)
+	{
+		const float through = distancePtBox(pos, &goal.staleBounds[i*6], &goal.staleBounds[i*6 + 3]) + goal.staleGoalDist[i];
+		h = dtMin(h, through*m_minAreaCost);
+	}
+	return h;
+}
+
+const dtLandmarkTable::StaleTiles* dtLandmarkTable::staleTiles() const
+{
+	StaleTiles* stale = m_stale;
+	const unsigned int current = m_nav->getTileChangeCount() + 1;
+	if (stale->checked.load(std::memory_order_acquire) == current)
+		return stale;
+
+	std::lock_guard<std::mutex> guard(stale->lock);
+	if (stale->checked.load(std::memory_order_relaxed) == current)
+		return stale;
+	stale->count = 0;
+	stale->boundsCount = 0;
+	for (int i = 0; i < m_tileCount; ++i)
+	{
+		const dtMeshTile* tile = m_nav->getTile(i);
+		const bool present = tile && tile->header && tile->header->polyCount > 0;
+		const TileTable& table = m_tiles[i];
+		if (!present)
+		{
+			// Removing a tile only makes routes longer
+			if (table.dist)
+				stale->count++;
+			continue;
+		}
+		if (table.dist && table.salt == m_nav->decodePolyIdSalt(m_nav->getPolyRefBase(tile)))
+			continue;
+		stale->count++;
+		if (stale->boundsCount < 0)
+			continue;
+		if (stale->boundsCount == DT_MAX_LANDMARK_STALE_TILES)
+		{
+			stale->boundsCount = -1;
+			continue;
+		}
+		// Off-mesh connections can reach out of the tile
+		float* bmin = &stale->bounds[stale->boundsCount*6];
+		float* bmax = bmin + 3;
+		dtVcopy(bmin, tile->header->bmin);
+		dtVcopy(bmax, tile->header->bmax);
+		for (int j = 0; j < tile->header->offMeshConCount; ++j)
+		{
+			const float* pos = tile->offMeshCons[j].pos;
+			dtVmin(bmin, &pos[0]);
+			dtVmax(bmax, &pos[0]);
+			dtVmin(bmin, &pos[3]);
+			dtVmax(bmax, &pos[3]);
+		}
+		stale->boundsCount++;
+	}
+	stale->checked.store(current, std::memory_order_release);
+	return stale;
+}
+
+int dtLandmarkTable::getStaleTileCount() const
+{
+	if (!m_nav || !m_tiles)
+		return 0;
+	return staleTiles()->count;
+}
+
+size_t dtLandmarkTable::getMemoryUsage() const
+{
+	size_t bytes = sizeof(*this) + sizeof(TileTable)*m_tileCount;
+	for (int i = 0; i < m_tileCount; ++i)
+	{
+		const TileTable& table = m_tiles[i];
+		if (!table.dist)
+			continue;
+		bytes += sizeof(int)*table.polyCount;
+		bytes += sizeof(float)*table.edgeCount*m_maxLandmarks;
+	}
+	return bytes;
+}
@@ -0,0 +1,250 @@
+// DetourMemory.cpp
+// Accounting of the memory Detour and Recast allocate, by hint and by owner
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "DetourMemory.h"
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+
+struct Counter
+{
+	std::atomic<size_t> current;
+	std::atomic<size_t> peak;
+	std::atomic<size_t> allocations;
+
+	void add(const size_t size)
+	{
+		const size_t now = current.fetch_add(size, std::memory_order_relaxed) + size;
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		size_t top = peak.load(std::memory_order_relaxed);
+		while (now > top && !peak.compare_exchange_weak(top, now, std::memory_order_relaxed)) {}
+	}
+
+	void remove(const size_t size)
+	{
+		current.fetch_sub(size, std::memory_order_relaxed);
+		allocations.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	void resetPeak()
+	{
+		peak.store(current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+
+	dtMemoryCounter read() const
+	{
+		dtMemoryCounter c;
+		c.current = current.load(std::memory_order_relaxed);
+		c.peak = peak.load(std::memory_order_relaxed);
+		c.allocations = allocations.load(std::memory_order_relaxed);
+		// The peak is raised after the current count, so a reader can see it lag.
+		if (c.peak < c.current) c.peak = c.current;
+		return c;
+	}
+};
+
+struct Block
+{
+	size_t size;
+	unsigned char owner;
+	unsigned char source;
+};
+
+// Blocks are looked up by address on free, in one of several maps so that
+// build threads allocating at once rarely wait on each other.
+struct Shard
+{
+	std::mutex lock;
+	std::unordered_map<const void*, Block> blocks;
+};
+
+static const int SHARD_BITS = 6;
+static const int SHARD_COUNT = 1 << SHARD_BITS;
+
+std::atomic<bool> s_enabled(false);
+std::atomic<size_t> s_tracked(0);	// Blocks recorded; frees skip the lookup while there are none.
+Counter s_total;
+Counter s_owners[DT_MEMORY_OWNER_COUNT];
+Counter s_sources[DT_MEMORY_SOURCE_COUNT];
+thread_local int t_owner = -1;
+
+Shard& shardOf(const void* ptr)
+{
+	// Never destroyed, so that blocks freed while statics are torn down still find their map.
+	static Shard* shards = new Shard[SHARD_COUNT];
+	const uint64_t h = (uint64_t)(uintptr_t)ptr * 0x9E3779B97F4A7C15ull;
+	return shards[h >> (64 - SHARD_BITS)];
+}
+
+void charge(const Block& b)
+{
+	s_total.add(b.size);
+	s_owners[b.owner].add(b.size);
+	s_sources[b.source].add(b.size);
+}
+
+void release(const Block& b)
+{
+	s_total.remove(b.size);
+	s_owners[b.owner].remove(b.size);
+	s_sources[b.source].remove(b.size);
+}
+
+void record(void* ptr, const Block& block)
+{
+	Shard& shard = shardOf(ptr);
+	Block stale;
+	bool replaced = false;
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+		std::pair<std::unordered_map<const void*, Block>::iterator, bool> r = shard.blocks.emplace(ptr, block);
+		if (!r.second)
+		{
+			// The address was freed without dtFree or rcFree and handed out again.
+			stale = r.first->second;
+			r.first->second = block;
+			replaced = true;
+		}
+	}
+	if (replaced)
+		release(stale);
+	else
+		s_tracked.fetch_add(1, std::memory_order_relaxed);
+	charge(block);
+}
+
+}
+
+void dtMemorySetTracking(bool enabled)
+{
+	s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool dtMemoryGetTracking()
+{
+	return s_enabled.load(std::memory_order_relaxed);
+}
+
+dtMemoryCounter dtMemoryGetTotal()
+{
+	return s_total.read();
+}
+
+dtMemoryCounter dtMemoryGetOwner(dtMemoryOwner owner)
+{
+	if ((int)owner < 0 || owner >= DT_MEMORY_OWNER_COUNT)
+	{
+		dtMemoryCounter empty = { 0, 0, 0 };
+		return empty;
+	}
+	return s_owners[owner].read();
+}
+
+dtMemoryCounter dtMemoryGetSource(dtMemorySource source)
+{
+	if ((int)source < 0 || source >= DT_MEMORY_SOURCE_COUNT)
+	{
+		dtMemoryCounter empty = { 0, 0, 0 };
+		return empty;
+	}
+	return s_sources[source].read();
+}
+
+void dtMemoryResetPeaks()
+{
+	s_total.resetPeak();
+	for (int i = 0; i < DT_MEMORY_OWNER_COUNT; ++i)
+		s_owners[i].resetPeak();
+	for (int i = 0; i < DT_MEMORY_SOURCE_COUNT; ++i)
+		s_sources[i].resetPeak();
+}
+
+dtMemoryOwnerScope::dtMemoryOwnerScope(dtMemoryOwner owner) :
+	m_previous(t_owner)
+{
+	if (t_owner < 0)
+		t_owner = owner;
+}
+
+dtMemoryOwnerScope::~dtMemoryOwnerScope()
+{
+	t_owner = m_previous;
+}
+
+void dtMemoryTrackAlloc(void* ptr, size_t size, dtMemorySource source)
+{
+	if (!ptr || !s_enabled.load(std::memory_order_relaxed))
+		return;
+	Block block;
+	block.size = size;
+	block.source = (unsigned char)source;
+	if (source == DT_MEMORY_RECAST_PERM || source == DT_MEMORY_RECAST_TEMP)
+		block.owner = DT_MEMORY_BUILD;
+	else
+		block.owner = (unsigned char)(t_owner >= 0 ? t_owner : DT_MEMORY_OTHER);
+	record(ptr, block);
+}
+
+void dtMemoryTrackFree(void* ptr)
+{
+	if (!ptr || s_tracked.load(std::memory_order_relaxed) == 0)
+		return;
+	Shard& shard = shardOf(ptr);
+	Block block;
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+		std::unordered_map<const void*, Block>::iterator it = shard.blocks.find(ptr);
+		if (it == shard.blocks.end())
+			return;
+		block = it->second;
+		shard.blocks.erase(it);
+	}
+	s_tracked.fetch_sub(1, std::memory_order_relaxed);
+	release(block);
+}
+
+void dtMemoryTrackOwner(void* ptr, size_t size, dtMemoryOwner owner)
+{
+	if (!ptr)
+		return;
+	if (s_tracked.load(std::memory_order_relaxed) > 0)
+	{
+		Shard& shard = shardOf(ptr);
+		size_t moved = 0;
+		int from = -1;
+		{
+			std::lock_guard<std::mutex> guard(shard.lock);
+			std::unordered_map<const void*, Block>::iterator it = shard.blocks.find(ptr);
+			if (it != shard.blocks.end())
+			{
+				from = it->second.owner;
+				moved = it->second.size;
+				it->second.owner = (unsigned char)owner;
+			}
+		}
+		if (from >= 0)
+		{
+			if (from != owner)
+			{
+				s_owners[from].remove(moved);
+				s_owners[owner].add(moved);
+			}
+			return;
+		}
+	}
+	if (!s_enabled.load(std::memory_order_relaxed))
+		return;
+	// Allocated outside Detour, such as a buffer from malloc.
+	Block block;
+	block.size = size;
+	block.owner = (unsigned char)owner;
+	block.source = DT_MEMORY_DETOUR_PERM;
+	record(ptr, block);
+}
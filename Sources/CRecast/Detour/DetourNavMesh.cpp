@@ -25,6 +25,7 @@
 #include "DetourMath.h"
 #include "DetourAlloc.h"
 #include "DetourAssert.h"
+#include "DetourMemory.h"
 #include <new>
 
 
@@ -137,6 +138,7 @@ inline void freeLink(dtMeshTile* tile, unsigned int link)
 
 dtNavMesh* dtAllocNavMesh()
 {
+	dtMemoryOwnerScope owner(DT_MEMORY_NAVMESH);
 	void* mem = dtAlloc(sizeof(dtNavMesh), DT_ALLOC_PERM);
 	if (!mem) return 0;
 	return new(mem) dtNavMesh;
@@ -193,7 +195,9 @@ dtNavMesh::dtNavMesh() :
 	m_tileLutMask(0),
 	m_posLookup(0),
 	m_nextFree(0),
-	m_tiles(0)
+	m_tiles(0),
+	m_detailProvider(0),
+	m_tileChangeCount(0)
 {
 #ifndef DT_POLYREF64
 	m_saltBits = 0;
@@ -223,6 +227,7 @@ dtNavMesh::~dtNavMesh()
 		
 dtStatus dtNavMesh::init(const dtNavMeshParams* params)
 {
+	dtMemoryOwnerScope owner(DT_MEMORY_NAVMESH);
 	memcpy(&m_params, params, sizeof(dtNavMeshParams));
 	dtVcopy(m_orig, params->orig);
 	m_tileWidth = params->tileWidth;
@@ -681,6 +686,11 @@ bool dtNavMesh::getPolyHeight(const dtMeshTile* tile, const dtPoly* poly, const
 	if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
 		return false;
 
+	// Give the provider a chance to attach the tile's detail mesh. All
+	// detail mesh reads, including closestPointOnPoly's, start here.
+	if (m_detailProvider)
+		m_detailProvider->requireDetail(tile);
+
 	const unsigned int ip = (unsigned int)(poly - tile->polys);
 	const dtPolyDetail* pd = &tile->detailMeshes[ip];
 	
@@ -925,6 +935,14 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 	// Make sure the location is free.
 	if (getTileAt(header->x, header->y, header->layer))
 		return DT_FAILURE | DT_ALREADY_OCCUPIED;
+
+	// Pre-linked tiles refer to their neighbours by reference, so they must keep
+	// theirs, and cannot be linked to tiles that were not saved with them.
+	const bool prelinked = (flags & DT_TILE_PRELINKED) != 0;
+	if (prelinked && !lastRef)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	if (hasMismatchedLinking(header->x, header->y, prelinked))
+		return DT_FAILURE | DT_INVALID_PARAM;
 		
 	// Allocate a tile.
 	dtMeshTile* tile = 0;
@@ -999,17 +1017,29 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 	if (!bvtreeSize)
 		tile->bvTree = 0;
 
-	// Build links freelist
-	tile->linksFreeList = 0;
-	tile->links[header->maxLinkCount-1].next = DT_NULL_LINK;
-	for (int i = 0; i < header->maxLinkCount-1; ++i)
-		tile->links[i].next = i+1;
-
 	// Init tile.
 	tile->header = header;
 	tile->data = data;
 	tile->dataSize = dataSize;
 	tile->flags = flags;
+	if (flags & DT_TILE_FREE_DATA)
+		dtMemoryTrackOwner(data, (size_t)dataSize, DT_MEMORY_TILES);
+	m_tileChangeCount++;
+
+	// Pre-linked tiles are complete as they are, and never get new links.
+	if (prelinked)
+	{
+		tile->linksFreeList = DT_NULL_LINK;
+		if (result)
+			*result = getTileRef(tile);
+		return DT_SUCCESS;
+	}
+
+	// Build links freelist
+	tile->linksFreeList = 0;
+	tile->links[header->maxLinkCount-1].next = DT_NULL_LINK;
+	for (int i = 0; i < header->maxLinkCount-1; ++i)
+		tile->links[i].next = i+1;
 
 	connectIntLinks(tile);
 
@@ -1054,6 +1084,29 @@ dtStatus dtNavMesh::addTile(unsigned char* data, int dataSize, int flags,
 	return DT_SUCCESS;
 }
 
+bool dtNavMesh::hasMismatchedLinking(const int x, const int y, bool prelinked) const
+{
+	static const int MAX_NEIS = 32;
+	dtMeshTile* neis[MAX_NEIS];
+	
+	int nneis = getTilesAt(x, y, neis, MAX_NEIS);
+	for (int j = 0; j < nneis; ++j)
+	{
+		if (((neis[j]->flags & DT_TILE_PRELINKED) != 0) != prelinked)
+			return true;
+	}
+	for (int i = 0; i < 8; ++i)
+	{
+		nneis = getNeighbourTilesAt(x, y, i, neis, MAX_NEIS);
+		for (int j = 0; j < nneis; ++j)
+		{
+			if (((neis[j]->flags & DT_TILE_PRELINKED) != 0) != prelinked)
+				return true;
+		}
+	}
+	return false;
+}
+
 const dtMeshTile* dtNavMesh::getTileAt(const int x, const int y, const int layer) const
 {
 	// Find tile based on hash.
@@ -1248,6 +1301,9 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 	dtMeshTile* tile = &m_tiles[tileIndex];
 	if (tile->salt != tileSalt)
 		return DT_FAILURE | DT_INVALID_PARAM;
+	// Unlinking would write to the neighbours' read-only data.
+	if (tile->flags & DT_TILE_PRELINKED)
+		return DT_FAILURE | DT_INVALID_PARAM;
 	
 	// Remove tile from hash lookup.
 	int h = computeTileHash(tile->header->x,tile->header->y,m_tileLutMask);
@@ -1328,6 +1384,7 @@ dtStatus dtNavMesh::removeTile(dtTileRef ref, unsigned char** data, int* dataSiz
 	// Add to free list.
 	tile->next = m_nextFree;
 	m_nextFree = tile;
+	m_tileChangeCount++;
 
 	return DT_SUCCESS;
 }
@@ -1339,6 +1396,23 @@ dtTileRef dtNavMesh::getTileRef(const dtMeshTile* tile) const
 	return (dtTileRef)encodePolyId(tile->salt, it, 0);
 }
 
+dtStatus dtNavMesh::setTileDetail(dtTileRef ref, dtPolyDetail* detailMeshes, float* detailVerts,
+								  unsigned char* detailTris)
+{
+	dtMeshTile* tile = (dtMeshTile*)getTileByRef(ref);
+	if (!tile || !detailMeshes)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	tile->detailMeshes = detailMeshes;
+	tile->detailVerts = detailVerts;
+	tile->detailTris = detailTris;
+	return DT_SUCCESS;
+}
+
+dtTileDetailProvider::~dtTileDetailProvider()
+{
+	// Defined out of line to fix the weak v-tables warning
+}
+
 /// @par
 ///
 /// Example use case:
@@ -1436,6 +1510,8 @@ dtStatus dtNavMesh::restoreTileState(dtMeshTile* tile, const unsigned char* data
 		return DT_FAILURE | DT_WRONG_VERSION;
 	if (tileState->ref != getTileRef(tile))
 		return DT_FAILURE | DT_INVALID_PARAM;
+	if (tile->flags & DT_TILE_PRELINKED)
+		return DT_FAILURE | DT_INVALID_PARAM;
 	
 	// Restore per poly state.
 	for (int i = 0; i < tile->header->polyCount; ++i)
@@ -1533,6 +1609,7 @@ dtStatus dtNavMesh::setPolyFlags(dtPolyRef ref, unsigned short flags)
 	if (m_tiles[it].salt != salt || m_tiles[it].header == 0) return DT_FAILURE | DT_INVALID_PARAM;
 	dtMeshTile* tile = &m_tiles[it];
 	if (ip >= (unsigned int)tile->header->polyCount) return DT_FAILURE | DT_INVALID_PARAM;
+	if (tile->flags & DT_TILE_PRELINKED) return DT_FAILURE | DT_INVALID_PARAM;
 	dtPoly* poly = &tile->polys[ip];
 	
 	// Change flags.
@@ -1566,6 +1643,7 @@ dtStatus dtNavMesh::setPolyArea(dtPolyRef ref, unsigned char area)
 	if (m_tiles[it].salt != salt || m_tiles[it].header == 0) return DT_FAILURE | DT_INVALID_PARAM;
 	dtMeshTile* tile = &m_tiles[it];
 	if (ip >= (unsigned int)tile->header->polyCount) return DT_FAILURE | DT_INVALID_PARAM;
+	if (tile->flags & DT_TILE_PRELINKED) return DT_FAILURE | DT_INVALID_PARAM;
 	dtPoly* poly = &tile->polys[ip];
 	
 	poly->setArea(area);
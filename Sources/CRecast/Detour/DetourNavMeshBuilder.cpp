@@ -26,6 +26,7 @@
 #include "DetourNavMeshBuilder.h"
 #include "DetourAlloc.h"
 #include "DetourAssert.h"
+#include "DetourMemory.h"
 
 static unsigned short MESH_NULL_IDX = 0xffff;
 
@@ -279,6 +280,7 @@ static unsigned char classifyOffMeshPoint(const float* pt, const float* bmin, co
 /// @see dtNavMesh, dtNavMesh::addTile()
 bool dtCreateNavMeshData(dtNavMeshCreateParams* params, unsigned char** outData, int* outDataSize)
 {
+	dtMemoryOwnerScope owner(DT_MEMORY_BUILD);
 	if (params->nvp > DT_VERTS_PER_POLYGON)
 		return false;
 	if (params->vertCount >= 0xffff)
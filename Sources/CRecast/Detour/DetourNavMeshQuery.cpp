@@ -18,15 +18,28 @@
 //
 
 #include <float.h>
+#include <stdlib.h>
 #include <string.h>
 #include "DetourNavMeshQuery.h"
+#include "DetourLandmarks.h"
 #include "DetourNavMesh.h"
 #include "DetourNode.h"
 #include "DetourCommon.h"
 #include "DetourMath.h"
 #include "DetourAlloc.h"
 #include "DetourAssert.h"
+#include "DetourMemory.h"
 #include <new>
+
+// Vectorized box tests for dtNavMeshQuery::findNearestPolys, selected at compile
+// time. Define DT_DISABLE_SIMD to always use the scalar path.
+#if !defined(DT_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#	include <emmintrin.h>
+#	define DT_NEAREST_SSE2 1
+#elif !defined(DT_DISABLE_SIMD) && (defined(__aarch64__) || defined(_M_ARM64))
+#	include <arm_neon.h>
+#	define DT_NEAREST_NEON 1
+#endif
 #import <swift/bridging>
 
 /// @class dtQueryFilter
@@ -117,6 +130,7 @@ static const float H_SCALE = 0.999f; // Search heuristic scale.
 
 dtNavMeshQuery* dtAllocNavMeshQuery()
 {
+	dtMemoryOwnerScope owner(DT_MEMORY_QUERY);
 	void* mem = dtAlloc(sizeof(dtNavMeshQuery), DT_ALLOC_PERM);
 	if (!mem) return 0;
 	return new(mem) dtNavMeshQuery;
@@ -154,6 +168,7 @@ dtPolyQuery::~dtPolyQuery()
 
 dtNavMeshQuery::dtNavMeshQuery() :
 	m_nav(0),
+	m_landmarks(0),
 	m_tinyNodePool(0),
 	m_nodePool(0),
 	m_openList(0)
@@ -186,6 +201,7 @@ dtStatus dtNavMeshQuery::init(const dtNavMesh* nav, const int maxNodes)
 		return DT_FAILURE | DT_INVALID_PARAM;
 
 	m_nav = nav;
+	dtMemoryOwnerScope owner(DT_MEMORY_QUERY);
 	
 	if (!m_nodePool || m_nodePool->getMaxNodes() < maxNodes)
 	{
@@ -741,6 +757,470 @@ dtStatus dtNavMeshQuery::findNearestPoly(const float* center, const float* halfE
 	return DT_SUCCESS;
 }
 
+// Centers findNearestPolys searches a tile for at once, and candidates it
+// keeps per center before evaluating them nearest first.
+static const int DT_NEAREST_LANES = 8;
+static const int DT_NEAREST_MAX_CANDIDATES = 32;
+
+/// A tile the search box of a center overlaps.
+struct dtNearestTileEntry
+{
+	unsigned long long key;		///< Tile index above the Morton code of the center's X/Z position in the tile.
+	int center;
+	unsigned int order;			///< Position of the tile in the order findNearestPoly visits the center's tiles.
+};
+
+/// The best polygon found so far for one center.
+struct dtNearestState
+{
+	float distSqr;
+	float pos[3];
+	unsigned long long seq;		///< Visit order of the polygon, to break ties as findNearestPoly does.
+	dtPolyRef ref;
+	bool overPoly;
+};
+
+/// A polygon whose bounds overlap a center's search box, with a lower bound on its distance.
+struct dtNearestCandidate
+{
+	float bound;
+	unsigned long long seq;
+	dtPolyRef ref;
+};
+
+static unsigned int spreadBits8(unsigned int v)
+{
+	v = (v | (v << 4)) & 0x0f0f;
+	v = (v | (v << 2)) & 0x3333;
+	v = (v | (v << 1)) & 0x5555;
+	return v;
+}
+
+/// Sorts @p entries by key, least significant byte first, using @p temp of the same size.
+static void sortNearestTileEntries(dtNearestTileEntry*& entries, dtNearestTileEntry*& temp, const int n, const int keyBits)
+{
+	int counts[256];
+	for (int shift = 0; shift < keyBits; shift += 8)
+	{
+		memset(counts, 0, sizeof(counts));
+		for (int i = 0; i < n; ++i)
+			counts[(entries[i].key >> shift) & 0xff]++;
+		int sum = 0;
+		for (int b = 0; b < 256; ++b)
+		{
+			const int c = counts[b];
+			counts[b] = sum;
+			sum += c;
+		}
+		for (int i = 0; i < n; ++i)
+			temp[counts[(entries[i].key >> shift) & 0xff]++] = entries[i];
+		dtSwap(entries, temp);
+	}
+}
+
+/// Evaluates the candidates of one center nearest bound first, skipping those
+/// whose bound is already farther than the best polygon.
+static void evaluateNearestCandidates(const dtNavMeshQuery* query, const float* center, const float walkableClimb,
+									  dtNearestCandidate* cands, const int ncands, dtNearestState& state)
+{
+	for (int i = 1; i < ncands; ++i)
+	{
+		const dtNearestCandidate c = cands[i];
+		int j = i - 1;
+		while (j >= 0 && cands[j].bound > c.bound)
+		{
+			cands[j + 1] = cands[j];
+			j--;
+		}
+		cands[j + 1] = c;
+	}
+
+	for (int i = 0; i < ncands; ++i)
+	{
+		const dtNearestCandidate& c = cands[i];
+		if (c.bound > state.distSqr)
+			break;
+
+		float closestPtPoly[3];
+		float diff[3];
+		bool posOverPoly = false;
+		float d;
+		query->closestPointOnPoly(c.ref, center, closestPtPoly, &posOverPoly);
+
+		// Same measure as dtFindNearestPolyQuery.
+		dtVsub(diff, center, closestPtPoly);
+		if (posOverPoly)
+		{
+			d = dtAbs(diff[1]) - walkableClimb;
+			d = d > 0 ? d*d : 0;
+		}
+		else
+		{
+			d = dtVlenSqr(diff);
+		}
+
+		if (d < state.distSqr || (d == state.distSqr && c.seq < state.seq))
+		{
+			dtVcopy(state.pos, closestPtPoly);
+			state.distSqr = d;
+			state.seq = c.seq;
+			state.ref = c.ref;
+			state.overPoly = posOverPoly;
+		}
+	}
+}
+
+/// Adds a candidate for one center, evaluating the center's candidates when they fill up.
+static void addNearestCandidate(const dtNavMeshQuery* query, const float* center, const float walkableClimb,
+								dtNearestCandidate* cands, int& ncands, dtNearestState& state,
+								const float bound, const unsigned long long seq, const dtPolyRef ref)
+{
+	dtNearestCandidate& cand = cands[ncands++];
+	cand.bound = bound;
+	cand.seq = seq;
+	cand.ref = ref;
+	if (ncands == DT_NEAREST_MAX_CANDIDATES)
+	{
+		evaluateNearestCandidates(query, center, walkableClimb, cands, ncands, state);
+		ncands = 0;
+	}
+}
+
+/// Lanes of @p qmin and @p qmax whose quantized boxes overlap the box of @p node, one bit per lane.
+static unsigned int overlapQuantLanes(const unsigned short qmin[3][DT_NEAREST_LANES],
+									  const unsigned short qmax[3][DT_NEAREST_LANES],
+									  const dtBVNode* node)
+{
+#if defined(DT_NEAREST_SSE2)
+	// SSE2 only compares signed 16-bit lanes; flipping the sign bit keeps the unsigned order.
+	const __m128i bias = _mm_set1_epi16((short)0x8000);
+	__m128i outside = _mm_setzero_si128();
+	for (int k = 0; k < 3; ++k)
+	{
+		const __m128i lo = _mm_xor_si128(_mm_loadu_si128((const __m128i*)qmin[k]), bias);
+		const __m128i hi = _mm_xor_si128(_mm_loadu_si128((const __m128i*)qmax[k]), bias);
+		const __m128i nlo = _mm_set1_epi16((short)(node->bmin[k] ^ 0x8000));
+		const __m128i nhi = _mm_set1_epi16((short)(node->bmax[k] ^ 0x8000));
+		outside = _mm_or_si128(outside, _mm_or_si128(_mm_cmpgt_epi16(lo, nhi), _mm_cmpgt_epi16(nlo, hi)));
+	}
+	// One mask bit per byte; pack the 16-bit lanes to bytes first.
+	return (unsigned int)~_mm_movemask_epi8(_mm_packs_epi16(outside, outside)) & 0xff;
+#elif defined(DT_NEAREST_NEON)
+	uint16x8_t outside = vdupq_n_u16(0);
+	for (int k = 0; k < 3; ++k)
+	{
+		const uint16x8_t lo = vld1q_u16(qmin[k]);
+		const uint16x8_t hi = vld1q_u16(qmax[k]);
+		outside = vorrq_u16(outside, vorrq_u16(vcgtq_u16(lo, vdupq_n_u16(node->bmax[k])),
+											   vcgtq_u16(vdupq_n_u16(node->bmin[k]), hi)));
+	}
+	static const unsigned short weights[DT_NEAREST_LANES] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+	return vaddvq_u16(vbicq_u16(vld1q_u16(weights), outside));
+#else
+	unsigned int mask = 0;
+	for (int i = 0; i < DT_NEAREST_LANES; ++i)
+	{
+		if (qmin[0][i] <= node->bmax[0] && qmax[0][i] >= node->bmin[0] &&
+			qmin[1][i] <= node->bmax[1] && qmax[1][i] >= node->bmin[1] &&
+			qmin[2][i] <= node->bmax[2] && qmax[2][i] >= node->bmin[2])
+			mask |= 1u << i;
+	}
+	return mask;
+#endif
+}
+
+/// Searches one tile for up to #DT_NEAREST_LANES centers at once, walking its BV tree a single time.
+static void findNearestPolysInTile(const dtNavMeshQuery* query, const dtMeshTile* tile,
+								   const dtNearestTileEntry* entries, const int nentries,
+								   const float* centers, const float* halfExtents, const dtQueryFilter* filter,
+								   dtNearestState* states)
+{
+	dtAssert(nentries > 0 && nentries <= DT_NEAREST_LANES);
+
+	const dtNavMesh* nav = query->getAttachedNavMesh();
+	const dtPolyRef base = nav->getPolyRefBase(tile);
+	const float walkableClimb = tile->header->walkableClimb;
+
+	dtNearestCandidate cands[DT_NEAREST_LANES][DT_NEAREST_MAX_CANDIDATES];
+	int ncands[DT_NEAREST_LANES];
+	const float* lanePos[DT_NEAREST_LANES];
+	for (int i = 0; i < nentries; ++i)
+	{
+		ncands[i] = 0;
+		lanePos[i] = &centers[entries[i].center * 3];
+	}
+
+	if (tile->bvTree)
+	{
+		const dtBVNode* node = &tile->bvTree[0];
+		const dtBVNode* end = &tile->bvTree[tile->header->bvNodeCount];
+		const float* tbmin = tile->header->bmin;
+		const float* tbmax = tile->header->bmax;
+		const float qfac = tile->header->bvQuantFactor;
+		const float quantum = 1.0f / qfac;
+
+		// Quantized boxes of the lanes, exactly as queryPolygonsInTile makes them.
+		// Unused lanes get an empty box.
+		unsigned short qmin[3][DT_NEAREST_LANES];
+		unsigned short qmax[3][DT_NEAREST_LANES];
+		for (int i = 0; i < DT_NEAREST_LANES; ++i)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				if (i >= nentries)
+				{
+					qmin[k][i] = 0xffff;
+					qmax[k][i] = 0;
+					continue;
+				}
+				const float lo = dtClamp(lanePos[i][k] - halfExtents[k], tbmin[k], tbmax[k]) - tbmin[k];
+				const float hi = dtClamp(lanePos[i][k] + halfExtents[k], tbmin[k], tbmax[k]) - tbmin[k];
+				qmin[k][i] = (unsigned short)(qfac * lo) & 0xfffe;
+				qmax[k][i] = (unsigned short)(qfac * hi + 1) | 1;
+			}
+		}
+
+		// Descend where any lane overlaps, which visits exactly the nodes
+		// the lanes would visit one by one, each of them once.
+		while (node < end)
+		{
+			const unsigned int lanes = overlapQuantLanes(qmin, qmax, node);
+			const bool isLeafNode = node->i >= 0;
+
+			if (isLeafNode && lanes)
+			{
+				const dtPolyRef ref = base | (dtPolyRef)node->i;
+				if (filter->passFilter(ref, tile, &tile->polys[node->i]))
+				{
+					// The node box widened by a quantum holds the polygon and its detail mesh,
+					// whose bounds were truncated when quantized.
+					float nmin[3], nmax[3];
+					for (int k = 0; k < 3; ++k)
+					{
+						nmin[k] = tbmin[k] + (node->bmin[k] - 1) * quantum;
+						nmax[k] = tbmin[k] + (node->bmax[k] + 1) * quantum;
+					}
+					const unsigned int visit = (unsigned int)(node - tile->bvTree);
+					for (int i = 0; i < nentries; ++i)
+					{
+						if (!(lanes & (1u << i)))
+							continue;
+						const float* c = lanePos[i];
+						float d2 = 0;
+						for (int k = 0; k < 3; ++k)
+						{
+							const float d = dtMax(dtMax(nmin[k] - c[k], c[k] - nmax[k]), 0.0f);
+							d2 += d*d;
+						}
+						// Over the polygon the measure is the height above it less the climb,
+						// which the box distance less the climb also bounds.
+						float bound = dtMathSqrtf(d2) - walkableClimb;
+						bound = bound > 0 ? bound*bound : 0;
+						dtNearestState& state = states[entries[i].center];
+						if (bound > state.distSqr)
+							continue;
+						addNearestCandidate(query, c, walkableClimb, cands[i], ncands[i], state, bound,
+											((unsigned long long)entries[i].order << 32) | visit, ref);
+					}
+				}
+			}
+
+			if (lanes || isLeafNode)
+				node++;
+			else
+			{
+				const int escapeIndex = -node->i;
+				node += escapeIndex;
+			}
+		}
+	}
+	else
+	{
+		// Without a BV tree the detail mesh may rise above the polygon bounds, so
+		// every overlapping polygon is evaluated, in visit order.
+		float bmin[3], bmax[3];
+		for (int p = 0; p < tile->header->polyCount; ++p)
+		{
+			const dtPoly* poly = &tile->polys[p];
+			if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+				continue;
+			const dtPolyRef ref = base | (dtPolyRef)p;
+			if (!filter->passFilter(ref, tile, poly))
+				continue;
+			const float* v = &tile->verts[poly->verts[0]*3];
+			dtVcopy(bmin, v);
+			dtVcopy(bmax, v);
+			for (int j = 1; j < poly->vertCount; ++j)
+			{
+				v = &tile->verts[poly->verts[j]*3];
+				dtVmin(bmin, v);
+				dtVmax(bmax, v);
+			}
+			for (int i = 0; i < nentries; ++i)
+			{
+				float qmin[3], qmax[3];
+				dtVsub(qmin, lanePos[i], halfExtents);
+				dtVadd(qmax, lanePos[i], halfExtents);
+				if (!dtOverlapBounds(qmin, qmax, bmin, bmax))
+					continue;
+				addNearestCandidate(query, lanePos[i], walkableClimb, cands[i], ncands[i], states[entries[i].center], 0,
+									((unsigned long long)entries[i].order << 32) | (unsigned int)p, ref);
+			}
+		}
+	}
+
+	for (int i = 0; i < nentries; ++i)
+	{
+		if (ncands[i] > 0)
+			evaluateNearestCandidates(query, lanePos[i], walkableClimb, cands[i], ncands[i], states[entries[i].center]);
+	}
+}
+
+/// @par
+///
+/// The centers are grouped by the tiles their search boxes overlap, nearby
+/// centers next to each other, and each tile is searched for up to eight
+/// centers at a time: its BV tree is walked once for them, with one
+/// vectorized box test per node, and for every center the overlapping
+/// polygons are measured nearest bound first so that most of them are
+/// rejected without computing their closest point. Ties between equally near
+/// polygons are broken as findNearestPoly breaks them.
+///
+/// A center whose search box intersects no polygon gets a @p nearestRefs of
+/// zero, and the call still returns #DT_SUCCESS.
+///
+dtStatus dtNavMeshQuery::findNearestPolys(const float* centers, const int count, const float* halfExtents,
+										  const dtQueryFilter* filter,
+										  dtPolyRef* nearestRefs, float* nearestPts, bool* isOverPoly) const
+{
+	dtAssert(m_nav);
+
+	if (!centers || count < 0 || !halfExtents || !dtVisfinite(halfExtents) || !filter || !nearestRefs)
+		return DT_FAILURE | DT_INVALID_PARAM;
+	if (count == 0)
+		return DT_SUCCESS;
+
+	static const int MAX_NEIS = 32;
+	const dtMeshTile* neis[MAX_NEIS];
+
+	// Count the tiles of every center, then list them.
+	int nentries = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		const float* c = &centers[i * 3];
+		if (!dtVisfinite(c))
+			continue;
+		float bmin[3], bmax[3];
+		dtVsub(bmin, c, halfExtents);
+		dtVadd(bmax, c, halfExtents);
+		int minx, miny, maxx, maxy;
+		m_nav->calcTileLoc(bmin, &minx, &miny);
+		m_nav->calcTileLoc(bmax, &maxx, &maxy);
+		for (int y = miny; y <= maxy; ++y)
+			for (int x = minx; x <= maxx; ++x)
+				nentries += m_nav->getTilesAt(x, y, neis, MAX_NEIS);
+	}
+
+	dtMemoryOwnerScope owner(DT_MEMORY_QUERY);
+	dtNearestState* states = (dtNearestState*)dtAlloc(sizeof(dtNearestState)*count, DT_ALLOC_TEMP);
+	dtNearestTileEntry* entries = 0;
+	dtNearestTileEntry* temp = 0;
+	if (nentries > 0)
+	{
+		entries = (dtNearestTileEntry*)dtAlloc(sizeof(dtNearestTileEntry)*nentries, DT_ALLOC_TEMP);
+		temp = (dtNearestTileEntry*)dtAlloc(sizeof(dtNearestTileEntry)*nentries, DT_ALLOC_TEMP);
+	}
+	if (!states || (nentries > 0 && (!entries || !temp)))
+	{
+		dtFree(states);
+		dtFree(entries);
+		dtFree(temp);
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+	}
+
+	const dtMeshTile* firstTile = m_nav->getTile(0);
+	int n = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		dtNearestState& state = states[i];
+		state.distSqr = FLT_MAX;
+		state.seq = ~0ull;
+		state.ref = 0;
+		state.overPoly = false;
+
+		const float* c = &centers[i * 3];
+		if (!dtVisfinite(c))
+			continue;
+		float bmin[3], bmax[3];
+		dtVsub(bmin, c, halfExtents);
+		dtVadd(bmax, c, halfExtents);
+		int minx, miny, maxx, maxy;
+		m_nav->calcTileLoc(bmin, &minx, &miny);
+		m_nav->calcTileLoc(bmax, &maxx, &maxy);
+		unsigned int order = 0;
+		for (int y = miny; y <= maxy; ++y)
+		{
+			for (int x = minx; x <= maxx; ++x)
+			{
+				const int nneis = m_nav->getTilesAt(x, y, neis, MAX_NEIS);
+				for (int j = 0; j < nneis; ++j)
+				{
+					const dtMeshTile* tile = neis[j];
+					const float* tbmin = tile->header->bmin;
+					const float* tbmax = tile->header->bmax;
+					const float sx = tbmax[0] > tbmin[0] ? 255.0f / (tbmax[0] - tbmin[0]) : 0.0f;
+					const float sz = tbmax[2] > tbmin[2] ? 255.0f / (tbmax[2] - tbmin[2]) : 0.0f;
+					const unsigned int cx = (unsigned int)dtClamp((c[0] - tbmin[0]) * sx, 0.0f, 255.0f);
+					const unsigned int cz = (unsigned int)dtClamp((c[2] - tbmin[2]) * sz, 0.0f, 255.0f);
+
+					dtNearestTileEntry& e = entries[n++];
+					e.key = ((unsigned long long)(tile - firstTile) << 16) | spreadBits8(cx) | (spreadBits8(cz) << 1);
+					e.center = i;
+					e.order = order++;
+				}
+			}
+		}
+	}
+	dtAssert(n == nentries);
+
+	if (nentries > 1)
+	{
+		int keyBits = 16;
+		while (keyBits < 64 && (1ull << (keyBits - 16)) < (unsigned long long)m_nav->getMaxTiles())
+			keyBits++;
+		sortNearestTileEntries(entries, temp, nentries, keyBits);
+	}
+
+	int i = 0;
+	while (i < nentries)
+	{
+		const unsigned long long tileIndex = entries[i].key >> 16;
+		int j = i + 1;
+		while (j < nentries && j - i < DT_NEAREST_LANES && (entries[j].key >> 16) == tileIndex)
+			j++;
+		findNearestPolysInTile(this, &firstTile[tileIndex], &entries[i], j - i, centers, halfExtents, filter, states);
+		i = j;
+	}
+
+	for (int c = 0; c < count; ++c)
+	{
+		const dtNearestState& state = states[c];
+		nearestRefs[c] = state.ref;
+		if (nearestPts && state.ref)
+		{
+			dtVcopy(&nearestPts[c * 3], state.pos);
+			if (isOverPoly)
+				isOverPoly[c] = state.overPoly;
+		}
+	}
+
+	dtFree(temp);
+	dtFree(entries);
+	dtFree(states);
+
+	return DT_SUCCESS;
+}
+
 void dtNavMeshQuery::queryPolygonsInTile(const dtMeshTile* tile, const float* qmin, const float* qmax,
 										 const dtQueryFilter* filter, dtPolyQuery* query) const
 {
@@ -1027,6 +1507,9 @@ dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
 	dtNode* lastBestNode = startNode;
 	float lastBestNodeCost = startNode->total;
 	
+	dtLandmarkGoal landmarkGoal;
+	const bool useLandmarks = m_landmarks && m_landmarks->matches(filter) && m_landmarks->prepareGoal(endRef, endPos, landmarkGoal);
+	
 	bool outOfNodes = false;
 	
 	while (!m_openList->empty())
@@ -1100,6 +1583,7 @@ dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
 			// Calculate cost and heuristic.
 			float cost = 0;
 			float heuristic = 0;
+			float distance = 0;
 			
 			// Special case for last node.
 			if (neighbourRef == endRef)
@@ -1125,7 +1609,14 @@ dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
 													  bestRef, bestTile, bestPoly,
 													  neighbourRef, neighbourTile, neighbourPoly);
 				cost = bestNode->cost + curCost;
-				heuristic = dtVdist(neighbourNode->pos, endPos)*H_SCALE;
+				distance = dtVdist(neighbourNode->pos, endPos)*H_SCALE;
+				heuristic = distance;
+				if (useLandmarks)
+				{
+					const float bound = m_landmarks->estimate(landmarkGoal, neighbourNode->pos, bestTile, bestPoly, &bestTile->links[i],
+															  neighbourTile, neighbourPoly);
+					heuristic = dtMax(heuristic, bound*H_SCALE);
+				}
 			}
 
 			const float total = cost + heuristic;
@@ -1156,10 +1647,10 @@ dtStatus dtNavMeshQuery::findPath(dtPolyRef startRef, dtPolyRef endRef,
 				m_openList->push(neighbourNode);
 			}
 			
-			// Update nearest node to target so far.
-			if (heuristic < lastBestNodeCost)
+			// Update nearest node to target so far, by straight-line distance.
+			if (distance < lastBestNodeCost)
 			{
-				lastBestNodeCost = heuristic;
+				lastBestNodeCost = distance;
 				lastBestNode = neighbourNode;
 			}
 		}
@@ -1285,6 +1776,8 @@ dtStatus dtNavMeshQuery::initSlicedFindPath(dtPolyRef startRef, dtPolyRef endRef
 	m_query.status = DT_IN_PROGRESS;
 	m_query.lastBestNode = startNode;
 	m_query.lastBestNodeCost = startNode->total;
+	m_query.useLandmarks = m_landmarks && m_landmarks->matches(filter) &&
+		m_landmarks->prepareGoal(endRef, m_query.endPos, m_query.landmarkGoal);
 	
 	return m_query.status;
 }
@@ -1412,6 +1905,7 @@ dtStatus dtNavMeshQuery::updateSlicedFindPath(const int maxIter, int* doneIters)
 			// Calculate cost and heuristic.
 			float cost = 0;
 			float heuristic = 0;
+			float distance = 0;
 			
 			// raycast parent
 			bool foundShortCut = false;
@@ -1451,7 +1945,14 @@ dtStatus dtNavMeshQuery::updateSlicedFindPath(const int maxIter, int* doneIters)
 			}
 			else
 			{
-				heuristic = dtVdist(neighbourNode->pos, m_query.endPos)*H_SCALE;
+				distance = dtVdist(neighbourNode->pos, m_query.endPos)*H_SCALE;
+				heuristic = distance;
+				if (m_query.useLandmarks)
+				{
+					const float bound = m_landmarks->estimate(m_query.landmarkGoal, neighbourNode->pos, bestTile, bestPoly, &bestTile->links[i],
+															  neighbourTile, neighbourPoly);
+					heuristic = dtMax(heuristic, bound*H_SCALE);
+				}
 			}
 			
 			const float total = cost + heuristic;
@@ -1484,10 +1985,10 @@ dtStatus dtNavMeshQuery::updateSlicedFindPath(const int maxIter, int* doneIters)
 				m_openList->push(neighbourNode);
 			}
 			
-			// Update nearest node to target so far.
-			if (heuristic < m_query.lastBestNodeCost)
+			// Update nearest node to target so far, by straight-line distance.
+			if (distance < m_query.lastBestNodeCost)
 			{
-				m_query.lastBestNodeCost = heuristic;
+				m_query.lastBestNodeCost = distance;
 				m_query.lastBestNode = neighbourNode;
 			}
 		}
@@ -22,28 +22,20 @@
 #include "DetourCommon.h"
 #include <string.h>
 
+// Fibonacci hashing: one multiply spreads the low bits of the ref, where the
+// polygon index changes, over the whole word, and folding the high half down
+// brings the best-mixed bits to where the bucket mask reads them.
 #ifdef DT_POLYREF64
-// From Thomas Wang, https://gist.github.com/badboy/6267743
 inline unsigned int dtHashRef(dtPolyRef a)
 {
-	a = (~a) + (a << 18); // a = (a << 18) - a - 1;
-	a = a ^ (a >> 31);
-	a = a * 21; // a = (a + (a << 2)) + (a << 4);
-	a = a ^ (a >> 11);
-	a = a + (a << 6);
-	a = a ^ (a >> 22);
-	return (unsigned int)a;
+	const unsigned long long h = (unsigned long long)a * 0x9E3779B97F4A7C15ull;
+	return (unsigned int)(h >> 32) ^ (unsigned int)h;
 }
 #else
 inline unsigned int dtHashRef(dtPolyRef a)
 {
-	a += ~(a<<15);
-	a ^=  (a>>10);
-	a +=  (a<<3);
-	a ^=  (a>>6);
-	a += ~(a<<11);
-	a ^=  (a>>16);
-	return (unsigned int)a;
+	const unsigned int h = a * 0x9E3779B1u;
+	return h ^ (h >> 16);
 }
 #endif
 
@@ -54,7 +46,8 @@ dtNodePool::dtNodePool(int maxNodes, int hashSize) :
 	m_next(0),
 	m_maxNodes(maxNodes),
 	m_hashSize(hashSize),
-	m_nodeCount(0)
+	m_nodeCount(0),
+	m_generation(1)
 {
 	dtAssert(dtNextPow2(m_hashSize) == (unsigned int)m_hashSize);
 	// pidx is special as 0 means "none" and 1 is the first node. For that reason
@@ -63,13 +56,14 @@ dtNodePool::dtNodePool(int maxNodes, int hashSize) :
 
 	m_nodes = (dtNode*)dtAlloc(sizeof(dtNode)*m_maxNodes, DT_ALLOC_PERM);
 	m_next = (dtNodeIndex*)dtAlloc(sizeof(dtNodeIndex)*m_maxNodes, DT_ALLOC_PERM);
-	m_first = (dtNodeIndex*)dtAlloc(sizeof(dtNodeIndex)*hashSize, DT_ALLOC_PERM);
+	m_first = (unsigned int*)dtAlloc(sizeof(unsigned int)*hashSize, DT_ALLOC_PERM);
 
 	dtAssert(m_nodes);
 	dtAssert(m_next);
 	dtAssert(m_first);
 
-	memset(m_first, 0xff, sizeof(dtNodeIndex)*m_hashSize);
+	// Generation 0 is never current, so zeroed buckets are empty.
+	memset(m_first, 0, sizeof(unsigned int)*m_hashSize);
 	memset(m_next, 0xff, sizeof(dtNodeIndex)*m_maxNodes);
 }
 
@@ -82,15 +76,19 @@ dtNodePool::~dtNodePool()
 
 void dtNodePool::clear()
 {
-	memset(m_first, 0xff, sizeof(dtNodeIndex)*m_hashSize);
 	m_nodeCount = 0;
+	if (++m_generation > 0xffff)
+	{
+		memset(m_first, 0, sizeof(unsigned int)*m_hashSize);
+		m_generation = 1;
+	}
 }
 
 unsigned int dtNodePool::findNodes(dtPolyRef id, dtNode** nodes, const int maxNodes)
 {
 	int n = 0;
 	unsigned int bucket = dtHashRef(id) & (m_hashSize-1);
-	dtNodeIndex i = m_first[bucket];
+	dtNodeIndex i = first(bucket);
 	while (i != DT_NULL_IDX)
 	{
 		if (m_nodes[i].id == id)
@@ -108,7 +106,7 @@ unsigned int dtNodePool::findNodes(dtPolyRef id, dtNode** nodes, const int maxNo
 dtNode* dtNodePool::findNode(dtPolyRef id, unsigned char state)
 {
 	unsigned int bucket = dtHashRef(id) & (m_hashSize-1);
-	dtNodeIndex i = m_first[bucket];
+	dtNodeIndex i = first(bucket);
 	while (i != DT_NULL_IDX)
 	{
 		if (m_nodes[i].id == id && m_nodes[i].state == state)
@@ -121,7 +119,7 @@ dtNode* dtNodePool::findNode(dtPolyRef id, unsigned char state)
 dtNode* dtNodePool::getNode(dtPolyRef id, unsigned char state)
 {
 	unsigned int bucket = dtHashRef(id) & (m_hashSize-1);
-	dtNodeIndex i = m_first[bucket];
+	dtNodeIndex i = first(bucket);
 	dtNode* node = 0;
 	while (i != DT_NULL_IDX)
 	{
@@ -145,8 +143,8 @@ dtNode* dtNodePool::getNode(dtPolyRef id, unsigned char state)
 	node->state = state;
 	node->flags = 0;
 	
-	m_next[i] = m_first[bucket];
-	m_first[bucket] = i;
+	m_next[i] = first(bucket);
+	m_first[bucket] = (m_generation << 16) | i;
 	
 	return node;
 }
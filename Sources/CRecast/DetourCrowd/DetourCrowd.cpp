@@ -20,7 +20,9 @@
 #include <float.h>
 #include <stdlib.h>
 #include <new>
+#include <chrono>
 #include "DetourCrowd.h"
+#include "DetourFlowField.h"
 #include "DetourNavMesh.h"
 #include "DetourNavMeshQuery.h"
 #include "DetourObstacleAvoidance.h"
@@ -28,9 +30,20 @@
 #include "DetourMath.h"
 #include "DetourAssert.h"
 #include "DetourAlloc.h"
+#include "DetourMemory.h"
+
+// dtCrowd::update() can split its per-agent phases across threads (see
+// dtCrowd::setUpdateThreads). Define DT_DISABLE_THREADS to always update on
+// the calling thread.
+#ifndef DT_DISABLE_THREADS
+#	include <condition_variable>
+#	include <mutex>
+#	include <thread>
+#endif
 
 dtCrowd* dtAllocCrowd()
 {
+	dtMemoryOwnerScope owner(DT_MEMORY_CROWD);
 	void* mem = dtAlloc(sizeof(dtCrowd), DT_ALLOC_PERM);
 	if (!mem) return 0;
 	return new(mem) dtCrowd;
@@ -44,11 +57,168 @@ void dtFreeCrowd(dtCrowd* ptr)
 }
 
 
-static const int MAX_ITERS_PER_UPDATE = 100;
+static const int DEFAULT_PATHQUEUE_ITERS = 100;
 
 static const int MAX_PATHQUEUE_NODES = 4096;
 static const int MAX_COMMON_NODES = 512;
 
+/// Crowds with fewer active agents than this update on the calling thread.
+static const int DT_CROWD_MIN_PARALLEL_AGENTS = 64;
+
+/// A fixed set of threads that runs a job over [0, count) with one
+/// contiguous range per thread, the calling thread taking the first range.
+/// Jobs only ever write to the agents of their own range, so the result does
+/// not depend on the number of threads.
+class dtCrowdWorkers
+{
+public:
+	explicit dtCrowdWorkers(int numThreads);
+	~dtCrowdWorkers();
+
+	int size() const { return m_numThreads; }
+
+	/// Calls job(worker, begin, end) for each thread's range of [0, count).
+	template<class Job>
+	void run(const int count, const Job& job)
+	{
+#ifndef DT_DISABLE_THREADS
+		if (m_numThreads > 1 && count >= DT_CROWD_MIN_PARALLEL_AGENTS)
+		{
+			dispatch(count, &invoke<Job>, &job);
+			return;
+		}
+#endif
+		job(0, 0, count);
+	}
+
+private:
+	typedef void (*JobFunc)(const void* job, int worker, int begin, int end);
+
+	template<class Job>
+	static void invoke(const void* job, int worker, int begin, int end)
+	{
+		(*(const Job*)job)(worker, begin, end);
+	}
+
+	int m_numThreads;
+
+#ifndef DT_DISABLE_THREADS
+	void dispatch(int count, JobFunc func, const void* job);
+	void workerMain(int worker);
+	void runRange(int worker);
+
+	std::thread m_threads[DT_CROWD_MAX_THREADS];
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	unsigned int m_generation;
+	int m_pending;
+	bool m_quit;
+	JobFunc m_func;
+	const void* m_job;
+	int m_count;
+#endif
+
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtCrowdWorkers(const dtCrowdWorkers&);
+	dtCrowdWorkers& operator=(const dtCrowdWorkers&);
+};
+
+dtCrowdWorkers::dtCrowdWorkers(int numThreads)
+{
+#ifdef DT_DISABLE_THREADS
+	dtIgnoreUnused(numThreads);
+	m_numThreads = 1;
+#else
+	m_numThreads = dtClamp(numThreads, 1, DT_CROWD_MAX_THREADS);
+	m_generation = 0;
+	m_pending = 0;
+	m_quit = false;
+	m_func = 0;
+	m_job = 0;
+	m_count = 0;
+	for (int i = 1; i < m_numThreads; ++i)
+		m_threads[i] = std::thread(&dtCrowdWorkers::workerMain, this, i);
+#endif
+}
+
+dtCrowdWorkers::~dtCrowdWorkers()
+{
+#ifndef DT_DISABLE_THREADS
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+	for (int i = 1; i < m_numThreads; ++i)
+		m_threads[i].join();
+#endif
+}
+
+#ifndef DT_DISABLE_THREADS
+void dtCrowdWorkers::runRange(int worker)
+{
+	const int begin = (int)((long long)m_count * worker / m_numThreads);
+	const int end = (int)((long long)m_count * (worker + 1) / m_numThreads);
+	if (begin < end)
+		m_func(m_job, worker, begin, end);
+}
+
+void dtCrowdWorkers::dispatch(int count, JobFunc func, const void* job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_func = func;
+		m_job = job;
+		m_count = count;
+		m_pending = m_numThreads - 1;
+		++m_generation;
+	}
+	m_wake.notify_all();
+
+	runRange(0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this]() { return m_pending == 0; });
+}
+
+void dtCrowdWorkers::workerMain(int worker)
+{
+	unsigned int seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&]() { return m_quit || m_generation != seen; });
+			if (m_quit)
+				return;
+			seen = m_generation;
+		}
+
+		runRange(worker);
+
+		bool last;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			last = --m_pending == 0;
+		}
+		if (last)
+			m_done.notify_one();
+	}
+}
+#endif
+
+// Runs job(worker, begin, end) on the crowd's update threads, or on the
+// calling thread for crowds without any.
+template<class Job>
+static void runAgentJob(dtCrowdWorkers* workers, const int count, const Job& job)
+{
+	if (workers)
+		workers->run(count, job);
+	else
+		job(0, 0, count);
+}
+
 inline float tween(const float t, const float t0, const float t1)
 {
 	return dtClamp((t-t0) / (t1-t0), 0.0f, 1.0f);
@@ -183,39 +353,6 @@ static int addNeighbour(const int idx, const float dist,
 	return dtMin(nneis+1, maxNeis);
 }
 
-static int getNeighbours(const float* pos, const float height, const float range,
-						 const dtCrowdAgent* skip, dtCrowdNeighbour* result, const int maxResult,
-						 dtCrowdAgent** agents, const int /*nagents*/, dtProximityGrid* grid)
-{
-	int n = 0;
-	
-	static const int MAX_NEIS = 32;
-	unsigned short ids[MAX_NEIS];
-	int nids = grid->queryItems(pos[0]-range, pos[2]-range,
-								pos[0]+range, pos[2]+range,
-								ids, MAX_NEIS);
-	
-	for (int i = 0; i < nids; ++i)
-	{
-		const dtCrowdAgent* ag = agents[ids[i]];
-		
-		if (ag == skip) continue;
-		
-		// Check for overlap.
-		float diff[3];
-		dtVsub(diff, pos, ag->npos);
-		if (dtMathFabsf(diff[1]) >= (height+ag->params.height)/2.0f)
-			continue;
-		diff[1] = 0;
-		const float distSqr = dtVlenSqr(diff);
-		if (distSqr > dtSqr(range))
-			continue;
-		
-		n = addNeighbour(ids[i], distSqr, result, n, maxResult);
-	}
-	return n;
-}
-
 static int addToOptQueue(dtCrowdAgent* newag, dtCrowdAgent** agents, const int nagents, const int maxAgents)
 {
 	// Insert neighbour based on greatest time.
@@ -252,15 +389,24 @@ static int addToOptQueue(dtCrowdAgent* newag, dtCrowdAgent** agents, const int n
 	return dtMin(nagents+1, maxAgents);
 }
 
+// True if agent a goes to the path queue before agent b: higher band first,
+// then the one that has gone longest without a replan.
+static bool pathRequestBefore(const dtCrowdAgent* a, const dtCrowdAgent* b)
+{
+	if (a->pathPriority != b->pathPriority)
+		return a->pathPriority > b->pathPriority;
+	return a->targetReplanTime > b->targetReplanTime;
+}
+
 static int addToPathQueue(dtCrowdAgent* newag, dtCrowdAgent** agents, const int nagents, const int maxAgents)
 {
-	// Insert neighbour based on greatest time.
+	// Insert neighbour based on band, then greatest time.
 	int slot = 0;
 	if (!nagents)
 	{
 		slot = nagents;
 	}
-	else if (newag->targetReplanTime <= agents[nagents-1]->targetReplanTime)
+	else if (!pathRequestBefore(newag, agents[nagents-1]))
 	{
 		if (nagents >= maxAgents)
 			return nagents;
@@ -270,7 +416,7 @@ static int addToPathQueue(dtCrowdAgent* newag, dtCrowdAgent** agents, const int
 	{
 		int i;
 		for (i = 0; i < nagents; ++i)
-			if (newag->targetReplanTime >= agents[i]->targetReplanTime)
+			if (!pathRequestBefore(agents[i], newag))
 				break;
 		
 		const int tgt = i+1;
@@ -332,14 +478,51 @@ dtCrowd::dtCrowd() :
 	m_agents(0),
 	m_activeAgents(0),
 	m_agentAnims(0),
+	m_pathqCandidates(0),
+	m_pathqMaxIters(DEFAULT_PATHQUEUE_ITERS),
+	m_pathqMaxTimeMs(0),
+	m_pathqWaiting(0),
+	m_pathqCompleted(0),
+	m_pathqFailed(0),
+	m_pathqLastLatency(0),
+	m_pathqLatencySum(0),
+	m_pathqMaxLatency(0),
 	m_obstacleQuery(0),
 	m_grid(0),
+	m_gridPoints(0),
+	m_activeIndex(0),
+	m_maxNeighbours(6),
+	m_agentPos(0),
+	m_agentVel(0),
+	m_agentDvel(0),
+	m_agentRadius(0),
+	m_agentHeight(0),
+	m_agentState(0),
+	m_lodAuto(false),
 	m_pathResult(0),
 	m_maxPathResult(0),
 	m_maxAgentRadius(0),
 	m_velocitySampleCount(0),
-	m_navquery(0)
+	m_pathRequestCount(0),
+	m_pathReplanCount(0),
+	m_profiling(false),
+	m_profileWindow(0),
+	m_profileCallback(0),
+	m_profileUserData(0),
+	m_profilePhase(-1),
+	m_profilePhaseStart(0),
+	m_navquery(0),
+	m_workers(0),
+	m_numThreads(1)
 {
+	memset(m_threadNavQuery, 0, sizeof(m_threadNavQuery));
+	memset(m_threadObstacleQuery, 0, sizeof(m_threadObstacleQuery));
+	memset(m_threadSampleCount, 0, sizeof(m_threadSampleCount));
+	memset(m_lodParams, 0, sizeof(m_lodParams));
+	dtVset(m_lodReference, 0,0,0);
+	memset(&m_profile, 0, sizeof(m_profile));
+	memset(&m_profileDone, 0, sizeof(m_profileDone));
+	memset(m_profileUpdate, 0, sizeof(m_profileUpdate));
 }
 
 dtCrowd::~dtCrowd()
@@ -347,8 +530,32 @@ dtCrowd::~dtCrowd()
 	purge();
 }
 
+void dtCrowd::freeThreads()
+{
+	if (m_workers)
+	{
+		m_workers->~dtCrowdWorkers();
+		dtFree(m_workers);
+		m_workers = 0;
+	}
+	for (int i = 1; i < DT_CROWD_MAX_THREADS; ++i)
+	{
+		dtFreeNavMeshQuery(m_threadNavQuery[i]);
+		m_threadNavQuery[i] = 0;
+		dtFreeObstacleAvoidanceQuery(m_threadObstacleQuery[i]);
+		m_threadObstacleQuery[i] = 0;
+	}
+	m_threadNavQuery[0] = m_navquery;
+	m_threadObstacleQuery[0] = m_obstacleQuery;
+	m_numThreads = 1;
+}
+
 void dtCrowd::purge()
 {
+	freeThreads();
+	m_threadNavQuery[0] = 0;
+	m_threadObstacleQuery[0] = 0;
+
 	for (int i = 0; i < m_maxAgents; ++i)
 		m_agents[i].~dtCrowdAgent();
 	dtFree(m_agents);
@@ -364,8 +571,28 @@ void dtCrowd::purge()
 	dtFree(m_pathResult);
 	m_pathResult = 0;
 	
+	dtFree(m_pathqCandidates);
+	m_pathqCandidates = 0;
+	
 	dtFreeProximityGrid(m_grid);
 	m_grid = 0;
+	dtFree(m_gridPoints);
+	m_gridPoints = 0;
+	dtFree(m_activeIndex);
+	m_activeIndex = 0;
+
+	dtFree(m_agentPos);
+	m_agentPos = 0;
+	dtFree(m_agentVel);
+	m_agentVel = 0;
+	dtFree(m_agentDvel);
+	m_agentDvel = 0;
+	dtFree(m_agentRadius);
+	m_agentRadius = 0;
+	dtFree(m_agentHeight);
+	m_agentHeight = 0;
+	dtFree(m_agentState);
+	m_agentState = 0;
 
 	dtFreeObstacleAvoidanceQuery(m_obstacleQuery);
 	m_obstacleQuery = 0;
@@ -379,6 +606,7 @@ void dtCrowd::purge()
 /// May be called more than once to purge and re-initialize the crowd.
 bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* nav)
 {
+	dtMemoryOwnerScope owner(DT_MEMORY_CROWD);
 	purge();
 	
 	m_maxAgents = maxAgents;
@@ -392,11 +620,33 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 		return false;
 	if (!m_grid->init(m_maxAgents*4, maxAgentRadius*3))
 		return false;
+	m_gridPoints = (float*)dtAlloc(sizeof(float)*2*m_maxAgents, DT_ALLOC_PERM);
+	if (!m_gridPoints)
+		return false;
+	m_activeIndex = (int*)dtAlloc(sizeof(int)*m_maxAgents, DT_ALLOC_PERM);
+	if (!m_activeIndex)
+		return false;
+	m_maxNeighbours = dtMin(6, DT_CROWDAGENT_MAX_NEIGHBOURS);
+	
+	m_agentPos = (float*)dtAlloc(sizeof(float)*3*m_maxAgents, DT_ALLOC_PERM);
+	m_agentVel = (float*)dtAlloc(sizeof(float)*3*m_maxAgents, DT_ALLOC_PERM);
+	m_agentDvel = (float*)dtAlloc(sizeof(float)*3*m_maxAgents, DT_ALLOC_PERM);
+	m_agentRadius = (float*)dtAlloc(sizeof(float)*m_maxAgents, DT_ALLOC_PERM);
+	m_agentHeight = (float*)dtAlloc(sizeof(float)*m_maxAgents, DT_ALLOC_PERM);
+	m_agentState = (unsigned char*)dtAlloc(sizeof(unsigned char)*m_maxAgents, DT_ALLOC_PERM);
+	if (!m_agentPos || !m_agentVel || !m_agentDvel || !m_agentRadius || !m_agentHeight || !m_agentState)
+		return false;
+	memset(m_agentPos, 0, sizeof(float)*3*m_maxAgents);
+	memset(m_agentVel, 0, sizeof(float)*3*m_maxAgents);
+	memset(m_agentDvel, 0, sizeof(float)*3*m_maxAgents);
+	memset(m_agentRadius, 0, sizeof(float)*m_maxAgents);
+	memset(m_agentHeight, 0, sizeof(float)*m_maxAgents);
+	memset(m_agentState, DT_CROWDAGENT_STATE_INVALID, sizeof(unsigned char)*m_maxAgents);
 	
 	m_obstacleQuery = dtAllocObstacleAvoidanceQuery();
 	if (!m_obstacleQuery)
 		return false;
-	if (!m_obstacleQuery->init(6, 8))
+	if (!m_obstacleQuery->init(DT_CROWDAGENT_MAX_NEIGHBOURS, 8))
 		return false;
 
 	// Init obstacle query params.
@@ -416,6 +666,16 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 		params->adaptiveDepth = 5;
 	}
 	
+	// Init level of detail tiers, all agents start in the first.
+	static const dtCrowdLodParams defaultLod[DT_CROWD_MAX_LOD_TIERS] = {
+		{ 0.0f, 0.0f, 1.0f, DT_CROWD_LOD_STEER_FULL },
+		{ 30.0f, 0.1f, 2.0f, DT_CROWD_LOD_STEER_FULL },
+		{ 60.0f, 0.25f, 4.0f, DT_CROWD_LOD_STEER_SEPARATION },
+		{ 120.0f, 0.5f, 8.0f, DT_CROWD_LOD_STEER_DIRECT },
+	};
+	memcpy(m_lodParams, defaultLod, sizeof(m_lodParams));
+	m_lodAuto = false;
+	
 	// Allocate temp buffer for merging paths.
 	m_maxPathResult = 256;
 	m_pathResult = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*m_maxPathResult, DT_ALLOC_PERM);
@@ -424,6 +684,13 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 	
 	if (!m_pathq.init(m_maxPathResult, MAX_PATHQUEUE_NODES, nav))
 		return false;
+	m_pathqCandidates = (dtCrowdAgent**)dtAlloc(sizeof(dtCrowdAgent*)*m_pathq.getMaxRequests(), DT_ALLOC_PERM);
+	if (!m_pathqCandidates)
+		return false;
+	m_pathqMaxIters = DEFAULT_PATHQUEUE_ITERS;
+	m_pathqMaxTimeMs = 0;
+	resetPathQueueStats();
+	m_pathqWaiting = 0;
 	
 	m_agents = (dtCrowdAgent*)dtAlloc(sizeof(dtCrowdAgent)*m_maxAgents, DT_ALLOC_PERM);
 	if (!m_agents)
@@ -456,10 +723,312 @@ bool dtCrowd::init(const int maxAgents, const float maxAgentRadius, dtNavMesh* n
 		return false;
 	if (dtStatusFailed(m_navquery->init(nav, MAX_COMMON_NODES)))
 		return false;
+
+	m_threadNavQuery[0] = m_navquery;
+	m_threadObstacleQuery[0] = m_obstacleQuery;
+	
+	return true;
+}
+
+/// @par
+///
+/// Every thread past the first gets its own #dtNavMeshQuery and
+/// #dtObstacleAvoidanceQuery, sized like the crowd's. The path validity
+/// checks, neighbourhood and corner updates, off-mesh triggers, steering,
+/// velocity planning, integration, collision resolution and corridor moves
+/// then run over contiguous ranges of the active agents. Each agent only
+/// writes its own state within a phase, and reads the others' state from the
+/// phase before, so the results are identical for any number of threads.
+/// Move requests, the path queue and topology optimization stay on the
+/// calling thread.
+///
+/// Crowds with fewer than 64 active agents, and navigation meshes with a
+/// #dtTileDetailProvider (which need not be thread-safe), are updated on the
+/// calling thread only.
+///
+/// Must be called after #init(), which resets the crowd to one thread.
+bool dtCrowd::setUpdateThreads(const int numThreads)
+{
+	if (!m_navquery || numThreads < 1 || numThreads > DT_CROWD_MAX_THREADS)
+		return false;
+	dtMemoryOwnerScope owner(DT_MEMORY_CROWD);
+
+	freeThreads();
+	if (numThreads == 1)
+		return true;
+
+	const dtNavMesh* nav = m_navquery->getAttachedNavMesh();
+	for (int i = 1; i < numThreads; ++i)
+	{
+		m_threadNavQuery[i] = dtAllocNavMeshQuery();
+		if (!m_threadNavQuery[i] || dtStatusFailed(m_threadNavQuery[i]->init(nav, MAX_COMMON_NODES)))
+		{
+			freeThreads();
+			return false;
+		}
+		m_threadObstacleQuery[i] = dtAllocObstacleAvoidanceQuery();
+		if (!m_threadObstacleQuery[i] || !m_threadObstacleQuery[i]->init(DT_CROWDAGENT_MAX_NEIGHBOURS, 8))
+		{
+			freeThreads();
+			return false;
+		}
+	}
+
+	void* mem = dtAlloc(sizeof(dtCrowdWorkers), DT_ALLOC_PERM);
+	if (!mem)
+	{
+		freeThreads();
+		return false;
+	}
+	m_workers = new(mem) dtCrowdWorkers(numThreads);
+	m_numThreads = m_workers->size();
+
+	return true;
+}
+
+/// @par
+///
+/// The default grid lists each agent in every cell its radius overlaps, and
+/// a neighbour query looks at no more than 32 entries. The large crowd grid
+/// lists each agent once, in the cell of its position, and is rebuilt with a
+/// counting sort that leaves every cell contiguous. Its cells follow the mean
+/// collision query range of the agents, shrunk in dense crowds to hold about
+/// four agents each but never below an agent's diameter, and a query looks
+/// at up to 128 agents.
+///
+/// Must be called after #init().
+bool dtCrowd::setHighCapacity(const bool enabled)
+{
+	if (!m_grid)
+		return false;
+	if (enabled == m_grid->isPointGrid())
+		return true;
+	dtMemoryOwnerScope owner(DT_MEMORY_CROWD);
+	if (enabled)
+		return m_grid->initPoints(m_maxAgents, m_maxAgentRadius*3);
+	return m_grid->init(m_maxAgents*4, m_maxAgentRadius*3);
+}
+
+/// @par
+///
+/// Neighbours are the closest agents within each agent's collision query
+/// range. They feed separation, obstacle avoidance and collision resolution,
+/// so the cost of those grows with the count.
+bool dtCrowd::setMaxNeighbours(const int maxNeighbours)
+{
+	if (maxNeighbours < 1 || maxNeighbours > DT_CROWDAGENT_MAX_NEIGHBOURS)
+		return false;
+	m_maxNeighbours = maxNeighbours;
+	return true;
+}
+
+/// @par
+///
+/// The search iterations are polygons visited by the A* search. With a time
+/// budget, the clock is checked every 16 iterations. The default budget is
+/// 100 iterations and no time limit.
+bool dtCrowd::setPathQueueBudget(const int maxIters, const float maxTimeMs)
+{
+	if (maxIters < 0 || maxTimeMs < 0.0f || (maxIters == 0 && maxTimeMs == 0.0f))
+		return false;
+	m_pathqMaxIters = maxIters;
+	m_pathqMaxTimeMs = maxTimeMs;
+	return true;
+}
+
+/// @par
+///
+/// Requests in the queue are dropped, and the agents waiting for them
+/// queue again on the next update. The default size is 8.
+///
+/// Must be called after #init().
+bool dtCrowd::setPathQueueSize(const int maxRequests)
+{
+	if (!m_navquery || maxRequests < 1)
+		return false;
+	
+	dtMemoryOwnerScope owner(DT_MEMORY_CROWD);
+	dtCrowdAgent** candidates = (dtCrowdAgent**)dtAlloc(sizeof(dtCrowdAgent*)*maxRequests, DT_ALLOC_PERM);
+	if (!candidates)
+		return false;
+	if (!m_pathq.init(m_maxPathResult, MAX_PATHQUEUE_NODES, m_navquery->getAttachedNavMesh(), maxRequests))
+	{
+		dtFree(candidates);
+		return false;
+	}
+	dtFree(m_pathqCandidates);
+	m_pathqCandidates = candidates;
+	
+	for (int i = 0; i < m_maxAgents; ++i)
+	{
+		dtCrowdAgent* ag = &m_agents[i];
+		if (ag->active && ag->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_PATH)
+		{
+			ag->targetPathqRef = DT_PATHQ_INVALID;
+			ag->targetState = DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE;
+		}
+	}
+	return true;
+}
+
+bool dtCrowd::setAgentPathPriority(const int idx, const unsigned char priority)
+{
+	if (idx < 0 || idx >= m_maxAgents)
+		return false;
+	m_agents[idx].pathPriority = priority;
+	return true;
+}
+
+void dtCrowd::getPathQueueStats(dtCrowdPathQueueStats* stats) const
+{
+	stats->waitingAgents = m_pathqWaiting;
+	stats->pendingRequests = m_pathq.getPendingCount();
+	stats->lastIterations = m_pathq.getLastIterations();
+	stats->completedPaths = m_pathqCompleted;
+	stats->failedPaths = m_pathqFailed;
+	stats->lastLatency = m_pathqLastLatency;
+	stats->meanLatency = m_pathqCompleted > 0 ? m_pathqLatencySum / (float)m_pathqCompleted : 0.0f;
+	stats->maxLatency = m_pathqMaxLatency;
+}
+
+void dtCrowd::resetPathQueueStats()
+{
+	m_pathqCompleted = 0;
+	m_pathqFailed = 0;
+	m_pathqLastLatency = 0;
+	m_pathqLatencySum = 0;
+	m_pathqMaxLatency = 0;
+}
+
+void dtCrowd::setProfiling(const bool enabled, const int window)
+{
+	if (enabled && !m_profiling)
+		resetProfile();
+	m_profiling = enabled;
+	m_profileWindow = dtMax(window, 0);
+}
+
+void dtCrowd::getProfile(dtCrowdProfile* profile) const
+{
+	*profile = m_profileWindow > 0 ? m_profileDone : m_profile;
+}
+
+void dtCrowd::resetProfile()
+{
+	memset(&m_profile, 0, sizeof(m_profile));
+	memset(&m_profileDone, 0, sizeof(m_profileDone));
+}
+
+void dtCrowd::setProfileCallback(dtCrowdProfileCallback callback, void* userData)
+{
+	m_profileCallback = callback;
+	m_profileUserData = userData;
+}
+
+static double profileClockMs()
+{
+	using namespace std::chrono;
+	return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Ends the phase under way, if any, and begins the next, or none if -1.
+void dtCrowd::profilePhase(const int phase)
+{
+	if (m_profiling)
+	{
+		const double now = profileClockMs();
+		if (m_profilePhase >= 0)
+			m_profileUpdate[m_profilePhase] += (float)(now - m_profilePhaseStart);
+		m_profilePhaseStart = now;
+	}
+	if (m_profileCallback)
+	{
+		if (m_profilePhase >= 0)
+			m_profileCallback(m_profileUserData, m_profilePhase, false);
+		if (phase >= 0)
+			m_profileCallback(m_profileUserData, phase, true);
+	}
+	m_profilePhase = phase;
+}
+
+// Ends the last phase and adds the update to the profile.
+void dtCrowd::endProfile()
+{
+	profilePhase(-1);
+	if (!m_profiling)
+		return;
 	
+	dtCrowdProfile& p = m_profile;
+	float total = 0;
+	for (int i = 0; i < DT_CROWD_PHASE_COUNT; ++i)
+	{
+		p.phaseTime[i] += m_profileUpdate[i];
+		p.phaseMaxTime[i] = dtMax(p.phaseMaxTime[i], m_profileUpdate[i]);
+		total += m_profileUpdate[i];
+		m_profileUpdate[i] = 0;
+	}
+	p.updates++;
+	p.updateTime += total;
+	p.updateMaxTime = dtMax(p.updateMaxTime, total);
+	p.pathRequests += m_pathRequestCount;
+	p.pathReplans += m_pathReplanCount;
+	p.pathQueueIterations += m_pathq.getLastIterations();
+	p.avoidanceSamples += m_velocitySampleCount;
+	
+	if (m_profileWindow > 0 && p.updates >= m_profileWindow)
+	{
+		m_profileDone = p;
+		memset(&p, 0, sizeof(p));
+	}
+}
+
+void dtCrowd::setLodParams(const int tier, const dtCrowdLodParams* params)
+{
+	if (tier >= 0 && tier < DT_CROWD_MAX_LOD_TIERS)
+		memcpy(&m_lodParams[tier], params, sizeof(dtCrowdLodParams));
+}
+
+const dtCrowdLodParams* dtCrowd::getLodParams(const int tier) const
+{
+	if (tier >= 0 && tier < DT_CROWD_MAX_LOD_TIERS)
+		return &m_lodParams[tier];
+	return 0;
+}
+
+static void assignLodTier(dtCrowdAgent* ag, const int idx, const int tier, const dtCrowdLodParams* params)
+{
+	ag->lodTier = (unsigned char)tier;
+	// Spread the agents entering a tier over its interval.
+	ag->lodTimer = params->updateInterval * (float)(idx & 7) / 8.0f;
+}
+
+/// @par
+///
+/// Agents in tiers with an update interval search for neighbours and plan
+/// their velocity only once per interval, staggered across the agents. In
+/// between they keep their neighbours and planned velocity, while corners,
+/// steering, collisions and movement along the navigation mesh are updated
+/// every time.
+bool dtCrowd::setAgentLod(const int idx, const int tier)
+{
+	if (idx < 0 || idx >= m_maxAgents || tier < 0 || tier >= DT_CROWD_MAX_LOD_TIERS)
+		return false;
+	if (m_agents[idx].lodTier != tier)
+		assignLodTier(&m_agents[idx], idx, tier, &m_lodParams[tier]);
 	return true;
 }
 
+/// @par
+///
+/// Each agent is placed in the last tier whose #dtCrowdLodParams::distance
+/// its 2D distance to the point reaches.
+void dtCrowd::setLodReference(const float* pos)
+{
+	m_lodAuto = pos != 0;
+	if (pos)
+		dtVcopy(m_lodReference, pos);
+}
+
 void dtCrowd::setObstacleAvoidanceParams(const int idx, const dtObstacleAvoidanceParams* params)
 {
 	if (idx >= 0 && idx < DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS)
@@ -553,6 +1122,13 @@ int dtCrowd::addAgent(const float* pos, const dtCrowdAgentParams* params)
 	ag->targetReplanTime = 0;
 	ag->nneis = 0;
 	
+	ag->pathPriority = 0;
+	ag->targetQueueTime = 0;
+	
+	ag->lodTier = 0;
+	ag->lodDue = true;
+	ag->lodTimer = 0;
+	
 	dtVset(ag->dvel, 0,0,0);
 	dtVset(ag->nvel, 0,0,0);
 	dtVset(ag->vel, 0,0,0);
@@ -566,8 +1142,10 @@ int dtCrowd::addAgent(const float* pos, const dtCrowdAgentParams* params)
 		ag->state = DT_CROWDAGENT_STATE_INVALID;
 	
 	ag->targetState = DT_CROWDAGENT_TARGET_NONE;
+	ag->targetField = 0;
 	
 	ag->active = true;
+	syncAgentState(idx);
 
 	return idx;
 }
@@ -581,7 +1159,36 @@ void dtCrowd::removeAgent(const int idx)
 	if (idx >= 0 && idx < m_maxAgents)
 	{
 		m_agents[idx].active = false;
+		m_agentState[idx] = DT_CROWDAGENT_STATE_INVALID;
+	}
+}
+
+/// @par
+///
+/// Reads the mirrored agent state, which is current after #update() and
+/// #addAgent(), so a whole crowd is copied in one pass without touching the
+/// #dtCrowdAgent structs.
+int dtCrowd::getAgentSnapshot(int* indices, float* pos, float* vel, unsigned char* states,
+							  const int stride, const int maxResult) const
+{
+	dtAssert(stride >= 3);
+	
+	int n = 0;
+	for (int i = 0; i < m_maxAgents && n < maxResult; ++i)
+	{
+		if (!m_agents[i].active)
+			continue;
+		if (indices)
+			indices[n] = i;
+		if (pos)
+			dtVcopy(&pos[n*stride], &m_agentPos[i*3]);
+		if (vel)
+			dtVcopy(&vel[n*stride], &m_agentVel[i*3]);
+		if (states)
+			states[n] = m_agentState[i];
+		n++;
 	}
+	return n;
 }
 
 bool dtCrowd::requestMoveTargetReplan(const int idx, dtPolyRef ref, const float* pos)
@@ -624,6 +1231,7 @@ bool dtCrowd::requestMoveTarget(const int idx, dtPolyRef ref, const float* pos)
 	ag->targetRef = ref;
 	dtVcopy(ag->targetPos, pos);
 	ag->targetPathqRef = DT_PATHQ_INVALID;
+	ag->targetField = 0;
 	ag->targetReplan = false;
 	if (ag->targetRef)
 		ag->targetState = DT_CROWDAGENT_TARGET_REQUESTING;
@@ -633,6 +1241,35 @@ bool dtCrowd::requestMoveTarget(const int idx, dtPolyRef ref, const float* pos)
 	return true;
 }
 
+/// @par
+///
+/// The target is the goal of the field, taken again every time the agent
+/// replans, so agents follow a goal moved with dtFlowField::setGoal().
+/// Agents on polygons the field does not reach, or whose way along the field
+/// goes through a tile changed since it was searched, plan through the path
+/// queue as for #requestMoveTarget().
+///
+/// The request will be processed during the next #update().
+bool dtCrowd::requestMoveFlowField(const int idx, const dtFlowField* field)
+{
+	if (idx < 0 || idx >= m_maxAgents)
+		return false;
+	if (!field || !field->getGoalRef())
+		return false;
+
+	dtCrowdAgent* ag = &m_agents[idx];
+
+	// Initialize request.
+	ag->targetRef = field->getGoalRef();
+	dtVcopy(ag->targetPos, field->getGoalPos());
+	ag->targetPathqRef = DT_PATHQ_INVALID;
+	ag->targetField = field;
+	ag->targetReplan = false;
+	ag->targetState = DT_CROWDAGENT_TARGET_REQUESTING;
+
+	return true;
+}
+
 bool dtCrowd::requestMoveVelocity(const int idx, const float* vel)
 {
 	if (idx < 0 || idx >= m_maxAgents)
@@ -644,6 +1281,7 @@ bool dtCrowd::requestMoveVelocity(const int idx, const float* vel)
 	ag->targetRef = 0;
 	dtVcopy(ag->targetPos, vel);
 	ag->targetPathqRef = DT_PATHQ_INVALID;
+	ag->targetField = 0;
 	ag->targetReplan = false;
 	ag->targetState = DT_CROWDAGENT_TARGET_VELOCITY;
 	
@@ -662,6 +1300,7 @@ bool dtCrowd::resetMoveTarget(const int idx)
 	dtVset(ag->targetPos, 0,0,0);
 	dtVset(ag->dvel, 0,0,0);
 	ag->targetPathqRef = DT_PATHQ_INVALID;
+	ag->targetField = 0;
 	ag->targetReplan = false;
 	ag->targetState = DT_CROWDAGENT_TARGET_NONE;
 	
@@ -681,14 +1320,48 @@ int dtCrowd::getActiveAgents(dtCrowdAgent** agents, const int maxAgents)
 }
 
 
-void dtCrowd::updateMoveRequest(const float /*dt*/)
+// Sets the corridor of an agent following a flow field to the way the field
+// leads from its current polygon. Returns false if the field does not lead
+// from there, or stops early on the way, and the path needs to be searched.
+bool dtCrowd::requestMoveOnField(dtCrowdAgent* ag)
 {
-	const int PATH_MAX_AGENTS = 8;
-	dtCrowdAgent* queue[PATH_MAX_AGENTS];
-	int nqueue = 0;
-	
-	// Fire off new requests.
-	for (int i = 0; i < m_maxAgents; ++i)
+	const dtFlowField* field = ag->targetField;
+	int npath = 0;
+	const dtStatus status = field->getPath(ag->corridor.getFirstPoly(), m_pathResult, &npath, m_maxPathResult);
+	if (dtStatusFailed(status) || dtStatusDetail(status, DT_PARTIAL_RESULT) || !npath)
+		return false;
+
+	float targetPos[3];
+	if (m_pathResult[npath-1] == ag->targetRef)
+	{
+		dtVcopy(targetPos, ag->targetPos);
+	}
+	else
+	{
+		// Longer than the corridor, head for the last polygon and replan
+		// from the field when the corridor runs short.
+		if (dtStatusFailed(m_navquery->closestPointOnPoly(m_pathResult[npath-1], ag->targetPos, targetPos, 0)))
+			return false;
+	}
+
+	ag->corridor.setCorridor(targetPos, m_pathResult, npath);
+	ag->boundary.reset();
+	ag->partial = false;
+	ag->targetPathqRef = DT_PATHQ_INVALID;
+	ag->targetState = DT_CROWDAGENT_TARGET_VALID;
+	ag->targetReplanTime = 0.0;
+	return true;
+}
+
+void dtCrowd::updateMoveRequest(const float dt)
+{
+	const int maxQueue = m_pathq.getMaxRequests();
+	dtCrowdAgent** queue = m_pathqCandidates;
+	int nqueue = 0;
+	m_pathqWaiting = 0;
+	
+	// Fire off new requests.
+	for (int i = 0; i < m_maxAgents; ++i)
 	{
 		dtCrowdAgent* ag = &m_agents[i];
 		if (!ag->active)
@@ -697,6 +1370,10 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 			continue;
 		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
 			continue;
+		
+		if (ag->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE ||
+			ag->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_PATH)
+			ag->targetQueueTime += dt;
 
 		if (ag->targetState == DT_CROWDAGENT_TARGET_REQUESTING)
 		{
@@ -704,6 +1381,19 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 			const int npath = ag->corridor.getPathCount();
 			dtAssert(npath);
 
+			if (ag->targetField && ag->targetField->getGoalRef())
+			{
+				// Read the corridor off the field, no search needed.
+				ag->targetRef = ag->targetField->getGoalRef();
+				dtVcopy(ag->targetPos, ag->targetField->getGoalPos());
+				if (requestMoveOnField(ag))
+					continue;
+			}
+
+			m_pathRequestCount++;
+			if (ag->targetReplan)
+				m_pathReplanCount++;
+
 			static const int MAX_RES = 32;
 			float reqPos[3];
 			dtPolyRef reqPath[MAX_RES];	// The path to the request location
@@ -766,12 +1456,14 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 			{
 				// The path is longer or potentially unreachable, full plan.
 				ag->targetState = DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE;
+				ag->targetQueueTime = 0.0f;
 			}
 		}
 		
 		if (ag->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE)
 		{
-			nqueue = addToPathQueue(ag, queue, nqueue, PATH_MAX_AGENTS);
+			nqueue = addToPathQueue(ag, queue, nqueue, maxQueue);
+			m_pathqWaiting++;
 		}
 	}
 
@@ -779,14 +1471,18 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 	{
 		dtCrowdAgent* ag = queue[i];
 		ag->targetPathqRef = m_pathq.request(ag->corridor.getLastPoly(), ag->targetRef,
-											 ag->corridor.getTarget(), ag->targetPos, &m_filters[ag->params.queryFilterType]);
+											 ag->corridor.getTarget(), ag->targetPos, &m_filters[ag->params.queryFilterType],
+											 ag->pathPriority);
 		if (ag->targetPathqRef != DT_PATHQ_INVALID)
+		{
 			ag->targetState = DT_CROWDAGENT_TARGET_WAITING_FOR_PATH;
+			m_pathqWaiting--;
+		}
 	}
 
 	
 	// Update requests.
-	m_pathq.update(MAX_ITERS_PER_UPDATE);
+	m_pathq.update(m_pathqMaxIters, m_pathqMaxTimeMs);
 
 	dtStatus status;
 
@@ -805,6 +1501,7 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 			status = m_pathq.getRequestStatus(ag->targetPathqRef);
 			if (dtStatusFailed(status))
 			{
+				m_pathqFailed++;
 				// Path find failed, retry if the target location is still valid.
 				ag->targetPathqRef = DT_PATHQ_INVALID;
 				if (ag->targetRef)
@@ -819,6 +1516,11 @@ void dtCrowd::updateMoveRequest(const float /*dt*/)
 				const int npath = ag->corridor.getPathCount();
 				dtAssert(npath);
 				
+				m_pathqCompleted++;
+				m_pathqLastLatency = ag->targetQueueTime;
+				m_pathqLatencySum += ag->targetQueueTime;
+				m_pathqMaxLatency = dtMax(m_pathqMaxLatency, ag->targetQueueTime);
+				
 				// Apply results.
 				float targetPos[3];
 				dtVcopy(targetPos, ag->targetPos);
@@ -944,476 +1646,663 @@ void dtCrowd::updateTopologyOptimization(dtCrowdAgent** agents, const int nagent
 
 }
 
+dtCrowdWorkers* dtCrowd::getUpdateWorkers() const
+{
+	// Tile detail providers are not required to be thread-safe.
+	if (!m_workers || m_navquery->getAttachedNavMesh()->getDetailProvider())
+		return 0;
+	return m_workers;
+}
+
 void dtCrowd::checkPathValidity(dtCrowdAgent** agents, const int nagents, const float dt)
+{
+	runAgentJob(getUpdateWorkers(), nagents, [&](int worker, int begin, int end) {
+		for (int i = begin; i < end; ++i)
+			checkAgentPathValidity(agents[i], dt, m_threadNavQuery[worker]);
+	});
+}
+
+void dtCrowd::checkAgentPathValidity(dtCrowdAgent* ag, const float dt, dtNavMeshQuery* navquery)
 {
 	static const int CHECK_LOOKAHEAD = 10;
 	static const float TARGET_REPLAN_DELAY = 1.0; // seconds
 	
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
-		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-			
-		ag->targetReplanTime += dt;
+	if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+		return;
 
-		bool replan = false;
+	ag->targetReplanTime += dt;
 
-		// First check that the current location is valid.
-		const int idx = getAgentIndex(ag);
-		float agentPos[3];
-		dtPolyRef agentRef = ag->corridor.getFirstPoly();
-		dtVcopy(agentPos, ag->npos);
-		if (!m_navquery->isValidPolyRef(agentRef, &m_filters[ag->params.queryFilterType]))
+	bool replan = false;
+
+	// First check that the current location is valid.
+	const int idx = getAgentIndex(ag);
+	float agentPos[3];
+	dtPolyRef agentRef = ag->corridor.getFirstPoly();
+	dtVcopy(agentPos, ag->npos);
+	if (!navquery->isValidPolyRef(agentRef, &m_filters[ag->params.queryFilterType]))
+	{
+		// Current location is not valid, try to reposition.
+		// TODO: this can snap agents, how to handle that?
+		float nearest[3];
+		dtVcopy(nearest, agentPos);
+		agentRef = 0;
+		navquery->findNearestPoly(ag->npos, m_agentPlacementHalfExtents, &m_filters[ag->params.queryFilterType], &agentRef, nearest);
+		dtVcopy(agentPos, nearest);
+
+		if (!agentRef)
 		{
-			// Current location is not valid, try to reposition.
-			// TODO: this can snap agents, how to handle that?
-			float nearest[3];
-			dtVcopy(nearest, agentPos);
-			agentRef = 0;
-			m_navquery->findNearestPoly(ag->npos, m_agentPlacementHalfExtents, &m_filters[ag->params.queryFilterType], &agentRef, nearest);
-			dtVcopy(agentPos, nearest);
+			// Could not find location in navmesh, set state to invalid.
+			ag->corridor.reset(0, agentPos);
+			ag->partial = false;
+			ag->boundary.reset();
+			ag->state = DT_CROWDAGENT_STATE_INVALID;
+			return;
+		}
 
-			if (!agentRef)
-			{
-				// Could not find location in navmesh, set state to invalid.
-				ag->corridor.reset(0, agentPos);
-				ag->partial = false;
-				ag->boundary.reset();
-				ag->state = DT_CROWDAGENT_STATE_INVALID;
-				continue;
-			}
+		// Make sure the first polygon is valid, but leave other valid
+		// polygons in the path so that replanner can adjust the path better.
+		ag->corridor.fixPathStart(agentRef, agentPos);
+//		ag->corridor.trimInvalidPath(agentRef, agentPos, navquery, &m_filter);
+		ag->boundary.reset();
+		dtVcopy(ag->npos, agentPos);
 
-			// Make sure the first polygon is valid, but leave other valid
-			// polygons in the path so that replanner can adjust the path better.
-			ag->corridor.fixPathStart(agentRef, agentPos);
-//			ag->corridor.trimInvalidPath(agentRef, agentPos, m_navquery, &m_filter);
-			ag->boundary.reset();
-			dtVcopy(ag->npos, agentPos);
+		replan = true;
+	}
+
+	// If the agent does not have move target or is controlled by velocity, no need to recover the target nor replan.
+	if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+		return;
 
+	// Try to recover move request position.
+	if (ag->targetState != DT_CROWDAGENT_TARGET_NONE && ag->targetState != DT_CROWDAGENT_TARGET_FAILED)
+	{
+		if (!navquery->isValidPolyRef(ag->targetRef, &m_filters[ag->params.queryFilterType]))
+		{
+			// Current target is not valid, try to reposition.
+			float nearest[3];
+			dtVcopy(nearest, ag->targetPos);
+			ag->targetRef = 0;
+			navquery->findNearestPoly(ag->targetPos, m_agentPlacementHalfExtents, &m_filters[ag->params.queryFilterType], &ag->targetRef, nearest);
+			dtVcopy(ag->targetPos, nearest);
 			replan = true;
 		}
+		if (!ag->targetRef)
+		{
+			// Failed to reposition target, fail moverequest.
+			ag->corridor.reset(agentRef, agentPos);
+			ag->partial = false;
+			ag->targetState = DT_CROWDAGENT_TARGET_NONE;
+		}
+	}
 
-		// If the agent does not have move target or is controlled by velocity, no need to recover the target nor replan.
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-			continue;
+	// If nearby corridor is not valid, replan.
+	if (!ag->corridor.isValid(CHECK_LOOKAHEAD, navquery, &m_filters[ag->params.queryFilterType]))
+	{
+		// Fix current path.
+//		ag->corridor.trimInvalidPath(agentRef, agentPos, navquery, &m_filter);
+//		ag->boundary.reset();
+		replan = true;
+	}
+	
+	// If the end of the path is near and it is not the requested location, replan.
+	if (ag->targetState == DT_CROWDAGENT_TARGET_VALID)
+	{
+		if (ag->targetReplanTime > TARGET_REPLAN_DELAY &&
+			ag->corridor.getPathCount() < CHECK_LOOKAHEAD &&
+			ag->corridor.getLastPoly() != ag->targetRef)
+			replan = true;
+	}
 
-		// Try to recover move request position.
-		if (ag->targetState != DT_CROWDAGENT_TARGET_NONE && ag->targetState != DT_CROWDAGENT_TARGET_FAILED)
+	// Try to replan path to goal.
+	if (replan)
+	{
+		if (ag->targetState != DT_CROWDAGENT_TARGET_NONE)
 		{
-			if (!m_navquery->isValidPolyRef(ag->targetRef, &m_filters[ag->params.queryFilterType]))
-			{
-				// Current target is not valid, try to reposition.
-				float nearest[3];
-				dtVcopy(nearest, ag->targetPos);
-				ag->targetRef = 0;
-				m_navquery->findNearestPoly(ag->targetPos, m_agentPlacementHalfExtents, &m_filters[ag->params.queryFilterType], &ag->targetRef, nearest);
-				dtVcopy(ag->targetPos, nearest);
-				replan = true;
-			}
-			if (!ag->targetRef)
-			{
-				// Failed to reposition target, fail moverequest.
-				ag->corridor.reset(agentRef, agentPos);
-				ag->partial = false;
-				ag->targetState = DT_CROWDAGENT_TARGET_NONE;
-			}
+			requestMoveTargetReplan(idx, ag->targetRef, ag->targetPos);
 		}
-
-		// If nearby corridor is not valid, replan.
-		if (!ag->corridor.isValid(CHECK_LOOKAHEAD, m_navquery, &m_filters[ag->params.queryFilterType]))
+	}
+}
+	
+void dtCrowd::updateLod(dtCrowdAgent** agents, const int nagents, const float dt)
+{
+	for (int i = 0; i < nagents; ++i)
+	{
+		dtCrowdAgent* ag = agents[i];
+		if (m_lodAuto)
 		{
-			// Fix current path.
-//			ag->corridor.trimInvalidPath(agentRef, agentPos, m_navquery, &m_filter);
-//			ag->boundary.reset();
-			replan = true;
+			const float distSqr = dtVdist2DSqr(ag->npos, m_lodReference);
+			int tier = 0;
+			while (tier+1 < DT_CROWD_MAX_LOD_TIERS && distSqr >= dtSqr(m_lodParams[tier+1].distance))
+				tier++;
+			if (tier != ag->lodTier)
+				assignLodTier(ag, getAgentIndex(ag), tier, &m_lodParams[tier]);
 		}
 		
-		// If the end of the path is near and it is not the requested location, replan.
-		if (ag->targetState == DT_CROWDAGENT_TARGET_VALID)
+		ag->lodTimer -= dt;
+		ag->lodDue = ag->lodTimer <= 0.0f;
+		if (ag->lodDue)
 		{
-			if (ag->targetReplanTime > TARGET_REPLAN_DELAY &&
-				ag->corridor.getPathCount() < CHECK_LOOKAHEAD &&
-				ag->corridor.getLastPoly() != ag->targetRef)
-				replan = true;
+			ag->lodTimer = dtMax(ag->lodTimer + m_lodParams[ag->lodTier].updateInterval, 0.0f);
 		}
-
-		// Try to replan path to goal.
-		if (replan)
+		else
 		{
-			if (ag->targetState != DT_CROWDAGENT_TARGET_NONE)
+			// Drop kept neighbours that have left the crowd.
+			int n = 0;
+			for (int j = 0; j < ag->nneis; ++j)
 			{
-				requestMoveTargetReplan(idx, ag->targetRef, ag->targetPos);
+				if (m_agents[ag->neis[j].idx].active)
+					ag->neis[n++] = ag->neis[j];
 			}
+			ag->nneis = n;
 		}
 	}
 }
-	
-void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
-{
-	m_velocitySampleCount = 0;
-	
-	const int debugIdx = debug ? debug->idx : -1;
-	
-	dtCrowdAgent** agents = m_activeAgents;
-	int nagents = getActiveAgents(agents, m_maxAgents);
 
-	// Check that all agents still have valid paths.
-	checkPathValidity(agents, nagents, dt);
-	
-	// Update async move request and path finder.
-	updateMoveRequest(dt);
+void dtCrowd::syncAgentState(const int idx)
+{
+	const dtCrowdAgent* ag = &m_agents[idx];
+	dtVcopy(&m_agentPos[idx*3], ag->npos);
+	dtVcopy(&m_agentVel[idx*3], ag->vel);
+	dtVcopy(&m_agentDvel[idx*3], ag->dvel);
+	m_agentRadius[idx] = ag->params.radius;
+	m_agentHeight[idx] = ag->params.height;
+	m_agentState[idx] = ag->active ? ag->state : (unsigned char)DT_CROWDAGENT_STATE_INVALID;
+}
 
-	// Optimize path topology.
-	updateTopologyOptimization(agents, nagents, dt);
-	
-	// Register agents to proximity grid.
-	m_grid->clear();
+void dtCrowd::buildProximityGrid(dtCrowdAgent** agents, const int nagents)
+{
 	for (int i = 0; i < nagents; ++i)
 	{
-		dtCrowdAgent* ag = agents[i];
-		const float* p = ag->npos;
-		const float r = ag->params.radius;
-		m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
+		m_activeIndex[i] = getAgentIndex(agents[i]);
+		syncAgentState(m_activeIndex[i]);
 	}
 	
-	// Get nearby navmesh segments and agents to collide with.
-	for (int i = 0; i < nagents; ++i)
+	if (!m_grid->isPointGrid())
 	{
-		dtCrowdAgent* ag = agents[i];
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-
-		// Update the collision boundary after certain distance has been passed or
-		// if it has become invalid.
-		const float updateThr = ag->params.collisionQueryRange*0.25f;
-		if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) ||
-			!ag->boundary.isValid(m_navquery, &m_filters[ag->params.queryFilterType]))
+		m_grid->clear();
+		for (int i = 0; i < nagents; ++i)
 		{
-			ag->boundary.update(ag->corridor.getFirstPoly(), ag->npos, ag->params.collisionQueryRange,
-								m_navquery, &m_filters[ag->params.queryFilterType]);
+			const float* p = &m_agentPos[m_activeIndex[i]*3];
+			const float r = m_agentRadius[m_activeIndex[i]];
+			m_grid->addItem((unsigned short)i, p[0]-r, p[2]-r, p[0]+r, p[2]+r);
 		}
-		// Query neighbour agents
-		ag->nneis = getNeighbours(ag->npos, ag->params.height, ag->params.collisionQueryRange,
-								  ag, ag->neis, DT_CROWDAGENT_MAX_NEIGHBOURS,
-								  agents, nagents, m_grid);
-		for (int j = 0; j < ag->nneis; j++)
-			ag->neis[j].idx = getAgentIndex(agents[ag->neis[j].idx]);
+		return;
 	}
 	
-	// Find next corner to steer to.
+	float range = 0;
+	float bmin[2] = {FLT_MAX, FLT_MAX}, bmax[2] = {-FLT_MAX, -FLT_MAX};
 	for (int i = 0; i < nagents; ++i)
 	{
-		dtCrowdAgent* ag = agents[i];
+		const float* p = &m_agentPos[m_activeIndex[i]*3];
+		m_gridPoints[i*2+0] = p[0];
+		m_gridPoints[i*2+1] = p[2];
+		bmin[0] = dtMin(bmin[0], p[0]);
+		bmin[1] = dtMin(bmin[1], p[2]);
+		bmax[0] = dtMax(bmax[0], p[0]);
+		bmax[1] = dtMax(bmax[1], p[2]);
+		range += agents[i]->params.collisionQueryRange;
+	}
+	if (nagents > 0)
+	{
+		// Cells about a query range across keep queries to a few cells. In dense
+		// crowds, smaller cells of about four agents each trim the candidates
+		// outside the query range.
+		range /= (float)nagents;
+		const float area = dtMax((bmax[0]-bmin[0]) * (bmax[1]-bmin[1]), dtSqr(range));
+		const float spacing = dtMathSqrtf(area / (float)nagents);
+		m_grid->setCellSize(dtMax(m_maxAgentRadius*2.0f, dtMin(range, spacing*2.0f)));
+	}
+	m_grid->buildPoints(m_gridPoints, nagents);
+}
+
+int dtCrowd::getNeighbours(const int self, const float range, dtCrowdNeighbour* result, const int maxResult) const
+{
+	int n = 0;
+	
+	// The default grid lists an agent once for every cell it overlaps.
+	static const int MAX_NEIS = 32;
+	static const int MAX_POINT_NEIS = 128;
+	unsigned short ids[MAX_POINT_NEIS];
+	const float* pos = &m_agentPos[self*3];
+	const float height = m_agentHeight[self];
+	int nids = m_grid->queryItems(pos[0]-range, pos[2]-range,
+								  pos[0]+range, pos[2]+range,
+								  ids, m_grid->isPointGrid() ? MAX_POINT_NEIS : MAX_NEIS);
+	
+	for (int i = 0; i < nids; ++i)
+	{
+		const int idx = m_activeIndex[ids[i]];
 		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+		if (idx == self) continue;
+		
+		// Check for overlap.
+		float diff[3];
+		dtVsub(diff, pos, &m_agentPos[idx*3]);
+		if (dtMathFabsf(diff[1]) >= (height+m_agentHeight[idx])/2.0f)
 			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+		diff[1] = 0;
+		const float distSqr = dtVlenSqr(diff);
+		if (distSqr > dtSqr(range))
 			continue;
 		
-		// Find corners for steering
-		ag->ncorners = ag->corridor.findCorners(ag->cornerVerts, ag->cornerFlags, ag->cornerPolys,
-												DT_CROWDAGENT_MAX_CORNERS, m_navquery, &m_filters[ag->params.queryFilterType]);
+		n = addNeighbour(idx, distSqr, result, n, maxResult);
+	}
+	return n;
+}
+
+void dtCrowd::updateAgentNeighbourhood(dtCrowdAgent* ag, dtNavMeshQuery* navquery)
+{
+	if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+		return;
+	if (!ag->lodDue)
+		return;
+
+	// Update the collision boundary after certain distance has been passed or
+	// if it has become invalid.
+	const float updateThr = ag->params.collisionQueryRange*0.25f*m_lodParams[ag->lodTier].boundaryScale;
+	if (dtVdist2DSqr(ag->npos, ag->boundary.getCenter()) > dtSqr(updateThr) ||
+		!ag->boundary.isValid(navquery, &m_filters[ag->params.queryFilterType]))
+	{
+		ag->boundary.update(ag->corridor.getFirstPoly(), ag->npos, ag->params.collisionQueryRange,
+							navquery, &m_filters[ag->params.queryFilterType]);
+	}
+	// Query neighbour agents
+	ag->nneis = getNeighbours(getAgentIndex(ag), ag->params.collisionQueryRange, ag->neis, m_maxNeighbours);
+}
+
+void dtCrowd::updateAgentCorners(dtCrowdAgent* ag, dtNavMeshQuery* navquery, dtCrowdAgentDebugInfo* debug)
+{
+	if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+		return;
+	if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+		return;
+	
+	// Find corners for steering
+	ag->ncorners = ag->corridor.findCorners(ag->cornerVerts, ag->cornerFlags, ag->cornerPolys,
+											DT_CROWDAGENT_MAX_CORNERS, navquery, &m_filters[ag->params.queryFilterType]);
+	
+	// Check to see if the corner after the next corner is directly visible,
+	// and short cut to there.
+	if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0)
+	{
+		const float* target = &ag->cornerVerts[dtMin(1,ag->ncorners-1)*3];
+		ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, navquery, &m_filters[ag->params.queryFilterType]);
 		
-		// Check to see if the corner after the next corner is directly visible,
-		// and short cut to there.
-		if ((ag->params.updateFlags & DT_CROWD_OPTIMIZE_VIS) && ag->ncorners > 0)
+		// Copy data for debug purposes.
+		if (debug)
 		{
-			const float* target = &ag->cornerVerts[dtMin(1,ag->ncorners-1)*3];
-			ag->corridor.optimizePathVisibility(target, ag->params.pathOptimizationRange, m_navquery, &m_filters[ag->params.queryFilterType]);
-			
-			// Copy data for debug purposes.
-			if (debugIdx == i)
-			{
-				dtVcopy(debug->optStart, ag->corridor.getPos());
-				dtVcopy(debug->optEnd, target);
-			}
+			dtVcopy(debug->optStart, ag->corridor.getPos());
+			dtVcopy(debug->optEnd, target);
 		}
-		else
+	}
+	else
+	{
+		// Copy data for debug purposes.
+		if (debug)
 		{
-			// Copy data for debug purposes.
-			if (debugIdx == i)
-			{
-				dtVset(debug->optStart, 0,0,0);
-				dtVset(debug->optEnd, 0,0,0);
-			}
+			dtVset(debug->optStart, 0,0,0);
+			dtVset(debug->optEnd, 0,0,0);
 		}
 	}
+}
+
+void dtCrowd::triggerAgentOffMesh(dtCrowdAgent* ag, dtNavMeshQuery* navquery)
+{
+	if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+		return;
+	if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+		return;
 	
-	// Trigger off-mesh connections (depends on corners).
-	for (int i = 0; i < nagents; ++i)
+	// Check 
+	const float triggerRadius = ag->params.radius*2.25f;
+	if (overOffmeshConnection(ag, triggerRadius))
 	{
-		dtCrowdAgent* ag = agents[i];
-		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-			continue;
+		// Prepare to off-mesh connection.
+		const int idx = (int)(ag - m_agents);
+		dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
 		
-		// Check 
-		const float triggerRadius = ag->params.radius*2.25f;
-		if (overOffmeshConnection(ag, triggerRadius))
+		// Adjust the path over the off-mesh connection.
+		dtPolyRef refs[2];
+		if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners-1], refs,
+												   anim->startPos, anim->endPos, navquery))
 		{
-			// Prepare to off-mesh connection.
-			const int idx = (int)(ag - m_agents);
-			dtCrowdAgentAnimation* anim = &m_agentAnims[idx];
+			dtVcopy(anim->initPos, ag->npos);
+			anim->polyRef = refs[1];
+			anim->active = true;
+			anim->t = 0.0f;
+			anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
 			
-			// Adjust the path over the off-mesh connection.
-			dtPolyRef refs[2];
-			if (ag->corridor.moveOverOffmeshConnection(ag->cornerPolys[ag->ncorners-1], refs,
-													   anim->startPos, anim->endPos, m_navquery))
-			{
-				dtVcopy(anim->initPos, ag->npos);
-				anim->polyRef = refs[1];
-				anim->active = true;
-				anim->t = 0.0f;
-				anim->tmax = (dtVdist2D(anim->startPos, anim->endPos) / ag->params.maxSpeed) * 0.5f;
-				
-				ag->state = DT_CROWDAGENT_STATE_OFFMESH;
-				ag->ncorners = 0;
-				ag->nneis = 0;
-				continue;
-			}
-			else
-			{
-				// Path validity check will ensure that bad/blocked connections will be replanned.
-			}
+			ag->state = DT_CROWDAGENT_STATE_OFFMESH;
+			m_agentState[idx] = DT_CROWDAGENT_STATE_OFFMESH;
+			ag->ncorners = 0;
+			ag->nneis = 0;
+		}
+		else
+		{
+			// Path validity check will ensure that bad/blocked connections will be replanned.
 		}
 	}
-		
-	// Calculate steering.
-	for (int i = 0; i < nagents; ++i)
-	{
-		dtCrowdAgent* ag = agents[i];
+}
 
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE)
-			continue;
-		
-		float dvel[3] = {0,0,0};
+void dtCrowd::updateAgentSteering(dtCrowdAgent* ag)
+{
+	if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+		return;
+	if (ag->targetState == DT_CROWDAGENT_TARGET_NONE)
+		return;
+	
+	float dvel[3] = {0,0,0};
 
-		if (ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-		{
-			dtVcopy(dvel, ag->targetPos);
-			ag->desiredSpeed = dtVlen(ag->targetPos);
-		}
+	if (ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+	{
+		dtVcopy(dvel, ag->targetPos);
+		ag->desiredSpeed = dtVlen(ag->targetPos);
+	}
+	else
+	{
+		// Calculate steering direction.
+		if (ag->params.updateFlags & DT_CROWD_ANTICIPATE_TURNS)
+			calcSmoothSteerDirection(ag, dvel);
 		else
-		{
-			// Calculate steering direction.
-			if (ag->params.updateFlags & DT_CROWD_ANTICIPATE_TURNS)
-				calcSmoothSteerDirection(ag, dvel);
-			else
-				calcStraightSteerDirection(ag, dvel);
+			calcStraightSteerDirection(ag, dvel);
+		
+		// Calculate speed scale, which tells the agent to slowdown at the end of the path.
+		const float slowDownRadius = ag->params.radius*2;	// TODO: make less hacky.
+		const float speedScale = getDistanceToGoal(ag, slowDownRadius) / slowDownRadius;
 			
-			// Calculate speed scale, which tells the agent to slowdown at the end of the path.
-			const float slowDownRadius = ag->params.radius*2;	// TODO: make less hacky.
-			const float speedScale = getDistanceToGoal(ag, slowDownRadius) / slowDownRadius;
-				
-			ag->desiredSpeed = ag->params.maxSpeed;
-			dtVscale(dvel, dvel, ag->desiredSpeed * speedScale);
-		}
+		ag->desiredSpeed = ag->params.maxSpeed;
+		dtVscale(dvel, dvel, ag->desiredSpeed * speedScale);
+	}
 
-		// Separation
-		if (ag->params.updateFlags & DT_CROWD_SEPARATION)
+	// Separation
+	if ((ag->params.updateFlags & DT_CROWD_SEPARATION) &&
+		m_lodParams[ag->lodTier].steering != DT_CROWD_LOD_STEER_DIRECT)
+	{
+		const float separationDist = ag->params.collisionQueryRange; 
+		const float invSeparationDist = 1.0f / separationDist; 
+		const float separationWeight = ag->params.separationWeight;
+		
+		float w = 0;
+		float disp[3] = {0,0,0};
+		
+		for (int j = 0; j < ag->nneis; ++j)
 		{
-			const float separationDist = ag->params.collisionQueryRange; 
-			const float invSeparationDist = 1.0f / separationDist; 
-			const float separationWeight = ag->params.separationWeight;
-			
-			float w = 0;
-			float disp[3] = {0,0,0};
+			float diff[3];
+			dtVsub(diff, ag->npos, &m_agentPos[ag->neis[j].idx*3]);
+			diff[1] = 0;
 			
-			for (int j = 0; j < ag->nneis; ++j)
-			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				
-				float diff[3];
-				dtVsub(diff, ag->npos, nei->npos);
-				diff[1] = 0;
-				
-				const float distSqr = dtVlenSqr(diff);
-				if (distSqr < 0.00001f)
-					continue;
-				if (distSqr > dtSqr(separationDist))
-					continue;
-				const float dist = dtMathSqrtf(distSqr);
-				const float weight = separationWeight * (1.0f - dtSqr(dist*invSeparationDist));
-				
-				dtVmad(disp, disp, diff, weight/dist);
-				w += 1.0f;
-			}
+			const float distSqr = dtVlenSqr(diff);
+			if (distSqr < 0.00001f)
+				continue;
+			if (distSqr > dtSqr(separationDist))
+				continue;
+			const float dist = dtMathSqrtf(distSqr);
+			const float weight = separationWeight * (1.0f - dtSqr(dist*invSeparationDist));
 			
-			if (w > 0.0001f)
-			{
-				// Adjust desired velocity.
-				dtVmad(dvel, dvel, disp, 1.0f/w);
-				// Clamp desired velocity to desired speed.
-				const float speedSqr = dtVlenSqr(dvel);
-				const float desiredSqr = dtSqr(ag->desiredSpeed);
-				if (speedSqr > desiredSqr)
-					dtVscale(dvel, dvel, desiredSqr/speedSqr);
-			}
+			dtVmad(disp, disp, diff, weight/dist);
+			w += 1.0f;
 		}
 		
-		// Set the desired velocity.
-		dtVcopy(ag->dvel, dvel);
+		if (w > 0.0001f)
+		{
+			// Adjust desired velocity.
+			dtVmad(dvel, dvel, disp, 1.0f/w);
+			// Clamp desired velocity to desired speed.
+			const float speedSqr = dtVlenSqr(dvel);
+			const float desiredSqr = dtSqr(ag->desiredSpeed);
+			if (speedSqr > desiredSqr)
+				dtVscale(dvel, dvel, desiredSqr/speedSqr);
+		}
 	}
 	
-	// Velocity planning.	
-	for (int i = 0; i < nagents; ++i)
+	// Set the desired velocity.
+	dtVcopy(ag->dvel, dvel);
+	dtVcopy(&m_agentDvel[getAgentIndex(ag)*3], dvel);
+}
+
+int dtCrowd::planAgentVelocity(dtCrowdAgent* ag, dtObstacleAvoidanceQuery* obstacleQuery, dtObstacleAvoidanceDebugData* vod)
+{
+	if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+		return 0;
+	
+	if (!(ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE) ||
+		m_lodParams[ag->lodTier].steering != DT_CROWD_LOD_STEER_FULL)
 	{
-		dtCrowdAgent* ag = agents[i];
-		
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+		// If not using velocity planning, new velocity is directly the desired velocity.
+		dtVcopy(ag->nvel, ag->dvel);
+		return 0;
+	}
+	if (!ag->lodDue)
+		return 0;
+
+	obstacleQuery->reset();
+	
+	// Add neighbours as obstacles.
+	for (int j = 0; j < ag->nneis; ++j)
+	{
+		const int nei = ag->neis[j].idx;
+		obstacleQuery->addCircle(&m_agentPos[nei*3], m_agentRadius[nei], &m_agentVel[nei*3], &m_agentDvel[nei*3]);
+	}
+
+	// Append neighbour segments as obstacles.
+	for (int j = 0; j < ag->boundary.getSegmentCount(); ++j)
+	{
+		const float* s = ag->boundary.getSegment(j);
+		if (dtTriArea2D(ag->npos, s, s+3) < 0.0f)
 			continue;
+		obstacleQuery->addSegment(s, s+3);
+	}
+
+	// Sample new safe velocity.
+	bool adaptive = true;
+	int ns = 0;
+
+	const dtObstacleAvoidanceParams* params = &m_obstacleQueryParams[ag->params.obstacleAvoidanceType];
 		
-		if (ag->params.updateFlags & DT_CROWD_OBSTACLE_AVOIDANCE)
-		{
-			m_obstacleQuery->reset();
-			
-			// Add neighbours as obstacles.
-			for (int j = 0; j < ag->nneis; ++j)
-			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				m_obstacleQuery->addCircle(nei->npos, nei->params.radius, nei->vel, nei->dvel);
-			}
+	if (adaptive)
+	{
+		ns = obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
+												   ag->vel, ag->dvel, ag->nvel, params, vod);
+	}
+	else
+	{
+		ns = obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
+											   ag->vel, ag->dvel, ag->nvel, params, vod);
+	}
+	return ns;
+}
 
-			// Append neighbour segments as obstacles.
-			for (int j = 0; j < ag->boundary.getSegmentCount(); ++j)
-			{
-				const float* s = ag->boundary.getSegment(j);
-				if (dtTriArea2D(ag->npos, s, s+3) < 0.0f)
-					continue;
-				m_obstacleQuery->addSegment(s, s+3);
-			}
+void dtCrowd::resolveAgentCollisions(dtCrowdAgent* ag)
+{
+	static const float COLLISION_RESOLVE_FACTOR = 0.7f;
 
-			dtObstacleAvoidanceDebugData* vod = 0;
-			if (debugIdx == i) 
-				vod = debug->vod;
-			
-			// Sample new safe velocity.
-			bool adaptive = true;
-			int ns = 0;
+	const int idx0 = getAgentIndex(ag);
+	
+	if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+		return;
 
-			const dtObstacleAvoidanceParams* params = &m_obstacleQueryParams[ag->params.obstacleAvoidanceType];
-				
-			if (adaptive)
-			{
-				ns = m_obstacleQuery->sampleVelocityAdaptive(ag->npos, ag->params.radius, ag->desiredSpeed,
-															 ag->vel, ag->dvel, ag->nvel, params, vod);
-			}
+	dtVset(ag->disp, 0,0,0);
+	
+	float w = 0;
+
+	const float* pos = &m_agentPos[idx0*3];
+	const float radius = m_agentRadius[idx0];
+	for (int j = 0; j < ag->nneis; ++j)
+	{
+		const int idx1 = ag->neis[j].idx;
+
+		float diff[3];
+		dtVsub(diff, pos, &m_agentPos[idx1*3]);
+		diff[1] = 0;
+		
+		float dist = dtVlenSqr(diff);
+		if (dist > dtSqr(radius + m_agentRadius[idx1]))
+			continue;
+		dist = dtMathSqrtf(dist);
+		float pen = (radius + m_agentRadius[idx1]) - dist;
+		if (dist < 0.0001f)
+		{
+			// Agents on top of each other, try to choose diverging separation directions.
+			if (idx0 > idx1)
+				dtVset(diff, -ag->dvel[2],0,ag->dvel[0]);
 			else
-			{
-				ns = m_obstacleQuery->sampleVelocityGrid(ag->npos, ag->params.radius, ag->desiredSpeed,
-														 ag->vel, ag->dvel, ag->nvel, params, vod);
-			}
-			m_velocitySampleCount += ns;
+				dtVset(diff, ag->dvel[2],0,-ag->dvel[0]);
+			pen = 0.01f;
 		}
 		else
 		{
-			// If not using velocity planning, new velocity is directly the desired velocity.
-			dtVcopy(ag->nvel, ag->dvel);
+			pen = (1.0f/dist) * (pen*0.5f) * COLLISION_RESOLVE_FACTOR;
 		}
+		
+		dtVmad(ag->disp, ag->disp, diff, pen);			
+		
+		w += 1.0f;
+	}
+	
+	if (w > 0.0001f)
+	{
+		const float iw = 1.0f / w;
+		dtVscale(ag->disp, ag->disp, iw);
 	}
+}
 
-	// Integrate.
-	for (int i = 0; i < nagents; ++i)
+void dtCrowd::moveAgent(dtCrowdAgent* ag, dtNavMeshQuery* navquery)
+{
+	if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+		return;
+	
+	// Move along navmesh.
+	ag->corridor.movePosition(ag->npos, navquery, &m_filters[ag->params.queryFilterType]);
+	// Get valid constrained position back.
+	dtVcopy(ag->npos, ag->corridor.getPos());
+	dtVcopy(&m_agentPos[getAgentIndex(ag)*3], ag->npos);
+
+	// If not using path, truncate the corridor to just one poly.
+	if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
 	{
-		dtCrowdAgent* ag = agents[i];
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
-		integrate(ag, dt);
+		ag->corridor.reset(ag->corridor.getFirstPoly(), ag->npos);
+		ag->partial = false;
 	}
+}
+
+void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
+{
+	m_velocitySampleCount = 0;
+	m_pathRequestCount = 0;
+	m_pathReplanCount = 0;
 	
-	// Handle collisions.
-	static const float COLLISION_RESOLVE_FACTOR = 0.7f;
+	// Profiling costs one test per phase while it is off.
+	const bool profile = m_profiling || m_profileCallback;
 	
-	for (int iter = 0; iter < 4; ++iter)
-	{
-		for (int i = 0; i < nagents; ++i)
-		{
-			dtCrowdAgent* ag = agents[i];
-			const int idx0 = getAgentIndex(ag);
-			
-			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-				continue;
+	const int debugIdx = debug ? debug->idx : -1;
+	
+	dtCrowdAgent** agents = m_activeAgents;
+	int nagents = getActiveAgents(agents, m_maxAgents);
 
-			dtVset(ag->disp, 0,0,0);
-			
-			float w = 0;
+	dtCrowdWorkers* workers = getUpdateWorkers();
 
-			for (int j = 0; j < ag->nneis; ++j)
-			{
-				const dtCrowdAgent* nei = &m_agents[ag->neis[j].idx];
-				const int idx1 = getAgentIndex(nei);
+	// Check that all agents still have valid paths.
+	if (profile) profilePhase(DT_CROWD_PHASE_PATH_VALIDITY);
+	checkPathValidity(agents, nagents, dt);
+	
+	// Update async move request and path finder.
+	if (profile) profilePhase(DT_CROWD_PHASE_MOVE_REQUEST);
+	updateMoveRequest(dt);
 
-				float diff[3];
-				dtVsub(diff, ag->npos, nei->npos);
-				diff[1] = 0;
-				
-				float dist = dtVlenSqr(diff);
-				if (dist > dtSqr(ag->params.radius + nei->params.radius))
-					continue;
-				dist = dtMathSqrtf(dist);
-				float pen = (ag->params.radius + nei->params.radius) - dist;
-				if (dist < 0.0001f)
-				{
-					// Agents on top of each other, try to choose diverging separation directions.
-					if (idx0 > idx1)
-						dtVset(diff, -ag->dvel[2],0,ag->dvel[0]);
-					else
-						dtVset(diff, ag->dvel[2],0,-ag->dvel[0]);
-					pen = 0.01f;
-				}
-				else
-				{
-					pen = (1.0f/dist) * (pen*0.5f) * COLLISION_RESOLVE_FACTOR;
-				}
-				
-				dtVmad(ag->disp, ag->disp, diff, pen);			
-				
-				w += 1.0f;
-			}
-			
-			if (w > 0.0001f)
-			{
-				const float iw = 1.0f / w;
-				dtVscale(ag->disp, ag->disp, iw);
-			}
-		}
+	// Optimize path topology.
+	if (profile) profilePhase(DT_CROWD_PHASE_TOPOLOGY);
+	updateTopologyOptimization(agents, nagents, dt);
+	
+	// Pick the agents that replan their neighbours and velocity.
+	if (profile) profilePhase(DT_CROWD_PHASE_NEIGHBOURS);
+	updateLod(agents, nagents, dt);
+	
+	// Register agents to proximity grid.
+	buildProximityGrid(agents, nagents);
+	
+	// Get nearby navmesh segments and agents to collide with.
+	runAgentJob(workers, nagents, [&](int worker, int begin, int end) {
+		for (int i = begin; i < end; ++i)
+			updateAgentNeighbourhood(agents[i], m_threadNavQuery[worker]);
+	});
+	
+	// Find next corner to steer to.
+	if (profile) profilePhase(DT_CROWD_PHASE_CORNERS);
+	runAgentJob(workers, nagents, [&](int worker, int begin, int end) {
+		for (int i = begin; i < end; ++i)
+			updateAgentCorners(agents[i], m_threadNavQuery[worker], debugIdx == i ? debug : 0);
+	});
+	
+	// Trigger off-mesh connections (depends on corners).
+	runAgentJob(workers, nagents, [&](int worker, int begin, int end) {
+		for (int i = begin; i < end; ++i)
+			triggerAgentOffMesh(agents[i], m_threadNavQuery[worker]);
+	});
 		
-		for (int i = 0; i < nagents; ++i)
+	// Calculate steering.
+	if (profile) profilePhase(DT_CROWD_PHASE_STEERING);
+	runAgentJob(workers, nagents, [&](int /*worker*/, int begin, int end) {
+		for (int i = begin; i < end; ++i)
+			updateAgentSteering(agents[i]);
+	});
+	
+	// Velocity planning.	
+	if (profile) profilePhase(DT_CROWD_PHASE_AVOIDANCE);
+	const int nthreads = workers ? workers->size() : 1;
+	for (int i = 0; i < nthreads; ++i)
+		m_threadSampleCount[i] = 0;
+	runAgentJob(workers, nagents, [&](int worker, int begin, int end) {
+		int ns = 0;
+		for (int i = begin; i < end; ++i)
+			ns += planAgentVelocity(agents[i], m_threadObstacleQuery[worker], debugIdx == i ? debug->vod : 0);
+		m_threadSampleCount[worker] = ns;
+	});
+	for (int i = 0; i < nthreads; ++i)
+		m_velocitySampleCount += m_threadSampleCount[i];
+
+	// Integrate.
+	if (profile) profilePhase(DT_CROWD_PHASE_INTEGRATE);
+	runAgentJob(workers, nagents, [&](int /*worker*/, int begin, int end) {
+		for (int i = begin; i < end; ++i)
 		{
 			dtCrowdAgent* ag = agents[i];
 			if (ag->state != DT_CROWDAGENT_STATE_WALKING)
 				continue;
-			
-			dtVadd(ag->npos, ag->npos, ag->disp);
+			integrate(ag, dt);
+			const int idx = getAgentIndex(ag);
+			dtVcopy(&m_agentPos[idx*3], ag->npos);
+			dtVcopy(&m_agentVel[idx*3], ag->vel);
 		}
-	}
+	});
 	
-	for (int i = 0; i < nagents; ++i)
+	// Handle collisions.
+	if (profile) profilePhase(DT_CROWD_PHASE_COLLISION);
+	for (int iter = 0; iter < 4; ++iter)
 	{
-		dtCrowdAgent* ag = agents[i];
-		if (ag->state != DT_CROWDAGENT_STATE_WALKING)
-			continue;
+		runAgentJob(workers, nagents, [&](int /*worker*/, int begin, int end) {
+			for (int i = begin; i < end; ++i)
+				resolveAgentCollisions(agents[i]);
+		});
 		
-		// Move along navmesh.
-		ag->corridor.movePosition(ag->npos, m_navquery, &m_filters[ag->params.queryFilterType]);
-		// Get valid constrained position back.
-		dtVcopy(ag->npos, ag->corridor.getPos());
-
-		// If not using path, truncate the corridor to just one poly.
-		if (ag->targetState == DT_CROWDAGENT_TARGET_NONE || ag->targetState == DT_CROWDAGENT_TARGET_VELOCITY)
-		{
-			ag->corridor.reset(ag->corridor.getFirstPoly(), ag->npos);
-			ag->partial = false;
-		}
-
+		runAgentJob(workers, nagents, [&](int /*worker*/, int begin, int end) {
+			for (int i = begin; i < end; ++i)
+			{
+				dtCrowdAgent* ag = agents[i];
+				if (ag->state != DT_CROWDAGENT_STATE_WALKING)
+					continue;
+				
+				dtVadd(ag->npos, ag->npos, ag->disp);
+				dtVcopy(&m_agentPos[getAgentIndex(ag)*3], ag->npos);
+			}
+		});
 	}
 	
+	if (profile) profilePhase(DT_CROWD_PHASE_MOVE);
+	runAgentJob(workers, nagents, [&](int worker, int begin, int end) {
+		for (int i = begin; i < end; ++i)
+			moveAgent(agents[i], m_threadNavQuery[worker]);
+	});
+	
 	// Update agents using off-mesh connection.
 	for (int i = 0; i < nagents; ++i)
 	{
@@ -1431,6 +2320,7 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 			anim->active = false;
 			// Prepare agent for walking.
 			ag->state = DT_CROWDAGENT_STATE_WALKING;
+			m_agentState[idx] = DT_CROWDAGENT_STATE_WALKING;
 			continue;
 		}
 		
@@ -1451,6 +2341,8 @@ void dtCrowd::update(const float dt, dtCrowdAgentDebugInfo* debug)
 		// Update velocity.
 		dtVset(ag->vel, 0,0,0);
 		dtVset(ag->dvel, 0,0,0);
+		syncAgentState(idx);
 	}
 	
+	if (profile) endProfile();
 }
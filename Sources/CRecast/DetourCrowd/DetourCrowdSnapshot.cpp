@@ -0,0 +1,100 @@
+// DetourCrowdSnapshot.cpp
+// Crowd state handed from a simulation thread to a render thread without locks
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "DetourCrowdSnapshot.h"
+#include "DetourAlloc.h"
+#include "DetourAssert.h"
+#include <string.h>
+#include <new>
+
+dtCrowdSnapshotBuffer* dtAllocCrowdSnapshotBuffer()
+{
+	void* mem = dtAlloc(sizeof(dtCrowdSnapshotBuffer), DT_ALLOC_PERM);
+	if (!mem) return 0;
+	return new(mem) dtCrowdSnapshotBuffer;
+}
+
+void dtFreeCrowdSnapshotBuffer(dtCrowdSnapshotBuffer* buffer)
+{
+	if (!buffer) return;
+	buffer->~dtCrowdSnapshotBuffer();
+	dtFree(buffer);
+}
+
+dtCrowdSnapshotBuffer::dtCrowdSnapshotBuffer() :
+	m_middle(1),
+	m_write(0),
+	m_read(2),
+	m_maxAgents(0)
+{
+	memset(m_slots, 0, sizeof(m_slots));
+}
+
+dtCrowdSnapshotBuffer::~dtCrowdSnapshotBuffer()
+{
+	purge();
+}
+
+void dtCrowdSnapshotBuffer::purge()
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		dtFree(m_slots[i].indices);
+		dtFree(m_slots[i].pos);
+		dtFree(m_slots[i].vel);
+		dtFree(m_slots[i].states);
+	}
+	memset(m_slots, 0, sizeof(m_slots));
+	m_maxAgents = 0;
+}
+
+bool dtCrowdSnapshotBuffer::init(const int maxAgents)
+{
+	dtAssert(maxAgents > 0);
+	
+	purge();
+	
+	for (int i = 0; i < 3; ++i)
+	{
+		dtCrowdSnapshot& s = m_slots[i];
+		s.indices = (int*)dtAlloc(sizeof(int)*maxAgents, DT_ALLOC_PERM);
+		s.pos = (float*)dtAlloc(sizeof(float)*4*maxAgents, DT_ALLOC_PERM);
+		s.vel = (float*)dtAlloc(sizeof(float)*4*maxAgents, DT_ALLOC_PERM);
+		s.states = (unsigned char*)dtAlloc(sizeof(unsigned char)*maxAgents, DT_ALLOC_PERM);
+		if (!s.indices || !s.pos || !s.vel || !s.states)
+		{
+			purge();
+			return false;
+		}
+		memset(s.pos, 0, sizeof(float)*4*maxAgents);
+		memset(s.vel, 0, sizeof(float)*4*maxAgents);
+	}
+	m_maxAgents = maxAgents;
+	m_write = 0;
+	m_middle.store(1, std::memory_order_relaxed);
+	m_read = 2;
+	
+	return true;
+}
+
+void dtCrowdSnapshotBuffer::publish(const dtCrowd* crowd, const unsigned int tick, const float time)
+{
+	dtCrowdSnapshot& s = m_slots[m_write];
+	s.count = crowd->getAgentSnapshot(s.indices, s.pos, s.vel, s.states, 4, m_maxAgents);
+	s.tick = tick;
+	s.time = time;
+	
+	// Release the snapshot to the reader, and take back whichever slot was
+	// in the middle: the reader no longer holds it.
+	m_write = m_middle.exchange(m_write | NEW_BIT, std::memory_order_acq_rel) & ~NEW_BIT;
+}
+
+const dtCrowdSnapshot* dtCrowdSnapshotBuffer::acquire()
+{
+	if (m_middle.load(std::memory_order_relaxed) & NEW_BIT)
+		m_read = m_middle.exchange(m_read, std::memory_order_acq_rel) & ~NEW_BIT;
+	return &m_slots[m_read];
+}
@@ -25,8 +25,95 @@
 #include <float.h>
 #include <new>
 
+// Candidate velocities are scored four at a time against the obstacles laid
+// out as structure of arrays, with SSE2 or NEON chosen at compile time. The
+// sampler keeps the scalar path when collecting debug data. Define
+// DT_DISABLE_SIMD to always use the scalar path.
+#if !defined(DT_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#	include <emmintrin.h>
+#	define DT_AVOIDANCE_SSE2 1
+#elif !defined(DT_DISABLE_SIMD) && (defined(__aarch64__) || defined(_M_ARM64))
+#	include <arm_neon.h>
+#	define DT_AVOIDANCE_NEON 1
+#endif
+#if defined(DT_AVOIDANCE_SSE2) || defined(DT_AVOIDANCE_NEON)
+#	define DT_AVOIDANCE_SIMD 1
+#endif
+
 static const float DT_PI = 3.14159265f;
 
+// Fields of dtObstacleAvoidanceQuery::m_circleSoa, each maxCircles long.
+enum dtCircleField
+{
+	DT_CIR_VX, DT_CIR_VZ,		// Obstacle velocity
+	DT_CIR_SX, DT_CIR_SZ,		// Obstacle position relative to the agent
+	DT_CIR_C,					// |s|^2 - (r0+r1)^2 of sweepCircleCircle
+	DT_CIR_DPX, DT_CIR_DPZ,		// Side selection direction
+	DT_CIR_NPX, DT_CIR_NPZ,		// Side selection normal
+	DT_CIR_FIELDS
+};
+
+// Fields of dtObstacleAvoidanceQuery::m_segmentSoa, each maxSegments long.
+enum dtSegmentField
+{
+	DT_SEG_TOUCH,				// 1 if the agent touches the segment, else 0
+	DT_SEG_NX, DT_SEG_NZ,		// Segment normal (for touching segments)
+	DT_SEG_VX, DT_SEG_VZ,		// q - p
+	DT_SEG_WX, DT_SEG_WZ,		// Agent position - p
+	DT_SEG_PVW,					// dtVperp2D(v, w) of isectRaySeg
+	DT_SEG_FIELDS
+};
+
+#ifdef DT_AVOIDANCE_SIMD
+#ifdef DT_AVOIDANCE_SSE2
+typedef __m128 dtFloat4;
+typedef __m128 dtMask4;
+inline dtFloat4 dtF4Set(const float v) { return _mm_set1_ps(v); }
+inline dtFloat4 dtF4Load(const float* v) { return _mm_loadu_ps(v); }
+inline void dtF4Store(float* dst, const dtFloat4 v) { _mm_storeu_ps(dst, v); }
+inline dtFloat4 dtF4Add(const dtFloat4 a, const dtFloat4 b) { return _mm_add_ps(a, b); }
+inline dtFloat4 dtF4Sub(const dtFloat4 a, const dtFloat4 b) { return _mm_sub_ps(a, b); }
+inline dtFloat4 dtF4Mul(const dtFloat4 a, const dtFloat4 b) { return _mm_mul_ps(a, b); }
+inline dtFloat4 dtF4Div(const dtFloat4 a, const dtFloat4 b) { return _mm_div_ps(a, b); }
+inline dtFloat4 dtF4Sqrt(const dtFloat4 a) { return _mm_sqrt_ps(a); }
+inline dtFloat4 dtF4Min(const dtFloat4 a, const dtFloat4 b) { return _mm_min_ps(a, b); }
+inline dtFloat4 dtF4Max(const dtFloat4 a, const dtFloat4 b) { return _mm_max_ps(a, b); }
+inline dtMask4 dtF4Lt(const dtFloat4 a, const dtFloat4 b) { return _mm_cmplt_ps(a, b); }
+inline dtMask4 dtF4Gt(const dtFloat4 a, const dtFloat4 b) { return _mm_cmpgt_ps(a, b); }
+inline dtMask4 dtF4Ge(const dtFloat4 a, const dtFloat4 b) { return _mm_cmpge_ps(a, b); }
+inline dtMask4 dtF4Le(const dtFloat4 a, const dtFloat4 b) { return _mm_cmple_ps(a, b); }
+inline dtMask4 dtM4And(const dtMask4 a, const dtMask4 b) { return _mm_and_ps(a, b); }
+inline dtMask4 dtM4Or(const dtMask4 a, const dtMask4 b) { return _mm_or_ps(a, b); }
+inline dtMask4 dtM4AndNot(const dtMask4 a, const dtMask4 b) { return _mm_andnot_ps(b, a); }	// a & ~b
+inline dtFloat4 dtF4Select(const dtMask4 m, const dtFloat4 a, const dtFloat4 b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+inline bool dtM4All(const dtMask4 m) { return _mm_movemask_ps(m) == 0xf; }
+inline bool dtM4Any(const dtMask4 m) { return _mm_movemask_ps(m) != 0; }
+#else
+typedef float32x4_t dtFloat4;
+typedef uint32x4_t dtMask4;
+inline dtFloat4 dtF4Set(const float v) { return vdupq_n_f32(v); }
+inline dtFloat4 dtF4Load(const float* v) { return vld1q_f32(v); }
+inline void dtF4Store(float* dst, const dtFloat4 v) { vst1q_f32(dst, v); }
+inline dtFloat4 dtF4Add(const dtFloat4 a, const dtFloat4 b) { return vaddq_f32(a, b); }
+inline dtFloat4 dtF4Sub(const dtFloat4 a, const dtFloat4 b) { return vsubq_f32(a, b); }
+inline dtFloat4 dtF4Mul(const dtFloat4 a, const dtFloat4 b) { return vmulq_f32(a, b); }
+inline dtFloat4 dtF4Div(const dtFloat4 a, const dtFloat4 b) { return vdivq_f32(a, b); }
+inline dtFloat4 dtF4Sqrt(const dtFloat4 a) { return vsqrtq_f32(a); }
+inline dtFloat4 dtF4Min(const dtFloat4 a, const dtFloat4 b) { return vbslq_f32(vcltq_f32(a, b), a, b); }
+inline dtFloat4 dtF4Max(const dtFloat4 a, const dtFloat4 b) { return vbslq_f32(vcgtq_f32(a, b), a, b); }
+inline dtMask4 dtF4Lt(const dtFloat4 a, const dtFloat4 b) { return vcltq_f32(a, b); }
+inline dtMask4 dtF4Gt(const dtFloat4 a, const dtFloat4 b) { return vcgtq_f32(a, b); }
+inline dtMask4 dtF4Ge(const dtFloat4 a, const dtFloat4 b) { return vcgeq_f32(a, b); }
+inline dtMask4 dtF4Le(const dtFloat4 a, const dtFloat4 b) { return vcleq_f32(a, b); }
+inline dtMask4 dtM4And(const dtMask4 a, const dtMask4 b) { return vandq_u32(a, b); }
+inline dtMask4 dtM4Or(const dtMask4 a, const dtMask4 b) { return vorrq_u32(a, b); }
+inline dtMask4 dtM4AndNot(const dtMask4 a, const dtMask4 b) { return vbicq_u32(a, b); }	// a & ~b
+inline dtFloat4 dtF4Select(const dtMask4 m, const dtFloat4 a, const dtFloat4 b) { return vbslq_f32(m, a, b); }
+inline bool dtM4All(const dtMask4 m) { return vminvq_u32(m) != 0; }
+inline bool dtM4Any(const dtMask4 m) { return vmaxvq_u32(m) != 0; }
+#endif
+#endif // DT_AVOIDANCE_SIMD
+
 static int sweepCircleCircle(const float* c0, const float r0, const float* v,
 							 const float* c1, const float r1,
 							 float& tmin, float& tmax)
@@ -215,7 +302,9 @@ dtObstacleAvoidanceQuery::dtObstacleAvoidanceQuery() :
 	m_ncircles(0),
 	m_maxSegments(0),
 	m_segments(0),
-	m_nsegments(0)
+	m_nsegments(0),
+	m_circleSoa(0),
+	m_segmentSoa(0)
 {
 }
 
@@ -223,6 +312,8 @@ dtObstacleAvoidanceQuery::~dtObstacleAvoidanceQuery()
 {
 	dtFree(m_circles);
 	dtFree(m_segments);
+	dtFree(m_circleSoa);
+	dtFree(m_segmentSoa);
 }
 
 bool dtObstacleAvoidanceQuery::init(const int maxCircles, const int maxSegments)
@@ -240,6 +331,15 @@ bool dtObstacleAvoidanceQuery::init(const int maxCircles, const int maxSegments)
 	if (!m_segments)
 		return false;
 	memset(m_segments, 0, sizeof(dtObstacleSegment)*m_maxSegments);
+
+	dtFree(m_circleSoa);
+	m_circleSoa = (float*)dtAlloc(sizeof(float)*DT_CIR_FIELDS*dtMax(m_maxCircles, 1), DT_ALLOC_PERM);
+	if (!m_circleSoa)
+		return false;
+	dtFree(m_segmentSoa);
+	m_segmentSoa = (float*)dtAlloc(sizeof(float)*DT_SEG_FIELDS*dtMax(m_maxSegments, 1), DT_ALLOC_PERM);
+	if (!m_segmentSoa)
+		return false;
 	
 	return true;
 }
@@ -432,6 +532,230 @@ float dtObstacleAvoidanceQuery::processSample(const float* vcand, const float cs
 	return penalty;
 }
 
+// Lays the prepared obstacles out by field for processSamples4(), with the
+// terms that do not depend on the candidate velocity computed once.
+void dtObstacleAvoidanceQuery::prepareSoa(const float* pos, const float rad)
+{
+	const int nc = m_maxCircles;
+	for (int i = 0; i < m_ncircles; ++i)
+	{
+		const dtObstacleCircle* cir = &m_circles[i];
+		float s[3];
+		dtVsub(s, cir->p, pos);
+		const float r = rad + cir->rad;
+		m_circleSoa[DT_CIR_VX*nc + i] = cir->vel[0];
+		m_circleSoa[DT_CIR_VZ*nc + i] = cir->vel[2];
+		m_circleSoa[DT_CIR_SX*nc + i] = s[0];
+		m_circleSoa[DT_CIR_SZ*nc + i] = s[2];
+		m_circleSoa[DT_CIR_C*nc + i] = dtVdot2D(s,s) - r*r;
+		m_circleSoa[DT_CIR_DPX*nc + i] = cir->dp[0];
+		m_circleSoa[DT_CIR_DPZ*nc + i] = cir->dp[2];
+		m_circleSoa[DT_CIR_NPX*nc + i] = cir->np[0];
+		m_circleSoa[DT_CIR_NPZ*nc + i] = cir->np[2];
+	}
+
+	const int ns = m_maxSegments;
+	for (int i = 0; i < m_nsegments; ++i)
+	{
+		const dtObstacleSegment* seg = &m_segments[i];
+		float v[3], w[3];
+		dtVsub(v, seg->q, seg->p);
+		dtVsub(w, pos, seg->p);
+		m_segmentSoa[DT_SEG_TOUCH*ns + i] = seg->touch ? 1.0f : 0.0f;
+		m_segmentSoa[DT_SEG_NX*ns + i] = -v[2];
+		m_segmentSoa[DT_SEG_NZ*ns + i] = v[0];
+		m_segmentSoa[DT_SEG_VX*ns + i] = v[0];
+		m_segmentSoa[DT_SEG_VZ*ns + i] = v[2];
+		m_segmentSoa[DT_SEG_WX*ns + i] = w[0];
+		m_segmentSoa[DT_SEG_WZ*ns + i] = w[2];
+		m_segmentSoa[DT_SEG_PVW*ns + i] = dtVperp2D(v, w);
+	}
+}
+
+#ifdef DT_AVOIDANCE_SIMD
+// Scores four candidate velocities the way processSample() does, but always
+// to the end: a candidate processSample() would bail out on gets FLT_MAX,
+// and the others a penalty equal to processSample()'s up to rounding.
+void dtObstacleAvoidanceQuery::processSamples4(const float* vx, const float* vz,
+											   const float* vel, const float* dvel,
+											   const float minPenalty, float* penalties) const
+{
+	const dtFloat4 cx = dtF4Load(vx);
+	const dtFloat4 cz = dtF4Load(vz);
+	const dtFloat4 zero = dtF4Set(0.0f);
+	const dtFloat4 one = dtF4Set(1.0f);
+	const dtFloat4 half = dtF4Set(0.5f);
+	const dtFloat4 two = dtF4Set(2.0f);
+
+	// penalty for straying away from the desired and current velocities
+	const dtFloat4 invVmax = dtF4Set(m_invVmax);
+	dtFloat4 dx = dtF4Sub(dtF4Set(dvel[0]), cx);
+	dtFloat4 dz = dtF4Sub(dtF4Set(dvel[2]), cz);
+	const dtFloat4 vpen = dtF4Mul(dtF4Set(m_params.weightDesVel),
+								  dtF4Mul(dtF4Sqrt(dtF4Add(dtF4Mul(dx,dx), dtF4Mul(dz,dz))), invVmax));
+	dx = dtF4Sub(dtF4Set(vel[0]), cx);
+	dz = dtF4Sub(dtF4Set(vel[2]), cz);
+	const dtFloat4 vcpen = dtF4Mul(dtF4Set(m_params.weightCurVel),
+								   dtF4Mul(dtF4Sqrt(dtF4Add(dtF4Mul(dx,dx), dtF4Mul(dz,dz))), invVmax));
+
+	// Threshold hit time below which processSample() bails out.
+	const dtFloat4 horizTime = dtF4Set(m_params.horizTime);
+	const dtFloat4 minPen = dtF4Sub(dtF4Sub(dtF4Set(minPenalty), vpen), vcpen);
+	const dtFloat4 tThreshold = dtF4Mul(dtF4Sub(dtF4Div(dtF4Set(m_params.weightToi), minPen), dtF4Set(0.1f)), horizTime);
+	dtMask4 bail = dtF4Gt(dtF4Sub(tThreshold, horizTime), dtF4Set(-FLT_EPSILON));
+	if (dtM4All(bail))
+	{
+		dtF4Store(penalties, dtF4Set(FLT_MAX));
+		return;
+	}
+
+	// Find min time of impact and exit amongst all obstacles.
+	dtFloat4 tmin = horizTime;
+	dtFloat4 side = zero;
+
+	const dtFloat4 vabx0 = dtF4Sub(dtF4Mul(cx, two), dtF4Set(vel[0]));
+	const dtFloat4 vabz0 = dtF4Sub(dtF4Mul(cz, two), dtF4Set(vel[2]));
+	const float* cir = m_circleSoa;
+	const int nc = m_maxCircles;
+	for (int i = 0; i < m_ncircles; ++i)
+	{
+		// RVO
+		const dtFloat4 vabx = dtF4Sub(vabx0, dtF4Set(cir[DT_CIR_VX*nc + i]));
+		const dtFloat4 vabz = dtF4Sub(vabz0, dtF4Set(cir[DT_CIR_VZ*nc + i]));
+
+		// Side
+		const dtFloat4 dp = dtF4Add(dtF4Mul(dtF4Add(dtF4Mul(dtF4Set(cir[DT_CIR_DPX*nc + i]), vabx),
+													dtF4Mul(dtF4Set(cir[DT_CIR_DPZ*nc + i]), vabz)), half), half);
+		const dtFloat4 np = dtF4Mul(dtF4Add(dtF4Mul(dtF4Set(cir[DT_CIR_NPX*nc + i]), vabx),
+											dtF4Mul(dtF4Set(cir[DT_CIR_NPZ*nc + i]), vabz)), two);
+		side = dtF4Add(side, dtF4Max(dtF4Min(dtF4Min(dp, np), one), zero));
+
+		// sweepCircleCircle
+		const dtFloat4 sx = dtF4Set(cir[DT_CIR_SX*nc + i]);
+		const dtFloat4 sz = dtF4Set(cir[DT_CIR_SZ*nc + i]);
+		const dtFloat4 a = dtF4Add(dtF4Mul(vabx, vabx), dtF4Mul(vabz, vabz));
+		const dtFloat4 b = dtF4Add(dtF4Mul(vabx, sx), dtF4Mul(vabz, sz));
+		const dtFloat4 d = dtF4Sub(dtF4Mul(b, b), dtF4Mul(a, dtF4Set(cir[DT_CIR_C*nc + i])));
+		const dtMask4 hit = dtM4And(dtF4Ge(a, dtF4Set(0.0001f)), dtF4Ge(d, zero));
+		if (!dtM4Any(hit))
+			continue;
+		const dtFloat4 ia = dtF4Div(one, a);
+		const dtFloat4 rd = dtF4Sqrt(dtF4Max(d, zero));
+		dtFloat4 htmin = dtF4Mul(dtF4Sub(b, rd), ia);
+		const dtFloat4 htmax = dtF4Mul(dtF4Add(b, rd), ia);
+
+		// Handle overlapping obstacles: avoid more when overlapped.
+		const dtMask4 overlap = dtM4And(dtF4Lt(htmin, zero), dtF4Gt(htmax, zero));
+		htmin = dtF4Select(overlap, dtF4Mul(htmin, dtF4Set(-0.5f)), htmin);
+
+		// The closest obstacle is somewhere ahead of us, keep track of nearest obstacle.
+		const dtMask4 closer = dtM4And(hit, dtM4And(dtF4Ge(htmin, zero), dtF4Lt(htmin, tmin)));
+		tmin = dtF4Select(closer, htmin, tmin);
+	}
+
+	bail = dtM4Or(bail, dtF4Lt(tmin, tThreshold));
+	if (dtM4All(bail))
+	{
+		dtF4Store(penalties, dtF4Set(FLT_MAX));
+		return;
+	}
+
+	const float* seg = m_segmentSoa;
+	const int ns = m_maxSegments;
+	for (int i = 0; i < m_nsegments; ++i)
+	{
+		dtFloat4 htmin;
+		dtMask4 hit;
+		if (seg[DT_SEG_TOUCH*ns + i] != 0.0f)
+		{
+			// Special case when the agent is very close to the segment.
+			// If the velocity is pointing towards the segment, no collision.
+			// Else immediate collision.
+			const dtFloat4 dn = dtF4Add(dtF4Mul(dtF4Set(seg[DT_SEG_NX*ns + i]), cx),
+										dtF4Mul(dtF4Set(seg[DT_SEG_NZ*ns + i]), cz));
+			hit = dtF4Ge(dn, zero);
+			htmin = zero;
+		}
+		else
+		{
+			// isectRaySeg
+			const dtFloat4 sgx = dtF4Set(seg[DT_SEG_VX*ns + i]);
+			const dtFloat4 sgz = dtF4Set(seg[DT_SEG_VZ*ns + i]);
+			const dtFloat4 wx = dtF4Set(seg[DT_SEG_WX*ns + i]);
+			const dtFloat4 wz = dtF4Set(seg[DT_SEG_WZ*ns + i]);
+			dtFloat4 d = dtF4Sub(dtF4Mul(cz, sgx), dtF4Mul(cx, sgz));
+			hit = dtM4Or(dtF4Ge(d, dtF4Set(1e-6f)), dtF4Le(d, dtF4Set(-1e-6f)));
+			if (!dtM4Any(hit))
+				continue;
+			d = dtF4Div(one, dtF4Select(hit, d, one));
+			const dtFloat4 t = dtF4Mul(dtF4Set(seg[DT_SEG_PVW*ns + i]), d);
+			const dtFloat4 u = dtF4Mul(dtF4Sub(dtF4Mul(cz, wx), dtF4Mul(cx, wz)), d);
+			hit = dtM4And(hit, dtM4And(dtM4And(dtF4Ge(t, zero), dtF4Le(t, one)),
+									   dtM4And(dtF4Ge(u, zero), dtF4Le(u, one))));
+			htmin = t;
+		}
+
+		// Avoid less when facing walls.
+		htmin = dtF4Mul(htmin, two);
+
+		// The closest obstacle is somewhere ahead of us, keep track of nearest obstacle.
+		tmin = dtF4Select(dtM4And(hit, dtF4Lt(htmin, tmin)), htmin, tmin);
+	}
+
+	// Normalize side bias, to prevent it dominating too much.
+	if (m_ncircles)
+		side = dtF4Div(side, dtF4Set((float)m_ncircles));
+
+	const dtFloat4 spen = dtF4Mul(dtF4Set(m_params.weightSide), side);
+	const dtFloat4 tpen = dtF4Mul(dtF4Set(m_params.weightToi),
+								  dtF4Div(one, dtF4Add(dtF4Set(0.1f), dtF4Mul(tmin, dtF4Set(m_invHorizTime)))));
+
+	const dtFloat4 penalty = dtF4Add(dtF4Add(dtF4Add(vpen, vcpen), spen), tpen);
+
+	bail = dtM4Or(bail, dtF4Lt(tmin, tThreshold));
+	dtF4Store(penalties, dtF4Select(bail, dtF4Set(FLT_MAX), penalty));
+}
+#else
+void dtObstacleAvoidanceQuery::processSamples4(const float* /*vx*/, const float* /*vz*/,
+											   const float* /*vel*/, const float* /*dvel*/,
+											   const float /*minPenalty*/, float* /*penalties*/) const
+{
+}
+#endif // DT_AVOIDANCE_SIMD
+
+// Scores n candidate velocities (x and z) four at a time, in order, and keeps
+// the first one with the lowest penalty below minPenalty in best.
+// Returns the index of that candidate, or -1 if none beat minPenalty.
+int dtObstacleAvoidanceQuery::processSamples(const float* vx, const float* vz, const int n,
+											 const float* vel, const float* dvel,
+											 float& minPenalty, float* best) const
+{
+	int bestIdx = -1;
+	for (int i = 0; i < n; i += 4)
+	{
+		const int m = dtMin(4, n - i);
+		float bx[4], bz[4], pen[4];
+		for (int j = 0; j < 4; ++j)
+		{
+			// Pad the last group with copies of its last candidate.
+			bx[j] = vx[i + dtMin(j, m-1)];
+			bz[j] = vz[i + dtMin(j, m-1)];
+		}
+		processSamples4(bx, bz, vel, dvel, minPenalty, pen);
+		for (int j = 0; j < m; ++j)
+		{
+			if (pen[j] < minPenalty)
+			{
+				minPenalty = pen[j];
+				bestIdx = i + j;
+			}
+		}
+	}
+	if (bestIdx >= 0)
+		dtVset(best, vx[bestIdx], 0, vz[bestIdx]);
+	return bestIdx;
+}
+
 int dtObstacleAvoidanceQuery::sampleVelocityGrid(const float* pos, const float rad, const float vmax,
 												 const float* vel, const float* dvel, float* nvel,
 												 const dtObstacleAvoidanceParams* params,
@@ -456,6 +780,30 @@ int dtObstacleAvoidanceQuery::sampleVelocityGrid(const float* pos, const float r
 		
 	float minPenalty = FLT_MAX;
 	int ns = 0;
+
+#ifdef DT_AVOIDANCE_SIMD
+	if (!debug)
+	{
+		prepareSoa(pos, rad);
+
+		// One row of candidates at a time.
+		float vx[256], vz[256];
+		for (int y = 0; y < m_params.gridSize; ++y)
+		{
+			int n = 0;
+			for (int x = 0; x < m_params.gridSize; ++x)
+			{
+				vx[n] = cvx + x*cs - half;
+				vz[n] = cvz + y*cs - half;
+				if (dtSqr(vx[n])+dtSqr(vz[n]) > dtSqr(vmax+cs/2)) continue;
+				n++;
+			}
+			processSamples(vx, vz, n, vel, dvel, minPenalty, nvel);
+			ns += n;
+		}
+		return ns;
+	}
+#endif
 		
 	for (int y = 0; y < m_params.gridSize; ++y)
 	{
@@ -578,6 +926,11 @@ int dtObstacleAvoidanceQuery::sampleVelocityAdaptive(const float* pos, const flo
 	}
 
 
+#ifdef DT_AVOIDANCE_SIMD
+	if (!debug)
+		prepareSoa(pos, rad);
+#endif
+
 	// Start sampling.
 	float cr = vmax * (1.0f - m_params.velBias);
 	float res[3];
@@ -589,6 +942,28 @@ int dtObstacleAvoidanceQuery::sampleVelocityAdaptive(const float* pos, const flo
 		float minPenalty = FLT_MAX;
 		float bvel[3];
 		dtVset(bvel, 0,0,0);
+
+#ifdef DT_AVOIDANCE_SIMD
+		if (!debug)
+		{
+			float vx[DT_MAX_PATTERN_DIVS*DT_MAX_PATTERN_RINGS+1], vz[DT_MAX_PATTERN_DIVS*DT_MAX_PATTERN_RINGS+1];
+			int n = 0;
+			for (int i = 0; i < npat; ++i)
+			{
+				vx[n] = res[0] + pat[i*2+0]*cr;
+				vz[n] = res[2] + pat[i*2+1]*cr;
+				if (dtSqr(vx[n])+dtSqr(vz[n]) > dtSqr(vmax+0.001f)) continue;
+				n++;
+			}
+			processSamples(vx, vz, n, vel, dvel, minPenalty, bvel);
+			ns += n;
+
+			dtVcopy(res, bvel);
+
+			cr *= 0.5f;
+			continue;
+		}
+#endif
 		
 		for (int i = 0; i < npat; ++i)
 		{
@@ -17,6 +17,7 @@
 //
 
 #include <string.h>
+#include <chrono>
 #include "DetourPathQueue.h"
 #include "DetourNavMesh.h"
 #include "DetourNavMeshQuery.h"
@@ -25,13 +26,14 @@
 
 
 dtPathQueue::dtPathQueue() :
+	m_queue(0),
+	m_maxQueue(0),
+	m_current(-1),
 	m_nextHandle(1),
 	m_maxPathSize(0),
-	m_queueHead(0),
+	m_lastIters(0),
 	m_navquery(0)
 {
-	for (int i = 0; i < MAX_QUEUE; ++i)
-		m_queue[i].path = 0;
 }
 
 dtPathQueue::~dtPathQueue()
@@ -43,14 +45,16 @@ void dtPathQueue::purge()
 {
 	dtFreeNavMeshQuery(m_navquery);
 	m_navquery = 0;
-	for (int i = 0; i < MAX_QUEUE; ++i)
-	{
+	for (int i = 0; i < m_maxQueue; ++i)
 		dtFree(m_queue[i].path);
-		m_queue[i].path = 0;
-	}
+	dtFree(m_queue);
+	m_queue = 0;
+	m_maxQueue = 0;
+	m_current = -1;
 }
 
-bool dtPathQueue::init(const int maxPathSize, const int maxSearchNodeCount, dtNavMesh* nav)
+bool dtPathQueue::init(const int maxPathSize, const int maxSearchNodeCount, const dtNavMesh* nav,
+					   const int maxQueue)
 {
 	purge();
 
@@ -60,8 +64,14 @@ bool dtPathQueue::init(const int maxPathSize, const int maxSearchNodeCount, dtNa
 	if (dtStatusFailed(m_navquery->init(nav, maxSearchNodeCount)))
 		return false;
 	
+	m_queue = (PathQuery*)dtAlloc(sizeof(PathQuery)*maxQueue, DT_ALLOC_PERM);
+	if (!m_queue)
+		return false;
+	memset(m_queue, 0, sizeof(PathQuery)*maxQueue);
+	m_maxQueue = maxQueue;
+	
 	m_maxPathSize = maxPathSize;
-	for (int i = 0; i < MAX_QUEUE; ++i)
+	for (int i = 0; i < m_maxQueue; ++i)
 	{
 		m_queue[i].ref = DT_PATHQ_INVALID;
 		m_queue[i].path = (dtPolyRef*)dtAlloc(sizeof(dtPolyRef)*m_maxPathSize, DT_ALLOC_PERM);
@@ -69,76 +79,108 @@ bool dtPathQueue::init(const int maxPathSize, const int maxSearchNodeCount, dtNa
 			return false;
 	}
 	
-	m_queueHead = 0;
+	m_current = -1;
+	m_lastIters = 0;
 	
 	return true;
 }
 
-void dtPathQueue::update(const int maxIters)
+int dtPathQueue::nextRequest() const
+{
+	// The sliced search can only hold one request, finish it first.
+	if (m_current != -1)
+		return m_current;
+	
+	int best = -1;
+	for (int i = 0; i < m_maxQueue; ++i)
+	{
+		const PathQuery& q = m_queue[i];
+		if (q.ref == DT_PATHQ_INVALID || q.status != 0)
+			continue;
+		if (best == -1 || q.priority > m_queue[best].priority ||
+			(q.priority == m_queue[best].priority && (int)(q.ref - m_queue[best].ref) < 0))
+			best = i;
+	}
+	return best;
+}
+
+/// @par
+///
+/// A request under search is always finished before the next one is
+/// started, whatever its band. With a time budget, the clock is checked
+/// every 16 iterations, so the update may run over by as many.
+void dtPathQueue::update(const int maxIters, const float maxTimeMs)
 {
 	static const int MAX_KEEP_ALIVE = 2; // in update ticks.
+	static const int TIME_CHECK_ITERS = 16;
 
-	// Update path request until there is nothing to update
-	// or upto maxIters pathfinder iterations has been consumed.
-	int iterCount = maxIters;
-	
-	for (int i = 0; i < MAX_QUEUE; ++i)
+	// If the path result has not been read in few frames, free the slot.
+	for (int i = 0; i < m_maxQueue; ++i)
 	{
-		PathQuery& q = m_queue[m_queueHead % MAX_QUEUE];
-		
-		// Skip inactive requests.
+		PathQuery& q = m_queue[i];
 		if (q.ref == DT_PATHQ_INVALID)
-		{
-			m_queueHead++;
 			continue;
-		}
-		
-		// Handle completed request.
 		if (dtStatusSucceed(q.status) || dtStatusFailed(q.status))
 		{
-			// If the path result has not been read in few frames, free the slot.
 			q.keepAlive++;
 			if (q.keepAlive > MAX_KEEP_ALIVE)
 			{
 				q.ref = DT_PATHQ_INVALID;
 				q.status = 0;
 			}
-			
-			m_queueHead++;
-			continue;
 		}
+	}
+
+	// Update path requests until there is nothing to update
+	// or the budget has been consumed.
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point start = maxTimeMs > 0.0f ? Clock::now() : Clock::time_point();
+	int iterCount = maxIters > 0 ? maxIters : 0x7fffffff;
+	m_lastIters = 0;
+	
+	while (iterCount > 0)
+	{
+		const int slot = nextRequest();
+		if (slot == -1)
+			break;
+		PathQuery& q = m_queue[slot];
 		
 		// Handle query start.
 		if (q.status == 0)
 		{
 			q.status = m_navquery->initSlicedFindPath(q.startRef, q.endRef, q.startPos, q.endPos, q.filter);
-		}		
+			m_current = dtStatusInProgress(q.status) ? slot : -1;
+		}
 		// Handle query in progress.
 		if (dtStatusInProgress(q.status))
 		{
 			int iters = 0;
-			q.status = m_navquery->updateSlicedFindPath(iterCount, &iters);
+			const int slice = maxTimeMs > 0.0f ? dtMin(iterCount, TIME_CHECK_ITERS) : iterCount;
+			q.status = m_navquery->updateSlicedFindPath(slice, &iters);
+			iters = dtMax(iters, 1);
 			iterCount -= iters;
+			m_lastIters += iters;
 		}
 		if (dtStatusSucceed(q.status))
 		{
 			q.status = m_navquery->finalizeSlicedFindPath(q.path, &q.npath, m_maxPathSize);
 		}
-
-		if (iterCount <= 0)
+		if (!dtStatusInProgress(q.status))
+			m_current = -1;
+		
+		if (maxTimeMs > 0.0f &&
+			std::chrono::duration<float, std::milli>(Clock::now() - start).count() >= maxTimeMs)
 			break;
-
-		m_queueHead++;
 	}
 }
 
 dtPathQueueRef dtPathQueue::request(dtPolyRef startRef, dtPolyRef endRef,
 									const float* startPos, const float* endPos,
-									const dtQueryFilter* filter)
+									const dtQueryFilter* filter, const unsigned char priority)
 {
 	// Find empty slot
 	int slot = -1;
-	for (int i = 0; i < MAX_QUEUE; ++i)
+	for (int i = 0; i < m_maxQueue; ++i)
 	{
 		if (m_queue[i].ref == DT_PATHQ_INVALID)
 		{
@@ -164,13 +206,36 @@ dtPathQueueRef dtPathQueue::request(dtPolyRef startRef, dtPolyRef endRef,
 	q.npath = 0;
 	q.filter = filter;
 	q.keepAlive = 0;
+	q.priority = priority;
 	
 	return ref;
 }
 
+int dtPathQueue::getPendingCount() const
+{
+	int n = 0;
+	for (int i = 0; i < m_maxQueue; ++i)
+	{
+		if (m_queue[i].ref != DT_PATHQ_INVALID && (m_queue[i].status == 0 || dtStatusInProgress(m_queue[i].status)))
+			n++;
+	}
+	return n;
+}
+
+int dtPathQueue::getFreeCount() const
+{
+	int n = 0;
+	for (int i = 0; i < m_maxQueue; ++i)
+	{
+		if (m_queue[i].ref == DT_PATHQ_INVALID)
+			n++;
+	}
+	return n;
+}
+
 dtStatus dtPathQueue::getRequestStatus(dtPathQueueRef ref) const
 {
-	for (int i = 0; i < MAX_QUEUE; ++i)
+	for (int i = 0; i < m_maxQueue; ++i)
 	{
 		if (m_queue[i].ref == ref)
 			return m_queue[i].status;
@@ -180,7 +245,7 @@ dtStatus dtPathQueue::getRequestStatus(dtPathQueueRef ref) const
 
 dtStatus dtPathQueue::getPathResult(dtPathQueueRef ref, dtPolyRef* path, int* pathSize, const int maxPath)
 {
-	for (int i = 0; i < MAX_QUEUE; ++i)
+	for (int i = 0; i < m_maxQueue; ++i)
 	{
 		if (m_queue[i].ref == ref)
 		{
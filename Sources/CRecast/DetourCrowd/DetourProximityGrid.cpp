@@ -53,14 +53,30 @@ dtProximityGrid::dtProximityGrid() :
 	m_poolHead(0),
 	m_poolSize(0),
 	m_buckets(0),
-	m_bucketsSize(0)
+	m_bucketsSize(0),
+	m_pointStart(0),
+	m_pointBucket(0)
 {
 }
 
 dtProximityGrid::~dtProximityGrid()
+{
+	purge();
+}
+
+void dtProximityGrid::purge()
 {
 	dtFree(m_buckets);
+	m_buckets = 0;
 	dtFree(m_pool);
+	m_pool = 0;
+	dtFree(m_pointStart);
+	m_pointStart = 0;
+	dtFree(m_pointBucket);
+	m_pointBucket = 0;
+	m_bucketsSize = 0;
+	m_poolSize = 0;
+	m_poolHead = 0;
 }
 
 bool dtProximityGrid::init(const int poolSize, const float cellSize)
@@ -68,6 +84,8 @@ bool dtProximityGrid::init(const int poolSize, const float cellSize)
 	dtAssert(poolSize > 0);
 	dtAssert(cellSize > 0.0f);
 	
+	purge();
+	
 	m_cellSize = cellSize;
 	m_invCellSize = 1.0f / m_cellSize;
 	
@@ -89,9 +107,45 @@ bool dtProximityGrid::init(const int poolSize, const float cellSize)
 	return true;
 }
 
+/// @par
+///
+/// Point grids keep one bucket per item on average. The items are counting
+/// sorted into their buckets on every #buildPoints(), which touches each item
+/// twice and leaves every bucket contiguous in memory.
+bool dtProximityGrid::initPoints(const int maxItems, const float cellSize)
+{
+	dtAssert(maxItems > 0 && maxItems <= 0xffff);
+	dtAssert(cellSize > 0.0f);
+	
+	purge();
+	
+	m_cellSize = cellSize;
+	m_invCellSize = 1.0f / m_cellSize;
+	
+	m_bucketsSize = dtNextPow2(maxItems);
+	m_pointStart = (int*)dtAlloc(sizeof(int)*(m_bucketsSize+1), DT_ALLOC_PERM);
+	if (!m_pointStart)
+		return false;
+	
+	m_poolSize = maxItems;
+	m_pool = (Item*)dtAlloc(sizeof(Item)*m_poolSize, DT_ALLOC_PERM);
+	if (!m_pool)
+		return false;
+	m_pointBucket = (int*)dtAlloc(sizeof(int)*m_poolSize, DT_ALLOC_PERM);
+	if (!m_pointBucket)
+		return false;
+	
+	clear();
+	
+	return true;
+}
+
 void dtProximityGrid::clear()
 {
-	memset(m_buckets, 0xff, sizeof(unsigned short)*m_bucketsSize);
+	if (m_pointStart)
+		memset(m_pointStart, 0, sizeof(int)*(m_bucketsSize+1));
+	else
+		memset(m_buckets, 0xff, sizeof(unsigned short)*m_bucketsSize);
 	m_poolHead = 0;
 	m_bounds[0] = 0xffff;
 	m_bounds[1] = 0xffff;
@@ -103,6 +157,8 @@ void dtProximityGrid::addItem(const unsigned short id,
 							  const float minx, const float miny,
 							  const float maxx, const float maxy)
 {
+	dtAssert(!m_pointStart);
+	
 	const int iminx = (int)dtMathFloorf(minx * m_invCellSize);
 	const int iminy = (int)dtMathFloorf(miny * m_invCellSize);
 	const int imaxx = (int)dtMathFloorf(maxx * m_invCellSize);
@@ -133,6 +189,57 @@ void dtProximityGrid::addItem(const unsigned short id,
 	}
 }
 
+void dtProximityGrid::setCellSize(const float cellSize)
+{
+	dtAssert(m_pointStart);
+	dtAssert(cellSize > 0.0f);
+	
+	m_cellSize = cellSize;
+	m_invCellSize = 1.0f / m_cellSize;
+}
+
+void dtProximityGrid::buildPoints(const float* pos, const int n)
+{
+	dtAssert(m_pointStart);
+	dtAssert(n <= m_poolSize);
+	
+	clear();
+	
+	// Count the items in each bucket.
+	for (int i = 0; i < n; ++i)
+	{
+		const int x = (int)dtMathFloorf(pos[i*2+0] * m_invCellSize);
+		const int y = (int)dtMathFloorf(pos[i*2+1] * m_invCellSize);
+		
+		m_bounds[0] = dtMin(m_bounds[0], x);
+		m_bounds[1] = dtMin(m_bounds[1], y);
+		m_bounds[2] = dtMax(m_bounds[2], x);
+		m_bounds[3] = dtMax(m_bounds[3], y);
+		
+		const int h = hashPos2(x, y, m_bucketsSize);
+		m_pointBucket[i] = h;
+		m_pointStart[h+1]++;
+	}
+	
+	// Turn the counts into bucket starts, then scatter the items, advancing
+	// each start to the end of its bucket.
+	for (int h = 0; h < m_bucketsSize; ++h)
+		m_pointStart[h+1] += m_pointStart[h];
+	for (int i = 0; i < n; ++i)
+	{
+		Item& item = m_pool[m_pointStart[m_pointBucket[i]]++];
+		item.id = (unsigned short)i;
+		item.x = (short)dtMathFloorf(pos[i*2+0] * m_invCellSize);
+		item.y = (short)dtMathFloorf(pos[i*2+1] * m_invCellSize);
+		item.next = 0xffff;
+	}
+	for (int h = m_bucketsSize; h > 0; --h)
+		m_pointStart[h] = m_pointStart[h-1];
+	m_pointStart[0] = 0;
+	
+	m_poolHead = n;
+}
+
 int dtProximityGrid::queryItems(const float minx, const float miny,
 								const float maxx, const float maxy,
 								unsigned short* ids, const int maxIds) const
@@ -144,6 +251,27 @@ int dtProximityGrid::queryItems(const float minx, const float miny,
 	
 	int n = 0;
 	
+	if (m_pointStart)
+	{
+		for (int y = iminy; y <= imaxy; ++y)
+		{
+			for (int x = iminx; x <= imaxx; ++x)
+			{
+				const int h = hashPos2(x, y, m_bucketsSize);
+				for (int i = m_pointStart[h]; i < m_pointStart[h+1]; ++i)
+				{
+					const Item& item = m_pool[i];
+					if ((int)item.x != x || (int)item.y != y)
+						continue;
+					if (n >= maxIds)
+						return n;
+					ids[n++] = item.id;
+				}
+			}
+		}
+		return n;
+	}
+	
 	for (int y = iminy; y <= imaxy; ++y)
 	{
 		for (int x = iminx; x <= imaxx; ++x)
@@ -181,6 +309,16 @@ int dtProximityGrid::getItemCountAt(const int x, const int y) const
 	int n = 0;
 	
 	const int h = hashPos2(x, y, m_bucketsSize);
+	if (m_pointStart)
+	{
+		for (int i = m_pointStart[h]; i < m_pointStart[h+1]; ++i)
+		{
+			if ((int)m_pool[i].x == x && (int)m_pool[i].y == y)
+				n++;
+		}
+		return n;
+	}
+	
 	unsigned short idx = m_buckets[h];
 	while (idx != 0xffff)
 	{
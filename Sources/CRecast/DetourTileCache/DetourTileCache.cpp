@@ -6,11 +6,13 @@
 #include "DetourMath.h"
 #include "DetourAlloc.h"
 #include "DetourAssert.h"
+#include "DetourMemory.h"
 #include <string.h>
 #include <new>
 
 dtTileCache* dtAllocTileCache()
 {
+	dtMemoryOwnerScope owner(DT_MEMORY_TILE_CACHE);
 	void* mem = dtAlloc(sizeof(dtTileCache), DT_ALLOC_PERM);
 	if (!mem) return 0;
 	return new(mem) dtTileCache;
@@ -120,6 +122,7 @@ dtStatus dtTileCache::init(const dtTileCacheParams* params,
 						   dtTileCacheCompressor* tcomp,
 						   dtTileCacheMeshProcess* tmproc)
 {
+	dtMemoryOwnerScope owner(DT_MEMORY_TILE_CACHE);
 	m_talloc = talloc;
 	m_tcomp = tcomp;
 	m_tmproc = tmproc;
@@ -283,6 +286,8 @@ dtStatus dtTileCache::addTile(unsigned char* data, const int dataSize, unsigned
 	tile->compressed = tile->data + headerSize;
 	tile->compressedSize = tile->dataSize - headerSize;
 	tile->flags = flags;
+	if (flags & DT_COMPRESSEDTILE_FREE_DATA)
+		dtMemoryTrackOwner(data, (size_t)dataSize, DT_MEMORY_TILE_CACHE);
 	
 	if (result)
 		*result = getTileRef(tile);
@@ -656,6 +661,7 @@ dtStatus dtTileCache::buildNavMeshTilesAt(const int tx, const int ty, dtNavMesh*
 
 dtStatus dtTileCache::buildNavMeshTile(const dtCompressedTileRef ref, dtNavMesh* navmesh)
 {	
+	dtMemoryOwnerScope owner(DT_MEMORY_BUILD);
 	dtAssert(m_talloc);
 	dtAssert(m_tcomp);
 	
@@ -0,0 +1,245 @@
+// GeometryCleanup.cpp
+// Vertex welding and triangle culling of build input geometry
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "GeometryCleanup.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+// Cell of the welding grid, or the exact position when welding without tolerance
+struct WeldKey
+{
+    int64_t x, y, z;
+
+    bool operator==(const WeldKey& o) const { return x == o.x && y == o.y && z == o.z; }
+};
+
+struct WeldKeyHash
+{
+    size_t operator()(const WeldKey& k) const
+    {
+        uint64_t h = (uint64_t)k.x * 0x9e3779b97f4a7c15ULL;
+        h ^= (uint64_t)k.y * 0xc2b2ae3d27d4eb4fULL + (h << 6) + (h >> 2);
+        h ^= (uint64_t)k.z * 0x165667b19e3779f9ULL + (h << 6) + (h >> 2);
+        return (size_t)h;
+    }
+};
+
+// Three vertex indices in ascending order
+struct TriangleKey
+{
+    int32_t a, b, c;
+
+    bool operator==(const TriangleKey& o) const { return a == o.a && b == o.b && c == o.c; }
+};
+
+struct TriangleKeyHash
+{
+    size_t operator()(const TriangleKey& k) const
+    {
+        uint64_t h = (uint64_t)(uint32_t)k.a * 0x9e3779b97f4a7c15ULL;
+        h ^= (uint64_t)(uint32_t)k.b * 0xc2b2ae3d27d4eb4fULL + (h << 6) + (h >> 2);
+        h ^= (uint64_t)(uint32_t)k.c * 0x165667b19e3779f9ULL + (h << 6) + (h >> 2);
+        return (size_t)h;
+    }
+};
+
+static inline int64_t weldCell(float v, double invTolerance)
+{
+    const double c = floor((double)v * invTolerance);
+    const double limit = 4.0e18;
+    return (int64_t)std::max(-limit, std::min(limit, c));
+}
+
+static inline int64_t exactBits(float v)
+{
+    if (v == 0.0f) v = 0.0f; // -0 and +0 are the same position
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+// remap[i] = the vertex that replaces vertex i: the lowest-numbered one within
+// tolerance, or i itself. Only vertices that replace themselves go in the grid.
+static int weldVertices(const float* verts, int nverts, float tolerance, std::vector<int>& remap)
+{
+    remap.resize(nverts);
+    std::unordered_map<WeldKey, int, WeldKeyHash> cellHead;
+    cellHead.reserve(nverts);
+    std::vector<int> next(nverts, -1);
+    const bool exact = !(tolerance > 0.0f);
+    const double invTolerance = exact ? 0.0 : 1.0 / tolerance;
+    const float tolerance2 = tolerance * tolerance;
+    int welded = 0;
+
+    for (int i = 0; i < nverts; ++i) {
+        const float* v = &verts[i * 3];
+        remap[i] = i;
+        if (!isfinite(v[0]) || !isfinite(v[1]) || !isfinite(v[2])) continue;
+
+        WeldKey key;
+        if (exact) {
+            key = { exactBits(v[0]), exactBits(v[1]), exactBits(v[2]) };
+        } else {
+            key = { weldCell(v[0], invTolerance), weldCell(v[1], invTolerance), weldCell(v[2], invTolerance) };
+        }
+
+        int found = -1;
+        const int reach = exact ? 0 : 1;
+        for (int dz = -reach; dz <= reach; ++dz) {
+            for (int dy = -reach; dy <= reach; ++dy) {
+                for (int dx = -reach; dx <= reach; ++dx) {
+                    const WeldKey cell = { key.x + dx, key.y + dy, key.z + dz };
+                    auto it = cellHead.find(cell);
+                    if (it == cellHead.end()) continue;
+                    for (int j = it->second; j >= 0; j = next[j]) {
+                        const float* u = &verts[j * 3];
+                        const float ex = u[0] - v[0];
+                        const float ey = u[1] - v[1];
+                        const float ez = u[2] - v[2];
+                        const bool close = exact ? (u[0] == v[0] && u[1] == v[1] && u[2] == v[2])
+                                                 : ex * ex + ey * ey + ez * ez <= tolerance2;
+                        if (close && (found < 0 || j < found)) found = j;
+                    }
+                }
+            }
+        }
+
+        if (found >= 0) {
+            remap[i] = found;
+            welded++;
+        } else {
+            auto inserted = cellHead.emplace(key, i);
+            if (!inserted.second) {
+                next[i] = inserted.first->second;
+                inserted.first->second = i;
+            }
+        }
+    }
+    return welded;
+}
+
+// The unit normal rcMarkWalkableTriangles computes for a triangle, with the
+// same float operations so the walkable test agrees at the threshold
+static void triangleNormal(const float* v0, const float* v1, const float* v2, float* n)
+{
+    const float e0[3] = { v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2] };
+    const float e1[3] = { v2[0] - v0[0], v2[1] - v0[1], v2[2] - v0[2] };
+    n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+    n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+    n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+    const float d = 1.0f / sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    n[0] *= d;
+    n[1] *= d;
+    n[2] *= d;
+}
+
+// Zero area: the edges from v0 are parallel to within about a microradian
+static bool isDegenerate(const float* v0, const float* v1, const float* v2)
+{
+    const double e0[3] = { (double)v1[0] - v0[0], (double)v1[1] - v0[1], (double)v1[2] - v0[2] };
+    const double e1[3] = { (double)v2[0] - v0[0], (double)v2[1] - v0[1], (double)v2[2] - v0[2] };
+    const double cx = e0[1] * e1[2] - e0[2] * e1[1];
+    const double cy = e0[2] * e1[0] - e0[0] * e1[2];
+    const double cz = e0[0] * e1[1] - e0[1] * e1[0];
+    const double len0 = e0[0] * e0[0] + e0[1] * e0[1] + e0[2] * e0[2];
+    const double len1 = e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2];
+    const double cross2 = cx * cx + cy * cy + cz * cz;
+    return !(cross2 > 1e-12 * len0 * len1);
+}
+
+void cleanupGeometry(const float* verts, int nverts, const int32_t* tris, int ntris,
+                     const GeometryCleanupSettings& settings,
+                     std::vector<float>& outVerts, std::vector<int32_t>& outTris,
+                     GeometryCleanupStats& stats)
+{
+    memset(&stats, 0, sizeof(stats));
+    outVerts.clear();
+    outTris.clear();
+
+    std::vector<int> remap;
+    stats.weldedVertices = weldVertices(verts, nverts, settings.weldTolerance, remap);
+
+    const bool cullSteep = settings.walkableSlopeAngle > 0.0f;
+    const float walkableThr = cosf(settings.walkableSlopeAngle / 180.0f * 3.14159265f);
+
+    // Kept triangles in input order, each with how far up it faces
+    std::vector<int32_t> kept;
+    std::vector<float> keptUp;
+    kept.reserve((size_t)ntris * 3);
+    std::unordered_map<TriangleKey, int, TriangleKeyHash> seen;
+    if (settings.removeDuplicates) seen.reserve(ntris);
+
+    for (int i = 0; i < ntris; ++i) {
+        const int32_t* t = &tris[i * 3];
+        if (t[0] < 0 || t[0] >= nverts || t[1] < 0 || t[1] >= nverts || t[2] < 0 || t[2] >= nverts) {
+            stats.degenerateTriangles++;
+            continue;
+        }
+        const int32_t a = remap[t[0]];
+        const int32_t b = remap[t[1]];
+        const int32_t c = remap[t[2]];
+        const float* va = &verts[a * 3];
+        const float* vb = &verts[b * 3];
+        const float* vc = &verts[c * 3];
+        if (a == b || b == c || a == c || isDegenerate(va, vb, vc)) {
+            stats.degenerateTriangles++;
+            continue;
+        }
+
+        float n[3];
+        triangleNormal(va, vb, vc, n);
+        if (cullSteep && !(n[1] > walkableThr)) {
+            stats.steepTriangles++;
+            continue;
+        }
+
+        if (settings.removeDuplicates) {
+            TriangleKey key = { a, b, c };
+            if (key.a > key.b) std::swap(key.a, key.b);
+            if (key.b > key.c) std::swap(key.b, key.c);
+            if (key.a > key.b) std::swap(key.a, key.b);
+            auto inserted = seen.emplace(key, (int)keptUp.size());
+            if (!inserted.second) {
+                // Coincident faces rasterize to the same spans; the walkable one decides their area
+                const int slot = inserted.first->second;
+                if (n[1] > keptUp[slot]) {
+                    kept[slot * 3 + 0] = a;
+                    kept[slot * 3 + 1] = b;
+                    kept[slot * 3 + 2] = c;
+                    keptUp[slot] = n[1];
+                }
+                stats.duplicateTriangles++;
+                continue;
+            }
+        }
+        kept.push_back(a);
+        kept.push_back(b);
+        kept.push_back(c);
+        keptUp.push_back(n[1]);
+    }
+
+    // Number the vertices still in use in their input order
+    std::vector<int> index(nverts, -1);
+    for (int32_t v : kept) index[v] = 0;
+    int count = 0;
+    for (int i = 0; i < nverts; ++i) {
+        if (index[i] == 0) index[i] = count++;
+    }
+    stats.unusedVertices = nverts - stats.weldedVertices - count;
+
+    outVerts.resize((size_t)count * 3);
+    for (int i = 0; i < nverts; ++i) {
+        if (index[i] >= 0) memcpy(&outVerts[(size_t)index[i] * 3], &verts[i * 3], sizeof(float) * 3);
+    }
+    outTris.resize(kept.size());
+    for (size_t i = 0; i < kept.size(); ++i) {
+        outTris[i] = index[kept[i]];
+    }
+}
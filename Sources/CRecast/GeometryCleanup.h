@@ -0,0 +1,47 @@
+// GeometryCleanup.h
+// Vertex welding and triangle culling of build input geometry
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef GEOMETRYCLEANUP_H
+#define GEOMETRYCLEANUP_H
+
+#include <stdint.h>
+#include <vector>
+
+struct GeometryCleanupSettings
+{
+    // Vertices closer than this are merged into the first of them; 0 merges
+    // only vertices at exactly the same position
+    float weldTolerance;
+    // Keep one of every set of triangles over the same three vertices
+    bool removeDuplicates;
+    // Drop triangles rcMarkWalkableTriangles would not mark walkable at this
+    // slope, in degrees; 0 keeps them
+    float walkableSlopeAngle;
+};
+
+struct GeometryCleanupStats
+{
+    int weldedVertices;         // Vertices merged into an earlier one
+    int unusedVertices;         // Vertices left out because no kept triangle uses them
+    int degenerateTriangles;    // Zero area, repeated or out-of-range indices
+    int duplicateTriangles;
+    int steepTriangles;
+};
+
+// Weld, cull and compact verts (x, y, z per vertex) and tris (three indices per
+// triangle) into outVerts and outTris.
+//
+// Welding moves no vertex: every vertex is replaced by the first one within
+// the tolerance, so the output holds a subset of the input positions in their
+// input order. Of duplicate triangles the one facing most upwards is kept,
+// which is the one whose area rasterization keeps. Triangles keep their order
+// and winding. Throws std::bad_alloc when out of memory.
+void cleanupGeometry(const float* verts, int nverts, const int32_t* tris, int ntris,
+                     const GeometryCleanupSettings& settings,
+                     std::vector<float>& outVerts, std::vector<int32_t>& outTris,
+                     GeometryCleanupStats& stats);
+
+#endif // GEOMETRYCLEANUP_H
@@ -0,0 +1,178 @@
+// LZTileCompressor.cpp
+// LZ4 block-format compressor for DetourTileCache layers
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "LZTileCompressor.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static const int LZ_HASH_BITS = 12;
+static const int LZ_MIN_MATCH = 4;
+static const int LZ_MAX_OFFSET = 65535;
+
+// The format ends every block with literals: the last match must start at
+// least 12 bytes before the end and stop at least 5 bytes before it.
+static const int LZ_MF_LIMIT = 12;
+static const int LZ_LAST_LITERALS = 5;
+
+static inline uint32_t read32(const unsigned char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash4(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Write the continuation bytes of a length whose 4-bit token field saturated
+static inline unsigned char* writeLength(unsigned char* op, int len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+int LZTileCompressor::maxCompressedSize(const int bufferSize)
+{
+    return bufferSize + bufferSize / 255 + 16;
+}
+
+dtStatus LZTileCompressor::compress(const unsigned char* buffer, const int bufferSize,
+                                    unsigned char* compressed, const int maxCompressedSize,
+                                    int* compressedSize)
+{
+    if (maxCompressedSize < this->maxCompressedSize(bufferSize))
+        return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+    const unsigned char* ip = buffer;
+    const unsigned char* anchor = buffer;
+    const unsigned char* const end = buffer + bufferSize;
+    unsigned char* op = compressed;
+
+    if (bufferSize >= LZ_MF_LIMIT + 1) {
+        int table[1 << LZ_HASH_BITS];
+        memset(table, 0xff, sizeof(table));
+
+        const unsigned char* const matchLimit = end - LZ_MF_LIMIT;
+        const unsigned char* const copyLimit = end - LZ_LAST_LITERALS;
+
+        while (ip < matchLimit) {
+            const uint32_t seq = read32(ip);
+            const uint32_t h = hash4(seq);
+            const int candidate = table[h];
+            table[h] = (int)(ip - buffer);
+
+            if (candidate < 0 || (ip - buffer) - candidate > LZ_MAX_OFFSET ||
+                read32(buffer + candidate) != seq) {
+                ++ip;
+                continue;
+            }
+
+            const unsigned char* match = buffer + candidate;
+
+            // Extend the match forward, staying clear of the literal tail
+            const unsigned char* mp = ip + LZ_MIN_MATCH;
+            const unsigned char* mr = match + LZ_MIN_MATCH;
+            while (mp < copyLimit && *mp == *mr) {
+                ++mp;
+                ++mr;
+            }
+
+            const int litLen = (int)(ip - anchor);
+            const int matchLen = (int)(mp - ip) - LZ_MIN_MATCH;
+            const int offset = (int)(ip - match);
+
+            unsigned char* token = op++;
+            *token = (unsigned char)((litLen >= 15 ? 15 : litLen) << 4);
+            if (litLen >= 15) op = writeLength(op, litLen - 15);
+            memcpy(op, anchor, litLen);
+            op += litLen;
+
+            *op++ = (unsigned char)(offset & 0xff);
+            *op++ = (unsigned char)(offset >> 8);
+
+            *token |= (unsigned char)(matchLen >= 15 ? 15 : matchLen);
+            if (matchLen >= 15) op = writeLength(op, matchLen - 15);
+
+            ip = mp;
+            anchor = ip;
+        }
+    }
+
+    // Trailing literals
+    const int litLen = (int)(end - anchor);
+    *op++ = (unsigned char)((litLen >= 15 ? 15 : litLen) << 4);
+    if (litLen >= 15) op = writeLength(op, litLen - 15);
+    memcpy(op, anchor, litLen);
+    op += litLen;
+
+    *compressedSize = (int)(op - compressed);
+    return DT_SUCCESS;
+}
+
+dtStatus LZTileCompressor::decompress(const unsigned char* compressed, const int compressedSize,
+                                      unsigned char* buffer, const int maxBufferSize,
+                                      int* bufferSize)
+{
+    const unsigned char* ip = compressed;
+    const unsigned char* const ipEnd = compressed + compressedSize;
+    unsigned char* op = buffer;
+    unsigned char* const opEnd = buffer + maxBufferSize;
+
+    while (ip < ipEnd) {
+        const unsigned char token = *ip++;
+
+        int litLen = token >> 4;
+        if (litLen == 15) {
+            unsigned char b;
+            do {
+                if (ip >= ipEnd) return DT_FAILURE | DT_INVALID_PARAM;
+                b = *ip++;
+                litLen += b;
+            } while (b == 255);
+        }
+        if (litLen > ipEnd - ip || litLen > opEnd - op)
+            return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+        memcpy(op, ip, litLen);
+        ip += litLen;
+        op += litLen;
+
+        // The last sequence carries literals only
+        if (ip == ipEnd) break;
+
+        if (ipEnd - ip < 2) return DT_FAILURE | DT_INVALID_PARAM;
+        const int offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op - buffer) return DT_FAILURE | DT_INVALID_PARAM;
+
+        int matchLen = token & 15;
+        if (matchLen == 15) {
+            unsigned char b;
+            do {
+                if (ip >= ipEnd) return DT_FAILURE | DT_INVALID_PARAM;
+                b = *ip++;
+                matchLen += b;
+            } while (b == 255);
+        }
+        matchLen += LZ_MIN_MATCH;
+        if (matchLen > opEnd - op) return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+
+        // Byte by byte: overlapping matches repeat the most recent bytes
+        const unsigned char* match = op - offset;
+        for (int i = 0; i < matchLen; ++i)
+            op[i] = match[i];
+        op += matchLen;
+    }
+
+    *bufferSize = (int)(op - buffer);
+    return DT_SUCCESS;
+}
@@ -0,0 +1,30 @@
+// LZTileCompressor.h
+// LZ4 block-format compressor for DetourTileCache layers
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef LZTILECOMPRESSOR_H
+#define LZTILECOMPRESSOR_H
+
+#include "DetourTileCacheBuilder.h"
+
+// Greedy single-pass LZ77 with a 4K-entry hash table, emitting the LZ4 block
+// format. Tile cache layers are small and highly repetitive (heights, area
+// ids and connection bits), so this compresses them several times over while
+// decompressing at memory speed, which is what obstacle updates pay for.
+//
+// Stateless; one instance can be shared by every tile cache.
+class LZTileCompressor : public dtTileCacheCompressor
+{
+public:
+    virtual int maxCompressedSize(const int bufferSize);
+    virtual dtStatus compress(const unsigned char* buffer, const int bufferSize,
+                              unsigned char* compressed, const int maxCompressedSize,
+                              int* compressedSize);
+    virtual dtStatus decompress(const unsigned char* compressed, const int compressedSize,
+                                unsigned char* buffer, const int maxBufferSize,
+                                int* bufferSize);
+};
+
+#endif // LZTILECOMPRESSOR_H
@@ -0,0 +1,436 @@
+// ObjMeshParser.cpp
+// Parallel parser for the vertices and faces of Wavefront OBJ files
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "ObjMeshParser.h"
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int OBJ_GEOM_CACHE_MAGIC = 'O'<<24 | 'B'<<16 | 'J'<<8 | 'C';
+static const int OBJ_GEOM_CACHE_VERSION = 1;
+
+struct ObjGeomCacheFileHeader
+{
+    int32_t magic;
+    int32_t version;
+    int32_t vertexCount;
+    int32_t triangleCount;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+};
+
+// Chunks are cut at line breaks, at least this far apart
+static const size_t OBJ_MIN_CHUNK_SIZE = 1 << 20;
+
+// ================================================
+//       Number parsing
+// ================================================
+
+static const double OBJ_POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// strtof over the whole token, 0 unless it reads all of it
+static float parseFloatSlow(const char* s, const char* end)
+{
+    const std::string token(s, end);
+    if (token.empty() || isSpace(token[0])) return 0.0f;
+    char* stop = nullptr;
+    const float value = strtof(token.c_str(), &stop);
+    return stop == token.c_str() + token.size() ? value : 0.0f;
+}
+
+// The token [s, end) as Float(String) reads it: the correctly rounded value,
+// or 0 when it is not a number.
+//
+// Plain decimals with up to 19 significant digits and a power of ten within
+// 10^22 are converted in double precision, where mantissa and power are both
+// exact so the one operation rounds correctly. Rounding that result again to
+// float is only wrong when it fell exactly halfway between two floats; those,
+// and everything else (long mantissas, hex, inf, nan), go through strtof.
+static float parseFloat(const char* s, const char* end)
+{
+    const char* p = s;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int significant = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+    for (; p < end && isDigit(*p); ++p) {
+        if (significant == 19) return parseFloatSlow(s, end);
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa) significant++;
+        anyDigit = true;
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && isDigit(*p); ++p) {
+            if (significant == 19) return parseFloatSlow(s, end);
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa) significant++;
+            exponent--;
+            anyDigit = true;
+        }
+    }
+    if (!anyDigit) return parseFloatSlow(s, end);
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExp = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negativeExp = *p == '-';
+            ++p;
+        }
+        if (p == end || !isDigit(*p)) return parseFloatSlow(s, end);
+        int e = 0;
+        for (; p < end && isDigit(*p); ++p) {
+            if (e < 10000) e = e * 10 + (*p - '0');
+        }
+        exponent += negativeExp ? -e : e;
+    }
+    if (p != end) return parseFloatSlow(s, end);
+
+    if (mantissa == 0) return negative ? -0.0f : 0.0f;
+    if (exponent < -22 || exponent > 22 || (mantissa >> 53)) return parseFloatSlow(s, end);
+
+    double d = (double)mantissa;
+    d = exponent < 0 ? d / OBJ_POW10[-exponent] : d * OBJ_POW10[exponent];
+    if (d < FLT_MIN || d > FLT_MAX) return parseFloatSlow(s, end);
+
+    // Halfway between two floats: bit 28 of the double's mantissa set, the 28 below clear
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    if ((bits & 0x1fffffff) == 0x10000000) return parseFloatSlow(s, end);
+
+    const float f = (float)d;
+    return negative ? -f : f;
+}
+
+// The token [s, end) as Int32(String) reads it, 0 when it is not one
+static int32_t parseInt(const char* s, const char* end)
+{
+    const char* p = s;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+    if (p == end) return 0;
+
+    int64_t value = 0;
+    for (; p < end; ++p) {
+        if (!isDigit(*p)) return 0;
+        value = value * 10 + (*p - '0');
+        if (value > (int64_t)INT32_MAX + 1) return 0;
+    }
+    if (negative) value = -value;
+    if (value > INT32_MAX) return 0;
+    return (int32_t)value;
+}
+
+// ================================================
+//       Chunks
+// ================================================
+
+// A face as written: its corners' indices, and how many vertices were read
+// before it, which negative indices and the range check are relative to
+struct ObjFace
+{
+    size_t firstCorner;
+    int cornerCount;
+    int vertexCount;
+};
+
+struct ObjChunk
+{
+    const char* begin;
+    const char* end;
+    std::vector<float> vertices;
+    std::vector<int32_t> corners;
+    std::vector<ObjFace> faces;
+    std::vector<int32_t> triangles;
+    int vertexBase;         // Vertices in the chunks before this one
+    bool badFormat;
+};
+
+// Parse one line, without its line break
+static void parseLine(const char* p, const char* end, ObjChunk& chunk)
+{
+    while (p < end && *p == '\r') ++p;
+    while (end > p && end[-1] == '\r') --end;
+    if (p == end) return;
+
+    if (p[0] == 'v' && end - p > 1 && p[1] == ' ') {
+        // "v x y z": fields are separated by spaces only
+        float xyz[3] = { 0, 0, 0 };
+        int fields = 0;
+        p += 2;
+        while (p < end) {
+            while (p < end && *p == ' ') ++p;
+            if (p == end) break;
+            const char* start = p;
+            while (p < end && *p != ' ') ++p;
+            if (fields < 3) xyz[fields] = parseFloat(start, p);
+            fields++;
+        }
+        if (fields < 3) {
+            chunk.badFormat = true;
+            return;
+        }
+        chunk.vertices.insert(chunk.vertices.end(), xyz, xyz + 3);
+    }
+    else if (p[0] == 'f') {
+        // Skip the first field ("f"), then take each corner's vertex index up to its first '/'
+        while (p < end && !isSpace(*p)) ++p;
+        ObjFace face = { chunk.corners.size(), 0, (int)(chunk.vertices.size() / 3) };
+        while (p < end) {
+            while (p < end && isSpace(*p)) ++p;
+            if (p == end) break;
+            const char* start = p;
+            while (p < end && !isSpace(*p)) ++p;
+            const char* slash = (const char*)memchr(start, '/', p - start);
+            chunk.corners.push_back(parseInt(start, slash ? slash : p));
+            face.cornerCount++;
+        }
+        if (face.cornerCount > 2) {
+            chunk.faces.push_back(face);
+        } else {
+            chunk.corners.resize(face.firstCorner);
+        }
+    }
+}
+
+static void parseChunk(ObjChunk& chunk)
+{
+    const char* p = chunk.begin;
+    while (p < chunk.end && !chunk.badFormat) {
+        const char* lineEnd = (const char*)memchr(p, '\n', chunk.end - p);
+        if (!lineEnd) lineEnd = chunk.end;
+        parseLine(p, lineEnd, chunk);
+        p = lineEnd + 1;
+    }
+}
+
+// Fan the chunk's faces into triangles of zero-based, global vertex indices
+static void triangulateChunk(ObjChunk& chunk)
+{
+    for (const ObjFace& face : chunk.faces) {
+        const int64_t vertexCount = (int64_t)chunk.vertexBase + face.vertexCount;
+        const int32_t* corners = &chunk.corners[face.firstCorner];
+        int64_t idx[3];
+        for (int i = 0; i < face.cornerCount; ++i) {
+            int64_t v = corners[i];
+            if (v < 0) v += vertexCount + 1;
+            idx[i < 2 ? i : 2] = v - 1;
+            if (i < 2) continue;
+
+            if (idx[0] >= 0 && idx[0] < vertexCount &&
+                idx[1] >= 0 && idx[1] < vertexCount &&
+                idx[2] >= 0 && idx[2] < vertexCount) {
+                chunk.triangles.push_back((int32_t)idx[0]);
+                chunk.triangles.push_back((int32_t)idx[1]);
+                chunk.triangles.push_back((int32_t)idx[2]);
+            }
+            idx[1] = idx[2];
+        }
+    }
+    std::vector<int32_t>().swap(chunk.corners);
+    std::vector<ObjFace>().swap(chunk.faces);
+}
+
+// Run fn(chunk) for every chunk on up to numThreads threads
+template <typename Fn>
+static void forEachChunk(std::vector<ObjChunk>& chunks, int numThreads, Fn fn)
+{
+    const int threadCount = std::min(numThreads, (int)chunks.size());
+    if (threadCount <= 1) {
+        for (ObjChunk& chunk : chunks) fn(chunk);
+        return;
+    }
+    std::atomic<int> next(0);
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = next++; i < (int)chunks.size(); i = next++) {
+                fn(chunks[i]);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+}
+
+ObjParseResult objParseMesh(const char* text, size_t size, int numThreads, ObjMesh& mesh)
+{
+    memset(&mesh, 0, sizeof(mesh));
+    if (numThreads <= 0) {
+        numThreads = (int)std::thread::hardware_concurrency();
+        if (numThreads <= 0) numThreads = 1;
+    }
+
+    // A few chunks per thread so an uneven file still spreads out
+    const size_t maxChunks = std::max<size_t>(1, size / OBJ_MIN_CHUNK_SIZE);
+    const size_t chunkCount = std::min(maxChunks, (size_t)numThreads * 4);
+    std::vector<ObjChunk> chunks;
+    chunks.reserve(chunkCount);
+    const char* begin = text;
+    const char* end = text + size;
+    for (size_t i = 1; i <= chunkCount && begin < end; ++i) {
+        const char* chunkEnd = i == chunkCount ? end : text + size / chunkCount * i;
+        if (chunkEnd < begin) chunkEnd = begin;
+        const char* lineEnd = (const char*)memchr(chunkEnd, '\n', end - chunkEnd);
+        chunkEnd = lineEnd ? lineEnd + 1 : end;
+
+        ObjChunk chunk;
+        chunk.begin = begin;
+        chunk.end = chunkEnd;
+        chunk.vertexBase = 0;
+        chunk.badFormat = false;
+        chunks.push_back(std::move(chunk));
+        begin = chunkEnd;
+    }
+
+    try {
+        forEachChunk(chunks, numThreads, parseChunk);
+
+        size_t vertexCount = 0;
+        for (ObjChunk& chunk : chunks) {
+            if (chunk.badFormat) return OBJ_PARSE_BAD_FORMAT;
+            if (vertexCount / 3 > (size_t)INT32_MAX) return OBJ_PARSE_OUT_OF_MEMORY;
+            chunk.vertexBase = (int)(vertexCount / 3);
+            vertexCount += chunk.vertices.size();
+        }
+        forEachChunk(chunks, numThreads, triangulateChunk);
+
+        size_t indexCount = 0;
+        for (const ObjChunk& chunk : chunks) indexCount += chunk.triangles.size();
+        if (vertexCount / 3 > (size_t)INT32_MAX || indexCount / 3 > (size_t)INT32_MAX) {
+            return OBJ_PARSE_OUT_OF_MEMORY;
+        }
+
+        mesh.vertices = (float*)malloc(std::max<size_t>(1, vertexCount) * sizeof(float));
+        mesh.triangles = (int32_t*)malloc(std::max<size_t>(1, indexCount) * sizeof(int32_t));
+        if (!mesh.vertices || !mesh.triangles) {
+            free(mesh.vertices);
+            free(mesh.triangles);
+            memset(&mesh, 0, sizeof(mesh));
+            return OBJ_PARSE_OUT_OF_MEMORY;
+        }
+        float* v = mesh.vertices;
+        int32_t* t = mesh.triangles;
+        for (const ObjChunk& chunk : chunks) {
+            if (!chunk.vertices.empty()) memcpy(v, chunk.vertices.data(), chunk.vertices.size() * sizeof(float));
+            if (!chunk.triangles.empty()) memcpy(t, chunk.triangles.data(), chunk.triangles.size() * sizeof(int32_t));
+            v += chunk.vertices.size();
+            t += chunk.triangles.size();
+        }
+        mesh.vertexCount = (int)(vertexCount / 3);
+        mesh.triangleCount = (int)(indexCount / 3);
+    } catch (const std::bad_alloc&) {
+        return OBJ_PARSE_OUT_OF_MEMORY;
+    }
+    return OBJ_PARSE_OK;
+}
+
+// ================================================
+//       Geometry cache
+// ================================================
+
+bool objGeomCacheLoad(const char* cachePath, uint64_t sourceSize, int64_t sourceTime, ObjMesh& mesh)
+{
+    memset(&mesh, 0, sizeof(mesh));
+
+    FILE* fp = fopen(cachePath, "rb");
+    if (!fp) return false;
+
+    ObjGeomCacheFileHeader header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        header.magic != OBJ_GEOM_CACHE_MAGIC ||
+        header.version != OBJ_GEOM_CACHE_VERSION ||
+        header.sourceSize != sourceSize || header.sourceTime != sourceTime ||
+        header.vertexCount < 0 || header.triangleCount < 0) {
+        fclose(fp);
+        return false;
+    }
+
+    const size_t vertexBytes = (size_t)header.vertexCount * 3 * sizeof(float);
+    const size_t indexBytes = (size_t)header.triangleCount * 3 * sizeof(int32_t);
+    float* vertices = (float*)malloc(std::max<size_t>(1, vertexBytes));
+    int32_t* triangles = (int32_t*)malloc(std::max<size_t>(1, indexBytes));
+    bool complete = vertices && triangles &&
+                    fread(vertices, 1, vertexBytes, fp) == vertexBytes &&
+                    fread(triangles, 1, indexBytes, fp) == indexBytes;
+    // Nothing may follow, or the file is not the one this header was written with
+    complete = complete && fgetc(fp) == EOF;
+    fclose(fp);
+
+    for (size_t i = 0; complete && i < (size_t)header.triangleCount * 3; ++i) {
+        complete = triangles[i] >= 0 && triangles[i] < header.vertexCount;
+    }
+    if (!complete) {
+        free(vertices);
+        free(triangles);
+        return false;
+    }
+
+    mesh.vertices = vertices;
+    mesh.triangles = triangles;
+    mesh.vertexCount = header.vertexCount;
+    mesh.triangleCount = header.triangleCount;
+    return true;
+}
+
+void objGeomCacheStore(const char* cachePath, uint64_t sourceSize, int64_t sourceTime, const ObjMesh& mesh)
+{
+    if (!cachePath) return;
+
+    char tmpPath[1024];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.%d.tmp", cachePath, (int)getpid());
+
+    FILE* fp = fopen(tmpPath, "wb");
+    if (!fp) return;
+
+    ObjGeomCacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = OBJ_GEOM_CACHE_MAGIC;
+    header.version = OBJ_GEOM_CACHE_VERSION;
+    header.vertexCount = mesh.vertexCount;
+    header.triangleCount = mesh.triangleCount;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+
+    const size_t vertexCount = (size_t)mesh.vertexCount * 3;
+    const size_t indexCount = (size_t)mesh.triangleCount * 3;
+    const bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                    fwrite(mesh.vertices, sizeof(float), vertexCount, fp) == vertexCount &&
+                    fwrite(mesh.triangles, sizeof(int32_t), indexCount, fp) == indexCount;
+    if (fclose(fp) != 0 || !ok || rename(tmpPath, cachePath) != 0)
+        remove(tmpPath);
+}
@@ -0,0 +1,48 @@
+// ObjMeshParser.h
+// Parallel parser for the vertices and faces of Wavefront OBJ files
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef OBJMESHPARSER_H
+#define OBJMESHPARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Vertices and triangles of an OBJ file; both arrays are malloc'ed
+struct ObjMesh
+{
+    float* vertices;        // x, y, z per vertex
+    int32_t* triangles;     // Three vertex indices per triangle
+    int vertexCount;
+    int triangleCount;
+};
+
+enum ObjParseResult
+{
+    OBJ_PARSE_OK,
+    OBJ_PARSE_BAD_FORMAT,   // A "v" line with fewer than three coordinates
+    OBJ_PARSE_OUT_OF_MEMORY,
+};
+
+// Parse the "v" and "f" lines of OBJ text, split at line breaks into chunks
+// parsed on numThreads threads (0 = one per core).
+//
+// The result is the one OBJParser.parse gives in Swift: coordinates that are
+// not numbers read as 0, faces are fanned into triangles, negative indices
+// count back from the vertices read so far, and triangles with an index out
+// of that range are dropped. Numbers are parsed straight from the bytes and
+// rounded exactly like Float(String).
+ObjParseResult objParseMesh(const char* text, size_t size, int numThreads, ObjMesh& mesh);
+
+// Load the mesh stored for a source file of the given size and modification
+// time (in nanoseconds). Returns false when there is no such cache file, it
+// was written for another version of the source, or it is damaged.
+bool objGeomCacheLoad(const char* cachePath, uint64_t sourceSize, int64_t sourceTime, ObjMesh& mesh);
+
+// Store mesh for a source file of the given size and modification time. The
+// write goes through a temporary file and a rename; failures are ignored.
+void objGeomCacheStore(const char* cachePath, uint64_t sourceSize, int64_t sourceTime, const ObjMesh& mesh);
+
+#endif // OBJMESHPARSER_H
@@ -0,0 +1,309 @@
+// PackedHeightfield.cpp
+// Heightfield spans packed into flat per-column arrays, for filtering and compaction
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "PackedHeightfield.h"
+#include "RecastAlloc.h"
+
+#include <string.h>
+
+static const int MAX_HEIGHT = 0xffff;
+
+rcPackedHeightfield::rcPackedHeightfield()
+    : width(0), height(0), cs(0), ch(0), spanCount(0),
+      columnStart(nullptr), smin(nullptr), smax(nullptr), areas(nullptr)
+{
+    memset(bmin, 0, sizeof(bmin));
+    memset(bmax, 0, sizeof(bmax));
+}
+
+rcPackedHeightfield::~rcPackedHeightfield()
+{
+    rcFree(areas);
+    rcFree(smax);
+    rcFree(smin);
+    rcFree(columnStart);
+}
+
+// Ceiling of span i in the column ending at end
+static inline int spanTop(const rcPackedHeightfield& hf, int i, int end)
+{
+    return i + 1 < end ? (int)hf.smin[i + 1] : MAX_HEIGHT;
+}
+
+bool rcPackHeightfield(rcContext* ctx, const rcHeightfield& hf, rcPackedHeightfield& packed)
+{
+    rcScopedTimer timer(ctx, RC_TIMER_BUILD_COMPACTHEIGHTFIELD);
+
+    rcFree(packed.areas);
+    rcFree(packed.smax);
+    rcFree(packed.smin);
+    rcFree(packed.columnStart);
+    packed.areas = nullptr;
+    packed.smax = nullptr;
+    packed.smin = nullptr;
+    packed.columnStart = nullptr;
+    packed.spanCount = 0;
+
+    const int numColumns = hf.width * hf.height;
+    packed.width = hf.width;
+    packed.height = hf.height;
+    rcVcopy(packed.bmin, hf.bmin);
+    rcVcopy(packed.bmax, hf.bmax);
+    packed.cs = hf.cs;
+    packed.ch = hf.ch;
+
+    packed.columnStart = (int*)rcAlloc(sizeof(int) * (numColumns + 1), RC_ALLOC_PERM);
+    if (!packed.columnStart) {
+        ctx->log(RC_LOG_ERROR, "rcPackHeightfield: Out of memory 'columnStart' (%d)", numColumns + 1);
+        return false;
+    }
+
+    int spanCount = 0;
+    for (int c = 0; c < numColumns; ++c) {
+        packed.columnStart[c] = spanCount;
+        for (const rcSpan* s = hf.spans[c]; s; s = s->next)
+            ++spanCount;
+    }
+    packed.columnStart[numColumns] = spanCount;
+
+    const int allocCount = rcMax(spanCount, 1);
+    packed.smin = (unsigned short*)rcAlloc(sizeof(unsigned short) * allocCount, RC_ALLOC_PERM);
+    packed.smax = (unsigned short*)rcAlloc(sizeof(unsigned short) * allocCount, RC_ALLOC_PERM);
+    packed.areas = (unsigned char*)rcAlloc(sizeof(unsigned char) * allocCount, RC_ALLOC_PERM);
+    if (!packed.smin || !packed.smax || !packed.areas) {
+        ctx->log(RC_LOG_ERROR, "rcPackHeightfield: Out of memory 'spans' (%d)", spanCount);
+        return false;
+    }
+    packed.spanCount = spanCount;
+
+    int n = 0;
+    for (int c = 0; c < numColumns; ++c) {
+        for (const rcSpan* s = hf.spans[c]; s; s = s->next, ++n) {
+            packed.smin[n] = (unsigned short)s->smin;
+            packed.smax[n] = (unsigned short)s->smax;
+            packed.areas[n] = (unsigned char)s->area;
+        }
+    }
+
+    return true;
+}
+
+void rcFilterLowHangingWalkableObstacles(rcContext* ctx, int walkableClimb, rcPackedHeightfield& hf)
+{
+    rcScopedTimer timer(ctx, RC_TIMER_FILTER_LOW_OBSTACLES);
+
+    const int numColumns = hf.width * hf.height;
+    for (int c = 0; c < numColumns; ++c) {
+        bool previousWasWalkable = false;
+        unsigned char previousArea = RC_NULL_AREA;
+
+        for (int i = hf.columnStart[c], end = hf.columnStart[c + 1]; i < end; ++i) {
+            const bool walkable = hf.areas[i] != RC_NULL_AREA;
+            // A non-walkable span just above a walkable one becomes walkable
+            // if it can be stepped onto; only one span up, never a chain.
+            if (!walkable && previousWasWalkable &&
+                rcAbs((int)hf.smax[i] - (int)hf.smax[i - 1]) <= walkableClimb) {
+                hf.areas[i] = previousArea;
+            }
+            previousWasWalkable = walkable;
+            previousArea = hf.areas[i];
+        }
+    }
+}
+
+void rcFilterLedgeSpans(rcContext* ctx, int walkableHeight, int walkableClimb, rcPackedHeightfield& hf)
+{
+    rcScopedTimer timer(ctx, RC_TIMER_FILTER_BORDER);
+
+    const int w = hf.width;
+    const int h = hf.height;
+
+    for (int z = 0; z < h; ++z) {
+        for (int x = 0; x < w; ++x) {
+            const int c = x + z * w;
+            for (int i = hf.columnStart[c], end = hf.columnStart[c + 1]; i < end; ++i) {
+                if (hf.areas[i] == RC_NULL_AREA) continue;
+
+                const int bot = (int)hf.smax[i];
+                const int top = spanTop(hf, i, end);
+
+                // Lowest neighbour floor, and the range of neighbour floors
+                // within climbing distance.
+                int minNeighborHeight = MAX_HEIGHT;
+                int accessibleMin = bot;
+                int accessibleMax = bot;
+
+                for (int dir = 0; dir < 4; ++dir) {
+                    const int nx = x + rcGetDirOffsetX(dir);
+                    const int nz = z + rcGetDirOffsetY(dir);
+                    if (nx < 0 || nz < 0 || nx >= w || nz >= h) {
+                        minNeighborHeight = rcMin(minNeighborHeight, -walkableClimb - bot);
+                        continue;
+                    }
+
+                    const int nc = nx + nz * w;
+                    const int nstart = hf.columnStart[nc];
+                    const int nend = hf.columnStart[nc + 1];
+
+                    // From minus infinity to the first span
+                    int neighborBot = -walkableClimb;
+                    int neighborTop = nstart < nend ? (int)hf.smin[nstart] : MAX_HEIGHT;
+                    if (rcMin(top, neighborTop) - rcMax(bot, neighborBot) > walkableHeight)
+                        minNeighborHeight = rcMin(minNeighborHeight, neighborBot - bot);
+
+                    for (int k = nstart; k < nend; ++k) {
+                        neighborBot = (int)hf.smax[k];
+                        neighborTop = spanTop(hf, k, nend);
+                        if (rcMin(top, neighborTop) - rcMax(bot, neighborBot) <= walkableHeight)
+                            continue;
+
+                        minNeighborHeight = rcMin(minNeighborHeight, neighborBot - bot);
+                        if (rcAbs(neighborBot - bot) <= walkableClimb) {
+                            if (neighborBot < accessibleMin) accessibleMin = neighborBot;
+                            if (neighborBot > accessibleMax) accessibleMax = neighborBot;
+                        }
+                    }
+                }
+
+                // Next to a drop, or on a slope too steep between neighbours
+                if (minNeighborHeight < -walkableClimb || accessibleMax - accessibleMin > walkableClimb)
+                    hf.areas[i] = RC_NULL_AREA;
+            }
+        }
+    }
+}
+
+void rcFilterWalkableLowHeightSpans(rcContext* ctx, int walkableHeight, rcPackedHeightfield& hf)
+{
+    rcScopedTimer timer(ctx, RC_TIMER_FILTER_WALKABLE);
+
+    const int numColumns = hf.width * hf.height;
+    for (int c = 0; c < numColumns; ++c) {
+        for (int i = hf.columnStart[c], end = hf.columnStart[c + 1]; i < end; ++i) {
+            if (spanTop(hf, i, end) - (int)hf.smax[i] < walkableHeight)
+                hf.areas[i] = RC_NULL_AREA;
+        }
+    }
+}
+
+int rcGetHeightFieldSpanCount(rcContext* ctx, const rcPackedHeightfield& hf)
+{
+    rcIgnoreUnused(ctx);
+
+    int count = 0;
+    for (int i = 0; i < hf.spanCount; ++i)
+        count += hf.areas[i] != RC_NULL_AREA;
+    return count;
+}
+
+bool rcBuildCompactHeightfield(rcContext* ctx, int walkableHeight, int walkableClimb,
+                               const rcPackedHeightfield& hf, rcCompactHeightfield& chf)
+{
+    rcScopedTimer timer(ctx, RC_TIMER_BUILD_COMPACTHEIGHTFIELD);
+
+    const int w = hf.width;
+    const int h = hf.height;
+    const int spanCount = rcGetHeightFieldSpanCount(ctx, hf);
+
+    chf.width = w;
+    chf.height = h;
+    chf.spanCount = spanCount;
+    chf.walkableHeight = walkableHeight;
+    chf.walkableClimb = walkableClimb;
+    chf.maxRegions = 0;
+    rcVcopy(chf.bmin, hf.bmin);
+    rcVcopy(chf.bmax, hf.bmax);
+    chf.bmax[1] += walkableHeight * hf.ch;
+    chf.cs = hf.cs;
+    chf.ch = hf.ch;
+    chf.cells = (rcCompactCell*)rcAlloc(sizeof(rcCompactCell) * w * h, RC_ALLOC_PERM);
+    if (!chf.cells) {
+        ctx->log(RC_LOG_ERROR, "rcBuildCompactHeightfield: Out of memory 'chf.cells' (%d)", w * h);
+        return false;
+    }
+    memset(chf.cells, 0, sizeof(rcCompactCell) * w * h);
+    chf.spans = (rcCompactSpan*)rcAlloc(sizeof(rcCompactSpan) * spanCount, RC_ALLOC_PERM);
+    if (!chf.spans) {
+        ctx->log(RC_LOG_ERROR, "rcBuildCompactHeightfield: Out of memory 'chf.spans' (%d)", spanCount);
+        return false;
+    }
+    memset(chf.spans, 0, sizeof(rcCompactSpan) * spanCount);
+    chf.areas = (unsigned char*)rcAlloc(sizeof(unsigned char) * spanCount, RC_ALLOC_PERM);
+    if (!chf.areas) {
+        ctx->log(RC_LOG_ERROR, "rcBuildCompactHeightfield: Out of memory 'chf.areas' (%d)", spanCount);
+        return false;
+    }
+    memset(chf.areas, RC_NULL_AREA, sizeof(unsigned char) * spanCount);
+
+    // Cells and spans. Empty columns keep index 0 and count 0.
+    int current = 0;
+    for (int c = 0; c < w * h; ++c) {
+        const int start = hf.columnStart[c];
+        const int end = hf.columnStart[c + 1];
+        if (start == end) continue;
+
+        rcCompactCell& cell = chf.cells[c];
+        cell.index = current;
+        cell.count = 0;
+
+        for (int i = start; i < end; ++i) {
+            if (hf.areas[i] == RC_NULL_AREA) continue;
+
+            const int bot = (int)hf.smax[i];
+            const int top = spanTop(hf, i, end);
+            chf.spans[current].y = (unsigned short)rcClamp(bot, 0, 0xffff);
+            chf.spans[current].h = (unsigned char)rcClamp(top - bot, 0, 0xff);
+            chf.areas[current] = hf.areas[i];
+            ++current;
+            ++cell.count;
+        }
+    }
+
+    // Neighbour connections, as in Recast
+    const int MAX_LAYERS = RC_NOT_CONNECTED - 1;
+    int maxLayerIndex = 0;
+    for (int z = 0; z < h; ++z) {
+        for (int x = 0; x < w; ++x) {
+            const rcCompactCell& cell = chf.cells[x + z * w];
+            for (int i = (int)cell.index, ni = (int)(cell.index + cell.count); i < ni; ++i) {
+                rcCompactSpan& span = chf.spans[i];
+
+                for (int dir = 0; dir < 4; ++dir) {
+                    rcSetCon(span, dir, RC_NOT_CONNECTED);
+                    const int nx = x + rcGetDirOffsetX(dir);
+                    const int nz = z + rcGetDirOffsetY(dir);
+                    if (nx < 0 || nz < 0 || nx >= w || nz >= h) continue;
+
+                    const rcCompactCell& neighborCell = chf.cells[nx + nz * w];
+                    for (int k = (int)neighborCell.index, nk = (int)(neighborCell.index + neighborCell.count); k < nk; ++k) {
+                        const rcCompactSpan& neighborSpan = chf.spans[k];
+                        const int bot = rcMax(span.y, neighborSpan.y);
+                        const int top = rcMin(span.y + span.h, neighborSpan.y + neighborSpan.h);
+                        if ((top - bot) < walkableHeight ||
+                            rcAbs((int)neighborSpan.y - (int)span.y) > walkableClimb) {
+                            continue;
+                        }
+
+                        const int layerIndex = k - (int)neighborCell.index;
+                        if (layerIndex < 0 || layerIndex > MAX_LAYERS) {
+                            maxLayerIndex = rcMax(maxLayerIndex, layerIndex);
+                            continue;
+                        }
+                        rcSetCon(span, dir, layerIndex);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    if (maxLayerIndex > MAX_LAYERS) {
+        ctx->log(RC_LOG_ERROR, "rcBuildCompactHeightfield: Heightfield has too many layers %d (max: %d)",
+                 maxLayerIndex, MAX_LAYERS);
+    }
+
+    return true;
+}
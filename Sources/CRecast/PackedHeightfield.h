@@ -0,0 +1,63 @@
+// PackedHeightfield.h
+// Heightfield spans packed into flat per-column arrays, for filtering and compaction
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef PACKEDHEIGHTFIELD_H
+#define PACKEDHEIGHTFIELD_H
+
+#include "Recast.h"
+
+// A rasterized heightfield with its spans laid out column by column in
+// structure-of-arrays form.
+//
+// rcHeightfield keeps every column as a linked list of pool-allocated spans,
+// which rasterization needs for merging, but the filter and compaction passes
+// then chase pointers in an order unrelated to memory. Packing once after
+// rasterization lets those passes stream through flat arrays: column c holds
+// spans [columnStart[c], columnStart[c + 1]) in ascending height, and a span's
+// ceiling is the floor of the next span in its column.
+//
+// Arrays come from rcAlloc, so a tile build serves them from its arena.
+struct rcPackedHeightfield
+{
+    rcPackedHeightfield();
+    ~rcPackedHeightfield();
+
+    int width;
+    int height;
+    float bmin[3];
+    float bmax[3];
+    float cs;
+    float ch;
+    int spanCount;
+
+    int* columnStart;       // width * height + 1 entries
+    unsigned short* smin;   // Span floors...
+    unsigned short* smax;   // ...and tops, in cell units
+    unsigned char* areas;   // Area id per span
+
+private:
+    // Explicitly-disabled copy constructor and copy assignment operator.
+    rcPackedHeightfield(const rcPackedHeightfield&);
+    rcPackedHeightfield& operator=(const rcPackedHeightfield&);
+};
+
+// Copy the spans of hf into packed, replacing what it held.
+// Returns false if memory could not be allocated.
+bool rcPackHeightfield(rcContext* ctx, const rcHeightfield& hf, rcPackedHeightfield& packed);
+
+// The rcFilter* passes on a packed heightfield; the results are identical.
+void rcFilterLowHangingWalkableObstacles(rcContext* ctx, int walkableClimb, rcPackedHeightfield& hf);
+void rcFilterLedgeSpans(rcContext* ctx, int walkableHeight, int walkableClimb, rcPackedHeightfield& hf);
+void rcFilterWalkableLowHeightSpans(rcContext* ctx, int walkableHeight, rcPackedHeightfield& hf);
+
+// Number of spans that are not RC_NULL_AREA
+int rcGetHeightFieldSpanCount(rcContext* ctx, const rcPackedHeightfield& hf);
+
+// rcBuildCompactHeightfield from a packed heightfield, with identical output
+bool rcBuildCompactHeightfield(rcContext* ctx, int walkableHeight, int walkableClimb,
+                               const rcPackedHeightfield& hf, rcCompactHeightfield& chf);
+
+#endif // PACKEDHEIGHTFIELD_H
@@ -17,6 +17,7 @@
 //
 
 #include "RecastAlloc.h"
+#include "DetourMemory.h"
 
 static void* rcAllocDefault(size_t size, rcAllocHint)
 {
@@ -37,15 +38,27 @@ void rcAllocSetCustom(rcAllocFunc* allocFunc, rcFreeFunc* freeFunc)
 	sRecastFreeFunc = freeFunc ? freeFunc : rcFreeDefault;
 }
 
+void rcAllocGetCustom(rcAllocFunc** allocFunc, rcFreeFunc** freeFunc)
+{
+	if (allocFunc)
+		*allocFunc = sRecastAllocFunc;
+	if (freeFunc)
+		*freeFunc = sRecastFreeFunc;
+}
+
 void* rcAlloc(size_t size, rcAllocHint hint)
 {
-	return sRecastAllocFunc(size, hint);
+	void* ptr = sRecastAllocFunc(size, hint);
+	// Recast shares the accounting of Detour, which this library is built with.
+	dtMemoryTrackAlloc(ptr, size, hint == RC_ALLOC_TEMP ? DT_MEMORY_RECAST_TEMP : DT_MEMORY_RECAST_PERM);
+	return ptr;
 }
 
 void rcFree(void* ptr)
 {
 	if (ptr != NULL)
 	{
+		dtMemoryTrackFree(ptr);
 		sRecastFreeFunc(ptr);
 	}
 }
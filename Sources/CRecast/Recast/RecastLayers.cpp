@@ -104,6 +104,13 @@ struct rcLayerSweepSpan
 bool rcBuildHeightfieldLayers(rcContext* ctx, const rcCompactHeightfield& chf,
 							  const int borderSize, const int walkableHeight,
 							  rcHeightfieldLayerSet& lset)
+{
+	return rcBuildHeightfieldLayers(ctx, chf, borderSize, walkableHeight, lset, 0);
+}
+
+bool rcBuildHeightfieldLayers(rcContext* ctx, const rcCompactHeightfield& chf,
+							  const int borderSize, const int walkableHeight,
+							  rcHeightfieldLayerSet& lset, unsigned char* spanLayers)
 {
 	rcAssert(ctx);
 	
@@ -487,6 +494,12 @@ bool rcBuildHeightfieldLayers(rcContext* ctx, const rcCompactHeightfield& chf,
 	for (int i = 0; i < nregs; ++i)
 		regs[i].layerId = remap[regs[i].layerId];
 	
+	if (spanLayers)
+	{
+		for (int i = 0; i < chf.spanCount; ++i)
+			spanLayers[i] = srcReg[i] != 0xff ? regs[srcReg[i]].layerId : 0xff;
+	}
+	
 	// No layers, return empty.
 	if (layerId == 0)
 		return true;
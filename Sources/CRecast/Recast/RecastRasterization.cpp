@@ -21,6 +21,17 @@
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
 
+// Vectorized triangle setup for rcRasterizeTriangles, selected at compile time.
+// Define RC_DISABLE_SIMD to always use the scalar reference path, and
+// RC_RASTERIZATION_VALIDATE to check every vectorized span against it.
+#if !defined(RC_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#	include <emmintrin.h>
+#	define RC_RASTER_SSE2 1
+#elif !defined(RC_DISABLE_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#	include <arm_neon.h>
+#	define RC_RASTER_NEON 1
+#endif
+
 /// Check whether two bounding boxes overlap
 ///
 /// @param[in]	aMin	Min axis extents of bounding box A
@@ -287,27 +298,41 @@ static void dividePoly(const float* inVerts, int inVertsCount,
 	*outVerts2Count = poly2Vert;
 }
 
-///	Rasterize a single triangle to the heightfield.
+/// Receives the spans of a rasterized triangle by adding them to the heightfield.
+struct rcAddSpanSink
+{
+	rcHeightfield& heightfield;
+	unsigned char areaID;
+	int flagMergeThreshold;
+
+	bool operator()(const int x, const int z, const unsigned short spanMin, const unsigned short spanMax)
+	{
+		return addSpan(heightfield, x, z, spanMin, spanMax, areaID, flagMergeThreshold);
+	}
+};
+
+///	Clip a single triangle against the heightfield grid and hand its spans to a sink.
+///	This is the reference rasterizer; the vectorized path must produce exactly its spans.
 ///
 ///	This code is extremely hot, so much care should be given to maintaining maximum perf here.
 /// 
 /// @param[in] 	v0					Triangle vertex 0
 /// @param[in] 	v1					Triangle vertex 1
 /// @param[in] 	v2					Triangle vertex 2
-/// @param[in] 	areaID				The area ID to assign to the rasterized spans
 /// @param[in] 	heightfield			Heightfield to rasterize into
 /// @param[in] 	heightfieldBBMin	The min extents of the heightfield bounding box
 /// @param[in] 	heightfieldBBMax	The max extents of the heightfield bounding box
 /// @param[in] 	cellSize			The x and z axis size of a voxel in the heightfield
 /// @param[in] 	inverseCellSize		1 / cellSize
 /// @param[in] 	inverseCellHeight	1 / cellHeight
-/// @param[in] 	flagMergeThreshold	The threshold in which area flags will be merged 
-/// @returns true if the operation completes successfully.  false if there was an error adding spans to the heightfield.
-static bool rasterizeTri(const float* v0, const float* v1, const float* v2,
-                         const unsigned char areaID, rcHeightfield& heightfield,
-                         const float* heightfieldBBMin, const float* heightfieldBBMax,
-                         const float cellSize, const float inverseCellSize, const float inverseCellHeight,
-                         const int flagMergeThreshold)
+/// @param[in] 	addSpanToSink		Called with (x, z, spanMin, spanMax) for every span; returns false on error
+/// @returns true if the operation completes successfully.  false if the sink failed.
+template <class SpanSink>
+static bool rasterizeTriSpans(const float* v0, const float* v1, const float* v2,
+                              const rcHeightfield& heightfield,
+                              const float* heightfieldBBMin, const float* heightfieldBBMax,
+                              const float cellSize, const float inverseCellSize, const float inverseCellHeight,
+                              SpanSink& addSpanToSink)
 {
 	// Calculate the bounding box of the triangle.
 	float triBBMin[3];
@@ -444,7 +469,7 @@ static bool rasterizeTri(const float* v0, const float* v1, const float* v2,
 			unsigned short spanMinCellIndex = (unsigned short)rcClamp((int)floorf(spanMin * inverseCellHeight), 0, RC_SPAN_MAX_HEIGHT);
 			unsigned short spanMaxCellIndex = (unsigned short)rcClamp((int)ceilf(spanMax * inverseCellHeight), (int)spanMinCellIndex + 1, RC_SPAN_MAX_HEIGHT);
 
-			if (!addSpan(heightfield, x, z, spanMinCellIndex, spanMaxCellIndex, areaID, flagMergeThreshold))
+			if (!addSpanToSink(x, z, spanMinCellIndex, spanMaxCellIndex))
 			{
 				return false;
 			}
@@ -454,6 +479,325 @@ static bool rasterizeTri(const float* v0, const float* v1, const float* v2,
 	return true;
 }
 
+///	Rasterize a single triangle to the heightfield.
+///
+/// @param[in] 	v0					Triangle vertex 0
+/// @param[in] 	v1					Triangle vertex 1
+/// @param[in] 	v2					Triangle vertex 2
+/// @param[in] 	areaID				The area ID to assign to the rasterized spans
+/// @param[in] 	heightfield			Heightfield to rasterize into
+/// @param[in] 	heightfieldBBMin	The min extents of the heightfield bounding box
+/// @param[in] 	heightfieldBBMax	The max extents of the heightfield bounding box
+/// @param[in] 	cellSize			The x and z axis size of a voxel in the heightfield
+/// @param[in] 	inverseCellSize		1 / cellSize
+/// @param[in] 	inverseCellHeight	1 / cellHeight
+/// @param[in] 	flagMergeThreshold	The threshold in which area flags will be merged 
+/// @returns true if the operation completes successfully.  false if there was an error adding spans to the heightfield.
+static bool rasterizeTri(const float* v0, const float* v1, const float* v2,
+                         const unsigned char areaID, rcHeightfield& heightfield,
+                         const float* heightfieldBBMin, const float* heightfieldBBMax,
+                         const float cellSize, const float inverseCellSize, const float inverseCellHeight,
+                         const int flagMergeThreshold)
+{
+	rcAddSpanSink sink = { heightfield, areaID, flagMergeThreshold };
+	return rasterizeTriSpans(v0, v1, v2, heightfield, heightfieldBBMin, heightfieldBBMax,
+	                         cellSize, inverseCellSize, inverseCellHeight, sink);
+}
+
+#if defined(RC_RASTER_SSE2) || defined(RC_RASTER_NEON)
+
+/// Number of triangles set up together by the vectorized path.
+static const int RC_RASTER_BATCH = 4;
+
+/// Cell footprint of a batch of triangles, one lane per triangle.
+struct rcTriBatchFootprint
+{
+	int overlaps[RC_RASTER_BATCH];	///< Non-zero if the triangle's bounds touch the heightfield's
+	int x0[RC_RASTER_BATCH];		///< Cell column of the triangle's min x, not clamped
+	int x1[RC_RASTER_BATCH];		///< Cell column of the triangle's max x, not clamped
+	int z0[RC_RASTER_BATCH];		///< Cell row of the triangle's min z, not clamped
+	int z1[RC_RASTER_BATCH];		///< Cell row of the triangle's max z, not clamped
+	float minY[RC_RASTER_BATCH];	///< Lowest vertex of the triangle
+	float maxY[RC_RASTER_BATCH];	///< Highest vertex of the triangle
+};
+
+/// Computes bounds, heightfield overlap and cell footprint of four triangles at once.
+/// The arithmetic matches the scalar rasterizer operation for operation, so the results are bit-identical.
+///
+/// @param[in]	tx, ty, tz			Vertex coordinates, [vertex * RC_RASTER_BATCH + lane]
+/// @param[in]	heightfieldBBMin	The min extents of the heightfield bounding box
+/// @param[in]	heightfieldBBMax	The max extents of the heightfield bounding box
+/// @param[in]	inverseCellSize		1 / cellSize
+/// @param[out]	footprint			Per-triangle results
+static void setupTriBatch(const float* tx, const float* ty, const float* tz,
+                          const float* heightfieldBBMin, const float* heightfieldBBMax,
+                          const float inverseCellSize, rcTriBatchFootprint& footprint)
+{
+#if defined(RC_RASTER_SSE2)
+	const __m128 x0 = _mm_loadu_ps(tx), x1 = _mm_loadu_ps(tx + 4), x2 = _mm_loadu_ps(tx + 8);
+	const __m128 y0 = _mm_loadu_ps(ty), y1 = _mm_loadu_ps(ty + 4), y2 = _mm_loadu_ps(ty + 8);
+	const __m128 z0 = _mm_loadu_ps(tz), z1 = _mm_loadu_ps(tz + 4), z2 = _mm_loadu_ps(tz + 8);
+
+	const __m128 minX = _mm_min_ps(_mm_min_ps(x0, x1), x2);
+	const __m128 maxX = _mm_max_ps(_mm_max_ps(x0, x1), x2);
+	const __m128 minY = _mm_min_ps(_mm_min_ps(y0, y1), y2);
+	const __m128 maxY = _mm_max_ps(_mm_max_ps(y0, y1), y2);
+	const __m128 minZ = _mm_min_ps(_mm_min_ps(z0, z1), z2);
+	const __m128 maxZ = _mm_max_ps(_mm_max_ps(z0, z1), z2);
+
+	const __m128 bminX = _mm_set1_ps(heightfieldBBMin[0]);
+	const __m128 bminY = _mm_set1_ps(heightfieldBBMin[1]);
+	const __m128 bminZ = _mm_set1_ps(heightfieldBBMin[2]);
+	__m128 overlaps = _mm_and_ps(_mm_cmple_ps(minX, _mm_set1_ps(heightfieldBBMax[0])), _mm_cmpge_ps(maxX, bminX));
+	overlaps = _mm_and_ps(overlaps, _mm_and_ps(_mm_cmple_ps(minY, _mm_set1_ps(heightfieldBBMax[1])), _mm_cmpge_ps(maxY, bminY)));
+	overlaps = _mm_and_ps(overlaps, _mm_and_ps(_mm_cmple_ps(minZ, _mm_set1_ps(heightfieldBBMax[2])), _mm_cmpge_ps(maxZ, bminZ)));
+
+	const __m128 ics = _mm_set1_ps(inverseCellSize);
+	_mm_storeu_si128((__m128i*)footprint.overlaps, _mm_castps_si128(overlaps));
+	_mm_storeu_si128((__m128i*)footprint.x0, _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(minX, bminX), ics)));
+	_mm_storeu_si128((__m128i*)footprint.x1, _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(maxX, bminX), ics)));
+	_mm_storeu_si128((__m128i*)footprint.z0, _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(minZ, bminZ), ics)));
+	_mm_storeu_si128((__m128i*)footprint.z1, _mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(maxZ, bminZ), ics)));
+	_mm_storeu_ps(footprint.minY, minY);
+	_mm_storeu_ps(footprint.maxY, maxY);
+#else
+	const float32x4_t x0 = vld1q_f32(tx), x1 = vld1q_f32(tx + 4), x2 = vld1q_f32(tx + 8);
+	const float32x4_t y0 = vld1q_f32(ty), y1 = vld1q_f32(ty + 4), y2 = vld1q_f32(ty + 8);
+	const float32x4_t z0 = vld1q_f32(tz), z1 = vld1q_f32(tz + 4), z2 = vld1q_f32(tz + 8);
+
+	const float32x4_t minX = vminq_f32(vminq_f32(x0, x1), x2);
+	const float32x4_t maxX = vmaxq_f32(vmaxq_f32(x0, x1), x2);
+	const float32x4_t minY = vminq_f32(vminq_f32(y0, y1), y2);
+	const float32x4_t maxY = vmaxq_f32(vmaxq_f32(y0, y1), y2);
+	const float32x4_t minZ = vminq_f32(vminq_f32(z0, z1), z2);
+	const float32x4_t maxZ = vmaxq_f32(vmaxq_f32(z0, z1), z2);
+
+	const float32x4_t bminX = vdupq_n_f32(heightfieldBBMin[0]);
+	const float32x4_t bminY = vdupq_n_f32(heightfieldBBMin[1]);
+	const float32x4_t bminZ = vdupq_n_f32(heightfieldBBMin[2]);
+	uint32x4_t overlaps = vandq_u32(vcleq_f32(minX, vdupq_n_f32(heightfieldBBMax[0])), vcgeq_f32(maxX, bminX));
+	overlaps = vandq_u32(overlaps, vandq_u32(vcleq_f32(minY, vdupq_n_f32(heightfieldBBMax[1])), vcgeq_f32(maxY, bminY)));
+	overlaps = vandq_u32(overlaps, vandq_u32(vcleq_f32(minZ, vdupq_n_f32(heightfieldBBMax[2])), vcgeq_f32(maxZ, bminZ)));
+
+	const float32x4_t ics = vdupq_n_f32(inverseCellSize);
+	vst1q_s32(footprint.overlaps, vreinterpretq_s32_u32(overlaps));
+	vst1q_s32(footprint.x0, vcvtq_s32_f32(vmulq_f32(vsubq_f32(minX, bminX), ics)));
+	vst1q_s32(footprint.x1, vcvtq_s32_f32(vmulq_f32(vsubq_f32(maxX, bminX), ics)));
+	vst1q_s32(footprint.z0, vcvtq_s32_f32(vmulq_f32(vsubq_f32(minZ, bminZ), ics)));
+	vst1q_s32(footprint.z1, vcvtq_s32_f32(vmulq_f32(vsubq_f32(maxZ, bminZ), ics)));
+	vst1q_f32(footprint.minY, minY);
+	vst1q_f32(footprint.maxY, maxY);
+#endif
+}
+
+/// Span of a triangle that lies inside a single heightfield cell, computed from its footprint.
+/// Inside one cell the scalar rasterizer's clipping returns the triangle unchanged, so its span
+/// is just the vertical extent of the three vertices.
+///
+/// @returns 1 if the span was produced, 0 if the triangle produces no span, -1 if the triangle
+/// is not known to fit in one cell and has to go through the scalar rasterizer.
+static int singleCellSpan(const float* v0, const float* v1, const float* v2,
+                          const rcTriBatchFootprint& footprint, const int lane,
+                          const rcHeightfield& heightfield,
+                          const float* heightfieldBBMin, const float* heightfieldBBMax,
+                          const float cellSize, const float inverseCellHeight,
+                          int& x, int& z, unsigned short& spanMinCellIndex, unsigned short& spanMaxCellIndex)
+{
+	if (!footprint.overlaps[lane])
+	{
+		return 0;
+	}
+
+	x = footprint.x0[lane];
+	z = footprint.z0[lane];
+	if (x != footprint.x1[lane] || z != footprint.z1[lane] ||
+		x < 0 || z < 0 || x >= heightfield.width || z >= heightfield.height)
+	{
+		return -1;
+	}
+
+	// The scalar path cuts the row and then the column at their far edge. The
+	// triangle passes both cuts unchanged only if every vertex lies strictly
+	// before them; the edges are computed the same way the scalar path does.
+	const float cellZ = heightfieldBBMin[2] + (float)z * cellSize;
+	const float rowEnd = cellZ + cellSize;
+	const float cx = heightfieldBBMin[0] + (float)x * cellSize;
+	const float columnEnd = cx + cellSize;
+	if (!(v0[2] < rowEnd && v1[2] < rowEnd && v2[2] < rowEnd &&
+		  v0[0] < columnEnd && v1[0] < columnEnd && v2[0] < columnEnd))
+	{
+		return -1;
+	}
+
+	const float by = heightfieldBBMax[1] - heightfieldBBMin[1];
+	float spanMin = footprint.minY[lane] - heightfieldBBMin[1];
+	float spanMax = footprint.maxY[lane] - heightfieldBBMin[1];
+	if (spanMax < 0.0f || spanMin > by)
+	{
+		return 0;
+	}
+	if (spanMin < 0.0f)
+	{
+		spanMin = 0;
+	}
+	if (spanMax > by)
+	{
+		spanMax = by;
+	}
+
+	spanMinCellIndex = (unsigned short)rcClamp((int)floorf(spanMin * inverseCellHeight), 0, RC_SPAN_MAX_HEIGHT);
+	spanMaxCellIndex = (unsigned short)rcClamp((int)ceilf(spanMax * inverseCellHeight), (int)spanMinCellIndex + 1, RC_SPAN_MAX_HEIGHT);
+	return 1;
+}
+
+#if defined(RC_RASTERIZATION_VALIDATE)
+/// Collects the spans the scalar rasterizer produces for one triangle.
+struct rcCollectSpanSink
+{
+	int count;
+	int x, z;
+	unsigned short spanMin, spanMax;
+
+	bool operator()(const int sx, const int sz, const unsigned short smin, const unsigned short smax)
+	{
+		if (count++ == 0)
+		{
+			x = sx;
+			z = sz;
+			spanMin = smin;
+			spanMax = smax;
+		}
+		return true;
+	}
+};
+#endif
+
+#endif // RC_RASTER_SSE2 || RC_RASTER_NEON
+
+/// Rasterizes a list of triangles. getTriangle(i, v0, v1, v2) returns the vertices of triangle i.
+///
+/// With SIMD available, triangles are set up four at a time. Triangles that fall inside a single
+/// cell, the common case for dense meshes, get their span directly; the others go through the
+/// scalar rasterizer. Spans are added in triangle order either way, so the heightfield is identical
+/// to the one the scalar path builds.
+template <class TriangleFetch>
+static bool rasterizeTriangleList(rcContext* context, const TriangleFetch& getTriangle,
+                                  const unsigned char* triAreaIDs, const int numTris,
+                                  rcHeightfield& heightfield, const int flagMergeThreshold)
+{
+	const float inverseCellSize = 1.0f / heightfield.cs;
+	const float inverseCellHeight = 1.0f / heightfield.ch;
+	int triIndex = 0;
+
+#if defined(RC_RASTER_SSE2) || defined(RC_RASTER_NEON)
+	for (; triIndex + RC_RASTER_BATCH <= numTris; triIndex += RC_RASTER_BATCH)
+	{
+		const float* verts[RC_RASTER_BATCH][3];
+		float tx[3 * RC_RASTER_BATCH], ty[3 * RC_RASTER_BATCH], tz[3 * RC_RASTER_BATCH];
+		for (int lane = 0; lane < RC_RASTER_BATCH; ++lane)
+		{
+			getTriangle(triIndex + lane, verts[lane][0], verts[lane][1], verts[lane][2]);
+			for (int vert = 0; vert < 3; ++vert)
+			{
+				tx[vert * RC_RASTER_BATCH + lane] = verts[lane][vert][0];
+				ty[vert * RC_RASTER_BATCH + lane] = verts[lane][vert][1];
+				tz[vert * RC_RASTER_BATCH + lane] = verts[lane][vert][2];
+			}
+		}
+
+		rcTriBatchFootprint footprint;
+		setupTriBatch(tx, ty, tz, heightfield.bmin, heightfield.bmax, inverseCellSize, footprint);
+
+		for (int lane = 0; lane < RC_RASTER_BATCH; ++lane)
+		{
+			const float* v0 = verts[lane][0];
+			const float* v1 = verts[lane][1];
+			const float* v2 = verts[lane][2];
+			const unsigned char areaID = triAreaIDs[triIndex + lane];
+
+			int x = 0, z = 0;
+			unsigned short spanMin = 0, spanMax = 0;
+			const int fast = singleCellSpan(v0, v1, v2, footprint, lane, heightfield, heightfield.bmin, heightfield.bmax,
+			                                heightfield.cs, inverseCellHeight, x, z, spanMin, spanMax);
+#if defined(RC_RASTERIZATION_VALIDATE)
+			if (fast >= 0)
+			{
+				rcCollectSpanSink reference = { 0, 0, 0, 0, 0 };
+				rasterizeTriSpans(v0, v1, v2, heightfield, heightfield.bmin, heightfield.bmax,
+				                  heightfield.cs, inverseCellSize, inverseCellHeight, reference);
+				const bool same = fast == 0 ? reference.count == 0 :
+					(reference.count == 1 && reference.x == x && reference.z == z &&
+					 reference.spanMin == spanMin && reference.spanMax == spanMax);
+				if (!same)
+				{
+					context->log(RC_LOG_ERROR, "rcRasterizeTriangles: Vectorized span of triangle %d differs from the reference.", triIndex + lane);
+					rcAssert(same);
+				}
+			}
+#endif
+			bool ok = true;
+			if (fast > 0)
+			{
+				ok = addSpan(heightfield, x, z, spanMin, spanMax, areaID, flagMergeThreshold);
+			}
+			else if (fast < 0)
+			{
+				ok = rasterizeTri(v0, v1, v2, areaID, heightfield, heightfield.bmin, heightfield.bmax,
+				                  heightfield.cs, inverseCellSize, inverseCellHeight, flagMergeThreshold);
+			}
+			if (!ok)
+			{
+				context->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
+				return false;
+			}
+		}
+	}
+#endif
+
+	for (; triIndex < numTris; ++triIndex)
+	{
+		const float* v0;
+		const float* v1;
+		const float* v2;
+		getTriangle(triIndex, v0, v1, v2);
+		if (!rasterizeTri(v0, v1, v2, triAreaIDs[triIndex], heightfield, heightfield.bmin, heightfield.bmax, heightfield.cs, inverseCellSize, inverseCellHeight, flagMergeThreshold))
+		{
+			context->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// Fetches triangle vertices through an index list.
+template <class IndexType>
+struct rcIndexedTriangles
+{
+	const float* verts;
+	const IndexType* tris;
+
+	void operator()(const int triIndex, const float*& v0, const float*& v1, const float*& v2) const
+	{
+		v0 = &verts[tris[triIndex * 3 + 0] * 3];
+		v1 = &verts[tris[triIndex * 3 + 1] * 3];
+		v2 = &verts[tris[triIndex * 3 + 2] * 3];
+	}
+};
+
+/// Fetches triangle vertices from a flat list of three vertices per triangle.
+struct rcFlatTriangles
+{
+	const float* verts;
+
+	void operator()(const int triIndex, const float*& v0, const float*& v1, const float*& v2) const
+	{
+		v0 = &verts[(triIndex * 3 + 0) * 3];
+		v1 = &verts[(triIndex * 3 + 1) * 3];
+		v2 = &verts[(triIndex * 3 + 2) * 3];
+	}
+};
+
 bool rcRasterizeTriangle(rcContext* context,
                          const float* v0, const float* v1, const float* v2,
                          const unsigned char areaID, rcHeightfield& heightfield, const int flagMergeThreshold)
@@ -484,21 +828,8 @@ bool rcRasterizeTriangles(rcContext* context,
 	rcScopedTimer timer(context, RC_TIMER_RASTERIZE_TRIANGLES);
 	
 	// Rasterize the triangles.
-	const float inverseCellSize = 1.0f / heightfield.cs;
-	const float inverseCellHeight = 1.0f / heightfield.ch;
-	for (int triIndex = 0; triIndex < numTris; ++triIndex)
-	{
-		const float* v0 = &verts[tris[triIndex * 3 + 0] * 3];
-		const float* v1 = &verts[tris[triIndex * 3 + 1] * 3];
-		const float* v2 = &verts[tris[triIndex * 3 + 2] * 3];
-		if (!rasterizeTri(v0, v1, v2, triAreaIDs[triIndex], heightfield, heightfield.bmin, heightfield.bmax, heightfield.cs, inverseCellSize, inverseCellHeight, flagMergeThreshold))
-		{
-			context->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
-			return false;
-		}
-	}
-
-	return true;
+	const rcIndexedTriangles<int> triangles = { verts, tris };
+	return rasterizeTriangleList(context, triangles, triAreaIDs, numTris, heightfield, flagMergeThreshold);
 }
 
 bool rcRasterizeTriangles(rcContext* context,
@@ -511,21 +842,8 @@ bool rcRasterizeTriangles(rcContext* context,
 	rcScopedTimer timer(context, RC_TIMER_RASTERIZE_TRIANGLES);
 
 	// Rasterize the triangles.
-	const float inverseCellSize = 1.0f / heightfield.cs;
-	const float inverseCellHeight = 1.0f / heightfield.ch;
-	for (int triIndex = 0; triIndex < numTris; ++triIndex)
-	{
-		const float* v0 = &verts[tris[triIndex * 3 + 0] * 3];
-		const float* v1 = &verts[tris[triIndex * 3 + 1] * 3];
-		const float* v2 = &verts[tris[triIndex * 3 + 2] * 3];
-		if (!rasterizeTri(v0, v1, v2, triAreaIDs[triIndex], heightfield, heightfield.bmin, heightfield.bmax, heightfield.cs, inverseCellSize, inverseCellHeight, flagMergeThreshold))
-		{
-			context->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
-			return false;
-		}
-	}
-
-	return true;
+	const rcIndexedTriangles<unsigned short> triangles = { verts, tris };
+	return rasterizeTriangleList(context, triangles, triAreaIDs, numTris, heightfield, flagMergeThreshold);
 }
 
 bool rcRasterizeTriangles(rcContext* context,
@@ -537,19 +855,6 @@ bool rcRasterizeTriangles(rcContext* context,
 	rcScopedTimer timer(context, RC_TIMER_RASTERIZE_TRIANGLES);
 	
 	// Rasterize the triangles.
-	const float inverseCellSize = 1.0f / heightfield.cs;
-	const float inverseCellHeight = 1.0f / heightfield.ch;
-	for (int triIndex = 0; triIndex < numTris; ++triIndex)
-	{
-		const float* v0 = &verts[(triIndex * 3 + 0) * 3];
-		const float* v1 = &verts[(triIndex * 3 + 1) * 3];
-		const float* v2 = &verts[(triIndex * 3 + 2) * 3];
-		if (!rasterizeTri(v0, v1, v2, triAreaIDs[triIndex], heightfield, heightfield.bmin, heightfield.bmax, heightfield.cs, inverseCellSize, inverseCellHeight, flagMergeThreshold))
-		{
-			context->log(RC_LOG_ERROR, "rcRasterizeTriangles: Out of memory.");
-			return false;
-		}
-	}
-
-	return true;
+	const rcFlatTriangles triangles = { verts };
+	return rasterizeTriangleList(context, triangles, triAreaIDs, numTris, heightfield, flagMergeThreshold);
 }
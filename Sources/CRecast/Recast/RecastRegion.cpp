@@ -25,28 +25,245 @@
 #include "RecastAlloc.h"
 #include "RecastAssert.h"
 
+// The distance field and watershed passes can split their work across
+// threads (see the numThreads overloads of rcBuildDistanceField and
+// rcBuildRegions). Define RC_DISABLE_THREADS to always run them on the
+// calling thread.
+#ifndef RC_DISABLE_THREADS
+#	include <atomic>
+#	include <condition_variable>
+#	include <mutex>
+#	include <new>
+#	include <thread>
+#endif
+
 namespace
 {
 struct LevelStackEntry
 {
+	LevelStackEntry() : x(0), y(0), index(-1) {}
 	LevelStackEntry(int x_, int y_, int index_) : x(x_), y(y_), index(index_) {}
 	int x;
 	int y;
 	int index;
 };
+
+/// Most threads a region build splits its passes across.
+static const int RC_MAX_REGION_THREADS = 64;
+
+/// Heightfields with fewer spans than this are not worth splitting.
+static const int RC_MIN_PARALLEL_SPANS = 1 << 15;
+
+/// Stacks shorter than this are expanded on the calling thread.
+static const int RC_MIN_PARALLEL_EXPAND = 4096;
+
+/// A fixed set of threads that runs a job over [0, count) with one
+/// contiguous range per thread, the calling thread taking the first range.
+/// Jobs only ever write to their own range, so the result does not depend on
+/// the number of threads.
+class rcRegionWorkers
+{
+public:
+	explicit rcRegionWorkers(int numThreads);
+	~rcRegionWorkers();
+
+	int size() const { return m_numThreads; }
+
+	/// Calls job(worker, begin, end) for each thread's range of [0, count).
+	template<class Job>
+	void run(const int count, const Job& job)
+	{
+#ifndef RC_DISABLE_THREADS
+		if (m_numThreads > 1 && count > 1)
+		{
+			dispatch(count, &invoke<Job>, &job);
+			return;
+		}
+#endif
+		job(0, 0, count);
+	}
+
+	/// Range of [0, count) handled by the given worker.
+	void range(const int count, const int worker, int& begin, int& end) const
+	{
+		begin = (int)((long long)count * worker / m_numThreads);
+		end = (int)((long long)count * (worker + 1) / m_numThreads);
+	}
+
+private:
+	typedef void (*JobFunc)(const void* job, int worker, int begin, int end);
+
+	template<class Job>
+	static void invoke(const void* job, int worker, int begin, int end)
+	{
+		(*(const Job*)job)(worker, begin, end);
+	}
+
+	int m_numThreads;
+
+#ifndef RC_DISABLE_THREADS
+	void dispatch(int count, JobFunc func, const void* job);
+	void workerMain(int worker);
+	void runRange(int worker);
+
+	std::thread m_threads[RC_MAX_REGION_THREADS];
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	unsigned int m_generation;
+	int m_pending;
+	bool m_quit;
+	JobFunc m_func;
+	const void* m_job;
+	int m_count;
+#endif
+
+	// Explicitly-disabled copy constructor and copy assignment operator.
+	rcRegionWorkers(const rcRegionWorkers&);
+	rcRegionWorkers& operator=(const rcRegionWorkers&);
+};
+
+rcRegionWorkers::rcRegionWorkers(int numThreads)
+{
+#ifdef RC_DISABLE_THREADS
+	rcIgnoreUnused(numThreads);
+	m_numThreads = 1;
+#else
+	m_numThreads = rcClamp(numThreads, 1, RC_MAX_REGION_THREADS);
+	m_generation = 0;
+	m_pending = 0;
+	m_quit = false;
+	m_func = 0;
+	m_job = 0;
+	m_count = 0;
+	for (int i = 1; i < m_numThreads; ++i)
+		m_threads[i] = std::thread(&rcRegionWorkers::workerMain, this, i);
+#endif
+}
+
+rcRegionWorkers::~rcRegionWorkers()
+{
+#ifndef RC_DISABLE_THREADS
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+	for (int i = 1; i < m_numThreads; ++i)
+		m_threads[i].join();
+#endif
+}
+
+#ifndef RC_DISABLE_THREADS
+void rcRegionWorkers::runRange(int worker)
+{
+	int begin, end;
+	range(m_count, worker, begin, end);
+	if (begin < end)
+		m_func(m_job, worker, begin, end);
+}
+
+void rcRegionWorkers::dispatch(int count, JobFunc func, const void* job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_func = func;
+		m_job = job;
+		m_count = count;
+		m_pending = m_numThreads - 1;
+		++m_generation;
+	}
+	m_wake.notify_all();
+
+	runRange(0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this]() { return m_pending == 0; });
+}
+
+void rcRegionWorkers::workerMain(int worker)
+{
+	unsigned int seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&]() { return m_quit || m_generation != seen; });
+			if (m_quit)
+				return;
+			seen = m_generation;
+		}
+
+		runRange(worker);
+
+		bool last;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			last = --m_pending == 0;
+		}
+		if (last)
+			m_done.notify_one();
+	}
+}
+#endif
+
+#ifndef RC_DISABLE_THREADS
+/// Orders the rows of a chamfer pass run as a wavefront: every row waits
+/// until the row before it (in pass order) is far enough ahead, so each span
+/// reads exactly the values a serial pass would.
+class rcRowProgress
+{
+public:
+	explicit rcRowProgress(int rows)
+	{
+		m_done = (std::atomic<int>*)rcAlloc(sizeof(std::atomic<int>) * rcMax(rows, 1), RC_ALLOC_TEMP);
+		if (m_done)
+		{
+			for (int i = 0; i < rows; ++i)
+				new (&m_done[i]) std::atomic<int>(0);
+		}
+	}
+	~rcRowProgress() { rcFree(m_done); }
+
+	bool valid() const { return m_done != 0; }
+
+	/// Blocks until the row has finished at least the given number of columns.
+	void wait(int row, int columns) const
+	{
+		while (m_done[row].load(std::memory_order_acquire) < columns)
+			std::this_thread::yield();
+	}
+
+	void publish(int row, int columns)
+	{
+		m_done[row].store(columns, std::memory_order_release);
+	}
+
+private:
+	std::atomic<int>* m_done;
+
+	// Explicitly-disabled copy constructor and copy assignment operator.
+	rcRowProgress(const rcRowProgress&);
+	rcRowProgress& operator=(const rcRowProgress&);
+};
+#endif
 }  // namespace
 
-static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* src, unsigned short& maxDist)
+/// Number of threads worth using for a pass over the given heightfield.
+static int regionThreadCount(const rcCompactHeightfield& chf, int numThreads)
+{
+	if (chf.spanCount < RC_MIN_PARALLEL_SPANS)
+		return 1;
+	return rcClamp(rcMin(numThreads, chf.height), 1, RC_MAX_REGION_THREADS);
+}
+
+/// Initializes the distances of rows [y0, y1): 0 on area boundaries,
+/// 0xffff elsewhere.
+static void markDistanceBoundaries(const rcCompactHeightfield& chf, unsigned short* src, int y0, int y1)
 {
 	const int w = chf.width;
-	const int h = chf.height;
-	
-	// Init distance and points.
-	for (int i = 0; i < chf.spanCount; ++i)
-		src[i] = 0xffff;
-	
-	// Mark boundary cells.
-	for (int y = 0; y < h; ++y)
+
+	for (int y = y0; y < y1; ++y)
 	{
 		for (int x = 0; x < w; ++x)
 		{
@@ -55,7 +272,7 @@ static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* sr
 			{
 				const rcCompactSpan& s = chf.spans[i];
 				const unsigned char area = chf.areas[i];
-				
+
 				int nc = 0;
 				for (int dir = 0; dir < 4; ++dir)
 				{
@@ -68,136 +285,228 @@ static void calculateDistanceField(rcCompactHeightfield& chf, unsigned short* sr
 							nc++;
 					}
 				}
-				if (nc != 4)
-					src[i] = 0;
+				src[i] = nc != 4 ? 0 : 0xffff;
 			}
 		}
 	}
-	
-			
-	// Pass 1
-	for (int y = 0; y < h; ++y)
+}
+
+/// First chamfer pass over columns [x0, x1) of row y, left to right: pulls
+/// distances from (-1,0), (-1,-1), (0,-1) and (1,-1).
+static void chamferRowForward(const rcCompactHeightfield& chf, unsigned short* src, int y, int x0, int x1)
+{
+	const int w = chf.width;
+
+	for (int x = x0; x < x1; ++x)
 	{
-		for (int x = 0; x < w; ++x)
+		const rcCompactCell& c = chf.cells[x+y*w];
+		for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			const rcCompactSpan& s = chf.spans[i];
+
+			if (rcGetCon(s, 0) != RC_NOT_CONNECTED)
 			{
-				const rcCompactSpan& s = chf.spans[i];
-				
-				if (rcGetCon(s, 0) != RC_NOT_CONNECTED)
+				// (-1,0)
+				const int ax = x + rcGetDirOffsetX(0);
+				const int ay = y + rcGetDirOffsetY(0);
+				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 0);
+				const rcCompactSpan& as = chf.spans[ai];
+				if (src[ai]+2 < src[i])
+					src[i] = src[ai]+2;
+
+				// (-1,-1)
+				if (rcGetCon(as, 3) != RC_NOT_CONNECTED)
 				{
-					// (-1,0)
-					const int ax = x + rcGetDirOffsetX(0);
-					const int ay = y + rcGetDirOffsetY(0);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 0);
-					const rcCompactSpan& as = chf.spans[ai];
-					if (src[ai]+2 < src[i])
-						src[i] = src[ai]+2;
-					
-					// (-1,-1)
-					if (rcGetCon(as, 3) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(3);
-						const int aay = ay + rcGetDirOffsetY(3);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 3);
-						if (src[aai]+3 < src[i])
-							src[i] = src[aai]+3;
-					}
+					const int aax = ax + rcGetDirOffsetX(3);
+					const int aay = ay + rcGetDirOffsetY(3);
+					const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 3);
+					if (src[aai]+3 < src[i])
+						src[i] = src[aai]+3;
 				}
-				if (rcGetCon(s, 3) != RC_NOT_CONNECTED)
+			}
+			if (rcGetCon(s, 3) != RC_NOT_CONNECTED)
+			{
+				// (0,-1)
+				const int ax = x + rcGetDirOffsetX(3);
+				const int ay = y + rcGetDirOffsetY(3);
+				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 3);
+				const rcCompactSpan& as = chf.spans[ai];
+				if (src[ai]+2 < src[i])
+					src[i] = src[ai]+2;
+
+				// (1,-1)
+				if (rcGetCon(as, 2) != RC_NOT_CONNECTED)
 				{
-					// (0,-1)
-					const int ax = x + rcGetDirOffsetX(3);
-					const int ay = y + rcGetDirOffsetY(3);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 3);
-					const rcCompactSpan& as = chf.spans[ai];
-					if (src[ai]+2 < src[i])
-						src[i] = src[ai]+2;
-					
-					// (1,-1)
-					if (rcGetCon(as, 2) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(2);
-						const int aay = ay + rcGetDirOffsetY(2);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 2);
-						if (src[aai]+3 < src[i])
-							src[i] = src[aai]+3;
-					}
+					const int aax = ax + rcGetDirOffsetX(2);
+					const int aay = ay + rcGetDirOffsetY(2);
+					const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 2);
+					if (src[aai]+3 < src[i])
+						src[i] = src[aai]+3;
 				}
 			}
 		}
 	}
-	
-	// Pass 2
-	for (int y = h-1; y >= 0; --y)
+}
+
+/// Second chamfer pass over columns [x0, x1) of row y, right to left: pulls
+/// distances from (1,0), (1,1), (0,1) and (-1,1).
+static void chamferRowBackward(const rcCompactHeightfield& chf, unsigned short* src, int y, int x0, int x1)
+{
+	const int w = chf.width;
+
+	for (int x = x1-1; x >= x0; --x)
 	{
-		for (int x = w-1; x >= 0; --x)
+		const rcCompactCell& c = chf.cells[x+y*w];
+		for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			const rcCompactSpan& s = chf.spans[i];
+
+			if (rcGetCon(s, 2) != RC_NOT_CONNECTED)
 			{
-				const rcCompactSpan& s = chf.spans[i];
-				
-				if (rcGetCon(s, 2) != RC_NOT_CONNECTED)
+				// (1,0)
+				const int ax = x + rcGetDirOffsetX(2);
+				const int ay = y + rcGetDirOffsetY(2);
+				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 2);
+				const rcCompactSpan& as = chf.spans[ai];
+				if (src[ai]+2 < src[i])
+					src[i] = src[ai]+2;
+
+				// (1,1)
+				if (rcGetCon(as, 1) != RC_NOT_CONNECTED)
 				{
-					// (1,0)
-					const int ax = x + rcGetDirOffsetX(2);
-					const int ay = y + rcGetDirOffsetY(2);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 2);
-					const rcCompactSpan& as = chf.spans[ai];
-					if (src[ai]+2 < src[i])
-						src[i] = src[ai]+2;
-					
-					// (1,1)
-					if (rcGetCon(as, 1) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(1);
-						const int aay = ay + rcGetDirOffsetY(1);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 1);
-						if (src[aai]+3 < src[i])
-							src[i] = src[aai]+3;
-					}
+					const int aax = ax + rcGetDirOffsetX(1);
+					const int aay = ay + rcGetDirOffsetY(1);
+					const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 1);
+					if (src[aai]+3 < src[i])
+						src[i] = src[aai]+3;
 				}
-				if (rcGetCon(s, 1) != RC_NOT_CONNECTED)
+			}
+			if (rcGetCon(s, 1) != RC_NOT_CONNECTED)
+			{
+				// (0,1)
+				const int ax = x + rcGetDirOffsetX(1);
+				const int ay = y + rcGetDirOffsetY(1);
+				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 1);
+				const rcCompactSpan& as = chf.spans[ai];
+				if (src[ai]+2 < src[i])
+					src[i] = src[ai]+2;
+
+				// (-1,1)
+				if (rcGetCon(as, 0) != RC_NOT_CONNECTED)
 				{
-					// (0,1)
-					const int ax = x + rcGetDirOffsetX(1);
-					const int ay = y + rcGetDirOffsetY(1);
-					const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, 1);
-					const rcCompactSpan& as = chf.spans[ai];
-					if (src[ai]+2 < src[i])
-						src[i] = src[ai]+2;
-					
-					// (-1,1)
-					if (rcGetCon(as, 0) != RC_NOT_CONNECTED)
-					{
-						const int aax = ax + rcGetDirOffsetX(0);
-						const int aay = ay + rcGetDirOffsetY(0);
-						const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 0);
-						if (src[aai]+3 < src[i])
-							src[i] = src[aai]+3;
-					}
+					const int aax = ax + rcGetDirOffsetX(0);
+					const int aay = ay + rcGetDirOffsetY(0);
+					const int aai = (int)chf.cells[aax+aay*w].index + rcGetCon(as, 0);
+					if (src[aai]+3 < src[i])
+						src[i] = src[aai]+3;
 				}
 			}
 		}
-	}	
-	
-	maxDist = 0;
-	for (int i = 0; i < chf.spanCount; ++i)
-		maxDist = rcMax(src[i], maxDist);
-	
+	}
 }
 
-static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
-							   unsigned short* src, unsigned short* dst)
+/// Columns of a row processed between progress updates in the wavefront.
+static const int RC_CHAMFER_BLOCK = 32;
+
+/// Runs both chamfer passes. With more than one worker, rows are dealt out
+/// round-robin and run as a wavefront, each trailing the row before it by
+/// one block, which reproduces the serial pass exactly.
+static bool chamferPasses(const rcCompactHeightfield& chf, unsigned short* src, rcRegionWorkers& workers)
 {
 	const int w = chf.width;
 	const int h = chf.height;
-	
-	thr *= 2;
-	
+	const int numWorkers = workers.size();
+
+#ifndef RC_DISABLE_THREADS
+	if (numWorkers > 1)
+	{
+		// Forward: row y needs row y-1 finished up to and including column x1.
+		rcRowProgress forward(h);
+		if (!forward.valid())
+			return false;
+		workers.run(numWorkers, [&](int worker, int, int)
+		{
+			for (int y = worker; y < h; y += numWorkers)
+			{
+				for (int x0 = 0; x0 < w; x0 += RC_CHAMFER_BLOCK)
+				{
+					const int x1 = rcMin(x0 + RC_CHAMFER_BLOCK, w);
+					if (y > 0)
+						forward.wait(y-1, rcMin(x1+1, w));
+					chamferRowForward(chf, src, y, x0, x1);
+					forward.publish(y, x1);
+				}
+			}
+		});
+
+		// Backward, mirrored: progress counts columns finished from the right.
+		rcRowProgress backward(h);
+		if (!backward.valid())
+			return false;
+		workers.run(numWorkers, [&](int worker, int, int)
+		{
+			for (int r = worker; r < h; r += numWorkers)
+			{
+				const int y = h-1 - r;
+				for (int x1 = w; x1 > 0; x1 -= RC_CHAMFER_BLOCK)
+				{
+					const int x0 = rcMax(x1 - RC_CHAMFER_BLOCK, 0);
+					if (r > 0)
+						backward.wait(y+1, rcMin(w - x0 + 1, w));
+					chamferRowBackward(chf, src, y, x0, x1);
+					backward.publish(y, w - x0);
+				}
+			}
+		});
+		return true;
+	}
+#endif
+
 	for (int y = 0; y < h; ++y)
+		chamferRowForward(chf, src, y, 0, w);
+	for (int y = h-1; y >= 0; --y)
+		chamferRowBackward(chf, src, y, 0, w);
+	return true;
+}
+
+static bool calculateDistanceField(rcCompactHeightfield& chf, unsigned short* src, unsigned short& maxDist,
+								   rcRegionWorkers& workers)
+{
+	const int h = chf.height;
+
+	// Mark boundary cells.
+	workers.run(h, [&](int, int y0, int y1)
+	{
+		markDistanceBoundaries(chf, src, y0, y1);
+	});
+
+	if (!chamferPasses(chf, src, workers))
+		return false;
+
+	unsigned short workerMax[RC_MAX_REGION_THREADS];
+	memset(workerMax, 0, sizeof(workerMax));
+	workers.run(chf.spanCount, [&](int worker, int begin, int end)
+	{
+		unsigned short m = 0;
+		for (int i = begin; i < end; ++i)
+			m = rcMax(src[i], m);
+		workerMax[worker] = m;
+	});
+
+	maxDist = 0;
+	for (int i = 0; i < workers.size(); ++i)
+		maxDist = rcMax(workerMax[i], maxDist);
+
+	return true;
+}
+
+/// Blurs the distances of rows [y0, y1) from src into dst.
+static void boxBlurRows(const rcCompactHeightfield& chf, int thr,
+						const unsigned short* src, unsigned short* dst, int y0, int y1)
+{
+	const int w = chf.width;
+
+	for (int y = y0; y < y1; ++y)
 	{
 		for (int x = 0; x < w; ++x)
 		{
@@ -221,7 +530,7 @@ static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
 						const int ay = y + rcGetDirOffsetY(dir);
 						const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
 						d += (int)src[ai];
-						
+
 						const rcCompactSpan& as = chf.spans[ai];
 						const int dir2 = (dir+1) & 0x3;
 						if (rcGetCon(as, dir2) != RC_NOT_CONNECTED)
@@ -245,6 +554,18 @@ static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
 			}
 		}
 	}
+}
+
+static unsigned short* boxBlur(rcCompactHeightfield& chf, int thr,
+							   unsigned short* src, unsigned short* dst,
+							   rcRegionWorkers& workers)
+{
+	thr *= 2;
+
+	workers.run(chf.height, [&](int, int y0, int y1)
+	{
+		boxBlurRows(chf, thr, src, dst, y0, y1);
+	});
 	return dst;
 }
 
@@ -352,35 +673,123 @@ static bool floodRegion(int x, int y, int i,
 // Struct to keep track of entries in the region table that have been changed.
 struct DirtyEntry
 {
+	DirtyEntry() : index(-1), region(0), distance2(0) {}
 	DirtyEntry(int index_, unsigned short region_, unsigned short distance2_)
 		: index(index_), region(region_), distance2(distance2_) {}
 	int index;
 	unsigned short region;
 	unsigned short distance2;
 };
+
+/// Counts, and writes to out when given, the spans of rows [y0, y1) that are
+/// revealed by the level and have no region yet, in scan order.
+static void collectRevealedSpans(const rcCompactHeightfield& chf, unsigned short level,
+								 const unsigned short* srcReg, int y0, int y1,
+								 LevelStackEntry* out, int* count)
+{
+	const int w = chf.width;
+	int n = 0;
+	for (int y = y0; y < y1; ++y)
+	{
+		for (int x = 0; x < w; ++x)
+		{
+			const rcCompactCell& c = chf.cells[x+y*w];
+			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			{
+				if (chf.dist[i] >= level && srcReg[i] == 0 && chf.areas[i] != RC_NULL_AREA)
+				{
+					if (out)
+						out[n] = LevelStackEntry(x, y, i);
+					n++;
+				}
+			}
+		}
+	}
+	*count = n;
+}
+
+/// Finds the region the entry would grow into from its neighbours, or 0.
+static unsigned short expandEntry(const rcCompactHeightfield& chf, const LevelStackEntry& entry,
+								  const unsigned short* srcReg, const unsigned short* srcDist,
+								  unsigned short& d2)
+{
+	const int w = chf.width;
+	const int x = entry.x;
+	const int y = entry.y;
+	const int i = entry.index;
+
+	unsigned short r = srcReg[i];
+	d2 = 0xffff;
+	const unsigned char area = chf.areas[i];
+	const rcCompactSpan& s = chf.spans[i];
+	for (int dir = 0; dir < 4; ++dir)
+	{
+		if (rcGetCon(s, dir) == RC_NOT_CONNECTED) continue;
+		const int ax = x + rcGetDirOffsetX(dir);
+		const int ay = y + rcGetDirOffsetY(dir);
+		const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
+		if (chf.areas[ai] != area) continue;
+		if (srcReg[ai] > 0 && (srcReg[ai] & RC_BORDER_REG) == 0)
+		{
+			if ((int)srcDist[ai]+2 < (int)d2)
+			{
+				r = srcReg[ai];
+				d2 = srcDist[ai]+2;
+			}
+		}
+	}
+	return r;
+}
+
 static void expandRegions(int maxIter, unsigned short level,
-					      rcCompactHeightfield& chf,
-					      unsigned short* srcReg, unsigned short* srcDist,
-					      rcTempVector<LevelStackEntry>& stack,
-					      bool fillStack)
+						  rcCompactHeightfield& chf,
+						  unsigned short* srcReg, unsigned short* srcDist,
+						  rcTempVector<LevelStackEntry>& stack,
+						  bool fillStack, rcRegionWorkers& workers)
 {
 	const int w = chf.width;
 	const int h = chf.height;
 
 	if (fillStack)
 	{
-		// Find cells revealed by the raised level.
+		// Find cells revealed by the raised level. Split across workers,
+		// each range is counted first and then written at its offset.
 		stack.clear();
-		for (int y = 0; y < h; ++y)
+		if (workers.size() > 1)
 		{
-			for (int x = 0; x < w; ++x)
+			int counts[RC_MAX_REGION_THREADS];
+			memset(counts, 0, sizeof(counts));
+			workers.run(h, [&](int worker, int y0, int y1)
 			{
-				const rcCompactCell& c = chf.cells[x+y*w];
-				for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+				collectRevealedSpans(chf, level, srcReg, y0, y1, 0, &counts[worker]);
+			});
+			int offsets[RC_MAX_REGION_THREADS];
+			int total = 0;
+			for (int i = 0; i < workers.size(); ++i)
+			{
+				offsets[i] = total;
+				total += counts[i];
+			}
+			stack.resize(total);
+			workers.run(h, [&](int worker, int y0, int y1)
+			{
+				int n;
+				collectRevealedSpans(chf, level, srcReg, y0, y1, stack.data() + offsets[worker], &n);
+			});
+		}
+		else
+		{
+			for (int y = 0; y < h; ++y)
+			{
+				for (int x = 0; x < w; ++x)
 				{
-					if (chf.dist[i] >= level && srcReg[i] == 0 && chf.areas[i] != RC_NULL_AREA)
+					const rcCompactCell& c = chf.cells[x+y*w];
+					for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
 					{
-						stack.push_back(LevelStackEntry(x, y, i));
+						if (chf.dist[i] >= level && srcReg[i] == 0 && chf.areas[i] != RC_NULL_AREA)
+						{
+							stack.push_back(LevelStackEntry(x, y, i));
+						}
 					}
 				}
 			}
@@ -403,59 +812,77 @@ static void expandRegions(int maxIter, unsigned short level,
 	{
 		int failed = 0;
 		dirtyEntries.clear();
-		
-		for (int j = 0; j < stack.size(); j++)
+
+		if (workers.size() > 1 && stack.size() >= RC_MIN_PARALLEL_EXPAND)
 		{
-			int x = stack[j].x;
-			int y = stack[j].y;
-			int i = stack[j].index;
-			if (i < 0)
-			{
-				failed++;
-				continue;
-			}
-			
-			unsigned short r = srcReg[i];
-			unsigned short d2 = 0xffff;
-			const unsigned char area = chf.areas[i];
-			const rcCompactSpan& s = chf.spans[i];
-			for (int dir = 0; dir < 4; ++dir)
+			// Every entry only reads srcReg and srcDist, which change after
+			// the sweep, so the sweep splits freely. One slot per entry keeps
+			// the updates in stack order.
+			dirtyEntries.resize(stack.size());
+			int failedBy[RC_MAX_REGION_THREADS];
+			memset(failedBy, 0, sizeof(failedBy));
+			workers.run(stack.size(), [&](int worker, int begin, int end)
 			{
-				if (rcGetCon(s, dir) == RC_NOT_CONNECTED) continue;
-				const int ax = x + rcGetDirOffsetX(dir);
-				const int ay = y + rcGetDirOffsetY(dir);
-				const int ai = (int)chf.cells[ax+ay*w].index + rcGetCon(s, dir);
-				if (chf.areas[ai] != area) continue;
-				if (srcReg[ai] > 0 && (srcReg[ai] & RC_BORDER_REG) == 0)
+				int f = 0;
+				for (int j = begin; j < end; j++)
 				{
-					if ((int)srcDist[ai]+2 < (int)d2)
+					if (stack[j].index < 0)
 					{
-						r = srcReg[ai];
-						d2 = srcDist[ai]+2;
+						f++;
+						continue;
+					}
+					unsigned short d2;
+					const unsigned short r = expandEntry(chf, stack[j], srcReg, srcDist, d2);
+					if (r)
+					{
+						dirtyEntries[j] = DirtyEntry(stack[j].index, r, d2);
+						stack[j].index = -1; // mark as used
+					}
+					else
+					{
+						f++;
 					}
 				}
-			}
-			if (r)
-			{
-				stack[j].index = -1; // mark as used
-				dirtyEntries.push_back(DirtyEntry(i, r, d2));
-			}
-			else
+				failedBy[worker] = f;
+			});
+			for (int i = 0; i < workers.size(); ++i)
+				failed += failedBy[i];
+		}
+		else
+		{
+			for (int j = 0; j < stack.size(); j++)
 			{
-				failed++;
+				if (stack[j].index < 0)
+				{
+					failed++;
+					continue;
+				}
+				unsigned short d2;
+				const unsigned short r = expandEntry(chf, stack[j], srcReg, srcDist, d2);
+				if (r)
+				{
+					dirtyEntries.push_back(DirtyEntry(stack[j].index, r, d2));
+					stack[j].index = -1; // mark as used
+				}
+				else
+				{
+					failed++;
+				}
 			}
 		}
-		
+
 		// Copy entries that differ between src and dst to keep them in sync.
 		for (int i = 0; i < dirtyEntries.size(); i++) {
 			int idx = dirtyEntries[i].index;
+			if (idx < 0)
+				continue;
 			srcReg[idx] = dirtyEntries[i].region;
 			srcDist[idx] = dirtyEntries[i].distance2;
 		}
-		
+
 		if (failed == stack.size())
 			break;
-		
+
 		if (level > 0)
 		{
 			++iter;
@@ -465,13 +892,31 @@ static void expandRegions(int maxIter, unsigned short level,
 	}
 }
 
+/// Stack of a span in sortCellsByLevel, or -1 if it belongs to none.
+static inline int levelStackOf(const rcCompactHeightfield& chf, const unsigned short* srcReg, int i,
+							   int startLevel, int nbStacks, unsigned short loglevelsPerStack)
+{
+	if (chf.areas[i] == RC_NULL_AREA || srcReg[i] != 0)
+		return -1;
+
+	int level = chf.dist[i] >> loglevelsPerStack;
+	int sId = startLevel - level;
+	if (sId >= nbStacks)
+		return -1;
+	if (sId < 0)
+		sId = 0;
+	return sId;
+}
 
+/// Maximum stacks sortCellsByLevel can fill on several workers.
+static const int RC_MAX_LEVEL_STACKS = 8;
 
 static void sortCellsByLevel(unsigned short startLevel,
 							  rcCompactHeightfield& chf,
 							  const unsigned short* srcReg,
 							  unsigned int nbStacks, rcTempVector<LevelStackEntry>* stacks,
-							  unsigned short loglevelsPerStack) // the levels per stack (2 in our case) as a bit shift
+							  unsigned short loglevelsPerStack, // the levels per stack (2 in our case) as a bit shift
+							  rcRegionWorkers& workers)
 {
 	const int w = chf.width;
 	const int h = chf.height;
@@ -480,28 +925,75 @@ static void sortCellsByLevel(unsigned short startLevel,
 	for (unsigned int j=0; j<nbStacks; ++j)
 		stacks[j].clear();
 
-	// put all cells in the level range into the appropriate stacks
-	for (int y = 0; y < h; ++y)
+	if (workers.size() <= 1 || nbStacks > (unsigned int)RC_MAX_LEVEL_STACKS)
 	{
-		for (int x = 0; x < w; ++x)
+		// put all cells in the level range into the appropriate stacks
+		for (int y = 0; y < h; ++y)
 		{
-			const rcCompactCell& c = chf.cells[x+y*w];
-			for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+			for (int x = 0; x < w; ++x)
 			{
-				if (chf.areas[i] == RC_NULL_AREA || srcReg[i] != 0)
-					continue;
-
-				int level = chf.dist[i] >> loglevelsPerStack;
-				int sId = startLevel - level;
-				if (sId >= (int)nbStacks)
-					continue;
-				if (sId < 0)
-					sId = 0;
+				const rcCompactCell& c = chf.cells[x+y*w];
+				for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+				{
+					const int sId = levelStackOf(chf, srcReg, i, startLevel, (int)nbStacks, loglevelsPerStack);
+					if (sId >= 0)
+						stacks[sId].push_back(LevelStackEntry(x, y, i));
+				}
+			}
+		}
+		return;
+	}
 
-				stacks[sId].push_back(LevelStackEntry(x, y, i));
+	// Count each worker's rows per stack, then fill every stack at the
+	// worker's offset so the order matches the serial scan.
+	int counts[RC_MAX_REGION_THREADS][RC_MAX_LEVEL_STACKS];
+	memset(counts, 0, sizeof(counts));
+	workers.run(h, [&](int worker, int y0, int y1)
+	{
+		for (int y = y0; y < y1; ++y)
+		{
+			for (int x = 0; x < w; ++x)
+			{
+				const rcCompactCell& c = chf.cells[x+y*w];
+				for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+				{
+					const int sId = levelStackOf(chf, srcReg, i, startLevel, (int)nbStacks, loglevelsPerStack);
+					if (sId >= 0)
+						counts[worker][sId]++;
+				}
 			}
 		}
+	});
+
+	for (unsigned int s = 0; s < nbStacks; ++s)
+	{
+		int total = 0;
+		for (int k = 0; k < workers.size(); ++k)
+		{
+			const int n = counts[k][s];
+			counts[k][s] = total;
+			total += n;
+		}
+		stacks[s].resize(total);
 	}
+
+	workers.run(h, [&](int worker, int y0, int y1)
+	{
+		int* offsets = counts[worker];
+		for (int y = y0; y < y1; ++y)
+		{
+			for (int x = 0; x < w; ++x)
+			{
+				const rcCompactCell& c = chf.cells[x+y*w];
+				for (int i = (int)c.index, ni = (int)(c.index+c.count); i < ni; ++i)
+				{
+					const int sId = levelStackOf(chf, srcReg, i, startLevel, (int)nbStacks, loglevelsPerStack);
+					if (sId >= 0)
+						stacks[sId][offsets[sId]++] = LevelStackEntry(x, y, i);
+				}
+			}
+		}
+	});
 }
 
 
@@ -1251,6 +1743,11 @@ static bool mergeAndFilterLayerRegions(rcContext* ctx, int minRegionArea,
 ///
 /// @see rcCompactHeightfield, rcBuildRegions, rcBuildRegionsMonotone
 bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
+{
+	return rcBuildDistanceField(ctx, chf, 1);
+}
+
+bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf, const int numThreads)
 {
 	rcAssert(ctx);
 	
@@ -1277,11 +1774,18 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
 	}
 	
 	unsigned short maxDist = 0;
+	rcRegionWorkers workers(regionThreadCount(chf, numThreads));
 
 	{
 		rcScopedTimer timerDist(ctx, RC_TIMER_BUILD_DISTANCEFIELD_DIST);
 
-		calculateDistanceField(chf, src, maxDist);
+		if (!calculateDistanceField(chf, src, maxDist, workers))
+		{
+			ctx->log(RC_LOG_ERROR, "rcBuildDistanceField: Out of memory 'progress' (%d).", chf.height);
+			rcFree(src);
+			rcFree(dst);
+			return false;
+		}
 		chf.maxDistance = maxDist;
 	}
 
@@ -1289,7 +1793,7 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf)
 		rcScopedTimer timerBlur(ctx, RC_TIMER_BUILD_DISTANCEFIELD_BLUR);
 
 		// Blur
-		if (boxBlur(chf, 1, src, dst) != src)
+		if (boxBlur(chf, 1, src, dst, workers) != src)
 			rcSwap(src, dst);
 
 		// Store distance.
@@ -1524,6 +2028,13 @@ bool rcBuildRegionsMonotone(rcContext* ctx, rcCompactHeightfield& chf,
 /// @see rcCompactHeightfield, rcCompactSpan, rcBuildDistanceField, rcBuildRegionsMonotone, rcConfig
 bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 					const int borderSize, const int minRegionArea, const int mergeRegionArea)
+{
+	return rcBuildRegions(ctx, chf, borderSize, minRegionArea, mergeRegionArea, 1);
+}
+
+bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
+					const int borderSize, const int minRegionArea, const int mergeRegionArea,
+					const int numThreads)
 {
 	rcAssert(ctx);
 	
@@ -1553,6 +2064,8 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 	unsigned short* srcReg = buf;
 	unsigned short* srcDist = buf+chf.spanCount;
 	
+	rcRegionWorkers workers(regionThreadCount(chf, numThreads));
+	
 	memset(srcReg, 0, sizeof(unsigned short)*chf.spanCount);
 	memset(srcDist, 0, sizeof(unsigned short)*chf.spanCount);
 	
@@ -1589,7 +2102,7 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 //		ctx->startTimer(RC_TIMER_DIVIDE_TO_LEVELS);
 
 		if (sId == 0)
-			sortCellsByLevel(level, chf, srcReg, NB_STACKS, lvlStacks, 1);
+			sortCellsByLevel(level, chf, srcReg, NB_STACKS, lvlStacks, 1, workers);
 		else 
 			appendStacks(lvlStacks[sId-1], lvlStacks[sId], srcReg); // copy left overs from last level
 
@@ -1599,7 +2112,7 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 			rcScopedTimer timerExpand(ctx, RC_TIMER_BUILD_REGIONS_EXPAND);
 
 			// Expand current regions until no empty connected cells found.
-			expandRegions(expandIters, level, chf, srcReg, srcDist, lvlStacks[sId], false);
+			expandRegions(expandIters, level, chf, srcReg, srcDist, lvlStacks[sId], false, workers);
 		}
 		
 		{
@@ -1630,7 +2143,7 @@ bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf,
 	}
 	
 	// Expand current regions until no empty connected cells found.
-	expandRegions(expandIters*8, 0, chf, srcReg, srcDist, stack, true);
+	expandRegions(expandIters*8, 0, chf, srcReg, srcDist, stack, true, workers);
 	
 	ctx->stopTimer(RC_TIMER_BUILD_REGIONS_WATERSHED);
 	
@@ -0,0 +1,215 @@
+// TileDiskCache.cpp
+// Content-addressed on-disk cache of built navmesh tiles
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "TileDiskCache.h"
+#include "DetourAlloc.h"
+#include "DetourNavMesh.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static const int TILE_DISK_CACHE_MAGIC = 'N'<<24 | 'T'<<16 | 'C'<<8 | 'E';
+static const int TILE_DISK_CACHE_VERSION = 1;
+
+struct TileDiskCacheFileHeader
+{
+    int32_t magic;
+    int32_t version;
+    int32_t dataSize;
+    int32_t reserved;
+    uint64_t key[2];        // Repeated from the file name, guards against stray renames
+};
+
+// ================================================
+//       MurmurHash3 x64-128 (public domain, Austin Appleby)
+// ================================================
+
+static const uint64_t MURMUR_C1 = 0x87c37b91114253d5ULL;
+static const uint64_t MURMUR_C2 = 0x4cf5ad432745937fULL;
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+static inline uint64_t loadLE64(const unsigned char* p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+TileHasher::TileHasher() :
+    m_h1(0),
+    m_h2(0),
+    m_tailSize(0),
+    m_length(0)
+{
+}
+
+void TileHasher::block(uint64_t k1, uint64_t k2)
+{
+    k1 *= MURMUR_C1; k1 = rotl64(k1, 31); k1 *= MURMUR_C2; m_h1 ^= k1;
+    m_h1 = rotl64(m_h1, 27); m_h1 += m_h2; m_h1 = m_h1 * 5 + 0x52dce729;
+
+    k2 *= MURMUR_C2; k2 = rotl64(k2, 33); k2 *= MURMUR_C1; m_h2 ^= k2;
+    m_h2 = rotl64(m_h2, 31); m_h2 += m_h1; m_h2 = m_h2 * 5 + 0x38495ab5;
+}
+
+void TileHasher::add(const void* data, size_t size)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    m_length += size;
+
+    if (m_tailSize > 0) {
+        const size_t n = size < 16 - m_tailSize ? size : 16 - m_tailSize;
+        memcpy(m_tail + m_tailSize, p, n);
+        m_tailSize += n;
+        p += n;
+        size -= n;
+        if (m_tailSize < 16) return;
+        block(loadLE64(m_tail), loadLE64(m_tail + 8));
+        m_tailSize = 0;
+    }
+
+    while (size >= 16) {
+        block(loadLE64(p), loadLE64(p + 8));
+        p += 16;
+        size -= 16;
+    }
+
+    memcpy(m_tail, p, size);
+    m_tailSize = size;
+}
+
+TileDiskCacheKey TileHasher::finish() const
+{
+    uint64_t h1 = m_h1;
+    uint64_t h2 = m_h2;
+
+    uint64_t k1 = 0, k2 = 0;
+    for (size_t i = m_tailSize; i > 8; --i)
+        k2 = (k2 << 8) | m_tail[i - 1];
+    for (size_t i = m_tailSize < 8 ? m_tailSize : 8; i > 0; --i)
+        k1 = (k1 << 8) | m_tail[i - 1];
+    if (m_tailSize > 8) {
+        k2 *= MURMUR_C2; k2 = rotl64(k2, 33); k2 *= MURMUR_C1; h2 ^= k2;
+    }
+    if (m_tailSize > 0) {
+        k1 *= MURMUR_C1; k1 = rotl64(k1, 31); k1 *= MURMUR_C2; h1 ^= k1;
+    }
+
+    h1 ^= m_length;
+    h2 ^= m_length;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    TileDiskCacheKey key;
+    key.h[0] = h1;
+    key.h[1] = h2;
+    return key;
+}
+
+// ================================================
+//       Cache files
+// ================================================
+
+static void tileDiskCachePath(char* path, size_t pathSize, const char* dir, const TileDiskCacheKey& key,
+                          const char* suffix)
+{
+    snprintf(path, pathSize, "%s/%016llx%016llx%s", dir,
+             (unsigned long long)key.h[0], (unsigned long long)key.h[1], suffix);
+}
+
+bool tileDiskCacheLoad(const char* dir, const TileDiskCacheKey& key, int tx, int ty,
+                   unsigned char*& data, int& dataSize)
+{
+    data = 0;
+    dataSize = 0;
+
+    char path[1024];
+    tileDiskCachePath(path, sizeof(path), dir, key, ".tile");
+
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return false;
+
+    TileDiskCacheFileHeader header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        header.magic != TILE_DISK_CACHE_MAGIC ||
+        header.version != TILE_DISK_CACHE_VERSION ||
+        header.key[0] != key.h[0] || header.key[1] != key.h[1] ||
+        header.dataSize < (int)sizeof(dtMeshHeader)) {
+        fclose(fp);
+        return false;
+    }
+
+    unsigned char* tileData = (unsigned char*)dtAlloc(header.dataSize, DT_ALLOC_PERM);
+    if (!tileData) {
+        fclose(fp);
+        return false;
+    }
+
+    const bool complete = fread(tileData, header.dataSize, 1, fp) == 1;
+    fclose(fp);
+
+    const dtMeshHeader* meshHeader = (const dtMeshHeader*)tileData;
+    if (!complete ||
+        meshHeader->magic != DT_NAVMESH_MAGIC ||
+        meshHeader->version != DT_NAVMESH_VERSION ||
+        meshHeader->x != tx || meshHeader->y != ty) {
+        dtFree(tileData);
+        return false;
+    }
+
+    data = tileData;
+    dataSize = header.dataSize;
+    return true;
+}
+
+void tileDiskCacheStore(const char* dir, const TileDiskCacheKey& key,
+                    const unsigned char* data, int dataSize)
+{
+    if (!dir || !data || dataSize <= 0) return;
+
+    char path[1024];
+    char tmpPath[1024];
+    char suffix[64];
+    tileDiskCachePath(path, sizeof(path), dir, key, ".tile");
+    snprintf(suffix, sizeof(suffix), ".%d.tmp", (int)getpid());
+    tileDiskCachePath(tmpPath, sizeof(tmpPath), dir, key, suffix);
+
+    FILE* fp = fopen(tmpPath, "wb");
+    if (!fp) return;
+
+    TileDiskCacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TILE_DISK_CACHE_MAGIC;
+    header.version = TILE_DISK_CACHE_VERSION;
+    header.dataSize = dataSize;
+    header.key[0] = key.h[0];
+    header.key[1] = key.h[1];
+
+    const bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                    fwrite(data, dataSize, 1, fp) == 1;
+    if (fclose(fp) != 0 || !ok || rename(tmpPath, path) != 0)
+        remove(tmpPath);
+}
@@ -0,0 +1,54 @@
+// TileDiskCache.h
+// Content-addressed on-disk cache of built navmesh tiles
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef TILEDISKCACHE_H
+#define TILEDISKCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 128-bit hash of everything a tile build reads
+struct TileDiskCacheKey
+{
+    uint64_t h[2];
+};
+
+// Streaming MurmurHash3 (x64, 128-bit) over the bytes of a tile's input
+class TileHasher
+{
+public:
+    TileHasher();
+
+    void add(const void* data, size_t size);
+
+    template <class T>
+    void addValue(const T& value) { add(&value, sizeof(T)); }
+
+    TileDiskCacheKey finish() const;
+
+private:
+    void block(uint64_t k1, uint64_t k2);
+
+    uint64_t m_h1;
+    uint64_t m_h2;
+    unsigned char m_tail[16];
+    size_t m_tailSize;
+    uint64_t m_length;
+};
+
+// Look up key in dir. On a hit returns true with data (dtAlloc'ed, for
+// addTile with DT_TILE_FREE_DATA) and dataSize; the stored tile is checked
+// to be a valid Detour tile at (tx, ty).
+bool tileDiskCacheLoad(const char* dir, const TileDiskCacheKey& key, int tx, int ty,
+                   unsigned char*& data, int& dataSize);
+
+// Store a built tile under key. The write goes through a temporary file and
+// a rename, so concurrent builders never see a partial entry. Failures are
+// ignored; the tile is simply built again next time.
+void tileDiskCacheStore(const char* dir, const TileDiskCacheKey& key,
+                    const unsigned char* data, int dataSize);
+
+#endif // TILEDISKCACHE_H
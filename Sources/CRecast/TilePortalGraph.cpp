@@ -0,0 +1,445 @@
+// TilePortalGraph.cpp
+// Abstract graph of tile border polygons for hierarchical pathfinding
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#include "TilePortalGraph.h"
+#include "DetourCommon.h"
+
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+
+// Heuristic scale of the graph search, as in dtNavMeshQuery
+static const float PORTAL_H_SCALE = 0.999f;
+
+// Search state of the graph nodes, reused from search to search on a thread.
+// A node is fresh for a search unless its stamp is that search's.
+struct PortalSearchScratch
+{
+    std::vector<float> g;
+    std::vector<float> h;
+    std::vector<unsigned int> parent;
+    std::vector<unsigned int> stamp;
+    unsigned int search = 0;
+
+    void begin(size_t nodes)
+    {
+        if (stamp.size() < nodes) {
+            g.resize(nodes);
+            h.resize(nodes);
+            parent.resize(nodes);
+            stamp.resize(nodes, 0);
+        }
+        if (++search == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0u);
+            search = 1;
+        }
+    }
+};
+
+static thread_local PortalSearchScratch s_scratch;
+
+static const unsigned int NO_NODE = ~0u;
+
+TilePortalGraph::TilePortalGraph(const dtNavMesh* navMesh, const dtQueryFilter& filter) :
+    m_navMesh(navMesh),
+    m_filter(filter),
+    m_builtTiles(0)
+{
+    m_tiles.resize(navMesh ? navMesh->getMaxTiles() : 0);
+}
+
+bool TilePortalGraph::passes(const dtPoly* poly) const
+{
+    // dtQueryFilter::passFilter, which DetourNavMeshQuery.cpp keeps inline
+    return (poly->flags & m_filter.getIncludeFlags()) != 0 && (poly->flags & m_filter.getExcludeFlags()) == 0;
+}
+
+float TilePortalGraph::stepCost(const dtMeshTile* tileA, const dtPoly* a, const float* pa,
+                                const dtMeshTile* tileB, const dtPoly* b, const float* pb) const
+{
+    (void)tileA;
+    (void)tileB;
+    const float areaCost = 0.5f * (m_filter.getAreaCost(a->getArea()) + m_filter.getAreaCost(b->getArea()));
+    return dtVdist(pa, pb) * areaCost;
+}
+
+void TilePortalGraph::buildTile(unsigned int index, Tile& out) const
+{
+    out = Tile();
+    const dtMeshTile* tile = m_navMesh->getTile((int)index);
+    if (!tile || !tile->header) return;
+    out.ref = m_navMesh->getTileRef(tile);
+
+    const int polyCount = tile->header->polyCount;
+    out.centroids.resize((size_t)polyCount * 3);
+    for (int i = 0; i < polyCount; ++i) {
+        const dtPoly* poly = &tile->polys[i];
+        float* c = &out.centroids[(size_t)i * 3];
+        c[0] = c[1] = c[2] = 0.0f;
+        for (int j = 0; j < poly->vertCount; ++j) {
+            dtVadd(c, c, &tile->verts[poly->verts[j] * 3]);
+        }
+        if (poly->vertCount > 0) dtVscale(c, c, 1.0f / poly->vertCount);
+
+        bool portal = poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION;
+        for (int j = 0; j < poly->vertCount && !portal; ++j) {
+            portal = (poly->neis[j] & DT_EXT_LINK) != 0;
+        }
+        if (portal && passes(poly)) {
+            out.portals.push_back((unsigned int)i);
+        }
+    }
+}
+
+void TilePortalGraph::portalCosts(unsigned int index, unsigned int sourcePoly, const float* sourcePos,
+                                  std::vector<float>& costs) const
+{
+    const Tile& entry = m_tiles[index];
+    const dtMeshTile* tile = m_navMesh->getTile((int)index);
+    const int polyCount = tile->header->polyCount;
+
+    std::vector<float> dist(polyCount, FLT_MAX);
+    typedef std::pair<float, unsigned int> Item;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> open;
+    const dtPoly* source = &tile->polys[sourcePoly];
+    dist[sourcePoly] = stepCost(tile, source, sourcePos, tile, source, &entry.centroids[(size_t)sourcePoly * 3]);
+    open.push(Item(dist[sourcePoly], sourcePoly));
+
+    while (!open.empty()) {
+        const Item top = open.top();
+        open.pop();
+        const unsigned int i = top.second;
+        if (top.first > dist[i]) continue;
+        const dtPoly* poly = &tile->polys[i];
+        const float* pi = &entry.centroids[(size_t)i * 3];
+        for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next) {
+            const dtPolyRef ref = tile->links[k].ref;
+            if (m_navMesh->decodePolyIdTile(ref) != index) continue;
+            const unsigned int j = m_navMesh->decodePolyIdPoly(ref);
+            const dtPoly* next = &tile->polys[j];
+            if (!passes(next)) continue;
+            const float d = top.first + stepCost(tile, poly, pi, tile, next, &entry.centroids[(size_t)j * 3]);
+            if (d < dist[j]) {
+                dist[j] = d;
+                open.push(Item(d, j));
+            }
+        }
+    }
+
+    costs.resize(entry.portals.size());
+    for (size_t p = 0; p < entry.portals.size(); ++p) {
+        costs[p] = dist[entry.portals[p]];
+    }
+}
+
+int TilePortalGraph::update(int numThreads)
+{
+    if (!m_navMesh) return 0;
+
+    std::vector<unsigned int> changed;
+    for (unsigned int i = 0; i < m_tiles.size(); ++i) {
+        const dtMeshTile* tile = m_navMesh->getTile((int)i);
+        const dtTileRef ref = tile && tile->header ? m_navMesh->getTileRef(tile) : 0;
+        if (ref != m_tiles[i].ref) changed.push_back(i);
+    }
+    if (changed.empty()) return 0;
+
+    for (unsigned int index : changed) {
+        if (m_tiles[index].ref) m_builtTiles--;
+    }
+
+    // Portals first, then the costs between them, which read centroids
+    auto build = [&](std::vector<unsigned int>::const_iterator first, std::vector<unsigned int>::const_iterator last) {
+        std::vector<float> costs;
+        for (auto it = first; it != last; ++it) {
+            buildTile(*it, m_tiles[*it]);
+        }
+        for (auto it = first; it != last; ++it) {
+            Tile& tile = m_tiles[*it];
+            const size_t n = tile.portals.size();
+            tile.costs.assign(n * n, FLT_MAX);
+            for (size_t p = 0; p < n; ++p) {
+                const float* c = &tile.centroids[(size_t)tile.portals[p] * 3];
+                portalCosts(*it, tile.portals[p], c, costs);
+                memcpy(&tile.costs[p * n], costs.data(), n * sizeof(float));
+            }
+        }
+    };
+
+    int threads = numThreads > 0 ? numThreads : (int)std::thread::hardware_concurrency();
+    threads = std::max(1, std::min(threads, (int)changed.size()));
+    if (threads == 1) {
+        build(changed.begin(), changed.end());
+    } else {
+        // Tiles are independent; workers take them a few at a time
+        const int batch = 4;
+        std::atomic<int> next(0);
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&]() {
+                for (;;) {
+                    const int first = next.fetch_add(batch);
+                    if (first >= (int)changed.size()) break;
+                    const int last = std::min(first + batch, (int)changed.size());
+                    build(changed.begin() + first, changed.begin() + last);
+                }
+            });
+        }
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    for (unsigned int index : changed) {
+        if (m_tiles[index].ref) m_builtTiles++;
+    }
+    linkTiles();
+    return (int)changed.size();
+}
+
+void TilePortalGraph::linkTiles()
+{
+    m_nodeRefs.clear();
+    m_nodeTiles.clear();
+    m_nodePositions.clear();
+    for (unsigned int i = 0; i < m_tiles.size(); ++i) {
+        Tile& tile = m_tiles[i];
+        tile.firstNode = (unsigned int)m_nodeRefs.size();
+        if (!tile.ref) continue;
+        const dtPolyRef base = m_navMesh->getPolyRefBase(m_navMesh->getTile((int)i));
+        for (unsigned int poly : tile.portals) {
+            m_nodeRefs.push_back(base | (dtPolyRef)poly);
+            m_nodeTiles.push_back(i);
+            m_nodePositions.insert(m_nodePositions.end(), &tile.centroids[(size_t)poly * 3],
+                                   &tile.centroids[(size_t)poly * 3] + 3);
+        }
+    }
+
+    std::unordered_map<dtPolyRef, unsigned int> nodes;
+    nodes.reserve(m_nodeRefs.size());
+    for (unsigned int node = 0; node < m_nodeRefs.size(); ++node) {
+        nodes.emplace(m_nodeRefs[node], node);
+    }
+
+    m_linkStart.assign(m_nodeRefs.size() + 1, 0);
+    m_linkTargets.clear();
+    m_linkCosts.clear();
+    for (unsigned int node = 0; node < m_nodeRefs.size(); ++node) {
+        m_linkStart[node] = (unsigned int)m_linkTargets.size();
+        const dtMeshTile* tile = nullptr;
+        const dtPoly* poly = nullptr;
+        m_navMesh->getTileAndPolyByRefUnsafe(m_nodeRefs[node], &tile, &poly);
+        for (unsigned int k = poly->firstLink; k != DT_NULL_LINK; k = tile->links[k].next) {
+            const dtPolyRef ref = tile->links[k].ref;
+            if (m_navMesh->decodePolyIdTile(ref) == m_nodeTiles[node]) continue;
+            auto target = nodes.find(ref);
+            if (target == nodes.end()) continue;
+            const dtMeshTile* nextTile = nullptr;
+            const dtPoly* nextPoly = nullptr;
+            m_navMesh->getTileAndPolyByRefUnsafe(ref, &nextTile, &nextPoly);
+            m_linkTargets.push_back(target->second);
+            m_linkCosts.push_back(stepCost(tile, poly, &m_nodePositions[(size_t)node * 3],
+                                           nextTile, nextPoly, &m_nodePositions[(size_t)target->second * 3]));
+        }
+    }
+    m_linkStart[m_nodeRefs.size()] = (unsigned int)m_linkTargets.size();
+}
+
+dtStatus TilePortalGraph::findPath(dtNavMeshQuery* query, dtPolyRef startRef, dtPolyRef endRef,
+                                   const float* startPos, const float* endPos,
+                                   dtPolyRef* path, int* pathCount, int maxPath, int* expanded) const
+{
+    *pathCount = 0;
+    if (expanded) *expanded = 0;
+    if (!query || !m_navMesh || !path || maxPath <= 0) return DT_FAILURE | DT_INVALID_PARAM;
+    if (!m_navMesh->isValidPolyRef(startRef) || !m_navMesh->isValidPolyRef(endRef)) {
+        return DT_FAILURE | DT_INVALID_PARAM;
+    }
+
+    const unsigned int startTile = m_navMesh->decodePolyIdTile(startRef);
+    const unsigned int endTile = m_navMesh->decodePolyIdTile(endRef);
+    const dtMeshTile* st = m_navMesh->getTile((int)startTile);
+    const dtMeshTile* et = m_navMesh->getTile((int)endTile);
+    const bool nearby = abs(st->header->x - et->header->x) <= 1 && abs(st->header->y - et->header->y) <= 1;
+    // Tiles the graph has not caught up with yet are searched directly too
+    if (nearby || m_tiles[startTile].ref != m_navMesh->getTileRef(st) ||
+        m_tiles[endTile].ref != m_navMesh->getTileRef(et)) {
+        return query->findPath(startRef, endRef, startPos, endPos, &m_filter, path, pathCount, maxPath);
+    }
+
+    std::vector<float> startCosts, endCosts;
+    portalCosts(startTile, m_navMesh->decodePolyIdPoly(startRef), startPos, startCosts);
+    portalCosts(endTile, m_navMesh->decodePolyIdPoly(endRef), endPos, endCosts);
+
+    // A* over portals, with the start and end positions as two extra nodes
+    const unsigned int nodeCount = (unsigned int)m_nodeRefs.size();
+    const unsigned int startNode = nodeCount;
+    const unsigned int endNode = nodeCount + 1;
+    const Tile& startEntry = m_tiles[startTile];
+    const Tile& endEntry = m_tiles[endTile];
+    PortalSearchScratch& scratch = s_scratch;
+    scratch.begin(nodeCount + 2);
+
+    struct Item
+    {
+        float f;
+        float g;
+        unsigned int node;
+        bool operator>(const Item& other) const { return f > other.f; }
+    };
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> open;
+
+    auto position = [&](unsigned int node) -> const float* {
+        if (node == startNode) return startPos;
+        if (node == endNode) return endPos;
+        return &m_nodePositions[(size_t)node * 3];
+    };
+    auto relax = [&](unsigned int from, unsigned int node, float g) {
+        if (scratch.stamp[node] != scratch.search) {
+            scratch.stamp[node] = scratch.search;
+            scratch.h[node] = dtVdist(position(node), endPos) * PORTAL_H_SCALE;
+        } else if (g >= scratch.g[node]) {
+            return;
+        }
+        scratch.g[node] = g;
+        scratch.parent[node] = from;
+        open.push({ g + scratch.h[node], g, node });
+    };
+
+    relax(NO_NODE, startNode, 0.0f);
+    unsigned int goal = NO_NODE;
+    unsigned int closest = startNode;   // The expanded node nearest the end, where a partial path stops
+    float closestDist = scratch.h[startNode];
+    int expandedCount = 0;
+
+    while (!open.empty()) {
+        const Item top = open.top();
+        open.pop();
+        const unsigned int current = top.node;
+        if (top.g > scratch.g[current]) continue;   // Superseded by a cheaper route
+        if (current == endNode) {
+            goal = current;
+            break;
+        }
+        expandedCount++;
+        if (scratch.h[current] < closestDist) {
+            closest = current;
+            closestDist = scratch.h[current];
+        }
+
+        if (current == startNode) {
+            for (size_t p = 0; p < startCosts.size(); ++p) {
+                if (startCosts[p] < FLT_MAX) relax(current, startEntry.firstNode + (unsigned int)p, startCosts[p]);
+            }
+            continue;
+        }
+
+        const Tile& tile = m_tiles[m_nodeTiles[current]];
+        const unsigned int portal = current - tile.firstNode;
+        const size_t n = tile.portals.size();
+        const float* costs = &tile.costs[portal * n];
+        for (size_t p = 0; p < n; ++p) {
+            if (p != portal && costs[p] < FLT_MAX) relax(current, tile.firstNode + (unsigned int)p, top.g + costs[p]);
+        }
+        if (&tile == &endEntry && endCosts[portal] < FLT_MAX) {
+            relax(current, endNode, top.g + endCosts[portal]);
+        }
+        for (unsigned int k = m_linkStart[current]; k < m_linkStart[current + 1]; ++k) {
+            relax(current, m_linkTargets[k], top.g + m_linkCosts[k]);
+        }
+    }
+    if (expanded) *expanded = expandedCount;
+    if (goal == NO_NODE && closest == startNode) {
+        return query->findPath(startRef, endRef, startPos, endPos, &m_filter, path, pathCount, maxPath);
+    }
+
+    // Portals from start to end, or to the one nearest an unreachable end
+    std::vector<unsigned int> route;
+    for (unsigned int i = goal != NO_NODE ? goal : closest; i != NO_NODE; i = scratch.parent[i]) route.push_back(i);
+    std::reverse(route.begin(), route.end());
+
+    auto polyRef = [&](unsigned int node) -> dtPolyRef {
+        if (node == startNode) return startRef;
+        if (node == endNode) return endRef;
+        return m_nodeRefs[node];
+    };
+
+    // Refine every stretch within a tile; stretches between tiles are a single link
+    std::vector<dtPolyRef> segment(std::max(maxPath, 256));
+    int count = 0;
+    dtStatus status = DT_SUCCESS;
+    path[count++] = startRef;
+    if (goal == NO_NODE) {
+        route.push_back(endNode);
+        status |= DT_PARTIAL_RESULT;
+    }
+    for (size_t i = 0; i + 1 < route.size(); ++i) {
+        const dtPolyRef a = polyRef(route[i]);
+        const dtPolyRef b = polyRef(route[i + 1]);
+        if (a == b) continue;
+        int n = 0;
+        if (goal == NO_NODE && i + 2 == route.size()) {
+            // As close to the end as the portal nearest it gets
+            query->findPath(a, b, position(route[i]), endPos, &m_filter, segment.data(), &n, (int)segment.size());
+        } else if (m_navMesh->decodePolyIdTile(a) != m_navMesh->decodePolyIdTile(b)) {
+            segment[0] = a;
+            segment[1] = b;
+            n = 2;
+        } else {
+            const dtStatus s = query->findPath(a, b, position(route[i]), position(route[i + 1]), &m_filter,
+                                               segment.data(), &n, (int)segment.size());
+            if (dtStatusFailed(s) || n == 0 || segment[n - 1] != b) {
+                // The stretch did not resolve within the query's node pool,
+                // or a tile on it changed since the last update
+                return query->findPath(startRef, endRef, startPos, endPos, &m_filter, path, pathCount, maxPath);
+            }
+        }
+        for (int j = 1; j < n; ++j) {
+            if (count == maxPath) {
+                status |= DT_BUFFER_TOO_SMALL;
+                break;
+            }
+            path[count++] = segment[j];
+        }
+        if (status & DT_BUFFER_TOO_SMALL) break;
+    }
+    *pathCount = count;
+    return status;
+}
+
+int TilePortalGraph::edgeCount() const
+{
+    int edges = 0;
+    for (const Tile& tile : m_tiles) {
+        for (float c : tile.costs) {
+            if (c < FLT_MAX) edges++;
+        }
+        edges -= (int)tile.portals.size();  // The diagonal
+    }
+    return edges + (int)m_linkTargets.size();
+}
+
+size_t TilePortalGraph::memoryUsage() const
+{
+    size_t bytes = m_tiles.capacity() * sizeof(Tile);
+    for (const Tile& tile : m_tiles) {
+        bytes += tile.portals.capacity() * sizeof(unsigned int);
+        bytes += tile.centroids.capacity() * sizeof(float);
+        bytes += tile.costs.capacity() * sizeof(float);
+    }
+    bytes += m_nodeRefs.capacity() * sizeof(dtPolyRef);
+    bytes += m_nodeTiles.capacity() * sizeof(unsigned int);
+    bytes += m_nodePositions.capacity() * sizeof(float);
+    bytes += m_linkStart.capacity() * sizeof(unsigned int);
+    bytes += m_linkTargets.capacity() * sizeof(unsigned int);
+    bytes += m_linkCosts.capacity() * sizeof(float);
+    return bytes;
+}
@@ -0,0 +1,95 @@
+// TilePortalGraph.h
+// Abstract graph of tile border polygons for hierarchical pathfinding
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef TILEPORTALGRAPH_H
+#define TILEPORTALGRAPH_H
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// A coarse graph over a tiled navmesh for long searches.
+//
+// Its nodes are the portal polygons of every tile: those with an edge on the
+// tile border, and off-mesh connections. Within a tile every pair of portals
+// is joined by the cost of the cheapest route between them through that tile,
+// found once per tile with Dijkstra over polygon centroids. Between tiles,
+// portals are joined through the navmesh's links, read again on every update,
+// so neighbours coming and going need no rebuild of the tiles around them.
+//
+// findPath searches this graph for the portals a path goes through and then
+// refines each stretch inside a tile with the ordinary A* of a dtNavMeshQuery,
+// so no single search expands more than about a tile's worth of nodes.
+// Costs are those of the filter the graph was built with.
+class TilePortalGraph
+{
+public:
+    TilePortalGraph(const dtNavMesh* navMesh, const dtQueryFilter& filter);
+
+    // Rebuild the tiles that were added, removed or replaced since the last
+    // update, on numThreads threads (0 = one per core). Returns how many.
+    int update(int numThreads);
+
+    // The corridor from startRef to endRef, like dtNavMeshQuery::findPath.
+    // Searches between the same or neighbouring tiles go straight to query;
+    // so do those the graph cannot resolve, such as an unreachable end, which
+    // then come back partial. expanded receives the graph nodes the search
+    // expanded. Safe to call from several threads with their own queries as
+    // long as update does not run at the same time.
+    dtStatus findPath(dtNavMeshQuery* query, dtPolyRef startRef, dtPolyRef endRef,
+                      const float* startPos, const float* endPos,
+                      dtPolyRef* path, int* pathCount, int maxPath, int* expanded) const;
+
+    int tileCount() const { return m_builtTiles; }
+    int nodeCount() const { return (int)m_nodeRefs.size(); }
+    int edgeCount() const;
+    size_t memoryUsage() const;
+
+private:
+    struct Tile
+    {
+        dtTileRef ref = 0;
+        std::vector<unsigned int> portals;  // Polygon index of every portal in the tile
+        std::vector<float> centroids;       // x, y, z per polygon of the tile
+        std::vector<float> costs;           // Portal to portal, FLT_MAX where unreachable
+        unsigned int firstNode = 0;         // Graph node of the first portal
+    };
+
+    void buildTile(unsigned int index, Tile& out) const;
+
+    // Number the portals of every tile and join them across tile borders
+    void linkTiles();
+
+    // Cost from sourcePos in sourcePoly to the centroid of every portal of
+    // tile index through polygons of that tile only
+    void portalCosts(unsigned int index, unsigned int sourcePoly, const float* sourcePos,
+                     std::vector<float>& costs) const;
+
+    bool passes(const dtPoly* poly) const;
+
+    float stepCost(const dtMeshTile* tileA, const dtPoly* a, const float* pa,
+                   const dtMeshTile* tileB, const dtPoly* b, const float* pb) const;
+
+    const dtNavMesh* m_navMesh;
+    dtQueryFilter m_filter;
+    std::vector<Tile> m_tiles;
+
+    // Per graph node, in tile order
+    std::vector<dtPolyRef> m_nodeRefs;
+    std::vector<unsigned int> m_nodeTiles;
+    std::vector<float> m_nodePositions;
+    // Links between tiles, grouped by source node from m_linkStart[node]
+    std::vector<unsigned int> m_linkStart;
+    std::vector<unsigned int> m_linkTargets;
+    std::vector<float> m_linkCosts;
+    int m_builtTiles;
+};
+
+#endif // TILEPORTALGRAPH_H
@@ -5,14 +5,20 @@
 #include <stdint.h>
 #include "Recast.h"
 #include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 // Constants for navmesh file format
-#define NAVMESHSET_MAGIC    'M'<<24 | 'S'<<16 | 'E'<<8 | 'T'
-#define NAVMESHSET_VERSION  1
+#define NAVMESHSET_MAGIC    ('M'<<24 | 'S'<<16 | 'E'<<8 | 'T')
+#define NAVMESHSET_VERSION  2
+// Version 1 sets store every tile as it is right after its rcNavMeshTileHeader.
+// Pre-linked sets keep that layout.
+#define NAVMESHSET_VERSION_RAW  1
+// A set whose tiles keep the links of the navmesh it was saved from
+#define NAVMESHSET_PRELINKED_MAGIC  ('M'<<24 | 'S'<<16 | 'P'<<8 | 'L')
 
 typedef enum {
     BCODE_OK = 0,
@@ -28,12 +34,48 @@ typedef enum {
     BD_ERR_VERTICES = 1,
     BD_ERR_BUILD_NAVMESH = 2,
     BD_ERR_ALLOC_NAVMESH = 3,
-    BD_ERR_INVALID_PARAM = 4
+    BD_ERR_INVALID_PARAM = 4,
+    BD_ERR_WRITE = 5
 } BDetourStatus;
 
+typedef enum {
+    BOBJ_OK = 0,
+    BOBJ_ERR_IO = 1,        // The file could not be opened or read
+    BOBJ_ERR_FORMAT = 2,    // A "v" line with fewer than three coordinates
+    BOBJ_ERR_MEMORY = 3
+} BObjStatus;
+
 // Tile configuration
 struct TileConfig {
     int tileSize;           // Size of each tile in voxels
+    int numThreads;         // Worker threads for tile builds (0 = one per core, 1 = serial)
+    int regionThreads;      // Threads splitting each tile's distance field and watershed regions
+                            // (0 = the build's threads for single-tile builds, 1 otherwise)
+};
+
+// Statistics for one tile build
+struct BindingTileStats {
+    int tx;
+    int ty;
+    double buildTimeMs;     // Wall-clock time of the tile build
+    int heightfieldSpans;   // Walkable spans in the solid heightfield after filtering
+    int compactSpans;       // Spans in the compact heightfield
+    int regions;            // Regions after partitioning
+    int contours;
+    int polys;              // Polygons in the tile's poly mesh
+    int detailTris;         // Triangles in the detail mesh
+    int dataSize;           // Bytes of Detour tile data, 0 if the tile came out empty
+    int fromCache;          // 1 if the tile was loaded from the tile cache instead of built
+    int layers;             // Detour tiles the tile ends up as: one per layer with BUILD_TILE_LAYERS
+    int reusedLayers;       // Layers left in place because their input was unchanged
+};
+
+// Statistics for a whole build
+struct BindingBuildStats {
+    double totalTimeMs;                 // Wall-clock time of the build call
+    double timerMs[RC_MAX_TIMERS];      // Accumulated time per rcTimerLabel, summed over worker threads
+    int numTileStats;
+    struct BindingTileStats* tileStats; // One entry per tile attempted, in build order
 };
 
 // Result structure for tiled mesh building
@@ -42,6 +84,7 @@ struct BindingTileMeshResult {
     dtNavMesh* navMesh;     // The multi-tile navigation mesh
     int tilesBuilt;         // Number of tiles successfully built
     int totalTiles;         // Total number of tiles
+    struct BindingBuildStats stats;
 };
 
 // Filter flags
@@ -54,7 +97,17 @@ enum {
     PARTITION_MASK = 24,
     PARTITION_WATERSHED = 8,
     PARTITION_MONOTONE = 16,
-    PARTITION_LAYER = 0
+    PARTITION_LAYER = 0,
+    
+    // Leave detail meshes out of the tiles; polygon planes give the heights
+    // until bindingCreateLazyDetail builds them on demand
+    BUILD_LAZY_DETAIL_MESH = 32,
+    
+    // Split every tile into the heightfield layers the tile cache uses, one
+    // Detour tile per layer, so stacked floors are built and replaced apart.
+    // Rebuilds keep the tiles of layers whose input did not change. Layers
+    // link to each other where they meet, within a tile and across its edges.
+    BUILD_TILE_LAYERS = 64
 };
 
 // New API that takes raw geometry for areas
@@ -97,13 +150,476 @@ struct BindingTileMeshResult* bindingBuildTiledNavMesh(
 // Release tiled navmesh result
 void bindingReleaseTiledNavMesh(BindingTileMeshResult* result);
 
-// Export tiled navmesh to binary format
+// What bindingCleanGeometry removed
+struct BindingGeometryCleanupStats {
+    int inputVertices;
+    int inputTriangles;
+    int outputVertices;
+    int outputTriangles;
+    int weldedVertices;         // Merged into an earlier vertex within the tolerance
+    int unusedVertices;         // Used by no remaining triangle
+    int degenerateTriangles;    // Zero area, or repeated or out-of-range indices
+    int duplicateTriangles;     // Over the same three vertices as an earlier one
+    int steepTriangles;         // Too steep to ever be walkable
+};
+
+// Build input geometry after bindingCleanGeometry; arrays are malloc'ed
+struct BindingCleanGeometry {
+    float* vertices;            // x, y, z per vertex
+    int32_t* triangles;         // Three vertex indices per triangle
+    int vertexCount;
+    int triangleCount;
+    struct BindingGeometryCleanupStats stats;
+};
+
+// Prepare geometry for a build: weld vertices closer than weldTolerance (0 =
+// only identical positions) into the first of them, drop degenerate triangles,
+// with removeDuplicates all but the most upward-facing of triangles over the
+// same vertices, with walkableSlopeAngle > 0 the triangles steeper than that,
+// and then the vertices no triangle uses. Remaining vertices and triangles
+// keep their input order and winding. Returns 0 when out of memory. Release
+// result with bindingReleaseCleanGeometry, also after a failure.
+int bindingCleanGeometry(const float* verts, int nverts, const int32_t* tris, int ntris,
+                         float weldTolerance, int removeDuplicates, float walkableSlopeAngle,
+                         struct BindingCleanGeometry* result);
+
+void bindingReleaseCleanGeometry(struct BindingCleanGeometry* result);
+
+// Retained build input for incremental tile rebuilds. Owns copies of the
+// geometry, the area meshes and the configuration, plus their spatial indices.
+typedef struct BindingTileBuildInput BindingTileBuildInput;
+
+// Copy the build input. Returns null on invalid parameters or allocation failure.
+BindingTileBuildInput* bindingCreateTileBuildInput(
+    const rcConfig* config,
+    const TileConfig* tileConfig,
+    int flags,
+    const float* verts,
+    int numVerts,
+    const int* tris,
+    int numTris,
+    const float** areaVerts,      // Array of vertex arrays for each area
+    const int* areaVertCounts,    // Number of vertices for each area
+    const int** areaTris,         // Array of triangle arrays for each area
+    const int* areaTriCounts,     // Number of triangles for each area
+    const unsigned char* areaCodes,
+    int numAreaMeshes,
+    float agentHeight,
+    float agentRadius,
+    float agentMaxClimb
+);
+
+void bindingReleaseTileBuildInput(BindingTileBuildInput* input);
+
+// Replace the retained geometry or area meshes. The tile grid stays fixed;
+// rebuild the affected tiles afterwards.
+BCodeStatus bindingUpdateTileBuildGeometry(
+    BindingTileBuildInput* input,
+    const float* verts,
+    int numVerts,
+    const int* tris,
+    int numTris
+);
+
+BCodeStatus bindingUpdateTileBuildAreas(
+    BindingTileBuildInput* input,
+    const float** areaVerts,
+    const int* areaVertCounts,
+    const int** areaTris,
+    const int* areaTriCounts,
+    const unsigned char* areaCodes,
+    int numAreaMeshes
+);
+
+// Build every tile of the retained input into a new navmesh
+struct BindingTileMeshResult* bindingBuildTiledNavMeshFromInput(BindingTileBuildInput* input);
+
+// Get the inclusive tile range overlapping a world-space box in xz. With
+// includeBorder, tiles whose border region overlaps the box are included too.
+// Returns 0 if the box misses the tile grid.
+int bindingGetTileRangeInBounds(
+    const BindingTileBuildInput* input,
+    const float* bmin,
+    const float* bmax,
+    int includeBorder,
+    int* minx,
+    int* miny,
+    int* maxx,
+    int* maxy
+);
+
+// Rebuild tiles given as (x, y) pairs and swap them into navMesh.
+// Tiles that build empty are removed. With BUILD_TILE_LAYERS only the layers
+// that changed are replaced. tilesBuilt receives the tiles added.
+// If stats is not null it receives the rebuild statistics; release them with
+// bindingReleaseBuildStats.
+BCodeStatus bindingRebuildTiles(
+    BindingTileBuildInput* input,
+    dtNavMesh* navMesh,
+    const int* tileCoords,
+    int numTiles,
+    int* tilesBuilt,
+    struct BindingBuildStats* stats
+);
+
+// Keep built tiles in dir, keyed by a hash of each tile's input (overlapping
+// triangles, area polygons, config and flags). Later builds and rebuilds from
+// this input load unchanged tiles from there instead of building them.
+// The directory must exist. Pass null to turn the cache off.
+void bindingSetTileCacheDirectory(BindingTileBuildInput* input, const char* dir);
+
+// Remove the tile at (tx, ty) from navMesh, every layer of it
+BDetourStatus bindingRemoveTile(dtNavMesh* navMesh, int tx, int ty);
+
+// Streaming builds: start from an empty navmesh, build tiles one at a time on
+// any thread and add each one as soon as it is done.
+
+// Size of the input's tile grid
+void bindingGetTileGridSize(const BindingTileBuildInput* input, int* tw, int* th);
+
+// Sort (x, y) tile pairs in place by xz distance from focus to the tile centre, nearest first
+void bindingSortTilesByDistance(
+    const BindingTileBuildInput* input,
+    const float* focus,
+    int* tileCoords,
+    int numTiles
+);
+
+// Allocate an empty navmesh sized for the input's tile grid. Returns null on failure;
+// code (optional) receives the reason.
+dtNavMesh* bindingCreateTiledNavMesh(const BindingTileBuildInput* input, BCodeStatus* code);
+
+// Build tile (tx, ty) without adding it to any navmesh. Calls for different tiles
+// may run concurrently as long as the input is not updated meanwhile.
+// The tile is built whole, as a single layer, even with BUILD_TILE_LAYERS.
+// Returns null if the tile came out empty. stats (optional) receives the tile's statistics.
+unsigned char* bindingBuildTileData(
+    BindingTileBuildInput* input,
+    int tx,
+    int ty,
+    int* dataSize,
+    struct BindingTileStats* stats
+);
+
+// Replace the tile at the data's coordinates, every layer of it. navMesh takes ownership of data,
+// which is freed if it cannot be added.
+BCodeStatus bindingAddTileData(dtNavMesh* navMesh, unsigned char* data, int dataSize);
+
+// Free tile data that was never handed to bindingAddTileData
+void bindingFreeTileData(unsigned char* data);
+
+// Tile cache navmesh: tiles are kept as compressed heightfield layers
+// (DetourTileCache) and rebuilt from them when temporary obstacles change,
+// without going back to the triangles. Not thread-safe; the navmesh is only
+// modified by bindingTileCacheUpdate.
+typedef struct BindingTileCacheMesh BindingTileCacheMesh;
+
+struct BindingTileCacheStats {
+    int tiles;              // Navmesh tiles built from the layers
+    int layers;             // Compressed layers kept by the tile cache
+    int compressedSize;     // Bytes of compressed layer data
+    int uncompressedSize;   // Bytes of the same layers uncompressed
+    double buildTimeMs;     // Wall-clock time of bindingCreateTileCacheMesh
+};
+
+// Build every tile of the input as layers and the initial navmesh from them.
+// The input's tile size plus twice its border must not exceed 255 cells.
+// Returns null on failure; code (optional) receives the reason.
+BindingTileCacheMesh* bindingCreateTileCacheMesh(
+    BindingTileBuildInput* input,
+    int maxObstacles,
+    BCodeStatus* code
+);
+
+void bindingReleaseTileCacheMesh(BindingTileCacheMesh* mesh);
+
+// The navmesh kept up to date by the tile cache; owned by mesh
+dtNavMesh* bindingTileCacheGetNavMesh(BindingTileCacheMesh* mesh);
+
+void bindingTileCacheGetStats(const BindingTileCacheMesh* mesh, struct BindingTileCacheStats* stats);
+
+// Obstacles take effect on the next bindingTileCacheUpdate. The add functions
+// return the obstacle's reference, or 0 if the tile cache is out of obstacles.
+uint32_t bindingTileCacheAddCylinderObstacle(BindingTileCacheMesh* mesh, const float* pos,
+                                             float radius, float height);
+uint32_t bindingTileCacheAddBoxObstacle(BindingTileCacheMesh* mesh, const float* bmin, const float* bmax);
+uint32_t bindingTileCacheAddOrientedBoxObstacle(BindingTileCacheMesh* mesh, const float* center,
+                                                const float* halfExtents, float yRadians);
+BDetourStatus bindingTileCacheRemoveObstacle(BindingTileCacheMesh* mesh, uint32_t ref);
+
+// Rebuild the tiles touched by obstacle changes, at most maxTileUpdates of
+// them (0 = all). upToDate receives 1 when no change is left pending.
+BDetourStatus bindingTileCacheUpdate(BindingTileCacheMesh* mesh, int maxTileUpdates, int* upToDate);
+
+// Multi-agent builds: one navmesh per agent profile from a single
+// rasterization of every tile. Each profile filters, erodes, partitions and
+// triangulates on its own; the profiles share the input's cell size, slope
+// and tile size. Agent dimensions are in world units and converted to voxels
+// like the regular build does (height and radius rounded up, climb down).
+struct BindingAgentProfile {
+    float height;
+    float radius;
+    float maxClimb;
+};
+
+struct BindingMultiAgentResult {
+    BCodeStatus code;
+    int numProfiles;
+    int totalTiles;             // Tiles per navmesh
+    dtNavMesh** navMeshes;      // One per profile; owned by the result until taken
+    int* tilesBuilt;            // Non-empty tiles per profile
+    // Stage timings of the whole build; tileStats holds totalTiles entries
+    // per profile, profile after profile
+    struct BindingBuildStats stats;
+};
+
+// Build every tile of the retained input for each of the profiles.
+// The input's tile cache directory is not used. Returns null if out of memory.
+struct BindingMultiAgentResult* bindingBuildTiledNavMeshesForAgents(
+    BindingTileBuildInput* input,
+    const struct BindingAgentProfile* profiles,
+    int numProfiles
+);
+
+// Hand the navmesh of a profile over to the caller, who frees it with dtFreeNavMesh
+dtNavMesh* bindingMultiAgentTakeNavMesh(struct BindingMultiAgentResult* result, int profile);
+
+void bindingReleaseMultiAgentResult(struct BindingMultiAgentResult* result);
+
+// Lazy detail meshes: for a navmesh built from input with
+// BUILD_LAZY_DETAIL_MESH, rebuild a tile's detail mesh the first time a query
+// or crowd samples heights on it, and keep the most recently used ones.
+// Attaching and evicting happen inside queries and change the tiles, so a
+// navmesh with lazy detail must not be queried from several threads at once.
+// A tile whose rebuilt polygons differ from the live ones (say the input
+// changed and the tile was not rebuilt) keeps its polygon-plane heights.
+// Serialized tile data never contains the attached detail meshes.
+typedef struct BindingLazyDetail BindingLazyDetail;
+
+struct BindingLazyDetailStats {
+    int cachedTiles;        // Tiles with a detail mesh attached
+    int builds;             // Detail meshes built so far
+    int evictions;          // Detail meshes dropped to make room
+    int failures;           // Tiles left on polygon-plane heights
+    int cachedBytes;        // Bytes held by the attached detail meshes
+};
+
+// Install a provider on navMesh that builds detail meshes from input, keeping
+// at most maxCachedTiles of them (0 = no limit). The input and navMesh must
+// outlive it. Returns null on invalid parameters or if navMesh already has a
+// detail provider.
+BindingLazyDetail* bindingCreateLazyDetail(
+    BindingTileBuildInput* input,
+    dtNavMesh* navMesh,
+    int maxCachedTiles
+);
+
+// Detach the provider, put the polygon-plane heights back on the tiles and
+// free the detail meshes. Call it before freeing the navmesh.
+void bindingReleaseLazyDetail(BindingLazyDetail* lazy);
+
+void bindingLazyDetailGetStats(const BindingLazyDetail* lazy, struct BindingLazyDetailStats* stats);
+
+// Free the per-tile entries of stats filled by bindingRebuildTiles
+void bindingReleaseBuildStats(struct BindingBuildStats* stats);
+
+// Short name of an rcTimerLabel, e.g. "rasterizeTriangles", or null if out of range
+const char* bindingTimerLabelName(int label);
+
+// Export tiled navmesh to binary format, as a version 1 set with uncompressed tiles
 BDetourStatus bindingExportTiledNavMesh(
     const dtNavMesh* navMesh,
     void** result,
     int* resultSize
 );
 
+// Export tiled navmesh as a version 2 set: a table of tile offsets, sizes and
+// checksums, then every tile LZ4-compressed (stored as it is when that does
+// not make it smaller). The compression is lossless.
+BDetourStatus bindingExportCompressedNavMesh(
+    const dtNavMesh* navMesh,
+    void** result,
+    int* resultSize
+);
+
+// Receives the bytes of a navmesh being written, in order. Returns nonzero if
+// it took them all, 0 to stop the write with BD_ERR_WRITE.
+typedef int (*BindingWriteFn)(void* context, const void* data, int size);
+
+// A BindingWriteFn for a file descriptor: context points to the int fd
+int bindingWriteFileDescriptor(void* context, const void* data, int size);
+
+// bindingExportTiledNavMesh through write, with no copy of the tiles: the
+// header, then each tile straight from navMesh
+BDetourStatus bindingWriteTiledNavMesh(
+    const dtNavMesh* navMesh,
+    BindingWriteFn write,
+    void* context
+);
+
+// bindingExportCompressedNavMesh through write, with the same bytes. Each tile
+// is compressed twice, once for the table at the start and once to write it,
+// so no more than one compressed tile is held at a time.
+BDetourStatus bindingWriteCompressedNavMesh(
+    const dtNavMesh* navMesh,
+    BindingWriteFn write,
+    void* context
+);
+
+// Export tiled navmesh in the pre-linked format: the tile data as it is in
+// navMesh, links included, for bindingLoadPrelinkedNavMesh. The layout is
+// the one of bindingExportTiledNavMesh.
+BDetourStatus bindingExportPrelinkedNavMesh(
+    const dtNavMesh* navMesh,
+    void** result,
+    int* resultSize
+);
+
+// Create a navmesh over pre-linked set data without copying or writing it,
+// so the data can be a read-only mapping shared between processes. Setup is
+// a pointer fix-up per tile in the navmesh's own memory. The data must be
+// 4-byte aligned and outlive the navmesh. The tiles cannot be removed or have
+// their polygon flags or areas changed (DT_TILE_PRELINKED).
+dtStatus bindingLoadPrelinkedNavMesh(const void* data, int64_t dataSize, dtNavMesh** result);
+
+// Load a tiled navmesh exported by bindingExportTiledNavMesh,
+// bindingExportCompressedNavMesh or bindingExportPrelinkedNavMesh. The data is copied and can be freed
+// afterwards. Compressed tiles are decompressed and checked on numThreads
+// threads (0 = one per core) straight into their tile buffers.
+dtStatus bindingImportNavMeshSet(const void* data, int dataSize, int numThreads, dtNavMesh** result);
+
+// Export tiled navmesh in the indexed format: a table of every tile's
+// coordinates, file offset and size, then the tiles, so a reader can load
+// any subset of them.
+BDetourStatus bindingExportIndexedNavMesh(
+    const dtNavMesh* navMesh,
+    void** result,
+    int64_t* resultSize
+);
+
+// Region-streamed navmesh over an indexed file: only the tiles near a focus
+// point are resident. Tiles are read on a background thread and added or
+// removed by bindingTileStreamUpdate, which must be called from the thread
+// that queries the navmesh. Tile refs are the ones in the file, so a
+// tile that is unloaded and loaded again keeps its polygon refs.
+typedef struct BindingTileStream BindingTileStream;
+
+struct BindingTileStreamStats {
+    int totalTiles;         // Tiles in the file
+    int residentTiles;      // Tiles in the navmesh
+    int pendingTiles;       // Tiles queued, being read, or read but not added yet
+    int residentBytes;      // Tile data held by the navmesh
+    int loads;              // Tiles added so far
+    int unloads;            // Tiles removed so far
+    int failures;           // Tiles that could not be read or added; not retried
+    int budgetSkipped;      // Tiles in range left out by the latest update to keep within budget
+};
+
+// Open an indexed navmesh file with an empty navmesh. Resident plus pending
+// tile data is kept within memoryBudget bytes (0 = no limit). Returns null on
+// failure; status (optional) receives the reason.
+BindingTileStream* bindingOpenTileStream(const char* path, int64_t memoryBudget, dtStatus* status);
+
+// Stop the reader and free the navmesh
+void bindingCloseTileStream(BindingTileStream* stream);
+
+// The navmesh tiles are streamed into; owned by stream
+dtNavMesh* bindingTileStreamGetNavMesh(BindingTileStream* stream);
+
+// Remove tiles farther than unloadRadius from focus (xz distance to the tile
+// bounds), queue the missing tiles within loadRadius nearest first, and add
+// up to maxTileAdds tiles that have been read since (0 = all of them).
+// unloadRadius below loadRadius is raised to it. Returns the number of tiles added.
+int bindingTileStreamUpdate(BindingTileStream* stream, const float* focus,
+                            float loadRadius, float unloadRadius, int maxTileAdds);
+
+// Wait until every queued tile has been read, then add them all.
+// Returns the number of tiles added.
+int bindingTileStreamFlush(BindingTileStream* stream);
+
+void bindingTileStreamGetStats(BindingTileStream* stream, struct BindingTileStreamStats* stats);
+
+// Vertices and triangles read from a Wavefront OBJ file
+struct BindingObjMesh {
+    float* vertices;        // x, y, z per vertex
+    int32_t* triangles;     // Three zero-based vertex indices per triangle
+    int vertexCount;
+    int triangleCount;
+    int fromCache;          // 1 if loaded from the geometry cache
+};
+
+// Parse OBJ text on numThreads threads (0 = one per core). Only vertices and
+// faces are read; faces are fanned into triangles and ones referring to
+// vertices not defined before them are dropped. Release mesh with
+// bindingReleaseObjMesh, also after a failure.
+BObjStatus bindingParseObjMesh(const char* text, int64_t size, int numThreads,
+                               struct BindingObjMesh* mesh);
+
+// bindingParseObjMesh over a memory-mapped file. With cachePath, the mesh is
+// read from that geometry cache instead when it was written for the file's
+// current size and modification time, and written there after parsing
+// otherwise.
+BObjStatus bindingLoadObjMesh(const char* path, const char* cachePath, int numThreads,
+                              struct BindingObjMesh* mesh);
+
+void bindingReleaseObjMesh(struct BindingObjMesh* mesh);
+
+// Straight paths for a batch of start and end positions, all with one filter.
+// For each item index i in items, the start and end (starts[i*3], ends[i*3])
+// are snapped to the nearest polygon within extents, the corridor of at most
+// maxPolys polygons between them is found and string-pulled into at most
+// maxPoints corners. The corners go to points[i * maxPoints * 3], their number
+// to pointCounts[i] and the status of the search to statuses[i]; a failed
+// item has no corners. One corridor buffer serves the whole batch.
+void bindingFindStraightPaths(dtNavMeshQuery* query, const dtQueryFilter* filter,
+                              const float* starts, const float* ends,
+                              const int* items, int itemCount, const float* extents,
+                              int maxPolys, int maxPoints, int options,
+                              float* points, int* pointCounts, dtStatus* statuses);
+
+// 1 if every polygon of refs is still in the navmesh query searches and
+// has flags filter includes, 0 once a tile one of them was in has been
+// removed or replaced, or one of them has flags the filter now excludes
+int bindingPolyRefsValid(const dtNavMeshQuery* query, const dtQueryFilter* filter,
+                         const dtPolyRef* refs, int count);
+
+// Hierarchical planner over the tiles of a navmesh for long paths. It keeps
+// a graph of the polygons on tile borders with the cost of crossing each
+// tile between them, searches that for the tiles a path goes through and
+// refines the path one tile at a time with an ordinary query. Costs are
+// those of the filter the planner was created with.
+typedef struct BindingPathPlanner BindingPathPlanner;
+
+struct BindingPathPlannerStats {
+    int tiles;              // Tiles in the graph
+    int nodes;              // Border polygons and off-mesh connections
+    int edges;              // Connections between them, within and across tiles
+    int64_t bytes;          // Memory held by the graph
+};
+
+// A planner for navMesh with a copy of filter and a graph of the tiles the
+// navmesh has now, built on numThreads threads (0 = one per core)
+BindingPathPlanner* bindingCreatePathPlanner(const dtNavMesh* navMesh, const dtQueryFilter* filter, int numThreads);
+
+void bindingReleasePathPlanner(BindingPathPlanner* planner);
+
+// Bring the graph up to date with tiles added, removed or replaced since it
+// was last built. Returns the number of tiles rebuilt. Must not run during
+// bindingPathPlannerFindPath.
+int bindingPathPlannerUpdate(BindingPathPlanner* planner, int numThreads);
+
+// The corridor from startRef to endRef, as dtNavMeshQuery::findPath finds it,
+// using query for the searches within tiles. Paths between the same or
+// neighbouring tiles, or through tiles not updated yet, are searched by query
+// directly. expanded (optional) receives the graph nodes searched. Several
+// threads can find paths at once with queries of their own.
+dtStatus bindingPathPlannerFindPath(const BindingPathPlanner* planner, dtNavMeshQuery* query,
+                                    dtPolyRef startRef, dtPolyRef endRef,
+                                    const float* startPos, const float* endPos,
+                                    dtPolyRef* path, int* pathCount, int maxPath, int* expanded);
+
+void bindingPathPlannerGetStats(const BindingPathPlanner* planner, struct BindingPathPlannerStats* stats);
+
 // Utility functions
 void bindingGetTilePos(const float* pos, int* tx, int* ty,
                       const float* bmin, float tileSize, float cellSize);
@@ -128,6 +644,45 @@ struct BindingVertsAndTriangles* bindingExtractTileGeometry(
 
 void freeVertsAndTriangles(BindingVertsAndTriangles *data);
 
+// Flat per-tile geometry for visualisation, kept up to date incrementally.
+// The cache remembers the tile ref of every slot it extracted, and an update
+// re-extracts only the slots whose tile was added, removed or replaced since.
+typedef struct BindingGeometryCache BindingGeometryCache;
+
+// One tile's triangles. Pointers stay valid until the next update of the
+// cache. Positions and normals are 4 floats per vertex (x, y, z, 0) so they
+// can be read as SIMD3<Float>. Off-mesh connections are left out.
+struct BindingTileGeometry {
+    dtTileRef tileRef;          // 0 if the slot is empty
+    int x, y, layer;
+    int nverts;
+    int ntris;
+    const float* positions;     // [nverts * 4]
+    const float* normals;       // [nverts * 4], unit length
+    const uint32_t* indices;    // [ntris * 3]
+    const uint8_t* areas;       // Area of the polygon of each triangle [ntris]
+    const uint16_t* flags;      // Flags of the polygon of each triangle [ntris]
+    const dtPolyRef* polys;     // Polygon of each triangle [ntris]
+};
+
+// An empty cache for navMesh. Nothing is extracted until the first update.
+BindingGeometryCache* bindingCreateGeometryCache(const dtNavMesh* navMesh);
+
+void bindingReleaseGeometryCache(BindingGeometryCache* cache);
+
+// Re-extract the slots whose tile changed since the last update, on
+// numThreads threads (0 = one per core). Writes up to maxChanged of their
+// indices to changed (may be NULL) and returns how many slots changed.
+// Must not run while tiles are added or removed.
+int bindingGeometryCacheUpdate(BindingGeometryCache* cache, int* changed, int maxChanged, int numThreads);
+
+// Fill geom with the tile of slot tileIndex as of the last update. Returns 0
+// for an index out of range, 1 otherwise (an empty slot has no triangles).
+int bindingGeometryCacheGetTile(const BindingGeometryCache* cache, int tileIndex, struct BindingTileGeometry* geom);
+
+// Vertices and triangles over every tile of the last update
+void bindingGeometryCacheGetTotals(const BindingGeometryCache* cache, int* nverts, int* ntris);
+
 #ifdef __cplusplus
 }   /* extern "C" */
 #endif
@@ -150,6 +705,39 @@ typedef struct {
     int32_t   dataSize;
 } rcNavMeshTileHeader;
 
+// Version 2 sets: numTiles entries after the rcNavMeshSetHeader, then the
+// tiles at their offsets
+typedef struct {
+    uint64_t  offset;           // From the start of the set
+    uint64_t  checksum;         // Of the storedSize bytes at offset
+    dtTileRef tileRef;
+    int32_t   dataSize;         // Bytes of the tile before compression
+    int32_t   storedSize;       // Bytes at offset; equal to dataSize if stored uncompressed
+} rcNavMeshSetTileEntry;
+
+// Indexed navmesh file: header, numTiles entries, then the tile data at the
+// entries' offsets, each 4-byte aligned
+#define NAVMESHINDEX_MAGIC      ('M'<<24 | 'S'<<16 | 'I'<<8 | 'X')
+#define NAVMESHINDEX_VERSION    1
+
+typedef struct {
+    int32_t         magic;
+    int32_t         version;
+    int32_t         numTiles;
+    int32_t         reserved;
+    dtNavMeshParams params;
+} rcNavMeshIndexHeader;
+
+typedef struct {
+    uint64_t  offset;       // From the start of the file
+    dtTileRef tileRef;
+    int32_t   x;
+    int32_t   y;
+    int32_t   layer;
+    int32_t   storedSize;   // Bytes at offset
+    int32_t   tileSize;     // Bytes of Detour tile data once loaded
+} rcNavMeshIndexEntry;
+
 // ================================================
 //       Geometry Detour helper symbols
 // ================================================
@@ -177,6 +765,104 @@ static inline dtPolyRef
 dtNavMeshGetPolyRefBase(const dtNavMesh *m,
                         const dtMeshTile *t)        { return m->getPolyRefBase(t); }
 
+// Whether a detail provider (such as on-demand detail meshes) is attached.
+static inline bool
+dtNavMeshHasDetailProvider(const dtNavMesh *m)      { return m->getDetailProvider() != 0; }
+
+/* -------------------------------------------------------------------
+ *  Tile and polygon lookup without scanning every tile slot
+ * ------------------------------------------------------------------*/
+// The tile at a grid location and layer, or NULL.
+static inline const dtMeshTile *
+dtNavMeshGetTileAt(const dtNavMesh *m, int32_t x, int32_t y,
+                   int32_t layer)                   { return m->getTileAt(x, y, layer); }
+
+// Writes up to maxTiles tiles at a grid location, every layer, and returns how many.
+static inline int32_t
+dtNavMeshGetTilesAt(const dtNavMesh *m, int32_t x, int32_t y,
+                    const dtMeshTile **tiles,
+                    int32_t maxTiles)               { return m->getTilesAt(x, y, tiles, maxTiles); }
+
+// The slot of a tile, for dtNavMeshGetTile, or -1 for NULL.
+static inline int32_t
+dtNavMeshGetTileIndex(const dtNavMesh *m, const dtMeshTile *t)
+{
+    return t ? (int32_t)(t - m->getTile(0)) : -1;
+}
+
+// Writes the slots of up to maxTiles tiles at a grid location, every layer, and returns how many.
+static inline int32_t
+dtNavMeshGetTileIndicesAt(const dtNavMesh *m, int32_t x, int32_t y,
+                          int32_t *indices, int32_t maxTiles)
+{
+    const dtMeshTile *tiles[32];
+    const int32_t n = m->getTilesAt(x, y, tiles, maxTiles < 32 ? maxTiles : 32);
+    for (int32_t i = 0; i < n; i++) indices[i] = (int32_t)(tiles[i] - m->getTile(0));
+    return n;
+}
+
+// The tile and polygon of a polygon reference, without copying either.
+static inline dtStatus
+dtNavMeshGetTileAndPolyByRef(const dtNavMesh *m, dtPolyRef ref,
+                             const dtMeshTile **tile,
+                             const dtPoly **poly)   { return m->getTileAndPolyByRef(ref, tile, poly); }
+
+// The tile of a polygon reference, or NULL if the reference is not valid.
+static inline const dtMeshTile *
+dtNavMeshGetTileByPolyRef(const dtNavMesh *m, dtPolyRef ref)
+{
+    const dtMeshTile *tile = 0;
+    const dtPoly *poly = 0;
+    return dtStatusSucceed(m->getTileAndPolyByRef(ref, &tile, &poly)) ? tile : 0;
+}
+
+// The polygon of a polygon reference, or NULL if the reference is not valid.
+static inline const dtPoly *
+dtNavMeshGetPolyByRef(const dtNavMesh *m, dtPolyRef ref)
+{
+    const dtMeshTile *tile = 0;
+    const dtPoly *poly = 0;
+    return dtStatusSucceed(m->getTileAndPolyByRef(ref, &tile, &poly)) ? poly : 0;
+}
+
+/* -------------------------------------------------------------------
+ *  Bulk per-tile polygon accessors, O(polygons in the tile)
+ * ------------------------------------------------------------------*/
+// Writes the references of the polygons of a tile that have vertices, up to
+// maxRefs, and returns how many.
+static inline int32_t
+dtMeshTileGetPolyRefs(const dtNavMesh *m, const dtMeshTile *tile,
+                      dtPolyRef *refs, int32_t maxRefs)
+{
+    if (!tile || !tile->header) return 0;
+    const dtPolyRef base = m->getPolyRefBase(tile);
+    int32_t n = 0;
+    for (int32_t i = 0; i < tile->header->polyCount && n < maxRefs; i++) {
+        if (tile->polys[i].vertCount > 0) refs[n++] = base | (dtPolyRef)i;
+    }
+    return n;
+}
+
+// Writes the flags of every polygon of a tile, up to maxPolys, and returns how many.
+static inline int32_t
+dtMeshTileGetPolyFlags(const dtMeshTile *tile, uint16_t *flags, int32_t maxPolys)
+{
+    if (!tile || !tile->header) return 0;
+    const int32_t n = tile->header->polyCount < maxPolys ? tile->header->polyCount : maxPolys;
+    for (int32_t i = 0; i < n; i++) flags[i] = tile->polys[i].flags;
+    return n;
+}
+
+// Writes the area of every polygon of a tile, up to maxPolys, and returns how many.
+static inline int32_t
+dtMeshTileGetPolyAreas(const dtMeshTile *tile, uint8_t *areas, int32_t maxPolys)
+{
+    if (!tile || !tile->header) return 0;
+    const int32_t n = tile->header->polyCount < maxPolys ? tile->header->polyCount : maxPolys;
+    for (int32_t i = 0; i < n; i++) areas[i] = tile->polys[i].getArea();
+    return n;
+}
+
 /* -------------------------------------------------------------------
  *  dtMeshTile accessors for Swift
  * ------------------------------------------------------------------*/
@@ -189,6 +875,14 @@ dtMeshTileGetVerts(const dtMeshTile *tile)          { return tile->verts; }
 static inline const dtPoly*
 dtMeshTileGetPolys(const dtMeshTile *tile)          { return tile->polys; }
 
+// Bytes of tile data, links included.
+static inline int32_t
+dtMeshTileGetDataSize(const dtMeshTile *tile)       { return tile->dataSize; }
+
+// Whether the navmesh frees the tile data when the tile is removed.
+static inline bool
+dtMeshTileOwnsData(const dtMeshTile *tile)          { return (tile->flags & DT_TILE_FREE_DATA) != 0; }
+
 /* -------------------------------------------------------------------
  *  dtMeshHeader accessors for Swift
  * ------------------------------------------------------------------*/
@@ -27,10 +27,18 @@
 #include "DetourPathQueue.h"
 #include <swift/bridging>
 
+class dtFlowField;
+class dtCrowdWorkers;
+
+#ifndef DT_CROWD_NEIGHBOUR_CAPACITY
+#define DT_CROWD_NEIGHBOUR_CAPACITY 16
+#endif
+
 /// The maximum number of neighbors that a crowd agent can take into account
-/// for steering decisions.
+/// for steering decisions. Define DT_CROWD_NEIGHBOUR_CAPACITY to change it;
+/// #dtCrowd::setMaxNeighbours() picks how many of them the agents use.
 /// @ingroup crowd
-static const int DT_CROWDAGENT_MAX_NEIGHBOURS = 6;
+static const int DT_CROWDAGENT_MAX_NEIGHBOURS = DT_CROWD_NEIGHBOUR_CAPACITY;
 
 /// The maximum number of corners a crowd agent will look ahead in the path.
 /// This value is used for sizing the crowd agent corner buffers.
@@ -52,6 +60,102 @@ static const int DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS = 8;
 ///		dtCrowdAgentParams::queryFilterType
 static const int DT_CROWD_MAX_QUERY_FILTER_TYPE = 16;
 
+/// The maximum number of threads #dtCrowd::update() can split its agents across.
+/// @ingroup crowd
+/// @see dtCrowd::setUpdateThreads()
+static const int DT_CROWD_MAX_THREADS = 32;
+
+/// The number of level of detail tiers agents can be placed in.
+/// @ingroup crowd
+/// @see dtCrowdLodParams, dtCrowd::setLodParams(), dtCrowd::setAgentLod()
+static const int DT_CROWD_MAX_LOD_TIERS = 4;
+
+/// How agents in a level of detail tier steer.
+/// @ingroup crowd
+/// @see dtCrowdLodParams::steering
+enum dtCrowdLodSteering
+{
+	DT_CROWD_LOD_STEER_FULL = 0,		///< As the agent's #UpdateFlags ask.
+	DT_CROWD_LOD_STEER_SEPARATION,		///< Separation only, no obstacle avoidance.
+	DT_CROWD_LOD_STEER_DIRECT			///< Straight at the corners, no separation or obstacle avoidance.
+};
+
+/// Configuration of a level of detail tier of a crowd.
+/// @ingroup crowd
+/// @see dtCrowd::setLodParams()
+struct dtCrowdLodParams
+{
+	/// Distance from the LOD reference point at which agents enter the tier. (See: dtCrowd::setLodReference())
+	float distance;
+
+	/// Seconds between neighbour searches and velocity planning; the agents
+	/// keep their neighbours and planned velocity in between. [Limit: >= 0]
+	float updateInterval;
+
+	/// Scale of the distance the agents move before their local boundary
+	/// is rebuilt, normally a quarter of the collision query range. [Limit: >= 1]
+	float boundaryScale;
+
+	/// How the agents steer. (See: #dtCrowdLodSteering)
+	unsigned char steering;
+};
+
+/// Path queue counters of a crowd.
+/// @ingroup crowd
+/// @see dtCrowd::getPathQueueStats()
+struct dtCrowdPathQueueStats
+{
+	int waitingAgents;		///< Agents waiting for a free slot in the path queue.
+	int pendingRequests;	///< Requests in the path queue waiting for or under search.
+	int lastIterations;		///< Search iterations spent by the last update.
+	int completedPaths;		///< Full paths delivered since the last reset.
+	int failedPaths;		///< Full path searches that failed since the last reset.
+	float lastLatency;		///< Seconds the last delivered path took, from the agent starting to wait for it.
+	float meanLatency;		///< Mean seconds paths took since the last reset.
+	float maxLatency;		///< Longest seconds a path took since the last reset.
+};
+
+/// The phases of dtCrowd::update(), in the order they run.
+/// @ingroup crowd
+/// @see dtCrowdProfile
+enum dtCrowdProfilePhase
+{
+	DT_CROWD_PHASE_PATH_VALIDITY,	///< Checking that the agent paths are still valid.
+	DT_CROWD_PHASE_MOVE_REQUEST,	///< Starting move requests and running the path queue.
+	DT_CROWD_PHASE_TOPOLOGY,		///< Optimizing the path topology.
+	DT_CROWD_PHASE_NEIGHBOURS,		///< Level of detail, proximity grid, neighbours and local boundaries.
+	DT_CROWD_PHASE_CORNERS,			///< Finding the corners to steer to and triggering off-mesh connections.
+	DT_CROWD_PHASE_STEERING,		///< Calculating the desired velocities.
+	DT_CROWD_PHASE_AVOIDANCE,		///< Sampling velocities to avoid obstacles.
+	DT_CROWD_PHASE_INTEGRATE,		///< Integrating the velocities.
+	DT_CROWD_PHASE_COLLISION,		///< Resolving collisions between agents.
+	DT_CROWD_PHASE_MOVE,			///< Moving the agents along their corridors and off-mesh connections.
+	DT_CROWD_PHASE_COUNT,
+};
+
+/// Timings and counters of dtCrowd::update(), summed over a number of updates.
+/// @ingroup crowd
+/// @see dtCrowd::setProfiling(), dtCrowd::getProfile()
+struct dtCrowdProfile
+{
+	int updates;							///< The updates summed.
+	float phaseTime[DT_CROWD_PHASE_COUNT];	///< Milliseconds spent in each phase. (See: #dtCrowdProfilePhase)
+	float phaseMaxTime[DT_CROWD_PHASE_COUNT];	///< Longest milliseconds one update spent in each phase.
+	float updateTime;						///< Milliseconds spent in the updates.
+	float updateMaxTime;					///< Longest milliseconds of one update.
+	int pathRequests;						///< Move requests that started a path search.
+	int pathReplans;						///< Those of the requests that replanned an existing path.
+	int pathQueueIterations;				///< Search iterations run by the path queue.
+	int avoidanceSamples;					///< Velocities sampled by obstacle avoidance.
+};
+
+/// Called when dtCrowd::update() begins and ends a phase.
+///  @param[in]		userData	The pointer given to dtCrowd::setProfileCallback().
+///  @param[in]		phase		The phase. (See: #dtCrowdProfilePhase)
+///  @param[in]		begin		True when the phase begins, false when it ends.
+/// @ingroup crowd
+typedef void (*dtCrowdProfileCallback)(void* userData, int phase, bool begin);
+
 /// Provides neighbor data for agents managed by the crowd.
 /// @ingroup crowd
 /// @see dtCrowdAgent::neis, dtCrowd
@@ -168,8 +272,16 @@ struct dtCrowdAgent
 	dtPolyRef targetRef;				///< Target polyref of the movement request.
 	float targetPos[3];					///< Target position of the movement request (or velocity in case of DT_CROWDAGENT_TARGET_VELOCITY).
 	dtPathQueueRef targetPathqRef;		///< Path finder ref.
+	const dtFlowField* targetField;		///< Flow field leading to the target, or null. (See: dtCrowd::requestMoveFlowField())
 	bool targetReplan;					///< Flag indicating that the current path is being replanned.
 	float targetReplanTime;				/// <Time since the agent's target was replanned.
+
+	unsigned char pathPriority;			///< Path queue band, higher bands are served first. (See: dtCrowd::setAgentPathPriority())
+	float targetQueueTime;				///< Time the agent has waited for a full path.
+
+	unsigned char lodTier;				///< Level of detail tier. (See: dtCrowd::setAgentLod())
+	bool lodDue;						///< True if the neighbours and velocity are replanned this update.
+	float lodTimer;						///< Time until the next replan of the neighbours and velocity.
 } SWIFT_UNSAFE_REFERENCE;
 
 struct dtCrowdAgentAnimation
@@ -209,11 +321,36 @@ class dtCrowd
 	dtCrowdAgentAnimation* m_agentAnims;
 	
 	dtPathQueue m_pathq;
+	dtCrowdAgent** m_pathqCandidates;	///< Agents handed to the path queue this update. [#dtPathQueue::getMaxRequests()]
+	int m_pathqMaxIters;
+	float m_pathqMaxTimeMs;
+	int m_pathqWaiting;
+	int m_pathqCompleted;
+	int m_pathqFailed;
+	float m_pathqLastLatency;
+	float m_pathqLatencySum;
+	float m_pathqMaxLatency;
 
 	dtObstacleAvoidanceParams m_obstacleQueryParams[DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS];
 	dtObstacleAvoidanceQuery* m_obstacleQuery;
 	
 	dtProximityGrid* m_grid;
+	float* m_gridPoints;			///< Agent positions handed to a point grid. [(x, z) * #m_maxAgents]
+	int* m_activeIndex;				///< Agent index of each active agent, by grid item id. [#m_maxAgents]
+	int m_maxNeighbours;
+	
+	// Agent state mirrored by agent index, so the neighbour loops read
+	// contiguous memory. Each is current by the end of #update() and #addAgent().
+	float* m_agentPos;				///< [(x, y, z) * #m_maxAgents]
+	float* m_agentVel;				///< [(x, y, z) * #m_maxAgents]
+	float* m_agentDvel;				///< [(x, y, z) * #m_maxAgents]
+	float* m_agentRadius;			///< [#m_maxAgents]
+	float* m_agentHeight;			///< [#m_maxAgents]
+	unsigned char* m_agentState;	///< (See: #CrowdAgentState) [#m_maxAgents]
+	
+	dtCrowdLodParams m_lodParams[DT_CROWD_MAX_LOD_TIERS];
+	float m_lodReference[3];
+	bool m_lodAuto;
 	
 	dtPolyRef* m_pathResult;
 	int m_maxPathResult;
@@ -225,16 +362,55 @@ class dtCrowd
 	float m_maxAgentRadius;
 
 	int m_velocitySampleCount;
+	int m_pathRequestCount;
+	int m_pathReplanCount;
+
+	bool m_profiling;
+	int m_profileWindow;
+	dtCrowdProfile m_profile;			///< The updates summed so far.
+	dtCrowdProfile m_profileDone;		///< The last full window, when #m_profileWindow is set.
+	dtCrowdProfileCallback m_profileCallback;
+	void* m_profileUserData;
+	int m_profilePhase;
+	double m_profilePhaseStart;
+	float m_profileUpdate[DT_CROWD_PHASE_COUNT];
 
 	dtNavMeshQuery* m_navquery;
 
+	dtCrowdWorkers* m_workers;
+	int m_numThreads;
+	dtNavMeshQuery* m_threadNavQuery[DT_CROWD_MAX_THREADS];					///< [0] is #m_navquery.
+	dtObstacleAvoidanceQuery* m_threadObstacleQuery[DT_CROWD_MAX_THREADS];	///< [0] is #m_obstacleQuery.
+	int m_threadSampleCount[DT_CROWD_MAX_THREADS];
+
+	void profilePhase(const int phase);
+	void endProfile();
+
 	void updateTopologyOptimization(dtCrowdAgent** agents, const int nagents, const float dt);
 	void updateMoveRequest(const float dt);
 	void checkPathValidity(dtCrowdAgent** agents, const int nagents, const float dt);
+	void checkAgentPathValidity(dtCrowdAgent* ag, const float dt, dtNavMeshQuery* navquery);
+
+	void updateAgentNeighbourhood(dtCrowdAgent* ag, dtNavMeshQuery* navquery);
+	void updateAgentCorners(dtCrowdAgent* ag, dtNavMeshQuery* navquery, dtCrowdAgentDebugInfo* debug);
+	void triggerAgentOffMesh(dtCrowdAgent* ag, dtNavMeshQuery* navquery);
+	void updateAgentSteering(dtCrowdAgent* ag);
+	int planAgentVelocity(dtCrowdAgent* ag, dtObstacleAvoidanceQuery* obstacleQuery, dtObstacleAvoidanceDebugData* vod);
+	void resolveAgentCollisions(dtCrowdAgent* ag);
+	void moveAgent(dtCrowdAgent* ag, dtNavMeshQuery* navquery);
+
+	dtCrowdWorkers* getUpdateWorkers() const;
+	void freeThreads();
+
+	void updateLod(dtCrowdAgent** agents, const int nagents, const float dt);
+	void buildProximityGrid(dtCrowdAgent** agents, const int nagents);
+	int getNeighbours(const int self, const float range, dtCrowdNeighbour* result, const int maxResult) const;
+	void syncAgentState(const int idx);
 
 	inline int getAgentIndex(const dtCrowdAgent* agent) const  { return (int)(agent - m_agents); }
 
 	bool requestMoveTargetReplan(const int idx, dtPolyRef ref, const float* pos);
+	bool requestMoveOnField(dtCrowdAgent* ag);
 
 	void purge();
 	
@@ -248,6 +424,120 @@ public:
 	///  @param[in]		nav				The navigation mesh to use for planning.
 	/// @return True if the initialization succeeded.
 	bool init(const int maxAgents, const float maxAgentRadius, dtNavMesh* nav);
+
+	/// Sets how many threads #update() splits the per-agent phases across.
+	///  @param[in]		numThreads	The number of threads, including the calling one.
+	///								[Limits: 1 <= value <= #DT_CROWD_MAX_THREADS]
+	/// @return True if the threads and their queries could be created.
+	bool setUpdateThreads(const int numThreads);
+
+	/// The number of threads #update() splits the per-agent phases across.
+	/// @return The number of update threads, including the calling one.
+	int getUpdateThreads() const { return m_numThreads; }
+
+	/// Switches the crowd between the default proximity grid and one built
+	/// for large crowds, which holds each agent once by its position, sizes
+	/// its cells from the agents' query range and density on every update,
+	/// and looks further for neighbours in dense crowds.
+	///  @param[in]		enabled		True for the large crowd grid.
+	/// @return True if the grid could be created.
+	bool setHighCapacity(const bool enabled);
+
+	/// True if the crowd uses the grid for large crowds. (See: #setHighCapacity())
+	bool getHighCapacity() const { return m_grid && m_grid->isPointGrid(); }
+
+	/// Sets how many of their nearest neighbours the agents steer by.
+	///  @param[in]		maxNeighbours	The neighbour count. [Limits: 1 <= value <= #DT_CROWDAGENT_MAX_NEIGHBOURS]
+	/// @return True if the count was in range.
+	bool setMaxNeighbours(const int maxNeighbours);
+
+	/// The number of nearest neighbours the agents steer by.
+	int getMaxNeighbours() const { return m_maxNeighbours; }
+
+	/// Sets how much searching the path queue does per #update().
+	///  @param[in]		maxIters	The search iterations, or 0 for no limit.
+	///  @param[in]		maxTimeMs	The milliseconds, or 0 for no limit.
+	/// @return True if at least one of the limits is set.
+	bool setPathQueueBudget(const int maxIters, const float maxTimeMs);
+
+	/// The search iterations the path queue may spend per #update(), or 0 for no limit.
+	int getPathQueueMaxIterations() const { return m_pathqMaxIters; }
+
+	/// The milliseconds the path queue may spend per #update(), or 0 for no limit.
+	float getPathQueueMaxTime() const { return m_pathqMaxTimeMs; }
+
+	/// Sets how many full path requests the path queue holds at once.
+	///  @param[in]		maxRequests		The number of requests. [Limit: > 0]
+	/// @return True if the queue could be resized.
+	bool setPathQueueSize(const int maxRequests);
+
+	/// The number of full path requests the path queue holds at once.
+	int getPathQueueSize() const { return m_pathq.getMaxRequests(); }
+
+	/// Sets the path queue band of an agent. Agents in higher bands get
+	/// their full path requests into the queue, and searched, first.
+	///  @param[in]		idx			The agent index. [Limits: 0 <= value < #getAgentCount()]
+	///  @param[in]		priority	The band.
+	/// @return True if the agent index was valid.
+	bool setAgentPathPriority(const int idx, const unsigned char priority);
+
+	/// Gets the path queue counters.
+	///  @param[out]	stats	The counters.
+	void getPathQueueStats(dtCrowdPathQueueStats* stats) const;
+
+	/// Resets the path and latency totals of the path queue counters.
+	void resetPathQueueStats();
+
+	/// Turns the timing of the phases of #update() on or off. Profiling is off by default.
+	/// Turning it on clears the profile.
+	///  @param[in]		enabled	True to time the updates.
+	///  @param[in]		window	The updates to sum before #getProfile() reports them,
+	///  						or 0 to sum all updates until #resetProfile(). [Limit: >= 0]
+	void setProfiling(const bool enabled, const int window = 0);
+
+	/// Gets whether the updates are being timed.
+	/// @return True if profiling is on.
+	bool getProfiling() const { return m_profiling; }
+
+	/// Gets the updates summed before #getProfile() reports them.
+	/// @return The window, or 0 if the updates are summed until #resetProfile().
+	int getProfileWindow() const { return m_profileWindow; }
+
+	/// Gets the profile of the updates.
+	///  @param[out]	profile	The last full window of updates, or the updates
+	///  						since the last reset if no window was set.
+	void getProfile(dtCrowdProfile* profile) const;
+
+	/// Clears the profile.
+	void resetProfile();
+
+	/// Sets a function called as #update() begins and ends each phase, for
+	/// tracing tools. It runs on the thread calling #update(), whether or not
+	/// profiling is on.
+	///  @param[in]		callback	The function, or null to remove it.
+	///  @param[in]		userData	A pointer passed to the function.
+	void setProfileCallback(dtCrowdProfileCallback callback, void* userData);
+
+	/// Sets the configuration of a level of detail tier.
+	///  @param[in]		tier	The tier. [Limits: 0 <= value < #DT_CROWD_MAX_LOD_TIERS]
+	///  @param[in]		params	The new configuration.
+	void setLodParams(const int tier, const dtCrowdLodParams* params);
+
+	/// Gets the configuration of a level of detail tier.
+	///  @param[in]		tier	The tier. [Limits: 0 <= value < #DT_CROWD_MAX_LOD_TIERS]
+	/// @return The configuration, or null if the tier is out of range.
+	const dtCrowdLodParams* getLodParams(const int tier) const;
+
+	/// Places an agent in a level of detail tier.
+	///  @param[in]		idx		The agent index. [Limits: 0 <= value < #getAgentCount()]
+	///  @param[in]		tier	The tier. [Limits: 0 <= value < #DT_CROWD_MAX_LOD_TIERS]
+	/// @return True if the agent and tier were valid.
+	bool setAgentLod(const int idx, const int tier);
+
+	/// Sets the point agents' tiers are picked by on every update, from
+	/// their distance to it. Overrides tiers set with #setAgentLod().
+	///  @param[in]		pos		The reference point, or null to stop picking tiers. [(x, y, z)] [Opt]
+	void setLodReference(const float* pos);
 	
 	/// Sets the shared avoidance configuration for the specified index.
 	///  @param[in]		idx		The index. [Limits: 0 <= value < #DT_CROWD_MAX_OBSTAVOIDANCE_PARAMS]
@@ -296,6 +586,14 @@ public:
 	/// @return True if the request was successfully submitted.
 	bool requestMoveTarget(const int idx, dtPolyRef ref, const float* pos);
 
+	/// Submits a new move request for the specified agent, toward the goal of
+	/// a flow field. The agent's corridor is read off the field instead of
+	/// being searched, whenever the field reaches the agent's polygon.
+	///  @param[in]		idx		The agent index. [Limits: 0 <= value < #getAgentCount()]
+	///  @param[in]		field	The field to follow. Must outlive the request.
+	/// @return True if the request was successfully submitted.
+	bool requestMoveFlowField(const int idx, const dtFlowField* field);
+
 	/// Submits a new move request for the specified agent.
 	///  @param[in]		idx		The agent index. [Limits: 0 <= value < #getAgentCount()]
 	///  @param[in]		vel		The movement velocity. [(x, y, z)]
@@ -313,6 +611,33 @@ public:
 	/// @return The number of agents returned in @p agents.
 	int getActiveAgents(dtCrowdAgent** agents, const int maxAgents);
 
+	/// Gets the agent positions by agent index, contiguous for all agents.
+	/// Entries of inactive agents are stale.
+	/// @return The agent positions. [(x, y, z) * #getAgentCount()]
+	const float* getAgentPositions() const { return m_agentPos; }
+
+	/// Gets the agent velocities by agent index, contiguous for all agents.
+	/// Entries of inactive agents are stale.
+	/// @return The agent velocities. [(x, y, z) * #getAgentCount()]
+	const float* getAgentVelocities() const { return m_agentVel; }
+
+	/// Gets the agent states by agent index, contiguous for all agents.
+	/// Inactive agents read #DT_CROWDAGENT_STATE_INVALID.
+	/// @return The agent states. (See: #CrowdAgentState) [#getAgentCount()]
+	const unsigned char* getAgentStates() const { return m_agentState; }
+
+	/// Copies the state of every active agent into contiguous buffers, in
+	/// agent index order.
+	///  @param[out]	indices		The agent index of each agent. [(index) * maxResult] [Opt]
+	///  @param[out]	pos			The agent positions. [(x, y, z) * maxResult, @p stride floats apart] [Opt]
+	///  @param[out]	vel			The actual agent velocities. [(x, y, z) * maxResult, @p stride floats apart] [Opt]
+	///  @param[out]	states		The agent states. (See: #CrowdAgentState) [(state) * maxResult] [Opt]
+	///  @param[in]		stride		The floats from one position or velocity to the next. [Limit: >= 3]
+	///  @param[in]		maxResult	The number of agents the buffers hold.
+	/// @return The number of agents copied.
+	int getAgentSnapshot(int* indices, float* pos, float* vel, unsigned char* states,
+						 const int stride, const int maxResult) const;
+
 	/// Updates the steering and positions of all agents.
 	///  @param[in]		dt		The time, in seconds, to update the simulation. [Limit: > 0]
 	///  @param[out]	debug	A debug object to load with debug information. [Opt]
@@ -0,0 +1,80 @@
+// DetourCrowdSnapshot.h
+// Crowd state handed from a simulation thread to a render thread without locks
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef DETOURCROWDSNAPSHOT_H
+#define DETOURCROWDSNAPSHOT_H
+
+#include <atomic>
+#include "DetourCrowd.h"
+
+/// The state of the active agents of a crowd after one simulation tick.
+/// @see dtCrowdSnapshotBuffer
+struct dtCrowdSnapshot
+{
+	int count;					///< The number of agents.
+	unsigned int tick;			///< The tick the state was taken after, counted from 1.
+	float time;					///< The simulated seconds up to that tick.
+	int* indices;				///< The agent index of each agent, ascending. [(index) * count]
+	float* pos;					///< The agent positions. [(x, y, z, 0) * count]
+	float* vel;					///< The actual agent velocities. [(x, y, z, 0) * count]
+	unsigned char* states;		///< The agent states. (See: #CrowdAgentState) [(state) * count]
+};
+
+/// Passes crowd snapshots from one writer thread to one reader thread.
+///
+/// Three snapshots rotate between the writer, the reader and a slot in
+/// between that holds the newest published one. Publishing and acquiring
+/// each swap a snapshot with the middle slot in one atomic exchange, so
+/// neither side ever waits on the other, and a snapshot is never written
+/// while it is being read.
+///
+/// Positions and velocities are four floats apart, as SIMD3<Float> in Swift.
+class dtCrowdSnapshotBuffer
+{
+	static const int NEW_BIT = 4;
+	
+	dtCrowdSnapshot m_slots[3];
+	std::atomic<int> m_middle;	///< Slot published last, with #NEW_BIT while unread.
+	int m_write;
+	int m_read;
+	int m_maxAgents;
+	
+	void purge();
+	
+public:
+	dtCrowdSnapshotBuffer();
+	~dtCrowdSnapshotBuffer();
+	
+	/// Initializes the buffer, dropping its snapshots.
+	///  @param[in]		maxAgents	The maximum number of agents of the crowd. [Limit: > 0]
+	/// @return True if the snapshots were allocated.
+	bool init(const int maxAgents);
+	
+	/// Takes a snapshot of the crowd and makes it the newest. Writer thread only.
+	///  @param[in]		crowd	The crowd, not being updated meanwhile.
+	///  @param[in]		tick	The tick just simulated.
+	///  @param[in]		time	The simulated seconds up to the tick.
+	void publish(const dtCrowd* crowd, const unsigned int tick, const float time);
+	
+	/// Gets the newest published snapshot. Reader thread only.
+	/// @return The snapshot, valid until the next call; its tick is 0 before
+	/// anything is published.
+	const dtCrowdSnapshot* acquire();
+	
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtCrowdSnapshotBuffer(const dtCrowdSnapshotBuffer&);
+	dtCrowdSnapshotBuffer& operator=(const dtCrowdSnapshotBuffer&);
+} SWIFT_UNSAFE_REFERENCE;
+
+/// Allocates a snapshot buffer using the Detour allocator.
+/// @return A buffer that is ready for initialization, or null on failure.
+dtCrowdSnapshotBuffer* dtAllocCrowdSnapshotBuffer();
+
+/// Frees a snapshot buffer allocated with #dtAllocCrowdSnapshotBuffer.
+void dtFreeCrowdSnapshotBuffer(dtCrowdSnapshotBuffer* buffer);
+
+#endif // DETOURCROWDSNAPSHOT_H
@@ -0,0 +1,159 @@
+// DetourFlowField.h
+// Shared-goal flow fields: the next polygon toward one goal from every polygon
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef DETOURFLOWFIELD_H
+#define DETOURFLOWFIELD_H
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+
+/// The cheapest way to one goal from every polygon of a navmesh, for many
+/// agents heading to the same place.
+///
+/// A single Dijkstra search runs backwards from the goal over the polygon
+/// graph, expanding like dtNavMeshQuery::findPolysAroundCircle: nodes sit
+/// on the portal a path takes out of each polygon and costs come from the
+/// filter. For every polygon it reaches, the field keeps the next polygon
+/// on the way to the goal and the cost to go. A corridor from any polygon
+/// is then read off the field in as many steps as it has polygons, instead
+/// of running A* once per agent.
+///
+/// Searches are sliced: update() expands at most a given number of polygons
+/// per call, into a second buffer, and the field in use is replaced once
+/// the search completes. Entries are stored per tile. A tile added, removed
+/// or replaced makes the entries of that tile unusable at once, and the
+/// next update() starts a new search; until it completes, corridors that
+/// would go through the tile stop short of it.
+///
+/// getPath() can run any number of times between updates, from any thread,
+/// but not during update(). The navmesh must not change during update().
+/// @ingroup detour
+class dtFlowField
+{
+public:
+	dtFlowField();
+	~dtFlowField();
+
+	/// Sets up an empty field.
+	///  @param[in]		nav			The navmesh to cover.
+	///  @param[in]		filter		Polygons to use and area costs. Copied.
+	/// @returns The status flags for the operation.
+	dtStatus init(const dtNavMesh* nav, const dtQueryFilter* filter);
+
+	/// Sets the goal and starts a new search toward it. The previous field
+	/// stays in use until the search completes, unless the goal polygon
+	/// differs, in which case nothing leads anywhere until it does.
+	///  @param[in]		goalRef		The goal polygon.
+	///  @param[in]		goalPos		A position within @p goalRef. [(x, y, z)]
+	/// @returns The status flags for the operation.
+	dtStatus setGoal(dtPolyRef goalRef, const float* goalPos);
+
+	/// Advances the search, or starts a new one if tiles changed since the
+	/// field in use was searched.
+	///  @param[in]		maxIter		Polygons to expand at most.
+	///  @param[out]	doneIters	Polygons expanded. [opt]
+	/// @returns #DT_SUCCESS when the field is complete and current,
+	/// #DT_IN_PROGRESS while a search is running, or a failure.
+	dtStatus update(const int maxIter, int* doneIters = 0);
+
+	/// The polygon after @p ref on the way to the goal and the cost from the
+	/// portal out of @p ref to the goal. Returns false when the field does
+	/// not reach @p ref. For the goal polygon @p next is 0.
+	///  @param[in]		ref			The polygon.
+	///  @param[out]	next		The next polygon. [opt]
+	///  @param[out]	cost		The cost to go. [opt]
+	bool getHop(dtPolyRef ref, dtPolyRef* next, float* cost) const;
+
+	/// Follows the field from @p startRef, writing the polygons it goes
+	/// through, starting with @p startRef.
+	/// @returns #DT_SUCCESS when the path reaches the goal polygon, with
+	/// #DT_BUFFER_TOO_SMALL when @p maxPath ran out first, with
+	/// #DT_PARTIAL_RESULT when the field ends on the way, because of a tile
+	/// changed since the search, or a failure if the field does not reach
+	/// @p startRef.
+	///  @param[in]		startRef	The polygon to start from.
+	///  @param[out]	path		The polygons. [(polyRef) * @p pathCount]
+	///  @param[out]	pathCount	The number of polygons written.
+	///  @param[in]		maxPath		The size of @p path. [Limit: >= 1]
+	dtStatus getPath(dtPolyRef startRef, dtPolyRef* path, int* pathCount, const int maxPath) const;
+
+	/// The goal polygon.
+	dtPolyRef getGoalRef() const { return m_goalRef; }
+
+	/// The goal position. [(x, y, z)]
+	const float* getGoalPos() const { return m_goalPos; }
+
+	/// The filter the costs come from.
+	const dtQueryFilter* getFilter() const { return &m_filter; }
+
+	/// True while a search is running.
+	bool isSearching() const { return m_searching; }
+
+	/// Polygons the field in use reaches.
+	int getReachedPolyCount() const { return m_reached[m_front]; }
+
+	/// Tiles with entries that are no longer in the navmesh as searched,
+	/// plus tiles added since.
+	int getStaleTileCount() const;
+
+	/// Bytes held by the field.
+	size_t getMemoryUsage() const;
+
+private:
+	struct TileField
+	{
+		unsigned int salt;		///< Salt of the tile the entries were computed for, 0 if none.
+		int polyCount;
+		dtPolyRef* next;		///< Next polygon toward the goal, or 0. [(polyRef) * polyCount]
+		float* cost;			///< Cost to go, FLT_MAX if not reached. [(cost) * polyCount]
+		float* pos;				///< Node position while searching. [(x, y, z) * polyCount]
+	};
+
+	struct HeapItem
+	{
+		float cost;
+		dtPolyRef ref;
+	};
+
+	void purge();
+	void freeBuffer(const int buffer);
+	bool beginSearch();
+	void finishSearch();
+	bool pushOpen(const float cost, const dtPolyRef ref);
+	HeapItem popOpen();
+	bool currentEntry(const TileField* fields, dtPolyRef ref, const dtMeshTile** tile,
+					  const dtPoly** poly, int* index) const;
+	bool tilesChanged() const;
+
+	const dtNavMesh* m_nav;
+	dtQueryFilter m_filter;
+	dtPolyRef m_goalRef;
+	float m_goalPos[3];
+	int m_maxTiles;
+	TileField* m_fields[2];		///< The field in use and the one being searched, per tile slot.
+	int m_reached[2];
+	int m_front;
+	bool m_searching;
+	HeapItem* m_open;
+	int m_openCount;
+	int m_openCapacity;
+
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtFlowField(const dtFlowField&);
+	dtFlowField& operator=(const dtFlowField&);
+} SWIFT_UNSAFE_REFERENCE;
+
+/// Allocates a flow field using the Detour allocator.
+/// @return An allocated field, or null on failure.
+/// @ingroup detour
+dtFlowField* dtAllocFlowField();
+
+/// Frees the specified flow field using the Detour allocator.
+///  @param[in]		field		A field allocated using #dtAllocFlowField
+/// @ingroup detour
+void dtFreeFlowField(dtFlowField* field);
+
+#endif // DETOURFLOWFIELD_H
@@ -0,0 +1,148 @@
+// DetourLandmarks.h
+// Landmark distance tables for a tighter A* heuristic in dtNavMeshQuery
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef DETOURLANDMARKS_H
+#define DETOURLANDMARKS_H
+
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+
+/// Distances from a few landmarks to every polygon edge of a navmesh, for
+/// the ALT (A*, landmarks, triangle inequality) heuristic.
+///
+/// For every landmark the table holds the cheapest cost, under one filter,
+/// from the landmark to each portal: each polygon edge with a link, and each
+/// end of an off-mesh connection. Costs are a lower bound on what
+/// dtNavMeshQuery::findPath can spend: crossing a polygon between two of its
+/// edges costs at least the shortest distance between the points where
+/// getEdgeMidPoint places the search on them, clamped portals on tile
+/// borders included, times the area cost, and links are taken both ways.
+/// By the triangle inequality, the difference between the distances of two
+/// portals to any landmark is then a lower bound on the cost between them,
+/// and the largest such difference over all landmarks is an admissible
+/// heuristic that sees walls and expensive areas the straight-line distance
+/// does not.
+///
+/// Attach a table to a query with dtNavMeshQuery::setLandmarkTable. The
+/// query uses it for findPath and sliced searches whose filter has the same
+/// include and exclude flags and area costs as the table, and falls back to
+/// the straight-line distance otherwise. A custom filter (DT_VIRTUAL_QUERYFILTER)
+/// with costs below distance times area cost must not use a table.
+///
+/// Distances are stored per tile. Tiles added, removed or replaced after
+/// build() lose theirs: searches fall back to the straight-line distance in
+/// a changed tile, and since a changed tile can open routes cheaper than the
+/// distances of every other tile allow, estimates elsewhere are capped by
+/// the distance through the bounds of each changed tile. With more than
+/// #DT_MAX_LANDMARK_STALE_TILES changed tiles searches use the straight-line
+/// distance until the next build(). The changed tiles are looked up again
+/// only when dtNavMesh::getTileChangeCount moves on.
+///
+/// A table is read-only during searches and can be shared by any number of
+/// queries on different threads. build() must not run while they search.
+/// @ingroup detour
+class dtLandmarkTable
+{
+public:
+	dtLandmarkTable();
+	~dtLandmarkTable();
+
+	/// Sets up an empty table.
+	///  @param[in]		nav				The navmesh the table describes.
+	///  @param[in]		filter			Polygons to use and area costs. Copied.
+	///  @param[in]		landmarkCount	Landmarks to place. [Limits: 1 <= value <= #DT_MAX_LANDMARKS]
+	/// @returns The status flags for the operation.
+	dtStatus init(const dtNavMesh* nav, const dtQueryFilter* filter, const int landmarkCount);
+
+	/// Places the landmarks and computes the distances of every tile the
+	/// navmesh has now. The first landmark is the portal farthest from
+	/// @p seedRef (or from the first polygon when 0), and each next one the
+	/// portal farthest from all the landmarks so far.
+	///  @param[in]		seedRef		A polygon in the part of the navmesh to cover. [opt]
+	/// @returns The status flags for the operation.
+	dtStatus build(dtPolyRef seedRef = 0);
+
+	/// True if searches with @p filter can use the table: the filter has the
+	/// table's flags and area costs.
+	bool matches(const dtQueryFilter* filter) const;
+
+	/// Fills @p goal for a search ending at @p endPos in @p endRef. Returns
+	/// false when the table has nothing for that polygon, or too many tiles
+	/// have changed.
+	bool prepareGoal(dtPolyRef endRef, const float* endPos, dtLandmarkGoal& goal) const;
+
+	/// Lower bound on the cost from the portal a search crosses when it goes
+	/// over @p link of @p poly to the goal polygon, or 0 if unknown.
+	///  @param[in]		goal		The goal, from prepareGoal.
+	///  @param[in]		pos			The position the search reaches the neighbour at. [(x, y, z)]
+	///  @param[in]		tile		The tile of @p poly.
+	///  @param[in]		poly		The polygon the search expands.
+	///  @param[in]		link		The link of @p poly to the neighbour.
+	///  @param[in]		nextTile	The tile of the neighbour.
+	///  @param[in]		nextPoly	The neighbour.
+	float estimate(const dtLandmarkGoal& goal, const float* pos, const dtMeshTile* tile, const dtPoly* poly,
+				   const dtLink* link, const dtMeshTile* nextTile, const dtPoly* nextPoly) const;
+
+	/// The number of landmarks placed by the latest build.
+	int getLandmarkCount() const { return m_landmarkCount; }
+
+	/// The portal midpoint of landmark @p i. [(x, y, z)]
+	const float* getLandmarkPos(const int i) const { return &m_landmarkPos[i * 3]; }
+
+	/// Tiles with distances that are no longer in the navmesh as built.
+	int getStaleTileCount() const;
+
+	/// Bytes held by the table.
+	size_t getMemoryUsage() const;
+
+private:
+	struct TileTable
+	{
+		unsigned int salt;		///< Salt of the tile the distances were computed for.
+		int polyCount;
+		int edgeCount;			///< Edge slots: the vertices of every polygon.
+		int* edgeBase;			///< First edge slot of each polygon. [(index) * polyCount]
+		float* dist;			///< Per edge slot, one distance per landmark.
+	};
+
+	struct StaleTiles;
+
+	void purge();
+	bool passes(const dtPoly* poly) const;
+	const StaleTiles* staleTiles() const;
+	bool portalOfLink(const dtMeshTile* tile, const dtPoly* poly, const dtLink* link,
+					  const dtMeshTile* nextTile, const dtPoly* nextPoly,
+					  const dtMeshTile** portalTile, const dtPoly** portalPoly, int* edge) const;
+	const float* distances(const dtMeshTile* tile, const dtPoly* poly, int edge) const;
+
+	const dtNavMesh* m_nav;
+	float m_areaCost[DT_MAX_AREAS];
+	float m_minAreaCost;
+	unsigned short m_includeFlags;
+	unsigned short m_excludeFlags;
+	int m_maxLandmarks;
+	int m_landmarkCount;
+	float m_landmarkPos[DT_MAX_LANDMARKS * 3];
+	TileTable* m_tiles;
+	int m_tileCount;
+	StaleTiles* m_stale;
+
+	// Explicitly disabled copy constructor and copy assignment operator.
+	dtLandmarkTable(const dtLandmarkTable&);
+	dtLandmarkTable& operator=(const dtLandmarkTable&);
+} SWIFT_UNSAFE_REFERENCE;
+
+/// Allocates a landmark table using the Detour allocator.
+/// @return An allocated table, or null on failure.
+/// @ingroup detour
+dtLandmarkTable* dtAllocLandmarkTable();
+
+/// Frees the specified landmark table using the Detour allocator.
+///  @param[in]		table		A table allocated using #dtAllocLandmarkTable
+/// @ingroup detour
+void dtFreeLandmarkTable(dtLandmarkTable* table);
+
+#endif // DETOURLANDMARKS_H
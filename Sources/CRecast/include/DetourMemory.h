@@ -0,0 +1,106 @@
+// DetourMemory.h
+// Accounting of the memory Detour and Recast allocate, by hint and by owner
+
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Nadia Yilmaz
+
+#ifndef DETOURMEMORY_H
+#define DETOURMEMORY_H
+
+#include <stddef.h>
+
+/// What an allocation belongs to.
+/// @see dtMemoryGetOwner
+enum dtMemoryOwner
+{
+	DT_MEMORY_OTHER = 0,	///< Anything not listed below, such as flow fields and landmark tables.
+	DT_MEMORY_NAVMESH,		///< dtNavMesh objects with their tile slots and tile lookup.
+	DT_MEMORY_TILES,		///< Tile data a dtNavMesh frees itself (#DT_TILE_FREE_DATA).
+	DT_MEMORY_QUERY,		///< dtNavMeshQuery objects with their node pools and open lists.
+	DT_MEMORY_CROWD,		///< dtCrowd objects with everything they allocate, their queries included.
+	DT_MEMORY_TILE_CACHE,	///< dtTileCache objects with their obstacles and compressed tiles.
+	DT_MEMORY_BUILD,		///< Every Recast allocation, and Detour data being built.
+	DT_MEMORY_OWNER_COUNT
+};
+
+/// Which allocator and hint an allocation came through.
+/// @see dtMemoryGetSource
+enum dtMemorySource
+{
+	DT_MEMORY_DETOUR_PERM = 0,	///< dtAlloc with #DT_ALLOC_PERM.
+	DT_MEMORY_DETOUR_TEMP,		///< dtAlloc with #DT_ALLOC_TEMP.
+	DT_MEMORY_RECAST_PERM,		///< rcAlloc with #RC_ALLOC_PERM.
+	DT_MEMORY_RECAST_TEMP,		///< rcAlloc with #RC_ALLOC_TEMP.
+	DT_MEMORY_SOURCE_COUNT
+};
+
+/// Bytes held by one owner, one source, or everything.
+struct dtMemoryCounter
+{
+	size_t current;			///< Bytes allocated and not yet freed.
+	size_t peak;			///< Most bytes held at once since tracking started or peaks were reset.
+	size_t allocations;		///< Blocks allocated and not yet freed.
+};
+
+/// Starts or stops recording allocations. Off by default.
+///
+/// Allocations are recorded above the functions given to #dtAllocSetCustom
+/// and #rcAllocSetCustom, so custom allocators keep their hints. Sizes are
+/// the requested ones, without allocator overhead; Recast allocations served
+/// from a build arena count from rcAlloc to rcFree.
+///
+/// Only allocations made while tracking count, so turn it on before
+/// creating the meshes, queries and crowds to measure. Blocks recorded
+/// before tracking stops still leave the counters when they are freed.
+void dtMemorySetTracking(bool enabled);
+
+/// True while allocations are being recorded.
+bool dtMemoryGetTracking();
+
+/// The bytes held by everything.
+dtMemoryCounter dtMemoryGetTotal();
+
+/// The bytes held by one owner.
+dtMemoryCounter dtMemoryGetOwner(dtMemoryOwner owner);
+
+/// The bytes allocated through one allocator and hint.
+dtMemoryCounter dtMemoryGetSource(dtMemorySource source);
+
+/// Lowers every peak to the bytes currently held.
+void dtMemoryResetPeaks();
+
+/// Charges the Detour allocations made on this thread while in scope to an
+/// owner. Scopes nest, and the outermost one wins, so a query that a crowd
+/// creates counts as the crowd's.
+class dtMemoryOwnerScope
+{
+public:
+	explicit dtMemoryOwnerScope(dtMemoryOwner owner);
+	~dtMemoryOwnerScope();
+
+private:
+	int m_previous;
+
+	// Explicitly-disabled copy constructor and copy assignment operator.
+	dtMemoryOwnerScope(const dtMemoryOwnerScope&);
+	dtMemoryOwnerScope& operator=(const dtMemoryOwnerScope&);
+};
+
+/// @name Allocator hooks
+/// Called by dtAlloc, dtFree, rcAlloc and rcFree, and by the objects that take
+/// ownership of a buffer; not needed elsewhere.
+/// @{
+
+/// Records a block that was just allocated.
+void dtMemoryTrackAlloc(void* ptr, size_t size, dtMemorySource source);
+
+/// Forgets a block about to be freed. Blocks that were never recorded are ignored.
+void dtMemoryTrackFree(void* ptr);
+
+/// Charges a block to a new owner, recording it as a #DT_MEMORY_DETOUR_PERM block
+/// of @p size bytes if it was allocated elsewhere but will be freed with dtFree.
+void dtMemoryTrackOwner(void* ptr, size_t size, dtMemoryOwner owner);
+
+/// @}
+
+#endif // DETOURMEMORY_H
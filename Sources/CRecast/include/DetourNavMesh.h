@@ -100,7 +100,13 @@ static const int DT_MAX_AREAS = 64;
 enum dtTileFlags
 {
 	/// The navigation mesh owns the tile memory and is responsible for freeing it.
-	DT_TILE_FREE_DATA = 0x01
+	DT_TILE_FREE_DATA = 0x01,
+
+	/// The tile data already holds its links, as saved from a navigation mesh with the
+	/// same tiles at the same references, and is never written. It can be used straight
+	/// from read-only memory. Pre-linked tiles cannot be removed, their polygon flags and
+	/// areas cannot be changed, and they cannot be mixed with other tiles in one mesh.
+	DT_TILE_PRELINKED = 0x02
 };
 
 /// Vertex flags returned by dtNavMeshQuery::findStraightPath.
@@ -334,6 +340,19 @@ struct dtNavMeshParams
 	int maxPolys;					///< The maximum number of polygons each tile can contain. This and maxTiles are used to calculate how many bits are needed to identify tiles and polygons uniquely.
 };
 
+/// Supplies detail meshes for tiles that were built without them.
+/// The navigation mesh calls it before it reads a tile's detail mesh, so the
+/// provider can attach one with dtNavMesh::setTileDetail.
+/// @ingroup detour
+struct dtTileDetailProvider
+{
+	virtual ~dtTileDetailProvider();
+
+	/// Called before the detail mesh of @p tile is read.
+	///  @param[in]	tile	The tile about to be sampled.
+	virtual void requireDetail(const dtMeshTile* tile) = 0;
+};
+
 /// A navigation mesh based on tiles of convex polygons.
 /// @ingroup detour
 class dtNavMesh
@@ -366,6 +385,7 @@ public:
 	///  @param[in]		dataSize	Data size of the new tile mesh.
 	///  @param[in]		flags		Tile flags. (See: #dtTileFlags)
 	///  @param[in]		lastRef		The desired reference for the tile. (When reloading a tile.) [opt] [Default: 0]
+	///  								Required with #DT_TILE_PRELINKED.
 	///  @param[out]	result		The tile reference. (If the tile was succesfully added.) [opt]
 	/// @return The status flags for the operation.
 	dtStatus addTile(unsigned char* data, int dataSize, int flags, dtTileRef lastRef, dtTileRef* result);
@@ -377,6 +397,28 @@ public:
 	/// @return The status flags for the operation.
 	dtStatus removeTile(dtTileRef ref, unsigned char** data, int* dataSize);
 
+	/// Replaces the detail mesh of the specified tile.
+	/// The arrays must describe every polygon of the tile and stay valid until
+	/// they are replaced again or the tile is removed; the tile does not own them.
+	///  @param[in]	ref				The reference of the tile.
+	///  @param[in]	detailMeshes	The detail sub-meshes. [Size: dtMeshHeader::polyCount]
+	///  @param[in]	detailVerts		The detail mesh vertices.
+	///  @param[in]	detailTris		The detail mesh triangles.
+	/// @return The status flags for the operation.
+	dtStatus setTileDetail(dtTileRef ref, dtPolyDetail* detailMeshes, float* detailVerts,
+						   unsigned char* detailTris);
+
+	/// Sets the object consulted before a tile's detail mesh is read. [opt]
+	///  @param[in]	provider	The provider, or null to remove it. The navigation mesh does not own it.
+	void setDetailProvider(dtTileDetailProvider* provider) { m_detailProvider = provider; }
+
+	/// The object consulted before a tile's detail mesh is read, if any.
+	dtTileDetailProvider* getDetailProvider() const { return m_detailProvider; }
+
+	/// The number of tiles added and removed so far, for data derived from the
+	/// tiles to tell cheaply whether it is still current.
+	unsigned int getTileChangeCount() const { return m_tileChangeCount; }
+
 	/// @}
 
 	/// @{
@@ -624,6 +666,9 @@ private:
 	/// Returns neighbour tile based on side.
 	int getNeighbourTilesAt(const int x, const int y, const int side,
 							dtMeshTile** tiles, const int maxTiles) const;
+
+	/// Returns true if a tile at the location, or a neighbour of it, differs from prelinked in #DT_TILE_PRELINKED.
+	bool hasMismatchedLinking(const int x, const int y, bool prelinked) const;
 	
 	/// Returns all polygons in neighbour tile based on portal defined by the segment.
 	int findConnectingPolys(const float* va, const float* vb,
@@ -667,6 +712,8 @@ private:
 	dtMeshTile** m_posLookup;			///< Tile hash lookup.
 	dtMeshTile* m_nextFree;				///< Freelist of tiles.
 	dtMeshTile* m_tiles;				///< List of tiles.
+	dtTileDetailProvider* m_detailProvider;	///< Supplies detail meshes on demand. [opt]
+	unsigned int m_tileChangeCount;		///< Tiles added and removed so far.
 		
 #ifndef DT_POLYREF64
 	unsigned int m_saltBits;			///< Number of salt bits in the tile ID.
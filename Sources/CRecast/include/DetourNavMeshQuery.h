@@ -162,6 +162,26 @@ public:
 	virtual void process(const dtMeshTile* tile, dtPoly** polys, dtPolyRef* refs, int count) = 0;
 };
 
+/// The most landmarks a dtLandmarkTable can hold.
+static const int DT_MAX_LANDMARKS = 16;
+
+/// The most tiles changed since a dtLandmarkTable was built that searches
+/// can still use it with.
+static const int DT_MAX_LANDMARK_STALE_TILES = 16;
+
+/// Landmark distances of the polygon a search is heading for, prepared once
+/// per search by dtLandmarkTable::prepareGoal.
+struct dtLandmarkGoal
+{
+	float minDist[DT_MAX_LANDMARKS];	///< Nearest portal of the goal polygon to each landmark.
+	float maxDist[DT_MAX_LANDMARKS];	///< Farthest portal of the goal polygon from each landmark.
+	float staleBounds[DT_MAX_LANDMARK_STALE_TILES*6];	///< Bounds of the tiles changed since the build. [(bmin, bmax) * staleCount]
+	float staleGoalDist[DT_MAX_LANDMARK_STALE_TILES];	///< Distance from the goal position to each of those bounds.
+	int staleCount;						///< Changed tiles in the navmesh.
+};
+
+class dtLandmarkTable;
+
 /// Provides the ability to perform pathfinding related queries against
 /// a navigation mesh.
 /// @ingroup detour
@@ -176,6 +196,15 @@ public:
 	///  @param[in]		maxNodes	Maximum number of search nodes. [Limits: 0 < value <= 65535]
 	/// @returns The status flags for the query.
 	dtStatus init(const dtNavMesh* nav, const int maxNodes);
+
+	/// Sets the landmark table findPath and sliced searches take their
+	/// heuristic from, or null for the straight-line distance alone. The
+	/// table is used for searches whose filter it matches; it is not owned.
+	///  @param[in]		table		A built table for the navmesh of the query. [opt]
+	void setLandmarkTable(const dtLandmarkTable* table) { m_landmarks = table; }
+
+	/// The landmark table set with setLandmarkTable.
+	const dtLandmarkTable* getLandmarkTable() const { return m_landmarks; }
 	
 	/// @name Standard Pathfinding Functions
 	/// @{
@@ -341,7 +370,25 @@ public:
 	dtStatus findNearestPoly(const float* center, const float* halfExtents,
 							 const dtQueryFilter* filter,
 							 dtPolyRef* nearestRef, float* nearestPt, bool* isOverPoly) const;
-	
+
+	/// Finds the polygon nearest to each of several center points, with the
+	/// same results as calling findNearestPoly for each of them.
+	/// [opt] means the specified parameter can be a null pointer, in that case the output parameter will not be set.
+	///
+	///  @param[in]		centers		The centers of the search boxes. [(x, y, z) * @p count]
+	///  @param[in]		count		The number of centers.
+	///  @param[in]		halfExtents	The search distance along each axis, the same for every center. [(x, y, z)]
+	///  @param[in]		filter		The polygon filter to apply to the query.
+	///  @param[out]	nearestRefs	The reference id of the nearest polygon of each center. 0 if no polygon is found
+	///  							or the center is not finite. [(polyRef) * @p count]
+	///  @param[out]	nearestPts	The nearest point of each center. Unchanged where no polygon is found. [opt] [(x, y, z) * @p count]
+	///  @param[out]	isOverPoly	Whether each center's X/Z coordinate lies inside its polygon. Unchanged where
+	///  							no polygon is found. [opt] [(bool) * @p count]
+	/// @returns The status flags for the query.
+	dtStatus findNearestPolys(const float* centers, const int count, const float* halfExtents,
+							  const dtQueryFilter* filter,
+							  dtPolyRef* nearestRefs, float* nearestPts, bool* isOverPoly) const;
+
 	/// Finds polygons that overlap the search box.
 	///  @param[in]		center		The center of the search box. [(x, y, z)]
 	///  @param[in]		halfExtents		The search distance along each axis. [(x, y, z)]
@@ -572,8 +619,11 @@ private:
 		const dtQueryFilter* filter;
 		unsigned int options;
 		float raycastLimitSqr;
+		bool useLandmarks;
+		dtLandmarkGoal landmarkGoal;
 	};
 	dtQueryData m_query;				///< Sliced query state.
+	const dtLandmarkTable* m_landmarks;	///< Heuristic table, or null.
 
 	class dtNodePool* m_tinyNodePool;	///< Pointer to small node pool.
 	class dtNodePool* m_nodePool;		///< Pointer to node pool.
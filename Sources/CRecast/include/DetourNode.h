@@ -46,11 +46,20 @@ struct dtNode
 
 static const int DT_MAX_STATES_PER_NODE = 1 << DT_NODE_STATE_BITS;	// number of extra states per node. See dtNode::state
 
+/// Nodes of a search, found by polygon ref through a chained hash table.
+///
+/// Each bucket holds the index of its first node together with the generation
+/// of the pool it was written in. clear() starts a new generation, which
+/// empties every bucket at once instead of writing over the whole table, so
+/// a pool sized for long searches costs short ones nothing. The table is
+/// wiped only when the 16-bit generation wraps.
 class dtNodePool
 {
 public:
 	dtNodePool(int maxNodes, int hashSize);
 	~dtNodePool();
+
+	/// Removes every node. Constant time.
 	void clear();
 
 	// Get a dtNode by ref and extra state information. If there is none then - allocate
@@ -82,13 +91,13 @@ public:
 		return sizeof(*this) +
 			sizeof(dtNode)*m_maxNodes +
 			sizeof(dtNodeIndex)*m_maxNodes +
-			sizeof(dtNodeIndex)*m_hashSize;
+			sizeof(unsigned int)*m_hashSize;
 	}
 	
 	inline int getMaxNodes() const { return m_maxNodes; }
 	
 	inline int getHashSize() const { return m_hashSize; }
-	inline dtNodeIndex getFirst(int bucket) const { return m_first[bucket]; }
+	inline dtNodeIndex getFirst(int bucket) const { return first(bucket); }
 	inline dtNodeIndex getNext(int i) const { return m_next[i]; }
 	inline int getNodeCount() const { return m_nodeCount; }
 	
@@ -96,13 +105,21 @@ private:
 	// Explicitly disabled copy constructor and copy assignment operator.
 	dtNodePool(const dtNodePool&);
 	dtNodePool& operator=(const dtNodePool&);
+
+	/// The first node of @p bucket, or #DT_NULL_IDX when it was last written in an older generation.
+	inline dtNodeIndex first(unsigned int bucket) const
+	{
+		const unsigned int entry = m_first[bucket];
+		return (entry >> 16) == m_generation ? (dtNodeIndex)(entry & 0xffff) : DT_NULL_IDX;
+	}
 	
 	dtNode* m_nodes;
-	dtNodeIndex* m_first;
+	unsigned int* m_first;		///< Per bucket, (generation << 16) | first node index.
 	dtNodeIndex* m_next;
 	const int m_maxNodes;
 	const int m_hashSize;
 	int m_nodeCount;
+	unsigned int m_generation;	///< Generation of the current search. [Limits: 1 <= value <= 0xffff]
 };
 
 class dtNodeQueue
@@ -138,6 +138,16 @@ private:
 						const float minPenalty,
 						dtObstacleAvoidanceDebugData* debug);
 
+	void prepareSoa(const float* pos, const float rad);
+
+	void processSamples4(const float* vx, const float* vz,
+						 const float* vel, const float* dvel,
+						 const float minPenalty, float* penalties) const;
+
+	int processSamples(const float* vx, const float* vz, const int n,
+					   const float* vel, const float* dvel,
+					   float& minPenalty, float* best) const;
+
 	dtObstacleAvoidanceParams m_params;
 	float m_invHorizTime;
 	float m_vmax;
@@ -150,6 +160,9 @@ private:
 	int m_maxSegments;
 	dtObstacleSegment* m_segments;
 	int m_nsegments;
+
+	float* m_circleSoa;		///< Circles by field, as of the last prepareSoa(). [9 * #m_maxCircles]
+	float* m_segmentSoa;	///< Segments by field, as of the last prepareSoa(). [8 * #m_maxSegments]
 };
 
 dtObstacleAvoidanceQuery* dtAllocObstacleAvoidanceQuery();
@@ -24,6 +24,9 @@
 
 static const unsigned int DT_PATHQ_INVALID = 0;
 
+/// The default number of requests a #dtPathQueue holds.
+static const int DT_PATHQ_DEFAULT_SIZE = 8;
+
 typedef unsigned int dtPathQueueRef;
 
 class dtPathQueue
@@ -40,34 +43,64 @@ class dtPathQueue
 		/// State.
 		dtStatus status;
 		int keepAlive;
+		/// Requests in higher bands are searched first.
+		unsigned char priority;
 		const dtQueryFilter* filter; ///< TODO: This is potentially dangerous!
 	};
 	
-	static const int MAX_QUEUE = 8;
-	PathQuery m_queue[MAX_QUEUE];
+	PathQuery* m_queue;
+	int m_maxQueue;
+	int m_current;			///< The request being searched, or -1.
 	dtPathQueueRef m_nextHandle;
 	int m_maxPathSize;
-	int m_queueHead;
+	int m_lastIters;
 	dtNavMeshQuery* m_navquery;
 	
 	void purge();
+	int nextRequest() const;
 	
 public:
 	dtPathQueue();
 	~dtPathQueue();
 	
-	bool init(const int maxPathSize, const int maxSearchNodeCount, dtNavMesh* nav);
+	/// Initializes the queue, dropping any requests.
+	///  @param[in]		maxPathSize			The maximum number of polygons in a path result.
+	///  @param[in]		maxSearchNodeCount	The maximum number of search nodes. [Limits: 0 < value <= 65535]
+	///  @param[in]		nav					The navigation mesh to search.
+	///  @param[in]		maxQueue			The maximum number of requests held at once. [Limit: > 0]
+	/// @return True if the queue was initialized.
+	bool init(const int maxPathSize, const int maxSearchNodeCount, const dtNavMesh* nav,
+			  const int maxQueue = DT_PATHQ_DEFAULT_SIZE);
 	
-	void update(const int maxIters);
+	/// Searches the queued requests, the highest priority band first and
+	/// the oldest first within a band, until the budget is spent.
+	///  @param[in]		maxIters	The search iterations to spend, or 0 for no limit.
+	///  @param[in]		maxTimeMs	The milliseconds to spend, or 0 for no limit.
+	void update(const int maxIters, const float maxTimeMs = 0.0f);
 	
+	/// Queues a path request.
+	///  @param[in]		priority	The priority band, higher bands are searched first.
+	/// @return The request reference, or #DT_PATHQ_INVALID if the queue is full.
 	dtPathQueueRef request(dtPolyRef startRef, dtPolyRef endRef,
 						   const float* startPos, const float* endPos, 
-						   const dtQueryFilter* filter);
+						   const dtQueryFilter* filter, const unsigned char priority = 0);
 	
 	dtStatus getRequestStatus(dtPathQueueRef ref) const;
 	
 	dtStatus getPathResult(dtPathQueueRef ref, dtPolyRef* path, int* pathSize, const int maxPath);
 	
+	/// The maximum number of requests held at once.
+	inline int getMaxRequests() const { return m_maxQueue; }
+	
+	/// The number of requests waiting for or under search.
+	int getPendingCount() const;
+	
+	/// The number of free request slots.
+	int getFreeCount() const;
+	
+	/// The search iterations spent by the last #update().
+	inline int getLastIterations() const { return m_lastIters; }
+	
 	inline const dtNavMeshQuery* getNavQuery() const { return m_navquery; }
 
 private:
@@ -37,6 +37,9 @@ class dtProximityGrid
 	unsigned short* m_buckets;
 	int m_bucketsSize;
 	
+	int* m_pointStart;		///< Start of each bucket's items in #m_pool in point mode, else null. [#m_bucketsSize + 1]
+	int* m_pointBucket;		///< Bucket of each point while building. [#m_poolSize]
+	
 	int m_bounds[4];
 	
 public:
@@ -45,12 +48,30 @@ public:
 	
 	bool init(const int poolSize, const float cellSize);
 	
+	/// Initializes the grid to hold items by a single point each, built all at
+	/// once with #buildPoints(). Each item lands in one cell, so queries return
+	/// it once and need no duplicate checks.
+	///  @param[in]		maxItems	The maximum number of items. [Limit: > 0]
+	///  @param[in]		cellSize	The initial cell size. [Limit: > 0]
+	/// @return True if the grid was initialized.
+	bool initPoints(const int maxItems, const float cellSize);
+	
 	void clear();
 	
 	void addItem(const unsigned short id,
 				 const float minx, const float miny,
 				 const float maxx, const float maxy);
 	
+	/// Sets the cell size used by the next #buildPoints(). Point mode only.
+	///  @param[in]		cellSize	The cell size. [Limit: > 0]
+	void setCellSize(const float cellSize);
+	
+	/// Replaces the items of a point grid with the ids [0, @p n), sorted by
+	/// bucket so each cell's items are contiguous.
+	///  @param[in]		pos		The item positions. [(x, y) * @p n]
+	///  @param[in]		n		The number of items. [Limits: 0 <= value <= maxItems]
+	void buildPoints(const float* pos, const int n);
+	
 	int queryItems(const float minx, const float miny,
 				   const float maxx, const float maxy,
 				   unsigned short* ids, const int maxIds) const;
@@ -59,8 +80,11 @@ public:
 	
 	inline const int* getBounds() const { return m_bounds; }
 	inline float getCellSize() const { return m_cellSize; }
+	inline bool isPointGrid() const { return m_pointStart != 0; }
 
 private:
+	void purge();
+	
 	// Explicitly disabled copy constructor and copy assignment operator.
 	dtProximityGrid(const dtProximityGrid&);
 	dtProximityGrid& operator=(const dtProximityGrid&);
@@ -1186,6 +1186,16 @@ void rcMarkCylinderArea(rcContext* context, const float* position, float radius,
 /// @returns True if the operation completed successfully.
 bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf);
 
+/// Builds the distance field, splitting the passes across threads.
+/// The result is identical to #rcBuildDistanceField for any thread count.
+/// Small heightfields are built on the calling thread.
+/// @ingroup recast
+/// @param[in,out]	ctx			The build context to use during the operation.
+/// @param[in,out]	chf			A populated compact heightfield.
+/// @param[in]		numThreads	The number of threads to use, including the calling one. [Limit: >= 1]
+/// @returns True if the operation completed successfully.
+bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf, int numThreads);
+
 /// Builds region data for the heightfield using watershed partitioning.
 /// @ingroup recast
 /// @param[in,out]	ctx				The build context to use during the operation.
@@ -1199,6 +1209,24 @@ bool rcBuildDistanceField(rcContext* ctx, rcCompactHeightfield& chf);
 /// @returns True if the operation completed successfully.
 bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf, int borderSize, int minRegionArea, int mergeRegionArea);
 
+/// Builds region data using watershed partitioning, splitting the level
+/// sorting and region expansion across threads. Region flooding, merging and
+/// filtering stay serial, so the regions are identical to #rcBuildRegions for
+/// any thread count.
+/// @ingroup recast
+/// @param[in,out]	ctx				The build context to use during the operation.
+/// @param[in,out]	chf				A populated compact heightfield.
+/// @param[in]		borderSize		The size of the non-navigable border around the heightfield.
+/// 								[Limit: >=0] [Units: vx]
+/// @param[in]		minRegionArea	The minimum number of cells allowed to form isolated island areas.
+/// 								[Limit: >=0] [Units: vx].
+/// @param[in]		mergeRegionArea	Any regions with a span count smaller than this value will, if possible,
+/// 								be merged with larger regions. [Limit: >=0] [Units: vx] 
+/// @param[in]		numThreads		The number of threads to use, including the calling one. [Limit: >= 1]
+/// @returns True if the operation completed successfully.
+bool rcBuildRegions(rcContext* ctx, rcCompactHeightfield& chf, int borderSize, int minRegionArea, int mergeRegionArea,
+					int numThreads);
+
 /// Builds region data for the heightfield by partitioning the heightfield in non-overlapping layers.
 /// @ingroup recast
 /// @param[in,out]	ctx				The build context to use during the operation.
@@ -1293,6 +1321,23 @@ bool rcBuildHeightfieldLayers(rcContext* ctx, const rcCompactHeightfield& chf,
 							  int borderSize, int walkableHeight,
 							  rcHeightfieldLayerSet& lset);
 
+/// Builds a layer set from the specified compact heightfield, also telling which layer each span went to.
+/// Spans in the border, and unwalkable ones, belong to no layer.
+/// @ingroup recast
+/// @param[in,out]	ctx				The build context to use during the operation.
+/// @param[in]		chf				A fully built compact heightfield.
+/// @param[in]		borderSize		The size of the non-navigable border around the heightfield. [Limit: >=0] 
+///  								[Units: vx]
+/// @param[in]		walkableHeight	Minimum floor to 'ceiling' height that will still allow the floor area 
+///  								to be considered walkable. [Limit: >= 3] [Units: vx]
+/// @param[out]		lset			The resulting layer set. (Must be pre-allocated.)
+/// @param[out]		spanLayers		The index in @p lset of the layer of each span, or 0xff for none. 
+///  								[Size: chf.spanCount]
+/// @returns True if the operation completed successfully.
+bool rcBuildHeightfieldLayers(rcContext* ctx, const rcCompactHeightfield& chf, 
+							  int borderSize, int walkableHeight,
+							  rcHeightfieldLayerSet& lset, unsigned char* spanLayers);
+
 /// Builds a contour set from the region outlines in the provided compact heightfield.
 /// @ingroup recast
 /// @param[in,out]	ctx			The build context to use during the operation.
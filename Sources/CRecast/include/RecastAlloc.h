@@ -51,6 +51,14 @@ typedef void (rcFreeFunc)(void* ptr);
 /// @see rcAlloc, rcFree
 void rcAllocSetCustom(rcAllocFunc *allocFunc, rcFreeFunc *freeFunc);
 
+/// Gets the allocation functions Recast uses now, the defaults included, so
+/// that a custom allocator can hand on to the one it replaces.
+///  @param[out]	allocFunc	The memory allocation function used by #rcAlloc
+///  @param[out]	freeFunc	The memory de-allocation function used by #rcFree
+///
+/// @see rcAllocSetCustom
+void rcAllocGetCustom(rcAllocFunc** allocFunc, rcFreeFunc** freeFunc);
+
 /// Allocates a memory block.
 /// 
 /// @param[in]		size	The size, in bytes of memory, to allocate.
@@ -0,0 +1,214 @@
+// SPDX-License-Identifier: MIT
+//
+//  Benchmarks.swift
+//  SwiftRecastBenchmarks
+//
+//  Build, query, crowd and serialization measurements
+//
+
+import Foundation
+import SwiftRecastNavigation
+
+// MARK: - Results
+
+/// Distribution of repeated timings, in the unit of the samples
+struct Latency: Encodable {
+    let count: Int
+    let mean: Double
+    let p50: Double
+    let p90: Double
+    let p99: Double
+    let max: Double
+
+    init(_ samples: [Double]) {
+        let sorted = samples.sorted()
+        func percentile(_ p: Double) -> Double {
+            sorted.isEmpty ? 0 : sorted[Swift.min(sorted.count - 1, Int(Double(sorted.count - 1) * p + 0.5))]
+        }
+        count = sorted.count
+        mean = sorted.isEmpty ? 0 : sorted.reduce(0, +) / Double(sorted.count)
+        p50 = percentile(0.5)
+        p90 = percentile(0.9)
+        p99 = percentile(0.99)
+        max = sorted.last ?? 0
+    }
+}
+
+struct BuildResult: Encodable {
+    let vertices: Int
+    let triangles: Int
+    let tileSize: Int
+    /// Wall-clock milliseconds of the whole build
+    let totalMs: Double
+    /// Milliseconds per Recast stage, summed over the build threads
+    let stageMs: [String: Double]
+    let tiles: Int
+    /// Milliseconds per tile
+    let tileMs: Latency
+    let polygons: Int
+}
+
+/// Query latencies in microseconds
+struct QueryResult: Encodable {
+    let samples: Int
+    let nearestPoint: Latency
+    let pathCorridor: Latency
+    let straightPath: Latency
+    /// Mean polygons in the corridors found
+    let meanCorridorLength: Double
+}
+
+struct CrowdResult: Encodable {
+    let agents: Int
+    let ticks: Int
+    /// Microseconds per `Crowd.update`
+    let update: Latency
+}
+
+struct SerializationResult: Encodable {
+    let compressed: Bool
+    let bytes: Int
+    let exportMs: Double
+    let loadMs: Double
+    let exportMBps: Double
+    let loadMBps: Double
+}
+
+struct SceneResult: Encodable {
+    let scene: String
+    var objLoadMs: Double?
+    var build: BuildResult?
+    var query: QueryResult?
+    var crowd: [CrowdResult] = []
+    var serialization: [SerializationResult] = []
+}
+
+// MARK: - Measurements
+
+/// Milliseconds `body` takes
+func measure<R>(_ body: () throws -> R) rethrows -> (R, Double) {
+    let start = DispatchTime.now().uptimeNanoseconds
+    let result = try body()
+    return (result, Double(DispatchTime.now().uptimeNanoseconds - start) / 1_000_000)
+}
+
+private var queryRandom = Scene.Random(seed: 1)
+
+/// Seeded random source for `findRandomPoint`, so every run asks the same questions
+private func seededRandom() -> Float {
+    queryRandom.unit()
+}
+
+struct Benchmarks {
+    let options: Options
+
+    func build(_ scene: Scene) throws -> (NavMeshBuilder, BuildResult) {
+        var config = NavMeshConfig()
+        config.tileSize = Int32(options.tileSize)
+        let (builder, totalMs) = try measure {
+            try NavMeshBuilder(vertices: scene.vertices, triangles: scene.triangles, config: config)
+        }
+        let report = builder.buildReport
+        let tiles = report?.tiles ?? []
+        let result = BuildResult(vertices: scene.vertices.count,
+                                 triangles: scene.triangles.count / 3,
+                                 tileSize: options.tileSize,
+                                 totalMs: totalMs,
+                                 stageMs: report?.stageTimes ?? [:],
+                                 tiles: tiles.count,
+                                 tileMs: Latency(tiles.map { $0.buildTime }),
+                                 polygons: tiles.reduce(0) { $0 + $1.polygons })
+        return (builder, result)
+    }
+
+    func queries(_ navMesh: NavMesh) throws -> QueryResult {
+        let query = try navMesh.makeQuery()
+        queryRandom = Scene.Random(seed: 1)
+
+        var endpoints: [(PointInPoly, PointInPoly)] = []
+        for _ in 0..<options.querySamples {
+            guard case .success(let a) = query.findRandomPoint(randomFunction: seededRandom),
+                  case .success(let b) = query.findRandomPoint(randomFunction: seededRandom) else {
+                continue
+            }
+            endpoints.append((a, b))
+        }
+
+        var nearest: [Double] = []
+        var corridor: [Double] = []
+        var straight: [Double] = []
+        var corridorPolys = 0
+        for (a, b) in endpoints {
+            let probe = a.point3 + SIMD3(0, 0.5, 0)
+            nearest.append(measure { query.findNearestPoint(point: probe, extents: [2, 4, 2]) }.1 * 1000)
+
+            let (found, corridorMs) = measure { query.findPathCorridor(start: a, end: b) }
+            corridor.append(corridorMs * 1000)
+            guard case .success(let polys) = found else { continue }
+            corridorPolys += polys.count
+
+            straight.append(measure {
+                query.findStraightPath(startPos: a.point3, endPos: b.point3, pathCorridor: polys)
+            }.1 * 1000)
+        }
+        return QueryResult(samples: endpoints.count,
+                           nearestPoint: Latency(nearest),
+                           pathCorridor: Latency(corridor),
+                           straightPath: Latency(straight),
+                           meanCorridorLength: corridor.isEmpty ? 0 : Double(corridorPolys) / Double(corridor.count))
+    }
+
+    func crowd(_ navMesh: NavMesh, agents count: Int) throws -> CrowdResult {
+        let query = try navMesh.makeQuery()
+        queryRandom = Scene.Random(seed: UInt64(count))
+        let crowd = try navMesh.makeCrowd(maxAgents: count, agentRadius: 0.6)
+        for _ in 0..<count {
+            guard case .success(let start) = query.findRandomPoint(randomFunction: seededRandom),
+                  case .success(let target) = query.findRandomPoint(randomFunction: seededRandom),
+                  let agent = crowd.addAgent(start.point3) else {
+                continue
+            }
+            _ = agent.requestMove(target: target)
+        }
+
+        let dt: Float = 1 / 30
+        for _ in 0..<options.crowdWarmupTicks {
+            crowd.update(time: dt)
+        }
+        var ticks: [Double] = []
+        for _ in 0..<options.crowdTicks {
+            ticks.append(measure { crowd.update(time: dt) }.1 * 1000)
+        }
+        return CrowdResult(agents: count, ticks: ticks.count, update: Latency(ticks))
+    }
+
+    func serialization(_ navMesh: NavMesh, compressed: Bool) throws -> SerializationResult {
+        let (data, exportMs) = try measure { try navMesh.exportToData(compressed: compressed) }
+        let (_, loadMs) = try measure { try NavMesh(setData: data) }
+        let megabytes = Double(data.count) / (1024 * 1024)
+        return SerializationResult(compressed: compressed,
+                                   bytes: data.count,
+                                   exportMs: exportMs,
+                                   loadMs: loadMs,
+                                   exportMBps: exportMs > 0 ? megabytes / (exportMs / 1000) : 0,
+                                   loadMBps: loadMs > 0 ? megabytes / (loadMs / 1000) : 0)
+    }
+
+    func run(_ scene: Scene) throws -> SceneResult {
+        var result = SceneResult(scene: scene.name)
+        result.objLoadMs = scene.loadTime.map { $0 * 1000 }
+
+        let (builder, buildResult) = try build(scene)
+        result.build = buildResult
+        let navMesh = try builder.makeNavMesh()
+
+        result.query = try queries(navMesh)
+        for agents in options.crowdSizes {
+            result.crowd.append(try crowd(navMesh, agents: agents))
+        }
+        for compressed in [false, true] {
+            result.serialization.append(try serialization(navMesh, compressed: compressed))
+        }
+        return result
+    }
+}
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: MIT
+//
+//  Scenes.swift
+//  SwiftRecastBenchmarks
+//
+//  Reproducible benchmark geometry
+//
+
+import Foundation
+
+/// Triangle soup a benchmark builds a navmesh from
+struct Scene {
+    let name: String
+    var vertices: [SIMD3<Float>]
+    var triangles: [Int32]
+    /// Seconds spent loading the scene from disk, for scenes read from a file
+    var loadTime: Double?
+
+    /// Linear congruential generator, so every run places the same geometry,
+    /// queries and agents
+    struct Random {
+        private var state: UInt64
+
+        init(seed: UInt64) {
+            state = seed
+        }
+
+        mutating func next() -> UInt64 {
+            state = state &* 6364136223846793005 &+ 1442695040888963407
+            return state >> 33
+        }
+
+        mutating func unit() -> Float {
+            Float(next() & 0xFFFFFF) / Float(0x1000000)
+        }
+    }
+
+    /// Rolling hills over a square grid of `cells` × `cells` one-metre cells
+    static func terrain(cells: Int, name: String = "terrain") -> Scene {
+        var vertices: [SIMD3<Float>] = []
+        var triangles: [Int32] = []
+        vertices.reserveCapacity((cells + 1) * (cells + 1))
+        triangles.reserveCapacity(cells * cells * 6)
+
+        for z in 0...cells {
+            for x in 0...cells {
+                let fx = Float(x), fz = Float(z)
+                let y = 4 * sin(fx * 0.05) * cos(fz * 0.04) + 1.5 * sin(fx * 0.17 + fz * 0.11)
+                vertices.append(SIMD3(fx, y, fz))
+            }
+        }
+        let row = Int32(cells + 1)
+        for z in 0..<Int32(cells) {
+            for x in 0..<Int32(cells) {
+                let a = z * row + x
+                triangles += [a, a + row, a + 1, a + 1, a + row, a + row + 1]
+            }
+        }
+        return Scene(name: name, vertices: vertices, triangles: triangles)
+    }
+
+    /// Floor and walls of a `cells` × `cells` maze with four-metre corridors,
+    /// carved by a seeded depth-first search
+    static func maze(cells: Int, seed: UInt64 = 7) -> Scene {
+        let corridor: Float = 4
+        let wallHeight: Float = 3
+        let wallThickness: Float = 0.4
+
+        // Walls east and south of each cell, until carved away
+        var east = [Bool](repeating: true, count: cells * cells)
+        var south = [Bool](repeating: true, count: cells * cells)
+        var visited = [Bool](repeating: false, count: cells * cells)
+        var random = Random(seed: seed)
+        var stack = [0]
+        visited[0] = true
+        while let cell = stack.last {
+            let x = cell % cells, z = cell / cells
+            var next: [(cell: Int, carve: () -> Void)] = []
+            if x + 1 < cells, !visited[cell + 1] { next.append((cell + 1, { east[cell] = false })) }
+            if x > 0, !visited[cell - 1] { next.append((cell - 1, { east[cell - 1] = false })) }
+            if z + 1 < cells, !visited[cell + cells] { next.append((cell + cells, { south[cell] = false })) }
+            if z > 0, !visited[cell - cells] { next.append((cell - cells, { south[cell - cells] = false })) }
+            if next.isEmpty {
+                stack.removeLast()
+                continue
+            }
+            let pick = next[Int(random.next() % UInt64(next.count))]
+            pick.carve()
+            visited[pick.cell] = true
+            stack.append(pick.cell)
+        }
+
+        var scene = Scene(name: "maze", vertices: [], triangles: [])
+        let size = Float(cells) * corridor
+        scene.addBox(min: SIMD3(0, -0.2, 0), max: SIMD3(size, 0, size))
+        // Outer walls
+        scene.addBox(min: SIMD3(-wallThickness, 0, -wallThickness), max: SIMD3(size, wallHeight, 0))
+        scene.addBox(min: SIMD3(-wallThickness, 0, 0), max: SIMD3(0, wallHeight, size))
+        for z in 0..<cells {
+            for x in 0..<cells {
+                let x0 = Float(x) * corridor, z0 = Float(z) * corridor
+                if east[z * cells + x] {
+                    scene.addBox(min: SIMD3(x0 + corridor - wallThickness / 2, 0, z0 - wallThickness / 2),
+                                 max: SIMD3(x0 + corridor + wallThickness / 2, wallHeight, z0 + corridor + wallThickness / 2))
+                }
+                if south[z * cells + x] {
+                    scene.addBox(min: SIMD3(x0 - wallThickness / 2, 0, z0 + corridor - wallThickness / 2),
+                                 max: SIMD3(x0 + corridor + wallThickness / 2, wallHeight, z0 + corridor + wallThickness / 2))
+                }
+            }
+        }
+        return scene
+    }
+
+    /// A large terrain written to an OBJ file and read back, or the OBJ at `path`
+    static func largeOBJ(path: String?, cells: Int) throws -> Scene {
+        let file: String
+        if let path {
+            file = path
+        } else {
+            file = FileManager.default.temporaryDirectory
+                .appendingPathComponent("swiftrecast-benchmark-\(cells).obj").path
+            if !FileManager.default.fileExists(atPath: file) {
+                try terrain(cells: cells).writeOBJ(to: file)
+            }
+        }
+        let start = Date()
+        let result = try OBJParser.load(from: file)
+        var scene = Scene(name: "largeOBJ", vertices: result.vertices, triangles: result.triangles)
+        scene.loadTime = Date().timeIntervalSince(start)
+        return scene
+    }
+
+    /// Appends an axis-aligned box, wound so its outside faces up
+    mutating func addBox(min lo: SIMD3<Float>, max hi: SIMD3<Float>) {
+        let base = Int32(vertices.count)
+        for i in 0..<8 {
+            vertices.append(SIMD3(i & 1 == 0 ? lo.x : hi.x,
+                                  i & 2 == 0 ? lo.y : hi.y,
+                                  i & 4 == 0 ? lo.z : hi.z))
+        }
+        let faces: [Int32] = [
+            2, 6, 3, 3, 6, 7, // top
+            0, 1, 4, 1, 5, 4, // bottom
+            0, 2, 1, 1, 2, 3, // -z
+            4, 5, 6, 5, 7, 6, // +z
+            0, 4, 2, 2, 4, 6, // -x
+            1, 3, 5, 3, 7, 5, // +x
+        ]
+        triangles += faces.map { $0 + base }
+    }
+
+    func writeOBJ(to path: String) throws {
+        var text = ""
+        text.reserveCapacity(vertices.count * 32 + triangles.count * 8)
+        for v in vertices {
+            text += "v \(v.x) \(v.y) \(v.z)\n"
+        }
+        for t in stride(from: 0, to: triangles.count, by: 3) {
+            text += "f \(triangles[t] + 1) \(triangles[t + 1] + 1) \(triangles[t + 2] + 1)\n"
+        }
+        try text.write(toFile: path, atomically: true, encoding: .utf8)
+    }
+}
@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: MIT
+//
+//  main.swift
+//  SwiftRecastBenchmarks
+//
+//  Runs the benchmarks and writes their results as JSON
+//
+//  swift run -c release SwiftRecastBenchmarks [--quick] [--scene terrain|maze|largeOBJ]
+//      [--obj path] [--tile-size voxels] [--output results.json]
+//
+
+import Foundation
+
+/// Command line settings
+struct Options {
+    var scenes: Set<String> = ["terrain", "maze", "largeOBJ"]
+    var objPath: String?
+    var output: String?
+    var tileSize = 64
+    var querySamples = 2000
+    var crowdSizes = [100, 500, 2000]
+    var crowdWarmupTicks = 30
+    var crowdTicks = 300
+    var terrainCells = 256
+    var mazeCells = 40
+    var largeCells = 1024
+
+    init(arguments: [String]) throws {
+        var selected: Set<String> = []
+        var i = 1
+        func value() throws -> String {
+            i += 1
+            guard i < arguments.count else {
+                throw OptionError.missingValue(arguments[i - 1])
+            }
+            return arguments[i]
+        }
+        while i < arguments.count {
+            switch arguments[i] {
+            case "--quick":
+                querySamples = 200
+                crowdTicks = 60
+                terrainCells = 128
+                mazeCells = 16
+                largeCells = 384
+            case "--scene":
+                selected.insert(try value())
+            case "--obj":
+                objPath = try value()
+            case "--output":
+                output = try value()
+            case "--tile-size":
+                guard let size = Int(try value()), size >= 0 else {
+                    throw OptionError.invalidValue("--tile-size")
+                }
+                tileSize = size
+            default:
+                throw OptionError.unknown(arguments[i])
+            }
+            i += 1
+        }
+        if !selected.isEmpty {
+            scenes = selected
+        }
+    }
+
+    enum OptionError: Error {
+        case missingValue(String)
+        case invalidValue(String)
+        case unknown(String)
+    }
+}
+
+/// Everything one run writes out
+struct Report: Encodable {
+    let date: String
+    let os: String
+    let processors: Int
+    let tileSize: Int
+    let scenes: [SceneResult]
+}
+
+do {
+    let options = try Options(arguments: CommandLine.arguments)
+    let benchmarks = Benchmarks(options: options)
+
+    var results: [SceneResult] = []
+    for name in ["terrain", "maze", "largeOBJ"] where options.scenes.contains(name) {
+        FileHandle.standardError.write("Running \(name)…\n".data(using: .utf8)!)
+        let scene: Scene
+        switch name {
+        case "terrain":
+            scene = Scene.terrain(cells: options.terrainCells)
+        case "maze":
+            scene = Scene.maze(cells: options.mazeCells)
+        default:
+            scene = try Scene.largeOBJ(path: options.objPath, cells: options.largeCells)
+        }
+        results.append(try benchmarks.run(scene))
+    }
+
+    let report = Report(date: ISO8601DateFormatter().string(from: Date()),
+                        os: ProcessInfo.processInfo.operatingSystemVersionString,
+                        processors: ProcessInfo.processInfo.activeProcessorCount,
+                        tileSize: options.tileSize,
+                        scenes: results)
+    let encoder = JSONEncoder()
+    encoder.outputFormatting = [.prettyPrinted, .sortedKeys]
+    let json = try encoder.encode(report)
+    if let output = options.output {
+        try json.write(to: URL(fileURLWithPath: output))
+    } else {
+        FileHandle.standardOutput.write(json)
+        FileHandle.standardOutput.write("\n".data(using: .utf8)!)
+    }
+} catch {
+    FileHandle.standardError.write("SwiftRecastBenchmarks: \(error)\n".data(using: .utf8)!)
+    exit(1)
+}
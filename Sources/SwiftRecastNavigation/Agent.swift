@@ -42,6 +42,11 @@ public class CrowdAgent: CustomDebugStringConvertible {
         return "Agent[\(idx)]"
     }
     
+    /// The agent's index in its crowd, as listed in ``Crowd/Snapshot/agentIndices``; -1 once removed.
+    public var agentIndex: Int32 {
+        idx
+    }
+    
     /// This property access the agent parameters, setitng it will update the running parameters.
     public var params: CrowdAgent.Params {
         get {
@@ -202,7 +207,22 @@ public class CrowdAgent: CustomDebugStringConvertible {
     /// - Returns: true for a valid request, false for an invalid one
     @discardableResult
     public func requestMove(target: PointInPoly) -> Bool {
-        crowd.crowd.requestMoveTarget(idx, target.polyRef, target.point)
+        crowd.flowFields[idx] = nil
+        return crowd.crowd.requestMoveTarget(idx, target.polyRef, target.point)
+    }
+
+    /// Submits a new move request toward the goal of a flow field, for many agents heading to the same place.
+    ///
+    /// The agent's corridor is read off the field instead of being searched.
+    /// Where the field does not reach, the agent plans as with ``requestMove(target:)``.
+    /// The crowd keeps the field and advances its searches in ``Crowd/update(time:)``.
+    /// - Parameter field: The field to follow, on the navmesh of the crowd
+    /// - Returns: true for a valid request, false for an invalid one
+    @discardableResult
+    public func requestMove(following field: NavMeshFlowField) -> Bool {
+        guard crowd.crowd.requestMoveFlowField(idx, field.field) else { return false }
+        crowd.flowFields[idx] = field
+        return true
     }
 
     /// Submits a new move request velociy for the specified agent.
@@ -211,6 +231,7 @@ public class CrowdAgent: CustomDebugStringConvertible {
     @discardableResult
     public func requestMove(velocity: SIMD3<Float>) -> Bool {
         let copy: [Float] = [velocity.x, velocity.y, velocity.z]
+        crowd.flowFields[idx] = nil
         return crowd.crowd.requestMoveVelocity(idx, copy)
     }
     
@@ -218,9 +239,27 @@ public class CrowdAgent: CustomDebugStringConvertible {
     /// - Returns: true for a valid request, false for an invalid one
     @discardableResult
     public func resetMove() -> Bool {
+        crowd.flowFields[idx] = nil
         return crowd.crowd.resetMoveTarget(idx)
     }
     
+    /// The agent's band in the crowd's full path queue, defaults to 0.
+    ///
+    /// Agents in higher bands get their full paths searched first, for example the
+    /// ones the player can see.
+    public var pathPriority: UInt8 {
+        get { crowd.crowd.getAgent(idx)!.pathPriority }
+        set { _ = crowd.crowd.setAgentPathPriority(idx, newValue) }
+    }
+    
+    /// The agent's level of detail tier, between 0 (full updates) and 3, configured with ``Crowd/setLod(tier:config:)``.
+    ///
+    /// While ``Crowd/lodReference`` is set, the crowd picks the tier on every update instead.
+    public var lodTier: Int {
+        get { Int(crowd.crowd.getAgent(idx)!.lodTier) }
+        set { _ = crowd.crowd.setAgentLod(idx, Int32(newValue)) }
+    }
+    
     /// The agent's position
     public var position: SIMD3<Float> {
         let pos = crowd.crowd.getAgent(idx)!.npos
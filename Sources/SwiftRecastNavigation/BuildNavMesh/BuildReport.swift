@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: MIT
+//
+//  BuildReport.swift
+//  SwiftRecastNavigation
+//
+//  Timings and statistics collected while building a navigation mesh
+//
+
+import CRecast
+
+/// Where the time of a navmesh build went, and what each tile produced.
+///
+/// Stage times are summed over all worker threads, so for a parallel build
+/// they can add up to more than ``totalTime``.
+public struct BuildReport {
+    /// Statistics for a single tile
+    public struct TileReport {
+        /// Tile column
+        public let x: Int
+        /// Tile row
+        public let y: Int
+        /// Wall-clock build time of the tile, in milliseconds
+        public let buildTime: Double
+        /// Walkable spans in the voxel heightfield after filtering
+        public let heightfieldSpans: Int
+        /// Spans in the compact heightfield
+        public let compactSpans: Int
+        /// Regions after partitioning
+        public let regions: Int
+        /// Contours traced from the regions
+        public let contours: Int
+        /// Polygons in the tile's poly mesh
+        public let polygons: Int
+        /// Triangles in the tile's detail mesh
+        public let detailTriangles: Int
+        /// Size of the tile's Detour data in bytes, 0 if the tile came out empty
+        public let dataSize: Int
+        /// Whether the tile was loaded from the tile cache instead of built
+        public let fromCache: Bool
+        /// Detour tiles the tile came out as: one per floor with ``NavMeshConfig/layeredTiles``
+        public let layers: Int
+        /// Layers a rebuild left in place because nothing under them changed
+        public let reusedLayers: Int
+
+        init(_ stats: BindingTileStats) {
+            x = Int(stats.tx)
+            y = Int(stats.ty)
+            buildTime = stats.buildTimeMs
+            heightfieldSpans = Int(stats.heightfieldSpans)
+            compactSpans = Int(stats.compactSpans)
+            regions = Int(stats.regions)
+            contours = Int(stats.contours)
+            polygons = Int(stats.polys)
+            detailTriangles = Int(stats.detailTris)
+            dataSize = Int(stats.dataSize)
+            fromCache = stats.fromCache != 0
+            layers = Int(stats.layers)
+            reusedLayers = Int(stats.reusedLayers)
+        }
+    }
+
+    /// Wall-clock time of the whole build, in milliseconds
+    public let totalTime: Double
+
+    /// Accumulated time per Recast stage in milliseconds, keyed by stage name
+    /// (for example `"rasterizeTriangles"` or `"buildRegions"`). Stages that
+    /// did not run are left out.
+    public let stageTimes: [String: Double]
+
+    /// One entry per tile that was built, in build order
+    public let tiles: [TileReport]
+
+    /// Number of tiles loaded from the tile cache
+    public var cachedTiles: Int {
+        tiles.reduce(0) { $0 + ($1.fromCache ? 1 : 0) }
+    }
+
+    /// The tiles that took longest to build, slowest first
+    public func slowestTiles(_ count: Int = 10) -> [TileReport] {
+        Array(tiles.sorted { $0.buildTime > $1.buildTime }.prefix(count))
+    }
+
+    init(_ stats: BindingBuildStats) {
+        totalTime = stats.totalTimeMs
+
+        var stages: [String: Double] = [:]
+        withUnsafeBytes(of: stats.timerMs) { raw in
+            let times = raw.bindMemory(to: Double.self)
+            for (label, ms) in times.enumerated() where ms > 0 {
+                if let name = bindingTimerLabelName(Int32(label)) {
+                    stages[String(cString: name)] = ms
+                }
+            }
+        }
+        stageTimes = stages
+
+        var tiles: [TileReport] = []
+        if let tileStats = stats.tileStats {
+            tiles.reserveCapacity(Int(stats.numTileStats))
+            for i in 0 ..< Int(stats.numTileStats) {
+                tiles.append(TileReport(tileStats[i]))
+            }
+        }
+        self.tiles = tiles
+    }
+}
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: MIT
+//
+//  GeometryPreprocessing.swift
+//  SwiftRecastNavigation
+//
+//  Welding and culling of input geometry before a navmesh build
+//
+
+import CRecast
+
+/// Cleanup applied to the input geometry before it is rasterized.
+///
+/// Geometry from model files and RealityKit often repeats every vertex once per
+/// submesh part and carries zero-area and coincident triangles, all of which
+/// are rasterized like any other. Preprocessing welds vertices within
+/// ``weldTolerance`` (moving none of them: each is replaced by the first one in
+/// range), drops triangles that lost their area, keeps one of every set of
+/// triangles over the same vertices (the most upward-facing, whose area
+/// rasterization would keep anyway) and compacts the indices. On already clean
+/// geometry the navmesh is unchanged.
+///
+/// Set it on ``NavMeshConfig/geometryPreprocessing``, or call
+/// ``NavMeshBuilder/preprocessGeometry(vertices:triangles:options:maxSlope:)`` directly.
+public struct GeometryPreprocessing {
+    /// Vertices closer than this are merged. 0 merges only identical positions,
+    /// which never changes the mesh. [Units: wu]
+    public var weldTolerance: Float = 0
+
+    /// Keep only one of the triangles over the same three vertices
+    public var removeDuplicateTriangles: Bool = true
+
+    /// Also drop triangles steeper than ``NavMeshConfig/agentMaxSlope``, which can
+    /// never be walkable. They are still obstacles to Recast (a wall stops the
+    /// floor next to it from being walkable, and a slope over a floor lowers its
+    /// clearance), so only enable this for geometry such as terrain where the
+    /// steep faces hide nothing.
+    public var removeUnwalkableSlopes: Bool = false
+
+    public init(weldTolerance: Float = 0, removeDuplicateTriangles: Bool = true, removeUnwalkableSlopes: Bool = false) {
+        self.weldTolerance = weldTolerance
+        self.removeDuplicateTriangles = removeDuplicateTriangles
+        self.removeUnwalkableSlopes = removeUnwalkableSlopes
+    }
+}
+
+/// What ``GeometryPreprocessing`` removed from a build's input
+public struct GeometryPreprocessingStats {
+    public let inputVertices: Int
+    public let inputTriangles: Int
+    public let outputVertices: Int
+    public let outputTriangles: Int
+    /// Vertices merged into an earlier vertex within the weld tolerance
+    public let weldedVertices: Int
+    /// Vertices no remaining triangle uses
+    public let unusedVertices: Int
+    /// Triangles with no area, or with repeated or out-of-range indices
+    public let degenerateTriangles: Int
+    /// Triangles over the same vertices as one that was kept
+    public let duplicateTriangles: Int
+    /// Triangles too steep to be walkable, when ``GeometryPreprocessing/removeUnwalkableSlopes`` is set
+    public let steepTriangles: Int
+
+    init(_ s: BindingGeometryCleanupStats) {
+        inputVertices = Int(s.inputVertices)
+        inputTriangles = Int(s.inputTriangles)
+        outputVertices = Int(s.outputVertices)
+        outputTriangles = Int(s.outputTriangles)
+        weldedVertices = Int(s.weldedVertices)
+        unusedVertices = Int(s.unusedVertices)
+        degenerateTriangles = Int(s.degenerateTriangles)
+        duplicateTriangles = Int(s.duplicateTriangles)
+        steepTriangles = Int(s.steepTriangles)
+    }
+}
+
+extension NavMeshBuilder {
+    /// Welds, culls and compacts geometry as a build with `options` would.
+    /// - Parameters:
+    ///   - vertices: Flattened vertices, x, y, z each
+    ///   - triangles: Three vertex indices per triangle
+    ///   - options: What to remove
+    ///   - maxSlope: Steepest walkable slope in degrees, used with ``GeometryPreprocessing/removeUnwalkableSlopes``
+    /// - Returns: The remaining vertices and triangles, in their input order, and what was removed
+    public static func preprocessGeometry(
+        vertices: [Float],
+        triangles: [Int32],
+        options: GeometryPreprocessing,
+        maxSlope: Float = 45
+    ) throws -> (vertices: [Float], triangles: [Int32], stats: GeometryPreprocessingStats) {
+        var result = BindingCleanGeometry()
+        defer { bindingReleaseCleanGeometry(&result) }
+        let ok = vertices.withUnsafeBufferPointer { vBuf in
+            triangles.withUnsafeBufferPointer { tBuf in
+                bindingCleanGeometry(
+                    vBuf.baseAddress, Int32(vertices.count / 3),
+                    tBuf.baseAddress, Int32(triangles.count / 3),
+                    options.weldTolerance,
+                    options.removeDuplicateTriangles ? 1 : 0,
+                    options.removeUnwalkableSlopes ? maxSlope : 0,
+                    &result
+                )
+            }
+        }
+        guard ok != 0 else { throw NavMeshError.memory }
+        return (
+            Array(UnsafeBufferPointer(start: result.vertices, count: Int(result.vertexCount) * 3)),
+            Array(UnsafeBufferPointer(start: result.triangles, count: Int(result.triangleCount) * 3)),
+            GeometryPreprocessingStats(result.stats)
+        )
+    }
+
+    /// ``preprocessGeometry(vertices:triangles:options:maxSlope:)`` for unflattened vertices
+    public static func preprocessGeometry(
+        vertices: [SIMD3<Float>],
+        triangles: [Int32],
+        options: GeometryPreprocessing,
+        maxSlope: Float = 45
+    ) throws -> (vertices: [Float], triangles: [Int32], stats: GeometryPreprocessingStats) {
+        try preprocessGeometry(vertices: flatten(vertices), triangles: triangles, options: options, maxSlope: maxSlope)
+    }
+}
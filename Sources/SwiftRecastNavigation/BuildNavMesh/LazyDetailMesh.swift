@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MIT
+//
+//  LazyDetailMesh.swift
+//  SwiftRecastNavigation
+//
+//  Detail meshes built on demand for meshes built with lazyDetailMesh
+//
+
+import CRecast
+
+/// How the on-demand detail meshes of a ``NavMesh`` built with
+/// ``NavMeshConfig/lazyDetailMesh`` are doing
+public struct LazyDetailStats {
+    /// Tiles that have a detail mesh right now
+    public let cachedTiles: Int
+    /// Detail meshes built so far
+    public let builds: Int
+    /// Detail meshes dropped to stay within ``NavMeshConfig/lazyDetailCacheTiles``
+    public let evictions: Int
+    /// Tiles whose rebuild did not match the navmesh, say because the geometry
+    /// changed without rebuilding them; they keep polygon-plane heights
+    public let failures: Int
+    /// Bytes held by the detail meshes
+    public let cachedBytes: Int
+}
+
+/// Owns a navmesh with on-demand detail meshes. Detaches the detail provider
+/// before freeing the mesh, and keeps the builder alive because its input is
+/// what the detail meshes are built from.
+final class LazyDetailOwner {
+    let navMesh: dtNavMesh
+    let lazy: OpaquePointer
+    let builder: NavMeshBuilder
+
+    init(navMesh: dtNavMesh, lazy: OpaquePointer, builder: NavMeshBuilder) {
+        self.navMesh = navMesh
+        self.lazy = lazy
+        self.builder = builder
+    }
+
+    deinit {
+        bindingReleaseLazyDetail(lazy)
+        dtFreeNavMesh(navMesh)
+    }
+}
+
+public extension NavMesh {
+    /// Statistics of the on-demand detail meshes, or nil if the mesh was not
+    /// built with ``NavMeshConfig/lazyDetailMesh``
+    var lazyDetailStats: LazyDetailStats? {
+        guard let owner = owner as? LazyDetailOwner else { return nil }
+        var s = BindingLazyDetailStats()
+        bindingLazyDetailGetStats(owner.lazy, &s)
+        return LazyDetailStats(
+            cachedTiles: Int(s.cachedTiles),
+            builds: Int(s.builds),
+            evictions: Int(s.evictions),
+            failures: Int(s.failures),
+            cachedBytes: Int(s.cachedBytes)
+        )
+    }
+}
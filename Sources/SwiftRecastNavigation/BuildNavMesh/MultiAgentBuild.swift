@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: MIT
+//
+//  MultiAgentBuild.swift
+//  SwiftRecastNavigation
+//
+//  Builds one navigation mesh per agent size from a single rasterization pass
+//
+
+import CRecast
+import Foundation
+
+/// The dimensions of one kind of agent, in world units
+public struct AgentProfile {
+    /// Height of the agent
+    public var height: Float
+    /// Radius of the agent; walkable areas are eroded by it
+    public var radius: Float
+    /// Highest ledge the agent can step up
+    public var maxClimb: Float
+
+    public init(height: Float, radius: Float, maxClimb: Float) {
+        self.height = height
+        self.radius = radius
+        self.maxClimb = maxClimb
+    }
+}
+
+/// The navigation mesh built for one ``AgentProfile``
+public struct AgentNavMesh {
+    /// The profile the mesh was built for
+    public let profile: AgentProfile
+    /// The navigation mesh
+    public let navMesh: NavMesh
+    /// Number of tiles that produced polygons
+    public let tilesBuilt: Int
+    /// Per-tile statistics for this profile. Stage times and ``BuildReport/totalTime``
+    /// cover the whole multi-agent build, and each tile's time includes its
+    /// shared rasterization.
+    public let buildReport: BuildReport
+}
+
+extension NavMeshBuilder {
+    /// Builds a navigation mesh for each agent profile, rasterizing the geometry only once.
+    ///
+    /// Every tile is voxelised once; the profiles then filter, erode and
+    /// triangulate that heightfield on their own. Rasterization is usually the
+    /// most expensive stage, so this is much faster than building each profile
+    /// separately. Cell size, slope and tile size come from `config`, and the
+    /// agent and walkable settings in it are replaced by each profile. The
+    /// on-disk tile cache (`tileCacheDirectory`) is not used.
+    /// - Parameters:
+    ///   - vertices: Array of vertices
+    ///   - triangles: Triangle index array
+    ///   - config: Configuration shared by all profiles
+    ///   - areas: Optional array of area definitions for marking special regions
+    ///   - agents: The agent profiles to build for
+    /// - Returns: One mesh per profile, in the order of `agents`
+    public static func buildNavMeshes(
+        vertices: [SIMD3<Float>],
+        triangles: [Int32],
+        config: NavMeshConfig = NavMeshConfig(),
+        areas: [AreaDefinition] = [],
+        agents: [AgentProfile]
+    ) throws -> [AgentNavMesh] {
+        try buildNavMeshes(
+            vertices: flatten(vertices),
+            triangles: triangles,
+            config: config,
+            areas: areas,
+            agents: agents
+        )
+    }
+
+    /// Builds a navigation mesh for each agent profile from flattened vertices and triangles
+    public static func buildNavMeshes(
+        vertices: [Float],
+        triangles: [Int32],
+        config: NavMeshConfig = NavMeshConfig(),
+        areas: [AreaDefinition] = [],
+        agents: [AgentProfile]
+    ) throws -> [AgentNavMesh] {
+        let builder = try NavMeshBuilder(
+            vertices: vertices,
+            triangles: triangles,
+            config: config,
+            areas: areas,
+            buildTiles: false
+        )
+        return try builder.makeNavMeshes(for: agents)
+    }
+
+    /// Builds a navigation mesh for each agent profile from this builder's current input
+    public func makeNavMeshes(for agents: [AgentProfile]) throws -> [AgentNavMesh] {
+        guard !agents.isEmpty, let input = buildInput else { throw NavMeshError.invalidConfiguration }
+
+        let profiles = agents.map { BindingAgentProfile(height: $0.height, radius: $0.radius, maxClimb: $0.maxClimb) }
+        guard let result = bindingBuildTiledNavMeshesForAgents(input, profiles, Int32(profiles.count)) else {
+            throw NavMeshError.memory
+        }
+        defer { bindingReleaseMultiAgentResult(result) }
+
+        switch result.pointee.code {
+        case BCODE_OK: break
+        case BCODE_ERR_MEMORY: throw NavMeshError.memory
+        case BCODE_ERR_INIT_TILE_NAVMESH: throw NavMeshError.initTileNavMesh
+        case BCODE_ERR_BUILD_TILE: throw NavMeshError.noTilesBuilt
+        case BCODE_ERR_ADD_TILE: throw NavMeshError.addTile
+        default: throw NavMeshError.unknown
+        }
+
+        let totalTiles = Int(result.pointee.totalTiles)
+        var meshes: [AgentNavMesh] = []
+        meshes.reserveCapacity(agents.count)
+        for (i, agent) in agents.enumerated() {
+            guard let handle = bindingMultiAgentTakeNavMesh(result, Int32(i)) else {
+                throw NavMeshError.unknown
+            }
+
+            // Report on this profile's slice of the tile statistics
+            var stats = result.pointee.stats
+            stats.tileStats = stats.tileStats.map { $0 + i * totalTiles }
+            stats.numTileStats = Int32(totalTiles)
+
+            meshes.append(AgentNavMesh(
+                profile: agent,
+                navMesh: NavMesh(navMesh: handle),
+                tilesBuilt: Int(result.pointee.tilesBuilt[i]),
+                buildReport: BuildReport(stats)
+            ))
+        }
+        return meshes
+    }
+}
@@ -12,34 +12,33 @@ import CRecast
 
 extension NavMeshBuilder {
     /// Creates a NavMeshBuilder from a RealityKit ModelComponent
+    ///
+    /// Every part of every model is included. Parts do not share vertices, so
+    /// set ``NavMeshConfig/geometryPreprocessing`` to weld the seams between them.
     public convenience init(model: ModelComponent, config: NavMeshConfig = NavMeshConfig()) throws {
         var floatArray: [Float] = []
         var triangles: [Int32] = []
         
         for model in model.mesh.contents.models {
             for part in model.parts {
-                if let vertices = part.buffers[.positions]?.get(SIMD3<Float>.self) {
-                    floatArray = Array(repeating: 0, count: vertices.count * 3)
-                    var i = 0
-                    for vertex in vertices {
-                        floatArray[i] = vertex.x
-                        floatArray[i + 1] = vertex.y
-                        floatArray[i + 2] = vertex.z
-                        i += 3
-                    }
+                guard let vertices = part.buffers[.positions]?.get(SIMD3<Float>.self) else { continue }
+                let base = Int32(floatArray.count / 3)
+                floatArray.reserveCapacity(floatArray.count + vertices.count * 3)
+                for vertex in vertices {
+                    floatArray.append(vertex.x)
+                    floatArray.append(vertex.y)
+                    floatArray.append(vertex.z)
                 }
                 
                 if let triangleBuffer = part.buffers[.triangleIndices]?.get(UInt16.self) {
-                    triangles = Array(repeating: 0, count: triangleBuffer.count)
-                    let telem = triangleBuffer.elements
-                    for x in 0..<triangleBuffer.count {
-                        triangles[x] = Int32(telem[x])
+                    triangles.reserveCapacity(triangles.count + triangleBuffer.count)
+                    for index in triangleBuffer.elements {
+                        triangles.append(base + Int32(index))
                     }
                 } else if let triangleBuffer = part.buffers[.triangleIndices]?.get(UInt32.self) {
-                    triangles = Array(repeating: 0, count: triangleBuffer.count)
-                    let telem = triangleBuffer.elements
-                    for x in 0..<triangleBuffer.count {
-                        triangles[x] = Int32(telem[x])
+                    triangles.reserveCapacity(triangles.count + triangleBuffer.count)
+                    for index in triangleBuffer.elements {
+                        triangles.append(base + Int32(index))
                     }
                 }
             }
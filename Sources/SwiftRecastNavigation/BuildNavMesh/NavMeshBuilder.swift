@@ -17,6 +17,9 @@ public class NavMeshBuilder {
     // Internal tiled mesh result
     public var tiledResult: UnsafeMutablePointer<BindingTileMeshResult>?
     
+    // Retained copy of the geometry, areas and rcConfig, used to rebuild tiles
+    var buildInput: OpaquePointer?
+    
     /// The minimum boundary used for building
     public let boundaryMin: SIMD3<Float>
     
@@ -36,6 +39,15 @@ public class NavMeshBuilder {
         return Int(tiledResult?.pointee.totalTiles ?? 0)
     }
     
+    /// Stage timings and per-tile statistics of the initial build
+    public private(set) var buildReport: BuildReport?
+    
+    /// Stage timings and per-tile statistics of the most recent `rebuildTiles` call
+    public internal(set) var lastRebuildReport: BuildReport?
+    
+    /// What ``NavMeshConfig/geometryPreprocessing`` removed from the input, nil without it
+    public private(set) var preprocessingStats: GeometryPreprocessingStats?
+    
     /// Creates a navigation mesh from vertices and triangles
     /// - Parameters:
     ///   - vertices: Array of vertices
@@ -57,11 +69,29 @@ public class NavMeshBuilder {
     }
     
     /// Creates a navigation mesh from flattened vertices and triangles
-    public init(
+    public convenience init(
         vertices: [Float],
         triangles: [Int32],
         config: NavMeshConfig = NavMeshConfig(),
         areas: [AreaDefinition] = []
+    ) throws {
+        try self.init(
+            vertices: vertices,
+            triangles: triangles,
+            config: config,
+            areas: areas,
+            buildTiles: true
+        )
+    }
+    
+    /// Prepares the build input and, if `buildTiles` is set, builds every tile.
+    /// Without it the builder only retains the input, for streaming builds.
+    init(
+        vertices: [Float],
+        triangles: [Int32],
+        config: NavMeshConfig,
+        areas: [AreaDefinition],
+        buildTiles: Bool
     ) throws {
         self.config = config
         
@@ -90,6 +120,21 @@ public class NavMeshBuilder {
             boundaryMax = maxBounds
         }
         
+        // Bounds come from the geometry as given, so preprocessing leaves the tile grid in place
+        var vertices = vertices
+        var triangles = triangles
+        if let options = config.geometryPreprocessing {
+            let cleaned = try Self.preprocessGeometry(
+                vertices: vertices,
+                triangles: triangles,
+                options: options,
+                maxSlope: config.agentMaxSlope
+            )
+            vertices = cleaned.vertices
+            triangles = cleaned.triangles
+            preprocessingStats = cleaned.stats
+        }
+        
         // Create rcConfig
         var cfg = rcConfig()
         cfg.cs = config.cellSize
@@ -139,12 +184,18 @@ public class NavMeshBuilder {
         flags |= config.filterLedgeSpans ? Int32(FILTER_LEDGE_SPANS) : 0
         flags |= config.filterLowHangingObstacles ? Int32(FILTER_LOW_HANGING_OBSTACLES) : 0
         flags |= config.filterWalkableLowHeightSpans ? Int32(FILTER_WALKABLE_LOW_HEIGHT_SPANS) : 0
+        flags |= config.lazyDetailMesh ? Int32(BUILD_LAZY_DETAIL_MESH) : 0
+        flags |= config.layeredTiles ? Int32(BUILD_TILE_LAYERS) : 0
         
         // Create tile config
-        var tileConfig = TileConfig(tileSize: cfg.tileSize)
+        var tileConfig = TileConfig(
+            tileSize: cfg.tileSize,
+            numThreads: config.buildThreadCount,
+            regionThreads: config.regionThreadCount
+        )
         
-        // Build tiled navmesh
-        let result = try buildTiledNavMesh(
+        // Keep the build input so tiles can be rebuilt after edits
+        guard let input = Self.makeBuildInput(
             config: &cfg,
             tileConfig: &tileConfig,
             flags: flags,
@@ -154,9 +205,22 @@ public class NavMeshBuilder {
             agentHeight: config.agentHeight,
             agentRadius: config.agentRadius,
             agentMaxClimb: config.agentMaxClimb
-        )
+        ) else {
+            throw NavMeshError.memory
+        }
+        buildInput = input
+        
+        if let cacheDir = config.tileCacheDirectory {
+            try? FileManager.default.createDirectory(at: cacheDir, withIntermediateDirectories: true)
+            bindingSetTileCacheDirectory(input, cacheDir.path)
+        }
+        
+        guard buildTiles else { return }
         
+        // Build tiled navmesh
+        let result = try Self.checkedResult(bindingBuildTiledNavMeshFromInput(input))
         tiledResult = result
+        buildReport = BuildReport(result.pointee.stats)
     }
     
     // MARK: – Internal helpers
@@ -193,15 +257,30 @@ public class NavMeshBuilder {
         guard let navMeshHandle = getNavMesh() else {
             throw NavMeshError.invalidConfiguration
         }
-        let navMesh = NavMesh(navMesh: navMeshHandle)
+        let navMesh = try wrapNavMesh(navMeshHandle)
 
         // 4. Detach the pointer from the build result so each is freed only once.
         tiledResult?.pointee.navMesh = nil
         return navMesh
     }
     
+    /// Wraps a navmesh built from this builder's input, taking it over unless this throws.
+    /// With `lazyDetailMesh` the wrapper also builds detail meshes on demand.
+    func wrapNavMesh(_ handle: dtNavMesh) throws -> NavMesh {
+        guard config.lazyDetailMesh else { return NavMesh(navMesh: handle) }
+        guard let input = buildInput,
+              let lazy = bindingCreateLazyDetail(input, handle, config.lazyDetailCacheTiles)
+        else {
+            throw NavMeshError.memory
+        }
+        return NavMesh(navMesh: handle, owner: LazyDetailOwner(navMesh: handle, lazy: lazy, builder: self))
+    }
+    
     /// Exports the navigation mesh to a binary format suitable for saving
-    public func exportToData() throws -> Data {
+    /// - Parameter compressed: Produce a version 2 set with LZ4-compressed, checksummed
+    ///   tiles instead of the uncompressed version 1 layout. The tiles are compressed
+    ///   losslessly.
+    public func exportToData(compressed: Bool = false) throws -> Data {
         guard let result = tiledResult,
               let navMesh = result.pointee.navMesh
         else {
@@ -211,32 +290,48 @@ public class NavMeshBuilder {
         var ptr: UnsafeMutableRawPointer?
         var size: Int32 = 0
         
-        let status = bindingExportTiledNavMesh(navMesh, &ptr, &size)
-        
-        switch status {
-        case BD_OK:
-            guard let ptr = ptr else {
-                throw NavMeshExportError.allocationFailed
-            }
-            return Data(bytesNoCopy: ptr, count: Int(size), deallocator: .free)
-        case BD_ERR_INVALID_PARAM:
+        let status = compressed
+            ? bindingExportCompressedNavMesh(navMesh, &ptr, &size)
+            : bindingExportTiledNavMesh(navMesh, &ptr, &size)
+        return try exportedData(status, ptr, Int(size))
+    }
+    
+    /// Saves the navigation mesh to disk as ``exportToData(compressed:)`` would
+    /// produce it, writing tile by tile instead of building the file in memory.
+    /// If writing fails the file is removed.
+    public func save(to url: URL, compressed: Bool = false) throws {
+        guard let result = tiledResult,
+              let navMesh = result.pointee.navMesh
+        else {
+            throw NavMeshExportError.invalidParameters
+        }
+        try saveNavMesh(navMesh, to: url, compressed: compressed)
+    }
+    
+    /// Exports the navigation mesh in the indexed format read by ``TileStreamingNavMesh``;
+    /// see ``NavMesh/exportIndexedData()``
+    public func exportIndexedData() throws -> Data {
+        guard let result = tiledResult,
+              let navMesh = result.pointee.navMesh
+        else {
             throw NavMeshExportError.invalidParameters
-        case BD_ERR_ALLOC_NAVMESH:
-            throw NavMeshExportError.allocationFailed
-        default:
-            throw NavMeshExportError.exportFailed
         }
+        return try NavMesh(navMesh: navMesh, owner: self)
+            .exportIndexedData()
     }
     
     deinit {
         if let result = tiledResult {
             bindingReleaseTiledNavMesh(result)
         }
+        if let input = buildInput {
+            bindingReleaseTileBuildInput(input)
+        }
     }
     
     // MARK: - Private Helpers
     
-    private static func flatten(_ d: [SIMD3<Float>]) -> [Float] {
+    static func flatten(_ d: [SIMD3<Float>]) -> [Float] {
         var ret = [Float](repeating: 0, count: d.count * 3)
         var j = 0
         for e in d {
@@ -248,82 +343,66 @@ public class NavMeshBuilder {
         return ret
     }
     
-    //  ──────────────────────────────────────────────────────────────────────────────
-    private func buildTiledNavMesh(
-        config: inout rcConfig,
-        tileConfig: inout TileConfig,
-        flags: Int32,
-        vertices: [Float],
-        triangles: [Int32],
-        areas: [AreaDefinition],
-        agentHeight: Float,
-        agentRadius: Float,
-        agentMaxClimb: Float
-    ) throws -> UnsafeMutablePointer<BindingTileMeshResult> {
-        // ── 1.  Pre-flatten area buffers (unchanged) ───────────────────────────────
+    /// Flattens the area definitions and calls `body` with the per-area
+    /// pointer lists the C bridge expects. The pointers are only valid inside `body`.
+    static func withAreaBuffers<R>(
+        _ areas: [AreaDefinition],
+        _ body: (
+            _ vertPtrs: UnsafeMutablePointer<UnsafePointer<Float>?>?,
+            _ vertCounts: UnsafePointer<Int32>?,
+            _ triPtrs: UnsafeMutablePointer<UnsafePointer<Int32>?>?,
+            _ triCounts: UnsafePointer<Int32>?,
+            _ codes: UnsafePointer<UInt8>?,
+            _ count: Int32
+        ) -> R
+    ) -> R {
+        if areas.isEmpty {
+            return body(nil, nil, nil, nil, nil, 0)
+        }
+        
+        // ── 1.  Pre-flatten area buffers ───────────────────────────────────────────
         var areaVertArrays: [[Float]] = []
         var areaTriArrays: [[Int32]] = []
         var areaCodes: [UInt8] = []
 
         for area in areas {
-            areaVertArrays.append(Self.flatten(area.vertices))
+            areaVertArrays.append(flatten(area.vertices))
             areaTriArrays.append(area.triangles)
             areaCodes.append(area.areaCode)
         }
 
-        // ── 2.  Helper that does *all* the real work, with no generics in sight ────
-        @inline(never)
-        func makeMesh(
-            vBase: UnsafePointer<Float>,
-            tBase: UnsafePointer<Int32>
-        ) -> UnsafeMutablePointer<BindingTileMeshResult>? {
-            if areas.isEmpty {
-                // 2-A  No custom areas
-                return bindingBuildTiledNavMesh(
-                    &config, &tileConfig, flags,
-                    vBase, Int32(vertices.count / 3),
-                    tBase, Int32(triangles.count / 3),
-                    nil, nil, /* areaCount */ 0,
-                    agentHeight, agentRadius, agentMaxClimb
-                )
-            }
+        // ── 2.  Build per-area pointer lists once ──────────────────────────────────
+        var areaVertPtrs: [UnsafePointer<Float>?] = []
+        var areaVertCnts: [Int32] = []
+        var areaTriPtrs: [UnsafePointer<Int32>?] = []
+        var areaTriCnts: [Int32] = []
 
-            // 2-B  Build per-area pointer lists once
-            var areaVertPtrs: [UnsafePointer<Float>?] = []
-            var areaVertCnts: [Int32] = []
-            var areaTriPtrs: [UnsafePointer<Int32>?] = []
-            var areaTriCnts: [Int32] = []
-
-            for i in 0 ..< areaVertArrays.count {
-                areaVertArrays[i].withUnsafeBufferPointer { p in
-                    areaVertPtrs.append(p.baseAddress)
-                }
-                areaVertCnts.append(Int32(areaVertArrays[i].count / 3))
+        for i in 0 ..< areaVertArrays.count {
+            areaVertArrays[i].withUnsafeBufferPointer { p in
+                areaVertPtrs.append(p.baseAddress)
+            }
+            areaVertCnts.append(Int32(areaVertArrays[i].count / 3))
 
-                areaTriArrays[i].withUnsafeBufferPointer { p in
-                    areaTriPtrs.append(p.baseAddress)
-                }
-                areaTriCnts.append(Int32(areaTriArrays[i].count / 3))
+            areaTriArrays[i].withUnsafeBufferPointer { p in
+                areaTriPtrs.append(p.baseAddress)
             }
+            areaTriCnts.append(Int32(areaTriArrays[i].count / 3))
+        }
 
-            // 2-C  Final C bridge call
-            return areaVertPtrs.withUnsafeMutableBufferPointer { vPtrBuf in
-                areaVertCnts.withUnsafeMutableBufferPointer { vCntBuf in
+        // ── 3.  Hand the lists to the caller ───────────────────────────────────────
+        return withExtendedLifetime((areaVertArrays, areaTriArrays)) {
+            areaVertPtrs.withUnsafeMutableBufferPointer { vPtrBuf in
+                areaVertCnts.withUnsafeBufferPointer { vCntBuf in
                     areaTriPtrs.withUnsafeMutableBufferPointer { tPtrBuf in
-                        areaTriCnts.withUnsafeMutableBufferPointer { tCntBuf in
+                        areaTriCnts.withUnsafeBufferPointer { tCntBuf in
                             areaCodes.withUnsafeBufferPointer { codeBuf in
-
-                                bindingBuildTiledNavMeshWithAreas(
-                                    &config, &tileConfig, flags,
-                                    vBase, Int32(vertices.count / 3),
-                                    tBase, Int32(triangles.count / 3),
-                                    vPtrBuf.baseAddress, // now UnsafeMutablePointer
+                                body(
+                                    vPtrBuf.baseAddress,
                                     vCntBuf.baseAddress,
                                     tPtrBuf.baseAddress,
                                     tCntBuf.baseAddress,
                                     codeBuf.baseAddress,
-                                    Int32(areas.count),
-                                    agentHeight, agentRadius, agentMaxClimb
+                                    Int32(areas.count)
                                 )
                             }
                         }
@@ -331,28 +410,53 @@ public class NavMeshBuilder {
                 }
             }
         }
-
-        // ── 3.  Two *tiny* generic closures – compiler is happy now ────────────────
-        let maybePtr: UnsafeMutablePointer<BindingTileMeshResult>? =
+    }
+    
+    //  ──────────────────────────────────────────────────────────────────────────────
+    private static func makeBuildInput(
+        config: inout rcConfig,
+        tileConfig: inout TileConfig,
+        flags: Int32,
+        vertices: [Float],
+        triangles: [Int32],
+        areas: [AreaDefinition],
+        agentHeight: Float,
+        agentRadius: Float,
+        agentMaxClimb: Float
+    ) -> OpaquePointer? {
+        withAreaBuffers(areas) { vPtrs, vCnts, tPtrs, tCnts, codes, count in
             vertices.withUnsafeBufferPointer { vBuf in
                 triangles.withUnsafeBufferPointer { tBuf in
-                    guard let vBase = vBuf.baseAddress,
-                          let tBase = tBuf.baseAddress else { return nil }
-                    return makeMesh(vBase: vBase, tBase: tBase)
+                    bindingCreateTileBuildInput(
+                        &config, &tileConfig, flags,
+                        vBuf.baseAddress, Int32(vertices.count / 3),
+                        tBuf.baseAddress, Int32(triangles.count / 3),
+                        vPtrs, vCnts, tPtrs, tCnts, codes, count,
+                        agentHeight, agentRadius, agentMaxClimb
+                    )
                 }
             }
+        }
+    }
 
-        // ── 4.  Error handling / result unwrap (unchanged) ─────────────────────────
+    /// Maps the bridge status of a finished build to a result or an error.
+    /// Failed results are released before throwing.
+    private static func checkedResult(
+        _ maybePtr: UnsafeMutablePointer<BindingTileMeshResult>?
+    ) throws -> UnsafeMutablePointer<BindingTileMeshResult> {
         guard let resultPtr = maybePtr else { throw NavMeshError.memory }
 
+        let error: NavMeshError
         switch resultPtr.pointee.code {
-        case BCODE_OK where resultPtr.pointee.tilesBuilt == 0: throw NavMeshError.noTilesBuilt
+        case BCODE_OK where resultPtr.pointee.tilesBuilt == 0: error = .noTilesBuilt
         case BCODE_OK: return resultPtr
-        case BCODE_ERR_MEMORY: throw NavMeshError.memory
-        case BCODE_ERR_INIT_TILE_NAVMESH: throw NavMeshError.initTileNavMesh
-        case BCODE_ERR_BUILD_TILE: throw NavMeshError.buildTile
-        case BCODE_ERR_ADD_TILE: throw NavMeshError.addTile
-        default: throw NavMeshError.unknown
+        case BCODE_ERR_MEMORY: error = .memory
+        case BCODE_ERR_INIT_TILE_NAVMESH: error = .initTileNavMesh
+        case BCODE_ERR_BUILD_TILE: error = .buildTile
+        case BCODE_ERR_ADD_TILE: error = .addTile
+        default: error = .unknown
         }
+        bindingReleaseTiledNavMesh(resultPtr)
+        throw error
     }
 }
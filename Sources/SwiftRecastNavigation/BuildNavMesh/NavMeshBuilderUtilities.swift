@@ -94,17 +94,166 @@ extension NavMeshBuilder {
         - Status: \(result.pointee.code == BCODE_OK ? "Success" : "Error")
         """
     }
+}
+
+// MARK: - Incremental tile rebuilds
+
+extension NavMeshBuilder {
+    /// Replaces the retained input geometry. The tile grid and bounds stay as built;
+    /// call ``rebuildTiles(touching:max:in:)`` for the edited region afterwards.
+    public func updateGeometry(vertices: [SIMD3<Float>], triangles: [Int32]) throws {
+        try updateGeometry(vertices: NavMeshBuilder.flatten(vertices), triangles: triangles)
+    }
+    
+    /// Replaces the retained input geometry from flattened vertices.
+    public func updateGeometry(vertices: [Float], triangles: [Int32]) throws {
+        guard let input = buildInput else { throw NavMeshError.invalidConfiguration }
+        
+        let status = vertices.withUnsafeBufferPointer { vBuf in
+            triangles.withUnsafeBufferPointer { tBuf in
+                bindingUpdateTileBuildGeometry(
+                    input,
+                    vBuf.baseAddress, Int32(vertices.count / 3),
+                    tBuf.baseAddress, Int32(triangles.count / 3)
+                )
+            }
+        }
+        guard status == BCODE_OK else { throw NavMeshError.memory }
+    }
     
-    /// Rebuilds a specific tile at the given coordinates
-    public func rebuildTile(at worldPos: SIMD3<Float>) -> Bool {
-        // TODO: Implement tile rebuilding
-        return false
+    /// Replaces the retained area definitions.
+    public func updateAreas(_ areas: [AreaDefinition]) throws {
+        guard let input = buildInput else { throw NavMeshError.invalidConfiguration }
+        
+        let status = NavMeshBuilder.withAreaBuffers(areas) { vPtrs, vCnts, tPtrs, tCnts, codes, count in
+            bindingUpdateTileBuildAreas(input, vPtrs, vCnts, tPtrs, tCnts, codes, count)
+        }
+        guard status == BCODE_OK else { throw NavMeshError.memory }
     }
     
-    /// Removes a tile at the given coordinates
-    public func removeTile(at worldPos: SIMD3<Float>) -> Bool {
-        // TODO: Implement tile removal
-        return false
+    /// Rebuilds every tile affected by an edit inside the world-space box and swaps
+    /// the new tiles into the live navmesh.
+    ///
+    /// Tiles whose border region overlaps the box are rebuilt too, since they
+    /// rasterize geometry past their own edges.
+    /// - Parameters:
+    ///   - min: Minimum corner of the edited region
+    ///   - max: Maximum corner of the edited region
+    ///   - navMesh: Mesh to update; defaults to the mesh still owned by this builder
+    /// - Returns: The number of non-empty tiles that were rebuilt
+    @discardableResult
+    public func rebuildTiles(touching min: SIMD3<Float>, max: SIMD3<Float>, in navMesh: NavMesh? = nil) throws -> Int {
+        try rebuildTiles(touching: [(min: min, max: max)], in: navMesh)
+    }
+    
+    /// Rebuilds the tiles affected by several edited regions in one pass.
+    /// Each tile is built once, even if several regions overlap it.
+    @discardableResult
+    public func rebuildTiles(touching regions: [(min: SIMD3<Float>, max: SIMD3<Float>)], in navMesh: NavMesh? = nil) throws -> Int {
+        var tiles: [(x: Int, y: Int)] = []
+        var seen = Set<SIMD2<Int32>>()
+        
+        for region in regions {
+            guard let range = tileRange(min: region.min, max: region.max, includeBorder: true) else { continue }
+            for y in range.minY ... range.maxY {
+                for x in range.minX ... range.maxX where seen.insert(SIMD2(x, y)).inserted {
+                    tiles.append((x: Int(x), y: Int(y)))
+                }
+            }
+        }
+        return try rebuildTiles(at: tiles, in: navMesh)
+    }
+    
+    /// Rebuilds the given tiles from the retained input and swaps them into the live navmesh.
+    /// Tiles that come out empty are removed.
+    /// - Returns: The number of non-empty tiles that were rebuilt
+    @discardableResult
+    public func rebuildTiles(at tiles: [(x: Int, y: Int)], in navMesh: NavMesh? = nil) throws -> Int {
+        guard let input = buildInput, let target = targetNavMesh(navMesh) else {
+            throw NavMeshError.invalidConfiguration
+        }
+        if tiles.isEmpty { return 0 }
+        
+        var coords = [Int32]()
+        coords.reserveCapacity(tiles.count * 2)
+        for tile in tiles {
+            coords.append(Int32(tile.x))
+            coords.append(Int32(tile.y))
+        }
+        
+        var built: Int32 = 0
+        var stats = BindingBuildStats()
+        let status = withExclusiveTileAccess(navMesh) {
+            coords.withUnsafeBufferPointer { buf in
+                bindingRebuildTiles(input, target, buf.baseAddress, Int32(tiles.count), &built, &stats)
+            }
+        }
+        lastRebuildReport = BuildReport(stats)
+        bindingReleaseBuildStats(&stats)
+        
+        switch status {
+        case BCODE_OK: return Int(built)
+        case BCODE_ERR_MEMORY: throw NavMeshError.memory
+        case BCODE_ERR_ADD_TILE: throw NavMeshError.addTile
+        default: throw NavMeshError.unknown
+        }
+    }
+    
+    /// Rebuilds the tile containing the given world position
+    /// - Returns: true if the tile was rebuilt and is in the navmesh; false if the
+    ///   rebuild failed, or the tile came out empty and was removed
+    @discardableResult
+    public func rebuildTile(at worldPos: SIMD3<Float>, in navMesh: NavMesh? = nil) -> Bool {
+        guard let range = tileRange(min: worldPos, max: worldPos, includeBorder: false),
+              let added = try? rebuildTiles(at: [(x: Int(range.minX), y: Int(range.minY))], in: navMesh) else {
+            return false
+        }
+        // With layeredTiles, layers that did not change are kept instead of added again
+        return added > 0 || (lastRebuildReport?.tiles.first?.reusedLayers ?? 0) > 0
+    }
+    
+    /// Removes the tile containing the given world position
+    @discardableResult
+    public func removeTile(at worldPos: SIMD3<Float>, in navMesh: NavMesh? = nil) -> Bool {
+        guard let target = targetNavMesh(navMesh),
+              let range = tileRange(min: worldPos, max: worldPos, includeBorder: false) else {
+            return false
+        }
+        return withExclusiveTileAccess(navMesh) {
+            bindingRemoveTile(target, range.minX, range.minY) == BD_OK
+        }
+    }
+    
+    // MARK: - Private Helpers
+    
+    /// Runs a tile edit under the given mesh's tile lock; the mesh this builder
+    /// still owns has no other users to wait for
+    private func withExclusiveTileAccess<R>(_ navMesh: NavMesh?, _ body: () throws -> R) rethrows -> R {
+        if let navMesh {
+            return try navMesh.withExclusiveTileAccess(body)
+        }
+        return try body()
+    }
+    
+    /// The mesh tile edits apply to: the given one, or the mesh this builder still owns
+    private func targetNavMesh(_ navMesh: NavMesh?) -> dtNavMesh? {
+        if let navMesh {
+            return navMesh.navMesh
+        }
+        return tiledResult?.pointee.navMesh
+    }
+    
+    private func tileRange(min: SIMD3<Float>, max: SIMD3<Float>, includeBorder: Bool)
+        -> (minX: Int32, minY: Int32, maxX: Int32, maxY: Int32)? {
+        guard let input = buildInput else { return nil }
+        
+        var bmin = [min.x, min.y, min.z]
+        var bmax = [max.x, max.y, max.z]
+        var minX: Int32 = 0, minY: Int32 = 0, maxX: Int32 = 0, maxY: Int32 = 0
+        let hit = bindingGetTileRangeInBounds(input, &bmin, &bmax, includeBorder ? 1 : 0,
+                                              &minX, &minY, &maxX, &maxY)
+        guard hit != 0 else { return nil }
+        return (minX, minY, maxX, maxY)
     }
 }
 
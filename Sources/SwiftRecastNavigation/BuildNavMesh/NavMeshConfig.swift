@@ -31,6 +31,23 @@ public struct NavMeshConfig {
     /// The size of tiles in voxels. Set to 0 for single-tile (solo) mesh
     public var tileSize: Int32 = 0
     
+    /// Number of worker threads used to build tiles. 0 uses one thread per core, 1 builds serially.
+    /// The resulting mesh is identical regardless of the thread count.
+    public var buildThreadCount: Int32 = 0
+    
+    /// Number of threads splitting the distance field and watershed regions of each tile.
+    /// 0 uses `buildThreadCount` threads for single-tile (solo) builds, whose tile
+    /// pool has only one worker, and one thread for tiled builds. Regions are
+    /// identical regardless of the thread count.
+    public var regionThreadCount: Int32 = 0
+    
+    /// Directory for the on-disk tile cache, or nil to build every tile.
+    /// Each built tile is stored under a hash of its input (the triangles and area
+    /// polygons overlapping it, this configuration and the filter flags), so a
+    /// rebuild after a small edit only builds the tiles the edit touched.
+    /// The directory is created if needed; entries are never evicted.
+    public var tileCacheDirectory: URL? = nil
+    
     /// The xz-plane cell size to use for fields. [Limit: > 0] [Units: wu]
     public var cellSize: Float = 0.3
     
@@ -76,11 +93,32 @@ public struct NavMeshConfig {
     /// The maximum distance the detail mesh surface should deviate from heightfield data
     public var detailSampleMaxError: Float = 1
     
+    /// Leave detail meshes out of the build and create a tile's the first time a query or
+    /// crowd samples heights on it. Builds are faster and smaller; until then heights follow
+    /// the polygons' planes. Meshes from ``NavMeshBuilder/makeNavMesh()`` attach the detail
+    /// meshes, so they must not be queried from several threads at once. Exported data never
+    /// contains the on-demand detail meshes.
+    public var lazyDetailMesh: Bool = false
+    
+    /// Most tiles that keep an on-demand detail mesh when `lazyDetailMesh` is set; the least
+    /// recently sampled one is dropped to make room. 0 keeps every one.
+    public var lazyDetailCacheTiles: Int32 = 64
+    
+    /// Build every tile as one navmesh tile per floor, the layers the tile cache uses, instead of
+    /// one tile holding every floor. Tiles of multi-storey buildings stay small, and a rebuild
+    /// replaces only the floors whose geometry changed. Floors link where they meet, so stairs
+    /// and ramps still connect them. Streaming builds keep building whole tiles.
+    public var layeredTiles: Bool = false
+    
     /// Filtering options
     public var filterLowHangingObstacles: Bool = false
     public var filterLedgeSpans: Bool = false
     public var filterWalkableLowHeightSpans: Bool = false
     
+    /// Weld and cull the input geometry before building, or nil to build from it as it is.
+    /// Area definitions are not preprocessed. See ``NavMeshBuilder/preprocessingStats``.
+    public var geometryPreprocessing: GeometryPreprocessing? = nil
+    
     /// Custom bounds (optional - computed from geometry if not set)
     public var bounds: (min: SIMD3<Float>, max: SIMD3<Float>)?
     
@@ -0,0 +1,277 @@
+// SPDX-License-Identifier: MIT
+//
+//  StreamingNavMeshBuild.swift
+//  SwiftRecastNavigation
+//
+//  Builds tiles in the background and adds them to a live navmesh as they finish
+//
+
+import CRecast
+import Foundation
+
+/// Progress of a streaming build, produced once per finished tile
+public struct TileBuildProgress {
+    /// Tile column
+    public let x: Int
+    /// Tile row
+    public let y: Int
+    /// Whether the tile produced polygons and was added to the navmesh
+    public let added: Bool
+    /// Statistics of the tile build
+    public let tile: BuildReport.TileReport
+    /// Tiles finished so far, including this one
+    public let tilesCompleted: Int
+    /// Tiles in the whole build
+    public let totalTiles: Int
+
+    /// Fraction of the build that is done, from 0 to 1
+    public var fractionCompleted: Double {
+        totalTiles > 0 ? Double(tilesCompleted) / Double(totalTiles) : 1
+    }
+}
+
+/// A navmesh that fills in tile by tile while it is being used.
+///
+/// ``navMesh`` is available right away and starts out empty. Tiles are built on
+/// background tasks, nearest to the focus point first, and each one is added to
+/// the navmesh when the sequence produces its ``TileBuildProgress``. That makes
+/// the iterating task the only writer: iterate from the same actor or thread
+/// that queries the navmesh, and paths become available as soon as the tiles
+/// around them exist.
+///
+/// ```swift
+/// let build = try NavMeshBuilder.streamingBuild(vertices: verts, triangles: tris, focus: player)
+/// let query = try build.navMesh.makeQuery()
+/// for try await progress in build {
+///     loadingBar.value = progress.fractionCompleted
+/// }
+/// ```
+///
+/// Cancel the build with ``cancel()`` or by cancelling the iterating task.
+/// Tiles that are already building finish, nothing new is started, and tiles
+/// that were built but not yet added are dropped. Do not call `updateGeometry`
+/// or `updateAreas` on ``builder`` before the sequence ends.
+public final class StreamingNavMeshBuild: AsyncSequence {
+    public typealias Element = TileBuildProgress
+
+    /// The builder holding the build input; use it to rebuild tiles of ``navMesh`` later
+    public let builder: NavMeshBuilder
+
+    /// The navmesh tiles are added to
+    public let navMesh: NavMesh
+
+    /// Tiles in the whole build
+    public let totalTiles: Int
+
+    private let tiles: AsyncStream<BuiltTile>
+    private let producer: Task<Void, Never>
+
+    /// A tile built off the navmesh. Data that never reaches the navmesh is
+    /// freed with the wrapper, including tiles still buffered when the build
+    /// is cancelled.
+    final class BuiltTile: @unchecked Sendable {
+        let x: Int
+        let y: Int
+        var data: UnsafeMutablePointer<UInt8>?
+        let dataSize: Int32
+        let stats: BindingTileStats
+
+        init(x: Int, y: Int, data: UnsafeMutablePointer<UInt8>?, dataSize: Int32, stats: BindingTileStats) {
+            self.x = x
+            self.y = y
+            self.data = data
+            self.dataSize = dataSize
+            self.stats = stats
+        }
+
+        deinit {
+            if let data {
+                bindingFreeTileData(data)
+            }
+        }
+    }
+
+    init(builder: NavMeshBuilder, focus: SIMD3<Float>?, priority: TaskPriority?) throws {
+        guard let input = builder.buildInput else { throw NavMeshError.invalidConfiguration }
+
+        var code = BCODE_OK
+        guard let handle = bindingCreateTiledNavMesh(input, &code) else {
+            throw code == BCODE_ERR_MEMORY ? NavMeshError.memory : NavMeshError.initTileNavMesh
+        }
+        do {
+            navMesh = try builder.wrapNavMesh(handle)
+        } catch {
+            dtFreeNavMesh(handle)
+            throw error
+        }
+        self.builder = builder
+
+        var tw: Int32 = 0, th: Int32 = 0
+        bindingGetTileGridSize(input, &tw, &th)
+        var coords = [Int32]()
+        coords.reserveCapacity(Int(tw * th) * 2)
+        for y in 0 ..< th {
+            for x in 0 ..< tw {
+                coords.append(x)
+                coords.append(y)
+            }
+        }
+        if var focus = focus.map({ [$0.x, $0.y, $0.z] }) {
+            bindingSortTilesByDistance(input, &focus, &coords, tw * th)
+        }
+        totalTiles = Int(tw * th)
+
+        let threads = builder.config.buildThreadCount > 0
+            ? Int(builder.config.buildThreadCount)
+            : ProcessInfo.processInfo.activeProcessorCount
+        let order = coords
+        let count = totalTiles
+
+        let (stream, output) = AsyncStream.makeStream(of: BuiltTile.self)
+        tiles = stream
+
+        // The task keeps the builder, and with it the build input, alive
+        // until the last tile build has returned.
+        producer = Task.detached(priority: priority) {
+            await withTaskGroup(of: Void.self) { group in
+                var next = 0
+                while next < min(threads, count) {
+                    let i = next
+                    group.addTask { output.yield(Self.buildTile(builder, order, i)) }
+                    next += 1
+                }
+                while await group.next() != nil {
+                    if Task.isCancelled || next >= count { continue }
+                    let i = next
+                    group.addTask { output.yield(Self.buildTile(builder, order, i)) }
+                    next += 1
+                }
+            }
+            output.finish()
+        }
+    }
+
+    deinit {
+        producer.cancel()
+    }
+
+    /// Stops starting new tiles. Tiles already built but not yet added are dropped.
+    public func cancel() {
+        producer.cancel()
+    }
+
+    public func makeAsyncIterator() -> AsyncIterator {
+        AsyncIterator(build: self, tiles: tiles.makeAsyncIterator())
+    }
+
+    public struct AsyncIterator: AsyncIteratorProtocol {
+        let build: StreamingNavMeshBuild
+        var tiles: AsyncStream<BuiltTile>.Iterator
+        var completed = 0
+
+        /// Waits for the next tile, adds it to the navmesh and reports it.
+        /// Returns nil once every tile is done or the build was cancelled.
+        public mutating func next() async throws -> TileBuildProgress? {
+            let tile = await tiles.next()
+            if Task.isCancelled {
+                build.cancel()
+                throw CancellationError()
+            }
+            // After cancel() the tiles still buffered are dropped, not added
+            guard let tile, !build.producer.isCancelled else { return nil }
+
+            var added = false
+            if let data = tile.data {
+                tile.data = nil
+                let code = build.navMesh.withExclusiveTileAccess {
+                    bindingAddTileData(build.navMesh.navMesh, data, tile.dataSize)
+                }
+                guard code == BCODE_OK else {
+                    build.cancel()
+                    throw NavMeshError.addTile
+                }
+                added = true
+            }
+
+            completed += 1
+            return TileBuildProgress(
+                x: tile.x,
+                y: tile.y,
+                added: added,
+                tile: BuildReport.TileReport(tile.stats),
+                tilesCompleted: completed,
+                totalTiles: build.totalTiles
+            )
+        }
+    }
+
+    /// Builds entry `index` of the (x, y) pairs in `order`
+    private static func buildTile(_ builder: NavMeshBuilder, _ order: [Int32], _ index: Int) -> BuiltTile {
+        let x = order[index * 2], y = order[index * 2 + 1]
+        var size: Int32 = 0
+        var stats = BindingTileStats()
+        var data: UnsafeMutablePointer<UInt8>?
+        if let input = builder.buildInput {
+            data = bindingBuildTileData(input, x, y, &size, &stats)
+        }
+        return BuiltTile(x: Int(x), y: Int(y), data: data, dataSize: size, stats: stats)
+    }
+}
+
+extension NavMeshBuilder {
+    /// Starts a streaming build and returns at once, before any tile exists.
+    ///
+    /// Tiles nearest `focus` are built first. Iterate the returned sequence to
+    /// add tiles to its ``StreamingNavMeshBuild/navMesh`` as they finish.
+    /// - Parameters:
+    ///   - vertices: Array of vertices
+    ///   - triangles: Triangle index array
+    ///   - config: Configuration for mesh creation
+    ///   - areas: Optional array of area definitions for marking special regions
+    ///   - focus: World position to build outwards from; nil builds in row order
+    ///   - priority: Priority of the background tile builds
+    public static func streamingBuild(
+        vertices: [SIMD3<Float>],
+        triangles: [Int32],
+        config: NavMeshConfig = NavMeshConfig(),
+        areas: [AreaDefinition] = [],
+        focus: SIMD3<Float>? = nil,
+        priority: TaskPriority? = nil
+    ) throws -> StreamingNavMeshBuild {
+        try streamingBuild(
+            vertices: flatten(vertices),
+            triangles: triangles,
+            config: config,
+            areas: areas,
+            focus: focus,
+            priority: priority
+        )
+    }
+
+    /// Starts a streaming build from flattened vertices and triangles
+    public static func streamingBuild(
+        vertices: [Float],
+        triangles: [Int32],
+        config: NavMeshConfig = NavMeshConfig(),
+        areas: [AreaDefinition] = [],
+        focus: SIMD3<Float>? = nil,
+        priority: TaskPriority? = nil
+    ) throws -> StreamingNavMeshBuild {
+        let builder = try NavMeshBuilder(
+            vertices: vertices,
+            triangles: triangles,
+            config: config,
+            areas: areas,
+            buildTiles: false
+        )
+        return try builder.makeStreamingBuild(focus: focus, priority: priority)
+    }
+
+    /// Streams a fresh build of this builder's current input into a new navmesh
+    public func makeStreamingBuild(
+        focus: SIMD3<Float>? = nil,
+        priority: TaskPriority? = nil
+    ) throws -> StreamingNavMeshBuild {
+        try StreamingNavMeshBuild(builder: self, focus: focus, priority: priority)
+    }
+}
@@ -10,6 +10,9 @@
 
 import Foundation
 import CRecast
+#if canImport(os)
+import os
+#endif
 
 /// Crowds implement local steering and dynamic avoidance features.
 ///
@@ -64,6 +67,205 @@ public class Crowd {
     }
     
     var crowd: dtCrowd
+    /// The navmesh the crowd moves on
+    let navMesh: NavMesh
+    /// Flow fields agents follow, by agent index
+    var flowFields: [Int32: NavMeshFlowField] = [:]
+    #if canImport(os)
+    /// Emits the signposts while ``signposts`` is on
+    var signposter: PhaseSignposter?
+    #endif
+
+    /// Polygons each flow field that agents follow may search per ``update(time:)``
+    public var flowFieldIterations = 4096
+
+    /// Threads ``update(time:)`` splits the agents across, including the calling one; 0 for one per core.
+    ///
+    /// Each thread has its own navmesh and obstacle avoidance queries, and the
+    /// simulation comes out the same for any count. Path requests stay on the
+    /// calling thread. Crowds with fewer than 64 agents, and navmeshes building
+    /// lazy detail meshes, update on the calling thread only.
+    public var updateThreadCount: Int {
+        get { Int(crowd.getUpdateThreads()) }
+        set {
+            let count = newValue > 0 ? newValue : ProcessInfo.processInfo.activeProcessorCount
+            _ = crowd.setUpdateThreads(Int32(min(count, Int(DT_CROWD_MAX_THREADS))))
+        }
+    }
+
+    /// Whether the crowd finds neighbours with the grid built for large crowds.
+    ///
+    /// The large crowd grid holds each agent once, by its position, and sizes
+    /// its cells on every update from the agents' collision query range and how
+    /// densely they are packed. It pays off from a few hundred agents up.
+    public var highCapacity: Bool {
+        get { crowd.getHighCapacity() }
+        set { _ = crowd.setHighCapacity(newValue) }
+    }
+
+    /// How many of their nearest neighbours agents steer and avoid by, between 1
+    /// and `DT_CROWDAGENT_MAX_NEIGHBOURS`; defaults to 6.
+    public var maxNeighbours: Int {
+        get { Int(crowd.getMaxNeighbours()) }
+        set { _ = crowd.setMaxNeighbours(Int32(max(1, min(newValue, Int(DT_CROWDAGENT_MAX_NEIGHBOURS))))) }
+    }
+
+    /// Search iterations the path queue may spend on full paths per ``update(time:)``, 0 for no limit; defaults to 100.
+    ///
+    /// Agents whose target is not reached by a quick search walk a partial corridor
+    /// until their full path comes out of the queue, so a larger budget gets them
+    /// on the right corridor sooner when many agents retarget at once.
+    /// ``pathQueueStats`` shows how long they wait.
+    public var pathQueueIterations: Int {
+        get { Int(crowd.getPathQueueMaxIterations()) }
+        set { _ = crowd.setPathQueueBudget(Int32(max(0, newValue)), crowd.getPathQueueMaxTime()) }
+    }
+
+    /// Milliseconds the path queue may spend on full paths per ``update(time:)``, 0 for no limit (the default).
+    ///
+    /// Applies together with ``pathQueueIterations``; set that to 0 for a pure time budget.
+    public var pathQueueTimeBudget: Float {
+        get { crowd.getPathQueueMaxTime() }
+        set { _ = crowd.setPathQueueBudget(crowd.getPathQueueMaxIterations(), max(0, newValue)) }
+    }
+
+    /// Full path requests the path queue holds at once; defaults to 8.
+    ///
+    /// Changing it drops the requests in the queue, and their agents queue again.
+    public var pathQueueCapacity: Int {
+        get { Int(crowd.getPathQueueSize()) }
+        set { _ = crowd.setPathQueueSize(Int32(max(1, newValue))) }
+    }
+
+    /// Path queue counters, see ``PathQueueStats``.
+    public var pathQueueStats: PathQueueStats {
+        var s = dtCrowdPathQueueStats()
+        crowd.getPathQueueStats(&s)
+        return PathQueueStats(waitingAgents: Int(s.waitingAgents), pendingRequests: Int(s.pendingRequests),
+                              lastIterations: Int(s.lastIterations), completedPaths: Int(s.completedPaths),
+                              failedPaths: Int(s.failedPaths), lastLatency: s.lastLatency,
+                              meanLatency: s.meanLatency, maxLatency: s.maxLatency)
+    }
+
+    /// Resets the path counts and latencies of ``pathQueueStats``.
+    public func resetPathQueueStats() {
+        crowd.resetPathQueueStats()
+    }
+
+    /// Starts timing the phases of ``update(time:)``, clearing ``profile``.
+    ///
+    /// While profiling is off, the crowd only tests a flag once per phase.
+    /// - Parameter window: Updates summed before ``profile`` reports them, or 0 to sum
+    ///   every update until ``resetProfile()``
+    public func startProfiling(window: Int = 0) {
+        crowd.setProfiling(true, Int32(max(0, window)))
+    }
+
+    /// Stops timing the updates; ``profile`` keeps what was measured.
+    public func stopProfiling() {
+        crowd.setProfiling(false, crowd.getProfileWindow())
+    }
+
+    /// True between ``startProfiling(window:)`` and ``stopProfiling()``.
+    public var isProfiling: Bool {
+        crowd.getProfiling()
+    }
+
+    /// The updates timed so far, or the last full window of them, see ``Profile``.
+    public var profile: Profile {
+        var p = dtCrowdProfile()
+        crowd.getProfile(&p)
+        return Profile(p)
+    }
+
+    /// Clears ``profile``.
+    public func resetProfile() {
+        crowd.resetProfile()
+    }
+
+    #if canImport(os)
+    /// Emits an Instruments signpost interval for each phase of ``update(time:)``, under the
+    /// `com.swiftrecastnavigation` subsystem and `Crowd` category. Off by default.
+    public var signposts: Bool {
+        get { signposter != nil }
+        set {
+            guard newValue != signposts else { return }
+            if newValue {
+                let signposter = PhaseSignposter()
+                self.signposter = signposter
+                crowd.setProfileCallback({ userData, phase, begin in
+                    Unmanaged<PhaseSignposter>.fromOpaque(userData!).takeUnretainedValue().mark(phase: Int(phase), begin: begin)
+                }, Unmanaged.passUnretained(signposter).toOpaque())
+            } else {
+                crowd.setProfileCallback(nil, nil)
+                signposter = nil
+            }
+        }
+    }
+
+    /// Turns the phase callbacks of `dtCrowd` into signpost intervals
+    final class PhaseSignposter {
+        let signposter = OSSignposter(subsystem: "com.swiftrecastnavigation", category: "Crowd")
+        var intervals = [OSSignpostIntervalState?](repeating: nil, count: Phase.allCases.count)
+
+        func mark(phase: Int, begin: Bool) {
+            guard let kind = Phase(rawValue: phase) else { return }
+            if begin {
+                intervals[phase] = open(kind)
+            } else if let state = intervals[phase] {
+                close(kind, state)
+                intervals[phase] = nil
+            }
+        }
+
+        // Signpost names must be static strings
+        private func open(_ phase: Phase) -> OSSignpostIntervalState {
+            switch phase {
+            case .pathValidity: return signposter.beginInterval("PathValidity")
+            case .moveRequest: return signposter.beginInterval("MoveRequest")
+            case .topology: return signposter.beginInterval("Topology")
+            case .neighbours: return signposter.beginInterval("Neighbours")
+            case .corners: return signposter.beginInterval("Corners")
+            case .steering: return signposter.beginInterval("Steering")
+            case .avoidance: return signposter.beginInterval("Avoidance")
+            case .integrate: return signposter.beginInterval("Integrate")
+            case .collision: return signposter.beginInterval("Collision")
+            case .move: return signposter.beginInterval("Move")
+            }
+        }
+
+        private func close(_ phase: Phase, _ state: OSSignpostIntervalState) {
+            switch phase {
+            case .pathValidity: signposter.endInterval("PathValidity", state)
+            case .moveRequest: signposter.endInterval("MoveRequest", state)
+            case .topology: signposter.endInterval("Topology", state)
+            case .neighbours: signposter.endInterval("Neighbours", state)
+            case .corners: signposter.endInterval("Corners", state)
+            case .steering: signposter.endInterval("Steering", state)
+            case .avoidance: signposter.endInterval("Avoidance", state)
+            case .integrate: signposter.endInterval("Integrate", state)
+            case .collision: signposter.endInterval("Collision", state)
+            case .move: signposter.endInterval("Move", state)
+            }
+        }
+    }
+    #endif
+
+    /// Point that agents' level of detail tiers are picked by, from their distance to it, or nil to
+    /// keep the tiers set with ``CrowdAgent/lodTier``.
+    ///
+    /// Typically the camera or player position, updated before each ``update(time:)``.
+    /// Tier distances are set with ``setLod(tier:config:)``.
+    public var lodReference: SIMD3<Float>? {
+        didSet {
+            if let p = lodReference {
+                var pos: [Float] = [p.x, p.y, p.z]
+                crowd.setLodReference(&pos)
+            } else {
+                crowd.setLodReference(nil)
+            }
+        }
+    }
 
     init (maxAgents: Int32, agentRadius: Float, nav: NavMesh) throws {
         guard let crowd = dtAllocCrowd() else {
@@ -73,6 +275,7 @@ public class Crowd {
             throw CrowdError.initialization
         }
         self.crowd = crowd
+        self.navMesh = nav
     }
     
     /// Sets the shared avoidance configuration for the specified index.
@@ -106,6 +309,31 @@ public class Crowd {
         return ObstacleAvoidanceConfig(velocitySelectionBias: r.velBias, desiredVelocityWeight: r.weightDesVel, currentVelocityWeight: r.weightCurVel, preferredSideWeight: r.weightSide, collisionTimeWeight: r.weightToi, timeHorizon: r.horizTime, samplingGridSize: r.gridSize, adaptiveDivs: r.adaptiveDivs, adaptiveRings: r.adaptiveRings, adaptiveDepth: r.adaptiveDepth)
     }
         
+    /// Sets the configuration of a level of detail tier.
+    ///
+    /// The tiers default to full updates in tier 0; updates every 0.1 seconds from 30 units in tier 1;
+    /// every 0.25 seconds with separation only from 60 units in tier 2; and every 0.5 seconds with
+    /// straight steering from 120 units in tier 3.
+    /// - Parameters:
+    ///  - tier: the tier, between 0 and 3
+    ///  - config: the configuration parameters
+    public func setLod(tier: Int, config: LodConfig) {
+        var p = dtCrowdLodParams(distance: config.distance,
+                                 updateInterval: config.updateInterval,
+                                 boundaryScale: config.boundaryScale,
+                                 steering: config.steering.rawValue)
+        crowd.setLodParams(Int32(tier), &p)
+    }
+
+    /// Returns the configuration of a level of detail tier, or nil for a tier out of range.
+    public func getLod(tier: Int) -> LodConfig? {
+        guard let r = crowd.getLodParams(Int32(tier))?.pointee else {
+            return nil
+        }
+        return LodConfig(distance: r.distance, updateInterval: r.updateInterval, boundaryScale: r.boundaryScale,
+                         steering: LodSteering(rawValue: r.steering) ?? .full)
+    }
+
     /// Adds a new agent to the crowd, convenience function that takes many optional arguments and default to some suitable values
     /// - Parameters:
     ///   - position: Requested position for the agent.
@@ -171,18 +399,104 @@ public class Crowd {
     /// Removes an agent from the crowd
     public func remove (agent: CrowdAgent) {
         crowd.removeAgent(agent.idx)
+        flowFields[agent.idx] = nil
         agent.idx = -1
     }
     
     /// Update the simulation.
+    ///
+    /// Flow fields that agents follow first search up to ``flowFieldIterations``
+    /// polygons each, when a search of theirs is under way or tiles changed.
     /// - Parameter dt: the time in seconds, to update the simulation
     public func update (time: Float) {
+        advanceFlowFields()
         crowd.update(time, nil)
     }
+
+    /// Continues the searches of the flow fields that agents follow.
+    func advanceFlowFields() {
+        var advanced = Set<ObjectIdentifier>()
+        for field in flowFields.values where advanced.insert(ObjectIdentifier(field)).inserted {
+            _ = try? field.update(maxIterations: flowFieldIterations)
+        }
+    }
     
+    /// Fills a snapshot with the state of every active agent, in one pass over the crowd.
+    ///
+    /// Reuse the same snapshot across updates to avoid reallocating its buffers.
+    /// - Parameter snapshot: the snapshot to overwrite
+    public func snapshot(into snapshot: inout Snapshot) {
+        let capacity = maxAgentCount
+        let stride = MemoryLayout<SIMD3<Float>>.stride / MemoryLayout<Float>.stride
+        snapshot.agentIndices.append(contentsOf: repeatElement(0, count: capacity - snapshot.agentIndices.count))
+        snapshot.positions.append(contentsOf: repeatElement(.zero, count: capacity - snapshot.positions.count))
+        snapshot.velocities.append(contentsOf: repeatElement(.zero, count: capacity - snapshot.velocities.count))
+        snapshot.states.append(contentsOf: repeatElement(0, count: capacity - snapshot.states.count))
+
+        var indices = snapshot.agentIndices
+        var positions = snapshot.positions
+        var velocities = snapshot.velocities
+        var states = snapshot.states
+        snapshot = Snapshot()
+        let count = indices.withUnsafeMutableBufferPointer { idx in
+            positions.withUnsafeMutableBufferPointer { pos in
+                velocities.withUnsafeMutableBufferPointer { vel in
+                    states.withUnsafeMutableBufferPointer { st in
+                        let p = UnsafeMutableRawPointer(pos.baseAddress!).assumingMemoryBound(to: Float.self)
+                        let v = UnsafeMutableRawPointer(vel.baseAddress!).assumingMemoryBound(to: Float.self)
+                        return Int(crowd.getAgentSnapshot(idx.baseAddress, p, v, st.baseAddress, Int32(stride), Int32(capacity)))
+                    }
+                }
+            }
+        }
+        indices.removeLast(capacity - count)
+        positions.removeLast(capacity - count)
+        velocities.removeLast(capacity - count)
+        states.removeLast(capacity - count)
+        snapshot = Snapshot(agentIndices: indices, positions: positions, velocities: velocities, states: states)
+    }
+
+    /// Returns the state of every active agent, see ``snapshot(into:)``.
+    public func snapshot() -> Snapshot {
+        var result = Snapshot()
+        snapshot(into: &result)
+        return result
+    }
+
+    /// Calls `body` with the agent positions by agent index, as of the last ``update(time:)``.
+    func withAgentPositions<R>(_ body: (UnsafePointer<Float>) throws -> R) rethrows -> R {
+        try body(crowd.getAgentPositions())
+    }
+
     deinit {
         dtFreeCrowd (crowd)
     }
+
+    /// The state of the active agents of a crowd, filled by ``Crowd/snapshot(into:)``.
+    ///
+    /// The arrays hold one entry per active agent, in agent index order.
+    public struct Snapshot {
+        /// The agent index of each agent, ``CrowdAgent/agentIndex``.
+        public internal(set) var agentIndices: [Int32] = []
+        /// The position of each agent.
+        public internal(set) var positions: [SIMD3<Float>] = []
+        /// The actual velocity of each agent.
+        public internal(set) var velocities: [SIMD3<Float>] = []
+        /// The state of each agent, see `CrowdAgentState`.
+        public internal(set) var states: [UInt8] = []
+
+        public init() {}
+
+        init(agentIndices: [Int32], positions: [SIMD3<Float>], velocities: [SIMD3<Float>], states: [UInt8]) {
+            self.agentIndices = agentIndices
+            self.positions = positions
+            self.velocities = velocities
+            self.states = states
+        }
+
+        /// The number of agents in the snapshot.
+        public var count: Int { agentIndices.count }
+    }
     
     /// Obstacle configuration information, you can create up to eight of these and set them
     /// on the ``Crowd`` instance by calling ``setObstacleAvoidance(idx:config:)``.
@@ -199,6 +513,126 @@ public class Crowd {
         public var adaptiveDepth: UInt8
     }
     
+    /// Counters of the crowd's full path queue.
+    public struct PathQueueStats {
+        /// Agents waiting for a free slot in the queue.
+        public var waitingAgents: Int
+        /// Requests in the queue, waiting for or under search.
+        public var pendingRequests: Int
+        /// Search iterations spent by the last ``Crowd/update(time:)``.
+        public var lastIterations: Int
+        /// Full paths delivered since the last ``Crowd/resetPathQueueStats()``.
+        public var completedPaths: Int
+        /// Full path searches that failed since the last reset.
+        public var failedPaths: Int
+        /// Seconds of simulation the last delivered path took, from its agent starting to wait for it.
+        public var lastLatency: Float
+        /// Mean seconds paths took since the last reset.
+        public var meanLatency: Float
+        /// Longest seconds a path took since the last reset.
+        public var maxLatency: Float
+    }
+
+    /// The phases of ``Crowd/update(time:)``, in the order they run.
+    public enum Phase: Int, CaseIterable {
+        /// Checking that the agent paths are still valid
+        case pathValidity
+        /// Starting move requests and running the path queue
+        case moveRequest
+        /// Optimizing the path topology
+        case topology
+        /// Level of detail, neighbours and local boundaries
+        case neighbours
+        /// Finding the corners to steer to and triggering off-mesh connections
+        case corners
+        /// Calculating the desired velocities
+        case steering
+        /// Sampling velocities to avoid obstacles
+        case avoidance
+        /// Integrating the velocities
+        case integrate
+        /// Resolving collisions between agents
+        case collision
+        /// Moving the agents along their corridors and off-mesh connections
+        case move
+    }
+
+    /// Timings and counters of ``Crowd/update(time:)``, summed over the updates profiled.
+    public struct Profile {
+        /// The updates summed.
+        public var updates: Int
+        /// Milliseconds spent in each phase, indexed by ``Phase``.
+        public var phaseTimes: [Float]
+        /// Longest milliseconds one update spent in each phase, indexed by ``Phase``.
+        public var phaseMaxTimes: [Float]
+        /// Milliseconds spent in the updates.
+        public var updateTime: Float
+        /// Longest milliseconds of one update.
+        public var updateMaxTime: Float
+        /// Move requests that started a path search.
+        public var pathRequests: Int
+        /// Those of the requests that replanned an existing path.
+        public var pathReplans: Int
+        /// Search iterations run by the full path queue.
+        public var pathQueueIterations: Int
+        /// Velocities sampled by obstacle avoidance.
+        public var avoidanceSamples: Int
+
+        init(_ p: dtCrowdProfile) {
+            updates = Int(p.updates)
+            phaseTimes = withUnsafeBytes(of: p.phaseTime) { Array($0.bindMemory(to: Float.self)) }
+            phaseMaxTimes = withUnsafeBytes(of: p.phaseMaxTime) { Array($0.bindMemory(to: Float.self)) }
+            updateTime = p.updateTime
+            updateMaxTime = p.updateMaxTime
+            pathRequests = Int(p.pathRequests)
+            pathReplans = Int(p.pathReplans)
+            pathQueueIterations = Int(p.pathQueueIterations)
+            avoidanceSamples = Int(p.avoidanceSamples)
+        }
+
+        /// Milliseconds spent in `phase`.
+        public func time(_ phase: Phase) -> Float {
+            phaseTimes[phase.rawValue]
+        }
+
+        /// Mean milliseconds of an update.
+        public var meanUpdateTime: Float {
+            updates > 0 ? updateTime / Float(updates) : 0
+        }
+    }
+
+    /// How agents in a level of detail tier steer.
+    public enum LodSteering: UInt8 {
+        /// As the agent's ``CrowdAgent/UpdateFlags`` ask
+        case full = 0
+        /// Separation only, without obstacle avoidance
+        case separation = 1
+        /// Straight at the path corners, without separation or obstacle avoidance
+        case direct = 2
+    }
+
+    /// Level of detail configuration, set on the ``Crowd`` for each of its four tiers with
+    /// ``setLod(tier:config:)``. Agents are placed in tiers with ``CrowdAgent/lodTier``,
+    /// or by their distance to ``lodReference``.
+    public struct LodConfig {
+        /// Distance from ``Crowd/lodReference`` at which agents enter the tier.
+        public var distance: Float
+        /// Seconds between neighbour searches and obstacle avoidance, 0 for every update.
+        /// In between, agents keep their neighbours and planned velocity.
+        public var updateInterval: Float
+        /// Scale of the distance agents move before their local boundary is rebuilt, at least 1.
+        public var boundaryScale: Float
+        /// How the agents steer.
+        public var steering: LodSteering
+
+        public init(distance: Float, updateInterval: Float, boundaryScale: Float = 1, steering: LodSteering = .full) {
+            self.distance = distance
+            self.updateInterval = updateInterval
+            self.boundaryScale = boundaryScale
+            self.steering = steering
+        }
+    }
+
     /// The maximum number of agents that can be managed by the object.
     public var maxAgentCount: Int {
         Int (crowd.getAgentCount())
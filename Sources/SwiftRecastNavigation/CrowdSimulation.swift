@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: MIT
+//
+//  CrowdSimulation.swift
+//  SwiftRecastNavigation
+//
+//  A crowd stepped at a fixed rate on a thread of its own
+//
+
+import CRecast
+import Foundation
+#if canImport(Darwin)
+import Darwin
+#elseif canImport(Glibc)
+import Glibc
+#endif
+
+/// Runs a ``Crowd`` on a background thread at a fixed tick, so that a large
+/// crowd does not take its update out of the frame.
+///
+/// After every tick the simulation publishes the agent positions, velocities
+/// and states. ``readLatest(into:)`` copies the newest of them without waiting
+/// for the tick under way, and never sees a tick half written.
+///
+/// ```swift
+/// let simulation = try CrowdSimulation(crowd: crowd, tickRate: 30)
+/// simulation.start()
+/// simulation.requestMove(agent, target: objective)
+/// // Every frame:
+/// var snapshot = Crowd.Snapshot()
+/// simulation.readLatest(into: &snapshot)
+/// ```
+///
+/// While the simulation runs, the crowd belongs to its thread: change it only
+/// from closures given to ``enqueue(_:)``, which run before the next tick, or
+/// while it is stopped. This includes adding and removing agents and moving them.
+/// Commands can be enqueued from any thread, ``readLatest(into:)`` must be
+/// called from one thread at a time. Each tick holds shared tile access while
+/// it updates the crowd.
+///
+/// The running thread keeps the simulation alive until ``stop()``.
+public final class CrowdSimulation: @unchecked Sendable {
+    /// The crowd being simulated
+    public let crowd: Crowd
+    /// Seconds simulated by each tick
+    public let tickInterval: Float
+    /// The most ticks run back to back to catch up after a late one; ticks
+    /// further behind are dropped, and ``droppedTicks`` counts them
+    public let maxCatchUpTicks: Int
+
+    private let mutex = UnsafeMutablePointer<pthread_mutex_t>.allocate(capacity: 1)
+    private let wake = DispatchSemaphore(value: 0)
+    private let finished = DispatchSemaphore(value: 0)
+    private let buffer: dtCrowdSnapshotBuffer
+    private var commands: [(Crowd) -> Void] = []
+    private var running = false
+    private var dropped = 0
+    // Only touched by the simulation thread, or while stopped
+    private var tick: UInt32 = 0
+    private var time: Float = 0
+
+    /// Creates a simulation of `crowd`, stopped.
+    /// - Parameters:
+    ///   - crowd: The crowd to simulate
+    ///   - tickRate: Ticks per second
+    ///   - maxCatchUpTicks: The most ticks to run at once after falling behind
+    public init(crowd: Crowd, tickRate: Float = 30, maxCatchUpTicks: Int = 4) throws {
+        guard let buffer = dtAllocCrowdSnapshotBuffer() else {
+            throw Crowd.CrowdError.alloc
+        }
+        guard buffer.`init`(Int32(crowd.maxAgentCount)) else {
+            dtFreeCrowdSnapshotBuffer(buffer)
+            throw Crowd.CrowdError.alloc
+        }
+        self.crowd = crowd
+        self.buffer = buffer
+        self.tickInterval = 1 / max(tickRate, 1)
+        self.maxCatchUpTicks = max(maxCatchUpTicks, 1)
+        pthread_mutex_init(mutex, nil)
+    }
+
+    deinit {
+        dtFreeCrowdSnapshotBuffer(buffer)
+        pthread_mutex_destroy(mutex)
+        mutex.deallocate()
+    }
+
+    /// True between ``start()`` and ``stop()``
+    public var isRunning: Bool {
+        pthread_mutex_lock(mutex)
+        defer { pthread_mutex_unlock(mutex) }
+        return running
+    }
+
+    /// Ticks dropped because the simulation fell more than ``maxCatchUpTicks`` behind
+    public var droppedTicks: Int {
+        pthread_mutex_lock(mutex)
+        defer { pthread_mutex_unlock(mutex) }
+        return dropped
+    }
+
+    /// Starts ticking on a new thread; the first tick runs right away.
+    public func start() {
+        pthread_mutex_lock(mutex)
+        defer { pthread_mutex_unlock(mutex) }
+        if running {
+            return
+        }
+        running = true
+        let thread = Thread { self.run() }
+        thread.name = "CrowdSimulation"
+        thread.qualityOfService = .userInteractive
+        thread.start()
+    }
+
+    /// Stops ticking and waits for the tick under way to finish.
+    ///
+    /// Commands still queued run before the next tick after ``start()``.
+    public func stop() {
+        pthread_mutex_lock(mutex)
+        if !running {
+            pthread_mutex_unlock(mutex)
+            return
+        }
+        running = false
+        pthread_mutex_unlock(mutex)
+        wake.signal()
+        finished.wait()
+    }
+
+    /// Queues `body` to run on the simulation thread before the next tick.
+    public func enqueue(_ body: @escaping (Crowd) -> Void) {
+        pthread_mutex_lock(mutex)
+        commands.append(body)
+        pthread_mutex_unlock(mutex)
+    }
+
+    /// Queues ``CrowdAgent/requestMove(target:)`` for the next tick.
+    public func requestMove(_ agent: CrowdAgent, target: PointInPoly) {
+        enqueue { _ in _ = agent.requestMove(target: target) }
+    }
+
+    /// Queues ``CrowdAgent/requestMove(velocity:)`` for the next tick.
+    public func requestMove(_ agent: CrowdAgent, velocity: SIMD3<Float>) {
+        enqueue { _ in _ = agent.requestMove(velocity: velocity) }
+    }
+
+    /// Queues ``CrowdAgent/resetMove()`` for the next tick.
+    public func resetMove(_ agent: CrowdAgent) {
+        enqueue { _ in _ = agent.resetMove() }
+    }
+
+    /// Copies the state published by the newest tick.
+    ///
+    /// Reuse the same snapshot across frames to avoid reallocating its buffers.
+    /// - Parameter snapshot: the snapshot to overwrite
+    /// - Returns: the tick the state is from, counted from 1, and 0 before the first tick
+    @discardableResult
+    public func readLatest(into snapshot: inout Crowd.Snapshot) -> Int {
+        let s = buffer.acquire().pointee
+        let count = Int(s.count)
+        snapshot.agentIndices.removeAll(keepingCapacity: true)
+        snapshot.positions.removeAll(keepingCapacity: true)
+        snapshot.velocities.removeAll(keepingCapacity: true)
+        snapshot.states.removeAll(keepingCapacity: true)
+        if count > 0 {
+            // The buffer lays out positions and velocities four floats apart, as SIMD3<Float>
+            snapshot.agentIndices.append(contentsOf: UnsafeBufferPointer(start: s.indices, count: count))
+            snapshot.positions.append(contentsOf: UnsafeBufferPointer(
+                start: UnsafeRawPointer(s.pos).assumingMemoryBound(to: SIMD3<Float>.self), count: count))
+            snapshot.velocities.append(contentsOf: UnsafeBufferPointer(
+                start: UnsafeRawPointer(s.vel).assumingMemoryBound(to: SIMD3<Float>.self), count: count))
+            snapshot.states.append(contentsOf: UnsafeBufferPointer(start: s.states, count: count))
+        }
+        return Int(s.tick)
+    }
+
+    private func run() {
+        let interval = UInt64(Double(tickInterval) * 1_000_000_000)
+        var next = DispatchTime.now().uptimeNanoseconds
+        while isRunning {
+            let now = DispatchTime.now().uptimeNanoseconds
+            if now < next {
+                _ = wake.wait(timeout: DispatchTime(uptimeNanoseconds: next))
+                continue
+            }
+            var due = Int((now - next) / interval) + 1
+            if due > maxCatchUpTicks {
+                let skipped = due - maxCatchUpTicks
+                next += UInt64(skipped) * interval
+                due = maxCatchUpTicks
+                pthread_mutex_lock(mutex)
+                dropped += skipped
+                pthread_mutex_unlock(mutex)
+            }
+            for _ in 0..<due {
+                step()
+                next += interval
+            }
+        }
+        finished.signal()
+    }
+
+    private func step() {
+        pthread_mutex_lock(mutex)
+        let pending = commands
+        commands.removeAll(keepingCapacity: true)
+        pthread_mutex_unlock(mutex)
+        for command in pending {
+            command(crowd)
+        }
+
+        // Flow fields take shared tile access themselves, and the lock is not reentrant
+        crowd.advanceFlowFields()
+        crowd.navMesh.withSharedTileAccess {
+            crowd.crowd.update(tickInterval, nil)
+        }
+        tick &+= 1
+        time += tickInterval
+        buffer.publish(crowd.crowd, tick, time)
+    }
+}
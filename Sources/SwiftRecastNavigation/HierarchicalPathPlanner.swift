@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: MIT
+//
+//  HierarchicalPathPlanner.swift
+//  SwiftRecastNavigation
+//
+//  Long paths across tiled navmeshes through a graph of tile borders
+//
+
+import CRecast
+import Foundation
+
+/// Finds long paths on a tiled ``NavMesh`` without one search over every polygon in between.
+///
+/// A cross-map ``NavMeshQuery/findPathCorridor(filter:start:end:maxPaths:)``
+/// expands nodes all the way from start to end, and on large worlds runs out
+/// of the query's node pool and comes back partial. The planner keeps a graph
+/// of the polygons on tile borders, with the cost of crossing each tile
+/// between them worked out once per tile. A path searches that graph first
+/// for the tiles to go through, then the query refines it one tile at a time,
+/// so a default 2048-node query finds paths across any number of tiles.
+///
+/// ```swift
+/// let planner = try navMesh.makePathPlanner()
+/// let query = try navMesh.makeQuery()
+/// let path = planner.findPath(with: query, from: spawn, to: objective)
+/// // After adding, removing or rebuilding tiles:
+/// planner.update()
+/// ```
+///
+/// Costs are those of the filter the planner was made with; make one planner
+/// per filter. Paths between the same or neighbouring tiles, and paths that
+/// start or end in a tile changed since the last ``update(threadCount:)``, are
+/// searched by the query directly. Paths are within about one percent of the
+/// shortest corridor.
+///
+/// Paths can be found from several threads at once, each with its own query,
+/// for example inside ``NavMeshQueryPool/withQuery(_:)``. ``update(threadCount:)``
+/// waits for them and reads the tiles of the navmesh, so call it where no tile
+/// is being changed, such as right after the change on the thread that made it.
+public final class HierarchicalPathPlanner: @unchecked Sendable {
+    /// The size of the graph
+    public struct Stats {
+        /// Tiles in the graph
+        public let tiles: Int
+        /// Border polygons and off-mesh connections
+        public let nodes: Int
+        /// Connections between nodes, through tiles and across their borders
+        public let edges: Int
+        /// Memory held by the graph
+        public let bytes: Int
+    }
+
+    /// The navmesh paths are planned on
+    public let navMesh: NavMesh
+    /// The filter whose area costs the graph holds
+    public let filter: NavQueryFilter
+
+    private let planner: OpaquePointer
+    private let graphLock = TileAccessLock()
+
+    /// Builds the graph for the tiles `navMesh` has now
+    /// - Parameters:
+    ///   - navMesh: The navmesh to plan on
+    ///   - filter: Polygons to use and area costs; later changes to it are not seen
+    ///   - threadCount: Threads building tiles of the graph, 0 for one per core
+    public init(navMesh: NavMesh, filter: NavQueryFilter = NavQueryFilter(), threadCount: Int = 0) throws {
+        guard let planner = bindingCreatePathPlanner(navMesh.navMesh, filter.query, Int32(threadCount)) else {
+            throw NavMesh.NavMeshError.invalidParam
+        }
+        self.navMesh = navMesh
+        self.filter = filter
+        self.planner = planner
+    }
+
+    deinit {
+        bindingReleasePathPlanner(planner)
+    }
+
+    /// Rebuilds the graph for the tiles added, removed or replaced since it was last built
+    /// - Parameter threadCount: Threads rebuilding tiles, 0 for one per core
+    /// - Returns: The number of tiles rebuilt
+    @discardableResult
+    public func update(threadCount: Int = 0) -> Int {
+        graphLock.withWriteLock {
+            Int(bindingPathPlannerUpdate(planner, Int32(threadCount)))
+        }
+    }
+
+    /// The current size of the graph
+    public var stats: Stats {
+        var stats = BindingPathPlannerStats()
+        graphLock.withReadLock {
+            bindingPathPlannerGetStats(planner, &stats)
+        }
+        return Stats(tiles: Int(stats.tiles), nodes: Int(stats.nodes), edges: Int(stats.edges), bytes: Int(stats.bytes))
+    }
+
+    /// Finds the polygon corridor from `start` to `end`, as
+    /// ``NavMeshQuery/findPathCorridor(filter:start:end:maxPaths:)`` does, with
+    /// `query` searching only within tiles.
+    ///
+    /// When `end` cannot be reached, the corridor ends at the polygon nearest
+    /// it that can, and the result is still a success.
+    /// - Parameters:
+    ///   - query: A query on ``navMesh`` that no other thread is using
+    ///   - start: Starting point
+    ///   - end: End point
+    ///   - maxPaths: Most polygons in the corridor
+    public func findPathCorridor(with query: NavMeshQuery, start: PointInPoly, end: PointInPoly,
+                                 maxPaths: Int = 512) -> Result<[dtPolyRef], NavMesh.NavMeshError> {
+        var result = [dtPolyRef](repeating: 0, count: max(maxPaths, 1))
+        var count: Int32 = 0
+        let res = graphLock.withReadLock {
+            bindingPathPlannerFindPath(planner, query.query, start.polyRef, end.polyRef, start.point, end.point,
+                                       &result, &count, Int32(result.count), nil)
+        }
+        if dtStatusSucceed(res) {
+            result.removeSubrange(Int(count)..<result.count)
+            return .success(result)
+        }
+        return .failure(NavMesh.statusToError(res))
+    }
+
+    /// Finds the straight path between two positions, snapping both to the
+    /// nearest polygon within `extents` and string-pulling the corridor from
+    /// ``findPathCorridor(with:start:end:maxPaths:)``.
+    /// - Parameters:
+    ///   - query: A query on ``navMesh`` that no other thread is using
+    ///   - startPos: Starting position
+    ///   - endPos: End position
+    ///   - extents: Search distance along each axis when snapping the positions
+    ///   - maxPaths: Most polygons in the corridor and points in the path
+    ///   - options: Which extra vertices to add to the path
+    public func findPath(with query: NavMeshQuery, from startPos: SIMD3<Float>, to endPos: SIMD3<Float>,
+                         extents: SIMD3<Float> = [1, 1, 1], maxPaths: Int = 512,
+                         options: NavMeshQuery.StraightPathOptions = []) -> Result<NavMeshQuery.FoundPath, NavMesh.NavMeshError> {
+        let start: PointInPoly
+        let end: PointInPoly
+        switch query.findNearestPoint(point: startPos, extents: extents, filter: filter) {
+        case .success(let found): start = found.0
+        case .failure(let error): return .failure(error)
+        }
+        switch query.findNearestPoint(point: endPos, extents: extents, filter: filter) {
+        case .success(let found): end = found.0
+        case .failure(let error): return .failure(error)
+        }
+        switch findPathCorridor(with: query, start: start, end: end, maxPaths: maxPaths) {
+        case .success(let corridor):
+            return query.findStraightPath(filter: filter, startPos: start.point3, endPos: end.point3,
+                                          pathCorridor: corridor, maxPaths: maxPaths, options: options)
+        case .failure(let error):
+            return .failure(error)
+        }
+    }
+}
+
+extension NavMesh {
+    /// Creates a ``HierarchicalPathPlanner`` for long paths across the tiles of this navmesh
+    /// - Parameters:
+    ///   - filter: Polygons to use and area costs of the paths
+    ///   - threadCount: Threads building the graph, 0 for one per core
+    public func makePathPlanner(filter: NavQueryFilter = NavQueryFilter(), threadCount: Int = 0) throws -> HierarchicalPathPlanner {
+        try HierarchicalPathPlanner(navMesh: self, filter: filter, threadCount: threadCount)
+    }
+}
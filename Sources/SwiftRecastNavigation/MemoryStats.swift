@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: MIT
+//
+//  MemoryStats.swift
+//  SwiftRecastNavigation
+//
+//  Memory held by navmeshes, queries, crowds and builds
+//
+
+import CRecast
+
+/// The memory Detour and Recast allocate, by owner and by allocation hint.
+///
+/// Tracking is off by default; turn it on before creating what you want to
+/// measure, then read ``current``:
+///
+/// ```swift
+/// MemoryStats.isTracking = true
+/// let navMesh = try builder.makeNavMesh()
+/// let crowd = try navMesh.makeCrowd(maxAgents: 500, agentRadius: 0.6)
+/// let stats = MemoryStats.current
+/// print(stats[.crowd].current, stats.total.peak)
+/// ```
+///
+/// Sizes are the bytes requested from the allocator, without its overhead.
+/// Tile data that Detour does not free itself, such as a blob or mapped file a
+/// ``NavMesh`` works on in place, is not counted; ``NavMesh/tileMemory`` lists
+/// every tile either way.
+public struct MemoryStats {
+    /// Bytes held by one owner, one source, or everything
+    public struct Counter {
+        /// Bytes allocated and not yet freed
+        public let current: Int
+        /// Most bytes held at once since tracking started or ``MemoryStats/resetPeaks()``
+        public let peak: Int
+        /// Blocks allocated and not yet freed
+        public let allocations: Int
+
+        init(_ counter: dtMemoryCounter) {
+            current = Int(counter.current)
+            peak = Int(counter.peak)
+            allocations = Int(counter.allocations)
+        }
+    }
+
+    /// What an allocation belongs to
+    public enum Owner: CaseIterable {
+        /// Navmesh objects with their tile slots and tile lookup
+        case navMesh
+        /// Tile data the navmesh frees itself
+        case tiles
+        /// Queries with their node pools and open lists; see ``NavMesh/makeQuery(maxNodes:)``
+        case query
+        /// Crowds with everything they allocate, their own queries included
+        case crowd
+        /// Tile caches with their obstacles and compressed tiles
+        case tileCache
+        /// Recast build temporaries, and tiles being built
+        case build
+        /// Anything else, such as flow fields and landmark tables
+        case other
+
+        var raw: dtMemoryOwner {
+            switch self {
+            case .navMesh: DT_MEMORY_NAVMESH
+            case .tiles: DT_MEMORY_TILES
+            case .query: DT_MEMORY_QUERY
+            case .crowd: DT_MEMORY_CROWD
+            case .tileCache: DT_MEMORY_TILE_CACHE
+            case .build: DT_MEMORY_BUILD
+            case .other: DT_MEMORY_OTHER
+            }
+        }
+    }
+
+    /// Which allocator and hint an allocation came through
+    public enum Source: CaseIterable {
+        /// `dtAlloc` with `DT_ALLOC_PERM`
+        case detourPermanent
+        /// `dtAlloc` with `DT_ALLOC_TEMP`
+        case detourTemporary
+        /// `rcAlloc` with `RC_ALLOC_PERM`
+        case recastPermanent
+        /// `rcAlloc` with `RC_ALLOC_TEMP`
+        case recastTemporary
+
+        var raw: dtMemorySource {
+            switch self {
+            case .detourPermanent: DT_MEMORY_DETOUR_PERM
+            case .detourTemporary: DT_MEMORY_DETOUR_TEMP
+            case .recastPermanent: DT_MEMORY_RECAST_PERM
+            case .recastTemporary: DT_MEMORY_RECAST_TEMP
+            }
+        }
+    }
+
+    /// Whether allocations are being recorded. Off by default.
+    ///
+    /// Only allocations made while tracking count. Costs a few percent of build
+    /// time while on, and nothing while off.
+    public static var isTracking: Bool {
+        get { dtMemoryGetTracking() }
+        set { dtMemorySetTracking(newValue) }
+    }
+
+    /// The counters as they are now
+    public static var current: MemoryStats {
+        MemoryStats()
+    }
+
+    /// Lowers every peak to the bytes currently held, to measure the peak of what follows
+    public static func resetPeaks() {
+        dtMemoryResetPeaks()
+    }
+
+    /// Everything together
+    public let total: Counter
+    /// Each owner
+    public let owners: [Owner: Counter]
+    /// Each allocator and hint
+    public let sources: [Source: Counter]
+
+    init() {
+        total = Counter(dtMemoryGetTotal())
+        owners = Dictionary(uniqueKeysWithValues: Owner.allCases.map { ($0, Counter(dtMemoryGetOwner($0.raw))) })
+        sources = Dictionary(uniqueKeysWithValues: Source.allCases.map { ($0, Counter(dtMemoryGetSource($0.raw))) })
+    }
+
+    /// The counter of `owner`
+    public subscript(owner: Owner) -> Counter {
+        owners[owner]!
+    }
+
+    /// The counter of `source`
+    public subscript(source: Source) -> Counter {
+        sources[source]!
+    }
+}
+
+public extension NavMesh {
+    /// Size of one tile's data
+    struct TileMemory {
+        /// Tile slot, as used by ``NavMesh/polyRefs(inTile:)``
+        public let index: Int
+        /// Tile column
+        public let x: Int
+        /// Tile row
+        public let y: Int
+        /// Tile layer
+        public let layer: Int
+        /// Bytes of tile data, links included
+        public let bytes: Int
+        /// Whether the navmesh frees the data, and ``MemoryStats`` counts it under ``MemoryStats/Owner/tiles``
+        public let ownedByNavMesh: Bool
+    }
+
+    /// The size of every loaded tile, in slot order. Does not need tracking.
+    var tileMemory: [TileMemory] {
+        var tiles: [TileMemory] = []
+        for i in 0..<Int(dtNavMeshGetMaxTiles(navMesh)) {
+            guard let tile = dtNavMeshGetTile(navMesh, Int32(i)), dtMeshTileGetHeader(tile) != nil else { continue }
+            var x: Int32 = 0, y: Int32 = 0, layer: Int32 = 0
+            dtNavMeshGetTileStateAt(navMesh, Int32(i), &x, &y, &layer)
+            tiles.append(TileMemory(index: i, x: Int(x), y: Int(y), layer: Int(layer),
+                                    bytes: Int(dtMeshTileGetDataSize(tile)),
+                                    ownedByNavMesh: dtMeshTileOwnsData(tile)))
+        }
+        return tiles
+    }
+
+    /// Bytes of data of every loaded tile
+    var tileDataSize: Int {
+        tileMemory.reduce(0) { $0 + $1.bytes }
+    }
+}
@@ -75,6 +75,13 @@ public class NavMesh {
     
     /// Track if we own the navMesh and should free it
     private let ownsNavMesh: Bool
+    
+    /// Keeps whatever owns a borrowed navMesh, or the data an owned one uses in
+    /// place, alive as long as this wrapper
+    let owner: AnyObject?
+
+    /// Orders queries from a ``NavMeshQueryPool`` against tile changes
+    let tileLock = TileAccessLock()
 
     // MARK: – Initialisers ------------------------------------------------------
 
@@ -84,35 +91,55 @@ public class NavMesh {
         self.mmapPtr = nil
         self.mmapSize = 0
         self.ownsNavMesh = true   // <-- own and free in deinit
+        self.owner = nil
     }
 
     /// Creates a NavMesh from a previously generated `Data` that was returned by
     /// ``NavMeshBuilder/makeNavigationBlob(agentHeight:agentRadius:agentMaxClimb:)`` method.
     ///
-    public init(_ blob: Data) throws {
+    /// The mesh uses the blob's storage in place and keeps it alive for as long
+    /// as it lives. Detour writes the tile's links into those bytes, so hand
+    /// over a blob you no longer read from. The bytes are copied only when they
+    /// are not aligned for Detour's tile structures. To load a blob saved to a
+    /// file without reading it into memory, use ``init(blobContentsOf:)``.
+    public init(_ blob: consuming Data) throws {
         guard let handle = dtAllocNavMesh() else { throw NavMeshError.alloc }
 
-        // Copy the blob so Detour can manage (and later free) the memory itself.
-        guard let copyPtr = malloc(blob.count) else {
+        let size = blob.count
+        guard size > 0 else {
             dtFreeNavMesh(handle)
-            throw NavMeshError.alloc
+            throw NavMeshError.invalidParam
         }
-        _ = blob.withUnsafeBytes { src in
-            memcpy(copyPtr, src.baseAddress, blob.count)
+
+        // NSData keeps its bytes at one address for its whole lifetime, which
+        // the closure-scoped pointers of Data do not promise
+        let storage = blob as NSData
+        var base = UnsafeMutableRawPointer(mutating: storage.bytes)
+        var flags: Int32 = 0
+        if Int(bitPattern: base) % MemoryLayout<dtPolyRef>.alignment != 0 {
+            guard let copy = malloc(size) else {
+                dtFreeNavMesh(handle)
+                throw NavMeshError.alloc
+            }
+            memcpy(copy, base, size)
+            base = copy
+            flags = Int32(DT_TILE_FREE_DATA.rawValue)
         }
 
-        let status = handle.`init`(copyPtr,
-                                   Int32(blob.count),
-                                   Int32(DT_TILE_FREE_DATA.rawValue))
+        let status = handle.`init`(base, Int32(size), flags)
         guard !dtStatusFailed(status) else {
+            if flags != 0 {
+                free(base)
+            }
             dtFreeNavMesh(handle)
             throw NavMesh.statusToError(status)
         }
 
         navMesh = handle
-        mmapPtr = nil // Detour owns `copyPtr` now
+        mmapPtr = nil
         mmapSize = 0
         ownsNavMesh = true
+        owner = flags != 0 ? nil : storage
     }
 
     /// Designated *internal* initialiser used by the tiled loader.
@@ -136,6 +163,7 @@ public class NavMesh {
         mmapPtr = freeWithDetour ? nil : ptr
         mmapSize = freeWithDetour ? 0 : Int(size)
         ownsNavMesh = true
+        owner = nil
     }
 
     /// Convenience wrapper when **you** own the buffer (Detour will free it).
@@ -154,6 +182,16 @@ public class NavMesh {
         self.mmapPtr = mmapPtr
         self.mmapSize = mmapSize
         self.ownsNavMesh = true   // <-- own and free in deinit
+        self.owner = nil
+    }
+
+    /// Internal – borrows a mesh that `owner` frees, such as a tile cache's.
+    init(navMesh: dtNavMesh, owner: AnyObject) {
+        self.navMesh = navMesh
+        self.mmapPtr = nil
+        self.mmapSize = 0
+        self.ownsNavMesh = false
+        self.owner = owner
     }
 
     deinit {
@@ -214,4 +252,59 @@ public extension NavMesh {
         }
         return nil
     }
+
+    /// The index of the tile at a grid location and layer, or nil if there is none.
+    /// Looked up in the tile hash, without visiting other tiles.
+    func tileIndex(x: Int32, y: Int32, layer: Int32 = 0) -> Int? {
+        guard let tile = dtNavMeshGetTileAt(navMesh, x, y, layer) else { return nil }
+        return Int(dtNavMeshGetTileIndex(navMesh, tile))
+    }
+
+    /// The indices of the tiles at a grid location, one per layer
+    func tileIndices(x: Int32, y: Int32) -> [Int] {
+        var indices = [Int32](repeating: 0, count: 32)
+        let count = dtNavMeshGetTileIndicesAt(navMesh, x, y, &indices, Int32(indices.count))
+        return indices[0..<Int(count)].map { Int($0) }
+    }
+
+    /// References of the polygons with vertices in the tile at `tileIndex`, empty if there is no tile there
+    func polyRefs(inTile tileIndex: Int) -> [dtPolyRef] {
+        tilePolyRefs(navMesh, tileIndex)
+    }
+
+    /// Flags of every polygon of the tile at `tileIndex`, indexed like the polygons, empty if there is no tile there
+    func polyFlags(inTile tileIndex: Int) -> [UInt16] {
+        guard let tile = loadedTile(navMesh, tileIndex), let header = dtMeshTileGetHeader(tile) else { return [] }
+        var flags = [UInt16](repeating: 0, count: Int(dtMeshHeaderGetPolyCount(header)))
+        let count = dtMeshTileGetPolyFlags(tile, &flags, Int32(flags.count))
+        return Array(flags[0..<Int(count)])
+    }
+
+    /// Areas of every polygon of the tile at `tileIndex`, indexed like the polygons, empty if there is no tile there
+    func polyAreas(inTile tileIndex: Int) -> [UInt8] {
+        guard let tile = loadedTile(navMesh, tileIndex), let header = dtMeshTileGetHeader(tile) else { return [] }
+        var areas = [UInt8](repeating: 0, count: Int(dtMeshHeaderGetPolyCount(header)))
+        let count = dtMeshTileGetPolyAreas(tile, &areas, Int32(areas.count))
+        return Array(areas[0..<Int(count)])
+    }
+}
+
+/// The tile in slot `tileIndex` of `navMesh`, nil when the slot is out of range
+@inline(__always)
+func loadedTile(_ navMesh: dtNavMesh, _ tileIndex: Int) -> OpaquePointer? {
+    guard tileIndex >= 0, tileIndex < Int(dtNavMeshGetMaxTiles(navMesh)) else { return nil }
+    return dtNavMeshGetTile(navMesh, Int32(tileIndex))
+}
+
+/// References of the polygons with vertices in slot `tileIndex` of `navMesh`
+func tilePolyRefs(_ navMesh: dtNavMesh, _ tileIndex: Int) -> [dtPolyRef] {
+    guard let tile = loadedTile(navMesh, tileIndex), let header = dtMeshTileGetHeader(tile) else { return [] }
+    return tilePolyRefs(navMesh, tile, polyCount: Int(dtMeshHeaderGetPolyCount(header)))
+}
+
+func tilePolyRefs(_ navMesh: dtNavMesh, _ tile: OpaquePointer, polyCount: Int) -> [dtPolyRef] {
+    var refs = [dtPolyRef](repeating: 0, count: polyCount)
+    let count = dtMeshTileGetPolyRefs(navMesh, tile, &refs, Int32(polyCount))
+    refs.removeSubrange(Int(count)..<polyCount)
+    return refs
 }
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: MIT
+//
+//  NavMeshFlowField.swift
+//  SwiftRecastNavigation
+//
+//  Shared-goal flow fields for many agents heading to one place
+//
+
+import CRecast
+import Foundation
+
+/// The way to one goal from every polygon of a navmesh, found by a single search.
+///
+/// When hundreds of agents head for the same place, as in an evacuation or
+/// a wave of attackers, ``Crowd`` plans a separate path for each of them and
+/// most wait their turn in the path queue. A flow field runs one search
+/// backwards from the goal and keeps, for every polygon, the next polygon on
+/// the way there and the cost to go. Agents that follow the field get their
+/// corridor straight from it.
+///
+/// ```swift
+/// let field = try NavMeshFlowField(navMesh: navMesh, goal: exit)
+/// for agent in evacuees {
+///     agent.requestMove(following: field)
+/// }
+/// ```
+///
+/// After tiles are added, removed or replaced, the entries of those tiles
+/// stop leading anywhere and ``update(maxIterations:)`` searches again;
+/// ``Crowd/update(time:)`` does that for the fields its agents follow.
+public final class NavMeshFlowField: @unchecked Sendable {
+    /// The navmesh the field covers
+    public let navMesh: NavMesh
+    /// The filter whose area costs the field holds
+    public let filter: NavQueryFilter
+
+    let field: dtFlowField
+
+    /// Creates a field leading to `goal` and searches it
+    /// - Parameters:
+    ///   - navMesh: The navmesh to cover
+    ///   - goal: Where agents following the field go
+    ///   - filter: Polygons to use and area costs; later changes to it are not seen
+    ///   - maxIterations: Polygons to search now at most, see ``update(maxIterations:)``
+    public init(navMesh: NavMesh, goal: PointInPoly, filter: NavQueryFilter = NavQueryFilter(), maxIterations: Int = .max) throws {
+        guard let field = dtAllocFlowField() else {
+            throw NavMesh.NavMeshError.alloc
+        }
+        var status = field.`init`(navMesh.navMesh, filter.query)
+        if dtStatusSucceed(status) {
+            status = navMesh.withSharedTileAccess {
+                var status = field.setGoal(goal.polyRef, goal.point)
+                if dtStatusSucceed(status) {
+                    status = field.update(Int32(clamping: maxIterations), nil)
+                }
+                return status
+            }
+        }
+        if dtStatusFailed(status) {
+            dtFreeFlowField(field)
+            throw NavMesh.statusToError(status)
+        }
+        self.navMesh = navMesh
+        self.filter = filter
+        self.field = field
+    }
+
+    deinit {
+        dtFreeFlowField(field)
+    }
+
+    /// Where agents following the field go
+    public var goal: PointInPoly {
+        let pos = field.getGoalPos()!
+        return PointInPoly(polyRef: field.getGoalRef(), point: [pos[0], pos[1], pos[2]])
+    }
+
+    /// Moves the goal and searches the field again.
+    ///
+    /// Agents following the field head for the new goal the next time they replan.
+    /// - Parameters:
+    ///   - goal: The new goal
+    ///   - maxIterations: Polygons to search now at most, see ``update(maxIterations:)``
+    public func setGoal(_ goal: PointInPoly, maxIterations: Int = .max) throws {
+        let status = navMesh.withSharedTileAccess {
+            var status = field.setGoal(goal.polyRef, goal.point)
+            if dtStatusSucceed(status) {
+                status = field.update(Int32(clamping: maxIterations), nil)
+            }
+            return status
+        }
+        if dtStatusFailed(status) {
+            throw NavMesh.statusToError(status)
+        }
+    }
+
+    /// Continues the search, or starts a new one if tiles changed since the last.
+    ///
+    /// The field found by the previous search stays in use until this one
+    /// completes, except in the tiles that changed.
+    /// - Parameter maxIterations: Polygons to search at most
+    /// - Returns: True once the field is complete and matches the navmesh
+    @discardableResult
+    public func update(maxIterations: Int = .max) throws -> Bool {
+        let status = navMesh.withSharedTileAccess {
+            field.update(Int32(clamping: maxIterations), nil)
+        }
+        if dtStatusFailed(status) {
+            throw NavMesh.statusToError(status)
+        }
+        return !dtStatusInProgress(status)
+    }
+
+    /// True while a search is under way
+    public var isSearching: Bool {
+        field.isSearching()
+    }
+
+    /// The polygon after `polyRef` on the way to the goal, 0 at the goal, and the cost to go
+    /// from there, or nil if the field does not reach `polyRef`
+    public func nextPoly(after polyRef: dtPolyRef) -> (next: dtPolyRef, cost: Float)? {
+        var next: dtPolyRef = 0
+        var cost: Float = 0
+        let found = navMesh.withSharedTileAccess { field.getHop(polyRef, &next, &cost) }
+        return found ? (next, cost) : nil
+    }
+
+    /// The polygons the field leads through from `polyRef`, starting with it.
+    ///
+    /// The corridor ends at the goal polygon, after `maxPolys` polygons, or
+    /// before a tile changed since the field was searched.
+    /// - Parameters:
+    ///   - polyRef: The polygon to start from
+    ///   - maxPolys: Most polygons to return
+    public func corridor(from polyRef: dtPolyRef, maxPolys: Int = 256) -> Result<[dtPolyRef], NavMesh.NavMeshError> {
+        var result = [dtPolyRef](repeating: 0, count: max(maxPolys, 1))
+        var count: Int32 = 0
+        let status = navMesh.withSharedTileAccess {
+            field.getPath(polyRef, &result, &count, Int32(result.count))
+        }
+        if dtStatusFailed(status) {
+            return .failure(NavMesh.statusToError(status))
+        }
+        result.removeSubrange(Int(count)..<result.count)
+        return .success(result)
+    }
+
+    /// Polygons the field reaches
+    public var reachedPolyCount: Int {
+        Int(field.getReachedPolyCount())
+    }
+
+    /// Tiles added, removed or replaced since the field was searched
+    public var staleTileCount: Int {
+        navMesh.withSharedTileAccess { Int(field.getStaleTileCount()) }
+    }
+
+    /// Memory held by the field, in bytes
+    public var memoryUsage: Int {
+        Int(field.getMemoryUsage())
+    }
+}
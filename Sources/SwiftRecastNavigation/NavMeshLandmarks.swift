@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: MIT
+//
+//  NavMeshLandmarks.swift
+//  SwiftRecastNavigation
+//
+//  Landmark distance tables that speed up path searches
+//
+
+import CRecast
+import Foundation
+
+/// Precomputed distances from a few landmarks that let path searches skip
+/// most of the polygons the straight-line estimate sends them into.
+///
+/// A* guesses the remaining cost of a path by the straight-line distance to
+/// the goal, which knows nothing of walls, dead ends or expensive areas, so
+/// searches on maze-like navmeshes expand far more polygons than the path
+/// goes through. The table stores the cost from each landmark to every
+/// polygon edge, and searches derive a much closer estimate from it while
+/// still finding the same shortest paths.
+///
+/// ```swift
+/// let landmarks = try navMesh.makeLandmarks()
+/// let query = try navMesh.makeQuery()
+/// query.landmarks = landmarks
+/// ```
+///
+/// The table holds the area costs of the filter it was made with, and
+/// searches with any other filter do not use it. Tiles added, removed or
+/// replaced later lose their distances: searches use the straight-line
+/// estimate inside them and lower the estimate elsewhere to the way through
+/// them, so they still find the shortest paths. With more than 16 changed
+/// tiles the table is not used until the next ``rebuild(seed:)``.
+///
+/// One table can be shared by any number of queries on different threads.
+public final class NavMeshLandmarks: @unchecked Sendable {
+    /// The navmesh the distances were computed on
+    public let navMesh: NavMesh
+    /// The filter whose area costs the table holds
+    public let filter: NavQueryFilter
+
+    let table: dtLandmarkTable
+
+    /// Places the landmarks and computes the distances for the tiles `navMesh` has now
+    /// - Parameters:
+    ///   - navMesh: The navmesh to cover
+    ///   - filter: Polygons to use and area costs; later changes to it are not seen
+    ///   - count: Landmarks to place, more give closer estimates and use more memory. [Limits: 1 <= value <= 16]
+    ///   - seed: A polygon in the part of the navmesh to cover, 0 for any
+    public init(navMesh: NavMesh, filter: NavQueryFilter = NavQueryFilter(), count: Int = 8, seed: dtPolyRef = 0) throws {
+        guard let table = dtAllocLandmarkTable() else {
+            throw NavMesh.NavMeshError.alloc
+        }
+        var status = table.`init`(navMesh.navMesh, filter.query, Int32(count))
+        if dtStatusSucceed(status) {
+            status = navMesh.withSharedTileAccess { table.build(seed) }
+        }
+        if dtStatusFailed(status) {
+            dtFreeLandmarkTable(table)
+            throw NavMesh.statusToError(status)
+        }
+        self.navMesh = navMesh
+        self.filter = filter
+        self.table = table
+    }
+
+    deinit {
+        dtFreeLandmarkTable(table)
+    }
+
+    /// Places the landmarks again and recomputes the distances for the tiles the navmesh has now.
+    ///
+    /// Call it while no query using the table is searching.
+    /// - Parameter seed: A polygon in the part of the navmesh to cover, 0 for any
+    public func rebuild(seed: dtPolyRef = 0) throws {
+        let status = navMesh.withSharedTileAccess { table.build(seed) }
+        if dtStatusFailed(status) {
+            throw NavMesh.statusToError(status)
+        }
+    }
+
+    /// Landmarks placed by the latest build
+    public var landmarkCount: Int {
+        Int(table.getLandmarkCount())
+    }
+
+    /// Positions of the landmarks
+    public var landmarkPositions: [SIMD3<Float>] {
+        (0..<table.getLandmarkCount()).map { i in
+            let pos = table.getLandmarkPos(i)!
+            return SIMD3<Float>(pos[0], pos[1], pos[2])
+        }
+    }
+
+    /// Tiles whose distances no longer match the navmesh, removed ones included;
+    /// see ``rebuild(seed:)``
+    public var staleTileCount: Int {
+        navMesh.withSharedTileAccess { Int(table.getStaleTileCount()) }
+    }
+
+    /// Memory held by the table, in bytes
+    public var memoryUsage: Int {
+        Int(table.getMemoryUsage())
+    }
+}
+
+extension NavMesh {
+    /// Creates a ``NavMeshLandmarks`` table to speed up path searches on this navmesh
+    /// - Parameters:
+    ///   - filter: Polygons to use and area costs of the searches
+    ///   - count: Landmarks to place. [Limits: 1 <= value <= 16]
+    public func makeLandmarks(filter: NavQueryFilter = NavQueryFilter(), count: Int = 8) throws -> NavMeshLandmarks {
+        try NavMeshLandmarks(navMesh: self, filter: filter, count: count)
+    }
+}
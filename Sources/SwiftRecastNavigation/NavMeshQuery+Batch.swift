@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: MIT
+//
+//  NavMeshQuery+Batch.swift
+//  SwiftRecastNavigation
+//
+//  Straight paths and nearest points for many positions in one call
+//
+
+import CRecast
+import Foundation
+
+/// Straight paths found by ``NavMeshQuery/findPaths(from:to:filters:extents:maxPolys:maxPoints:options:)``,
+/// stored one after the other in a single buffer
+public struct PathBatch {
+    /// Corners of every path, path after path
+    public let points: [SIMD3<Float>]
+    /// Path `i` is `points[offsets[i] ..< offsets[i + 1]]`; there is one more offset than paths
+    public let offsets: [Int]
+    /// Detour status of the search for every path
+    public let statuses: [dtStatus]
+
+    /// Number of paths
+    public var count: Int { statuses.count }
+
+    /// The corners of path `index`, empty if it failed
+    public subscript(index: Int) -> ArraySlice<SIMD3<Float>> {
+        points[offsets[index] ..< offsets[index + 1]]
+    }
+
+    /// Whether path `index` was found, possibly only part of the way
+    public func succeeded(_ index: Int) -> Bool {
+        dtStatusSucceed(statuses[index])
+    }
+
+    /// Whether path `index` stops short of its end, because the end could not
+    /// be reached or a buffer was too small
+    public func isPartial(_ index: Int) -> Bool {
+        statuses[index] & (DT_PARTIAL_RESULT | DT_BUFFER_TOO_SMALL) != 0
+    }
+
+    /// The corners of path `index`, or why it could not be found
+    public func result(at index: Int) -> Result<ArraySlice<SIMD3<Float>>, NavMesh.NavMeshError> {
+        if dtStatusSucceed(statuses[index]) {
+            return .success(self[index])
+        }
+        return .failure(NavMesh.statusToError(statuses[index]))
+    }
+}
+
+/// Inputs of a batch and the fixed-size slot each path is written to before
+/// the paths are packed into a ``PathBatch``
+final class PathBatchStaging: @unchecked Sendable {
+    let count: Int
+    let maxPolys: Int32
+    let maxPoints: Int
+    let options: Int32
+    let extents: [Float]
+    let starts: UnsafeMutableBufferPointer<Float>
+    let ends: UnsafeMutableBufferPointer<Float>
+    let points: UnsafeMutableBufferPointer<Float>
+    let pointCounts: UnsafeMutableBufferPointer<Int32>
+    let statuses: UnsafeMutableBufferPointer<dtStatus>
+
+    init(starts: [SIMD3<Float>], ends: [SIMD3<Float>], extents: SIMD3<Float>,
+         maxPolys: Int, maxPoints: Int, options: NavMeshQuery.StraightPathOptions) {
+        precondition(starts.count == ends.count, "starts and ends differ in length")
+        count = starts.count
+        self.maxPolys = Int32(maxPolys)
+        self.maxPoints = max(maxPoints, 0)
+        self.options = options.rawValue
+        self.extents = [extents.x, extents.y, extents.z]
+        self.starts = .allocate(capacity: count * 3)
+        self.ends = .allocate(capacity: count * 3)
+        points = .allocate(capacity: count * self.maxPoints * 3)
+        pointCounts = .allocate(capacity: count)
+        statuses = .allocate(capacity: count)
+        for i in 0..<count {
+            self.starts[i * 3] = starts[i].x
+            self.starts[i * 3 + 1] = starts[i].y
+            self.starts[i * 3 + 2] = starts[i].z
+            self.ends[i * 3] = ends[i].x
+            self.ends[i * 3 + 1] = ends[i].y
+            self.ends[i * 3 + 2] = ends[i].z
+        }
+    }
+
+    deinit {
+        starts.deallocate()
+        ends.deallocate()
+        points.deallocate()
+        pointCounts.deallocate()
+        statuses.deallocate()
+    }
+
+    /// Marks `range` as failed with `status`, for items no query got to
+    func fail(_ range: Range<Int>, status: dtStatus) {
+        for i in range {
+            pointCounts[i] = 0
+            statuses[i] = status
+        }
+    }
+
+    func makeBatch() -> PathBatch {
+        var offsets = [Int]()
+        offsets.reserveCapacity(count + 1)
+        var total = 0
+        offsets.append(0)
+        for i in 0..<count {
+            total += Int(pointCounts[i])
+            offsets.append(total)
+        }
+        var packed = [SIMD3<Float>]()
+        packed.reserveCapacity(total)
+        for i in 0..<count {
+            let base = i * maxPoints * 3
+            for corner in 0..<Int(pointCounts[i]) {
+                let p = base + corner * 3
+                packed.append(SIMD3(points[p], points[p + 1], points[p + 2]))
+            }
+        }
+        return PathBatch(points: packed, offsets: offsets, statuses: Array(statuses))
+    }
+}
+
+extension NavMeshQuery {
+    /// Finds the straight paths between many pairs of positions in one call.
+    ///
+    /// Every pair is searched as ``findPath(from:to:filter:)`` would: both ends
+    /// are snapped to the nearest polygon, the polygon corridor between them is
+    /// found and string-pulled. The batch is searched in C with this query's
+    /// node pool and a single corridor buffer, and the paths come back in one
+    /// buffer, so the cost per path is the search itself. Use
+    /// ``NavMeshQueryPool/findPaths(from:to:filters:extents:maxPolys:maxPoints:options:)``
+    /// to spread a batch over several threads.
+    ///
+    /// - Parameters:
+    ///   - starts: Start position of every path
+    ///   - ends: End position of every path, as many as `starts`
+    ///   - filters: The filter of every path, as many as `starts`; nil uses ``filter`` for all of them
+    ///   - extents: The search distance along each axis when snapping the ends to the mesh
+    ///   - maxPolys: Most polygons in the corridor of a path
+    ///   - maxPoints: Most corners of a path
+    ///   - options: Which vertices to add to the paths
+    /// - Returns: The paths, in the order of `starts`
+    public func findPaths(from starts: [SIMD3<Float>], to ends: [SIMD3<Float>], filters: [NavQueryFilter]? = nil,
+                          extents: SIMD3<Float> = [1, 1, 1], maxPolys: Int = 512, maxPoints: Int = 512,
+                          options: StraightPathOptions = []) -> PathBatch {
+        let staging = PathBatchStaging(starts: starts, ends: ends, extents: extents,
+                                       maxPolys: maxPolys, maxPoints: maxPoints, options: options)
+        findPaths(staging, range: 0..<staging.count, filters: filters)
+        return staging.makeBatch()
+    }
+
+    /// Searches the items of `staging` in `range`, one C call per distinct filter
+    func findPaths(_ staging: PathBatchStaging, range: Range<Int>, filters: [NavQueryFilter]?) {
+        if let filters {
+            precondition(filters.count == staging.count, "filters and starts differ in length")
+        }
+        var groups: [ObjectIdentifier: (filter: NavQueryFilter, items: [Int32])] = [:]
+        for i in range {
+            let filter = filters?[i] ?? self.filter
+            groups[ObjectIdentifier(filter), default: (filter, [])].items.append(Int32(i))
+        }
+        for (_, group) in groups {
+            group.items.withUnsafeBufferPointer { items in
+                bindingFindStraightPaths(query, group.filter.query,
+                                         staging.starts.baseAddress, staging.ends.baseAddress,
+                                         items.baseAddress, Int32(items.count), staging.extents,
+                                         staging.maxPolys, Int32(staging.maxPoints), staging.options,
+                                         staging.points.baseAddress, staging.pointCounts.baseAddress,
+                                         staging.statuses.baseAddress)
+            }
+        }
+    }
+}
+
+extension NavMeshQuery {
+    /// Finds the polygon nearest to each of many points in one call, with the
+    /// same results as calling ``findNearestPoint(point:extents:filter:)`` for each.
+    ///
+    /// The points are grouped by tile and each tile is searched for several
+    /// nearby points at once, so snapping the positions of a whole crowd costs
+    /// less than one call per point, the more so the larger `extents` is.
+    /// - Parameters:
+    ///   - points: Centers of the search boxes
+    ///   - extents: The search distance along each axis, for every point
+    ///   - filter: an optional filter to determine the elegibility of a polygon
+    /// - Returns: For every point, the nearest point on the mesh and whether the
+    ///   point's X/Z coordinate lies inside its polygon, or nil when no polygon is within `extents`
+    public func findNearestPoints(_ points: [SIMD3<Float>], extents: SIMD3<Float> = [1, 1, 1],
+                                  filter: NavQueryFilter? = nil) -> Result<[(PointInPoly, isOverPoly: Bool)?], NavMesh.NavMeshError> {
+        let count = points.count
+        var centers = [Float](repeating: 0, count: count * 3)
+        for i in 0..<count {
+            centers[i * 3] = points[i].x
+            centers[i * 3 + 1] = points[i].y
+            centers[i * 3 + 2] = points[i].z
+        }
+        var _extents: [Float] = [extents.x, extents.y, extents.z]
+        var refs = [dtPolyRef](repeating: 0, count: count)
+        var nearest = [Float](repeating: 0, count: count * 3)
+        var overPoly = [Bool](repeating: false, count: count)
+
+        let ret = query.findNearestPolys(&centers, Int32(count), &_extents, (filter ?? self.filter).query,
+                                         &refs, &nearest, &overPoly)
+        if dtStatusFailed(ret) {
+            return .failure(NavMesh.statusToError(ret))
+        }
+        return .success((0..<count).map { i in
+            guard refs[i] != 0 else { return nil }
+            let point = [nearest[i * 3], nearest[i * 3 + 1], nearest[i * 3 + 2]]
+            return (PointInPoly(polyRef: refs[i], point: point), overPoly[i])
+        })
+    }
+}
+
+extension NavMeshQueryPool {
+    /// Finds the straight paths between many pairs of positions, spread over one
+    /// query of the pool per core.
+    ///
+    /// The batch is cut into contiguous runs searched in parallel, each with
+    /// ``NavMeshQuery/findPaths(from:to:filters:extents:maxPolys:maxPoints:options:)``
+    /// on a query checked out for the whole run. The call blocks until every
+    /// path is found; from Swift concurrency, call it from a task that can afford to wait.
+    ///
+    /// - Parameters:
+    ///   - starts: Start position of every path
+    ///   - ends: End position of every path, as many as `starts`
+    ///   - filters: The filter of every path, as many as `starts`; nil uses the default filter
+    ///   - extents: The search distance along each axis when snapping the ends to the mesh
+    ///   - maxPolys: Most polygons in the corridor of a path
+    ///   - maxPoints: Most corners of a path
+    ///   - options: Which vertices to add to the paths
+    /// - Returns: The paths, in the order of `starts`
+    public func findPaths(from starts: [SIMD3<Float>], to ends: [SIMD3<Float>], filters: [NavQueryFilter]? = nil,
+                          extents: SIMD3<Float> = [1, 1, 1], maxPolys: Int = 512, maxPoints: Int = 512,
+                          options: NavMeshQuery.StraightPathOptions = []) -> PathBatch {
+        let staging = PathBatchStaging(starts: starts, ends: ends, extents: extents,
+                                       maxPolys: maxPolys, maxPoints: maxPoints, options: options)
+        // Runs of at least a few dozen paths keep the cost of a checkout negligible
+        let runs = max(1, min(ProcessInfo.processInfo.activeProcessorCount, staging.count / 32))
+        let search = { (run: Int) in
+            let range = (staging.count * run / runs) ..< (staging.count * (run + 1) / runs)
+            do {
+                try self.withQuery { $0.findPaths(staging, range: range, filters: filters) }
+            } catch {
+                staging.fail(range, status: DT_FAILURE | DT_OUT_OF_MEMORY)
+            }
+        }
+        if runs == 1 {
+            search(0)
+        } else {
+            DispatchQueue.concurrentPerform(iterations: runs, execute: search)
+        }
+        return staging.makeBatch()
+    }
+}
@@ -41,6 +41,14 @@ public class NavMeshQuery {
     }
     public var query: dtNavMeshQuery
     public var filter: NavQueryFilter
+    /// Corridors to reuse instead of searching again, nil to always search.
+    /// See ``PathCorridorCache``.
+    public var corridorCache: PathCorridorCache?
+    /// Landmark distances that speed up searches with the filter they were
+    /// made with, nil to use the straight-line estimate. See ``NavMeshLandmarks``.
+    public var landmarks: NavMeshLandmarks? {
+        didSet { query.setLandmarkTable(landmarks?.table) }
+    }
 
     /// - Parameters:
     ///   - nav: the navigation mesh this will operate on
@@ -91,6 +99,12 @@ public class NavMeshQuery {
     ///  - maxPaths: the maximum number of paths to generate
     /// - Returns: on success, an array of polygon references from the starting point to the ending point, on failure, a detail for the reason why the path could not be found
     public func findPathCorridor (filter custom: NavQueryFilter? = nil, start: PointInPoly, end: PointInPoly, maxPaths: Int = 512) -> Result<[dtPolyRef],NavMesh.NavMeshError> {
+        let cacheKey = corridorCache == nil ? nil : corridorCacheKey(start.polyRef, end.polyRef, custom)
+        if let cache = corridorCache, let cacheKey,
+           let cached = cache.withCorridor(cacheKey, query: query, filter: custom ?? self.filter, { Array($0.prefix(maxPaths)) }) {
+            return .success(cached)
+        }
+        
         var result: [dtPolyRef] = Array.init(repeating: 0, count: maxPaths)
         var count: Int32 = 0
         
@@ -103,6 +117,9 @@ public class NavMeshQuery {
             if result.count != count {
                 result.removeSubrange(Int(count)..<result.count)
             }
+            if let cache = corridorCache, let cacheKey, res == DT_SUCCESS {
+                result.withUnsafeBufferPointer { cache.insert(cacheKey, corridor: $0) }
+            }
             return .success(result)
         }
         return .failure(NavMesh.statusToError(res))
@@ -280,6 +297,13 @@ public class NavMeshQuery {
     }
 }
 
+extension NavMeshQuery {
+    /// Key of the corridor between two polygons under a filter in ``corridorCache``
+    func corridorCacheKey(_ start: dtPolyRef, _ end: dtPolyRef, _ custom: NavQueryFilter?) -> PathCorridorCache.Key {
+        PathCorridorCache.Key(start: start, end: end, filter: (custom ?? filter).stateHash)
+    }
+}
+
 func floatRand () -> Float {
     return Float.random(in: 0..<1)
 }
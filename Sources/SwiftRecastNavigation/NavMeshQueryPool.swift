@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: MIT
+//
+//  NavMeshQueryPool.swift
+//  SwiftRecastNavigation
+//
+//  Queries that can run on every core at once against one navmesh
+//
+
+import CRecast
+import Foundation
+#if canImport(Darwin)
+import Darwin
+#elseif canImport(Glibc)
+import Glibc
+#endif
+
+/// A set of ``NavMeshQuery`` objects for running path queries on many threads at once.
+///
+/// A `dtNavMeshQuery` keeps its search state (node pool and open list) inside
+/// itself, so a single query must not be used by two threads at the same time.
+/// The pool hands each caller a query of its own for the duration of
+/// ``withQuery(_:)``, and holds the navmesh's tile lock for reading meanwhile,
+/// so any number of queries run in parallel while changes to the tiles of the
+/// navmesh wait for them to finish.
+///
+/// ```swift
+/// let pool = try navMesh.makeQueryPool()
+/// await withTaskGroup(of: [SIMD3<Float>]?.self) { group in
+///     for request in requests {
+///         group.addTask {
+///             try? pool.withQuery { try $0.findPath(from: request.start, to: request.end) }
+///         }
+///     }
+/// }
+/// ```
+///
+/// The pool is safe to share between threads and tasks. The closure passed to
+/// ``withQuery(_:)`` is synchronous, so a task never suspends while it holds a query.
+///
+/// On a navmesh with on-demand detail meshes (``NavMeshConfig/lazyDetailMesh``)
+/// queries run one at a time, since sampling heights builds and drops detail meshes.
+public final class NavMeshQueryPool: @unchecked Sendable {
+    /// The navmesh the queries search
+    public let navMesh: NavMesh
+    /// Search nodes of every query in the pool
+    public let maxNodes: Int
+    /// The corridor cache every query of the pool shares, if any
+    public let corridorCache: PathCorridorCache?
+    /// The landmark table every query of the pool uses, if any
+    public let landmarks: NavMeshLandmarks?
+
+    private let mutex = UnsafeMutablePointer<pthread_mutex_t>.allocate(capacity: 1)
+    private var available: [NavMeshQuery]
+    private var created: Int
+
+    /// Creates a pool for `navMesh`
+    /// - Parameters:
+    ///   - navMesh: The navmesh to search
+    ///   - maxNodes: Maximum number of search nodes of each query. [Limits: 0 < value <= 65535]
+    ///   - capacity: Queries to create up front, 0 for one per core. When more
+    ///     callers than that need a query at once, the pool creates more.
+    ///   - corridorCache: A cache for all the queries to share, see ``NavMeshQuery/corridorCache``
+    ///   - landmarks: A landmark table for all the queries to use, see ``NavMeshQuery/landmarks``
+    public init(navMesh: NavMesh, maxNodes: Int = 2048, capacity: Int = 0,
+                corridorCache: PathCorridorCache? = nil, landmarks: NavMeshLandmarks? = nil) throws {
+        self.navMesh = navMesh
+        self.maxNodes = maxNodes
+        self.corridorCache = corridorCache
+        self.landmarks = landmarks
+        let count = capacity > 0 ? capacity : ProcessInfo.processInfo.activeProcessorCount
+        var queries = [NavMeshQuery]()
+        queries.reserveCapacity(count)
+        for _ in 0..<count {
+            let query = try NavMeshQuery(nav: navMesh, maxNodes: Int32(maxNodes))
+            query.corridorCache = corridorCache
+            query.landmarks = landmarks
+            queries.append(query)
+        }
+        available = queries
+        created = count
+        pthread_mutex_init(mutex, nil)
+    }
+
+    deinit {
+        pthread_mutex_destroy(mutex)
+        mutex.deallocate()
+    }
+
+    /// Queries created so far, both in use and available
+    public var queryCount: Int {
+        pthread_mutex_lock(mutex)
+        defer { pthread_mutex_unlock(mutex) }
+        return created
+    }
+
+    /// Runs `body` with a query no other caller is using, while no tile of the
+    /// navmesh is being added or removed.
+    ///
+    /// The query goes back to the pool when `body` returns; do not keep it.
+    /// Results that refer to polygons stay valid only until the next tile
+    /// change, as with any query. On a navmesh with a detail provider callers
+    /// take turns; see ``NavMesh/withSharedTileAccess(_:)``.
+    public func withQuery<R>(_ body: (NavMeshQuery) throws -> R) throws -> R {
+        let query = try checkOut()
+        defer { checkIn(query) }
+        return try navMesh.withSharedTileAccess {
+            try body(query)
+        }
+    }
+
+    private func checkOut() throws -> NavMeshQuery {
+        pthread_mutex_lock(mutex)
+        if let query = available.popLast() {
+            pthread_mutex_unlock(mutex)
+            return query
+        }
+        created += 1
+        pthread_mutex_unlock(mutex)
+        do {
+            return try makeQuery()
+        } catch {
+            pthread_mutex_lock(mutex)
+            created -= 1
+            pthread_mutex_unlock(mutex)
+            throw error
+        }
+    }
+
+    private func makeQuery() throws -> NavMeshQuery {
+        let query = try NavMeshQuery(nav: navMesh, maxNodes: Int32(maxNodes))
+        query.corridorCache = corridorCache
+        query.landmarks = landmarks
+        return query
+    }
+
+    private func checkIn(_ query: NavMeshQuery) {
+        pthread_mutex_lock(mutex)
+        available.append(query)
+        pthread_mutex_unlock(mutex)
+    }
+}
+
+/// Reader/writer lock ordering queries against tile changes on a ``NavMesh``.
+///
+/// Waiting writers go ahead of new readers, so a steady stream of queries does
+/// not hold tile changes back indefinitely.
+final class TileAccessLock {
+    private let lock = UnsafeMutablePointer<pthread_rwlock_t>.allocate(capacity: 1)
+
+    init() {
+        #if canImport(Glibc)
+        var attr = pthread_rwlockattr_t()
+        pthread_rwlockattr_init(&attr)
+        // glibc prefers readers unless asked; Darwin already prefers writers
+        pthread_rwlockattr_setkind_np(&attr, Int32(PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP))
+        pthread_rwlock_init(lock, &attr)
+        pthread_rwlockattr_destroy(&attr)
+        #else
+        pthread_rwlock_init(lock, nil)
+        #endif
+    }
+
+    deinit {
+        pthread_rwlock_destroy(lock)
+        lock.deallocate()
+    }
+
+    func withReadLock<R>(_ body: () throws -> R) rethrows -> R {
+        pthread_rwlock_rdlock(lock)
+        defer { pthread_rwlock_unlock(lock) }
+        return try body()
+    }
+
+    func withWriteLock<R>(_ body: () throws -> R) rethrows -> R {
+        pthread_rwlock_wrlock(lock)
+        defer { pthread_rwlock_unlock(lock) }
+        return try body()
+    }
+}
+
+extension NavMesh {
+    /// Creates a pool of queries for searching this navmesh from many threads at once
+    /// - Parameters:
+    ///   - maxNodes: Maximum number of search nodes of each query. [Limits: 0 < value <= 65535]
+    ///   - capacity: Queries to create up front, 0 for one per core
+    ///   - corridorCache: A cache for all the queries to share, see ``NavMeshQuery/corridorCache``
+    ///   - landmarks: A landmark table for all the queries to use, see ``NavMeshQuery/landmarks``
+    public func makeQueryPool(maxNodes: Int = 2048, capacity: Int = 0, corridorCache: PathCorridorCache? = nil,
+                              landmarks: NavMeshLandmarks? = nil) throws -> NavMeshQueryPool {
+        try NavMeshQueryPool(navMesh: self, maxNodes: maxNodes, capacity: capacity,
+                             corridorCache: corridorCache, landmarks: landmarks)
+    }
+
+    /// Runs `body` while no tile is being added to or removed from this navmesh.
+    ///
+    /// Any number of callers can hold shared access at once. ``NavMeshQueryPool``
+    /// takes it around every query; take it yourself around queries made
+    /// with a ``NavMeshQuery`` of your own on a thread other than the one changing tiles.
+    ///
+    /// A detail provider, such as the one behind ``NavMeshConfig/lazyDetailMesh``,
+    /// builds and frees detail meshes from inside height queries without a lock
+    /// of its own, so on such a mesh callers get exclusive access instead and
+    /// run one at a time.
+    public func withSharedTileAccess<R>(_ body: () throws -> R) rethrows -> R {
+        if dtNavMeshHasDetailProvider(navMesh) {
+            return try tileLock.withWriteLock(body)
+        }
+        return try tileLock.withReadLock(body)
+    }
+
+    /// Runs `body` once every caller with shared access has finished, while
+    /// nobody else can take it.
+    ///
+    /// ``TileCacheNavMesh``, ``TileStreamingNavMesh``, ``StreamingNavMeshBuild``
+    /// and the tile editing methods of ``NavMeshBuilder`` take exclusive access
+    /// while they change tiles. Take it yourself around calls that add or remove
+    /// tiles of ``navMesh`` directly. It is not reentrant.
+    public func withExclusiveTileAccess<R>(_ body: () throws -> R) rethrows -> R {
+        try tileLock.withWriteLock(body)
+    }
+}
@@ -67,6 +67,18 @@ public class NavQueryFilter {
         query.getAreaCost(idx)
     }
     
+    /// Hash of everything that decides which corridor a search finds, so that
+    /// filters set up alike share cached corridors
+    var stateHash: Int {
+        var hasher = Hasher()
+        hasher.combine(query.getIncludeFlags())
+        hasher.combine(query.getExcludeFlags())
+        for area in 0..<Int32(DT_MAX_AREAS) {
+            hasher.combine(query.getAreaCost(area).bitPattern)
+        }
+        return hasher.finalize()
+    }
+    
     deinit {
         dtFreeQueryFilter (query)
     }
@@ -0,0 +1,258 @@
+// SPDX-License-Identifier: MIT
+//
+//  PathBuffer.swift
+//  SwiftRecastNavigation
+//
+//  Caller-owned storage for path queries that allocate nothing per call
+//
+
+import CRecast
+import Foundation
+
+/// Storage for the corridor and straight path of one query, reused from call to call.
+///
+/// The `into:` overloads of ``NavMeshQuery`` write their results here instead
+/// of returning new arrays, so a query that reuses a buffer does no heap
+/// allocation once the buffer exists:
+///
+/// ```swift
+/// let buffer = PathBuffer(capacity: 256)
+/// // Every frame:
+/// if case .success(let count) = query.findPath(from: agent, to: goal, into: buffer) {
+///     for i in 0..<count { steer(toward: buffer[i]) }
+/// }
+/// ```
+///
+/// A buffer holds one result at a time and must not be used by two queries at once.
+public final class PathBuffer {
+    /// Most polygons in the corridor and most points in the straight path
+    public let capacity: Int
+
+    private let corridorStorage: UnsafeMutableBufferPointer<dtPolyRef>
+    private let pointStorage: UnsafeMutableBufferPointer<Float>
+    private let flagStorage: UnsafeMutableBufferPointer<UInt8>
+    private let refStorage: UnsafeMutableBufferPointer<dtPolyRef>
+    /// Query and result positions passed to Detour: start, end, snapped start, snapped end, extents
+    let scratch: UnsafeMutablePointer<Float>
+
+    /// Polygons in ``corridor``
+    public internal(set) var corridorCount = 0
+    /// Points in the straight path
+    public internal(set) var pointCount = 0
+
+    /// - Parameter capacity: Most polygons in a corridor and most points in a straight path
+    public init(capacity: Int = 512) {
+        self.capacity = max(capacity, 1)
+        corridorStorage = .allocate(capacity: self.capacity)
+        pointStorage = .allocate(capacity: self.capacity * 3)
+        flagStorage = .allocate(capacity: self.capacity)
+        refStorage = .allocate(capacity: self.capacity)
+        scratch = .allocate(capacity: 15)
+        scratch.initialize(repeating: 0, count: 15)
+    }
+
+    deinit {
+        corridorStorage.deallocate()
+        pointStorage.deallocate()
+        flagStorage.deallocate()
+        refStorage.deallocate()
+        scratch.deallocate()
+    }
+
+    /// The polygons of the latest corridor, valid until the buffer is used again
+    public var corridor: UnsafeBufferPointer<dtPolyRef> {
+        UnsafeBufferPointer(rebasing: corridorStorage[0..<corridorCount])
+    }
+
+    /// The straight path as x, y, z per point, valid until the buffer is used again
+    public var rawPoints: UnsafeBufferPointer<Float> {
+        UnsafeBufferPointer(rebasing: pointStorage[0..<(pointCount * 3)])
+    }
+
+    /// Point `index` of the straight path
+    public subscript(index: Int) -> SIMD3<Float> {
+        precondition(index >= 0 && index < pointCount, "Out of range \(index) count is \(pointCount)")
+        let base = index * 3
+        return SIMD3<Float>(pointStorage[base], pointStorage[base + 1], pointStorage[base + 2])
+    }
+
+    /// The flags of point `index` of the straight path
+    public func flags(at index: Int) -> NavMeshQuery.StraightPathFlags {
+        precondition(index >= 0 && index < pointCount, "Out of range \(index) count is \(pointCount)")
+        return NavMeshQuery.StraightPathFlags(rawValue: flagStorage[index])
+    }
+
+    /// The polygon entered at point `index` of the straight path; 0 at the end point
+    public func polyRef(at index: Int) -> dtPolyRef {
+        precondition(index >= 0 && index < pointCount, "Out of range \(index) count is \(pointCount)")
+        return refStorage[index]
+    }
+
+    var corridorBase: UnsafeMutablePointer<dtPolyRef> { corridorStorage.baseAddress! }
+    var pointBase: UnsafeMutablePointer<Float> { pointStorage.baseAddress! }
+    var flagBase: UnsafeMutablePointer<UInt8> { flagStorage.baseAddress! }
+    var refBase: UnsafeMutablePointer<dtPolyRef> { refStorage.baseAddress! }
+
+    @inline(__always)
+    func setScratch(_ slot: Int, _ value: SIMD3<Float>) {
+        scratch[slot * 3] = value.x
+        scratch[slot * 3 + 1] = value.y
+        scratch[slot * 3 + 2] = value.z
+    }
+}
+
+extension NavMeshQuery {
+    /// Finds the polygon corridor from `start` to `end`, as
+    /// ``findPathCorridor(filter:start:end:maxPaths:)`` does, into ``PathBuffer/corridor``.
+    /// - Returns: The number of polygons in the corridor, at most the buffer's capacity
+    public func findPathCorridor(filter custom: NavQueryFilter? = nil, start: PointInPoly, end: PointInPoly,
+                                 into buffer: PathBuffer) -> Result<Int, NavMesh.NavMeshError> {
+        buffer.setScratch(2, start.point3)
+        buffer.setScratch(3, end.point3)
+        return findCorridor(filter: custom, startRef: start.polyRef, endRef: end.polyRef, buffer: buffer)
+    }
+
+    /// Finds the polygon corridor from `start` to `end` into caller-owned storage.
+    /// - Returns: The number of polygons written to `corridor`
+    public func findPathCorridor(filter custom: NavQueryFilter? = nil, start: PointInPoly, end: PointInPoly,
+                                 into corridor: UnsafeMutableBufferPointer<dtPolyRef>) -> Result<Int, NavMesh.NavMeshError> {
+        guard let base = corridor.baseAddress, !corridor.isEmpty else { return .failure(.invalidParam) }
+        var count: Int32 = 0
+        let res = start.point.withUnsafeBufferPointer { startPoint in
+            end.point.withUnsafeBufferPointer { endPoint in
+                query.findPath(start.polyRef, end.polyRef, startPoint.baseAddress, endPoint.baseAddress,
+                               (custom ?? self.filter).query, base, &count, Int32(corridor.count))
+            }
+        }
+        if dtStatusSucceed(res) {
+            return .success(Int(count))
+        }
+        return .failure(NavMesh.statusToError(res))
+    }
+
+    /// String-pulls the corridor in ``PathBuffer/corridor`` from `startPos` to
+    /// `endPos`, as ``findStraightPath(filter:startPos:endPos:pathCorridor:maxPaths:options:)``
+    /// does, into the buffer's points, flags and polygon refs.
+    /// - Returns: The number of points in the straight path
+    public func findStraightPath(startPos: SIMD3<Float>, endPos: SIMD3<Float>, in buffer: PathBuffer,
+                                 options: StraightPathOptions = []) -> Result<Int, NavMesh.NavMeshError> {
+        buffer.setScratch(0, startPos)
+        buffer.setScratch(1, endPos)
+        return straightPath(buffer: buffer, options: options)
+    }
+
+    /// String-pulls `corridor` from `startPos` to `endPos` into caller-owned storage.
+    /// - Parameters:
+    ///   - points: Receives x, y, z per point; its count over 3 is the most points returned
+    ///   - flags: Receives the flags of every point, or nil
+    ///   - refs: Receives the polygon entered at every point, or nil
+    /// - Returns: The number of points written
+    public func findStraightPath(startPos: SIMD3<Float>, endPos: SIMD3<Float>, corridor: UnsafeBufferPointer<dtPolyRef>,
+                                 points: UnsafeMutableBufferPointer<Float>,
+                                 flags: UnsafeMutableBufferPointer<UInt8>? = nil,
+                                 refs: UnsafeMutableBufferPointer<dtPolyRef>? = nil,
+                                 options: StraightPathOptions = []) -> Result<Int, NavMesh.NavMeshError> {
+        var maxPoints = points.count / 3
+        if let flags { maxPoints = min(maxPoints, flags.count) }
+        if let refs { maxPoints = min(maxPoints, refs.count) }
+        guard maxPoints > 0, let corridorBase = corridor.baseAddress, !corridor.isEmpty else {
+            return .failure(.invalidParam)
+        }
+        var count: Int32 = 0
+        var start = startPos
+        var end = endPos
+        let res = withUnsafePointer(to: &start) { startPtr in
+            startPtr.withMemoryRebound(to: Float.self, capacity: 3) { startFloatPtr in
+                withUnsafePointer(to: &end) { endPtr in
+                    endPtr.withMemoryRebound(to: Float.self, capacity: 3) { endFloatPtr in
+                        query.findStraightPath(startFloatPtr, endFloatPtr, corridorBase, Int32(corridor.count),
+                                               points.baseAddress, flags?.baseAddress, refs?.baseAddress,
+                                               &count, Int32(maxPoints), options.rawValue)
+                    }
+                }
+            }
+        }
+        if dtStatusSucceed(res) {
+            return .success(Int(count))
+        }
+        return .failure(NavMesh.statusToError(res))
+    }
+
+    /// Finds the straight path from `startPos` to `endPos`, as
+    /// ``findPath(from:to:filter:)`` does, with every intermediate result kept in `buffer`.
+    ///
+    /// Both positions are snapped to the nearest polygon within `extents`, and
+    /// the corridor between them is found and string-pulled. Nothing is
+    /// allocated: read the path from the buffer.
+    /// - Returns: The number of points in the straight path
+    public func findPath(from startPos: SIMD3<Float>, to endPos: SIMD3<Float>, filter custom: NavQueryFilter? = nil,
+                         extents: SIMD3<Float> = [1, 1, 1], into buffer: PathBuffer,
+                         options: StraightPathOptions = []) -> Result<Int, NavMesh.NavMeshError> {
+        buffer.corridorCount = 0
+        buffer.pointCount = 0
+        buffer.setScratch(0, startPos)
+        buffer.setScratch(1, endPos)
+        buffer.setScratch(4, extents)
+        let filter = (custom ?? self.filter).query
+        let s = buffer.scratch
+        var startRef: dtPolyRef = 0
+        var endRef: dtPolyRef = 0
+        var res = query.findNearestPoly(s, s + 12, filter, &startRef, s + 6)
+        if dtStatusSucceed(res) {
+            res = query.findNearestPoly(s + 3, s + 12, filter, &endRef, s + 9)
+        }
+        if dtStatusFailed(res) {
+            return .failure(NavMesh.statusToError(res))
+        }
+        if case .failure(let error) = findCorridor(filter: custom, startRef: startRef, endRef: endRef, buffer: buffer) {
+            return .failure(error)
+        }
+        return straightPath(buffer: buffer, options: options)
+    }
+
+    /// Corridor between the snapped start and end in scratch slots 2 and 3
+    private func findCorridor(filter custom: NavQueryFilter?, startRef: dtPolyRef, endRef: dtPolyRef,
+                              buffer: PathBuffer) -> Result<Int, NavMesh.NavMeshError> {
+        let cacheKey = corridorCache == nil ? nil : corridorCacheKey(startRef, endRef, custom)
+        if let cache = corridorCache, let cacheKey,
+           let cached = cache.withCorridor(cacheKey, query: query, filter: custom ?? self.filter, { refs -> Int in
+               let n = min(refs.count, buffer.capacity)
+               buffer.corridorBase.update(from: refs.baseAddress!, count: n)
+               return n
+           }) {
+            buffer.corridorCount = cached
+            return .success(cached)
+        }
+        
+        var count: Int32 = 0
+        let s = buffer.scratch
+        let res = query.findPath(startRef, endRef, s + 6, s + 9, (custom ?? self.filter).query,
+                                 buffer.corridorBase, &count, Int32(buffer.capacity))
+        buffer.corridorCount = dtStatusSucceed(res) ? Int(count) : 0
+        if dtStatusSucceed(res) {
+            if let cache = corridorCache, let cacheKey, res == DT_SUCCESS {
+                cache.insert(cacheKey, corridor: buffer.corridor)
+            }
+            return .success(Int(count))
+        }
+        return .failure(NavMesh.statusToError(res))
+    }
+
+    /// String-pulls the buffer's corridor between the positions in scratch slots 0 and 1
+    private func straightPath(buffer: PathBuffer, options: StraightPathOptions) -> Result<Int, NavMesh.NavMeshError> {
+        guard buffer.corridorCount > 0 else {
+            buffer.pointCount = 0
+            return .failure(.invalidParam)
+        }
+        var count: Int32 = 0
+        let s = buffer.scratch
+        let res = query.findStraightPath(s, s + 3, buffer.corridorBase, Int32(buffer.corridorCount),
+                                         buffer.pointBase, buffer.flagBase, buffer.refBase,
+                                         &count, Int32(buffer.capacity), options.rawValue)
+        buffer.pointCount = dtStatusSucceed(res) ? Int(count) : 0
+        if dtStatusSucceed(res) {
+            return .success(Int(count))
+        }
+        return .failure(NavMesh.statusToError(res))
+    }
+}
@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: MIT
+//
+//  PathCorridorCache.swift
+//  SwiftRecastNavigation
+//
+//  Least-recently-used store of polygon corridors between polygon pairs
+//
+
+import CRecast
+import Foundation
+#if canImport(Darwin)
+import Darwin
+#elseif canImport(Glibc)
+import Glibc
+#endif
+
+/// Corridors found between pairs of polygons, kept so that searching the same
+/// pair again skips the A* search.
+///
+/// Attach a cache to one or more queries through ``NavMeshQuery/corridorCache``;
+/// ``NavMeshQuery/findPathCorridor(filter:start:end:maxPaths:)``, the calls built
+/// on it and the ``PathBuffer`` overloads then look corridors up by start
+/// polygon, end polygon and filter settings before they search, so only
+/// string-pulling runs on a hit.
+///
+/// A cached corridor is checked on every hit: once a tile it crosses has been
+/// removed or rebuilt, the salt in its polygon refs no longer matches the navmesh,
+/// and the entry is dropped and searched again. The same happens once one of its
+/// polygons no longer passes the search's filter, as when a door's flags are
+/// changed to close it. A polygon opening up does not drop corridors that could
+/// now be shorter; call ``removeAll()`` for that. Only complete corridors are
+/// stored; partial ones could become complete as tiles are added. The corridor
+/// for a pair is the one found from the positions of its first search, which
+/// can differ slightly from the best one for other positions in the same polygons.
+///
+/// The cache is safe to share between queries on different threads, for
+/// example all the queries of a ``NavMeshQueryPool``, as long as they search
+/// the same navmesh.
+public final class PathCorridorCache: @unchecked Sendable {
+    struct Key: Hashable {
+        let start: dtPolyRef
+        let end: dtPolyRef
+        let filter: Int
+    }
+
+    /// An entry of the recency list, most recent at `head`
+    struct Entry {
+        var key: Key
+        var corridor: [dtPolyRef]
+        var prev: Int
+        var next: Int
+    }
+
+    /// Most corridors kept
+    public let capacity: Int
+
+    private let mutex = UnsafeMutablePointer<pthread_mutex_t>.allocate(capacity: 1)
+    private var index: [Key: Int] = [:]
+    private var entries: [Entry] = []
+    private var head = -1
+    private var tail = -1
+    private var counters = (hits: 0, misses: 0, invalidations: 0)
+
+    /// - Parameter capacity: Most corridors kept; the least recently used one
+    ///   makes way for a new one beyond that
+    public init(capacity: Int = 1024) {
+        self.capacity = max(capacity, 1)
+        index.reserveCapacity(self.capacity)
+        entries.reserveCapacity(self.capacity)
+        pthread_mutex_init(mutex, nil)
+    }
+
+    deinit {
+        pthread_mutex_destroy(mutex)
+        mutex.deallocate()
+    }
+
+    /// Lookups answered from the cache
+    public var hits: Int { locked { counters.hits } }
+    /// Lookups that had to search, including invalidated ones
+    public var misses: Int { locked { counters.misses } }
+    /// Entries dropped because a tile they cross changed
+    public var invalidations: Int { locked { counters.invalidations } }
+    /// Corridors held
+    public var count: Int { locked { index.count } }
+
+    /// Drops every corridor
+    public func removeAll() {
+        locked {
+            index.removeAll(keepingCapacity: true)
+            entries.removeAll(keepingCapacity: true)
+            head = -1
+            tail = -1
+        }
+    }
+
+    /// The corridor stored for `key` if all its polygons are still in the
+    /// navmesh `query` searches and pass `filter`; `body` reads it under the lock
+    func withCorridor<R>(_ key: Key, query: dtNavMeshQuery, filter: NavQueryFilter,
+                         _ body: (UnsafeBufferPointer<dtPolyRef>) -> R) -> R? {
+        locked {
+            guard let slot = index[key] else {
+                counters.misses += 1
+                return nil
+            }
+            let valid = entries[slot].corridor.withUnsafeBufferPointer { refs in
+                bindingPolyRefsValid(query, filter.query, refs.baseAddress, Int32(refs.count)) != 0
+            }
+            guard valid else {
+                remove(slot)
+                counters.invalidations += 1
+                counters.misses += 1
+                return nil
+            }
+            counters.hits += 1
+            moveToFront(slot)
+            return entries[slot].corridor.withUnsafeBufferPointer(body)
+        }
+    }
+
+    /// Stores `corridor` for `key`, replacing the least recently used entry when full
+    func insert(_ key: Key, corridor: UnsafeBufferPointer<dtPolyRef>) {
+        locked {
+            if let slot = index[key] {
+                entries[slot].corridor = Array(corridor)
+                moveToFront(slot)
+                return
+            }
+            let slot: Int
+            if entries.count < capacity {
+                slot = entries.count
+                entries.append(Entry(key: key, corridor: Array(corridor), prev: -1, next: -1))
+            } else {
+                // Reuse the least recent entry's slot
+                slot = tail
+                unlink(slot)
+                index[entries[slot].key] = nil
+                entries[slot].key = key
+                entries[slot].corridor = Array(corridor)
+            }
+            index[key] = slot
+            linkAtFront(slot)
+        }
+    }
+
+    private func locked<R>(_ body: () -> R) -> R {
+        pthread_mutex_lock(mutex)
+        defer { pthread_mutex_unlock(mutex) }
+        return body()
+    }
+
+    private func unlink(_ slot: Int) {
+        let prev = entries[slot].prev
+        let next = entries[slot].next
+        if prev >= 0 { entries[prev].next = next } else { head = next }
+        if next >= 0 { entries[next].prev = prev } else { tail = prev }
+        entries[slot].prev = -1
+        entries[slot].next = -1
+    }
+
+    private func linkAtFront(_ slot: Int) {
+        entries[slot].prev = -1
+        entries[slot].next = head
+        if head >= 0 { entries[head].prev = slot }
+        head = slot
+        if tail < 0 { tail = slot }
+    }
+
+    private func moveToFront(_ slot: Int) {
+        guard slot != head else { return }
+        unlink(slot)
+        linkAtFront(slot)
+    }
+
+    /// Removes the entry in `slot`, moving the last entry into it to keep the storage dense
+    private func remove(_ slot: Int) {
+        unlink(slot)
+        index[entries[slot].key] = nil
+        let last = entries.count - 1
+        if slot != last {
+            let moved = entries[last]
+            entries[slot] = moved
+            index[moved.key] = slot
+            if moved.prev >= 0 { entries[moved.prev].next = slot } else { head = slot }
+            if moved.next >= 0 { entries[moved.next].prev = slot } else { tail = slot }
+        }
+        entries.removeLast()
+    }
+}
@@ -0,0 +1,252 @@
+// SPDX-License-Identifier: MIT
+//
+//  PathRequestScheduler.swift
+//  SwiftRecastNavigation
+//
+//  Path searches spread over frames within a fixed time budget
+//
+
+import CRecast
+import Foundation
+#if canImport(Darwin)
+import Darwin
+#elseif canImport(Glibc)
+import Glibc
+#endif
+
+/// Finds path corridors a little at a time, so that long searches do not make a frame late.
+///
+/// ``NavMeshQuery/findPathCorridor(filter:start:end:maxPaths:)`` runs a whole
+/// search before it returns, and a search across a large navmesh can take
+/// longer than a frame. The scheduler takes requests from any task and hands
+/// back the corridors asynchronously, while ``update(microseconds:)``, called once a
+/// frame, advances the sliced searches of `dtNavMeshQuery` for at most the
+/// time given, highest priority first.
+///
+/// ```swift
+/// let scheduler = try PathRequestScheduler(navMesh: navMesh)
+/// Task {
+///     let corridor = try await scheduler.findPathCorridor(start: spawn, end: objective)
+///     ...
+/// }
+/// // Every frame:
+/// scheduler.update(microseconds: 500)
+/// ```
+///
+/// Requests can be made from any thread. ``update(microseconds:)`` must be called
+/// from one thread at a time and holds shared tile access while it searches.
+/// Cancelling the task of a request drops the request and throws `CancellationError`.
+public final class PathRequestScheduler: @unchecked Sendable {
+    /// The navmesh the searches run on
+    public let navMesh: NavMesh
+    /// Polygons each search expands between checks of the time budget
+    public var iterationsPerStep: Int = 32
+
+    private final class Request: @unchecked Sendable {
+        let start: PointInPoly
+        let end: PointInPoly
+        let filter: NavQueryFilter
+        let maxPaths: Int
+        let priority: Int
+        let order: UInt64
+        var continuation: CheckedContinuation<[dtPolyRef], Error>?
+        var cancelled = false
+
+        init(start: PointInPoly, end: PointInPoly, filter: NavQueryFilter, maxPaths: Int, priority: Int, order: UInt64) {
+            self.start = start
+            self.end = end
+            self.filter = filter
+            self.maxPaths = maxPaths
+            self.priority = priority
+            self.order = order
+        }
+
+        // Higher priority first, then first come first served
+        func precedes(_ other: Request) -> Bool {
+            priority != other.priority ? priority > other.priority : order < other.order
+        }
+    }
+
+    private let mutex = UnsafeMutablePointer<pthread_mutex_t>.allocate(capacity: 1)
+    private let queries: [NavMeshQuery]
+    private var searches: [Request?]
+    private var pending: [Request] = []
+    private var nextOrder: UInt64 = 0
+
+    /// Creates a scheduler for `navMesh`
+    /// - Parameters:
+    ///   - navMesh: The navmesh to search
+    ///   - maxNodes: Maximum number of search nodes of each search. [Limits: 0 < value <= 65535]
+    ///   - concurrentSearches: Searches under way at once; more requests wait their turn
+    ///   - landmarks: A landmark table the searches use, see ``NavMeshQuery/landmarks``
+    public init(navMesh: NavMesh, maxNodes: Int = 2048, concurrentSearches: Int = 4,
+                landmarks: NavMeshLandmarks? = nil) throws {
+        self.navMesh = navMesh
+        var queries = [NavMeshQuery]()
+        for _ in 0..<max(concurrentSearches, 1) {
+            let query = try NavMeshQuery(nav: navMesh, maxNodes: Int32(maxNodes))
+            query.landmarks = landmarks
+            queries.append(query)
+        }
+        self.queries = queries
+        self.searches = Array(repeating: nil, count: queries.count)
+        pthread_mutex_init(mutex, nil)
+    }
+
+    deinit {
+        pthread_mutex_destroy(mutex)
+        mutex.deallocate()
+    }
+
+    /// Finds the polygon corridor from `start` to `end`, as
+    /// ``NavMeshQuery/findPathCorridor(filter:start:end:maxPaths:)`` does, over
+    /// the next calls to ``update(microseconds:)``.
+    ///
+    /// When `end` cannot be reached, the corridor ends at the polygon nearest it
+    /// that can, and the result is still a success.
+    /// - Parameters:
+    ///   - filter: Polygons to use and area costs, the default filter if nil
+    ///   - start: Starting point
+    ///   - end: End point
+    ///   - maxPaths: Most polygons in the corridor
+    ///   - priority: Requests with higher values are searched first
+    public func findPathCorridor(filter: NavQueryFilter? = nil, start: PointInPoly, end: PointInPoly,
+                                 maxPaths: Int = 512, priority: Int = 0) async throws -> [dtPolyRef] {
+        pthread_mutex_lock(mutex)
+        let request = Request(start: start, end: end, filter: filter ?? NavQueryFilter(),
+                              maxPaths: max(maxPaths, 1), priority: priority, order: nextOrder)
+        nextOrder += 1
+        pthread_mutex_unlock(mutex)
+
+        return try await withTaskCancellationHandler {
+            try await withCheckedThrowingContinuation { continuation in
+                pthread_mutex_lock(mutex)
+                if request.cancelled {
+                    pthread_mutex_unlock(mutex)
+                    continuation.resume(throwing: CancellationError())
+                    return
+                }
+                request.continuation = continuation
+                pending.append(request)
+                pthread_mutex_unlock(mutex)
+            }
+        } onCancel: {
+            self.cancel(request)
+        }
+    }
+
+    /// Requests waiting for a search to start, and searches under way
+    public var requestCount: Int {
+        pthread_mutex_lock(mutex)
+        defer { pthread_mutex_unlock(mutex) }
+        return pending.count + searches.reduce(0) { $0 + ($1 == nil ? 0 : 1) }
+    }
+
+    /// Advances the searches, highest priority first, for about `microseconds`.
+    ///
+    /// Searches that complete hand their corridor to the caller that requested it,
+    /// and the requests waiting their turn take their place.
+    /// - Parameter microseconds: Time to spend
+    /// - Returns: The number of requests completed
+    @discardableResult
+    public func update(microseconds: Int) -> Int {
+        let deadline = DispatchTime.now().uptimeNanoseconds + UInt64(max(microseconds, 0)) * 1000
+        var completed: [(CheckedContinuation<[dtPolyRef], Error>, Result<[dtPolyRef], Error>)] = []
+
+        navMesh.withSharedTileAccess {
+            startSearches(&completed)
+            repeat {
+                guard let slot = nextSearch() else { break }
+                let query = queries[slot].query
+                var done: Int32 = 0
+                let status = query.updateSlicedFindPath(Int32(max(iterationsPerStep, 1)), &done)
+                if dtStatusInProgress(status) {
+                    continue
+                }
+                let request = searches[slot]!
+                var result = [dtPolyRef](repeating: 0, count: request.maxPaths)
+                var count: Int32 = 0
+                let final = dtStatusFailed(status) ? status : query.finalizeSlicedFindPath(&result, &count, Int32(result.count))
+                if dtStatusSucceed(final) {
+                    result.removeSubrange(Int(count)..<result.count)
+                    completed.append((request.continuation!, .success(result)))
+                } else {
+                    completed.append((request.continuation!, .failure(NavMesh.statusToError(final))))
+                }
+                pthread_mutex_lock(mutex)
+                searches[slot] = nil
+                pthread_mutex_unlock(mutex)
+                startSearches(&completed)
+            } while DispatchTime.now().uptimeNanoseconds < deadline
+        }
+
+        for (continuation, result) in completed {
+            continuation.resume(with: result)
+        }
+        return completed.count
+    }
+
+    // The slot of the search to advance next: the one of the highest priority
+    private func nextSearch() -> Int? {
+        var best: Int?
+        for (slot, request) in searches.enumerated() {
+            guard let request else { continue }
+            if let b = best, !request.precedes(searches[b]!) { continue }
+            best = slot
+        }
+        return best
+    }
+
+    // Drops cancelled searches and starts the waiting requests of the highest
+    // priority in the free slots. Requests that cannot start fail at once.
+    private func startSearches(_ completed: inout [(CheckedContinuation<[dtPolyRef], Error>, Result<[dtPolyRef], Error>)]) {
+        pthread_mutex_lock(mutex)
+        defer { pthread_mutex_unlock(mutex) }
+        for slot in searches.indices {
+            if let request = searches[slot], request.cancelled {
+                completed.append((request.continuation!, .failure(CancellationError())))
+                searches[slot] = nil
+            }
+        }
+        pending.sort { $0.precedes($1) }
+        var taken = 0
+        for slot in searches.indices where searches[slot] == nil && taken < pending.count {
+            while taken < pending.count {
+                let request = pending[taken]
+                taken += 1
+                let status = queries[slot].query.initSlicedFindPath(request.start.polyRef, request.end.polyRef,
+                                                                    request.start.point, request.end.point,
+                                                                    request.filter.query, 0)
+                if dtStatusFailed(status) {
+                    completed.append((request.continuation!, .failure(NavMesh.statusToError(status))))
+                    continue
+                }
+                searches[slot] = request
+                break
+            }
+        }
+        pending.removeFirst(taken)
+    }
+
+    private func cancel(_ request: Request) {
+        pthread_mutex_lock(mutex)
+        request.cancelled = true
+        var continuation: CheckedContinuation<[dtPolyRef], Error>?
+        if let index = pending.firstIndex(where: { $0 === request }) {
+            pending.remove(at: index)
+            continuation = request.continuation
+        }
+        pthread_mutex_unlock(mutex)
+        continuation?.resume(throwing: CancellationError())
+    }
+}
+
+extension NavMesh {
+    /// Creates a ``PathRequestScheduler`` that finds paths on this navmesh within a time budget per frame
+    /// - Parameters:
+    ///   - maxNodes: Maximum number of search nodes of each search. [Limits: 0 < value <= 65535]
+    ///   - concurrentSearches: Searches under way at once
+    public func makePathRequestScheduler(maxNodes: Int = 2048, concurrentSearches: Int = 4) throws -> PathRequestScheduler {
+        try PathRequestScheduler(navMesh: self, maxNodes: maxNodes, concurrentSearches: concurrentSearches)
+    }
+}
@@ -142,69 +142,27 @@ public extension NavMeshQuery {
     /// - Returns: On success, returns an array of all polygon references in the tile.
     ///           Returns an empty array if the tile doesn't exist.
     ///
-    /// - Note: This method iterates through all tiles to find the matching coordinates.
-    ///         For better performance with frequent queries, consider caching tile references.
+    /// - Note: The tile is looked up by its coordinates directly, so the cost is
+    ///         proportional to the polygons in the tile, not to the tiles in the mesh.
     func findPolysInTile(
         tileX: Int,
         tileY: Int,
         layer: Int = 0
     ) -> [dtPolyRef] {
         // Access the underlying navmesh through the query
-        guard let navMesh = query.getAttachedNavMesh() else {
-            return []
-        }
-        
-        // Find the tile with matching coordinates
-        // We need to iterate through tiles to find the one with the right x,y coordinates
-        let maxTiles = dtNavMeshGetMaxTiles(navMesh)
-        var targetTile: OpaquePointer?
-        
-        for i in 0..<maxTiles {
-            guard let tile = dtNavMeshGetTile(navMesh, i) else { continue }
-            
-            var tx: Int32 = 0
-            var ty: Int32 = 0
-            var tlayer: Int32 = 0
-            dtNavMeshGetTileStateAt(navMesh, i, &tx, &ty, &tlayer)
-            
-            if tx == Int32(tileX), ty == Int32(tileY), tlayer == Int32(layer) {
-                targetTile = tile
-                break
-            }
-        }
-        
-        guard let tile = targetTile,
+        guard let navMesh = query.getAttachedNavMesh(),
+              let tile = dtNavMeshGetTileAt(navMesh, Int32(tileX), Int32(tileY), Int32(layer)),
               let header = dtMeshTileGetHeader(tile)
         else {
             return []
         }
         
-        let polyCount = Int(dtMeshHeaderGetPolyCount(header))
-        var polyRefs: [dtPolyRef] = []
-        polyRefs.reserveCapacity(polyCount)
-        
-        // Get the base reference for this tile
-        let base = dtNavMeshGetPolyRefBase(navMesh, tile)
-        
-        // Get all polygons in this tile
-        if let polys = dtMeshTileGetPolys(tile) {
-            for i in 0..<polyCount {
-                // Calculate the polygon reference
-                // Skip null polygons (those without vertices)
-                var poly = polys.advanced(by: i).pointee
-                if dtPolyGetVertCount(&poly) > 0 {
-                    let ref = base | dtPolyRef(i)
-                    polyRefs.append(ref)
-                }
-            }
-        }
-        
-        return polyRefs
+        return tilePolyRefs(navMesh, tile, polyCount: Int(dtMeshHeaderGetPolyCount(header)))
     }
     
     /// Finds all polygons within a tile by tile index.
     ///
-    /// This is more efficient than `findPolysInTile` if you already know the tile index.
+    /// Use this instead of `findPolysInTile` if you already know the tile index.
     ///
     /// - Parameter tileIndex: The index of the tile (0 to maxTiles-1)
     /// - Returns: On success, returns an array of all polygon references in the tile.
@@ -215,34 +173,7 @@ public extension NavMeshQuery {
             return []
         }
         
-        guard tileIndex >= 0, tileIndex < dtNavMeshGetMaxTiles(navMesh),
-              let tile = dtNavMeshGetTile(navMesh, Int32(tileIndex)),
-              let header = dtMeshTileGetHeader(tile)
-        else {
-            return []
-        }
-        
-        let polyCount = Int(dtMeshHeaderGetPolyCount(header))
-        var polyRefs: [dtPolyRef] = []
-        polyRefs.reserveCapacity(polyCount)
-        
-        // Get the base reference for this tile
-        let base = dtNavMeshGetPolyRefBase(navMesh, tile)
-        
-        // Get all polygons in this tile
-        if let polys = dtMeshTileGetPolys(tile) {
-            for i in 0..<polyCount {
-                // Calculate the polygon reference
-                // Skip null polygons (those without vertices)
-                var poly = polys.advanced(by: i).pointee
-                if dtPolyGetVertCount(&poly) > 0 {
-                    let ref = base | dtPolyRef(i)
-                    polyRefs.append(ref)
-                }
-            }
-        }
-        
-        return polyRefs
+        return tilePolyRefs(navMesh, tileIndex)
     }
     
     /// Finds all polygons overlapping a bounding box.
@@ -358,50 +289,22 @@ public extension NavMeshQuery {
             return nil
         }
         
-        // Find the tile containing this polygon
-        // We need to iterate through tiles to find the one containing this polyRef
-        let maxTiles = dtNavMeshGetMaxTiles(navMesh)
-        var targetTile: OpaquePointer?
-        var polyIndex: Int = -1
-        
-        for i in 0..<maxTiles {
-            guard let tile = dtNavMeshGetTile(navMesh, i),
-                  let header = dtMeshTileGetHeader(tile) else { continue }
-            
-            let base = dtNavMeshGetPolyRefBase(navMesh, tile)
-            let polyCount = Int(dtMeshHeaderGetPolyCount(header))
-            
-            // Check if this polyRef belongs to this tile
-            for j in 0..<polyCount {
-                if (base | dtPolyRef(j)) == polyRef {
-                    targetTile = tile
-                    polyIndex = j
-                    break
-                }
-            }
-            
-            if targetTile != nil { break }
-        }
-        
-        guard let tile = targetTile,
-              let header = dtMeshTileGetHeader(tile),
-              let polys = dtMeshTileGetPolys(tile),
-              let verts = dtMeshTileGetVerts(tile),
-              polyIndex >= 0
+        // The polygon reference names its tile and polygon directly
+        guard let tile = dtNavMeshGetTileByPolyRef(navMesh, polyRef),
+              let poly = dtNavMeshGetPolyByRef(navMesh, polyRef),
+              let verts = dtMeshTileGetVerts(tile)
         else {
             return nil
         }
         
-        // Get the polygon
-        var poly = polys.advanced(by: polyIndex).pointee
-        let vertCount = Int(dtPolyGetVertCount(&poly))
+        let vertCount = Int(dtPolyGetVertCount(poly))
         
         // Extract vertices
         var vertices: [SIMD3<Float>] = []
         vertices.reserveCapacity(vertCount)
         
         for i in 0..<vertCount {
-            let vertIndex = Int(dtPolyGetVert(&poly, Int32(i)))
+            let vertIndex = Int(dtPolyGetVert(poly, Int32(i)))
             let baseIdx = vertIndex * 3
             vertices.append(SIMD3<Float>(
                 verts[baseIdx],
@@ -414,11 +317,12 @@ public extension NavMeshQuery {
         var neighbors: [dtPolyRef] = []
         neighbors.reserveCapacity(vertCount)
         
+        let base = dtNavMeshGetPolyRefBase(navMesh, tile)
         for i in 0..<vertCount {
-            let nei = dtPolyGetNeighbor(&poly, Int32(i))
+            let nei = dtPolyGetNeighbor(poly, Int32(i))
             if nei != 0 {
                 // Convert local index to full reference
-                let neiRef = dtNavMeshGetPolyRefBase(navMesh, tile) | dtPolyRef(nei - 1)
+                let neiRef = base | dtPolyRef(nei - 1)
                 neighbors.append(neiRef)
             } else {
                 neighbors.append(0) // No neighbor on this edge
@@ -429,8 +333,8 @@ public extension NavMeshQuery {
             polyRef: polyRef,
             vertices: vertices,
             neighbors: neighbors,
-            flags: dtPolyGetFlags(&poly),
-            area: dtPolyGetArea(&poly)
+            flags: dtPolyGetFlags(poly),
+            area: dtPolyGetArea(poly)
         )
     }
     
@@ -47,36 +47,25 @@ public class CrowdSystem: System {
     }
     
     public func update(context: SceneUpdateContext) {
-        var crowds: [Crowd] = []
-        var crowd: Crowd? = nil
+        // Group the entities by crowd, with the agent index of each, so every
+        // crowd is updated once and its positions read in one pass.
+        var groups: [ObjectIdentifier: (crowd: Crowd, entities: [(entity: Entity, idx: Int32)])] = [:]
         context.scene.performQuery(Self.query).forEach { entity in
-            
-            guard let agentComponent = entity.components [AgentComponent.self] else {
+            guard let agent = entity.components [AgentComponent.self]?.agent, agent.idx >= 0 else {
                 return
             }
-            let agent = agentComponent.agent
-            let agentCrowd = agent.crowd
-            
-            // Ensure all the crowd systems have been invoked, there might be more
-            // than one crowd system active
-            if crowd == nil {
-                crowd = agentCrowd
-                crowds = [agentCrowd]
-                agentCrowd.update(time: Float (context.deltaTime))
-            } else if crowd === agent.crowd {
-                // common path, single crowd.
-                // update was already called on this crowd
-            } else {
-                // We have more than one crowd active
-                if crowds.contains (where: { $0 === agentCrowd }) {
-                    // No need to do anything, the crowd update has already been called
-                } else {
-                    // Ok, a new crowd showed up, make sure we call the update function
-                    crowds.append(agentCrowd)
-                    agentCrowd.update (time: Float (context.deltaTime))
+            groups[ObjectIdentifier(agent.crowd), default: (agent.crowd, [])].entities.append((entity, agent.idx))
+        }
+
+        let deltaTime = Float (context.deltaTime)
+        for group in groups.values {
+            group.crowd.update(time: deltaTime)
+            group.crowd.withAgentPositions { positions in
+                for (entity, idx) in group.entities {
+                    let p = positions + Int(idx) * 3
+                    entity.position = SIMD3<Float>(p[0], p[1], p[2])
                 }
             }
-            entity.position = agent.position
         }
     }
 }
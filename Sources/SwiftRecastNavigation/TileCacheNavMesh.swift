@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: MIT
+//
+//  TileCacheNavMesh.swift
+//  SwiftRecastNavigation
+//
+//  Navigation mesh with temporary obstacles, backed by DetourTileCache
+//
+
+import CRecast
+import Foundation
+
+/// A navigation mesh that temporary obstacles can be added to and removed
+/// from at runtime.
+///
+/// Every tile is voxelised once and kept as compressed heightfield layers.
+/// When obstacles change, ``update(maxTileUpdates:)`` carves them out of the
+/// affected layers and rebuilds those tiles from the layers alone, so an update
+/// costs a few tiles' worth of region and polygon building rather than a
+/// rebuild from the triangles.
+///
+/// ```swift
+/// let mesh = try TileCacheNavMesh(vertices: verts, triangles: tris, config: config)
+/// let query = try mesh.navMesh.makeQuery()
+/// let door = mesh.addBoxObstacle(min: doorMin, max: doorMax)
+/// try mesh.update()
+/// ```
+///
+/// Obstacles only affect ``navMesh`` during ``update(maxTileUpdates:)``. Call it,
+/// and the obstacle methods, from the thread or actor that queries the navmesh.
+///
+/// Tiles are built with DetourTileCache's own region and polygon steps and
+/// carry no detail mesh, so heights on them follow the voxel layers. The
+/// configuration needs a `tileSize` greater than 0, and the tile size plus the
+/// border (`walkableRadius + 3` on each side) must not exceed 255 cells.
+public final class TileCacheNavMesh {
+    /// Identifies an obstacle added to the mesh
+    public typealias ObstacleID = UInt32
+
+    /// Sizes and build time of the tile cache
+    public struct Stats {
+        /// Navmesh tiles built from the layers
+        public let tiles: Int
+        /// Compressed heightfield layers kept for rebuilding
+        public let layers: Int
+        /// Bytes of compressed layer data
+        public let compressedSize: Int
+        /// Bytes the same layers take uncompressed
+        public let uncompressedSize: Int
+        /// Wall-clock time of the initial build, in milliseconds
+        public let buildTime: Double
+    }
+
+    /// Owns the tile cache and its navmesh; ``navMesh`` keeps it alive
+    final class Handle {
+        let mesh: OpaquePointer
+
+        init(_ mesh: OpaquePointer) {
+            self.mesh = mesh
+        }
+
+        deinit {
+            bindingReleaseTileCacheMesh(mesh)
+        }
+    }
+
+    private let handle: Handle
+
+    /// The navmesh kept up to date with the obstacles
+    public let navMesh: NavMesh
+
+    /// The configuration used to build the mesh
+    public let config: NavMeshConfig
+
+    /// Builds the tile cache and the initial navmesh
+    /// - Parameters:
+    ///   - vertices: Array of vertices
+    ///   - triangles: Triangle index array
+    ///   - config: Configuration for mesh creation; `tileSize` must be set
+    ///   - areas: Optional array of area definitions for marking special regions
+    ///   - maxObstacles: Most obstacles that can exist at the same time
+    public convenience init(
+        vertices: [SIMD3<Float>],
+        triangles: [Int32],
+        config: NavMeshConfig = NavMeshConfig(),
+        areas: [AreaDefinition] = [],
+        maxObstacles: Int = 128
+    ) throws {
+        try self.init(
+            vertices: NavMeshBuilder.flatten(vertices),
+            triangles: triangles,
+            config: config,
+            areas: areas,
+            maxObstacles: maxObstacles
+        )
+    }
+
+    /// Builds the tile cache from flattened vertices and triangles
+    public init(
+        vertices: [Float],
+        triangles: [Int32],
+        config: NavMeshConfig = NavMeshConfig(),
+        areas: [AreaDefinition] = [],
+        maxObstacles: Int = 128
+    ) throws {
+        guard config.tileSize > 0, maxObstacles > 0 else { throw NavMeshError.invalidConfiguration }
+
+        let builder = try NavMeshBuilder(
+            vertices: vertices,
+            triangles: triangles,
+            config: config,
+            areas: areas,
+            buildTiles: false
+        )
+        guard let input = builder.buildInput else { throw NavMeshError.invalidConfiguration }
+
+        var code = BCODE_OK
+        guard let mesh = bindingCreateTileCacheMesh(input, Int32(maxObstacles), &code) else {
+            switch code {
+            case BCODE_ERR_MEMORY: throw NavMeshError.memory
+            case BCODE_ERR_INIT_TILE_NAVMESH: throw NavMeshError.initTileNavMesh
+            case BCODE_ERR_BUILD_TILE: throw NavMeshError.buildTile
+            case BCODE_ERR_ADD_TILE: throw NavMeshError.addTile
+            default: throw NavMeshError.invalidConfiguration
+            }
+        }
+        handle = Handle(mesh)
+        guard let detourMesh = bindingTileCacheGetNavMesh(mesh) else { throw NavMeshError.unknown }
+        navMesh = NavMesh(navMesh: detourMesh, owner: handle)
+        self.config = config
+    }
+
+    /// Adds an upright cylinder standing on `position`
+    /// - Returns: The obstacle's identifier, or nil when `maxObstacles` are already in use
+    public func addCylinderObstacle(at position: SIMD3<Float>, radius: Float, height: Float) -> ObstacleID? {
+        var pos = [position.x, position.y, position.z]
+        let ref = bindingTileCacheAddCylinderObstacle(handle.mesh, &pos, radius, height)
+        return ref != 0 ? ref : nil
+    }
+
+    /// Adds an axis-aligned box
+    /// - Returns: The obstacle's identifier, or nil when `maxObstacles` are already in use
+    public func addBoxObstacle(min: SIMD3<Float>, max: SIMD3<Float>) -> ObstacleID? {
+        var bmin = [min.x, min.y, min.z]
+        var bmax = [max.x, max.y, max.z]
+        let ref = bindingTileCacheAddBoxObstacle(handle.mesh, &bmin, &bmax)
+        return ref != 0 ? ref : nil
+    }
+
+    /// Adds a box rotated around the vertical axis
+    /// - Parameters:
+    ///   - center: Center of the box
+    ///   - halfExtents: Half of the box's size along each of its own axes
+    ///   - yRotation: Rotation around the Y axis, in radians
+    /// - Returns: The obstacle's identifier, or nil when `maxObstacles` are already in use
+    public func addBoxObstacle(center: SIMD3<Float>, halfExtents: SIMD3<Float>, yRotation: Float) -> ObstacleID? {
+        var c = [center.x, center.y, center.z]
+        var h = [halfExtents.x, halfExtents.y, halfExtents.z]
+        let ref = bindingTileCacheAddOrientedBoxObstacle(handle.mesh, &c, &h, yRotation)
+        return ref != 0 ? ref : nil
+    }
+
+    /// Removes an obstacle; the navmesh changes on the next ``update(maxTileUpdates:)``
+    /// - Returns: false if the obstacle does not exist
+    @discardableResult
+    public func removeObstacle(_ id: ObstacleID) -> Bool {
+        bindingTileCacheRemoveObstacle(handle.mesh, id) == BD_OK
+    }
+
+    /// Applies pending obstacle changes to ``navMesh`` by rebuilding the tiles they touch.
+    /// - Parameter maxTileUpdates: Most tiles to rebuild in this call, 0 for all of
+    ///   them. Spread large changes over frames by passing a small budget.
+    /// - Returns: true once no change is left pending
+    @discardableResult
+    public func update(maxTileUpdates: Int = 0) throws -> Bool {
+        var upToDate: Int32 = 0
+        let status = navMesh.withExclusiveTileAccess {
+            bindingTileCacheUpdate(handle.mesh, Int32(maxTileUpdates), &upToDate)
+        }
+        guard status == BD_OK else {
+            throw NavMeshError.buildTile
+        }
+        return upToDate != 0
+    }
+
+    /// Sizes and build time of the tile cache
+    public var stats: Stats {
+        var s = BindingTileCacheStats()
+        bindingTileCacheGetStats(handle.mesh, &s)
+        return Stats(
+            tiles: Int(s.tiles),
+            layers: Int(s.layers),
+            compressedSize: Int(s.compressedSize),
+            uncompressedSize: Int(s.uncompressedSize),
+            buildTime: s.buildTimeMs
+        )
+    }
+}
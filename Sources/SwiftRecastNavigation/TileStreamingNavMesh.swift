@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: MIT
+//
+//  TileStreamingNavMesh.swift
+//  SwiftRecastNavigation
+//
+//  Navigation mesh that keeps only the tiles near a moving focus resident
+//
+
+import CRecast
+import Foundation
+
+/// A navigation mesh streamed from an indexed file, with only the tiles
+/// around a focus point (usually the player) in memory.
+///
+/// The file is written by ``NavMesh/exportIndexedData()``
+/// or ``NavMeshBuilder/exportIndexedData()`` and starts with a table of its
+/// tiles, so opening it reads only that table. Each ``update(focus:loadRadius:unloadRadius:maxTileAdds:)``
+/// drops the tiles that moved out of range and queues the missing ones,
+/// nearest first, for a background reader; the tiles read since the previous
+/// update are added to ``navMesh``.
+///
+/// ```swift
+/// let world = try TileStreamingNavMesh(contentsOf: url, memoryBudget: 32 << 20)
+/// world.update(focus: player, loadRadius: 150)
+/// world.flush()                       // Block once for the tiles around the spawn point
+/// let query = try world.navMesh.makeQuery()
+/// // Every frame:
+/// world.update(focus: player, loadRadius: 150)
+/// ```
+///
+/// Tiles only change during ``update(focus:loadRadius:unloadRadius:maxTileAdds:)``
+/// and ``flush()``; call them from the thread or actor that queries the navmesh.
+/// A tile keeps its polygon refs when it is unloaded and loaded again, but refs
+/// into an unloaded tile are invalid until then.
+public final class TileStreamingNavMesh {
+    /// What is resident and what is on its way
+    public struct Stats {
+        /// Tiles in the file
+        public let totalTiles: Int
+        /// Tiles in ``TileStreamingNavMesh/navMesh``
+        public let residentTiles: Int
+        /// Tiles queued, being read, or read and waiting to be added
+        public let pendingTiles: Int
+        /// Bytes of tile data held by the navmesh
+        public let residentBytes: Int
+        /// Tiles added so far
+        public let loads: Int
+        /// Tiles removed so far
+        public let unloads: Int
+        /// Tiles that could not be read, decoded or added; they are not retried
+        public let failures: Int
+        /// Tiles in range that the latest update left out to stay within the memory budget
+        public let budgetSkipped: Int
+    }
+
+    /// Owns the stream and its navmesh; ``navMesh`` keeps it alive
+    final class Handle {
+        let stream: OpaquePointer
+
+        init(_ stream: OpaquePointer) {
+            self.stream = stream
+        }
+
+        deinit {
+            bindingCloseTileStream(stream)
+        }
+    }
+
+    private let handle: Handle
+
+    /// The navmesh holding the resident tiles
+    public let navMesh: NavMesh
+
+    /// Opens an indexed navmesh file with no tiles resident yet
+    /// - Parameters:
+    ///   - url: File URL of the indexed navmesh
+    ///   - memoryBudget: Most bytes of tile data to keep resident or in flight,
+    ///     0 for no limit. Tiles in range beyond it are skipped, farthest first.
+    public init(contentsOf url: URL, memoryBudget: Int = 0) throws {
+        var status: dtStatus = 0
+        guard let stream = bindingOpenTileStream(url.path, Int64(memoryBudget), &status) else {
+            throw NavMesh.statusToError(status)
+        }
+        handle = Handle(stream)
+        guard let detourMesh = bindingTileStreamGetNavMesh(stream) else { throw NavMeshError.unknown }
+        navMesh = NavMesh(navMesh: detourMesh, owner: handle)
+    }
+
+    /// Moves the resident region to `focus`.
+    /// - Parameters:
+    ///   - focus: Centre of the region; distances are measured on the xz plane to each tile's bounds
+    ///   - loadRadius: Tiles within this distance are loaded
+    ///   - unloadRadius: Tiles beyond this distance are unloaded. Defaults to a
+    ///     quarter more than `loadRadius`, so small moves back and forth do not
+    ///     reload the same tiles.
+    ///   - maxTileAdds: Most tiles to add in this call, 0 for all that are ready
+    /// - Returns: The number of tiles added
+    @discardableResult
+    public func update(focus: SIMD3<Float>, loadRadius: Float, unloadRadius: Float? = nil, maxTileAdds: Int = 0) -> Int {
+        var pos = [focus.x, focus.y, focus.z]
+        return navMesh.withExclusiveTileAccess {
+            Int(bindingTileStreamUpdate(handle.stream, &pos, loadRadius,
+                                        unloadRadius ?? loadRadius * 1.25, Int32(maxTileAdds)))
+        }
+    }
+
+    /// Waits for every tile queued by the latest update to be read, and adds them all
+    /// - Returns: The number of tiles added
+    @discardableResult
+    public func flush() -> Int {
+        navMesh.withExclusiveTileAccess {
+            Int(bindingTileStreamFlush(handle.stream))
+        }
+    }
+
+    /// What is resident and what is on its way
+    public var stats: Stats {
+        var s = BindingTileStreamStats()
+        bindingTileStreamGetStats(handle.stream, &s)
+        return Stats(
+            totalTiles: Int(s.totalTiles),
+            residentTiles: Int(s.residentTiles),
+            pendingTiles: Int(s.pendingTiles),
+            residentBytes: Int(s.residentBytes),
+            loads: Int(s.loads),
+            unloads: Int(s.unloads),
+            failures: Int(s.failures),
+            budgetSkipped: Int(s.budgetSkipped)
+        )
+    }
+}
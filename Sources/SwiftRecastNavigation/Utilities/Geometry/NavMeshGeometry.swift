@@ -64,114 +64,137 @@ public extension NavMesh {
 
         // Walk every allocated tile
         for tileIdx in 0 ..< maxTiles {
-            // ───────────────────────────────────────────────
-            // 1️⃣ Get tile as opaque pointer
-            // ───────────────────────────────────────────────
-            guard let tilePtr = dtNavMeshGetTile(navMesh, Int32(tileIdx)) else {
-                trace("· tile", tileIdx, "is nil – skipped")
-                continue
-            }
+            extractTile(tileIdx, into: &polys, tiles: &tileInfos, verbose: verbose)
+        }
 
-            // Get tile header
-            guard let headerPtr = dtMeshTileGetHeader(tilePtr) else {
-                // Skip empty tiles - this is normal behavior
-                continue
-            }
+        trace("Extraction finished – total polys:", polys.count, "tiles:", tileInfos.count)
+        return NavMeshGeometry(polygons: polys, tiles: tileInfos)
+    }
 
-            // Get vertices and polygons
-            guard let vertsPtr = dtMeshTileGetVerts(tilePtr),
-                  let polysPtr = dtMeshTileGetPolys(tilePtr)
-            else {
-                trace("· tile", tileIdx, "missing verts/polys – skipped")
-                continue
-            }
+    /// Pulls the geometry of the tile at a grid location and layer out of the live
+    /// Detour structure, without visiting any other tile.
+    /// Returns an empty geometry if there is no tile there.
+    func extractGeometry(tileX: Int32, tileY: Int32, layer: Int32 = 0, verbose: Bool = false) -> NavMeshGeometry {
+        var polys: [NavMeshGeometry.Polygon] = []
+        var tileInfos: [NavMeshGeometry.TileInfo] = []
+        if let tileIdx = tileIndex(x: tileX, y: tileY, layer: layer) {
+            extractTile(tileIdx, into: &polys, tiles: &tileInfos, verbose: verbose)
+        }
+        return NavMeshGeometry(polygons: polys, tiles: tileInfos)
+    }
+
+    /// Appends the polygons and info of the tile in slot `tileIdx`
+    private func extractTile(_ tileIdx: Int, into polys: inout [NavMeshGeometry.Polygon],
+                             tiles tileInfos: inout [NavMeshGeometry.TileInfo], verbose: Bool) {
+        @inline(__always) func trace(_ items: Any...) {
+            guard verbose else { return }
+            geomLog.debug("\(items.map { "\($0)" }.joined(separator: " "))")
+        }
+
+        // ───────────────────────────────────────────────
+        // 1️⃣ Get tile as opaque pointer
+        // ───────────────────────────────────────────────
+        guard let tilePtr = dtNavMeshGetTile(navMesh, Int32(tileIdx)) else {
+            trace("· tile", tileIdx, "is nil – skipped")
+            return
+        }
 
-            let polyCount = Int(dtMeshHeaderGetPolyCount(headerPtr))
-            let vertCount = Int(dtMeshHeaderGetVertCount(headerPtr))
-
-            // Get tile coordinates
-            var tileX: Int32 = 0
-            var tileY: Int32 = 0
-            var tileLayer: Int32 = 0
-            dtNavMeshGetTileStateAt(navMesh, Int32(tileIdx), &tileX, &tileY, &tileLayer)
-
-            // Calculate tile bounds
-            var tileBounds = (min: SIMD3<Float>(Float.greatestFiniteMagnitude,
-                                                Float.greatestFiniteMagnitude,
-                                                Float.greatestFiniteMagnitude),
-                              max: SIMD3<Float>(-Float.greatestFiniteMagnitude,
-                                                -Float.greatestFiniteMagnitude,
-                                                -Float.greatestFiniteMagnitude))
-
-            // Update bounds based on all vertices in this tile
-            for i in 0 ..< vertCount {
-                let vertIdx = i * 3
-                let vert = SIMD3<Float>(
+        // Get tile header
+        guard let headerPtr = dtMeshTileGetHeader(tilePtr) else {
+            // Skip empty tiles - this is normal behavior
+            return
+        }
+
+        // Get vertices and polygons
+        guard let vertsPtr = dtMeshTileGetVerts(tilePtr),
+              let polysPtr = dtMeshTileGetPolys(tilePtr)
+        else {
+            trace("· tile", tileIdx, "missing verts/polys – skipped")
+            return
+        }
+
+        let polyCount = Int(dtMeshHeaderGetPolyCount(headerPtr))
+        let vertCount = Int(dtMeshHeaderGetVertCount(headerPtr))
+
+        // Get tile coordinates
+        var tileX: Int32 = 0
+        var tileY: Int32 = 0
+        var tileLayer: Int32 = 0
+        dtNavMeshGetTileStateAt(navMesh, Int32(tileIdx), &tileX, &tileY, &tileLayer)
+
+        // Calculate tile bounds
+        var tileBounds = (min: SIMD3<Float>(Float.greatestFiniteMagnitude,
+                                            Float.greatestFiniteMagnitude,
+                                            Float.greatestFiniteMagnitude),
+                          max: SIMD3<Float>(-Float.greatestFiniteMagnitude,
+                                            -Float.greatestFiniteMagnitude,
+                                            -Float.greatestFiniteMagnitude))
+
+        // Update bounds based on all vertices in this tile
+        for i in 0 ..< vertCount {
+            let vertIdx = i * 3
+            let vert = SIMD3<Float>(
+                vertsPtr[vertIdx + 0],
+                vertsPtr[vertIdx + 1],
+                vertsPtr[vertIdx + 2]
+            )
+            tileBounds.min = min(tileBounds.min, vert)
+            tileBounds.max = max(tileBounds.max, vert)
+        }
+
+        // Store tile info
+        tileInfos.append(.init(
+            index: tileIdx,
+            x: tileX,
+            y: tileY,
+            bounds: tileBounds,
+            polyCount: polyCount,
+            vertCount: vertCount
+        ))
+
+        // Walk every polygon inside the tile
+        let refBase = dtNavMeshGetPolyRefBase(navMesh, tilePtr)
+        for polyIdx in 0 ..< polyCount {
+            let polyPtr = polysPtr.advanced(by: polyIdx)
+            let vCount = Int(dtPolyGetVertCount(polyPtr))
+
+            // -------- vertices --------
+            var verts: [SIMD3<Float>] = []
+            verts.reserveCapacity(vCount)
+            for i in 0 ..< vCount {
+                let vertIdx = Int(dtPolyGetVert(polyPtr, Int32(i))) * 3
+                verts.append(SIMD3<Float>(
                     vertsPtr[vertIdx + 0],
                     vertsPtr[vertIdx + 1],
                     vertsPtr[vertIdx + 2]
-                )
-                tileBounds.min = min(tileBounds.min, vert)
-                tileBounds.max = max(tileBounds.max, vert)
+                ))
             }
 
-            // Store tile info
-            tileInfos.append(.init(
-                index: tileIdx,
-                x: tileX,
-                y: tileY,
-                bounds: tileBounds,
-                polyCount: polyCount,
-                vertCount: vertCount
-            ))
-
-            // Walk every polygon inside the tile
-            for polyIdx in 0 ..< polyCount {
-                let polyPtr = polysPtr.advanced(by: polyIdx)
-                let vCount = Int(dtPolyGetVertCount(polyPtr))
-
-                // -------- vertices --------
-                var verts: [SIMD3<Float>] = []
-                verts.reserveCapacity(vCount)
-                for i in 0 ..< vCount {
-                    let vertIdx = Int(dtPolyGetVert(polyPtr, Int32(i))) * 3
-                    verts.append(SIMD3<Float>(
-                        vertsPtr[vertIdx + 0],
-                        vertsPtr[vertIdx + 1],
-                        vertsPtr[vertIdx + 2]
-                    ))
+            // -------- neighbours ------
+            var neis: [dtPolyRef] = []
+            neis.reserveCapacity(vCount)
+            for i in 0 ..< vCount {
+                let n = dtPolyGetNeighbor(polyPtr, Int32(i))
+                if n != 0 {
+                    neis.append(dtPolyRef(n))
                 }
-
-                // -------- neighbours ------
-                var neis: [dtPolyRef] = []
-                neis.reserveCapacity(vCount)
-                for i in 0 ..< vCount {
-                    let n = dtPolyGetNeighbor(polyPtr, Int32(i))
-                    if n != 0 {
-                        neis.append(dtPolyRef(n))
-                    }
-                }
-
-                // -------- global ref ------
-                let refBase = dtNavMeshGetPolyRefBase(navMesh, tilePtr)
-                let ref = dtPolyRef(refBase) | dtPolyRef(polyIdx)
-
-                polys.append(.init(
-                    ref: ref,
-                    vertices: verts,
-                    neighbours: neis,
-                    area: dtPolyGetArea(polyPtr),
-                    flags: dtPolyGetFlags(polyPtr),
-                    type: dtPolyGetType(polyPtr),
-                    tileX: tileX,
-                    tileY: tileY,
-                    tileIndex: tileIdx
-                ))
             }
-        }
 
-        trace("Extraction finished – total polys:", polys.count, "tiles:", tileInfos.count)
-        return NavMeshGeometry(polygons: polys, tiles: tileInfos)
+            // -------- global ref ------
+            let ref = dtPolyRef(refBase) | dtPolyRef(polyIdx)
+
+            polys.append(.init(
+                ref: ref,
+                vertices: verts,
+                neighbours: neis,
+                area: dtPolyGetArea(polyPtr),
+                flags: dtPolyGetFlags(polyPtr),
+                type: dtPolyGetType(polyPtr),
+                tileX: tileX,
+                tileY: tileY,
+                tileIndex: tileIdx
+            ))
+        }
     }
 }
 
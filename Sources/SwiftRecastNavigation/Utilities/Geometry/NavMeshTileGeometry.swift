@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: MIT
+//
+//  NavMeshTileGeometry.swift
+//  SwiftRecastNavigation
+//
+//  Flat per-tile navmesh triangles for debug overlays, refreshed incrementally
+//
+
+import CRecast
+import Foundation
+
+/// The triangles of every tile of a ``NavMesh`` in flat buffers, re-extracted
+/// only for the tiles that changed.
+///
+/// ``NavMesh/extractGeometry(verbose:)`` builds a ``NavMeshGeometry/Polygon``
+/// with its own arrays for every polygon on every call, which makes refreshing
+/// an overlay after each tile change slow on large navmeshes. The cache keeps
+/// one vertex buffer and one index buffer per tile slot, filled in C++, and
+/// ``update(threadCount:)`` re-extracts only the slots whose tile was added,
+/// removed or replaced since the last update.
+///
+/// ```swift
+/// let geometry = NavMeshTileGeometry(navMesh: navMesh)
+/// // After every change to the tiles:
+/// for index in geometry.update() {
+///     redraw(geometry.tile(at: index))
+/// }
+/// ```
+///
+/// Polygons are fanned into triangles from their own vertices, as
+/// ``NavMeshBuilder/getTileMeshResource(tileX:tileY:)`` does; off-mesh
+/// connections are left out.
+public final class NavMeshTileGeometry: @unchecked Sendable {
+    /// The triangles of one tile
+    public struct Tile {
+        /// Slot of the tile in the navmesh
+        public let index: Int
+        /// Reference of the tile the triangles were extracted from
+        public let tileRef: dtTileRef
+        public let x: Int32
+        public let y: Int32
+        public let layer: Int32
+        /// Vertex positions, world-space
+        public let positions: [SIMD3<Float>]
+        /// Unit vertex normals, the sum of the normals of the triangles around each vertex
+        public let normals: [SIMD3<Float>]
+        /// Three vertex indices per triangle
+        public let indices: [UInt32]
+        /// Area of the polygon of each triangle
+        public let areas: [UInt8]
+        /// Flags of the polygon of each triangle
+        public let flags: [UInt16]
+        /// Polygon of each triangle
+        public let polys: [dtPolyRef]
+    }
+
+    /// The navmesh the triangles come from
+    public let navMesh: NavMesh
+
+    private let cache: OpaquePointer
+    private let cacheLock = TileAccessLock()
+
+    /// Creates an empty cache for `navMesh`; the first ``update(threadCount:)`` extracts every tile.
+    public init(navMesh: NavMesh) {
+        self.navMesh = navMesh
+        self.cache = bindingCreateGeometryCache(navMesh.navMesh)!
+    }
+
+    deinit {
+        bindingReleaseGeometryCache(cache)
+    }
+
+    /// Re-extracts the tiles added, removed or replaced since the last update
+    /// - Parameter threadCount: Threads extracting tiles, 0 for one per core
+    /// - Returns: Slots whose triangles changed, including slots that are now empty
+    @discardableResult
+    public func update(threadCount: Int = 0) -> [Int] {
+        var changed = [Int32](repeating: 0, count: Int(dtNavMeshGetMaxTiles(navMesh.navMesh)))
+        let count = navMesh.withSharedTileAccess {
+            cacheLock.withWriteLock {
+                bindingGeometryCacheUpdate(cache, &changed, Int32(changed.count), Int32(threadCount))
+            }
+        }
+        return changed[0..<Int(count)].map { Int($0) }
+    }
+
+    /// Slots that held a tile at the last update
+    public var tileIndices: [Int] {
+        cacheLock.withReadLock {
+            var geom = BindingTileGeometry()
+            return (0..<Int(dtNavMeshGetMaxTiles(navMesh.navMesh))).filter { index in
+                bindingGeometryCacheGetTile(cache, Int32(index), &geom) != 0 && geom.tileRef != 0
+            }
+        }
+    }
+
+    /// Vertices and triangles over every tile at the last update
+    public var totals: (vertices: Int, triangles: Int) {
+        var nverts: Int32 = 0
+        var ntris: Int32 = 0
+        cacheLock.withReadLock {
+            bindingGeometryCacheGetTotals(cache, &nverts, &ntris)
+        }
+        return (Int(nverts), Int(ntris))
+    }
+
+    /// The triangles of slot `index` as of the last update, or nil if it held no tile
+    public func tile(at index: Int) -> Tile? {
+        withTileGeometry(at: index) { geom in
+            let nverts = Int(geom.nverts)
+            let ntris = Int(geom.ntris)
+            // Positions and normals are 4 floats per vertex, the layout of SIMD3<Float>
+            return Tile(index: index, tileRef: geom.tileRef, x: geom.x, y: geom.y, layer: geom.layer,
+                        positions: Self.vectors(geom.positions, nverts),
+                        normals: Self.vectors(geom.normals, nverts),
+                        indices: Array(UnsafeBufferPointer(start: geom.indices, count: ntris * 3)),
+                        areas: Array(UnsafeBufferPointer(start: geom.areas, count: ntris)),
+                        flags: Array(UnsafeBufferPointer(start: geom.flags, count: ntris)),
+                        polys: Array(UnsafeBufferPointer(start: geom.polys, count: ntris)))
+        }
+    }
+
+    /// Runs `body` with the buffers of slot `index` without copying them, or returns nil if it held no tile.
+    ///
+    /// The pointers in the geometry are valid only inside `body`.
+    public func withTileGeometry<R>(at index: Int, _ body: (BindingTileGeometry) throws -> R) rethrows -> R? {
+        try cacheLock.withReadLock {
+            var geom = BindingTileGeometry()
+            guard bindingGeometryCacheGetTile(cache, Int32(index), &geom) != 0, geom.tileRef != 0 else {
+                return nil
+            }
+            return try body(geom)
+        }
+    }
+
+    private static func vectors(_ floats: UnsafePointer<Float>?, _ count: Int) -> [SIMD3<Float>] {
+        guard let floats, count > 0 else { return [] }
+        return UnsafeRawPointer(floats).withMemoryRebound(to: SIMD3<Float>.self, capacity: count) {
+            Array(UnsafeBufferPointer(start: $0, count: count))
+        }
+    }
+}
+
+#if canImport(RealityKit)
+import RealityKit
+
+extension NavMeshTileGeometry {
+    /// A mesh of the triangles of slot `index`, or nil if it held no tile at the last update
+    public func meshResource(forTile index: Int) throws -> MeshResource? {
+        guard let descriptor = meshDescriptor(forTile: index) else { return nil }
+        return try MeshResource.generate(from: [descriptor])
+    }
+
+    /// Updates the cache and brings `meshes`, one mesh per slot, up to date with it.
+    ///
+    /// Only the meshes of changed slots are generated again; meshes of slots
+    /// that are now empty are removed.
+    /// - Parameters:
+    ///   - meshes: Meshes by slot, as left by the previous call
+    ///   - threadCount: Threads extracting tiles, 0 for one per core
+    /// - Returns: Slots whose mesh was replaced or removed
+    @discardableResult
+    public func updateMeshResources(_ meshes: inout [Int: MeshResource], threadCount: Int = 0) throws -> [Int] {
+        let changed = update(threadCount: threadCount)
+        for index in changed {
+            if let descriptor = meshDescriptor(forTile: index) {
+                meshes[index] = try MeshResource.generate(from: [descriptor])
+            } else {
+                meshes[index] = nil
+            }
+        }
+        return changed
+    }
+
+    private func meshDescriptor(forTile index: Int) -> MeshDescriptor? {
+        guard let tile = tile(at: index), !tile.indices.isEmpty else { return nil }
+        var descriptor = MeshDescriptor(name: "tile-\(tile.x)-\(tile.y)-\(tile.layer)")
+        descriptor.positions = MeshBuffer(tile.positions)
+        descriptor.normals = MeshBuffer(tile.normals)
+        descriptor.primitives = .triangles(tile.indices)
+        return descriptor
+    }
+}
+#endif
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: MIT
+//
+//  SplatMeshCache.swift
+//  SwiftRecastNavigation
+//
+//  Splat meshes kept by image digest, channel and generator settings
+//
+
+import CoreGraphics
+import CryptoKit
+import Foundation
+#if canImport(Darwin)
+import Darwin
+#elseif canImport(Glibc)
+import Glibc
+#endif
+
+/// Meshes extracted from splat images, kept so that rebuilding with an
+/// unchanged splat skips its extraction.
+///
+/// Pass a cache to ``SplatMeshGenerator/meshes(from:config:cache:)``. Entries
+/// are keyed by a digest of the image pixels, the channel and every generator
+/// setting that changes the mesh, so editing the splat or the settings misses
+/// the cache instead of returning a stale mesh.
+///
+/// The cache can be shared between generators and tasks.
+public final class SplatMeshCache: @unchecked Sendable {
+    struct Key: Hashable {
+        let imageDigest: String
+        let channel: SplatMeshGenerator.Channel
+        let maxEdgeLength: CGFloat
+        let simplificationTolerance: CGFloat
+        let threshold: Float?
+        let invertMask: Bool?
+        let morphologyRadius: Int
+    }
+
+    /// Most meshes kept
+    public let capacity: Int
+
+    private let mutex = UnsafeMutablePointer<pthread_mutex_t>.allocate(capacity: 1)
+    private var meshes: [Key: MeshResult2D] = [:]
+    /// Keys in insertion order, oldest first
+    private var order: [Key] = []
+    private var counters = (hits: 0, misses: 0)
+
+    /// - Parameter capacity: Most meshes kept; the oldest one makes way for a new one beyond that
+    public init(capacity: Int = 64) {
+        self.capacity = max(capacity, 1)
+        pthread_mutex_init(mutex, nil)
+    }
+
+    deinit {
+        pthread_mutex_destroy(mutex)
+        mutex.deallocate()
+    }
+
+    /// Lookups answered from the cache
+    public var hits: Int { locked { counters.hits } }
+    /// Lookups that had to extract the mesh
+    public var misses: Int { locked { counters.misses } }
+    /// Meshes held
+    public var count: Int { locked { meshes.count } }
+
+    /// Drops every mesh
+    public func removeAll() {
+        locked {
+            meshes.removeAll()
+            order.removeAll()
+        }
+    }
+
+    func mesh(for key: Key) -> MeshResult2D? {
+        locked {
+            let mesh = meshes[key]
+            if mesh != nil {
+                counters.hits += 1
+            } else {
+                counters.misses += 1
+            }
+            return mesh
+        }
+    }
+
+    func insert(_ mesh: MeshResult2D, for key: Key) {
+        locked {
+            if meshes.updateValue(mesh, forKey: key) == nil {
+                order.append(key)
+            }
+            while order.count > capacity {
+                meshes[order.removeFirst()] = nil
+            }
+        }
+    }
+
+    /// SHA-256 of the pixels and layout of `image`, nil if its pixels cannot be read
+    static func digest(of image: CGImage) -> String? {
+        guard let data = image.dataProvider?.data as Data? else {
+            return nil
+        }
+        var hasher = SHA256()
+        let layout = [image.width, image.height, image.bitsPerPixel, image.bytesPerRow,
+                      Int(image.bitmapInfo.rawValue)]
+        layout.withUnsafeBytes { hasher.update(bufferPointer: $0) }
+        hasher.update(data: data)
+        return hasher.finalize().map { String(format: "%02x", $0) }.joined()
+    }
+
+    private func locked<R>(_ body: () -> R) -> R {
+        pthread_mutex_lock(mutex)
+        defer { pthread_mutex_unlock(mutex) }
+        return body()
+    }
+}
@@ -38,7 +38,7 @@ public struct SplatMeshGenerator {
     /// Optional manual threshold in [0 … 1]; `nil` → Otsu.
     public let threshold: Float?
     /// Which channel to use for mesh generation.
-    public let channel: Channel
+    public private(set) var channel: Channel
     /// `nil` → auto; `false` → detect *bright* shapes; `true` → detect *dark* shapes.
     public let invertMask: Bool?
     /// Radius (pixels) for the dilate → erode "closing" operation; 0 = skip.
@@ -78,60 +78,73 @@ public struct SplatMeshGenerator {
     /// The routine:
     /// 1. Builds a binary mask from `ciImage`
     /// 2. Extracts the top-level contours (outer rings + one-level holes)
-    /// 3. Runs constrained-Delaunay triangulation with iTriangle
+    /// 3. Runs constrained-Delaunay triangulation with iTriangle, one contour per core
     /// 4. Returns GPU-ready vertex & index buffers
+    ///
+    /// The mask stays a Core Image recipe until Vision renders it for contour
+    /// detection, so thresholding and morphology run on the GPU.
     public func mesh(from ciImage: CIImage,
                      imageSize: CGSize,
                      debugURL: URL? = nil) async throws -> MeshResult2D
     {
-        // 1. Vision –> binary mask
+        // 1. Core Image –> binary mask, still unrendered
         let mask = try await createBinaryMask(from: ciImage, debugURL: debugURL)
 
         // 2. Vision –> contour tree (top-level only)
         let rootContours = try await detectContours(in: mask)
 
+        // 3. Walk every outer ring and its direct holes, one contour per core
+        let tolerance = simplificationTolerance * min(imageSize.width, imageSize.height)
+        var meshes = [(vertices: [CGPoint], indices: [UInt32])?](repeating: nil, count: rootContours.count)
+        meshes.withUnsafeMutableBufferPointer { buffer in
+            let out = buffer
+            DispatchQueue.concurrentPerform(iterations: rootContours.count) { contourIndex in
+                let outerContour = rootContours[contourIndex]
+
+                // a. Flatten → simplify → resample outer ring
+                let outerRing = resample(
+                    points: flattenSingleContour(outerContour, imageSize: imageSize)
+                        .simplified(tolerance: tolerance))
+
+                guard outerRing.count >= 3 else { return }
+
+                // b. Same pipeline for direct-child holes
+                let holeRings: [[CGPoint]] = outerContour.childContours.compactMap { hole in
+                    let simplified = flattenSingleContour(hole, imageSize: imageSize)
+                        .simplified(tolerance: tolerance)
+                    return simplified.count >= 3 ? resample(points: simplified) : nil
+                }
+
+                // c. Robust constrained-Delaunay triangulation (iTriangle)
+                out[contourIndex] = triangulateITriangle(
+                    outerRing: outerRing,
+                    holeRings: holeRings)
+            }
+        }
+
         var vertices: [SIMD2<Float>] = []
         var indices: [UInt32] = []
 
-        // 3. Walk every outer ring and its direct holes
+        // d. Stitch the local meshes into global buffers, in contour order
         for (contourIndex, outerContour) in rootContours.enumerated() {
             if debugPrint {
                 print("\n[DEBUG] ⇢ Contour \(contourIndex) – outer \(outerContour.pointCount) pts, \(outerContour.childContours.count) holes")
             }
 
-            // a. Flatten → simplify → resample outer ring
-            let outerRing = resample(
-                points: flattenSingleContour(outerContour, imageSize: imageSize)
-                    .simplified(tolerance: simplificationTolerance
-                        * min(imageSize.width, imageSize.height)))
-
-            guard outerRing.count >= 3 else { continue }
-
-            // b. Same pipeline for direct-child holes
-            let holeRings: [[CGPoint]] = outerContour.childContours.compactMap { hole in
-                let simplified = flattenSingleContour(hole, imageSize: imageSize)
-                    .simplified(tolerance: simplificationTolerance
-                        * min(imageSize.width, imageSize.height))
-                return simplified.count >= 3 ? resample(points: simplified) : nil
-            }
-
-            // c. Robust constrained-Delaunay triangulation (iTriangle)
-            let (localVertices, localIndices) = triangulateITriangle(
-                outerRing: outerRing,
-                holeRings: holeRings)
+            // Outer rings under 3 points were skipped without triangulating
+            guard let local = meshes[contourIndex] else { continue }
 
-            guard !localIndices.isEmpty else {
+            guard !local.indices.isEmpty else {
                 if debugPrint { print("[DEBUG]    ⤺  iTriangle produced 0 triangles – skipping") }
                 continue
             }
 
-            // d. Stitch local mesh into global buffers
             let indexOffset = UInt32(vertices.count)
-            vertices += localVertices.map { SIMD2(Float($0.x), Float($0.y)) }
-            indices += localIndices.map { $0 + indexOffset }
+            vertices += local.vertices.map { SIMD2(Float($0.x), Float($0.y)) }
+            indices += local.indices.map { $0 + indexOffset }
 
             if debugPrint {
-                print("[DEBUG]    ➜  kept \(localVertices.count) vertices, \(localIndices.count / 3) triangles")
+                print("[DEBUG]    ➜  kept \(local.vertices.count) vertices, \(local.indices.count / 3) triangles")
             }
         }
 
@@ -153,6 +166,82 @@ public struct SplatMeshGenerator {
         return try await mesh(from: ciImage, imageSize: size, debugURL: debugURL)
     }
 
+    // MARK: – Multi-channel pipeline --------------------------------------------
+
+    /// Generate one mesh per channel of `config`, all channels at once.
+    ///
+    /// Each channel runs the ``mesh(from:imageSize:debugURL:)`` pipeline with
+    /// this generator's settings and the channel of its ``SplatAreaConfig/ChannelConfig``.
+    /// - Returns: The meshes, in the order of `config.channelConfigs`
+    public func meshes(from ciImage: CIImage,
+                       imageSize: CGSize,
+                       config: SplatAreaConfig) async throws -> [MeshResult2D]
+    {
+        try await withThrowingTaskGroup(of: (Int, MeshResult2D).self) { group in
+            for (i, channelConfig) in config.channelConfigs.enumerated() {
+                let generator = with(channel: channelConfig.channel)
+                group.addTask {
+                    (i, try await generator.mesh(from: ciImage, imageSize: imageSize))
+                }
+            }
+            var results = [MeshResult2D?](repeating: nil, count: config.channelConfigs.count)
+            for try await (i, mesh) in group {
+                results[i] = mesh
+            }
+            return results.map { $0! }
+        }
+    }
+
+    /// Generate one mesh per channel of `config` from a CGImage, reusing the
+    /// meshes in `cache` for channels of an image it has seen with the same settings.
+    ///
+    /// The image is identified by a SHA-256 digest of its pixels, so an
+    /// unchanged splat costs one pass over its bytes on rebuild.
+    /// - Returns: The meshes, in the order of `config.channelConfigs`
+    public func meshes(from cgImage: CGImage,
+                       config: SplatAreaConfig,
+                       cache: SplatMeshCache? = nil) async throws -> [MeshResult2D]
+    {
+        let ciImage = CIImage(cgImage: cgImage)
+        let size = CGSize(width: cgImage.width, height: cgImage.height)
+        guard let cache, let digest = SplatMeshCache.digest(of: cgImage) else {
+            return try await meshes(from: ciImage, imageSize: size, config: config)
+        }
+
+        let keys = config.channelConfigs.map { cacheKey(digest: digest, channel: $0.channel) }
+        var results = keys.map { cache.mesh(for: $0) }
+        let missing = results.indices.filter { results[$0] == nil }
+        if missing.isEmpty {
+            return results.map { $0! }
+        }
+
+        let pending = SplatAreaConfig(splatName: config.splatName,
+                                      channelConfigs: missing.map { config.channelConfigs[$0] })
+        let built = try await meshes(from: ciImage, imageSize: size, config: pending)
+        for (i, mesh) in zip(missing, built) {
+            cache.insert(mesh, for: keys[i])
+            results[i] = mesh
+        }
+        return results.map { $0! }
+    }
+
+    /// A copy of this generator for another channel, sharing its Core Image context
+    private func with(channel: Channel) -> SplatMeshGenerator {
+        var generator = self
+        generator.channel = channel
+        return generator
+    }
+
+    private func cacheKey(digest: String, channel: Channel) -> SplatMeshCache.Key {
+        SplatMeshCache.Key(imageDigest: digest,
+                           channel: channel,
+                           maxEdgeLength: maxEdgeLength,
+                           simplificationTolerance: simplificationTolerance,
+                           threshold: threshold,
+                           invertMask: invertMask,
+                           morphologyRadius: morphologyRadius)
+    }
+
     // MARK: – Step 1: Channel isolation → threshold → morphology -----------------
 
     private func createBinaryMask(from ci: CIImage,
@@ -379,11 +468,9 @@ public struct SplatMeshGenerator {
             print("[DEBUG] Creating VNImageRequestHandler...")
         }
 
-        guard let cgImage = ciContext.createCGImage(mask, from: mask.extent) else {
-            throw MeshError.invalidImage
-        }
-
-        let handler = VNImageRequestHandler(cgImage: cgImage, options: [:])
+        // Vision renders the mask itself, with our context, straight at its
+        // working size; no full-size copy is read back first.
+        let handler = VNImageRequestHandler(ciImage: mask, options: [.ciContext: ciContext])
         let request = VNDetectContoursRequest()
         request.maximumImageDimension = 1024 // keep or tweak
         request.detectsDarkOnLight = false // black-on-white mask
@@ -467,13 +554,15 @@ public struct SplatMeshGenerator {
                 "inputScale": 1
             ])
 
-        var rawBins = [UInt32](repeating: 0, count: binCount)
+        // Only the 256 bins come back from the GPU. Read them as floats: the
+        // bins hold fractions of the pixels, which 8 bits would flatten.
+        var rawBins = [Float](repeating: 0, count: binCount * 4)
         ciContext.render(
             histogramImage,
             toBitmap: &rawBins,
-            rowBytes: MemoryLayout<UInt32>.size * binCount,
+            rowBytes: MemoryLayout<Float>.size * 4 * binCount,
             bounds: CGRect(x: 0, y: 0, width: binCount, height: 1),
-            format: .RGBA8,
+            format: .RGBAf,
             colorSpace: nil)
 
         // The histogram might be in any channel, not just red
@@ -481,13 +570,13 @@ public struct SplatMeshGenerator {
         var counts: [Float] = []
 
         // Check each channel
-        for shift in [0, 8, 16, 24] {
-            let channelCounts = rawBins.map { Float(($0 >> shift) & 0xFF) }
+        for component in 0 ..< 4 {
+            let channelCounts = (0 ..< binCount).map { rawBins[$0 * 4 + component] }
             let total = channelCounts.reduce(0, +)
             if total > 0 {
                 counts = channelCounts
                 if debugPrint {
-                    print("[DEBUG] Found histogram data in channel shift \(shift), total: \(total)")
+                    print("[DEBUG] Found histogram data in channel \(component), total: \(total)")
                 }
                 break
             }
@@ -9,9 +9,33 @@
 import Foundation
 import simd
 
+#if canImport(Darwin)
+import Darwin
+#elseif canImport(Glibc)
+import Glibc
+#endif
+
 extension NavMeshGeometry {
     /// Export the navigation mesh geometry to a USDA file with colored polygons by area code
     public func exportToUSDA(filePath: String) throws {
+        var usdContent = usdaPreamble(areaCodes: Set(polygons.map { $0.area }).sorted())
+        
+        // Create geometry scope
+        usdContent += "    def Scope \"Geometry\"\n    {\n"
+        
+        // Export each polygon as a separate mesh
+        for (index, polygon) in polygons.enumerated() {
+            usdContent += exportPolygonToUSD(polygon, index: index)
+        }
+        
+        usdContent += "    }\n}\n"
+        
+        // Write to file
+        try usdContent.write(toFile: filePath, atomically: true, encoding: .utf8)
+    }
+    
+    /// The document header and the material of every area code, up to the geometry
+    fileprivate func usdaPreamble(areaCodes: [UInt8]) -> String {
         var usdContent = ""
         
         // USDA header
@@ -29,13 +53,10 @@ extension NavMeshGeometry {
         {
         """
         
-        // Collect unique area codes
-        let uniqueAreaCodes = Set(polygons.map { $0.area }).sorted()
-        
         // Create materials for each area code
         usdContent += "\n    def Scope \"Materials\"\n    {\n"
         
-        for areaCode in uniqueAreaCodes {
+        for areaCode in areaCodes {
             let color = colorForAreaCode(areaCode)
             usdContent += """
             
@@ -57,19 +78,7 @@ extension NavMeshGeometry {
         }
         
         usdContent += "    }\n\n"
-        
-        // Create geometry scope
-        usdContent += "    def Scope \"Geometry\"\n    {\n"
-        
-        // Export each polygon as a separate mesh
-        for (index, polygon) in polygons.enumerated() {
-            usdContent += exportPolygonToUSD(polygon, index: index)
-        }
-        
-        usdContent += "    }\n}\n"
-        
-        // Write to file
-        try usdContent.write(toFile: filePath, atomically: true, encoding: .utf8)
+        return usdContent
     }
     
     private func exportPolygonToUSD(_ polygon: Polygon, index: Int) -> String {
@@ -135,7 +144,7 @@ extension NavMeshGeometry {
         return normal
     }
     
-    private func formatExtent(_ vertices: [SIMD3<Float>]) -> String {
+    fileprivate func formatExtent(_ vertices: [SIMD3<Float>]) -> String {
         var minBound = vertices[0]
         var maxBound = vertices[0]
         
@@ -147,7 +156,7 @@ extension NavMeshGeometry {
         return "(\(minBound.x), \(minBound.y), \(minBound.z)), (\(maxBound.x), \(maxBound.y), \(maxBound.z))"
     }
     
-    private func colorForAreaCode(_ areaCode: UInt8) -> (r: Float, g: Float, b: Float) {
+    fileprivate func colorForAreaCode(_ areaCode: UInt8) -> (r: Float, g: Float, b: Float) {
         // Generate distinct colors for different area codes
         switch areaCode {
         case 63:  // RC_WALKABLE_AREA
@@ -204,88 +213,30 @@ extension NavMeshGeometry {
 
 // Extension to export with tile-based organization
 extension NavMeshGeometry {
-    /// Export navigation mesh organized by tiles
+    /// Export navigation mesh organized by tiles, with one mesh prim per polygon
+    ///
+    /// The file is written as it is produced; see ``writeUSDA(to:mergeTilePolygons:threadCount:)``.
     public func exportToUSDATiled(filePath: String) throws {
-        var usdContent = ""
-        
-        // USDA header
-        usdContent += """
-        #usda 1.0
-        (
-            defaultPrim = "NavMesh"
-            metersPerUnit = 1
-            upAxis = "Y"
-        )
-        
-        def Xform "NavMesh" (
-            kind = "assembly"
-        )
-        {
+        try writeUSDA(to: URL(fileURLWithPath: filePath), mergeTilePolygons: false)
+    }
+    
+    /// Opens the `Xform` of a tile with `polyCount` polygons
+    fileprivate func tileXformHeader(_ tile: TileInfo, polyCount: Int) -> String {
         """
         
-        // Collect unique area codes
-        let uniqueAreaCodes = Set(polygons.map { $0.area }).sorted()
-        
-        // Create materials
-        usdContent += "\n    def Scope \"Materials\"\n    {\n"
-        for areaCode in uniqueAreaCodes {
-            let color = colorForAreaCode(areaCode)
-            usdContent += """
-            
-                def Material "AreaMaterial_\(areaCode)"
-                {
-                    token outputs:surface.connect = </NavMesh/Materials/AreaMaterial_\(areaCode)/PbrShader.outputs:surface>
-                    
-                    def Shader "PbrShader"
-                    {
-                        uniform token info:id = "UsdPreviewSurface"
-                        color3f inputs:diffuseColor = (\(color.r), \(color.g), \(color.b))
-                        float inputs:metallic = 0
-                        float inputs:roughness = 0.5
-                        token outputs:surface
+                def Xform "Tile_\(tile.x)_\(tile.y)" (
+                    customData = {
+                        int tileX = \(tile.x)
+                        int tileY = \(tile.y)
+                        int polyCount = \(polyCount)
                     }
-                }
-            
-            """
-        }
-        usdContent += "    }\n\n"
-        
-        // Organize by tiles
-        usdContent += "    def Scope \"Tiles\"\n    {\n"
-        
-        for tile in tiles {
-            let tilePolygons = polygons(forTileIndex: tile.index)
-            if !tilePolygons.isEmpty {
-                usdContent += """
-                
-                        def Xform "Tile_\(tile.x)_\(tile.y)" (
-                            customData = {
-                                int tileX = \(tile.x)
-                                int tileY = \(tile.y)
-                                int polyCount = \(tilePolygons.count)
-                            }
-                        )
-                        {
-                
-                """
-                
-                for (polyIndex, polygon) in tilePolygons.enumerated() {
-                    usdContent += exportPolygonToUSDIndented(polygon,
-                                                            index: polyIndex,
-                                                            globalIndex: polygons.firstIndex(where: { $0.ref == polygon.ref })!,
-                                                            indent: "            ")
-                }
-                
-                usdContent += "        }\n"
-            }
-        }
-        
-        usdContent += "    }\n}\n"
+                )
+                {
         
-        try usdContent.write(toFile: filePath, atomically: true, encoding: .utf8)
+        """
     }
     
-    private func exportPolygonToUSDIndented(_ polygon: Polygon, index: Int, globalIndex: Int, indent: String) -> String {
+    fileprivate func exportPolygonToUSDIndented(_ polygon: Polygon, index: Int, globalIndex: Int, indent: String) -> String {
         let meshName = "Polygon_\(globalIndex)"
         var usd = """
         
@@ -325,6 +276,194 @@ extension NavMeshGeometry {
     }
 }
 
+// Streaming export
+extension NavMeshGeometry {
+    /// Writes the navigation mesh to a USDA file organised by tiles, as the
+    /// document is produced.
+    ///
+    /// Tiles are rendered to text in parallel, a few per thread at a time, and
+    /// written out in order through a buffered file handle, so memory stays at a
+    /// window of tiles whatever the size of the map. The file is written next to
+    /// `url` and moved into place once complete.
+    ///
+    /// - Parameters:
+    ///   - url: File URL of the `.usda` document
+    ///   - mergeTilePolygons: Give each tile a single mesh prim with one face per
+    ///     polygon, carrying the area code, display color and polygon ref as
+    ///     per-face primvars and bound to the area materials through `GeomSubset`s.
+    ///     With false every polygon gets a prim of its own, as in ``exportToUSDATiled(filePath:)``.
+    ///   - threadCount: Threads rendering tiles; 0 uses one per core
+    public func writeUSDA(to url: URL, mergeTilePolygons: Bool = true, threadCount: Int = 0) throws {
+        // Group polygons by tile once, keeping their index in `polygons` for prim names
+        var tilePolygons = [Int: [Int]]()
+        for (index, polygon) in polygons.enumerated() {
+            tilePolygons[polygon.tileIndex, default: []].append(index)
+        }
+        let populated = tiles.filter { tilePolygons[$0.index] != nil }
+        
+        let tmpURL = url.deletingLastPathComponent()
+            .appendingPathComponent(".\(url.lastPathComponent).\(ProcessInfo.processInfo.processIdentifier).tmp")
+        guard FileManager.default.createFile(atPath: tmpURL.path, contents: nil),
+              let handle = FileHandle(forWritingAtPath: tmpURL.path)
+        else {
+            throw CocoaError(.fileWriteUnknown, userInfo: [NSFilePathErrorKey: tmpURL.path])
+        }
+        let writer = USDAFileWriter(handle)
+        do {
+            try writer.write(usdaPreamble(areaCodes: Set(polygons.map { $0.area }).sorted()))
+            try writer.write("    def Scope \"Tiles\"\n    {\n")
+            
+            let threads = max(1, threadCount > 0 ? threadCount : ProcessInfo.processInfo.activeProcessorCount)
+            let window = threads == 1 ? 1 : threads * 4
+            var start = 0
+            while start < populated.count {
+                let end = min(start + window, populated.count)
+                var chunks = [String](repeating: "", count: end - start)
+                let render = { (i: Int) -> String in
+                    let tile = populated[start + i]
+                    let indices = tilePolygons[tile.index]!
+                    return mergeTilePolygons ? self.mergedTileUSD(tile, indices) : self.tileUSD(tile, indices)
+                }
+                if threads == 1 {
+                    chunks[0] = render(0)
+                } else {
+                    chunks.withUnsafeMutableBufferPointer { out in
+                        DispatchQueue.concurrentPerform(iterations: end - start) { i in
+                            out[i] = render(i)
+                        }
+                    }
+                }
+                for chunk in chunks {
+                    try writer.write(chunk)
+                }
+                start = end
+            }
+            
+            try writer.write("    }\n}\n")
+            try writer.flush()
+            try handle.close()
+            guard rename(tmpURL.path, url.path) == 0 else {
+                throw CocoaError(.fileWriteUnknown, userInfo: [NSFilePathErrorKey: url.path])
+            }
+        } catch {
+            try? handle.close()
+            try? FileManager.default.removeItem(at: tmpURL)
+            throw error
+        }
+    }
+    
+    /// A tile with a prim per polygon, as ``exportToUSDATiled(filePath:)`` lays it out
+    private func tileUSD(_ tile: TileInfo, _ indices: [Int]) -> String {
+        var usd = tileXformHeader(tile, polyCount: indices.count)
+        for (polyIndex, globalIndex) in indices.enumerated() {
+            usd += exportPolygonToUSDIndented(polygons[globalIndex],
+                                              index: polyIndex,
+                                              globalIndex: globalIndex,
+                                              indent: "            ")
+        }
+        usd += "        }\n"
+        return usd
+    }
+    
+    /// A tile whose polygons are the faces of one mesh prim. Polygons share the
+    /// points they have in common, and faces are bound to their area's material
+    /// through one `GeomSubset` per area code.
+    private func mergedTileUSD(_ tile: TileInfo, _ indices: [Int]) -> String {
+        var points: [SIMD3<Float>] = []
+        var pointIndex: [SIMD3<Float>: Int] = [:]
+        var faceVertexIndices: [Int] = []
+        var areaFaces: [UInt8: [Int]] = [:]
+        for (face, globalIndex) in indices.enumerated() {
+            let polygon = polygons[globalIndex]
+            for vertex in polygon.vertices {
+                if let existing = pointIndex[vertex] {
+                    faceVertexIndices.append(existing)
+                } else {
+                    pointIndex[vertex] = points.count
+                    faceVertexIndices.append(points.count)
+                    points.append(vertex)
+                }
+            }
+            areaFaces[polygon.area, default: []].append(face)
+        }
+        
+        let indent = "            "
+        var usd = tileXformHeader(tile, polyCount: indices.count)
+        usd.reserveCapacity(usd.utf8.count + points.count * 40 + faceVertexIndices.count * 8 + indices.count * 48)
+        usd += "\n\(indent)def Mesh \"Polygons\"\n\(indent){\n"
+        if !points.isEmpty {
+            usd += "\(indent)    float3[] extent = [\(formatExtent(points))]\n"
+        }
+        usd += "\(indent)    point3f[] points = ["
+        for (i, p) in points.enumerated() {
+            if i > 0 { usd += ", " }
+            usd += "(\(p.x), \(p.y), \(p.z))"
+        }
+        usd += "]\n"
+        usd += "\(indent)    int[] faceVertexCounts = ["
+        usd += indices.map { String(polygons[$0].vertices.count) }.joined(separator: ", ")
+        usd += "]\n"
+        usd += "\(indent)    int[] faceVertexIndices = ["
+        usd += faceVertexIndices.map { String($0) }.joined(separator: ", ")
+        usd += "]\n"
+        usd += "\(indent)    uniform token subdivisionScheme = \"none\"\n"
+        usd += "\(indent)    uniform token subsetFamily:materialBind:familyType = \"partition\"\n"
+        
+        // Per-face primvars
+        usd += "\(indent)    int[] primvars:areaCode = ["
+        usd += indices.map { String(polygons[$0].area) }.joined(separator: ", ")
+        usd += "] (\n\(indent)        interpolation = \"uniform\"\n\(indent)    )\n"
+        usd += "\(indent)    color3f[] primvars:displayColor = ["
+        usd += indices.map {
+            let c = colorForAreaCode(polygons[$0].area)
+            return "(\(c.r), \(c.g), \(c.b))"
+        }.joined(separator: ", ")
+        usd += "] (\n\(indent)        interpolation = \"uniform\"\n\(indent)    )\n"
+        usd += "\(indent)    uint[] primvars:polyRef = ["
+        usd += indices.map { String(polygons[$0].ref) }.joined(separator: ", ")
+        usd += "] (\n\(indent)        interpolation = \"uniform\"\n\(indent)    )\n"
+        
+        for area in areaFaces.keys.sorted() {
+            usd += "\n\(indent)    def GeomSubset \"Area_\(area)\"\n\(indent)    {\n"
+            usd += "\(indent)        uniform token elementType = \"face\"\n"
+            usd += "\(indent)        uniform token familyName = \"materialBind\"\n"
+            usd += "\(indent)        int[] indices = ["
+            usd += areaFaces[area]!.map { String($0) }.joined(separator: ", ")
+            usd += "]\n"
+            usd += "\(indent)        rel material:binding = </NavMesh/Materials/AreaMaterial_\(area)>\n"
+            usd += "\(indent)    }\n"
+        }
+        usd += "\(indent)}\n        }\n"
+        return usd
+    }
+}
+
+/// Appends text to a file through a buffer that is written out as it fills
+private final class USDAFileWriter {
+    private let handle: FileHandle
+    private var buffer: [UInt8] = []
+    private let capacity: Int
+    
+    init(_ handle: FileHandle, capacity: Int = 1 << 20) {
+        self.handle = handle
+        self.capacity = capacity
+        buffer.reserveCapacity(capacity)
+    }
+    
+    func write(_ text: String) throws {
+        buffer.append(contentsOf: text.utf8)
+        if buffer.count >= capacity {
+            try flush()
+        }
+    }
+    
+    func flush() throws {
+        guard !buffer.isEmpty else { return }
+        try handle.write(contentsOf: buffer)
+        buffer.removeAll(keepingCapacity: true)
+    }
+}
+
 // Usage example:
 /*
 let geometry = navMesh.extractGeometry(verbose: true)
@@ -334,4 +473,7 @@ try geometry.exportToUSDA(filePath: "/path/to/navmesh.usda")
 
 // Or export with tile organization
 try geometry.exportToUSDATiled(filePath: "/path/to/navmesh_tiled.usda")
+
+// Or stream one merged mesh per tile, for large maps
+try geometry.writeUSDA(to: URL(fileURLWithPath: "/path/to/navmesh_tiles.usda"))
 */
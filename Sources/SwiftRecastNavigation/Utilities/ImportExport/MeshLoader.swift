@@ -33,9 +33,13 @@ public final class MeshLoader {
     // MARK: - Path A: Load from OBJ File
     
     /// Loads mesh data from an OBJ file on disk
-    public convenience init(file: String) throws {
+    /// - Parameters:
+    ///   - file: Path of the OBJ file
+    ///   - useGeometryCache: Reload the parsed geometry from a `.geomcache` sidecar
+    ///     while the file is unchanged; see ``OBJParser/load(from:useGeometryCache:)``
+    public convenience init(file: String, useGeometryCache: Bool = false) throws {
         self.init()
-        let result = try OBJParser.load(from: file)
+        let result = try OBJParser.load(from: file, useGeometryCache: useGeometryCache)
         self.vertices = result.vertices
         self.triangles = result.triangles
         self.normals = result.normals
@@ -172,6 +176,7 @@ public final class MeshLoader {
         let heights = TerrainSampler.sampleOBJHeights(
             at: terrainSpaceXZ,
             terrainVertices: terrainResult.vertices,
+            terrainTriangles: terrainResult.triangles,
             scale: terrainScale
         )
         
@@ -7,67 +7,156 @@
 import CRecast
 import Foundation
 
+#if canImport(Darwin)
+import Darwin
+#elseif canImport(Glibc)
+import Glibc
+#endif
+
 // MARK: - NavMesh Export Extension
 public extension NavMesh {
     /// Exports and saves the navigation mesh to disk in binary format
-    /// - Parameter url: The file URL where the navigation mesh should be saved (typically with .bin extension)
-    /// - Throws: `NavMeshExportError` if export fails, or file system errors if save fails
-    func save(to url: URL) throws {
-        // Export the mesh to binary format
-        var ptr: UnsafeMutableRawPointer?
-        var size: Int32 = 0
-        
-        let status = bindingExportTiledNavMesh(navMesh, &ptr, &size)
-        
-        switch status {
-        case BD_OK:
-            guard let ptr = ptr else {
-                throw NavMeshExportError.allocationFailed
-            }
-            
-            // Create Data object that will free the pointer when done
-            let data = Data(bytesNoCopy: ptr, count: Int(size), deallocator: .free)
-            
-            // Write to disk
-            try data.write(to: url)
-            
-        case BD_ERR_INVALID_PARAM:
-            throw NavMeshExportError.invalidParameters
-            
-        case BD_ERR_ALLOC_NAVMESH:
-            throw NavMeshExportError.allocationFailed
-            
-        default:
-            throw NavMeshExportError.exportFailed
-        }
+    ///
+    /// The set is written to the file as it is produced, tile by tile, without
+    /// building it in memory first. If writing fails the file is removed.
+    /// - Parameters:
+    ///   - url: The file URL where the navigation mesh should be saved (typically with .bin extension)
+    ///   - compressed: Write a version 2 set with LZ4-compressed, checksummed tiles,
+    ///     which only this package reads, instead of the uncompressed version 1 layout
+    ///     that other Detour tools read and that ``NavMesh/init(tiledContentsOf:zeroCopy:)``
+    ///     can map without copying. Compression is lossless.
+    /// - Throws: `NavMeshExportError` if export fails, or `POSIXError` if the file cannot be written
+    func save(to url: URL, compressed: Bool = false) throws {
+        try saveNavMesh(navMesh, to: url, compressed: compressed)
+    }
+    
+    /// Exports the navigation mesh a chunk at a time, for writing it to a socket,
+    /// an archive or anything else that takes bytes in order.
+    ///
+    /// `write` receives the same bytes as ``exportToData(compressed:)`` returns; the
+    /// tiles of an uncompressed set are passed straight from the navigation mesh.
+    /// The buffers are only valid during the call.
+    /// - Parameters:
+    ///   - compressed: Write a version 2 set instead of version 1, as in ``save(to:compressed:)``
+    ///   - write: Called with each chunk in order; an error it throws stops the export and is rethrown
+    func export(compressed: Bool = false, to write: (UnsafeRawBufferPointer) throws -> Void) throws {
+        try exportNavMesh(navMesh, compressed: compressed, to: write)
     }
     
     /// Exports the navigation mesh to Data
+    /// - Parameter compressed: Produce a version 2 set with LZ4-compressed, checksummed
+    ///   tiles instead of the uncompressed version 1 layout; see ``save(to:compressed:)``
     /// - Returns: Binary data representing the navigation mesh
     /// - Throws: `NavMeshExportError` if export fails
-    func exportToData() throws -> Data {
+    func exportToData(compressed: Bool = false) throws -> Data {
         var ptr: UnsafeMutableRawPointer?
         var size: Int32 = 0
+        let status = compressed
+            ? bindingExportCompressedNavMesh(navMesh, &ptr, &size)
+            : bindingExportTiledNavMesh(navMesh, &ptr, &size)
+        return try exportedData(status, ptr, Int(size))
+    }
+    
+    /// Exports the navigation mesh in the indexed format read by ``TileStreamingNavMesh``:
+    /// a table of every tile's coordinates, offset and size comes first, so a reader can
+    /// load only the tiles it needs.
+    func exportIndexedData() throws -> Data {
+        var ptr: UnsafeMutableRawPointer?
+        var size: Int64 = 0
+        let status = bindingExportIndexedNavMesh(navMesh, &ptr, &size)
+        return try exportedData(status, ptr, Int(size))
+    }
+    
+    /// Exports the navigation mesh in the pre-linked format loaded by
+    /// ``NavMesh/init(prelinkedContentsOf:)``: the tiles with the links between
+    /// them already resolved, so they can be used from a read-only mapping.
+    func exportPrelinkedData() throws -> Data {
+        var ptr: UnsafeMutableRawPointer?
+        var size: Int32 = 0
+        let status = bindingExportPrelinkedNavMesh(navMesh, &ptr, &size)
+        return try exportedData(status, ptr, Int(size))
+    }
+}
+
+/// Writes navMesh as a set to a new file at url through `bindingWriteFileDescriptor`
+func saveNavMesh(_ navMesh: dtNavMesh, to url: URL, compressed: Bool) throws {
+    var fd = open(url.path, O_WRONLY | O_CREAT | O_TRUNC, 0o644)
+    guard fd >= 0 else {
+        throw POSIXError(POSIXErrorCode(rawValue: errno) ?? .EIO)
+    }
+    let status = compressed
+        ? bindingWriteCompressedNavMesh(navMesh, bindingWriteFileDescriptor, &fd)
+        : bindingWriteTiledNavMesh(navMesh, bindingWriteFileDescriptor, &fd)
+    let writeErrno = errno
+    let closed = close(fd) == 0
+    let closeErrno = errno
+    if status == BD_OK && closed {
+        return
+    }
+    unlink(url.path)
+    try throwExportError(status == BD_ERR_WRITE ? BD_OK : status)
+    throw POSIXError(POSIXErrorCode(rawValue: status == BD_OK ? closeErrno : writeErrno) ?? .EIO)
+}
+
+/// Passes navMesh as a set to `write`, chunk by chunk
+func exportNavMesh(_ navMesh: dtNavMesh, compressed: Bool,
+                   to write: (UnsafeRawBufferPointer) throws -> Void) throws {
+    /// What the C callback needs; it only sees a pointer to this
+    final class Sink {
+        let write: (UnsafeRawBufferPointer) throws -> Void
+        var error: Error?
         
-        let status = bindingExportTiledNavMesh(navMesh, &ptr, &size)
-        
-        switch status {
-        case BD_OK:
-            guard let ptr = ptr else {
-                throw NavMeshExportError.allocationFailed
+        init(_ write: @escaping (UnsafeRawBufferPointer) throws -> Void) {
+            self.write = write
+        }
+    }
+    
+    try withoutActuallyEscaping(write) { write in
+        let sink = Sink(write)
+        let callback: BindingWriteFn = { context, data, size in
+            let sink = Unmanaged<Sink>.fromOpaque(context!).takeUnretainedValue()
+            do {
+                try sink.write(UnsafeRawBufferPointer(start: data, count: Int(size)))
+                return 1
+            } catch {
+                sink.error = error
+                return 0
             }
-            return Data(bytesNoCopy: ptr, count: Int(size), deallocator: .free)
-            
-        case BD_ERR_INVALID_PARAM:
-            throw NavMeshExportError.invalidParameters
-            
-        case BD_ERR_ALLOC_NAVMESH:
-            throw NavMeshExportError.allocationFailed
-            
-        default:
-            throw NavMeshExportError.exportFailed
         }
+        let status = withExtendedLifetime(sink) {
+            let context = Unmanaged.passUnretained(sink).toOpaque()
+            return compressed
+                ? bindingWriteCompressedNavMesh(navMesh, callback, context)
+                : bindingWriteTiledNavMesh(navMesh, callback, context)
+        }
+        if let error = sink.error {
+            throw error
+        }
+        try throwExportError(status)
+    }
+}
+
+/// Throws the `NavMeshExportError` for a failed status
+private func throwExportError(_ status: BDetourStatus) throws {
+    switch status {
+    case BD_OK:
+        return
+    case BD_ERR_INVALID_PARAM:
+        throw NavMeshExportError.invalidParameters
+    case BD_ERR_ALLOC_NAVMESH:
+        throw NavMeshExportError.allocationFailed
+    default:
+        throw NavMeshExportError.exportFailed
+    }
+}
+
+/// Takes over a buffer returned by one of the `bindingExport` functions
+func exportedData(_ status: BDetourStatus, _ ptr: UnsafeMutableRawPointer?, _ size: Int) throws -> Data {
+    try throwExportError(status)
+    guard let ptr = ptr else {
+        throw NavMeshExportError.allocationFailed
     }
+    return Data(bytesNoCopy: ptr, count: Int(size), deallocator: .free)
 }
 
 /* usage examples
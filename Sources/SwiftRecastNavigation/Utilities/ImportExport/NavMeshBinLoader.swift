@@ -20,7 +20,9 @@ public typealias NavMeshSetHeader  = rcNavMeshSetHeader
 public typealias NavMeshTileHeader = rcNavMeshTileHeader
 
 public let NAVMESHSET_MAGIC: Int32 = 0x4D534554 // "MSET"
-public let NAVMESHSET_VERSION: Int32 = 1 // Detour demo/save default
+public let NAVMESHSET_VERSION: Int32 = 2 // Compressed tiles behind an offset table
+public let NAVMESHSET_VERSION_RAW: Int32 = 1 // Detour demo/save default
+public let NAVMESHSET_PRELINKED_MAGIC: Int32 = 0x4D53504C // "MSPL"
 
 public extension NavMesh {
     /// Loads a **multi‑tile** Detour binary (usually produced by `SaveAll` in
@@ -30,6 +32,8 @@ public extension NavMesh {
     /// – Parameters:
     ///   – url:      File‐URL to the `.bin` nav‑mesh set.
     ///   – zeroCopy: `true` ⇒ memory maps the file (no overhead, *read‑only*).
+    ///     Only version 1 sets can be used in place; a compressed (version 2) set
+    ///     throws `FileError.notMappable`, load it with `zeroCopy: false`.
     convenience init(tiledContentsOf url: URL,
                      zeroCopy: Bool = false) throws
     {
@@ -80,8 +84,26 @@ public extension NavMesh {
         let setHeader = rawPtr.bindMemory(to: NavMeshSetHeader.self, capacity: 1).pointee
 
         guard setHeader.numTiles > 0 else { throw FileError.readError /* malformed set */ }
-        guard setHeader.magic == NAVMESHSET_MAGIC else { throw FileError.notTiled }
-        guard setHeader.version == NAVMESHSET_VERSION else { throw NavMeshError.wrongVersion }
+        // Pre-linked sets have the same layout; here their tiles are simply linked again
+        guard setHeader.magic == NAVMESHSET_MAGIC || setHeader.magic == NAVMESHSET_PRELINKED_MAGIC else {
+            throw FileError.notTiled
+        }
+
+        // Version 2 tiles are decompressed in parallel into buffers of their own,
+        // so the file is not kept (and not mapped) past loading
+        if setHeader.magic == NAVMESHSET_MAGIC && setHeader.version == NAVMESHSET_VERSION {
+            guard detourOwns else {
+                munmap(rawPtr, rawSize)
+                throw FileError.notMappable
+            }
+            var handle: dtNavMesh?
+            let status = bindingImportNavMeshSet(rawPtr, Int32(rawSize), 0, &handle)
+            rawPtr.deallocate()
+            guard !dtStatusFailed(status), let handle else { throw NavMesh.statusToError(status) }
+            self.init(navMesh: handle)
+            return
+        }
+        guard setHeader.version == NAVMESHSET_VERSION_RAW else { throw NavMeshError.wrongVersion }
 
         // --------------------------------------------------------------------
         // 3️⃣  Boot ‑up a fresh dtNavMesh ------------------------------------
@@ -131,12 +153,85 @@ public extension NavMesh {
                   mmapSize: detourOwns ? 0 : rawSize)
     }
 
+    /// Loads a tiled navigation mesh from data written by ``exportToData(compressed:)``.
+    ///
+    /// Every tile is copied (compressed tiles are decompressed and checked on all
+    /// cores), so `data` is not retained.
+    convenience init(setData data: Data) throws {
+        var handle: dtNavMesh?
+        let status = data.withUnsafeBytes { buf in
+            bindingImportNavMeshSet(buf.baseAddress, Int32(buf.count), 0, &handle)
+        }
+        guard !dtStatusFailed(status), let handle else {
+            throw NavMesh.statusToError(status)
+        }
+        self.init(navMesh: handle)
+    }
+
+    /// Maps a pre-linked navigation mesh, written by ``exportPrelinkedData()``,
+    /// read-only and uses its tiles in place.
+    ///
+    /// Nothing in the file is written, so its pages stay shared with the page
+    /// cache and with every other process that maps the same file, and loading
+    /// only sets up the navmesh's own tile table. The tiles cannot be removed or
+    /// have their polygon flags or areas changed.
+    convenience init(prelinkedContentsOf url: URL) throws {
+        let fd = open(url.path, O_RDONLY)
+        guard fd >= 0 else { throw FileError.fileNotFound }
+        defer { close(fd) }
+
+        var st = stat()
+        guard fstat(fd, &st) == 0, st.st_size > 0 else {
+            throw FileError.readError
+        }
+        let size = Int(st.st_size)
+        guard let addr = mmap(nil, size, PROT_READ, MAP_FILE | MAP_SHARED, fd, 0),
+              addr != MAP_FAILED else { throw FileError.readError }
+
+        var handle: dtNavMesh?
+        let status = bindingLoadPrelinkedNavMesh(addr, Int64(size), &handle)
+        guard !dtStatusFailed(status), let handle else {
+            munmap(addr, size)
+            throw NavMesh.statusToError(status)
+        }
+        self.init(navMesh: handle, mmapPtr: addr, mmapSize: size)
+    }
+
+    /// Maps a file holding a single-tile navigation blob, the Detour tile data
+    /// ``NavMesh/init(_:)`` takes, and uses it in place.
+    ///
+    /// The mapping is private and copy-on-write: the only pages copied into
+    /// memory are the ones Detour writes when it links the tile, and the file
+    /// is never changed. It stays mapped for as long as the mesh lives.
+    convenience init(blobContentsOf url: URL) throws {
+        let fd = open(url.path, O_RDONLY)
+        guard fd >= 0 else { throw FileError.fileNotFound }
+        defer { close(fd) }
+
+        var st = stat()
+        guard fstat(fd, &st) == 0, st.st_size > 0, st.st_size <= Int32.max else {
+            throw FileError.readError
+        }
+        let size = Int(st.st_size)
+        guard let addr = mmap(nil, size, PROT_READ | PROT_WRITE, MAP_FILE | MAP_PRIVATE, fd, 0),
+              addr != MAP_FAILED else { throw FileError.readError }
+
+        do {
+            // Not freed by Detour; deinit unmaps it
+            try self.init(addr, size: Int32(size), freeWithDetour: false)
+        } catch {
+            munmap(addr, size)
+            throw error
+        }
+    }
+
     // MARK: - Error extension ----------------------------------------------
 
     enum FileError: Error {
         case fileNotFound // couldn’t open
         case readError // fread/fstat fail or len==0
         case notTiled // blob was solo mesh, not a set
+        case notMappable // compressed set, cannot be used in place with zeroCopy
     }
 }
 
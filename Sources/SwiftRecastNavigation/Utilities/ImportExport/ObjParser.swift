@@ -6,6 +6,7 @@
 //  Handles parsing and writing of Wavefront OBJ mesh files
 //
 
+import CRecast
 import Foundation
 import simd
 
@@ -37,6 +38,8 @@ public enum OBJParser {
     enum ParseError: Error {
         case invalidFormat
         case unsupportedFeature(String)
+        case unreadableFile(String)
+        case outOfMemory
         
         var localizedDescription: String {
             switch self {
@@ -44,81 +47,84 @@ public enum OBJParser {
                 return "Invalid OBJ format"
             case .unsupportedFeature(let feature):
                 return "Unsupported OBJ feature: \(feature)"
+            case .unreadableFile(let path):
+                return "Cannot read OBJ file: \(path)"
+            case .outOfMemory:
+                return "Out of memory parsing OBJ"
             }
         }
     }
     
     /// Result of parsing an OBJ file
     public struct ParseResult {
-        let vertices: [SIMD3<Float>]
-        let triangles: [Int32]
-        let normals: [SIMD3<Float>]
+        public let vertices: [SIMD3<Float>]
+        public let triangles: [Int32]
+        public let normals: [SIMD3<Float>]
     }
     
     /// Parses OBJ format text into mesh data
+    ///
+    /// Only vertices and faces are read. Faces are fanned into triangles, negative
+    /// indices count back from the vertices defined so far, and triangles that
+    /// refer to a vertex not defined yet are dropped.
     static func parse(_ rawOBJ: String) throws -> ParseResult {
-        var vertices: [SIMD3<Float>] = []
-        var triangles: [Int32] = []
-        
-        let lines = rawOBJ
-            .replacingOccurrences(of: "\r", with: "")
-            .split(separator: "\n")
+        var text = rawOBJ
+        var mesh = BindingObjMesh()
+        defer { bindingReleaseObjMesh(&mesh) }
+        let status = text.withUTF8 { bytes in
+            bytes.withMemoryRebound(to: CChar.self) { chars in
+                bindingParseObjMesh(chars.baseAddress, Int64(chars.count), 0, &mesh)
+            }
+        }
+        return try makeResult(status, mesh, path: nil)
+    }
+    
+    /// Loads and parses an OBJ file from disk
+    ///
+    /// The file is memory-mapped and parsed in chunks on every core, with numbers
+    /// read straight from the bytes; the result is the same as ``parse(_:)`` on its text.
+    /// - Parameters:
+    ///   - path: Path of the OBJ file
+    ///   - useGeometryCache: Keep the parsed vertices and triangles in a binary
+    ///     sidecar next to the file (`terrain.obj` → `terrain.geomcache`) and load
+    ///     them from there while the file's size and modification time are unchanged
+    public static func load(from path: String, useGeometryCache: Bool = false) throws -> ParseResult {
+        var mesh = BindingObjMesh()
+        defer { bindingReleaseObjMesh(&mesh) }
+        let status = useGeometryCache
+            ? bindingLoadObjMesh(path, geometryCachePath(for: path), 0, &mesh)
+            : bindingLoadObjMesh(path, nil, 0, &mesh)
+        return try makeResult(status, mesh, path: path)
+    }
+    
+    /// Path of the geometry cache sidecar of an OBJ file
+    public static func geometryCachePath(for path: String) -> String {
+        (path as NSString).deletingPathExtension + ".geomcache"
+    }
+    
+    /// Copies a parsed mesh into a ``ParseResult``, or throws for a failed status
+    private static func makeResult(_ status: BObjStatus, _ mesh: BindingObjMesh, path: String?) throws -> ParseResult {
+        switch status {
+        case BOBJ_OK:
+            break
+        case BOBJ_ERR_FORMAT:
+            throw ParseError.invalidFormat
+        case BOBJ_ERR_IO:
+            throw ParseError.unreadableFile(path ?? "")
+        default:
+            throw ParseError.outOfMemory
+        }
         
-        for line in lines {
-            switch line.first {
-            case "v": // vertex
-                if line.starts(with: "v ") {
-                    let p = line.split(separator: " ")
-                    guard p.count >= 4 else { throw ParseError.invalidFormat }
-                    vertices.append([
-                        Float(p[1]) ?? 0,
-                        Float(p[2]) ?? 0,
-                        Float(p[3]) ?? 0
-                    ])
-                }
-            case "f": // face (as polygon or triangle fan)
-                let vCount = Int32(vertices.count)
-                let parts = line.split(whereSeparator: { $0.isWhitespace }).dropFirst()
-                let faceIdxs = parts.map { part -> Int32 in
-                    // Handle vertex/texture/normal format
-                    if let slash = part.firstIndex(of: "/") {
-                        return Int32(part[..<slash]) ?? 0
-                    } else {
-                        return Int32(part) ?? 0
-                    }
-                }.map { $0 < 0 ? vCount + $0 + 1 : $0 } // Handle negative indices
-                
-                // Convert to zero-based indices
-                let zeroBasedIdxs = faceIdxs.map { $0 - 1 }
-                
-                // Triangulate polygon
-                guard zeroBasedIdxs.count > 2 else { break }
-                let a = zeroBasedIdxs[0]
-                
-                for i in 2..<zeroBasedIdxs.count {
-                    let b = zeroBasedIdxs[i - 1]
-                    let c = zeroBasedIdxs[i]
-                    
-                    // Validate indices
-                    guard (0..<vCount).contains(a),
-                          (0..<vCount).contains(b),
-                          (0..<vCount).contains(c) else { continue }
-                    
-                    triangles.append(contentsOf: [a, b, c])
+        let vertexCount = Int(mesh.vertexCount)
+        let vertices = [SIMD3<Float>](unsafeUninitializedCapacity: vertexCount) { buffer, count in
+            if let src = mesh.vertices {
+                for i in 0..<vertexCount {
+                    buffer[i] = SIMD3(src[i * 3], src[i * 3 + 1], src[i * 3 + 2])
                 }
-            case "#": break // Comment
-            case "m": break // mtllib
-            case "u": break // usemtl
-            case "o": break // object name
-            case "g": break // group name
-            case "s": break // smooth shading
-            case "v":
-                if line.starts(with: "vn ") || line.starts(with: "vt ") {
-                    break // Skip vertex normals and texture coordinates for now
-                }
-            default: break
             }
+            count = vertexCount
         }
+        let triangles = Array(UnsafeBufferPointer(start: mesh.triangles, count: Int(mesh.triangleCount) * 3))
         
         // Generate normals from triangles
         let normals = generateNormals(vertices: vertices, triangles: triangles)
@@ -126,12 +132,6 @@ public enum OBJParser {
         return ParseResult(vertices: vertices, triangles: triangles, normals: normals)
     }
     
-    /// Loads and parses an OBJ file from disk
-    public static func load(from path: String) throws -> ParseResult {
-        let content = try String(contentsOfFile: path, encoding: .utf8)
-        return try parse(content)
-    }
-    
     /// Flattens an array of polygons (each with its own `vertices`)
     /// and emits them as triangles in OBJ format.
     public static func write(polygons: [NavMeshGeometry.Polygon], to url: URL) throws {
@@ -262,6 +262,7 @@ public enum OBJParser {
     /// Generates per-triangle normals from vertices and triangles
     private static func generateNormals(vertices: [SIMD3<Float>], triangles: [Int32]) -> [SIMD3<Float>] {
         var normals: [SIMD3<Float>] = []
+        normals.reserveCapacity(triangles.count / 3)
         
         for i in stride(from: 0, to: triangles.count, by: 3) {
             let v0 = triangles[i]
@@ -48,6 +48,15 @@ public func analyzeNavMeshFile(_ url: URL) throws {
                 // Check tiles
                 if setHeader.numTiles == 0 {
                     print("  ⚠️ WARNING: No tiles in mesh!")
+                } else if setHeader.version == NAVMESHSET_VERSION {
+                    let entries = base.advanced(by: MemoryLayout<NavMeshSetHeader>.size)
+                    for i in 0..<Int(min(setHeader.numTiles, 3)) {
+                        let end = MemoryLayout<NavMeshSetHeader>.size + (i + 1) * MemoryLayout<rcNavMeshSetTileEntry>.size
+                        if end > data.count { break }
+                        let entry = entries.advanced(by: i * MemoryLayout<rcNavMeshSetTileEntry>.size)
+                            .loadUnaligned(as: rcNavMeshSetTileEntry.self)
+                        print("\n  Tile \(i): ref=\(entry.tileRef), size=\(entry.dataSize), stored=\(entry.storedSize)")
+                    }
                 } else {
                     var offset = MemoryLayout<NavMeshSetHeader>.size
                     for i in 0..<min(setHeader.numTiles, 3) {
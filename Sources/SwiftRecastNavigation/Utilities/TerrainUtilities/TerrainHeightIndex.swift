@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: MIT
+//
+//  TerrainHeightIndex.swift
+//  SwiftRecastNavigation
+//
+//  Uniform X-Z grid over terrain triangles for height lookups
+//
+
+import Foundation
+import simd
+
+/// Finds terrain heights from the triangles under a point, testing only the
+/// triangles that share its grid cell.
+///
+/// The grid is sized for about one triangle per cell, so a lookup costs the
+/// same on a terrain of a thousand triangles as on one of millions. Heights
+/// are interpolated across the triangle that contains the point; points off
+/// the terrain, or a terrain without triangles, get the height of the nearest
+/// vertex instead.
+struct TerrainHeightIndex {
+    /// Terrain vertices
+    let vertices: [SIMD3<Float>]
+    /// Triangle vertex indices, 3 per triangle; empty to index the vertices alone
+    let triangles: [UInt32]
+
+    private let origin: SIMD2<Float>
+    private let cellSize: Float
+    private let columns: Int
+    private let rows: Int
+    /// Where the items of each cell start in `cellItems` [columns * rows + 1]
+    private let cellStart: [Int32]
+    /// Triangles, or vertices when there are none, by cell
+    private let cellItems: [Int32]
+
+    /// Largest number of grid cells, to bound memory on sparse terrains
+    private static let maxCells = 1 << 22
+    /// Tolerance of the point in triangle test, so that points on shared edges always hit
+    private static let edgeEpsilon: Float = 1e-5
+
+    /// Builds the index
+    /// - Parameters:
+    ///   - vertices: Terrain vertices
+    ///   - triangles: Triangle vertex indices, 3 per triangle
+    init(vertices: [SIMD3<Float>], triangles: [UInt32]) {
+        self.vertices = vertices
+        self.triangles = triangles.count % 3 == 0 ? triangles : Array(triangles.prefix(triangles.count / 3 * 3))
+
+        var lo = SIMD2<Float>(repeating: .greatestFiniteMagnitude)
+        var hi = SIMD2<Float>(repeating: -.greatestFiniteMagnitude)
+        for v in vertices {
+            lo = simd_min(lo, SIMD2(v.x, v.z))
+            hi = simd_max(hi, SIMD2(v.x, v.z))
+        }
+        if vertices.isEmpty {
+            lo = .zero
+            hi = .zero
+        }
+
+        let itemCount = self.triangles.isEmpty ? vertices.count : self.triangles.count / 3
+        let extent = simd_max(hi - lo, SIMD2(repeating: 1e-3))
+        let cells = Float(min(max(itemCount, 1), Self.maxCells))
+        let size = max((extent.x * extent.y / cells).squareRoot(), max(extent.x, extent.y) / Float(Self.maxCells))
+        let columns = max(1, Int((extent.x / size).rounded(.up)))
+        let rows = max(1, min(Self.maxCells / columns, Int((extent.y / size).rounded(.up))))
+
+        self.origin = lo
+        self.cellSize = size
+        self.columns = columns
+        self.rows = rows
+
+        // Bucket the items with a counting sort: count the items of each cell,
+        // then place them after the running total.
+        var start = [Int32](repeating: 0, count: columns * rows + 1)
+        let tris = self.triangles
+        func forEachCell(of item: Int, _ body: (Int) -> Void) {
+            var a = SIMD2<Float>(repeating: 0), b = a
+            if tris.isEmpty {
+                let v = vertices[item]
+                a = SIMD2(v.x, v.z)
+                b = a
+            } else {
+                let v0 = vertices[Int(tris[item * 3])]
+                let v1 = vertices[Int(tris[item * 3 + 1])]
+                let v2 = vertices[Int(tris[item * 3 + 2])]
+                a = simd_min(simd_min(SIMD2(v0.x, v0.z), SIMD2(v1.x, v1.z)), SIMD2(v2.x, v2.z))
+                b = simd_max(simd_max(SIMD2(v0.x, v0.z), SIMD2(v1.x, v1.z)), SIMD2(v2.x, v2.z))
+            }
+            let c0 = Self.cell(a, origin: lo, size: size, columns: columns, rows: rows)
+            let c1 = Self.cell(b, origin: lo, size: size, columns: columns, rows: rows)
+            for z in c0.z...c1.z {
+                for x in c0.x...c1.x {
+                    body(z * columns + x)
+                }
+            }
+        }
+        for item in 0..<itemCount {
+            forEachCell(of: item) { start[$0 + 1] += 1 }
+        }
+        for i in 0..<columns * rows {
+            start[i + 1] += start[i]
+        }
+        var items = [Int32](repeating: 0, count: Int(start[columns * rows]))
+        var fill = start
+        for item in 0..<itemCount {
+            forEachCell(of: item) { cell in
+                items[Int(fill[cell])] = Int32(item)
+                fill[cell] += 1
+            }
+        }
+
+        self.cellStart = start
+        self.cellItems = items
+    }
+
+    private static func cell(_ p: SIMD2<Float>, origin: SIMD2<Float>, size: Float, columns: Int, rows: Int) -> (x: Int, z: Int) {
+        // Clamp before converting, so that far off points cannot overflow Int
+        let q = simd_clamp((p - origin) / size, .zero, SIMD2(Float(columns - 1), Float(rows - 1)))
+        return (q.x.isNaN ? 0 : Int(q.x), q.y.isNaN ? 0 : Int(q.y))
+    }
+
+    /// The terrain height at `xz`, or nil for a terrain without vertices
+    func height(at xz: SIMD2<Float>) -> Float? {
+        guard !vertices.isEmpty else {
+            return nil
+        }
+        let c = Self.cell(xz, origin: origin, size: cellSize, columns: columns, rows: rows)
+
+        if !triangles.isEmpty {
+            var best: Float?
+            let cell = c.z * columns + c.x
+            for i in Int(cellStart[cell])..<Int(cellStart[cell + 1]) {
+                let t = Int(cellItems[i]) * 3
+                if let y = interpolate(triangle: t, at: xz) {
+                    // Overhangs: keep the top surface
+                    best = max(best ?? y, y)
+                }
+            }
+            if let best {
+                return best
+            }
+        }
+        return nearestVertexHeight(to: xz, from: c)
+    }
+
+    /// The terrain heights at each of `positions`, looked up in parallel for large batches
+    func heights(at positions: [SIMD2<Float>]) -> [Float?] {
+        var result = [Float?](repeating: nil, count: positions.count)
+        let chunk = 1024
+        let chunks = (positions.count + chunk - 1) / chunk
+        result.withUnsafeMutableBufferPointer { buffer in
+            let out = buffer
+            positions.withUnsafeBufferPointer { points in
+                let run = { (c: Int) in
+                    for i in c * chunk..<min((c + 1) * chunk, points.count) {
+                        out[i] = height(at: points[i])
+                    }
+                }
+                if chunks > 1 {
+                    DispatchQueue.concurrentPerform(iterations: chunks, execute: run)
+                } else if chunks == 1 {
+                    run(0)
+                }
+            }
+        }
+        return result
+    }
+
+    /// Height of triangle `t` (its first index in `triangles`) at `xz`, nil if `xz` is outside it
+    private func interpolate(triangle t: Int, at xz: SIMD2<Float>) -> Float? {
+        let a = vertices[Int(triangles[t])]
+        let b = vertices[Int(triangles[t + 1])]
+        let c = vertices[Int(triangles[t + 2])]
+        let e0 = SIMD2(b.x - a.x, b.z - a.z)
+        let e1 = SIMD2(c.x - a.x, c.z - a.z)
+        let p = SIMD2(xz.x - a.x, xz.y - a.z)
+        let det = e0.x * e1.y - e1.x * e0.y
+        // Vertical or degenerate triangles have no height to interpolate
+        guard det != 0 else {
+            return nil
+        }
+        let u = (p.x * e1.y - e1.x * p.y) / det
+        let v = (e0.x * p.y - p.x * e0.y) / det
+        guard u >= -Self.edgeEpsilon, v >= -Self.edgeEpsilon, u + v <= 1 + Self.edgeEpsilon else {
+            return nil
+        }
+        return a.y + u * (b.y - a.y) + v * (c.y - a.y)
+    }
+
+    /// Height of the vertex nearest `xz`, searching rings of cells out from `start`
+    private func nearestVertexHeight(to xz: SIMD2<Float>, from start: (x: Int, z: Int)) -> Float? {
+        var bestDistance = Float.greatestFiniteMagnitude
+        var bestHeight: Float?
+        func consider(_ vertex: Int) {
+            let v = vertices[vertex]
+            let d = simd_length_squared(SIMD2(v.x, v.z) - xz)
+            if d < bestDistance {
+                bestDistance = d
+                bestHeight = v.y
+            }
+        }
+
+        for ring in 0...max(columns, rows) {
+            for z in max(start.z - ring, 0)...min(start.z + ring, rows - 1) {
+                let edge = z == start.z - ring || z == start.z + ring
+                // Inside rows of the ring only have its two end cells
+                let step = edge ? 1 : max(2 * ring, 1)
+                for x in stride(from: start.x - ring, through: start.x + ring, by: step) where x >= 0 && x < columns {
+                    let cell = z * columns + x
+                    for i in Int(cellStart[cell])..<Int(cellStart[cell + 1]) {
+                        let item = Int(cellItems[i])
+                        if triangles.isEmpty {
+                            consider(item)
+                        } else {
+                            consider(Int(triangles[item * 3]))
+                            consider(Int(triangles[item * 3 + 1]))
+                            consider(Int(triangles[item * 3 + 2]))
+                        }
+                    }
+                }
+            }
+            // Cells beyond this ring are at least `ring` cells away
+            let reach = Float(ring) * cellSize
+            if bestHeight != nil && bestDistance <= reach * reach {
+                break
+            }
+        }
+        return bestHeight
+    }
+}
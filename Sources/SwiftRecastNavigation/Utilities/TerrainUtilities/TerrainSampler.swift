@@ -6,7 +6,6 @@
 //  Handles terrain height sampling from various sources
 //
 
-import Accelerate
 import RealityKit
 import simd
 
@@ -17,109 +16,83 @@ struct TerrainSampler {
     
     /// Cached terrain mesh data for efficient height sampling
     struct TerrainMeshData {
-        let vertices: [SIMD3<Float>]
-        let xCoords: [Float]
-        let yCoords: [Float]
-        let zCoords: [Float]
+        /// Triangle grid the heights are looked up in
+        let index: TerrainHeightIndex
         
-        /// Extracts and caches terrain vertex data from a ModelEntity
+        /// Terrain vertices
+        var vertices: [SIMD3<Float>] { index.vertices }
+        
+        /// Extracts and indexes terrain triangles from a ModelEntity
         init(from terrainModel: ModelEntity, rotation: simd_quatf? = nil) {
             guard let mesh = terrainModel.model?.mesh else {
-                self.vertices = []
-                self.xCoords = []
-                self.yCoords = []
-                self.zCoords = []
+                self.index = TerrainHeightIndex(vertices: [], triangles: [])
                 return
             }
             
-            // Gather vertices in local space
-            let localVertices: [SIMD3<Float>] = mesh.contents.models.flatMap { meshModel in
-                meshModel.parts.flatMap { part in
-                    part.positions.elements
+            // Gather vertices in local space, with the triangles of each part
+            // offset past the vertices of the parts before it
+            var localVertices: [SIMD3<Float>] = []
+            var triangles: [UInt32] = []
+            for meshModel in mesh.contents.models {
+                for part in meshModel.parts {
+                    let base = UInt32(localVertices.count)
+                    localVertices.append(contentsOf: part.positions.elements)
+                    if let indices = part.triangleIndices?.elements {
+                        triangles.append(contentsOf: indices.map { $0 + base })
+                    }
                 }
             }
             
-            guard !localVertices.isEmpty else {
-                self.vertices = []
-                self.xCoords = []
-                self.yCoords = []
-                self.zCoords = []
-                return
-            }
-            
             // Apply rotation if provided
-            let transformedVertices: [SIMD3<Float>]
             if let rotation = rotation {
-                transformedVertices = localVertices.map { vertex in
+                localVertices = localVertices.map { vertex in
                     rotation.act(vertex)
                 }
-            } else {
-                transformedVertices = localVertices
             }
             
-            // Extract coordinates for Accelerate
-            let vertexCount = transformedVertices.count
-            var xCoordsLocal = [Float](repeating: 0, count: vertexCount)
-            var yCoordsLocal = [Float](repeating: 0, count: vertexCount)
-            var zCoordsLocal = [Float](repeating: 0, count: vertexCount)
-            
-            for (i, v) in transformedVertices.enumerated() {
-                xCoordsLocal[i] = v.x
-                yCoordsLocal[i] = v.y
-                zCoordsLocal[i] = v.z
-            }
-            
-            self.vertices = transformedVertices
-            self.xCoords = xCoordsLocal
-            self.yCoords = yCoordsLocal
-            self.zCoords = zCoordsLocal
+            self.index = TerrainHeightIndex(vertices: localVertices, triangles: triangles)
+        }
+        
+        /// Indexes terrain triangles given as vertex and index buffers
+        init(vertices: [SIMD3<Float>], triangles: [UInt32]) {
+            self.index = TerrainHeightIndex(vertices: vertices, triangles: triangles)
+        }
+        
+        /// Terrain height at an X-Z position, interpolated across the triangle under it
+        func height(at localXZ: SIMD2<Float>) -> Float? {
+            index.height(at: localXZ)
+        }
+        
+        /// Terrain heights at many X-Z positions
+        func heights(at localXZPositions: [SIMD2<Float>]) -> [Float?] {
+            index.heights(at: localXZPositions)
         }
     }
     
     /// Samples a single terrain height at given X-Z position from a RealityKit model
+    ///
+    /// This indexes the whole terrain on every call; build a ``TerrainMeshData``
+    /// once, or use ``sampleHeights(at:on:rotation:)``, to sample many positions.
     static func sampleHeight(at localXZ: SIMD2<Float>, 
                            on terrainModel: ModelEntity, 
                            rotation: simd_quatf? = nil) -> Float? {
-        let meshData = TerrainMeshData(from: terrainModel, rotation: rotation)
-        
-        guard !meshData.vertices.isEmpty else {
-            return nil
-        }
-        
-        let nearestIndex = findNearestVertexIndex(
-            to: localXZ,
-            in: meshData.xCoords,
-            and: meshData.zCoords
-        )
-        
-        return meshData.yCoords[nearestIndex]
+        TerrainMeshData(from: terrainModel, rotation: rotation).height(at: localXZ)
     }
     
     /// Batch samples multiple terrain heights from a RealityKit model
     static func sampleHeights(at localXZPositions: [SIMD2<Float>], 
                             on terrainModel: ModelEntity, 
                             rotation: simd_quatf? = nil) -> [Float?] {
-        let meshData = TerrainMeshData(from: terrainModel, rotation: rotation)
-        
-        guard !meshData.vertices.isEmpty else {
-            return Array(repeating: nil, count: localXZPositions.count)
-        }
-        
-        return localXZPositions.map { xz in
-            let nearestIndex = findNearestVertexIndex(
-                to: xz,
-                in: meshData.xCoords,
-                and: meshData.zCoords
-            )
-            return meshData.yCoords[nearestIndex]
-        }
+        TerrainMeshData(from: terrainModel, rotation: rotation).heights(at: localXZPositions)
     }
     
     // MARK: - OBJ Terrain Sampling
     
-    /// Samples terrain heights from OBJ vertices using nearest neighbor
+    /// Samples terrain heights from OBJ triangles, or the nearest vertices when
+    /// no triangles are given or a position is off the terrain
     static func sampleOBJHeights(at localXZPositions: [SIMD2<Float>],
                                terrainVertices: [SIMD3<Float>],
+                               terrainTriangles: [Int32] = [],
                                scale: Float = 1.0) -> [Float] {
         guard !terrainVertices.isEmpty else {
             return Array(repeating: 0, count: localXZPositions.count)
@@ -127,53 +100,9 @@ struct TerrainSampler {
         
         // Scale terrain vertices
         let scaledVertices = terrainVertices.map { $0 * scale }
+        let meshData = TerrainMeshData(vertices: scaledVertices,
+                                       triangles: terrainTriangles.map { UInt32(bitPattern: $0) })
         
-        // Extract coordinates for Accelerate
-        let xCoords = scaledVertices.map { $0.x }
-        let yCoords = scaledVertices.map { $0.y }
-        let zCoords = scaledVertices.map { $0.z }
-        
-        return localXZPositions.map { xz in
-            let nearestIndex = findNearestVertexIndex(
-                to: xz,
-                in: xCoords,
-                and: zCoords
-            )
-            return yCoords[nearestIndex]
-        }
-    }
-    
-    // MARK: - Private Helpers
-    
-    /// Finds the index of the nearest vertex to a given X-Z position using Accelerate
-    private static func findNearestVertexIndex(to queryXZ: SIMD2<Float>,
-                                             in xCoords: [Float],
-                                             and zCoords: [Float]) -> Int {
-        let vertexCount = xCoords.count
-        var distances = [Float](repeating: 0, count: vertexCount)
-        
-        // Batch calculate squared distances
-        var diffX = [Float](repeating: 0, count: vertexCount)
-        var diffZ = [Float](repeating: 0, count: vertexCount)
-        
-        // X differences
-        vDSP_vfill([queryXZ.x], &diffX, 1, vDSP_Length(vertexCount))
-        vDSP_vsub(xCoords, 1, diffX, 1, &diffX, 1, vDSP_Length(vertexCount))
-        vDSP_vsq(diffX, 1, &diffX, 1, vDSP_Length(vertexCount))
-        
-        // Z differences
-        vDSP_vfill([queryXZ.y], &diffZ, 1, vDSP_Length(vertexCount))
-        vDSP_vsub(zCoords, 1, diffZ, 1, &diffZ, 1, vDSP_Length(vertexCount))
-        vDSP_vsq(diffZ, 1, &diffZ, 1, vDSP_Length(vertexCount))
-        
-        // Sum for total squared distance
-        vDSP_vadd(diffX, 1, diffZ, 1, &distances, 1, vDSP_Length(vertexCount))
-        
-        // Find nearest
-        var minDistance: Float = 0
-        var minIndex: vDSP_Length = 0
-        vDSP_minvi(distances, 1, &minDistance, &minIndex, vDSP_Length(vertexCount))
-        
-        return Int(minIndex)
+        return meshData.heights(at: localXZPositions).map { $0 ?? 0 }
     }
 }